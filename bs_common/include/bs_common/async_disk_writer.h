@@ -0,0 +1,143 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <bs_parameters/optimizers/async_disk_writer_params.h>
+
+namespace bs_common {
+
+/**
+ * @brief Policy applied by the AsyncDiskWriter when its queue is full
+ */
+enum class WriterOverflowPolicy { BLOCK = 0, DROP_NEWEST, DROP_OLDEST };
+
+/**
+ * @brief this class moves disk writes (scan dumps, graph outputs, debug
+ * clouds) off the real-time callback threads. Callers copy whatever they need
+ * into a write function and enqueue it, and a single background thread runs
+ * the writes in the order they were queued, so a later write of the same file
+ * always wins. It is implemented as a singleton so that every sensor model
+ * loaded in the same process shares one bounded queue.
+ *
+ * When the queue is full the overflow policy decides whether the caller waits
+ * (up to max_block_time_s), or whether the newest or oldest write is dropped.
+ * Every dropped write is counted and reported in GetStats().
+ *
+ * The thread is started on the first call to Enqueue, and remaining writes are
+ * flushed when the program exits.
+ */
+class AsyncDiskWriter {
+public:
+  using Params = bs_parameters::optimizers::AsyncDiskWriterParams;
+
+  /**
+   * @brief function doing the actual write. Exceptions are caught, logged and
+   * counted as failures
+   */
+  using WriteFunction = std::function<void()>;
+
+  struct Stats {
+    uint64_t enqueued{0};
+    uint64_t written{0};
+    uint64_t failed{0};
+    uint64_t dropped{0};
+    size_t queue_size{0};
+    size_t max_queue_size_reached{0};
+    double total_write_time_s{0};
+  };
+
+  /**
+   * @brief Static Instance getter (singleton)
+   * @return reference to the singleton
+   */
+  static AsyncDiskWriter& GetInstance();
+
+  /**
+   * @brief Delete copy constructor
+   */
+  AsyncDiskWriter(const AsyncDiskWriter& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  AsyncDiskWriter& operator=(const AsyncDiskWriter& other) = delete;
+
+  /**
+   * @brief Destructor, flushes all queued writes and stops the thread
+   */
+  ~AsyncDiskWriter();
+
+  /**
+   * @brief set params. If the thread is running, the queued writes are
+   * flushed and the thread is restarted on the next call to Enqueue.
+   * Throws std::invalid_argument if the overflow policy is invalid.
+   */
+  void SetParams(const Params& params);
+
+  /**
+   * @brief queue a write
+   * @param description short description used when logging failures or drops
+   * @param write function doing the write. It must own (or copy) all the data
+   * it writes, since it is run after this call returns
+   * @return false if this write was dropped
+   */
+  bool Enqueue(const std::string& description, WriteFunction write);
+
+  /**
+   * @brief block until all writes queued so far are done
+   */
+  void Flush();
+
+  Stats GetStats() const;
+
+private:
+  struct Task {
+    std::string description;
+    WriteFunction write;
+  };
+
+  /**
+   * @brief Constructor
+   */
+  AsyncDiskWriter() = default;
+
+  /**
+   * @brief start the thread if it isn't running. Must be called with mutex_
+   * locked
+   */
+  void StartThread();
+
+  /**
+   * @brief finish all queued writes and join the thread
+   */
+  void StopThread();
+
+  /**
+   * @brief thread loop, runs until StopThreads is called and the queue is
+   * empty
+   * @param generation the thread exits once generation_ no longer matches this
+   */
+  void Run(uint64_t generation);
+
+  mutable std::mutex mutex_;
+  std::condition_variable task_cv_;
+  std::condition_variable space_cv_;
+  std::condition_variable idle_cv_;
+  std::deque<Task> queue_;
+  std::thread thread_;
+  uint64_t generation_{0};
+  size_t active_writes_{0};
+
+  size_t max_queue_size_{200};
+  WriterOverflowPolicy policy_{WriterOverflowPolicy::BLOCK};
+  double max_block_time_s_{0.01};
+  Stats stats_;
+};
+
+} // namespace bs_common
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include <bs_parameters/optimizers/degradation_controller_params.h>
+
+namespace bs_common {
+
+/**
+ * @brief Levels of work reduction requested by the DegradationController.
+ * Each level sheds more work than the previous one.
+ */
+enum class DegradationLevel {
+  NOMINAL = 0,
+  LIGHT = 1,
+  MODERATE = 2,
+  SEVERE = 3
+};
+
+std::string DegradationLevelToString(DegradationLevel level);
+
+/**
+ * @brief this class monitors the load on the fixed lag smoother and decides how
+ * much work the rest of the system should shed to keep up. It is implemented
+ * as a singleton so that the optimizer (which reports the timing of each
+ * optimization cycle) and every sensor model loaded in the same process
+ * (which query the scaling factors) share one decision.
+ *
+ * A cycle is overloaded if the optimization took longer than high_load_ratio *
+ * optimization_period, or if the pending transactions span more than
+ * max_queue_lag_fraction * lag_duration. After cycles_to_degrade overloaded
+ * cycles in a row we move up one level, after cycles_to_recover underloaded
+ * cycles in a row we move down one level. Every level change is logged.
+ *
+ * The scaling factors returned for each level are:
+ *
+ *  level    | landmarks | voxel size | solver iterations | keyframe spacing
+ *  NOMINAL  |   1.0     |    1.0     |       1.0         |      1.0
+ *  LIGHT    |   0.75    |    1.5     |       0.75        |      1.25
+ *  MODERATE |   0.5     |    2.0     |       0.5         |      1.5
+ *  SEVERE   |   0.3     |    3.0     |       0.3         |      2.0
+ */
+class DegradationController {
+public:
+  using Params = bs_parameters::optimizers::DegradationControllerParams;
+
+  /**
+   * @brief Static Instance getter (singleton)
+   * @return reference to the singleton
+   */
+  static DegradationController& GetInstance();
+
+  /**
+   * @brief Delete copy constructor
+   */
+  DegradationController(const DegradationController& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  DegradationController& operator=(const DegradationController& other) = delete;
+
+  /**
+   * @brief set params and reset the controller to the nominal level
+   */
+  void SetParams(const Params& params);
+
+  /**
+   * @brief report the result of one optimization cycle. This should be called
+   * by the optimizer after each cycle.
+   * @param optimization_time_s wall time spent in this cycle
+   * @param optimization_period_s configured optimization period
+   * @param queue_span_s time spanned by the transactions still pending after
+   * this cycle (newest stamp - oldest stamp)
+   * @param lag_duration_s configured lag duration
+   * @return level after this cycle
+   */
+  DegradationLevel AddCycle(double optimization_time_s,
+                            double optimization_period_s, double queue_span_s,
+                            double lag_duration_s);
+
+  /**
+   * @brief go back to the nominal level and clear all counters
+   */
+  void Reset();
+
+  DegradationLevel Level() const;
+
+  /**
+   * @brief fraction of the landmarks measured in a frame that should be added
+   * to the graph
+   */
+  double LandmarkFraction() const;
+
+  /**
+   * @brief factor to multiply map voxel downsample sizes by
+   */
+  double VoxelSizeScale() const;
+
+  /**
+   * @brief fraction of the configured max solver iterations to use
+   */
+  double SolverIterationFraction() const;
+
+  /**
+   * @brief factor to multiply keyframe selection thresholds by
+   */
+  double KeyframeSpacingScale() const;
+
+private:
+  DegradationController() = default;
+
+  void SetLevel(DegradationLevel level, const std::string& reason);
+
+  mutable std::mutex mutex_;
+  Params params_;
+  int overloaded_cycles_{0};
+  int underloaded_cycles_{0};
+  std::atomic<int> level_{0};
+};
+
+} // namespace bs_common
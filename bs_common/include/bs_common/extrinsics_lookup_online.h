@@ -24,6 +24,17 @@ public:
    */
   static ExtrinsicsLookupOnline& GetInstance();
 
+  /**
+   * @brief Use fixed extrinsics instead of loading the calibration params from
+   * ROS and looking up the extrinsics on tf, so that offline tools can run
+   * without a ROS master. Must be called before the first call to GetInstance.
+   * @param extrinsics frame ids and extrinsics, e.g., loaded from the files
+   * written by SaveFrameIdsToJson and SaveExtrinsicsToJson
+   * @return false if the instance was already created, in which case nothing
+   * is changed
+   */
+  static bool InitializeStatic(const ExtrinsicsLookupBase& extrinsics);
+
   /**
    * @brief Delete copy constructor
    */
@@ -53,6 +64,13 @@ public:
    */
   void SaveFrameIdsToJson(const std::string& save_filename);
 
+  /**
+   * @brief Load extrinsics previously saved with SaveExtrinsicsToJson, e.g.,
+   * when warm starting from a snapshot. See ExtrinsicsLookupBase::LoadExtrinsics
+   * @param filepath full path to json file
+   */
+  void LoadExtrinsicsFromJson(const std::string& filepath);
+
   /**
    * @brief get transform from any two frames
    * @param T reference to result
@@ -265,6 +283,9 @@ private:
 
   bs_parameters::models::CalibrationParams calibration_params_;
 
+  /** set if initialized with InitializeStatic, no tf lookups are performed */
+  bool offline_{false};
+
   std::unique_ptr<tf::TransformListener> tf_listener_;
 
   std::shared_ptr<ExtrinsicsLookupBase> extrinsics_;
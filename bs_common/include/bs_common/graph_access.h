@@ -36,6 +36,32 @@ std::map<int64_t, ImuBiases>
 void SaveGraphToTxtFile(const fuse_core::Graph& graph,
                         const std::string& txt_file_save_path);
 
+/**
+ * @brief Save graph to a binary file using its boost serialization, so that it
+ * can be loaded back with LoadGraphFromBinaryFile
+ * @return true if successful
+ */
+bool SaveGraphToBinaryFile(const fuse_core::Graph& graph,
+                           const std::string& filename);
+
+/**
+ * @brief Load a graph saved with SaveGraphToBinaryFile. The graph must be of
+ * the same type as the one that was saved (e.g., fuse_graphs::HashGraph)
+ * @return true if successful
+ */
+bool LoadGraphFromBinaryFile(const std::string& filename,
+                             fuse_core::Graph& graph);
+
+/**
+ * @brief Create a transaction which adds a clone of every variable and
+ * constraint in a graph
+ * @param graph
+ * @param stamp stamp to give the transaction
+ * @return transaction
+ */
+fuse_core::Transaction::SharedPtr
+    GraphToTransaction(const fuse_core::Graph& graph, const ros::Time& stamp);
+
 /**
  * @brief Get number of constraints being added by a transaction
  * @param transaction
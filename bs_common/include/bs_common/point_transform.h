@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <pcl/point_cloud.h>
+
+namespace bs_common {
+
+/**
+ * @brief Points stored as a structure of arrays, so that transforms can work
+ * on many points per SIMD instruction.
+ *
+ * This pays off for points that are kept and transformed several times, e.g.
+ * map points. A pcl cloud that is transformed once is better left to
+ * pcl::transformPointCloud, which already transforms one padded point per SIMD
+ * instruction: converting it to PointsSoA and back costs more than the faster
+ * transform saves. See point_transform_benchmark_main.cpp
+ */
+struct PointsSoA {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+
+  size_t size() const { return x.size(); }
+
+  void resize(size_t size) {
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+  }
+};
+
+/**
+ * @brief Points stored as float16 offsets from an origin, which takes half the
+ * memory of PointsSoA. Meant for map points which are kept for a long time but
+ * only read through TransformPoints.
+ *
+ * A float16 has 11 significant bits, so the error of a point is up to
+ * 2^-11 times its offset from the origin, e.g. 1.5cm at 30m. Offsets must be
+ * below 65504m. The conversion to float is only vectorized on builds with F16C
+ * instructions (e.g. -march=native on x86), elsewhere TransformPoints is slower
+ * than with PointsSoA.
+ */
+struct CompactPoints {
+  Eigen::Vector3d origin{Eigen::Vector3d::Zero()};
+  std::vector<Eigen::half> x;
+  std::vector<Eigen::half> y;
+  std::vector<Eigen::half> z;
+
+  size_t size() const { return x.size(); }
+};
+
+/**
+ * @brief Transforms n points: out = T * in. Vectorized with Eigen, so it uses
+ * whichever SIMD instructions the build enables. The out arrays must not
+ * overlap the in arrays
+ */
+void TransformPoints(const Eigen::Matrix4f& T, const float* x_in,
+                     const float* y_in, const float* z_in, float* x_out,
+                     float* y_out, float* z_out, size_t n);
+
+/**
+ * @brief out = T * in, out is resized. in and out can be the same
+ */
+void TransformPoints(const Eigen::Matrix4d& T, const PointsSoA& in,
+                     PointsSoA& out);
+
+/**
+ * @brief out = T * in, out is resized. Use an identity T to decompress
+ */
+void TransformPoints(const Eigen::Matrix4d& T, const CompactPoints& in,
+                     PointsSoA& out);
+
+/**
+ * @brief Stores points as float16 offsets from the center of their bounding
+ * box
+ */
+CompactPoints CompressPoints(const PointsSoA& points);
+
+/**
+ * @brief copies the x, y and z fields of a cloud
+ */
+template <typename PointT>
+PointsSoA ToPointsSoA(const pcl::PointCloud<PointT>& cloud) {
+  PointsSoA points;
+  points.resize(cloud.size());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    points.x[i] = cloud.points[i].x;
+    points.y[i] = cloud.points[i].y;
+    points.z[i] = cloud.points[i].z;
+  }
+  return points;
+}
+
+/**
+ * @brief sets the x, y and z fields of cloud, which is resized
+ */
+template <typename PointT>
+void FromPointsSoA(const PointsSoA& points, pcl::PointCloud<PointT>& cloud) {
+  cloud.resize(points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    cloud.points[i].x = points.x[i];
+    cloud.points[i].y = points.y[i];
+    cloud.points[i].z = points.z[i];
+  }
+}
+
+} // namespace bs_common
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <ros/time.h>
+
+#include <bs_parameters/optimizers/snapshot_params.h>
+
+namespace bs_common {
+
+/**
+ * @brief this class coordinates saving and restoring the state of the system
+ * so that it can warm start after a crash or a reset instead of going through
+ * SLAM initialization again. It is implemented as a singleton so that all
+ * sensor models loaded in the same process share the same snapshot.
+ *
+ * Each component (e.g., the graph, the IMU buffer, the registration map) is
+ * saved by its owner to its own sub directory of the snapshot path, either
+ * on the owner's thread with Save() or on the AsyncDiskWriter thread with
+ * SaveAsync():
+ *
+ *  path/
+ *    component_name/
+ *      snapshot.json  (stamp of the saved state, written last)
+ *      ...            (files written by the component)
+ *
+ * Each component is first written to a temporary directory which replaces the
+ * previous one only once it is complete, so a crash during a save never
+ * leaves a partial snapshot behind.
+ *
+ * On startup, SLAM initialization decides whether the snapshot is recent
+ * enough to be used and calls SetWarmStarted(). The other components then
+ * restore their state by calling Load() if WarmStarted() is true.
+ */
+class SnapshotManager {
+public:
+  using Params = bs_parameters::optimizers::SnapshotParams;
+
+  /**
+   * @brief function that writes (or reads) a component's state to (or from) a
+   * directory. Returns false on failure.
+   */
+  using IOFunction = std::function<bool(const std::string& directory)>;
+
+  /**
+   * @brief Static Instance getter (singleton)
+   * @return reference to the singleton
+   */
+  static SnapshotManager& GetInstance();
+
+  /**
+   * @brief Delete copy constructor
+   */
+  SnapshotManager(const SnapshotManager& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  SnapshotManager& operator=(const SnapshotManager& other) = delete;
+
+  /**
+   * @brief set params. This is called by the optimizer before starting the
+   * sensor models. Throws std::invalid_argument if max_warm_start_gap_s is
+   * less than period_s
+   */
+  void SetParams(const Params& params);
+
+  Params GetParams() const;
+
+  /**
+   * @brief true if saving is enabled and the component was not saved in the
+   * last period_s seconds (in sensor time)
+   */
+  bool SaveDue(const std::string& component, const ros::Time& stamp) const;
+
+  /**
+   * @brief save a component
+   * @param component name of the component, used as the sub directory name
+   * @param stamp stamp of the state being saved
+   * @param write function writing the component state to the directory it is
+   * given
+   * @return true if successful
+   */
+  bool Save(const std::string& component, const ros::Time& stamp,
+            const IOFunction& write);
+
+  /**
+   * @brief save a component on the AsyncDiskWriter thread, so that callbacks
+   * are not blocked by the disk. The save is recorded right away, so SaveDue()
+   * is false for the next period even while the write is still queued.
+   * Queued saves run one at a time in the order they were queued, so two saves
+   * of the same component never share its temporary directory
+   * @param component name of the component, used as the sub directory name
+   * @param stamp stamp of the state being saved
+   * @param write function writing the component state to the directory it is
+   * given. It must own (or copy) all the data it writes, since it is run
+   * after this call returns
+   * @return false if the write was not queued
+   */
+  bool SaveAsync(const std::string& component, const ros::Time& stamp,
+                 IOFunction write);
+
+  /**
+   * @brief load a component from the snapshot
+   * @param component name of the component
+   * @param read function reading the component state from the directory it
+   * is given
+   * @return true if the component exists in the snapshot and was read
+   */
+  bool Load(const std::string& component, const IOFunction& read) const;
+
+  /**
+   * @brief get the stamp of the state saved for a component
+   * @return true if the component exists in the snapshot
+   */
+  bool GetStamp(const std::string& component, ros::Time& stamp) const;
+
+  /**
+   * @brief mark that the system was started from the snapshot
+   * @param stamp stamp of the snapshot graph used for the warm start
+   */
+  void SetWarmStarted(const ros::Time& stamp);
+
+  /**
+   * @brief true if the system was started from the snapshot, and the other
+   * components should restore their state from it
+   */
+  bool WarmStarted() const;
+
+  /**
+   * @brief clear the warm start flag and save times, e.g., on reset. The
+   * snapshot on disk is kept
+   */
+  void Reset();
+
+private:
+  /**
+   * @brief Constructor
+   */
+  SnapshotManager() = default;
+
+  std::string ComponentPath(const std::string& component) const;
+
+  /**
+   * @brief writes a component to a temporary directory, then replaces the
+   * previous snapshot of the component with it
+   */
+  bool Write(const std::string& component, const std::string& final_path,
+             const ros::Time& stamp, const IOFunction& write) const;
+
+  mutable std::mutex mutex_;
+  Params params_;
+  std::map<std::string, ros::Time> last_save_stamps_;
+  std::atomic<bool> warm_started_{false};
+  ros::Time warm_start_stamp_;
+};
+
+} // namespace bs_common
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace bs_common {
+
+/**
+ * @brief Fixed size, lock free queue for one producer and one consumer.
+ *
+ * Push never waits for the consumer, so a high rate sensor callback can hand
+ * data to a slower consumer without contending on a mutex. Pushes and pops
+ * must each be made by one thread at a time: several producer (or consumer)
+ * threads are fine as long as they are serialized, e.g. by a mutex, which
+ * then also orders their accesses.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+  /**
+   * @brief Constructor
+   * @param capacity maximum number of queued elements
+   */
+  explicit SpscRingBuffer(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) { size *= 2; }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  /**
+   * @brief Delete copy constructor
+   */
+  SpscRingBuffer(const SpscRingBuffer& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  SpscRingBuffer& operator=(const SpscRingBuffer& other) = delete;
+
+  /**
+   * @brief queue a copy of value. Producer only
+   * @return false if the buffer is full, in which case nothing is queued
+   */
+  bool Push(const T& value) {
+    T copy = value;
+    return Push(std::move(copy));
+  }
+
+  /**
+   * @brief queue value. Producer only
+   * @return false if the buffer is full, in which case value is not moved
+   */
+  bool Push(T&& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_) { return false; }
+    buffer_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief take the oldest element. Consumer only
+   * @return false if the buffer is empty
+   */
+  bool Pop(T& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) { return false; }
+    value = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief call func on each queued element, oldest first, and remove it.
+   * Elements pushed during the call may or may not be included. Consumer only
+   * @return number of elements removed
+   */
+  template <typename Func>
+  size_t Drain(Func&& func) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t i = head; i != tail; i++) {
+      func(std::move(buffer_[i & mask_]));
+      // free each slot as soon as it is used so the producer can refill it
+      head_.store(i + 1, std::memory_order_release);
+    }
+    return tail - head;
+  }
+
+  /**
+   * @brief number of queued elements. Exact only when called by the producer
+   * or the consumer while the other is idle
+   */
+  size_t Size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+private:
+  std::vector<T> buffer_;
+  size_t mask_;
+
+  // on separate cache lines so that the producer and consumer do not
+  // invalidate each other's cache on every operation
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace bs_common
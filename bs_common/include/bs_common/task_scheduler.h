@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <bs_parameters/optimizers/task_scheduler_params.h>
+#include <bs_parameters/thread_placement_params.h>
+
+namespace bs_common {
+
+/**
+ * @brief Priority of work submitted to the TaskScheduler. Queued tasks of a
+ * higher priority always run before queued tasks of a lower priority
+ */
+enum class TaskPriority { REALTIME = 0, MAPPING, IO };
+
+/**
+ * @brief this class is a pool of worker threads shared by every sensor model
+ * and optimizer loaded in the same process, so that parallel work from
+ * different models is spread over the cores instead of each model spinning up
+ * its own threads. It is implemented as a singleton.
+ *
+ * Tasks are queued by priority: real-time odometry work runs before mapping
+ * work, which runs before I/O. A task that has started is never preempted, so
+ * realtime_threads of the workers only run REALTIME tasks to bound their
+ * latency. Workers can be pinned to a set of cores and given a scheduling
+ * policy, see bs_common::ThreadPlacement.
+ *
+ * ParallelFor splits a loop over the workers, and the calling thread works on
+ * the loop too. It can therefore be called from inside a task without
+ * deadlocking, and runs the whole loop on the calling thread if all workers
+ * are busy.
+ *
+ * Threads are started on the first submitted task, and queued tasks are run
+ * before the threads are stopped.
+ */
+class TaskScheduler {
+public:
+  using Params = bs_parameters::optimizers::TaskSchedulerParams;
+  using Task = std::function<void()>;
+
+  static constexpr size_t kNumPriorities = 3;
+
+  struct PriorityStats {
+    uint64_t submitted{0};
+    uint64_t completed{0};
+    uint64_t failed{0};
+    size_t queue_size{0};
+    size_t max_queue_size_reached{0};
+
+    /** time from submission to start */
+    double total_wait_time_s{0};
+    double max_wait_time_s{0};
+    double total_run_time_s{0};
+  };
+
+  struct Stats {
+    /** by priority, in the order of TaskPriority */
+    std::array<PriorityStats, kNumPriorities> priorities;
+    int num_threads{0};
+
+    /** time since the threads were started */
+    double elapsed_time_s{0};
+
+    /** time the workers spent running tasks over their total time since they
+     * were started, in [0, 1] */
+    double utilization{0};
+  };
+
+  /**
+   * @brief Static Instance getter (singleton)
+   * @return reference to the singleton
+   */
+  static TaskScheduler& GetInstance();
+
+  /**
+   * @brief Delete copy constructor
+   */
+  TaskScheduler(const TaskScheduler& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  TaskScheduler& operator=(const TaskScheduler& other) = delete;
+
+  /**
+   * @brief Destructor, runs all queued tasks and stops the threads
+   */
+  ~TaskScheduler();
+
+  /**
+   * @brief set params. If the threads are running, the queued tasks are run
+   * and the threads are restarted on the next submission. Throws
+   * std::invalid_argument if a placement is invalid.
+   */
+  void SetParams(const Params& params);
+
+  /**
+   * @brief queue a task
+   * @param priority task priority
+   * @param task function to run. It must own (or copy) the data it uses, or
+   * the caller must wait on the returned future
+   * @return future which is ready once the task has run, and rethrows any
+   * exception thrown by the task
+   */
+  std::future<void> Submit(TaskPriority priority, Task task);
+
+  /**
+   * @brief run func(i) for i in [0, n) on the workers and the calling thread,
+   * and return once all calls are done. The first exception thrown by any
+   * call is rethrown once all calls have finished.
+   * @param priority priority of the work
+   * @param n number of calls
+   * @param func function to call, must be safe to call concurrently
+   * @param max_parallelism maximum number of threads working on the loop,
+   * including the calling thread. If < 1, all workers can be used
+   */
+  void ParallelFor(TaskPriority priority, size_t n,
+                   const std::function<void(size_t)>& func,
+                   int max_parallelism = 0);
+
+  /**
+   * @brief block until all tasks submitted so far are done
+   */
+  void Flush();
+
+  Stats GetStats() const;
+
+  /**
+   * @brief number of worker threads used with the current params
+   */
+  int NumThreads() const;
+
+  static std::string ToString(TaskPriority priority);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedTask {
+    Task task;
+    Clock::time_point submit_time;
+  };
+
+  /**
+   * @brief Constructor
+   */
+  TaskScheduler() = default;
+
+  /**
+   * @brief queue a task and wake a worker that can run it
+   */
+  void Enqueue(TaskPriority priority, Task task);
+
+  /**
+   * @brief start the threads if they aren't running. Must be called with
+   * mutex_ locked
+   */
+  void StartThreads();
+
+  /**
+   * @brief run all queued tasks and join the threads
+   */
+  void StopThreads();
+
+  /**
+   * @brief pop the highest priority task a worker can run. Must be called
+   * with mutex_ locked
+   * @return false if there is none
+   */
+  bool PopTask(bool realtime_only, QueuedTask& task, size_t& priority);
+
+  /**
+   * @brief placement of the shared or the REALTIME only workers
+   */
+  static bs_parameters::ThreadPlacementParams
+      GetPlacement(const Params& params, bool realtime_only);
+
+  /**
+   * @brief thread loop, runs until StopThreads is called and there are no
+   * tasks left it can run
+   * @param generation threads exit once generation_ no longer matches this
+   * @param placement placement applied to the thread before running tasks
+   * @param realtime_only only run REALTIME tasks
+   */
+  void Run(uint64_t generation, bs_parameters::ThreadPlacementParams placement,
+           bool realtime_only);
+
+  mutable std::mutex mutex_;
+  std::condition_variable task_cv_;
+  std::condition_variable realtime_cv_;
+  std::condition_variable idle_cv_;
+  std::array<std::deque<QueuedTask>, kNumPriorities> queues_;
+  std::vector<std::thread> threads_;
+  uint64_t generation_{0};
+  size_t active_tasks_{0};
+  Clock::time_point start_time_;
+  double busy_time_s_{0};
+
+  Params params_;
+  Stats stats_;
+};
+
+} // namespace bs_common
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <bs_parameters/thread_placement_params.h>
+
+namespace bs_common {
+
+/**
+ * @brief Pins the calling thread to a set of cores and sets its scheduling
+ * policy and priority (see ThreadPlacementParams). Only supported on linux,
+ * elsewhere a warning is logged.
+ *
+ * Threads created afterwards by the calling thread inherit its placement, so
+ * placing the optimizer thread before its first solve also places the Ceres
+ * worker threads.
+ *
+ * @param params placement
+ * @param name thread name used in log messages
+ * @return false if some of the placement could not be applied, e.g. a
+ * real-time policy without the needed permissions. The rest is still applied
+ */
+bool ApplyThreadPlacement(const bs_parameters::ThreadPlacementParams& params,
+                          const std::string& name);
+
+/**
+ * @brief Throws std::invalid_argument if params has an invalid core id,
+ * scheduling policy or priority
+ */
+void ValidateThreadPlacement(
+    const bs_parameters::ThreadPlacementParams& params,
+    const std::string& name);
+
+/**
+ * @brief Applies a placement to each thread that calls ApplyToCurrentThread,
+ * once per thread. This is meant for the callbacks of sensor models, which run
+ * on threads owned by the ros spinner: calling ApplyToCurrentThread at the top
+ * of a callback places every thread that runs it, and only costs a thread
+ * local lookup after the first call.
+ */
+class ThreadPlacement {
+public:
+  using Params = bs_parameters::ThreadPlacementParams;
+
+  /**
+   * @brief Constructor for an empty placement, which leaves threads as they
+   * are
+   */
+  ThreadPlacement() = default;
+
+  /**
+   * @brief Constructor. Throws std::invalid_argument if the params are invalid
+   * @param name name used in log messages
+   * @param params placement
+   */
+  ThreadPlacement(const std::string& name, const Params& params);
+
+  void ApplyToCurrentThread() const;
+
+private:
+  std::string name_;
+  Params params_;
+  bool enabled_{false};
+  uint64_t id_{0};
+};
+
+/**
+ * @brief Collects latency samples of a periodic or event driven thread, e.g.
+ * how late the optimizer wakes up after its timer fired, or how old messages
+ * are when their callback starts. The spread of the samples is the jitter
+ * caused by the thread placement and by other threads competing for the
+ * cores. Thread safe.
+ *
+ * Monitors are named and created through Create, so that the stats of every
+ * monitor in the process can be reported in one place with GetAllStats.
+ */
+class JitterMonitor {
+public:
+  struct Stats {
+    /** samples since creation */
+    uint64_t count{0};
+
+    /** over the last window_size samples, in seconds */
+    double mean_s{0};
+    double stddev_s{0};
+    double p50_s{0};
+    double p99_s{0};
+    double max_s{0};
+  };
+
+  /**
+   * @brief get the monitor with some name, or create it
+   * @param name monitor name
+   * @param window_size number of samples kept for the stats
+   */
+  static std::shared_ptr<JitterMonitor> Create(const std::string& name,
+                                               size_t window_size = 1000);
+
+  /**
+   * @brief stats of all monitors that are still in use, by name
+   */
+  static std::map<std::string, Stats> GetAllStats();
+
+  /**
+   * @brief Constructor for a monitor which is not listed in GetAllStats
+   */
+  explicit JitterMonitor(size_t window_size = 1000);
+
+  void AddSample(double latency_s);
+
+  /**
+   * @brief percentiles use the nearest rank
+   */
+  Stats GetStats() const;
+
+  void Reset();
+
+private:
+  size_t window_size_;
+  mutable std::mutex mutex_;
+  std::deque<double> samples_;
+  uint64_t count_{0};
+};
+
+} // namespace bs_common
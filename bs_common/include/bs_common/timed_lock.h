@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include <bs_common/thread_placement.h>
+
+namespace bs_common {
+
+/**
+ * @brief Locks a mutex for the lifetime of this object, like a
+ * std::unique_lock, and records how long it was held in a JitterMonitor. Use
+ * it to measure the lock hold times that other threads may wait on.
+ */
+class TimedLock {
+public:
+  /**
+   * @brief Constructor, blocks until the mutex is locked
+   * @param mutex mutex to lock
+   * @param monitor where hold times are recorded, can be null
+   */
+  TimedLock(std::mutex& mutex, JitterMonitor* monitor)
+      : lock_(mutex), monitor_(monitor), start_(Clock::now()) {}
+
+  /**
+   * @brief Constructor which does not block, check owns_lock()
+   */
+  TimedLock(std::mutex& mutex, JitterMonitor* monitor, std::try_to_lock_t)
+      : lock_(mutex, std::try_to_lock),
+        monitor_(monitor),
+        start_(Clock::now()) {}
+
+  /**
+   * @brief Delete copy constructor
+   */
+  TimedLock(const TimedLock& other) = delete;
+
+  /**
+   * @brief Delete copy assignment operator
+   */
+  TimedLock& operator=(const TimedLock& other) = delete;
+
+  ~TimedLock() { unlock(); }
+
+  bool owns_lock() const { return lock_.owns_lock(); }
+
+  /**
+   * @brief unlock before the end of the scope
+   */
+  void unlock() {
+    if (!lock_.owns_lock()) { return; }
+    lock_.unlock();
+    if (monitor_) {
+      monitor_->AddSample(
+          std::chrono::duration<double>(Clock::now() - start_).count());
+    }
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_lock<std::mutex> lock_;
+  JitterMonitor* monitor_;
+  Clock::time_point start_;
+};
+
+} // namespace bs_common
@@ -20,6 +20,19 @@ public:
     // imu topic
     getParamRequired<std::string>(nh, "imu_topic", imu_topic);
 
+    /** time between knots of the continuous-time trajectory. If set, each IMU
+     * measurement constrains the spline at its own time instead of being
+     * preintegrated between triggers. Must match the knot spacing used by
+     * lidar odometry. Set to 0 to disable */
+    getParam<double>(nh, "continuous_time_knot_spacing",
+                     continuous_time_knot_spacing,
+                     continuous_time_knot_spacing);
+
+    /** only use every nth IMU measurement for the continuous-time constraints
+     */
+    getParam<int>(nh, "continuous_time_imu_stride", continuous_time_imu_stride,
+                  continuous_time_imu_stride);
+
     std::string info_weights_config;
     getParamRequired<std::string>(ros::NodeHandle("~"),
                                   "information_weights_config",
@@ -36,5 +49,7 @@ public:
   double measurement_buffer_duration{10.0};
   double inertial_information_weight{1.0};
   std::string imu_topic{};
+  double continuous_time_knot_spacing{0};
+  int continuous_time_imu_stride{1};
 };
 }} // namespace bs_parameters::models
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <numeric>
+#include <stdexcept>
 
 #include <fuse_variables/orientation_3d_stamped.h>
 #include <fuse_variables/position_3d_stamped.h>
 #include <ros/param.h>
 
 #include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
 #include <beam_utils/pointclouds.h>
 
 #include <bs_common/utils.h>
@@ -61,7 +63,9 @@ public:
     getParam<std::string>(nh, "scan_output_directory", scan_output_directory,
                           scan_output_directory);
 
-    /** Matcher params for registration. Use path relative to config folder */
+    /** Matcher params for registration. Use path relative to config folder.
+     * Use matchers/voxel_gaussian.json for point to distribution matching,
+     * which requires SCANTOMAP registration */
     std::string matcher_config_rel;
     getParam<std::string>(nh, "matcher_config", matcher_config_rel,
                           matcher_config_rel);
@@ -80,6 +84,30 @@ public:
           bs_common::GetBeamSlamConfigPath(), registration_config_rel);
     }
 
+    /** Optional config for tuning the registration profile at runtime based
+     * on the time taken to process each scan. Provide path relative to config
+     * folder. If empty, the matcher and registration configs are used as is */
+    std::string registration_tuning_config_rel;
+    getParam<std::string>(nh, "registration_tuning_config",
+                          registration_tuning_config_rel,
+                          registration_tuning_config_rel);
+    if (!registration_tuning_config_rel.empty()) {
+      registration_tuning_config = beam::CombinePaths(
+          bs_common::GetBeamSlamConfigPath(), registration_tuning_config_rel);
+    }
+
+    /** Optional config for removing points on moving objects from the
+     * registration map, see DynamicPointFilter. Provide path relative to
+     * config folder. If empty, no points are removed */
+    std::string dynamic_point_filter_config_rel;
+    getParam<std::string>(nh, "dynamic_point_filter_config",
+                          dynamic_point_filter_config_rel,
+                          dynamic_point_filter_config_rel);
+    if (!dynamic_point_filter_config_rel.empty()) {
+      dynamic_point_filter_config = beam::CombinePaths(
+          bs_common::GetBeamSlamConfigPath(), dynamic_point_filter_config_rel);
+    }
+
     /**
      * type of lidar. Options: VELODYNE, OUSTER. This is needed so we know how
      * to convert the PointCloud2 msgs in the lidar odometry.
@@ -96,6 +124,79 @@ public:
       lidar_type = iter->second;
     }
 
+    /** If true and using a loam matcher, features are extracted from an
+     * organized range image (one row per ring) instead of with the default
+     * loam feature extractor. The layout of organized scans (e.g. ouster) is
+     * only kept if all input filters can be fused, the voxel filter is then
+     * skipped for feature extraction. Otherwise, and when re-deskewing scans,
+     * range image columns are computed from the azimuth of the filtered
+     * points */
+    getParam<bool>(nh, "organized_feature_extraction",
+                   organized_feature_extraction, organized_feature_extraction);
+
+    /** Number of range image columns to use if the input clouds are not
+     * organized. Organized clouds (e.g. ouster) use their own width. This
+     * should be close to the number of points per ring per revolution (e.g.
+     * 1800 for a VLP16 at 10Hz) */
+    getParam<int>(nh, "range_image_columns", range_image_columns,
+                  range_image_columns);
+
+    /** If true, the input scans must be raw (not deskewed) with per point
+     * times, and a frame_initializer_config must be set. Scans are deskewed
+     * here using the frame initializer, then re-deskewed with the optimized
+     * trajectory on each graph update while they are in the window, see
+     * ScanRedeskewer. Do not run the LidarScanDeskewer upstream if enabled */
+    getParam<bool>(nh, "redeskew_scans", redeskew_scans, redeskew_scans);
+
+    /** Scans are only re-deskewed if the optimized motion over the scan
+     * differs from the one used to deskew it by more than these */
+    getParam<double>(nh, "redeskew_rotation_threshold_deg",
+                     redeskew_rotation_threshold_deg,
+                     redeskew_rotation_threshold_deg);
+    getParam<double>(nh, "redeskew_translation_threshold_m",
+                     redeskew_translation_threshold_m,
+                     redeskew_translation_threshold_m);
+
+    /** Max number of scans re-deskewed on each graph update, the scans whose
+     * motion changed the most go first. Each one is re-extracted and updated
+     * in the registration map on the graph update callback. 0 for no limit */
+    getParam<int>(nh, "redeskew_max_scans_per_update",
+                  redeskew_max_scans_per_update,
+                  redeskew_max_scans_per_update);
+
+    /** If greater than zero, the trajectory is estimated as a continuous-time
+     * cubic B-spline with this knot spacing [s] instead of one pose per scan,
+     * and each scan adds constraints from its raw points at their exact
+     * timestamps, so there is no separate deskewing step. Input must be raw
+     * scans with per-point times. Scan registration is still run to initialize
+     * the new part of the trajectory and build the map, but its relative pose
+     * constraints are not added. Other models constraining the trajectory must
+     * use the same knot spacing (see InertialOdometryParams). Models that
+     * expect one pose per scan (e.g. trigger_inertial_odom_constraints and
+     * the frame initializer prior) are not compatible with this option */
+    getParam<double>(nh, "continuous_time_knot_spacing",
+                     continuous_time_knot_spacing,
+                     continuous_time_knot_spacing);
+    if (continuous_time_knot_spacing < 0 ||
+        (continuous_time_knot_spacing > 0 &&
+         continuous_time_knot_spacing < 1e-3)) {
+      BEAM_ERROR("Invalid continuous_time_knot_spacing param: {}, must be 0 "
+                 "(disabled) or at least 0.001 s",
+                 continuous_time_knot_spacing);
+      throw std::invalid_argument{"invalid continuous_time_knot_spacing"};
+    }
+
+    /** Max number of points per scan that are added as constraints in
+     * continuous-time mode */
+    getParam<int>(nh, "continuous_time_points_per_scan",
+                  continuous_time_points_per_scan,
+                  continuous_time_points_per_scan);
+
+    /** Voxel size of the map used for point correspondences in
+     * continuous-time mode */
+    getParam<double>(nh, "continuous_time_voxel_size",
+                     continuous_time_voxel_size, continuous_time_voxel_size);
+
     /** relative file path to input filters config */
     getParam<std::string>(nh, "input_filters_config", input_filters_config,
                           input_filters_config);
@@ -142,6 +243,8 @@ public:
   // Scan Registration Params
   std::string registration_config;
   std::string matcher_config;
+  std::string registration_tuning_config;
+  std::string dynamic_point_filter_config;
 
   // General params
   std::string input_topic;
@@ -161,6 +264,15 @@ public:
   bool save_marginalized_scans{true};
 
   LidarType lidar_type{LidarType::VELODYNE};
+  bool organized_feature_extraction{false};
+  int range_image_columns{1800};
+  bool redeskew_scans{false};
+  double redeskew_rotation_threshold_deg{0.1};
+  double redeskew_translation_threshold_m{0.01};
+  int redeskew_max_scans_per_update{3};
+  double continuous_time_knot_spacing{0};
+  int continuous_time_points_per_scan{500};
+  double continuous_time_voxel_size{1.0};
 
   Eigen::Matrix<double, 6, 6> prior_covariance;
 };
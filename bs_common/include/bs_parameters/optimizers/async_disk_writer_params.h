@@ -0,0 +1,44 @@
+#pragma once
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_common::AsyncDiskWriter. These are read from the async_disk_writer
+ * namespace of the optimizer's private node handle.
+ */
+struct AsyncDiskWriterParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** Maximum number of writes waiting in the queue */
+    getParam<int>(nh, "max_queue_size", max_queue_size, max_queue_size);
+
+    /** What to do when the queue is full. Options:
+     * BLOCK: wait up to max_block_time_s for space, then drop the new write
+     * DROP_NEWEST: drop the new write
+     * DROP_OLDEST: drop the oldest queued write to make space */
+    getParam<std::string>(nh, "overflow_policy", overflow_policy,
+                          overflow_policy);
+
+    /** Maximum time a caller is blocked when the queue is full and the policy
+     * is BLOCK */
+    getParam<double>(nh, "max_block_time_s", max_block_time_s,
+                     max_block_time_s);
+  }
+
+  int max_queue_size{200};
+  std::string overflow_policy{"BLOCK"};
+  double max_block_time_s{0.01};
+};
+
+}} // namespace bs_parameters::optimizers
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_common::DegradationController. These are read from the
+ * degradation_controller namespace of the optimizer's private node handle.
+ */
+struct DegradationControllerParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** If false, the controller always reports the nominal level */
+    getParam<bool>(nh, "enabled", enabled, enabled);
+
+    /** Ratio of optimization time to optimization period above which a cycle
+     * is considered overloaded */
+    getParam<double>(nh, "high_load_ratio", high_load_ratio, high_load_ratio);
+
+    /** Ratio of optimization time to optimization period below which a cycle
+     * is considered underloaded */
+    getParam<double>(nh, "low_load_ratio", low_load_ratio, low_load_ratio);
+
+    /** Fraction of the lag duration that the pending transaction queue may
+     * span before the cycle is considered overloaded */
+    getParam<double>(nh, "max_queue_lag_fraction", max_queue_lag_fraction,
+                     max_queue_lag_fraction);
+
+    /** Consecutive overloaded cycles required before degrading one level */
+    getParam<int>(nh, "cycles_to_degrade", cycles_to_degrade,
+                  cycles_to_degrade);
+
+    /** Consecutive underloaded cycles required before recovering one level */
+    getParam<int>(nh, "cycles_to_recover", cycles_to_recover,
+                  cycles_to_recover);
+  }
+
+  bool enabled{false};
+  double high_load_ratio{0.9};
+  double low_load_ratio{0.5};
+  double max_queue_lag_fraction{0.25};
+  int cycles_to_degrade{5};
+  int cycles_to_recover{50};
+};
+
+}} // namespace bs_parameters::optimizers
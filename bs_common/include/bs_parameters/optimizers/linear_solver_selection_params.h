@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_optimizers::LinearSolverSelector. These are read from the
+ * linear_solver_selection namespace of the optimizer's private node handle.
+ */
+struct LinearSolverSelectionParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** If false, the linear solver from solver_options is always used */
+    getParam<bool>(nh, "enabled", enabled, enabled);
+
+    /** Linear solvers to choose from. Options: DENSE_QR, DENSE_SCHUR,
+     * SPARSE_NORMAL_CHOLESKY, SPARSE_SCHUR, ITERATIVE_SCHUR. Solvers that are
+     * not supported by the ceres build are removed. Each one is solved with
+     * at least once, so only list solvers that are reasonable for the
+     * problem: the time of ITERATIVE_SCHUR varies a lot with conditioning */
+    if (!nh.getParam("candidates", candidates)) {
+      ROS_INFO_STREAM("Could not find parameter candidates in namespace "
+                      << nh.getNamespace()
+                      << ", using default: DENSE_QR, "
+                         "SPARSE_NORMAL_CHOLESKY, SPARSE_SCHUR");
+    }
+
+    /** Variable types that are eliminated first by the Schur solvers, and are
+     * used to estimate the size of the reduced system */
+    if (!nh.getParam("landmark_variable_types", landmark_variable_types)) {
+      ROS_INFO_STREAM("Could not find parameter landmark_variable_types in "
+                      "namespace "
+                      << nh.getNamespace()
+                      << ", using default: bs_variables::Point3DLandmark");
+    }
+
+    /** Smoothing factor in [0, 1] for the running estimate of the time per
+     * unit of predicted cost of each solver. Higher values react faster */
+    getParam<double>(nh, "cost_smoothing", cost_smoothing, cost_smoothing);
+
+    /** A different solver is only selected if its predicted time is lower
+     * than the current solver's by this fraction */
+    getParam<double>(nh, "switch_margin", switch_margin, switch_margin);
+
+    /** Every this many cycles, a candidate that was never measured, or else
+     * the candidate measured least recently, is solved with once so its cost
+     * estimate stays current. Set to 0 to only use measured candidates */
+    getParam<int>(nh, "exploration_period", exploration_period,
+                  exploration_period);
+
+    /** A measured candidate is only explored again if its predicted time is
+     * at most this many times the best predicted time */
+    getParam<double>(nh, "max_exploration_ratio", max_exploration_ratio,
+                     max_exploration_ratio);
+  }
+
+  bool enabled{false};
+  std::vector<std::string> candidates{"DENSE_QR", "SPARSE_NORMAL_CHOLESKY",
+                                      "SPARSE_SCHUR"};
+  std::vector<std::string> landmark_variable_types{
+      "bs_variables::Point3DLandmark"};
+  double cost_smoothing{0.2};
+  double switch_margin{0.1};
+  int exploration_period{50};
+  double max_exploration_ratio{1.5};
+};
+
+}} // namespace bs_parameters::optimizers
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_optimizers::OptimizationBudget. These are read from the
+ * optimization_budget namespace of the optimizer's private node handle.
+ */
+struct OptimizationBudgetParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** If false, the solver options from the config are used as is */
+    getParam<bool>(nh, "enabled", enabled, enabled);
+
+    /** Fraction of the optimization period that one cycle (graph update,
+     * marginalization and solve) is allowed to take */
+    getParam<double>(nh, "budget_fraction", budget_fraction, budget_fraction);
+
+    /** Minimum solver time given to a cycle, even if the budget has already
+     * been spent on updating and marginalizing the graph */
+    getParam<double>(nh, "min_solver_time_s", min_solver_time_s,
+                     min_solver_time_s);
+
+    /** Minimum number of solver iterations per cycle */
+    getParam<int>(nh, "min_iterations", min_iterations, min_iterations);
+
+    /** Smoothing factor in [0, 1] for the running estimate of the time per
+     * solver iteration. Higher values react faster to changes */
+    getParam<double>(nh, "iteration_time_smoothing", iteration_time_smoothing,
+                     iteration_time_smoothing);
+
+    /** If true, a cycle that does not converge triggers another cycle at the
+     * next timer event even if no new transactions have arrived */
+    getParam<bool>(nh, "carry_over_unconverged", carry_over_unconverged,
+                   carry_over_unconverged);
+  }
+
+  bool enabled{false};
+  double budget_fraction{0.8};
+  double min_solver_time_s{0.005};
+  int min_iterations{1};
+  double iteration_time_smoothing{0.2};
+  bool carry_over_unconverged{true};
+};
+
+}} // namespace bs_parameters::optimizers
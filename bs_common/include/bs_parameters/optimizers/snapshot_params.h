@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_common::SnapshotManager. These are read from the snapshot namespace of
+ * the optimizer's private node handle.
+ */
+struct SnapshotParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** Full path to the directory that holds the snapshot. Each component is
+     * saved to its own sub directory. If empty, snapshots are disabled */
+    getParam<std::string>(nh, "path", path, path);
+
+    /** If true, each component periodically saves its state to path */
+    getParam<bool>(nh, "save", save, save);
+
+    /** Minimum time between two saves of the same component, in sensor time */
+    getParam<double>(nh, "period_s", period_s, period_s);
+
+    /** If true, SLAM initialization will try to start from the snapshot in path
+     * instead of initializing from scratch */
+    getParam<bool>(nh, "warm_start", warm_start, warm_start);
+
+    /** Maximum time between the newest state in the snapshot and the first IMU
+     * measurement received for the snapshot to be used for a warm start. Only
+     * the latest snapshot is kept, which is up to period_s old when the
+     * process stops, so this must be at least period_s plus the expected
+     * restart time */
+    getParam<double>(nh, "max_warm_start_gap_s", max_warm_start_gap_s,
+                     max_warm_start_gap_s);
+  }
+
+  std::string path{""};
+  bool save{false};
+  double period_s{5.0};
+  bool warm_start{false};
+  double max_warm_start_gap_s{15.0};
+};
+
+}} // namespace bs_parameters::optimizers
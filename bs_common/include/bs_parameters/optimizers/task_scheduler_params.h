@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters { namespace optimizers {
+
+/**
+ * @brief Defines the set of parameters required by the
+ * bs_common::TaskScheduler. These are read from the task_scheduler namespace
+ * of the optimizer's private node handle.
+ */
+struct TaskSchedulerParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** Total number of worker threads. If set to 0, one per core */
+    getParam<int>(nh, "num_threads", num_threads, num_threads);
+
+    /** Number of the worker threads that only run REALTIME tasks, so that
+     * odometry work never waits behind long mapping or I/O tasks */
+    getParam<int>(nh, "realtime_threads", realtime_threads, realtime_threads);
+
+    /** Cores the shared worker threads may run on. If empty, the threads are
+     * not pinned */
+    if (!nh.getParam("cpu_affinity", cpu_affinity)) {
+      ROS_INFO_STREAM("Could not find parameter cpu_affinity in namespace "
+                      << nh.getNamespace() << ", not pinning threads");
+    }
+
+    /** Cores the REALTIME only worker threads may run on. If empty,
+     * cpu_affinity is used */
+    if (!nh.getParam("realtime_cpu_affinity", realtime_cpu_affinity)) {
+      ROS_INFO_STREAM("Could not find parameter realtime_cpu_affinity in "
+                      "namespace "
+                      << nh.getNamespace() << ", using cpu_affinity");
+    }
+
+    /** Scheduling policy and priority of the shared worker threads, see
+     * ThreadPlacementParams */
+    getParam<std::string>(nh, "scheduling_policy", scheduling_policy,
+                          scheduling_policy);
+    getParam<int>(nh, "priority", priority, priority);
+
+    /** Scheduling policy and priority of the REALTIME only worker threads */
+    getParam<std::string>(nh, "realtime_scheduling_policy",
+                          realtime_scheduling_policy,
+                          realtime_scheduling_policy);
+    getParam<int>(nh, "realtime_priority", realtime_priority,
+                  realtime_priority);
+  }
+
+  int num_threads{0};
+  int realtime_threads{1};
+  std::vector<int> cpu_affinity;
+  std::vector<int> realtime_cpu_affinity;
+  std::string scheduling_policy{"OTHER"};
+  int priority{0};
+  std::string realtime_scheduling_policy{"OTHER"};
+  int realtime_priority{0};
+};
+
+}} // namespace bs_parameters::optimizers
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ros/node_handle.h>
+#include <ros/param.h>
+
+#include <bs_parameters/parameter_base.h>
+
+namespace bs_parameters {
+
+/**
+ * @brief Defines where and with what priority a thread runs, see
+ * bs_common::ThreadPlacement. These are read from the thread_placement
+ * namespace of the optimizer's or of a sensor model's private node handle.
+ */
+struct ThreadPlacementParams : public ParameterBase {
+public:
+  /**
+   * @brief Method for loading parameter values from ROS.
+   *
+   * @param[in] nh - The ROS node handle with which to load parameters
+   */
+  void loadFromROS(const ros::NodeHandle& nh) final {
+    /** Cores the thread may run on. If empty, the thread is not pinned. Give
+     * latency critical threads cores that no other thread uses, ideally cores
+     * isolated from the kernel scheduler (isolcpus), and keep them on one
+     * socket or cluster */
+    if (!nh.getParam("cpu_affinity", cpu_affinity)) {
+      ROS_INFO_STREAM("Could not find parameter cpu_affinity in namespace "
+                      << nh.getNamespace() << ", not pinning thread");
+    }
+
+    /** Linux scheduling policy. Options: OTHER, BATCH, IDLE, FIFO, RR. FIFO
+     * and RR are real-time policies and need CAP_SYS_NICE or an rtprio limit
+     */
+    getParam<std::string>(nh, "scheduling_policy", scheduling_policy,
+                          scheduling_policy);
+
+    /** For FIFO and RR, the real-time priority in [1, 99]. For OTHER and
+     * BATCH, the nice value in [-20, 19], where lower runs first. Unused for
+     * IDLE */
+    getParam<int>(nh, "priority", priority, priority);
+  }
+
+  std::vector<int> cpu_affinity;
+  std::string scheduling_policy{"OTHER"};
+  int priority{0};
+};
+
+} // namespace bs_parameters
@@ -0,0 +1,149 @@
+#include <bs_common/async_disk_writer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <ros/console.h>
+
+#include <beam_utils/log.h>
+
+namespace bs_common {
+
+AsyncDiskWriter& AsyncDiskWriter::GetInstance() {
+  static AsyncDiskWriter instance;
+  return instance;
+}
+
+AsyncDiskWriter::~AsyncDiskWriter() {
+  StopThread();
+}
+
+void AsyncDiskWriter::SetParams(const Params& params) {
+  WriterOverflowPolicy policy;
+  if (params.overflow_policy == "BLOCK") {
+    policy = WriterOverflowPolicy::BLOCK;
+  } else if (params.overflow_policy == "DROP_NEWEST") {
+    policy = WriterOverflowPolicy::DROP_NEWEST;
+  } else if (params.overflow_policy == "DROP_OLDEST") {
+    policy = WriterOverflowPolicy::DROP_OLDEST;
+  } else {
+    BEAM_ERROR("Invalid overflow policy: {}. Options: BLOCK, DROP_NEWEST, "
+               "DROP_OLDEST",
+               params.overflow_policy);
+    throw std::invalid_argument{"invalid overflow policy"};
+  }
+
+  StopThread();
+  std::lock_guard<std::mutex> lk(mutex_);
+  max_queue_size_ = static_cast<size_t>(std::max(params.max_queue_size, 1));
+  policy_ = policy;
+  max_block_time_s_ = std::max(params.max_block_time_s, 0.0);
+}
+
+bool AsyncDiskWriter::Enqueue(const std::string& description,
+                              WriteFunction write) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  StartThread();
+  stats_.enqueued++;
+
+  if (queue_.size() >= max_queue_size_) {
+    if (policy_ == WriterOverflowPolicy::DROP_OLDEST) {
+      ROS_WARN_STREAM_THROTTLE(5, "Disk writer queue full, dropping: "
+                                      << queue_.front().description);
+      queue_.pop_front();
+      stats_.dropped++;
+    } else {
+      bool has_space{false};
+      if (policy_ == WriterOverflowPolicy::BLOCK) {
+        has_space = space_cv_.wait_for(
+            lk, std::chrono::duration<double>(max_block_time_s_),
+            [this] { return queue_.size() < max_queue_size_; });
+      }
+      if (!has_space) {
+        ROS_WARN_STREAM_THROTTLE(5, "Disk writer queue full, dropping: "
+                                        << description);
+        stats_.dropped++;
+        return false;
+      }
+    }
+  }
+
+  queue_.push_back(Task{description, std::move(write)});
+  stats_.max_queue_size_reached =
+      std::max(stats_.max_queue_size_reached, queue_.size());
+  lk.unlock();
+  task_cv_.notify_one();
+  return true;
+}
+
+void AsyncDiskWriter::Flush() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  idle_cv_.wait(lk, [this] { return queue_.empty() && active_writes_ == 0; });
+}
+
+AsyncDiskWriter::Stats AsyncDiskWriter::GetStats() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  Stats stats = stats_;
+  stats.queue_size = queue_.size();
+  return stats;
+}
+
+void AsyncDiskWriter::StartThread() {
+  if (thread_.joinable()) { return; }
+  thread_ = std::thread(&AsyncDiskWriter::Run, this, generation_);
+}
+
+void AsyncDiskWriter::StopThread() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    generation_++;
+    thread.swap(thread_);
+  }
+  task_cv_.notify_all();
+  if (thread.joinable()) { thread.join(); }
+}
+
+void AsyncDiskWriter::Run(uint64_t generation) {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      task_cv_.wait(lk, [this, generation] {
+        return generation_ != generation || !queue_.empty();
+      });
+      // on stop, finish the queued writes before exiting
+      if (queue_.empty()) { return; }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+      active_writes_++;
+    }
+    space_cv_.notify_one();
+
+    bool success{true};
+    const auto start = std::chrono::steady_clock::now();
+    try {
+      task.write();
+    } catch (const std::exception& e) {
+      BEAM_ERROR("Disk write failed ({}): {}", task.description, e.what());
+      success = false;
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      active_writes_--;
+      if (success) {
+        stats_.written++;
+      } else {
+        stats_.failed++;
+      }
+      stats_.total_write_time_s += elapsed.count();
+    }
+    idle_cv_.notify_all();
+  }
+}
+
+} // namespace bs_common
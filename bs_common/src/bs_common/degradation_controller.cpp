@@ -0,0 +1,139 @@
+#include <bs_common/degradation_controller.h>
+
+#include <sstream>
+
+#include <ros/console.h>
+
+namespace bs_common {
+
+namespace {
+
+constexpr int kMaxLevel = static_cast<int>(DegradationLevel::SEVERE);
+
+// indexed by level
+constexpr double kLandmarkFractions[] = {1.0, 0.75, 0.5, 0.3};
+constexpr double kVoxelSizeScales[] = {1.0, 1.5, 2.0, 3.0};
+constexpr double kSolverIterationFractions[] = {1.0, 0.75, 0.5, 0.3};
+constexpr double kKeyframeSpacingScales[] = {1.0, 1.25, 1.5, 2.0};
+
+} // namespace
+
+std::string DegradationLevelToString(DegradationLevel level) {
+  switch (level) {
+    case DegradationLevel::NOMINAL:
+      return "NOMINAL";
+    case DegradationLevel::LIGHT:
+      return "LIGHT";
+    case DegradationLevel::MODERATE:
+      return "MODERATE";
+    case DegradationLevel::SEVERE:
+      return "SEVERE";
+  }
+  return "UNKNOWN";
+}
+
+DegradationController& DegradationController::GetInstance() {
+  static DegradationController instance;
+  return instance;
+}
+
+void DegradationController::SetParams(const Params& params) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  params_ = params;
+  overloaded_cycles_ = 0;
+  underloaded_cycles_ = 0;
+  level_ = 0;
+}
+
+void DegradationController::Reset() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  overloaded_cycles_ = 0;
+  underloaded_cycles_ = 0;
+  if (level_ != 0) { SetLevel(DegradationLevel::NOMINAL, "reset"); }
+}
+
+DegradationLevel DegradationController::AddCycle(double optimization_time_s,
+                                                 double optimization_period_s,
+                                                 double queue_span_s,
+                                                 double lag_duration_s) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (!params_.enabled || optimization_period_s <= 0) { return Level(); }
+
+  const double load = optimization_time_s / optimization_period_s;
+  const double queue_fraction =
+      lag_duration_s > 0 ? queue_span_s / lag_duration_s : 0;
+
+  const bool overloaded = load > params_.high_load_ratio ||
+                          queue_fraction > params_.max_queue_lag_fraction;
+  const bool underloaded = load < params_.low_load_ratio &&
+                           queue_fraction < 0.5 * params_.max_queue_lag_fraction;
+
+  if (overloaded) {
+    overloaded_cycles_++;
+    underloaded_cycles_ = 0;
+  } else if (underloaded) {
+    underloaded_cycles_++;
+    overloaded_cycles_ = 0;
+  } else {
+    overloaded_cycles_ = 0;
+    underloaded_cycles_ = 0;
+  }
+
+  if (overloaded_cycles_ >= params_.cycles_to_degrade && level_ < kMaxLevel) {
+    std::stringstream ss;
+    ss << overloaded_cycles_ << " overloaded cycles (load: " << load
+       << ", queue/lag: " << queue_fraction << ")";
+    SetLevel(static_cast<DegradationLevel>(level_ + 1), ss.str());
+    overloaded_cycles_ = 0;
+  } else if (underloaded_cycles_ >= params_.cycles_to_recover && level_ > 0) {
+    std::stringstream ss;
+    ss << underloaded_cycles_ << " underloaded cycles (load: " << load
+       << ", queue/lag: " << queue_fraction << ")";
+    SetLevel(static_cast<DegradationLevel>(level_ - 1), ss.str());
+    underloaded_cycles_ = 0;
+  }
+
+  return Level();
+}
+
+void DegradationController::SetLevel(DegradationLevel level,
+                                     const std::string& reason) {
+  const DegradationLevel previous = Level();
+  level_ = static_cast<int>(level);
+  if (level > previous) {
+    ROS_WARN_STREAM("DegradationController: degrading from "
+                    << DegradationLevelToString(previous) << " to "
+                    << DegradationLevelToString(level) << " after " << reason
+                    << ". Landmark fraction: " << LandmarkFraction()
+                    << ", voxel scale: " << VoxelSizeScale()
+                    << ", solver iteration fraction: "
+                    << SolverIterationFraction()
+                    << ", keyframe spacing scale: " << KeyframeSpacingScale());
+  } else {
+    ROS_INFO_STREAM("DegradationController: recovering from "
+                    << DegradationLevelToString(previous) << " to "
+                    << DegradationLevelToString(level) << " after " << reason);
+  }
+}
+
+DegradationLevel DegradationController::Level() const {
+  return static_cast<DegradationLevel>(level_.load());
+}
+
+double DegradationController::LandmarkFraction() const {
+  return kLandmarkFractions[level_];
+}
+
+double DegradationController::VoxelSizeScale() const {
+  return kVoxelSizeScales[level_];
+}
+
+double DegradationController::SolverIterationFraction() const {
+  return kSolverIterationFractions[level_];
+}
+
+double DegradationController::KeyframeSpacingScale() const {
+  return kKeyframeSpacingScales[level_];
+}
+
+} // namespace bs_common
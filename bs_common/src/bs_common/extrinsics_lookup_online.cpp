@@ -8,12 +8,40 @@
 
 namespace bs_common {
 
+namespace {
+
+// set by InitializeStatic, consumed when the instance is created
+std::shared_ptr<ExtrinsicsLookupBase> static_extrinsics;
+bool instance_created{false};
+
+} // namespace
+
 ExtrinsicsLookupOnline& ExtrinsicsLookupOnline::GetInstance() {
   static ExtrinsicsLookupOnline instance;
   return instance;
 }
 
+bool ExtrinsicsLookupOnline::InitializeStatic(
+    const ExtrinsicsLookupBase& extrinsics) {
+  if (instance_created) {
+    BEAM_ERROR("ExtrinsicsLookupOnline already created, cannot initialize "
+               "with static extrinsics.");
+    return false;
+  }
+  static_extrinsics = std::make_shared<ExtrinsicsLookupBase>(extrinsics);
+  return true;
+}
+
 ExtrinsicsLookupOnline::ExtrinsicsLookupOnline() {
+  instance_created = true;
+  if (static_extrinsics) {
+    BEAM_INFO("Using static extrinsics, not loading calibration from ROS.");
+    extrinsics_ = static_extrinsics;
+    calibration_params_.static_extrinsics = true;
+    offline_ = true;
+    return;
+  }
+
   calibration_params_.loadFromROS();
   ExtrinsicsLookupBase::FrameIds frame_ids{
       .imu = calibration_params_.imu_frame,
@@ -35,6 +63,11 @@ void ExtrinsicsLookupOnline::SaveFrameIdsToJson(
   extrinsics_->SaveFrameIdsToJson(save_filename);
 }
 
+void ExtrinsicsLookupOnline::LoadExtrinsicsFromJson(
+    const std::string& filepath) {
+  extrinsics_->LoadExtrinsics(filepath);
+}
+
 ExtrinsicsLookupBase ExtrinsicsLookupOnline::GetExtrinsicsCopy() {
   return *extrinsics_;
 }
@@ -60,6 +93,11 @@ bool ExtrinsicsLookupOnline::GetTransform(Eigen::Matrix4d& T,
   if (extrinsics_->GetTransform(T, to_frame, from_frame)) { return true; }
 
   // if that failed, then the transform isn't set, so lets look it up and set it
+  if (offline_) {
+    BEAM_ERROR("No static extrinsics from frame {} to frame {}.", from_frame,
+               to_frame);
+    return false;
+  }
   if (!LookupTransform(T, to_frame, from_frame)) { return false; }
   extrinsics_->SetTransform(T, to_frame, from_frame);
   return true;
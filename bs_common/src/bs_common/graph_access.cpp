@@ -1,5 +1,10 @@
 #include <bs_common/graph_access.h>
 
+#include <fstream>
+
+#include <beam_utils/log.h>
+#include <fuse_core/serialization.h>
+
 #include <bs_variables/point_3d_landmark.h>
 
 #include <bs_common/conversions.h>
@@ -56,6 +61,55 @@ void SaveGraphToTxtFile(const fuse_core::Graph& graph,
   outFile.close();
 }
 
+bool SaveGraphToBinaryFile(const fuse_core::Graph& graph,
+                           const std::string& filename) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.good()) {
+    BEAM_ERROR("Unable to open file for writing graph: {}", filename);
+    return false;
+  }
+  {
+    fuse_core::BinaryOutputArchive archive(file);
+    graph.serialize(archive);
+  }
+  file.flush();
+  if (!file.good()) {
+    BEAM_ERROR("Unable to write graph to file: {}", filename);
+    return false;
+  }
+  return true;
+}
+
+bool LoadGraphFromBinaryFile(const std::string& filename,
+                             fuse_core::Graph& graph) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.good()) {
+    BEAM_ERROR("Unable to open graph file: {}", filename);
+    return false;
+  }
+  try {
+    fuse_core::BinaryInputArchive archive(file);
+    graph.deserialize(archive);
+  } catch (const std::exception& e) {
+    BEAM_ERROR("Unable to deserialize graph from {}: {}", filename, e.what());
+    return false;
+  }
+  return true;
+}
+
+fuse_core::Transaction::SharedPtr
+    GraphToTransaction(const fuse_core::Graph& graph, const ros::Time& stamp) {
+  auto transaction = fuse_core::Transaction::make_shared();
+  transaction->stamp(stamp);
+  for (const auto& variable : graph.getVariables()) {
+    transaction->addVariable(variable.clone());
+  }
+  for (const auto& constraint : graph.getConstraints()) {
+    transaction->addConstraint(constraint.clone());
+  }
+  return transaction;
+}
+
 int GetNumberOfConstraints(
     const fuse_core::Transaction::SharedPtr& transaction) {
   if (transaction == nullptr) { return 0; }
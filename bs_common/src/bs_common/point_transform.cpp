@@ -0,0 +1,96 @@
+#include <bs_common/point_transform.h>
+
+#include <algorithm>
+
+namespace bs_common {
+
+namespace {
+
+// number of points transformed at a time, so that a block stays in cache
+constexpr size_t kBlockSize = 256;
+
+using ArrayMap = Eigen::Map<Eigen::ArrayXf>;
+using ConstArrayMap = Eigen::Map<const Eigen::ArrayXf>;
+using HalfArray = Eigen::Array<Eigen::half, Eigen::Dynamic, 1>;
+using HalfArrayMap = Eigen::Map<HalfArray>;
+using ConstHalfArrayMap = Eigen::Map<const HalfArray>;
+
+} // namespace
+
+void TransformPoints(const Eigen::Matrix4f& T, const float* x_in,
+                     const float* y_in, const float* z_in, float* x_out,
+                     float* y_out, float* z_out, size_t n) {
+  const Eigen::Index size = static_cast<Eigen::Index>(n);
+  ConstArrayMap x(x_in, size);
+  ConstArrayMap y(y_in, size);
+  ConstArrayMap z(z_in, size);
+  ArrayMap(x_out, size) = T(0, 0) * x + T(0, 1) * y + T(0, 2) * z + T(0, 3);
+  ArrayMap(y_out, size) = T(1, 0) * x + T(1, 1) * y + T(1, 2) * z + T(1, 3);
+  ArrayMap(z_out, size) = T(2, 0) * x + T(2, 1) * y + T(2, 2) * z + T(2, 3);
+}
+
+void TransformPoints(const Eigen::Matrix4d& T, const PointsSoA& in,
+                     PointsSoA& out) {
+  const Eigen::Matrix4f T_float = T.cast<float>();
+  out.resize(in.size());
+  // through a block in cache, so that in and out can be the same
+  alignas(64) float block[3][kBlockSize];
+  for (size_t start = 0; start < in.size(); start += kBlockSize) {
+    const size_t n = std::min(kBlockSize, in.size() - start);
+    TransformPoints(T_float, &in.x[start], &in.y[start], &in.z[start],
+                    block[0], block[1], block[2], n);
+    std::copy(block[0], block[0] + n, &out.x[start]);
+    std::copy(block[1], block[1] + n, &out.y[start]);
+    std::copy(block[2], block[2] + n, &out.z[start]);
+  }
+}
+
+void TransformPoints(const Eigen::Matrix4d& T, const CompactPoints& in,
+                     PointsSoA& out) {
+  // T * (origin + offset) = R * offset + (R * origin + t)
+  Eigen::Matrix4d T_offset = T;
+  T_offset.block<3, 1>(0, 3) += T.block<3, 3>(0, 0) * in.origin;
+  const Eigen::Matrix4f T_float = T_offset.cast<float>();
+
+  out.resize(in.size());
+  alignas(64) float block[3][kBlockSize];
+  for (size_t start = 0; start < in.size(); start += kBlockSize) {
+    const size_t n = std::min(kBlockSize, in.size() - start);
+    const Eigen::Index size = static_cast<Eigen::Index>(n);
+    ArrayMap(block[0], size) =
+        ConstHalfArrayMap(&in.x[start], size).cast<float>();
+    ArrayMap(block[1], size) =
+        ConstHalfArrayMap(&in.y[start], size).cast<float>();
+    ArrayMap(block[2], size) =
+        ConstHalfArrayMap(&in.z[start], size).cast<float>();
+    TransformPoints(T_float, block[0], block[1], block[2], &out.x[start],
+                    &out.y[start], &out.z[start], n);
+  }
+}
+
+CompactPoints CompressPoints(const PointsSoA& points) {
+  CompactPoints compact;
+  if (points.size() == 0) { return compact; }
+
+  const Eigen::Index size = static_cast<Eigen::Index>(points.size());
+  ConstArrayMap x(points.x.data(), size);
+  ConstArrayMap y(points.y.data(), size);
+  ConstArrayMap z(points.z.data(), size);
+  const Eigen::Vector3f min(x.minCoeff(), y.minCoeff(), z.minCoeff());
+  const Eigen::Vector3f max(x.maxCoeff(), y.maxCoeff(), z.maxCoeff());
+  const Eigen::Vector3f origin = 0.5f * (min + max);
+  compact.origin = origin.cast<double>();
+
+  auto compress = [size, &origin](const ConstArrayMap& values, int axis,
+                                  std::vector<Eigen::half>& compressed) {
+    compressed.resize(size);
+    HalfArrayMap(compressed.data(), size) =
+        (values - origin[axis]).cast<Eigen::half>();
+  };
+  compress(x, 0, compact.x);
+  compress(y, 1, compact.y);
+  compress(z, 2, compact.z);
+  return compact;
+}
+
+} // namespace bs_common
@@ -0,0 +1,201 @@
+#include <bs_common/snapshot_manager.h>
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+#include <ros/console.h>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+#include <bs_common/async_disk_writer.h>
+
+namespace bs_common {
+
+namespace {
+
+const std::string kManifestFilename = "snapshot.json";
+const std::string kTempSuffix = ".tmp";
+
+bool ReadManifest(const std::string& directory, ros::Time& stamp) {
+  const std::string manifest_path =
+      beam::CombinePaths(directory, kManifestFilename);
+  if (!boost::filesystem::exists(manifest_path)) { return false; }
+  nlohmann::json J;
+  if (!beam::ReadJson(manifest_path, J) || !J.contains("stamp_nsecs")) {
+    return false;
+  }
+  stamp.fromNSec(J["stamp_nsecs"].get<uint64_t>());
+  return true;
+}
+
+} // namespace
+
+SnapshotManager& SnapshotManager::GetInstance() {
+  // constructed first so that it is destroyed last: queued saves are flushed
+  // when the writer is destroyed, and they still use this instance
+  AsyncDiskWriter::GetInstance();
+  static SnapshotManager instance;
+  return instance;
+}
+
+void SnapshotManager::SetParams(const Params& params) {
+  if (params.max_warm_start_gap_s < params.period_s) {
+    BEAM_ERROR("Invalid snapshot max_warm_start_gap_s: {}, must be at least "
+               "period_s ({}) plus the expected restart time",
+               params.max_warm_start_gap_s, params.period_s);
+    throw std::invalid_argument{"invalid max_warm_start_gap_s"};
+  }
+  std::lock_guard<std::mutex> lk(mutex_);
+  params_ = params;
+}
+
+SnapshotManager::Params SnapshotManager::GetParams() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return params_;
+}
+
+std::string SnapshotManager::ComponentPath(const std::string& component) const {
+  return beam::CombinePaths(params_.path, component);
+}
+
+bool SnapshotManager::SaveDue(const std::string& component,
+                              const ros::Time& stamp) const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (!params_.save || params_.path.empty()) { return false; }
+  auto iter = last_save_stamps_.find(component);
+  if (iter == last_save_stamps_.end()) { return true; }
+  return (stamp - iter->second).toSec() >= params_.period_s;
+}
+
+bool SnapshotManager::Save(const std::string& component,
+                           const ros::Time& stamp, const IOFunction& write) {
+  std::string final_path;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (params_.path.empty()) { return false; }
+    final_path = ComponentPath(component);
+    // record the attempt so a failing component does not retry every update
+    last_save_stamps_[component] = stamp;
+  }
+  return Write(component, final_path, stamp, write);
+}
+
+bool SnapshotManager::SaveAsync(const std::string& component,
+                                const ros::Time& stamp, IOFunction write) {
+  std::string final_path;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (params_.path.empty()) { return false; }
+    final_path = ComponentPath(component);
+    last_save_stamps_[component] = stamp;
+  }
+  return AsyncDiskWriter::GetInstance().Enqueue(
+      "snapshot of " + component,
+      [this, component, final_path, stamp, write]() {
+        Write(component, final_path, stamp, write);
+      });
+}
+
+bool SnapshotManager::Write(const std::string& component,
+                            const std::string& final_path,
+                            const ros::Time& stamp,
+                            const IOFunction& write) const {
+  const std::string temp_path = final_path + kTempSuffix;
+  const ros::WallTime start = ros::WallTime::now();
+
+  try {
+    boost::filesystem::remove_all(temp_path);
+    boost::filesystem::create_directories(temp_path);
+    if (!write(temp_path)) {
+      BEAM_ERROR("Unable to save snapshot of component: {}", component);
+      boost::filesystem::remove_all(temp_path);
+      return false;
+    }
+
+    // the manifest is written last, it marks the directory as complete
+    nlohmann::json J;
+    J["stamp_nsecs"] = stamp.toNSec();
+    J["save_time_s"] = (ros::WallTime::now() - start).toSec();
+    std::ofstream file(beam::CombinePaths(temp_path, kManifestFilename));
+    file << std::setw(4) << J << std::endl;
+    file.close();
+
+    boost::filesystem::remove_all(final_path);
+    boost::filesystem::rename(temp_path, final_path);
+  } catch (const boost::filesystem::filesystem_error& e) {
+    BEAM_ERROR("Unable to save snapshot of component {}: {}", component,
+               e.what());
+    return false;
+  }
+
+  ROS_DEBUG_STREAM("Saved snapshot of " << component << " at "
+                                        << stamp.toSec() << " in "
+                                        << (ros::WallTime::now() - start).toSec()
+                                        << "s");
+  return true;
+}
+
+bool SnapshotManager::Load(const std::string& component,
+                           const IOFunction& read) const {
+  std::string final_path;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (params_.path.empty()) { return false; }
+    final_path = ComponentPath(component);
+  }
+
+  // if we crashed between removing the old snapshot and renaming the new one,
+  // the complete snapshot is still in the temporary directory
+  ros::Time stamp;
+  std::string path = final_path;
+  if (!ReadManifest(path, stamp)) {
+    path = final_path + kTempSuffix;
+    if (!ReadManifest(path, stamp)) { return false; }
+  }
+
+  const ros::WallTime start = ros::WallTime::now();
+  if (!read(path)) {
+    BEAM_ERROR("Unable to load snapshot of component: {}", component);
+    return false;
+  }
+  ROS_INFO_STREAM("Loaded snapshot of " << component << " at "
+                                        << stamp.toSec() << " in "
+                                        << (ros::WallTime::now() - start).toSec()
+                                        << "s");
+  return true;
+}
+
+bool SnapshotManager::GetStamp(const std::string& component,
+                               ros::Time& stamp) const {
+  std::string final_path;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (params_.path.empty()) { return false; }
+    final_path = ComponentPath(component);
+  }
+  return ReadManifest(final_path, stamp) ||
+         ReadManifest(final_path + kTempSuffix, stamp);
+}
+
+void SnapshotManager::SetWarmStarted(const ros::Time& stamp) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  warm_start_stamp_ = stamp;
+  warm_started_ = true;
+}
+
+bool SnapshotManager::WarmStarted() const {
+  return warm_started_;
+}
+
+void SnapshotManager::Reset() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  last_save_stamps_.clear();
+  warm_started_ = false;
+  warm_start_stamp_ = ros::Time(0);
+}
+
+} // namespace bs_common
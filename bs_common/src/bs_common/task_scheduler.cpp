@@ -0,0 +1,298 @@
+#include <bs_common/task_scheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+#include <beam_utils/log.h>
+
+#include <bs_common/thread_placement.h>
+
+namespace bs_common {
+
+namespace {
+
+int NumCores() {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+/**
+ * @brief state of a ParallelFor shared between the calling thread and the
+ * helper tasks, which may start after the loop is done
+ */
+struct LoopState {
+  LoopState(size_t _n, const std::function<void(size_t)>& _func)
+      : n(_n), func(_func) {}
+
+  /** claim and run indices until there are none left */
+  void Work() {
+    size_t num_done = 0;
+    for (size_t i = next++; i < n; i = next++) {
+      try {
+        func(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (!error) { error = std::current_exception(); }
+      }
+      num_done++;
+    }
+    if (num_done == 0) { return; }
+    std::lock_guard<std::mutex> lk(mutex);
+    done += num_done;
+    if (done == n) { cv.notify_all(); }
+  }
+
+  const size_t n;
+  const std::function<void(size_t)>& func;
+  std::atomic<size_t> next{0};
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t done{0};
+  std::exception_ptr error;
+};
+
+} // namespace
+
+TaskScheduler& TaskScheduler::GetInstance() {
+  static TaskScheduler instance;
+  return instance;
+}
+
+TaskScheduler::~TaskScheduler() {
+  StopThreads();
+}
+
+void TaskScheduler::SetParams(const Params& params) {
+  ValidateThreadPlacement(GetPlacement(params, false), "task scheduler");
+  ValidateThreadPlacement(GetPlacement(params, true),
+                          "task scheduler realtime worker");
+
+  StopThreads();
+  std::lock_guard<std::mutex> lk(mutex_);
+  params_ = params;
+}
+
+std::future<void> TaskScheduler::Submit(TaskPriority priority, Task task) {
+  auto promise = std::make_shared<std::promise<void>>();
+  std::future<void> future = promise->get_future();
+  Enqueue(priority, [promise, task = std::move(task)]() {
+    try {
+      task();
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+      throw;
+    }
+    promise->set_value();
+  });
+  return future;
+}
+
+void TaskScheduler::ParallelFor(TaskPriority priority, size_t n,
+                                const std::function<void(size_t)>& func,
+                                int max_parallelism) {
+  if (n == 0) { return; }
+  int num_helpers = NumThreads();
+  if (max_parallelism > 0) {
+    num_helpers = std::min(num_helpers, max_parallelism - 1);
+  }
+  num_helpers = std::min<size_t>(num_helpers, n - 1);
+
+  // func is only used while the caller waits, but late helpers still need
+  // the state to see that there is nothing left to do
+  auto state = std::make_shared<LoopState>(n, func);
+  for (int i = 0; i < num_helpers; i++) {
+    Enqueue(priority, [state]() { state->Work(); });
+  }
+  state->Work();
+
+  std::unique_lock<std::mutex> lk(state->mutex);
+  state->cv.wait(lk, [&state] { return state->done == state->n; });
+  if (state->error) { std::rethrow_exception(state->error); }
+}
+
+void TaskScheduler::Flush() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  idle_cv_.wait(lk, [this] {
+    return active_tasks_ == 0 &&
+           std::all_of(queues_.begin(), queues_.end(),
+                       [](const std::deque<QueuedTask>& queue) {
+                         return queue.empty();
+                       });
+  });
+}
+
+TaskScheduler::Stats TaskScheduler::GetStats() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  Stats stats = stats_;
+  for (size_t p = 0; p < kNumPriorities; p++) {
+    stats.priorities[p].queue_size = queues_[p].size();
+  }
+  if (!threads_.empty()) {
+    stats.num_threads = threads_.size();
+    stats.elapsed_time_s =
+        std::chrono::duration<double>(Clock::now() - start_time_).count();
+    if (stats.elapsed_time_s > 0) {
+      stats.utilization = std::min(
+          busy_time_s_ / (stats.elapsed_time_s * stats.num_threads), 1.0);
+    }
+  }
+  return stats;
+}
+
+int TaskScheduler::NumThreads() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return params_.num_threads > 0 ? params_.num_threads : NumCores();
+}
+
+std::string TaskScheduler::ToString(TaskPriority priority) {
+  switch (priority) {
+    case TaskPriority::REALTIME:
+      return "REALTIME";
+    case TaskPriority::MAPPING:
+      return "MAPPING";
+    case TaskPriority::IO:
+      return "IO";
+  }
+  return "UNKNOWN";
+}
+
+void TaskScheduler::Enqueue(TaskPriority priority, Task task) {
+  const size_t p = static_cast<size_t>(priority);
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    StartThreads();
+    queues_[p].push_back(QueuedTask{std::move(task), Clock::now()});
+    auto& stats = stats_.priorities[p];
+    stats.submitted++;
+    stats.max_queue_size_reached =
+        std::max(stats.max_queue_size_reached, queues_[p].size());
+  }
+  // the shared workers can run any task, so waking one of them is enough. A
+  // realtime worker is woken too since it may be the only one idle
+  task_cv_.notify_one();
+  if (priority == TaskPriority::REALTIME) { realtime_cv_.notify_one(); }
+}
+
+void TaskScheduler::StartThreads() {
+  if (!threads_.empty()) { return; }
+  const int num_threads =
+      params_.num_threads > 0 ? params_.num_threads : NumCores();
+  // keep at least one shared worker so that every priority can run
+  const int realtime_threads =
+      std::min(std::max(params_.realtime_threads, 0), num_threads - 1);
+  for (int i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&TaskScheduler::Run, this, generation_,
+                          GetPlacement(params_, i < realtime_threads),
+                          i < realtime_threads);
+  }
+  start_time_ = Clock::now();
+  busy_time_s_ = 0;
+}
+
+void TaskScheduler::StopThreads() {
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    generation_++;
+    threads.swap(threads_);
+  }
+  task_cv_.notify_all();
+  realtime_cv_.notify_all();
+  for (auto& thread : threads) { thread.join(); }
+}
+
+bool TaskScheduler::PopTask(bool realtime_only, QueuedTask& task,
+                            size_t& priority) {
+  const size_t num_priorities = realtime_only ? 1 : kNumPriorities;
+  for (size_t p = 0; p < num_priorities; p++) {
+    if (queues_[p].empty()) { continue; }
+    task = std::move(queues_[p].front());
+    queues_[p].pop_front();
+    priority = p;
+    return true;
+  }
+  return false;
+}
+
+bs_parameters::ThreadPlacementParams
+    TaskScheduler::GetPlacement(const Params& params, bool realtime_only) {
+  bs_parameters::ThreadPlacementParams placement;
+  placement.cpu_affinity = params.cpu_affinity;
+  placement.scheduling_policy = params.scheduling_policy;
+  placement.priority = params.priority;
+  if (realtime_only) {
+    if (!params.realtime_cpu_affinity.empty()) {
+      placement.cpu_affinity = params.realtime_cpu_affinity;
+    }
+    placement.scheduling_policy = params.realtime_scheduling_policy;
+    placement.priority = params.realtime_priority;
+  }
+  return placement;
+}
+
+void TaskScheduler::Run(uint64_t generation,
+                        bs_parameters::ThreadPlacementParams placement,
+                        bool realtime_only) {
+  // leaves the thread as is if nothing is configured
+  ThreadPlacement(realtime_only ? "task scheduler realtime worker"
+                                : "task scheduler worker",
+                  placement)
+      .ApplyToCurrentThread();
+  std::condition_variable& cv = realtime_only ? realtime_cv_ : task_cv_;
+  while (true) {
+    QueuedTask task;
+    size_t priority;
+    Clock::time_point start;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cv.wait(lk, [&] {
+        return generation_ != generation ||
+               !queues_[0].empty() ||
+               (!realtime_only &&
+                (!queues_[1].empty() || !queues_[2].empty()));
+      });
+      // on stop, run the queued tasks before exiting
+      if (!PopTask(realtime_only, task, priority)) { return; }
+      active_tasks_++;
+      start = Clock::now();
+      auto& stats = stats_.priorities[priority];
+      const double wait_time_s =
+          std::chrono::duration<double>(start - task.submit_time).count();
+      stats.total_wait_time_s += wait_time_s;
+      stats.max_wait_time_s = std::max(stats.max_wait_time_s, wait_time_s);
+    }
+
+    bool success{true};
+    try {
+      task.task();
+    } catch (const std::exception& e) {
+      BEAM_ERROR("{} task failed: {}",
+                 ToString(static_cast<TaskPriority>(priority)), e.what());
+      success = false;
+    } catch (...) {
+      BEAM_ERROR("{} task failed",
+                 ToString(static_cast<TaskPriority>(priority)));
+      success = false;
+    }
+    const double run_time_s =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      active_tasks_--;
+      auto& stats = stats_.priorities[priority];
+      if (success) {
+        stats.completed++;
+      } else {
+        stats.failed++;
+      }
+      stats.total_run_time_s += run_time_s;
+      busy_time_s_ += run_time_s;
+    }
+    idle_cv_.notify_all();
+  }
+}
+
+} // namespace bs_common
@@ -0,0 +1,221 @@
+#include <bs_common/thread_placement.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <beam_utils/log.h>
+
+namespace bs_common {
+
+namespace {
+
+bool IsRealtimePolicy(const std::string& policy) {
+  return policy == "FIFO" || policy == "RR";
+}
+
+#ifdef __linux__
+int ToLinuxPolicy(const std::string& policy) {
+  if (policy == "BATCH") { return SCHED_BATCH; }
+  if (policy == "IDLE") { return SCHED_IDLE; }
+  if (policy == "FIFO") { return SCHED_FIFO; }
+  if (policy == "RR") { return SCHED_RR; }
+  return SCHED_OTHER;
+}
+#endif
+
+std::mutex monitors_mutex;
+std::map<std::string, std::weak_ptr<JitterMonitor>> monitors;
+
+} // namespace
+
+bool ApplyThreadPlacement(const bs_parameters::ThreadPlacementParams& params,
+                          const std::string& name) {
+  bool success{true};
+#ifdef __linux__
+  if (!params.cpu_affinity.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : params.cpu_affinity) { CPU_SET(core, &set); }
+    const int error =
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+    if (error != 0) {
+      BEAM_WARN("Unable to set the cpu affinity of {}: {}", name,
+                std::strerror(error));
+      success = false;
+    }
+  }
+
+  sched_param param{};
+  param.sched_priority = IsRealtimePolicy(params.scheduling_policy)
+                             ? params.priority
+                             : 0;
+  const int error = pthread_setschedparam(
+      pthread_self(), ToLinuxPolicy(params.scheduling_policy), &param);
+  if (error != 0) {
+    BEAM_WARN("Unable to set scheduling policy {} of {}: {}",
+              params.scheduling_policy, name, std::strerror(error));
+    success = false;
+  }
+
+  // the nice value of a thread is set through its thread id
+  if (params.scheduling_policy == "OTHER" ||
+      params.scheduling_policy == "BATCH") {
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), params.priority) !=
+        0) {
+      BEAM_WARN("Unable to set nice value {} of {}: {}", params.priority,
+                name, std::strerror(errno));
+      success = false;
+    }
+  }
+#else
+  if (!params.cpu_affinity.empty() || params.scheduling_policy != "OTHER" ||
+      params.priority != 0) {
+    BEAM_WARN("Thread placement is only supported on linux, not placing {}",
+              name);
+    success = false;
+  }
+#endif
+  return success;
+}
+
+void ValidateThreadPlacement(
+    const bs_parameters::ThreadPlacementParams& params,
+    const std::string& name) {
+  for (int core : params.cpu_affinity) {
+#ifdef __linux__
+    const bool valid = core >= 0 && core < CPU_SETSIZE;
+#else
+    const bool valid = core >= 0;
+#endif
+    if (!valid) {
+      BEAM_ERROR("Invalid core id in cpu affinity of {}: {}", name, core);
+      throw std::invalid_argument{"invalid core id"};
+    }
+  }
+
+  const std::string& policy = params.scheduling_policy;
+  if (policy != "OTHER" && policy != "BATCH" && policy != "IDLE" &&
+      !IsRealtimePolicy(policy)) {
+    BEAM_ERROR("Invalid scheduling policy of {}: {}, options are OTHER, "
+               "BATCH, IDLE, FIFO, RR",
+               name, policy);
+    throw std::invalid_argument{"invalid scheduling policy"};
+  }
+
+  if (IsRealtimePolicy(policy) &&
+      (params.priority < 1 || params.priority > 99)) {
+    BEAM_ERROR("Invalid real-time priority of {}: {}, must be in [1, 99]",
+               name, params.priority);
+    throw std::invalid_argument{"invalid priority"};
+  } else if ((policy == "OTHER" || policy == "BATCH") &&
+             (params.priority < -20 || params.priority > 19)) {
+    BEAM_ERROR("Invalid nice value of {}: {}, must be in [-20, 19]", name,
+               params.priority);
+    throw std::invalid_argument{"invalid priority"};
+  }
+}
+
+ThreadPlacement::ThreadPlacement(const std::string& name, const Params& params)
+    : name_(name), params_(params) {
+  ValidateThreadPlacement(params_, name_);
+  enabled_ = !params_.cpu_affinity.empty() ||
+             params_.scheduling_policy != "OTHER" || params_.priority != 0;
+  static std::atomic<uint64_t> next_id{1};
+  id_ = next_id++;
+}
+
+void ThreadPlacement::ApplyToCurrentThread() const {
+  if (!enabled_) { return; }
+  thread_local std::unordered_set<uint64_t> applied;
+  if (!applied.insert(id_).second) { return; }
+  if (ApplyThreadPlacement(params_, name_)) {
+    BEAM_INFO("Placed a thread of {}", name_);
+  }
+}
+
+std::shared_ptr<JitterMonitor> JitterMonitor::Create(const std::string& name,
+                                                     size_t window_size) {
+  std::lock_guard<std::mutex> lk(monitors_mutex);
+  auto& monitor = monitors[name];
+  if (auto existing = monitor.lock()) { return existing; }
+  auto created = std::make_shared<JitterMonitor>(window_size);
+  monitor = created;
+  return created;
+}
+
+std::map<std::string, JitterMonitor::Stats> JitterMonitor::GetAllStats() {
+  std::lock_guard<std::mutex> lk(monitors_mutex);
+  std::map<std::string, Stats> stats;
+  for (auto iter = monitors.begin(); iter != monitors.end();) {
+    if (auto monitor = iter->second.lock()) {
+      stats.emplace(iter->first, monitor->GetStats());
+      iter++;
+    } else {
+      iter = monitors.erase(iter);
+    }
+  }
+  return stats;
+}
+
+JitterMonitor::JitterMonitor(size_t window_size)
+    : window_size_(std::max<size_t>(window_size, 1)) {}
+
+void JitterMonitor::AddSample(double latency_s) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  samples_.push_back(latency_s);
+  if (samples_.size() > window_size_) { samples_.pop_front(); }
+  count_++;
+}
+
+JitterMonitor::Stats JitterMonitor::GetStats() const {
+  std::vector<double> samples;
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    samples.assign(samples_.begin(), samples_.end());
+    stats.count = count_;
+  }
+  if (samples.empty()) { return stats; }
+
+  std::sort(samples.begin(), samples.end());
+  double sum{0};
+  for (double s : samples) { sum += s; }
+  stats.mean_s = sum / samples.size();
+  double sum_sq{0};
+  for (double s : samples) {
+    sum_sq += (s - stats.mean_s) * (s - stats.mean_s);
+  }
+  stats.stddev_s = std::sqrt(sum_sq / samples.size());
+  auto percentile = [&samples](double p) {
+    const size_t rank =
+        static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+  };
+  stats.p50_s = percentile(50);
+  stats.p99_s = percentile(99);
+  stats.max_s = samples.back();
+  return stats;
+}
+
+void JitterMonitor::Reset() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  samples_.clear();
+  count_ = 0;
+}
+
+} // namespace bs_common
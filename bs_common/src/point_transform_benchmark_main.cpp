@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <pcl/common/transforms.h>
+#include <pcl/point_types.h>
+
+#include <beam_utils/log.h>
+
+#include <bs_common/point_transform.h>
+
+// clang-format off
+/**
+ * Compares the ways point clouds are transformed in the lidar pipeline on a
+ * random cloud: pcl::transformPointCloud, a per point Eigen multiply, and
+ * bs_common::TransformPoints on PointsSoA and CompactPoints. Also times
+ * converting the cloud to PointsSoA, transforming it and converting it back,
+ * which is what a pcl cloud that is only transformed once would cost.
+ *
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_common/bs_common_point_transform_benchmark_main \
+ -points 100000 \
+ -iterations 100
+ */
+// clang-format on
+
+DEFINE_int32(points, 100000, "Number of points in the cloud.");
+DEFINE_int32(iterations, 100, "Number of times to run each implementation.");
+DEFINE_double(range, 30, "Points are uniformly sampled in [-range, range].");
+
+namespace {
+
+using PointCloud = pcl::PointCloud<pcl::PointXYZ>;
+
+/** best time of all iterations, in seconds */
+double Time(const std::function<void()>& func) {
+  double best_s = std::numeric_limits<double>::max();
+  for (int i = 0; i < FLAGS_iterations; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+    best_s = std::min(best_s, duration.count());
+  }
+  return best_s;
+}
+
+double MaxError(const bs_common::PointsSoA& a, const bs_common::PointsSoA& b) {
+  double max_error{0};
+  for (size_t i = 0; i < a.size(); i++) {
+    const Eigen::Vector3d diff(a.x[i] - b.x[i], a.y[i] - b.y[i],
+                               a.z[i] - b.z[i]);
+    max_error = std::max(max_error, diff.norm());
+  }
+  return max_error;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_points < 1 || FLAGS_iterations < 1) {
+    BEAM_ERROR("points and iterations must be at least 1");
+    return 1;
+  }
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-FLAGS_range, FLAGS_range);
+  PointCloud cloud;
+  cloud.resize(FLAGS_points);
+  for (auto& p : cloud) {
+    p.x = dist(gen);
+    p.y = dist(gen);
+    p.z = dist(gen);
+  }
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, 3).normalized())
+          .toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(10, -5, 2);
+  const Eigen::Matrix4f T_float = T.cast<float>();
+
+  PointCloud pcl_out;
+  const double pcl_s =
+      Time([&]() { pcl::transformPointCloud(cloud, pcl_out, T_float); });
+
+  PointCloud eigen_out;
+  const double eigen_s = Time([&]() {
+    eigen_out = cloud;
+    for (auto& p : eigen_out) {
+      const Eigen::Vector4f transformed = T_float * Eigen::Vector4f(p.x, p.y,
+                                                                    p.z, 1);
+      p.x = transformed[0];
+      p.y = transformed[1];
+      p.z = transformed[2];
+    }
+  });
+
+  const bs_common::PointsSoA points = bs_common::ToPointsSoA(cloud);
+  bs_common::PointsSoA soa_out;
+  const double soa_s =
+      Time([&]() { bs_common::TransformPoints(T, points, soa_out); });
+
+  const bs_common::CompactPoints compact = bs_common::CompressPoints(points);
+  bs_common::PointsSoA compact_out;
+  const double compact_s =
+      Time([&]() { bs_common::TransformPoints(T, compact, compact_out); });
+
+  PointCloud round_trip_out;
+  const double round_trip_s = Time([&]() {
+    bs_common::PointsSoA converted = bs_common::ToPointsSoA(cloud);
+    bs_common::TransformPoints(T, converted, converted);
+    bs_common::FromPointsSoA(converted, round_trip_out);
+  });
+
+  auto report = [](const std::string& name, double time_s, double base_s) {
+    BEAM_INFO("{:<32} {:>9.5f}s {:>8.1f} Mpoints/s {:>6.2f}x", name, time_s,
+              FLAGS_points / time_s * 1e-6, base_s / time_s);
+  };
+  BEAM_INFO("{} points, best of {} iterations, speedup relative to pcl",
+            FLAGS_points, FLAGS_iterations);
+  report("pcl::transformPointCloud", pcl_s, pcl_s);
+  report("per point Eigen", eigen_s, pcl_s);
+  report("TransformPoints PointsSoA", soa_s, pcl_s);
+  report("TransformPoints CompactPoints", compact_s, pcl_s);
+  report("PointCloud to PointsSoA and back", round_trip_s, pcl_s);
+
+  const size_t soa_bytes = 3 * sizeof(float) * points.size();
+  const size_t compact_bytes = 3 * sizeof(Eigen::half) * compact.size();
+  BEAM_INFO("memory: PointCloud {:.2f}MB, PointsSoA {:.2f}MB, CompactPoints "
+            "{:.2f}MB",
+            sizeof(pcl::PointXYZ) * cloud.size() * 1e-6, soa_bytes * 1e-6,
+            compact_bytes * 1e-6);
+
+  const bs_common::PointsSoA expected = bs_common::ToPointsSoA(pcl_out);
+  const double round_trip_error =
+      MaxError(bs_common::ToPointsSoA(round_trip_out), expected);
+  const double soa_error = MaxError(soa_out, expected);
+  const double compact_error = MaxError(compact_out, expected);
+  BEAM_INFO("max error relative to pcl: PointsSoA {:.2e}m, CompactPoints "
+            "{:.2e}m",
+            soa_error, compact_error);
+  if (soa_error > 1e-4 || round_trip_error > 1e-4) {
+    BEAM_ERROR("results differ from pcl::transformPointCloud");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <bs_common/async_disk_writer.h>
+
+using namespace bs_common;
+
+namespace {
+
+AsyncDiskWriter::Params GetTestParams(const std::string& policy) {
+  AsyncDiskWriter::Params params;
+  params.max_queue_size = 3;
+  params.overflow_policy = policy;
+  params.max_block_time_s = 0.01;
+  return params;
+}
+
+// Holds the writer thread inside a write until Release() is called, so that
+// we can fill the queue deterministically
+class Gate {
+public:
+  void Wait() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    entered_ = true;
+    entered_cv_.notify_all();
+    cv_.wait(lk, [this] { return open_; });
+  }
+
+  void WaitUntilEntered() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    entered_cv_.wait(lk, [this] { return entered_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable entered_cv_;
+  bool open_{false};
+  bool entered_{false};
+};
+
+} // namespace
+
+TEST(AsyncDiskWriter, WritesInOrder) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  AsyncDiskWriter::Params params = GetTestParams("BLOCK");
+  params.max_queue_size = 1000;
+  writer.SetParams(params);
+  const auto stats_before = writer.GetStats();
+
+  std::vector<int> written;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(
+        writer.Enqueue("test", [&written, i]() { written.push_back(i); }));
+  }
+  writer.Flush();
+
+  ASSERT_EQ(written.size(), 100u);
+  for (int i = 0; i < 100; i++) { EXPECT_EQ(written[i], i); }
+  const auto stats = writer.GetStats();
+  EXPECT_EQ(stats.written - stats_before.written, 100u);
+  EXPECT_EQ(stats.dropped - stats_before.dropped, 0u);
+  EXPECT_EQ(stats.queue_size, 0u);
+}
+
+TEST(AsyncDiskWriter, DropNewest) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  writer.SetParams(GetTestParams("DROP_NEWEST"));
+  const auto stats_before = writer.GetStats();
+
+  Gate gate;
+  std::vector<int> written;
+  writer.Enqueue("blocking", [&gate]() { gate.Wait(); });
+  gate.WaitUntilEntered();
+  for (int i = 0; i < 5; i++) {
+    const bool queued =
+        writer.Enqueue("test", [&written, i]() { written.push_back(i); });
+    EXPECT_EQ(queued, i < 3);
+  }
+  gate.Release();
+  writer.Flush();
+
+  EXPECT_EQ(written, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(writer.GetStats().dropped - stats_before.dropped, 2u);
+}
+
+TEST(AsyncDiskWriter, DropOldest) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  writer.SetParams(GetTestParams("DROP_OLDEST"));
+  const auto stats_before = writer.GetStats();
+
+  Gate gate;
+  std::vector<int> written;
+  writer.Enqueue("blocking", [&gate]() { gate.Wait(); });
+  gate.WaitUntilEntered();
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(
+        writer.Enqueue("test", [&written, i]() { written.push_back(i); }));
+  }
+  gate.Release();
+  writer.Flush();
+
+  EXPECT_EQ(written, std::vector<int>({2, 3, 4}));
+  EXPECT_EQ(writer.GetStats().dropped - stats_before.dropped, 2u);
+}
+
+TEST(AsyncDiskWriter, BlockTimesOut) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  writer.SetParams(GetTestParams("BLOCK"));
+  const auto stats_before = writer.GetStats();
+
+  Gate gate;
+  std::atomic<int> num_written{0};
+  writer.Enqueue("blocking", [&gate]() { gate.Wait(); });
+  gate.WaitUntilEntered();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(writer.Enqueue("test", [&num_written]() { num_written++; }));
+  }
+  // the writer is stuck, so this waits for max_block_time_s then drops
+  EXPECT_FALSE(writer.Enqueue("test", [&num_written]() { num_written++; }));
+  gate.Release();
+  writer.Flush();
+
+  EXPECT_EQ(num_written, 3);
+  const auto stats = writer.GetStats();
+  EXPECT_EQ(stats.dropped - stats_before.dropped, 1u);
+  EXPECT_GE(stats.max_queue_size_reached, 3u);
+}
+
+TEST(AsyncDiskWriter, CountsFailures) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  writer.SetParams(GetTestParams("BLOCK"));
+  const auto stats_before = writer.GetStats();
+
+  writer.Enqueue("failing", []() { throw std::runtime_error{"disk full"}; });
+  writer.Enqueue("test", []() {});
+  writer.Flush();
+
+  const auto stats = writer.GetStats();
+  EXPECT_EQ(stats.failed - stats_before.failed, 1u);
+  EXPECT_EQ(stats.written - stats_before.written, 1u);
+}
+
+TEST(AsyncDiskWriter, InvalidPolicyThrows) {
+  AsyncDiskWriter& writer = AsyncDiskWriter::GetInstance();
+  EXPECT_THROW(writer.SetParams(GetTestParams("DROP_RANDOM")),
+               std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
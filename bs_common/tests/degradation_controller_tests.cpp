@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <bs_common/degradation_controller.h>
+
+using namespace bs_common;
+
+namespace {
+
+DegradationController::Params GetTestParams() {
+  DegradationController::Params params;
+  params.enabled = true;
+  params.high_load_ratio = 0.9;
+  params.low_load_ratio = 0.5;
+  params.max_queue_lag_fraction = 0.25;
+  params.cycles_to_degrade = 3;
+  params.cycles_to_recover = 5;
+  return params;
+}
+
+} // namespace
+
+TEST(DegradationController, DisabledStaysNominal) {
+  DegradationController& controller = DegradationController::GetInstance();
+  DegradationController::Params params = GetTestParams();
+  params.enabled = false;
+  controller.SetParams(params);
+  for (int i = 0; i < 100; i++) { controller.AddCycle(1.0, 0.1, 5.0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::NOMINAL);
+  EXPECT_EQ(controller.LandmarkFraction(), 1.0);
+  EXPECT_EQ(controller.VoxelSizeScale(), 1.0);
+  EXPECT_EQ(controller.SolverIterationFraction(), 1.0);
+  EXPECT_EQ(controller.KeyframeSpacingScale(), 1.0);
+}
+
+TEST(DegradationController, DegradesAndRecovers) {
+  DegradationController& controller = DegradationController::GetInstance();
+  controller.SetParams(GetTestParams());
+
+  // overloaded by optimization time
+  for (int i = 0; i < 2; i++) { controller.AddCycle(0.2, 0.1, 0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::NOMINAL);
+  controller.AddCycle(0.2, 0.1, 0, 5.0);
+  EXPECT_EQ(controller.Level(), DegradationLevel::LIGHT);
+  EXPECT_LT(controller.LandmarkFraction(), 1.0);
+  EXPECT_GT(controller.VoxelSizeScale(), 1.0);
+
+  // overloaded by queue length
+  for (int i = 0; i < 3; i++) { controller.AddCycle(0.01, 0.1, 2.0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::MODERATE);
+
+  // saturates at the highest level
+  for (int i = 0; i < 30; i++) { controller.AddCycle(0.2, 0.1, 0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::SEVERE);
+
+  // cycles between thresholds reset the counters
+  for (int i = 0; i < 4; i++) { controller.AddCycle(0.01, 0.1, 0, 5.0); }
+  controller.AddCycle(0.07, 0.1, 0, 5.0);
+  for (int i = 0; i < 4; i++) { controller.AddCycle(0.01, 0.1, 0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::SEVERE);
+
+  // recover one level at a time
+  controller.AddCycle(0.01, 0.1, 0, 5.0);
+  EXPECT_EQ(controller.Level(), DegradationLevel::MODERATE);
+  for (int i = 0; i < 10; i++) { controller.AddCycle(0.01, 0.1, 0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::NOMINAL);
+}
+
+TEST(DegradationController, Reset) {
+  DegradationController& controller = DegradationController::GetInstance();
+  controller.SetParams(GetTestParams());
+  for (int i = 0; i < 3; i++) { controller.AddCycle(0.2, 0.1, 0, 5.0); }
+  EXPECT_EQ(controller.Level(), DegradationLevel::LIGHT);
+  controller.Reset();
+  EXPECT_EQ(controller.Level(), DegradationLevel::NOMINAL);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <pcl/point_types.h>
+
+#include <bs_common/point_transform.h>
+
+using namespace bs_common;
+
+namespace {
+
+Eigen::Matrix4d RandomTransform(std::mt19937& gen) {
+  std::uniform_real_distribution<double> dist(-10, 10);
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      Eigen::Quaterniond::UnitRandom().normalized().toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(dist(gen), dist(gen), dist(gen));
+  return T;
+}
+
+PointsSoA RandomPoints(std::mt19937& gen, size_t size, double range) {
+  std::uniform_real_distribution<float> dist(-range, range);
+  PointsSoA points;
+  points.resize(size);
+  for (size_t i = 0; i < size; i++) {
+    points.x[i] = dist(gen);
+    points.y[i] = dist(gen);
+    points.z[i] = dist(gen);
+  }
+  return points;
+}
+
+Eigen::Vector3d Point(const PointsSoA& points, size_t i) {
+  return Eigen::Vector3d(points.x[i], points.y[i], points.z[i]);
+}
+
+} // namespace
+
+TEST(PointTransform, PointsSoA) {
+  std::mt19937 gen(0);
+  const Eigen::Matrix4d T = RandomTransform(gen);
+
+  // sizes around the block size
+  for (size_t size : {0, 1, 7, 256, 257, 1000}) {
+    const PointsSoA points = RandomPoints(gen, size, 50);
+    PointsSoA transformed;
+    TransformPoints(T, points, transformed);
+    ASSERT_EQ(transformed.size(), size);
+    for (size_t i = 0; i < size; i++) {
+      const Eigen::Vector3d expected =
+          (T * Point(points, i).homogeneous()).head<3>();
+      EXPECT_LT((Point(transformed, i) - expected).norm(), 1e-4);
+    }
+
+    // in place
+    PointsSoA in_place = points;
+    TransformPoints(T, in_place, in_place);
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(Point(in_place, i), Point(transformed, i));
+    }
+  }
+}
+
+TEST(PointTransform, PointCloud) {
+  std::mt19937 gen(1);
+  const PointsSoA points = RandomPoints(gen, 600, 50);
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  cloud.resize(10);
+  FromPointsSoA(points, cloud);
+  ASSERT_EQ(cloud.size(), points.size());
+  const PointsSoA converted = ToPointsSoA(cloud);
+  ASSERT_EQ(converted.size(), points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    EXPECT_EQ(Point(converted, i), Point(points, i));
+  }
+}
+
+TEST(PointTransform, CompactPoints) {
+  std::mt19937 gen(2);
+  const Eigen::Matrix4d T = RandomTransform(gen);
+
+  // a 40m wide map far from the world origin
+  PointsSoA points = RandomPoints(gen, 1000, 20);
+  TransformPoints(Eigen::Affine3d(Eigen::Translation3d(500, -300, 20)).matrix(),
+                  points, points);
+
+  const CompactPoints compact = CompressPoints(points);
+  ASSERT_EQ(compact.size(), points.size());
+  EXPECT_LT((compact.origin - Eigen::Vector3d(500, -300, 20)).norm(), 1);
+
+  // offsets are within 20m on each axis, so within 35m of the origin
+  PointsSoA decompressed;
+  TransformPoints(Eigen::Matrix4d::Identity(), compact, decompressed);
+  PointsSoA transformed;
+  TransformPoints(T, compact, transformed);
+  PointsSoA expected;
+  TransformPoints(T, points, expected);
+  for (size_t i = 0; i < points.size(); i++) {
+    EXPECT_LT((Point(decompressed, i) - Point(points, i)).norm(), 0.03);
+    EXPECT_LT((Point(transformed, i) - Point(expected, i)).norm(), 0.03);
+  }
+
+  EXPECT_EQ(CompressPoints(PointsSoA()).size(), 0u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <bs_common/spsc_ring_buffer.h>
+#include <bs_common/timed_lock.h>
+
+using namespace bs_common;
+
+TEST(SpscRingBuffer, OrderAndWrapAround) {
+  SpscRingBuffer<int> buffer(3);
+  EXPECT_EQ(buffer.Capacity(), 4u);
+  EXPECT_TRUE(buffer.Empty());
+
+  int value;
+  EXPECT_FALSE(buffer.Pop(value));
+
+  // several passes over the buffer so the indices wrap around
+  int next_push = 0;
+  int next_pop = 0;
+  for (int pass = 0; pass < 5; pass++) {
+    for (int i = 0; i < 3; i++) { EXPECT_TRUE(buffer.Push(next_push++)); }
+    EXPECT_EQ(buffer.Size(), 3u);
+    for (int i = 0; i < 3; i++) {
+      ASSERT_TRUE(buffer.Pop(value));
+      EXPECT_EQ(value, next_pop++);
+    }
+    EXPECT_TRUE(buffer.Empty());
+  }
+}
+
+TEST(SpscRingBuffer, Full) {
+  SpscRingBuffer<std::unique_ptr<int>> buffer(2);
+  EXPECT_TRUE(buffer.Push(std::make_unique<int>(0)));
+  EXPECT_TRUE(buffer.Push(std::make_unique<int>(1)));
+
+  // a failed push leaves the value alone
+  auto value = std::make_unique<int>(2);
+  EXPECT_FALSE(buffer.Push(std::move(value)));
+  ASSERT_TRUE(value);
+
+  std::vector<int> drained;
+  const size_t num_drained = buffer.Drain(
+      [&drained](std::unique_ptr<int>&& v) { drained.push_back(*v); });
+  EXPECT_EQ(num_drained, 2u);
+  EXPECT_EQ(drained, std::vector<int>({0, 1}));
+  EXPECT_TRUE(buffer.Push(std::move(value)));
+  EXPECT_EQ(buffer.Size(), 1u);
+}
+
+TEST(SpscRingBuffer, ProducerConsumer) {
+  const int num_values = 100000;
+  SpscRingBuffer<int> buffer(64);
+
+  std::thread producer([&buffer]() {
+    for (int i = 0; i < num_values; i++) {
+      while (!buffer.Push(i)) { std::this_thread::yield(); }
+    }
+  });
+
+  int expected = 0;
+  bool in_order{true};
+  while (expected < num_values) {
+    buffer.Drain([&](int v) { in_order = in_order && v == expected++; });
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(buffer.Empty());
+}
+
+TEST(SpscRingBuffer, PushWhileConsumerLocked) {
+  // the consumer holds a mutex for a long time, pushes do not wait for it
+  SpscRingBuffer<int> buffer(16);
+  std::mutex mutex;
+  JitterMonitor lock_hold;
+  {
+    TimedLock lk(mutex, &lock_hold);
+    std::thread producer([&]() {
+      for (int i = 0; i < 10; i++) { EXPECT_TRUE(buffer.Push(i)); }
+      TimedLock try_lk(mutex, &lock_hold, std::try_to_lock);
+      EXPECT_FALSE(try_lk.owns_lock());
+    });
+    producer.join();
+    buffer.Drain([](int) {});
+  }
+  EXPECT_TRUE(buffer.Empty());
+
+  // only the lock that was held is recorded
+  EXPECT_EQ(lock_hold.GetStats().count, 1u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
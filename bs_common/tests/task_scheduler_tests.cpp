@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <bs_common/task_scheduler.h>
+
+using namespace bs_common;
+
+namespace {
+
+TaskScheduler::Params GetTestParams(int num_threads, int realtime_threads) {
+  TaskScheduler::Params params;
+  params.num_threads = num_threads;
+  params.realtime_threads = realtime_threads;
+  return params;
+}
+
+// Holds a worker inside a task until Release() is called, so that we can fill
+// the queues deterministically
+class Gate {
+public:
+  void Wait() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    entered_ = true;
+    entered_cv_.notify_all();
+    cv_.wait(lk, [this] { return open_; });
+  }
+
+  void WaitUntilEntered() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    entered_cv_.wait(lk, [this] { return entered_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable entered_cv_;
+  bool open_{false};
+  bool entered_{false};
+};
+
+} // namespace
+
+TEST(TaskScheduler, RunsByPriority) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(1, 0));
+
+  Gate gate;
+  scheduler.Submit(TaskPriority::IO, [&gate]() { gate.Wait(); });
+  gate.WaitUntilEntered();
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto add = [&mutex, &order](int i) {
+    return [&mutex, &order, i]() {
+      std::lock_guard<std::mutex> lk(mutex);
+      order.push_back(i);
+    };
+  };
+  scheduler.Submit(TaskPriority::IO, add(4));
+  scheduler.Submit(TaskPriority::MAPPING, add(2));
+  scheduler.Submit(TaskPriority::REALTIME, add(0));
+  scheduler.Submit(TaskPriority::MAPPING, add(3));
+  scheduler.Submit(TaskPriority::REALTIME, add(1));
+  gate.Release();
+  scheduler.Flush();
+
+  ASSERT_EQ(order.size(), 5u);
+  for (int i = 0; i < 5; i++) { EXPECT_EQ(order[i], i); }
+}
+
+TEST(TaskScheduler, RealtimeWorkerIsNotBlocked) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(2, 1));
+
+  // hold the only shared worker in a mapping task, a realtime task should
+  // still run on the realtime worker
+  Gate gate;
+  scheduler.Submit(TaskPriority::MAPPING, [&gate]() { gate.Wait(); });
+  gate.WaitUntilEntered();
+
+  std::atomic<bool> ran{false};
+  auto future =
+      scheduler.Submit(TaskPriority::REALTIME, [&ran]() { ran = true; });
+  future.wait();
+  EXPECT_TRUE(ran);
+  gate.Release();
+  scheduler.Flush();
+}
+
+TEST(TaskScheduler, SubmitPropagatesExceptions) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(2, 0));
+  const auto stats_before = scheduler.GetStats();
+  const size_t mapping = static_cast<size_t>(TaskPriority::MAPPING);
+
+  auto future = scheduler.Submit(TaskPriority::MAPPING, []() {
+    throw std::runtime_error{"test"};
+  });
+  EXPECT_THROW(future.get(), std::runtime_error);
+  scheduler.Flush();
+
+  const auto stats = scheduler.GetStats();
+  EXPECT_EQ(stats.priorities[mapping].failed -
+                stats_before.priorities[mapping].failed,
+            1u);
+}
+
+TEST(TaskScheduler, ParallelFor) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(4, 1));
+
+  const size_t n = 1000;
+  std::vector<std::atomic<int>> calls(n);
+  for (auto& c : calls) { c = 0; }
+  scheduler.ParallelFor(TaskPriority::REALTIME, n,
+                        [&calls](size_t i) { calls[i]++; });
+  for (size_t i = 0; i < n; i++) { EXPECT_EQ(calls[i], 1); }
+
+  // limited to the calling thread
+  std::vector<int> order;
+  scheduler.ParallelFor(
+      TaskPriority::MAPPING, 10,
+      [&order](size_t i) { order.push_back(static_cast<int>(i)); }, 1);
+  ASSERT_EQ(order.size(), 10u);
+  for (int i = 0; i < 10; i++) { EXPECT_EQ(order[i], i); }
+}
+
+TEST(TaskScheduler, ParallelForRethrows) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(4, 0));
+
+  std::atomic<int> num_calls{0};
+  EXPECT_THROW(scheduler.ParallelFor(TaskPriority::MAPPING, 100,
+                                     [&num_calls](size_t i) {
+                                       num_calls++;
+                                       if (i == 50) {
+                                         throw std::runtime_error{"test"};
+                                       }
+                                     }),
+               std::runtime_error);
+  // all other calls still run
+  EXPECT_EQ(num_calls, 100);
+}
+
+TEST(TaskScheduler, NestedParallelFor) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(2, 0));
+
+  // every worker is busy in the outer loop, the inner loops must still finish
+  std::atomic<int> sum{0};
+  scheduler.ParallelFor(TaskPriority::MAPPING, 8, [&](size_t) {
+    scheduler.ParallelFor(TaskPriority::MAPPING, 8,
+                          [&sum](size_t j) { sum += static_cast<int>(j); });
+  });
+  EXPECT_EQ(sum, 8 * 28);
+}
+
+TEST(TaskScheduler, Stats) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  scheduler.SetParams(GetTestParams(2, 0));
+  const auto stats_before = scheduler.GetStats();
+  const size_t io = static_cast<size_t>(TaskPriority::IO);
+
+  for (int i = 0; i < 10; i++) {
+    scheduler.Submit(TaskPriority::IO, []() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+  }
+  scheduler.Flush();
+
+  const auto stats = scheduler.GetStats();
+  EXPECT_EQ(stats.num_threads, 2);
+  EXPECT_EQ(stats.priorities[io].submitted -
+                stats_before.priorities[io].submitted,
+            10u);
+  EXPECT_EQ(stats.priorities[io].completed -
+                stats_before.priorities[io].completed,
+            10u);
+  EXPECT_EQ(stats.priorities[io].queue_size, 0u);
+  EXPECT_GT(stats.priorities[io].total_run_time_s, 0.009);
+  EXPECT_GT(stats.utilization, 0);
+  EXPECT_LE(stats.utilization, 1);
+}
+
+TEST(TaskScheduler, InvalidAffinity) {
+  TaskScheduler& scheduler = TaskScheduler::GetInstance();
+  TaskScheduler::Params params = GetTestParams(2, 1);
+  params.cpu_affinity = {-1};
+  EXPECT_THROW(scheduler.SetParams(params), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <bs_common/thread_placement.h>
+
+using namespace bs_common;
+
+TEST(ThreadPlacement, Validate) {
+  ThreadPlacement::Params params;
+  EXPECT_NO_THROW(ValidateThreadPlacement(params, "test"));
+
+  params.cpu_affinity = {-1};
+  EXPECT_THROW(ValidateThreadPlacement(params, "test"), std::invalid_argument);
+
+  params.cpu_affinity.clear();
+  params.scheduling_policy = "DEADLINE";
+  EXPECT_THROW(ValidateThreadPlacement(params, "test"), std::invalid_argument);
+
+  params.scheduling_policy = "FIFO";
+  params.priority = 0;
+  EXPECT_THROW(ValidateThreadPlacement(params, "test"), std::invalid_argument);
+  params.priority = 50;
+  EXPECT_NO_THROW(ValidateThreadPlacement(params, "test"));
+
+  params.scheduling_policy = "OTHER";
+  params.priority = 20;
+  EXPECT_THROW(ThreadPlacement("test", params), std::invalid_argument);
+}
+
+#ifdef __linux__
+TEST(ThreadPlacement, PinsThread) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &allowed), 0);
+  int core = 0;
+  while (core < CPU_SETSIZE && !CPU_ISSET(core, &allowed)) { core++; }
+  ASSERT_LT(core, CPU_SETSIZE);
+
+  ThreadPlacement::Params params;
+  params.cpu_affinity = {core};
+  const ThreadPlacement placement("test", params);
+
+  // a new thread so that the test thread is not pinned
+  bool pinned{false};
+  std::thread thread([&]() {
+    placement.ApplyToCurrentThread();
+    placement.ApplyToCurrentThread();
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &set) == 0) {
+      pinned = CPU_COUNT(&set) == 1 && CPU_ISSET(core, &set);
+    }
+  });
+  thread.join();
+  EXPECT_TRUE(pinned);
+}
+#endif
+
+TEST(JitterMonitor, Stats) {
+  JitterMonitor monitor(100);
+  EXPECT_EQ(monitor.GetStats().count, 0u);
+
+  for (int i = 1; i <= 200; i++) { monitor.AddSample(i * 0.001); }
+  const auto stats = monitor.GetStats();
+  EXPECT_EQ(stats.count, 200u);
+
+  // only the last 100 samples, 0.101 to 0.2
+  EXPECT_NEAR(stats.mean_s, 0.1505, 1e-9);
+  EXPECT_NEAR(stats.p50_s, 0.150, 1e-9);
+  EXPECT_NEAR(stats.p99_s, 0.199, 1e-9);
+  EXPECT_NEAR(stats.max_s, 0.2, 1e-9);
+  EXPECT_NEAR(stats.stddev_s, 0.028866, 1e-5);
+
+  monitor.Reset();
+  EXPECT_EQ(monitor.GetStats().count, 0u);
+}
+
+TEST(JitterMonitor, Registry) {
+  auto monitor = JitterMonitor::Create("registry_test");
+  EXPECT_EQ(JitterMonitor::Create("registry_test"), monitor);
+  monitor->AddSample(0.5);
+
+  auto all_stats = JitterMonitor::GetAllStats();
+  ASSERT_EQ(all_stats.count("registry_test"), 1u);
+  EXPECT_EQ(all_stats.at("registry_test").count, 1u);
+
+  // monitors are listed while they are in use
+  monitor.reset();
+  EXPECT_EQ(JitterMonitor::GetAllStats().count("registry_test"), 0u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
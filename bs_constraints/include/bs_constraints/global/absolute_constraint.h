@@ -7,6 +7,8 @@
 
 #include <bs_variables/accel_bias_3d_stamped.h>
 #include <bs_variables/gyro_bias_3d_stamped.h>
+#include <bs_variables/orientation_control_point_3d_stamped.h>
+#include <bs_variables/position_control_point_3d_stamped.h>
 
 namespace bs_constraints {
 
@@ -25,6 +27,12 @@ using AbsoluteGyroBias3DStampedConstraint =
 using AbsoluteAccelBias3DStampedConstraint =
     fuse_constraints::AbsoluteConstraint<
         bs_variables::AccelerationBias3DStamped>;
+using AbsolutePositionControlPoint3DStampedConstraint =
+    fuse_constraints::AbsoluteConstraint<
+        bs_variables::PositionControlPoint3DStamped>;
+using AbsoluteOrientationControlPoint3DStampedConstraint =
+    fuse_constraints::AbsoluteConstraint<
+        bs_variables::OrientationControlPoint3DStamped>;
 
 } // namespace bs_constraints
 
@@ -39,3 +47,7 @@ BOOST_CLASS_EXPORT_KEY(
     bs_constraints::AbsoluteAccelerationLinear3DStampedConstraint);
 BOOST_CLASS_EXPORT_KEY(bs_constraints::AbsoluteGyroBias3DStampedConstraint);
 BOOST_CLASS_EXPORT_KEY(bs_constraints::AbsoluteAccelBias3DStampedConstraint);
+BOOST_CLASS_EXPORT_KEY(
+    bs_constraints::AbsolutePositionControlPoint3DStampedConstraint);
+BOOST_CLASS_EXPORT_KEY(
+    bs_constraints::AbsoluteOrientationControlPoint3DStampedConstraint);
@@ -7,6 +7,8 @@
 
 #include <bs_variables/accel_bias_3d_stamped.h>
 #include <bs_variables/gyro_bias_3d_stamped.h>
+#include <bs_variables/orientation_control_point_3d_stamped.h>
+#include <bs_variables/position_control_point_3d_stamped.h>
 
 namespace fuse_constraints {
 
@@ -40,4 +42,17 @@ inline std::string fuse_constraints::AbsoluteConstraint<
   return "fuse_constraints::AbsoluteAccelBias3DStampedConstraint";
 }
 
+template <>
+inline std::string fuse_constraints::AbsoluteConstraint<
+    bs_variables::PositionControlPoint3DStamped>::type() const {
+  return "fuse_constraints::AbsolutePositionControlPoint3DStampedConstraint";
+}
+
+template <>
+inline std::string fuse_constraints::AbsoluteConstraint<
+    bs_variables::OrientationControlPoint3DStamped>::type() const {
+  return "fuse_constraints::"
+         "AbsoluteOrientationControlPoint3DStampedConstraint";
+}
+
 }  // namespace fuse_constraints
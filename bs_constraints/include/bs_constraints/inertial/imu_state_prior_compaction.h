@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <fuse_core/graph.h>
+#include <fuse_core/transaction.h>
+
+#include <bs_common/imu_state.h>
+#include <bs_constraints/inertial/absolute_imu_state_3d_stamped_constraint.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief Merge a set of absolute priors on the same IMU state into a single
+ * dense prior. The priors are linearized about the mean of the first prior,
+ * their information matrices are summed and the merged mean is the information
+ * weighted average of the individual means in that tangent space. For priors
+ * that agree within the linearization this produces the same cost (up to a
+ * constant) as keeping all priors in the graph.
+ *
+ * @param source source of the merged constraint
+ * @param imu_state imu state that all priors are on. Only the variable uuids
+ * are used.
+ * @param priors priors to merge, must not be empty and must all be on
+ * imu_state. Not owned.
+ * @return merged prior
+ */
+AbsoluteImuState3DStampedConstraint::SharedPtr MergeImuStatePriors(
+    const std::string& source, const bs_common::ImuState& imu_state,
+    const std::vector<const AbsoluteImuState3DStampedConstraint*>& priors);
+
+/**
+ * @brief Compact the absolute IMU state priors from a given source so that
+ * each IMU state carries at most one of them once the transaction is applied
+ * to the graph.
+ *
+ * Priors considered are the ones currently in the graph which the transaction
+ * does not already remove, plus the ones the transaction adds. Any IMU state
+ * with more than one such prior has them all removed from (or dropped out of)
+ * the transaction and replaced by a single prior from MergeImuStatePriors.
+ *
+ * This is used with pseudo-marginalization, which adds a new prior on the
+ * window start state every time variables are marginalized. Without it, these
+ * priors stack up on the oldest states of the window whenever the window start
+ * does not change between cycles.
+ *
+ * @param graph graph the transaction is about to be applied to
+ * @param source source of the priors to compact
+ * @param transaction transaction to add the compaction to
+ * @return number of priors from this source in the graph once the transaction
+ * is applied
+ */
+size_t CompactImuStatePriors(const fuse_core::Graph& graph,
+                             const std::string& source,
+                             fuse_core::Transaction& transaction);
+
+} // namespace bs_constraints
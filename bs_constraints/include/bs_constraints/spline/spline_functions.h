@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cmath>
+
+#include <Eigen/Dense>
+
+namespace bs_constraints {
+
+/**
+ * @brief Cumulative basis of a uniform cubic B-spline, and its first and second
+ * time derivatives, evaluated at some normalized time u in [0, 1) within a
+ * segment. See "Spline Fusion: A continuous-time representation for
+ * visual-inertial fusion with application to rolling shutter cameras",
+ * Lovegrove et al., 2013.
+ *
+ * A segment between knots i and i + 1 is defined by the four control points
+ * i - 1, i, i + 1 and i + 2.
+ */
+struct SplineBasis {
+  SplineBasis() = default;
+
+  /**
+   * @param u normalized time within the segment
+   * @param knot_spacing_s time between knots
+   */
+  SplineBasis(double u, double knot_spacing_s) {
+    // cumulative basis matrix of a uniform cubic B-spline
+    static const Eigen::Matrix4d C =
+        (Eigen::Matrix4d() << 6, 0, 0, 0, 5, 3, -3, 1, 1, 3, 3, -2, 0, 0, 0, 1)
+            .finished() /
+        6.0;
+    const Eigen::Vector4d U(1, u, u * u, u * u * u);
+    const Eigen::Vector4d dU(0, 1, 2 * u, 3 * u * u);
+    const Eigen::Vector4d ddU(0, 0, 2, 6 * u);
+    B = C * U;
+    dB = C * dU / knot_spacing_s;
+    ddB = C * ddU / (knot_spacing_s * knot_spacing_s);
+  }
+
+  Eigen::Vector4d B{1, 0, 0, 0};
+  Eigen::Vector4d dB{Eigen::Vector4d::Zero()};
+  Eigen::Vector4d ddB{Eigen::Vector4d::Zero()};
+};
+
+/**
+ * @brief quaternion exponential map, which is also valid for ceres Jets near
+ * zero rotation
+ */
+template <typename T>
+Eigen::Quaternion<T> SplineExp(const Eigen::Matrix<T, 3, 1>& w) {
+  using std::cos;
+  using std::sin;
+  using std::sqrt;
+  const T theta_sq = w.squaredNorm();
+  if (theta_sq > T(1e-12)) {
+    const T theta = sqrt(theta_sq);
+    const Eigen::Matrix<T, 3, 1> v = w * (sin(theta / T(2)) / theta);
+    return Eigen::Quaternion<T>(cos(theta / T(2)), v[0], v[1], v[2]);
+  }
+  return Eigen::Quaternion<T>(T(1), w[0] / T(2), w[1] / T(2), w[2] / T(2));
+}
+
+/**
+ * @brief quaternion logarithm map, returning the rotation vector of the
+ * shortest rotation
+ */
+template <typename T>
+Eigen::Matrix<T, 3, 1> SplineLog(const Eigen::Quaternion<T>& q_in) {
+  using std::atan2;
+  using std::sqrt;
+  const Eigen::Quaternion<T> q =
+      q_in.w() < T(0) ? Eigen::Quaternion<T>(-q_in.coeffs()) : q_in;
+  const T sin_sq = q.vec().squaredNorm();
+  if (sin_sq > T(1e-12)) {
+    const T sin_half = sqrt(sin_sq);
+    return q.vec() * (T(2) * atan2(sin_half, q.w()) / sin_half);
+  }
+  return q.vec() * (T(2) / q.w());
+}
+
+/**
+ * @brief Evaluate the position of a cumulative B-spline, and optionally its
+ * first and second time derivatives
+ * @param p four control point positions [x, y, z]
+ * @param basis spline basis at the time of interest
+ * @param position output position
+ * @param velocity optional output velocity
+ * @param acceleration optional output acceleration
+ */
+template <typename T>
+void EvaluateSplinePosition(const T* const p[4], const SplineBasis& basis,
+                            Eigen::Matrix<T, 3, 1>& position,
+                            Eigen::Matrix<T, 3, 1>* velocity = nullptr,
+                            Eigen::Matrix<T, 3, 1>* acceleration = nullptr) {
+  position = Eigen::Map<const Eigen::Matrix<T, 3, 1>>(p[0]);
+  if (velocity) { velocity->setZero(); }
+  if (acceleration) { acceleration->setZero(); }
+  for (int j = 1; j < 4; j++) {
+    const Eigen::Matrix<T, 3, 1> d =
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>>(p[j]) -
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>>(p[j - 1]);
+    position += d * T(basis.B[j]);
+    if (velocity) { *velocity += d * T(basis.dB[j]); }
+    if (acceleration) { *acceleration += d * T(basis.ddB[j]); }
+  }
+}
+
+/**
+ * @brief Evaluate the orientation of a cumulative B-spline on SO(3), and
+ * optionally the angular velocity expressed in the body frame
+ * @param q four control point orientations [qw, qx, qy, qz]
+ * @param basis spline basis at the time of interest
+ * @param orientation output orientation
+ * @param angular_velocity optional output angular velocity in the body frame
+ */
+template <typename T>
+void EvaluateSplineOrientation(
+    const T* const q[4], const SplineBasis& basis,
+    Eigen::Quaternion<T>& orientation,
+    Eigen::Matrix<T, 3, 1>* angular_velocity = nullptr) {
+  auto to_quaternion = [](const T* const qwxyz) {
+    return Eigen::Quaternion<T>(qwxyz[0], qwxyz[1], qwxyz[2], qwxyz[3])
+        .normalized();
+  };
+  Eigen::Quaternion<T> q_prev = to_quaternion(q[0]);
+  orientation = q_prev;
+  if (angular_velocity) { angular_velocity->setZero(); }
+  for (int j = 1; j < 4; j++) {
+    const Eigen::Quaternion<T> q_j = to_quaternion(q[j]);
+    const Eigen::Matrix<T, 3, 1> d = SplineLog<T>(q_prev.conjugate() * q_j);
+    const Eigen::Quaternion<T> A = SplineExp<T>(Eigen::Matrix<T, 3, 1>(
+        d * T(basis.B[j])));
+    orientation = orientation * A;
+    if (angular_velocity) {
+      *angular_velocity = A.conjugate() * (*angular_velocity) +
+                          d * T(basis.dB[j]);
+    }
+    q_prev = q_j;
+  }
+}
+
+} // namespace bs_constraints
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/export.hpp>
+#include <fuse_core/constraint.h>
+#include <fuse_core/eigen.h>
+#include <fuse_core/fuse_macros.h>
+#include <fuse_core/serialization.h>
+#include <ros/time.h>
+
+#include <bs_constraints/spline/spline_trajectory.h>
+#include <bs_variables/accel_bias_3d_stamped.h>
+#include <bs_variables/gyro_bias_3d_stamped.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief A constraint on a continuous-time trajectory from a single IMU
+ * measurement, evaluated at the exact time of the measurement. See
+ * SplineImuCostFunctor.
+ */
+class SplineImuConstraint : public fuse_core::Constraint {
+public:
+  FUSE_CONSTRAINT_DEFINITIONS_WITH_EIGEN(SplineImuConstraint);
+
+  /**
+   * @brief Default constructor
+   */
+  SplineImuConstraint() = default;
+
+  /**
+   * @brief Create a constraint from an IMU measurement
+   * @param source the name of the sensor or motion model that generated this
+   * constraint
+   * @param trajectory spline trajectory to constrain
+   * @param stamp time of the measurement
+   * @param angular_velocity measured angular velocity in the baselink frame
+   * @param linear_acceleration measured linear acceleration in the baselink
+   * frame
+   * @param gyro_bias gyroscope bias variable
+   * @param accel_bias accelerometer bias variable
+   * @param covariance measurement covariance (6x6 matrix: gyro, accel)
+   */
+  SplineImuConstraint(const std::string& source,
+                      const SplineTrajectory& trajectory,
+                      const ros::Time& stamp,
+                      const Eigen::Vector3d& angular_velocity,
+                      const Eigen::Vector3d& linear_acceleration,
+                      const bs_variables::GyroscopeBias3DStamped& gyro_bias,
+                      const bs_variables::AccelerationBias3DStamped& accel_bias,
+                      const Eigen::Matrix<double, 6, 6>& covariance);
+
+  /**
+   * @brief Destructor
+   */
+  virtual ~SplineImuConstraint() = default;
+
+  /**
+   * @brief Read-only access to the time of the measurement
+   */
+  const ros::Time& stamp() const { return stamp_; }
+
+  /**
+   * @brief Read-only access to the square root information matrix.
+   */
+  const Eigen::Matrix<double, 6, 6>& sqrtInformation() const {
+    return sqrt_information_;
+  }
+
+  /**
+   * @brief Print a human-readable description of the constraint to the provided
+   * stream.
+   * @param stream the stream to write to. Defaults to stdout.
+   */
+  void print(std::ostream& stream = std::cout) const override;
+
+  /**
+   * @brief Construct an instance of this constraint's cost function
+   *
+   * The function caller will own the new cost function instance. It is the
+   * responsibility of the caller to delete the cost function object when it is
+   * no longer needed. If the pointer is provided to a Ceres::Problem object,
+   * the Ceres::Problem object will takes ownership of the pointer and delete it
+   * during destruction.
+   *
+   * @return a base pointer to an instance of a derived CostFunction.
+   */
+  ceres::CostFunction* costFunction() const override;
+
+protected:
+  ros::Time stamp_;
+  double u_{0};
+  double knot_spacing_s_{0};
+  Eigen::Vector3d angular_velocity_;
+  Eigen::Vector3d linear_acceleration_;
+  Eigen::Matrix<double, 6, 6> sqrt_information_;
+
+private:
+  SplineImuConstraint(const std::string& source,
+                      const std::vector<fuse_core::UUID>& variables,
+                      const SplineTrajectory::Segment& segment,
+                      double knot_spacing_s, const ros::Time& stamp,
+                      const Eigen::Vector3d& angular_velocity,
+                      const Eigen::Vector3d& linear_acceleration,
+                      const Eigen::Matrix<double, 6, 6>& covariance);
+
+  // Allow Boost Serialization access to private methods
+  friend class boost::serialization::access;
+
+  /**
+   * @brief The Boost Serialize method that serializes all of the data members
+   * in to/out of the archive
+   * @param archive - The archive object that holds the serialized class members
+   * @param version - The version of the archive being read/written. Generally
+   * unused.
+   */
+  template <class Archive>
+  void serialize(Archive& archive, const unsigned int /* version */) {
+    archive& boost::serialization::base_object<fuse_core::Constraint>(*this);
+    archive& stamp_;
+    archive& u_;
+    archive& knot_spacing_s_;
+    archive& angular_velocity_;
+    archive& linear_acceleration_;
+    archive& sqrt_information_;
+  }
+};
+
+} // namespace bs_constraints
+
+BOOST_CLASS_EXPORT_KEY(bs_constraints::SplineImuConstraint);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <fuse_core/fuse_macros.h>
+
+#include <bs_constraints/spline/spline_functions.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief Cost functor for a single IMU measurement expressed directly on a
+ * continuous-time trajectory, instead of being preintegrated between two
+ * discrete states.
+ *
+ * The cost function is of the form:
+ *
+ *   cost(x) = || A * [ w(t) + bg - w_meas                 ] ||^2
+ *             ||     [ R(t)^T * (a(t) - g) + ba - a_meas  ] ||
+ *
+ * where w(t) is the angular velocity of the spline in the baselink frame, a(t)
+ * its linear acceleration in the world frame, R(t) its orientation, g the
+ * gravity vector in the world frame and bg, ba the gyroscope and accelerometer
+ * biases. The IMU is assumed to be at the baselink frame.
+ *
+ * Parameters are the four position control points, the four orientation
+ * control points, the gyroscope bias and the accelerometer bias.
+ */
+class SplineImuCostFunctor {
+public:
+  FUSE_MAKE_ALIGNED_OPERATOR_NEW();
+
+  SplineImuCostFunctor(const SplineBasis& basis,
+                       const Eigen::Vector3d& angular_velocity,
+                       const Eigen::Vector3d& linear_acceleration,
+                       const Eigen::Vector3d& gravity_World,
+                       const Eigen::Matrix<double, 6, 6>& A)
+      : basis_(basis),
+        angular_velocity_(angular_velocity),
+        linear_acceleration_(linear_acceleration),
+        gravity_World_(gravity_World),
+        A_(A) {}
+
+  template <typename T>
+  bool operator()(const T* const p0, const T* const p1, const T* const p2,
+                  const T* const p3, const T* const q0, const T* const q1,
+                  const T* const q2, const T* const q3, const T* const bg,
+                  const T* const ba, T* residual) const {
+    const T* const p[4] = {p0, p1, p2, p3};
+    const T* const q[4] = {q0, q1, q2, q3};
+    Eigen::Matrix<T, 3, 1> t_World_Baselink;
+    Eigen::Matrix<T, 3, 1> v_World;
+    Eigen::Matrix<T, 3, 1> a_World;
+    Eigen::Quaternion<T> q_World_Baselink;
+    Eigen::Matrix<T, 3, 1> w_Baselink;
+    EvaluateSplinePosition(p, basis_, t_World_Baselink, &v_World, &a_World);
+    EvaluateSplineOrientation(q, basis_, q_World_Baselink, &w_Baselink);
+
+    Eigen::Matrix<T, 6, 1> error;
+    error.template head<3>() = w_Baselink +
+                               Eigen::Map<const Eigen::Matrix<T, 3, 1>>(bg) -
+                               angular_velocity_.cast<T>();
+    error.template tail<3>() =
+        q_World_Baselink.conjugate() * (a_World - gravity_World_.cast<T>()) +
+        Eigen::Map<const Eigen::Matrix<T, 3, 1>>(ba) -
+        linear_acceleration_.cast<T>();
+
+    Eigen::Map<Eigen::Matrix<T, 6, 1>> r(residual);
+    r = A_.cast<T>() * error;
+    return true;
+  }
+
+private:
+  SplineBasis basis_;
+  Eigen::Vector3d angular_velocity_;
+  Eigen::Vector3d linear_acceleration_;
+  Eigen::Vector3d gravity_World_;
+  Eigen::Matrix<double, 6, 6> A_;
+};
+
+} // namespace bs_constraints
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/export.hpp>
+#include <fuse_core/constraint.h>
+#include <fuse_core/eigen.h>
+#include <fuse_core/fuse_macros.h>
+#include <fuse_core/serialization.h>
+#include <ros/time.h>
+
+#include <bs_constraints/spline/spline_trajectory.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief A constraint on a continuous-time trajectory from a single lidar
+ * point, evaluated at the exact time the point was measured. The point is
+ * associated with a normal distribution in the world frame, see
+ * SplinePointCostFunctor. Since the trajectory is evaluated per point, scans
+ * do not need to be deskewed beforehand.
+ */
+class SplinePoint3DConstraint : public fuse_core::Constraint {
+public:
+  FUSE_CONSTRAINT_DEFINITIONS_WITH_EIGEN(SplinePoint3DConstraint);
+
+  /**
+   * @brief Default constructor
+   */
+  SplinePoint3DConstraint() = default;
+
+  /**
+   * @brief Create a constraint from a lidar point
+   * @param source the name of the sensor or motion model that generated this
+   * constraint
+   * @param trajectory spline trajectory to constrain
+   * @param stamp time the point was measured
+   * @param p_Baselink measured point, transformed to the baselink frame
+   * @param mean_World mean of the associated distribution
+   * @param sqrt_information square root information of the associated
+   * distribution
+   */
+  SplinePoint3DConstraint(const std::string& source,
+                          const SplineTrajectory& trajectory,
+                          const ros::Time& stamp,
+                          const Eigen::Vector3d& p_Baselink,
+                          const Eigen::Vector3d& mean_World,
+                          const Eigen::Matrix3d& sqrt_information);
+
+  /**
+   * @brief Destructor
+   */
+  virtual ~SplinePoint3DConstraint() = default;
+
+  /**
+   * @brief Read-only access to the time of the measurement
+   */
+  const ros::Time& stamp() const { return stamp_; }
+
+  /**
+   * @brief Read-only access to the square root information matrix.
+   */
+  const Eigen::Matrix3d& sqrtInformation() const { return sqrt_information_; }
+
+  /**
+   * @brief Print a human-readable description of the constraint to the provided
+   * stream.
+   * @param stream the stream to write to. Defaults to stdout.
+   */
+  void print(std::ostream& stream = std::cout) const override;
+
+  /**
+   * @brief Construct an instance of this constraint's cost function
+   *
+   * The function caller will own the new cost function instance. It is the
+   * responsibility of the caller to delete the cost function object when it is
+   * no longer needed. If the pointer is provided to a Ceres::Problem object,
+   * the Ceres::Problem object will takes ownership of the pointer and delete it
+   * during destruction.
+   *
+   * @return a base pointer to an instance of a derived CostFunction.
+   */
+  ceres::CostFunction* costFunction() const override;
+
+protected:
+  ros::Time stamp_;
+  double u_{0};
+  double knot_spacing_s_{0};
+  Eigen::Vector3d p_Baselink_;
+  Eigen::Vector3d mean_World_;
+  Eigen::Matrix3d sqrt_information_;
+
+private:
+  SplinePoint3DConstraint(const std::string& source,
+                          const std::vector<fuse_core::UUID>& variables,
+                          const SplineTrajectory::Segment& segment,
+                          double knot_spacing_s, const ros::Time& stamp,
+                          const Eigen::Vector3d& p_Baselink,
+                          const Eigen::Vector3d& mean_World,
+                          const Eigen::Matrix3d& sqrt_information);
+
+  // Allow Boost Serialization access to private methods
+  friend class boost::serialization::access;
+
+  /**
+   * @brief The Boost Serialize method that serializes all of the data members
+   * in to/out of the archive
+   * @param archive - The archive object that holds the serialized class members
+   * @param version - The version of the archive being read/written. Generally
+   * unused.
+   */
+  template <class Archive>
+  void serialize(Archive& archive, const unsigned int /* version */) {
+    archive& boost::serialization::base_object<fuse_core::Constraint>(*this);
+    archive& stamp_;
+    archive& u_;
+    archive& knot_spacing_s_;
+    archive& p_Baselink_;
+    archive& mean_World_;
+    archive& sqrt_information_;
+  }
+};
+
+} // namespace bs_constraints
+
+BOOST_CLASS_EXPORT_KEY(bs_constraints::SplinePoint3DConstraint);
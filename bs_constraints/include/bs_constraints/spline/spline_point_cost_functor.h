@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <fuse_core/fuse_macros.h>
+
+#include <bs_constraints/spline/spline_functions.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief Cost functor for a point measured by a lidar at a specific time, and
+ * associated with a normal distribution in the world frame (e.g. a plane, a
+ * line or a voxel of a map).
+ *
+ * The cost function is of the form:
+ *
+ *   cost(x) = || A * (T_World_Baselink(t) * p_Baselink - mu) ||^2
+ *
+ * where p_Baselink is the lidar point in the baselink frame,
+ * T_World_Baselink(t) is evaluated from the four control points of the
+ * spline segment containing the measurement time, mu is the mean of the
+ * distribution and A is its square root information.
+ *
+ * Parameters are the four position control points followed by the four
+ * orientation control points.
+ */
+class SplinePointCostFunctor {
+public:
+  FUSE_MAKE_ALIGNED_OPERATOR_NEW();
+
+  SplinePointCostFunctor(const SplineBasis& basis,
+                         const Eigen::Vector3d& p_Baselink,
+                         const Eigen::Vector3d& mean_World,
+                         const Eigen::Matrix3d& A)
+      : basis_(basis),
+        p_Baselink_(p_Baselink),
+        mean_World_(mean_World),
+        A_(A) {}
+
+  template <typename T>
+  bool operator()(const T* const p0, const T* const p1, const T* const p2,
+                  const T* const p3, const T* const q0, const T* const q1,
+                  const T* const q2, const T* const q3, T* residual) const {
+    const T* const p[4] = {p0, p1, p2, p3};
+    const T* const q[4] = {q0, q1, q2, q3};
+    Eigen::Matrix<T, 3, 1> t_World_Baselink;
+    Eigen::Quaternion<T> q_World_Baselink;
+    EvaluateSplinePosition(p, basis_, t_World_Baselink);
+    EvaluateSplineOrientation(q, basis_, q_World_Baselink);
+
+    const Eigen::Matrix<T, 3, 1> p_World =
+        q_World_Baselink * p_Baselink_.cast<T>() + t_World_Baselink;
+    Eigen::Map<Eigen::Matrix<T, 3, 1>> r(residual);
+    r = A_.cast<T>() * (p_World - mean_World_.cast<T>());
+    return true;
+  }
+
+private:
+  SplineBasis basis_;
+  Eigen::Vector3d p_Baselink_;
+  Eigen::Vector3d mean_World_;
+  Eigen::Matrix3d A_;
+};
+
+} // namespace bs_constraints
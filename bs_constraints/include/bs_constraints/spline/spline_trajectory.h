@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <fuse_core/graph.h>
+#include <fuse_core/transaction.h>
+#include <fuse_core/uuid.h>
+#include <ros/time.h>
+
+#include <bs_constraints/spline/spline_functions.h>
+
+namespace bs_constraints {
+
+/**
+ * @brief Continuous-time trajectory of the baselink frame, represented by a
+ * uniform cubic B-spline whose control points are stored in the graph as
+ * bs_variables::PositionControlPoint3DStamped and
+ * bs_variables::OrientationControlPoint3DStamped.
+ *
+ * Knots are placed at integer multiples of the knot spacing since the epoch,
+ * so that every sensor model using the same spacing refers to the same control
+ * point variables without having to coordinate. This class holds no state
+ * other than the knot spacing, the estimates all live in the graph.
+ */
+class SplineTrajectory {
+public:
+  /**
+   * @brief The part of the spline that defines the trajectory at some time
+   */
+  struct Segment {
+    /** stamps of the four control points */
+    std::array<ros::Time, 4> knots;
+
+    /** normalized time within the segment */
+    double u{0};
+    SplineBasis basis;
+  };
+
+  /**
+   * @brief constructor
+   * @param knot_spacing_s time between knots, must be positive
+   * @param device_id optional device id of the control point variables
+   */
+  explicit SplineTrajectory(
+      double knot_spacing_s,
+      const fuse_core::UUID& device_id = fuse_core::uuid::NIL);
+
+  double KnotSpacing() const;
+
+  /**
+   * @brief get the segment that defines the trajectory at some time
+   */
+  Segment GetSegment(const ros::Time& time) const;
+
+  /**
+   * @brief get the stamps of all control points needed to evaluate the
+   * trajectory between two times
+   */
+  std::vector<ros::Time> GetKnots(const ros::Time& start,
+                                  const ros::Time& end) const;
+
+  /**
+   * @brief uuids of the position control point variables of a segment
+   */
+  std::vector<fuse_core::UUID> PositionUuids(const Segment& segment) const;
+
+  /**
+   * @brief uuids of the orientation control point variables of a segment
+   */
+  std::vector<fuse_core::UUID> OrientationUuids(const Segment& segment) const;
+
+  /**
+   * @brief uuids of all control point variables of a segment, positions first
+   * then orientations, in the order used by the spline constraints
+   */
+  std::vector<fuse_core::UUID> SegmentUuids(const Segment& segment) const;
+
+  /**
+   * @brief check if all the control points of a segment are in a graph
+   */
+  bool InGraph(const fuse_core::Graph& graph, const Segment& segment) const;
+
+  /**
+   * @brief evaluate the pose of the baselink at some time using the control
+   * points in the graph
+   * @return false if any of the control points needed are not in the graph
+   */
+  bool GetPose(const fuse_core::Graph& graph, const ros::Time& time,
+               Eigen::Matrix4d& T_World_Baselink) const;
+
+  /**
+   * @brief add the control points needed to evaluate the trajectory between
+   * two times to a transaction. Control points that are already in the graph
+   * are not added.
+   * @param transaction transaction to add variables to
+   * @param start start time
+   * @param end end time
+   * @param T_World_Baselink initial value of the new control points
+   * @param graph optional current graph
+   * @return stamps of the control points that were added
+   */
+  std::vector<ros::Time>
+      AddControlPoints(fuse_core::Transaction& transaction,
+                       const ros::Time& start, const ros::Time& end,
+                       const Eigen::Matrix4d& T_World_Baselink,
+                       const fuse_core::Graph* graph = nullptr) const;
+
+  /**
+   * @brief add a prior on a control point, e.g. to fix the gauge of the
+   * trajectory when it is first created
+   * @param transaction transaction to add the constraints to
+   * @param stamp stamp of the control point, which must be in the graph or in
+   * the transaction
+   * @param T_World_Baselink prior mean
+   * @param covariance diagonal prior covariance
+   * @param source source of the constraints
+   */
+  void AddControlPointPrior(fuse_core::Transaction& transaction,
+                            const ros::Time& stamp,
+                            const Eigen::Matrix4d& T_World_Baselink,
+                            double covariance,
+                            const std::string& source) const;
+
+  /**
+   * @brief evaluate a spline segment from its control points
+   */
+  static Eigen::Matrix4d
+      Evaluate(const std::array<Eigen::Matrix4d, 4>& control_points,
+               const SplineBasis& basis);
+
+private:
+  bool GetControlPoint(const fuse_core::Graph& graph, const ros::Time& stamp,
+                       Eigen::Matrix4d& T_World_Baselink) const;
+
+  uint64_t knot_spacing_ns_;
+  fuse_core::UUID device_id_;
+};
+
+} // namespace bs_constraints
@@ -13,6 +13,10 @@ BOOST_CLASS_EXPORT_IMPLEMENT(
     bs_constraints::AbsoluteGyroBias3DStampedConstraint);
 BOOST_CLASS_EXPORT_IMPLEMENT(
     bs_constraints::AbsoluteAccelBias3DStampedConstraint);
+BOOST_CLASS_EXPORT_IMPLEMENT(
+    bs_constraints::AbsolutePositionControlPoint3DStampedConstraint);
+BOOST_CLASS_EXPORT_IMPLEMENT(
+    bs_constraints::AbsoluteOrientationControlPoint3DStampedConstraint);
 
 PLUGINLIB_EXPORT_CLASS(
     bs_constraints::AbsoluteVelocityAngular3DStampedConstraint,
@@ -27,3 +31,9 @@ PLUGINLIB_EXPORT_CLASS(bs_constraints::AbsoluteGyroBias3DStampedConstraint,
                        fuse_core::Constraint);
 PLUGINLIB_EXPORT_CLASS(bs_constraints::AbsoluteAccelBias3DStampedConstraint,
                        fuse_core::Constraint);
+PLUGINLIB_EXPORT_CLASS(
+    bs_constraints::AbsolutePositionControlPoint3DStampedConstraint,
+    fuse_core::Constraint);
+PLUGINLIB_EXPORT_CLASS(
+    bs_constraints::AbsoluteOrientationControlPoint3DStampedConstraint,
+    fuse_core::Constraint);
@@ -0,0 +1,144 @@
+#include <bs_constraints/inertial/imu_state_prior_compaction.h>
+
+#include <map>
+#include <unordered_set>
+
+#include <Eigen/Dense>
+#include <fuse_core/uuid.h>
+#include <fuse_variables/position_3d_stamped.h>
+
+namespace bs_constraints {
+
+namespace {
+
+Eigen::Quaterniond MeanOrientation(const Eigen::Matrix<double, 16, 1>& mean) {
+  return Eigen::Quaterniond(mean[0], mean[1], mean[2], mean[3]).normalized();
+}
+
+/**
+ * @brief Error of the linearization point x0 w.r.t. a prior mean, using the
+ * same orientation convention as the prior's cost functor
+ */
+Eigen::Matrix<double, 15, 1> PriorError(const Eigen::Matrix<double, 16, 1>& x0,
+                                        const Eigen::Matrix<double, 16, 1>& mean) {
+  Eigen::Matrix<double, 15, 1> error;
+  Eigen::AngleAxisd aa(MeanOrientation(mean).inverse() * MeanOrientation(x0));
+  error.head<3>() = aa.angle() * aa.axis();
+  error.tail<12>() = x0.tail<12>() - mean.tail<12>();
+  return error;
+}
+
+/**
+ * @brief Find the stamp of an IMU state from its position variable, looking
+ * first in the graph and then in the variables added by the transaction
+ */
+bool GetStateStamp(const fuse_core::Graph& graph,
+                   const fuse_core::Transaction& transaction,
+                   const fuse_core::UUID& position_uuid, ros::Time& stamp) {
+  const fuse_core::Variable* variable{nullptr};
+  if (graph.variableExists(position_uuid)) {
+    variable = &graph.getVariable(position_uuid);
+  } else {
+    for (const auto& v : transaction.addedVariables()) {
+      if (v.uuid() == position_uuid) {
+        variable = &v;
+        break;
+      }
+    }
+  }
+  const auto position =
+      dynamic_cast<const fuse_variables::Position3DStamped*>(variable);
+  if (!position) { return false; }
+  stamp = position->stamp();
+  return true;
+}
+
+} // namespace
+
+AbsoluteImuState3DStampedConstraint::SharedPtr MergeImuStatePriors(
+    const std::string& source, const bs_common::ImuState& imu_state,
+    const std::vector<const AbsoluteImuState3DStampedConstraint*>& priors) {
+  const Eigen::Matrix<double, 16, 1> x0 = priors.front()->mean();
+
+  // minimize sum_i || A_i (e_i + dx) ||^2 over the tangent space offset dx
+  Eigen::Matrix<double, 15, 15> information =
+      Eigen::Matrix<double, 15, 15>::Zero();
+  Eigen::Matrix<double, 15, 1> b = Eigen::Matrix<double, 15, 1>::Zero();
+  for (const auto prior : priors) {
+    const Eigen::Matrix<double, 15, 15> info_i =
+        prior->sqrtInformation().transpose() * prior->sqrtInformation();
+    information += info_i;
+    b += info_i * PriorError(x0, prior->mean());
+  }
+  const Eigen::Matrix<double, 15, 15> covariance = information.inverse();
+  const Eigen::Matrix<double, 15, 1> dx = -covariance * b;
+
+  Eigen::Matrix<double, 16, 1> mean;
+  Eigen::Quaterniond q = MeanOrientation(x0);
+  if (dx.head<3>().norm() > 0) {
+    q = q * Eigen::Quaterniond(
+                Eigen::AngleAxisd(dx.head<3>().norm(), dx.head<3>().normalized()));
+  }
+  mean << q.w(), q.x(), q.y(), q.z(), x0.tail<12>() + dx.tail<12>();
+
+  return std::make_shared<AbsoluteImuState3DStampedConstraint>(
+      source, imu_state, mean, covariance);
+}
+
+size_t CompactImuStatePriors(const fuse_core::Graph& graph,
+                             const std::string& source,
+                             fuse_core::Transaction& transaction) {
+  std::unordered_set<fuse_core::UUID, fuse_core::uuid::hash> removed;
+  for (const auto& uuid : transaction.removedConstraints()) {
+    removed.insert(uuid);
+  }
+
+  // group priors by the imu state they are on
+  std::map<std::vector<fuse_core::UUID>,
+           std::vector<const AbsoluteImuState3DStampedConstraint*>>
+      priors_per_state;
+  auto add_prior = [&](const fuse_core::Constraint& constraint) {
+    if (constraint.source() != source) { return; }
+    const auto prior =
+        dynamic_cast<const AbsoluteImuState3DStampedConstraint*>(&constraint);
+    if (!prior) { return; }
+    priors_per_state[prior->variables()].push_back(prior);
+  };
+  for (const auto& constraint : graph.getConstraints()) {
+    if (removed.find(constraint.uuid()) == removed.end()) {
+      add_prior(constraint);
+    }
+  }
+  for (const auto& constraint : transaction.addedConstraints()) {
+    add_prior(constraint);
+  }
+
+  size_t num_priors{0};
+  for (const auto& state_priors : priors_per_state) {
+    const auto& variables = state_priors.first;
+    const auto& priors = state_priors.second;
+    ros::Time stamp;
+    if (priors.size() < 2 ||
+        !GetStateStamp(graph, transaction, variables.at(1), stamp)) {
+      num_priors += priors.size();
+      continue;
+    }
+
+    // the merged prior must be built before the priors it merges are dropped
+    // from the transaction, since added priors are owned by the transaction
+    auto merged =
+        MergeImuStatePriors(source, bs_common::ImuState(stamp), priors);
+    if (merged->variables() != variables) {
+      num_priors += priors.size();
+      continue;
+    }
+    std::vector<fuse_core::UUID> to_remove;
+    for (const auto prior : priors) { to_remove.push_back(prior->uuid()); }
+    for (const auto& uuid : to_remove) { transaction.removeConstraint(uuid); }
+    transaction.addConstraint(merged);
+    num_priors++;
+  }
+  return num_priors;
+}
+
+} // namespace bs_constraints
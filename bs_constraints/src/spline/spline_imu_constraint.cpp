@@ -0,0 +1,85 @@
+#include <bs_constraints/spline/spline_imu_constraint.h>
+
+#include <boost/serialization/export.hpp>
+#include <ceres/autodiff_cost_function.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <bs_common/utils.h>
+#include <bs_constraints/spline/spline_imu_cost_functor.h>
+
+namespace bs_constraints {
+
+namespace {
+
+std::vector<fuse_core::UUID>
+    ImuVariables(const SplineTrajectory& trajectory, const ros::Time& stamp,
+                 const bs_variables::GyroscopeBias3DStamped& gyro_bias,
+                 const bs_variables::AccelerationBias3DStamped& accel_bias) {
+  std::vector<fuse_core::UUID> uuids =
+      trajectory.SegmentUuids(trajectory.GetSegment(stamp));
+  uuids.push_back(gyro_bias.uuid());
+  uuids.push_back(accel_bias.uuid());
+  return uuids;
+}
+
+} // namespace
+
+SplineImuConstraint::SplineImuConstraint(
+    const std::string& source, const SplineTrajectory& trajectory,
+    const ros::Time& stamp, const Eigen::Vector3d& angular_velocity,
+    const Eigen::Vector3d& linear_acceleration,
+    const bs_variables::GyroscopeBias3DStamped& gyro_bias,
+    const bs_variables::AccelerationBias3DStamped& accel_bias,
+    const Eigen::Matrix<double, 6, 6>& covariance)
+    : SplineImuConstraint(
+          source, ImuVariables(trajectory, stamp, gyro_bias, accel_bias),
+          trajectory.GetSegment(stamp), trajectory.KnotSpacing(), stamp,
+          angular_velocity, linear_acceleration, covariance) {}
+
+SplineImuConstraint::SplineImuConstraint(
+    const std::string& source, const std::vector<fuse_core::UUID>& variables,
+    const SplineTrajectory::Segment& segment, double knot_spacing_s,
+    const ros::Time& stamp, const Eigen::Vector3d& angular_velocity,
+    const Eigen::Vector3d& linear_acceleration,
+    const Eigen::Matrix<double, 6, 6>& covariance)
+    : fuse_core::Constraint(source, variables.begin(), variables.end()),
+      stamp_(stamp),
+      u_(segment.u),
+      knot_spacing_s_(knot_spacing_s),
+      angular_velocity_(angular_velocity),
+      linear_acceleration_(linear_acceleration),
+      sqrt_information_(covariance.inverse().llt().matrixU()) {}
+
+void SplineImuConstraint::print(std::ostream& stream) const {
+  stream << type() << "\n"
+         << "  source: " << source() << "\n"
+         << "  uuid: " << uuid() << "\n"
+         << "  stamp: " << stamp_ << "\n"
+         << "  u: " << u_ << "\n"
+         << "  angular_velocity: [" << angular_velocity_.transpose() << "]\n"
+         << "  linear_acceleration: [" << linear_acceleration_.transpose()
+         << "]\n"
+         << "  sqrt_info: " << sqrtInformation() << "\n";
+  for (size_t i = 0; i < variables().size(); i++) {
+    stream << "  variable " << i << ": " << variables().at(i) << "\n";
+  }
+
+  if (loss()) {
+    stream << "  loss: ";
+    loss()->print(stream);
+  }
+}
+
+ceres::CostFunction* SplineImuConstraint::costFunction() const {
+  return new ceres::AutoDiffCostFunction<SplineImuCostFunctor, 6, 3, 3, 3, 3,
+                                         4, 4, 4, 4, 3, 3>(
+      new SplineImuCostFunctor(SplineBasis(u_, knot_spacing_s_),
+                               angular_velocity_, linear_acceleration_,
+                               GRAVITY_WORLD, sqrt_information_));
+}
+
+} // namespace bs_constraints
+
+BOOST_CLASS_EXPORT_IMPLEMENT(bs_constraints::SplineImuConstraint);
+PLUGINLIB_EXPORT_CLASS(bs_constraints::SplineImuConstraint,
+                       fuse_core::Constraint);
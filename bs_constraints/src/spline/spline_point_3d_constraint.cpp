@@ -0,0 +1,64 @@
+#include <bs_constraints/spline/spline_point_3d_constraint.h>
+
+#include <boost/serialization/export.hpp>
+#include <ceres/autodiff_cost_function.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <bs_constraints/spline/spline_point_cost_functor.h>
+
+namespace bs_constraints {
+
+SplinePoint3DConstraint::SplinePoint3DConstraint(
+    const std::string& source, const SplineTrajectory& trajectory,
+    const ros::Time& stamp, const Eigen::Vector3d& p_Baselink,
+    const Eigen::Vector3d& mean_World, const Eigen::Matrix3d& sqrt_information)
+    : SplinePoint3DConstraint(
+          source, trajectory.SegmentUuids(trajectory.GetSegment(stamp)),
+          trajectory.GetSegment(stamp), trajectory.KnotSpacing(), stamp,
+          p_Baselink, mean_World, sqrt_information) {}
+
+SplinePoint3DConstraint::SplinePoint3DConstraint(
+    const std::string& source, const std::vector<fuse_core::UUID>& variables,
+    const SplineTrajectory::Segment& segment, double knot_spacing_s,
+    const ros::Time& stamp, const Eigen::Vector3d& p_Baselink,
+    const Eigen::Vector3d& mean_World, const Eigen::Matrix3d& sqrt_information)
+    : fuse_core::Constraint(source, variables.begin(), variables.end()),
+      stamp_(stamp),
+      u_(segment.u),
+      knot_spacing_s_(knot_spacing_s),
+      p_Baselink_(p_Baselink),
+      mean_World_(mean_World),
+      sqrt_information_(sqrt_information) {}
+
+void SplinePoint3DConstraint::print(std::ostream& stream) const {
+  stream << type() << "\n"
+         << "  source: " << source() << "\n"
+         << "  uuid: " << uuid() << "\n"
+         << "  stamp: " << stamp_ << "\n"
+         << "  u: " << u_ << "\n"
+         << "  p_Baselink: [" << p_Baselink_.transpose() << "]\n"
+         << "  mean_World: [" << mean_World_.transpose() << "]\n"
+         << "  sqrt_info: " << sqrtInformation() << "\n";
+  for (size_t i = 0; i < variables().size(); i++) {
+    stream << "  control point variable " << i << ": " << variables().at(i)
+           << "\n";
+  }
+
+  if (loss()) {
+    stream << "  loss: ";
+    loss()->print(stream);
+  }
+}
+
+ceres::CostFunction* SplinePoint3DConstraint::costFunction() const {
+  return new ceres::AutoDiffCostFunction<SplinePointCostFunctor, 3, 3, 3, 3, 3,
+                                         4, 4, 4, 4>(
+      new SplinePointCostFunctor(SplineBasis(u_, knot_spacing_s_),
+                                 p_Baselink_, mean_World_, sqrt_information_));
+}
+
+} // namespace bs_constraints
+
+BOOST_CLASS_EXPORT_IMPLEMENT(bs_constraints::SplinePoint3DConstraint);
+PLUGINLIB_EXPORT_CLASS(bs_constraints::SplinePoint3DConstraint,
+                       fuse_core::Constraint);
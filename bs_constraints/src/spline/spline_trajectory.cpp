@@ -0,0 +1,204 @@
+#include <bs_constraints/spline/spline_trajectory.h>
+
+#include <stdexcept>
+
+#include <bs_constraints/global/absolute_constraint.h>
+#include <bs_variables/orientation_control_point_3d_stamped.h>
+#include <bs_variables/position_control_point_3d_stamped.h>
+
+namespace bs_constraints {
+
+namespace {
+
+ros::Time KnotStamp(uint64_t index, uint64_t knot_spacing_ns) {
+  ros::Time stamp;
+  stamp.fromNSec(index * knot_spacing_ns);
+  return stamp;
+}
+
+} // namespace
+
+SplineTrajectory::SplineTrajectory(double knot_spacing_s,
+                                   const fuse_core::UUID& device_id)
+    : knot_spacing_ns_(static_cast<uint64_t>(knot_spacing_s * 1e9 + 0.5)),
+      device_id_(device_id) {
+  if (knot_spacing_ns_ == 0) {
+    throw std::invalid_argument{"spline knot spacing must be positive"};
+  }
+}
+
+double SplineTrajectory::KnotSpacing() const {
+  return knot_spacing_ns_ * 1e-9;
+}
+
+SplineTrajectory::Segment
+    SplineTrajectory::GetSegment(const ros::Time& time) const {
+  const uint64_t t = time.toNSec();
+  const uint64_t i = t / knot_spacing_ns_;
+  Segment segment;
+  for (uint64_t j = 0; j < 4; j++) {
+    segment.knots[j] = KnotStamp(i + j - 1, knot_spacing_ns_);
+  }
+  segment.u = static_cast<double>(t - i * knot_spacing_ns_) /
+              static_cast<double>(knot_spacing_ns_);
+  segment.basis = SplineBasis(segment.u, KnotSpacing());
+  return segment;
+}
+
+std::vector<ros::Time>
+    SplineTrajectory::GetKnots(const ros::Time& start,
+                               const ros::Time& end) const {
+  const uint64_t first = start.toNSec() / knot_spacing_ns_ - 1;
+  const uint64_t last = end.toNSec() / knot_spacing_ns_ + 2;
+  std::vector<ros::Time> knots;
+  for (uint64_t i = first; i <= last; i++) {
+    knots.push_back(KnotStamp(i, knot_spacing_ns_));
+  }
+  return knots;
+}
+
+std::vector<fuse_core::UUID>
+    SplineTrajectory::PositionUuids(const Segment& segment) const {
+  std::vector<fuse_core::UUID> uuids;
+  for (const auto& stamp : segment.knots) {
+    uuids.push_back(
+        bs_variables::PositionControlPoint3DStamped(stamp, device_id_).uuid());
+  }
+  return uuids;
+}
+
+std::vector<fuse_core::UUID>
+    SplineTrajectory::OrientationUuids(const Segment& segment) const {
+  std::vector<fuse_core::UUID> uuids;
+  for (const auto& stamp : segment.knots) {
+    uuids.push_back(
+        bs_variables::OrientationControlPoint3DStamped(stamp, device_id_)
+            .uuid());
+  }
+  return uuids;
+}
+
+std::vector<fuse_core::UUID>
+    SplineTrajectory::SegmentUuids(const Segment& segment) const {
+  std::vector<fuse_core::UUID> uuids = PositionUuids(segment);
+  const auto orientation_uuids = OrientationUuids(segment);
+  uuids.insert(uuids.end(), orientation_uuids.begin(),
+               orientation_uuids.end());
+  return uuids;
+}
+
+bool SplineTrajectory::InGraph(const fuse_core::Graph& graph,
+                               const Segment& segment) const {
+  for (const auto& uuid : SegmentUuids(segment)) {
+    if (!graph.variableExists(uuid)) { return false; }
+  }
+  return true;
+}
+
+bool SplineTrajectory::GetControlPoint(
+    const fuse_core::Graph& graph, const ros::Time& stamp,
+    Eigen::Matrix4d& T_World_Baselink) const {
+  const bs_variables::PositionControlPoint3DStamped p(stamp, device_id_);
+  const bs_variables::OrientationControlPoint3DStamped o(stamp, device_id_);
+  if (!graph.variableExists(p.uuid()) || !graph.variableExists(o.uuid())) {
+    return false;
+  }
+  const double* p_data = graph.getVariable(p.uuid()).data();
+  const double* o_data = graph.getVariable(o.uuid()).data();
+  T_World_Baselink.setIdentity();
+  T_World_Baselink.block<3, 3>(0, 0) =
+      Eigen::Quaterniond(o_data[0], o_data[1], o_data[2], o_data[3])
+          .normalized()
+          .toRotationMatrix();
+  T_World_Baselink.block<3, 1>(0, 3) =
+      Eigen::Vector3d(p_data[0], p_data[1], p_data[2]);
+  return true;
+}
+
+bool SplineTrajectory::GetPose(const fuse_core::Graph& graph,
+                               const ros::Time& time,
+                               Eigen::Matrix4d& T_World_Baselink) const {
+  const Segment segment = GetSegment(time);
+  std::array<Eigen::Matrix4d, 4> control_points;
+  for (int j = 0; j < 4; j++) {
+    if (!GetControlPoint(graph, segment.knots[j], control_points[j])) {
+      return false;
+    }
+  }
+  T_World_Baselink = Evaluate(control_points, segment.basis);
+  return true;
+}
+
+std::vector<ros::Time> SplineTrajectory::AddControlPoints(
+    fuse_core::Transaction& transaction, const ros::Time& start,
+    const ros::Time& end, const Eigen::Matrix4d& T_World_Baselink,
+    const fuse_core::Graph* graph) const {
+  const Eigen::Quaterniond q(T_World_Baselink.block<3, 3>(0, 0));
+  std::vector<ros::Time> added;
+  for (const auto& stamp : GetKnots(start, end)) {
+    auto p = bs_variables::PositionControlPoint3DStamped::make_shared(
+        stamp, device_id_);
+    auto o = bs_variables::OrientationControlPoint3DStamped::make_shared(
+        stamp, device_id_);
+    if (graph && graph->variableExists(p->uuid()) &&
+        graph->variableExists(o->uuid())) {
+      continue;
+    }
+    p->x() = T_World_Baselink(0, 3);
+    p->y() = T_World_Baselink(1, 3);
+    p->z() = T_World_Baselink(2, 3);
+    o->w() = q.w();
+    o->x() = q.x();
+    o->y() = q.y();
+    o->z() = q.z();
+    transaction.addInvolvedStamp(stamp);
+    transaction.addVariable(p);
+    transaction.addVariable(o);
+    added.push_back(stamp);
+  }
+  return added;
+}
+
+void SplineTrajectory::AddControlPointPrior(
+    fuse_core::Transaction& transaction, const ros::Time& stamp,
+    const Eigen::Matrix4d& T_World_Baselink, double covariance,
+    const std::string& source) const {
+  const bs_variables::PositionControlPoint3DStamped p(stamp, device_id_);
+  const bs_variables::OrientationControlPoint3DStamped o(stamp, device_id_);
+  const Eigen::Vector3d p_mean = T_World_Baselink.block<3, 1>(0, 3);
+  const Eigen::Quaterniond q(T_World_Baselink.block<3, 3>(0, 0));
+  Eigen::Vector4d o_mean(q.w(), q.x(), q.y(), q.z());
+  transaction.addConstraint(
+      std::make_shared<AbsolutePositionControlPoint3DStampedConstraint>(
+          source, p, p_mean, Eigen::Matrix3d::Identity() * covariance));
+  transaction.addConstraint(
+      std::make_shared<AbsoluteOrientationControlPoint3DStampedConstraint>(
+          source, o, o_mean, Eigen::Matrix4d::Identity() * covariance));
+}
+
+Eigen::Matrix4d SplineTrajectory::Evaluate(
+    const std::array<Eigen::Matrix4d, 4>& control_points,
+    const SplineBasis& basis) {
+  std::array<Eigen::Vector3d, 4> p;
+  std::array<Eigen::Vector4d, 4> q;
+  const double* p_ptrs[4];
+  const double* q_ptrs[4];
+  for (int j = 0; j < 4; j++) {
+    p[j] = control_points[j].block<3, 1>(0, 3);
+    const Eigen::Quaterniond q_j(control_points[j].block<3, 3>(0, 0));
+    q[j] = Eigen::Vector4d(q_j.w(), q_j.x(), q_j.y(), q_j.z());
+    p_ptrs[j] = p[j].data();
+    q_ptrs[j] = q[j].data();
+  }
+
+  Eigen::Vector3d position;
+  Eigen::Quaterniond orientation;
+  EvaluateSplinePosition(p_ptrs, basis, position);
+  EvaluateSplineOrientation(q_ptrs, basis, orientation);
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) = orientation.toRotationMatrix();
+  T.block<3, 1>(0, 3) = position;
+  return T;
+}
+
+} // namespace bs_constraints
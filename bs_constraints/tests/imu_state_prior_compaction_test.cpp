@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <fuse_core/eigen_gtest.h>
+#include <fuse_graphs/hash_graph.h>
+
+#include <bs_common/imu_state.h>
+#include <bs_constraints/inertial/imu_state_3d_stamped_transaction.h>
+#include <bs_constraints/inertial/imu_state_prior_compaction.h>
+
+using namespace bs_constraints;
+
+namespace {
+
+const std::string kSource = "MARGINALIZATION";
+
+bs_common::ImuState GetState(double t) {
+  return bs_common::ImuState(
+      ros::Time(t), Eigen::Quaterniond(0.952, 0.038, -0.189, 0.239),
+      Eigen::Vector3d(1.5, -3.0, 10.0), Eigen::Vector3d(0.5, 0.1, 0.0),
+      Eigen::Vector3d(0.01, -0.02, 0.03), Eigen::Vector3d(0.1, 0.2, 0.3));
+}
+
+AbsoluteImuState3DStampedConstraint::SharedPtr
+    GetPrior(const bs_common::ImuState& state) {
+  return std::make_shared<AbsoluteImuState3DStampedConstraint>(
+      kSource, state, state.GetStateVector(),
+      Eigen::Matrix<double, 15, 15>::Identity() * 0.00001);
+}
+
+size_t CountPriors(const fuse_core::Graph& graph) {
+  size_t count{0};
+  for (const auto& c : graph.getConstraints()) {
+    if (c.source() == kSource) { count++; }
+  }
+  return count;
+}
+
+} // namespace
+
+TEST(ImuStatePriorCompaction, MergeTwoPriors) {
+  bs_common::ImuState state = GetState(1);
+  Eigen::Matrix<double, 16, 1> mean1 = state.GetStateVector();
+  Eigen::Matrix<double, 16, 1> mean2 = mean1;
+  mean2.tail<12>() += Eigen::Matrix<double, 12, 1>::Constant(0.2);
+
+  // rotate the second mean by 0.1 rad about z
+  Eigen::Quaterniond q1(mean1[0], mean1[1], mean1[2], mean1[3]);
+  Eigen::Quaterniond q2 =
+      q1 * Eigen::Quaterniond(Eigen::AngleAxisd(0.1, Eigen::Vector3d::UnitZ()));
+  mean2.head<4>() << q2.w(), q2.x(), q2.y(), q2.z();
+
+  Eigen::Matrix<double, 15, 15> cov = Eigen::Matrix<double, 15, 15>::Identity();
+  AbsoluteImuState3DStampedConstraint prior1("test", state, mean1, cov);
+  AbsoluteImuState3DStampedConstraint prior2("test", state, mean2, cov);
+
+  auto merged = MergeImuStatePriors(kSource, state, {&prior1, &prior2});
+
+  // equal weights give the midpoint and half the covariance
+  Eigen::Quaterniond q_expected =
+      q1 * Eigen::Quaterniond(Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitZ()));
+  Eigen::Vector4d q_merged = merged->mean().head<4>();
+  Eigen::Vector4d q_expected_vec(q_expected.w(), q_expected.x(),
+                                 q_expected.y(), q_expected.z());
+  EXPECT_MATRIX_NEAR(q_expected_vec, q_merged, 1e-9);
+  EXPECT_MATRIX_NEAR(
+      (mean1.tail<12>() + Eigen::Matrix<double, 12, 1>::Constant(0.1)).eval(),
+      merged->mean().tail<12>().eval(), 1e-9);
+  EXPECT_MATRIX_NEAR((0.5 * cov).eval(), merged->covariance(), 1e-9);
+  EXPECT_EQ(merged->source(), kSource);
+  EXPECT_EQ(merged->variables(), prior1.variables());
+}
+
+TEST(ImuStatePriorCompaction, ConstraintCountStaysBounded) {
+  fuse_graphs::HashGraph graph;
+  const int num_states = 10;
+  const int priors_per_state = 20;
+
+  for (int i = 0; i < num_states; i++) {
+    bs_common::ImuState state = GetState(i + 1);
+
+    // add the state and a prior on it, then keep adding priors on the same
+    // state the way pseudo-marginalization does when the window start does not
+    // move
+    ImuState3DStampedTransaction new_transaction(state.Stamp());
+    new_transaction.AddImuStateVariables(state);
+    graph.update(*new_transaction.GetTransaction());
+
+    for (int j = 0; j < priors_per_state; j++) {
+      fuse_core::Transaction transaction;
+      transaction.addConstraint(GetPrior(state));
+      size_t num_priors = CompactImuStatePriors(graph, kSource, transaction);
+      graph.update(transaction);
+      EXPECT_EQ(num_priors, static_cast<size_t>(i + 1));
+      EXPECT_EQ(CountPriors(graph), static_cast<size_t>(i + 1));
+    }
+  }
+
+  // the merged priors have the combined information of all merged priors
+  for (const auto& c : graph.getConstraints()) {
+    const auto prior =
+        dynamic_cast<const AbsoluteImuState3DStampedConstraint*>(&c);
+    ASSERT_TRUE(prior);
+    Eigen::Matrix<double, 15, 15> expected_cov =
+        Eigen::Matrix<double, 15, 15>::Identity() * 0.00001 / priors_per_state;
+    EXPECT_MATRIX_NEAR(expected_cov, prior->covariance(), 1e-12);
+  }
+}
+
+TEST(ImuStatePriorCompaction, IgnoresOtherSources) {
+  fuse_graphs::HashGraph graph;
+  bs_common::ImuState state = GetState(1);
+  ImuState3DStampedTransaction new_transaction(state.Stamp());
+  new_transaction.AddImuStateVariables(state);
+  graph.update(*new_transaction.GetTransaction());
+
+  for (int i = 0; i < 3; i++) {
+    fuse_core::Transaction transaction;
+    transaction.addConstraint(
+        std::make_shared<AbsoluteImuState3DStampedConstraint>(
+            "other", state, state.GetStateVector(),
+            Eigen::Matrix<double, 15, 15>::Identity()));
+    EXPECT_EQ(CompactImuStatePriors(graph, kSource, transaction), 0u);
+    graph.update(transaction);
+  }
+  EXPECT_EQ(CountPriors(graph), 0u);
+  EXPECT_EQ(std::distance(graph.getConstraints().begin(),
+                          graph.getConstraints().end()),
+            3);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <ceres/cost_function.h>
+#include <fuse_graphs/hash_graph.h>
+
+#include <bs_common/utils.h>
+#include <bs_constraints/spline/spline_imu_constraint.h>
+#include <bs_constraints/spline/spline_point_3d_constraint.h>
+#include <bs_constraints/spline/spline_trajectory.h>
+#include <bs_variables/orientation_control_point_3d_stamped.h>
+#include <bs_variables/position_control_point_3d_stamped.h>
+
+using namespace bs_constraints;
+
+namespace {
+
+const double kKnotSpacing{0.1};
+
+// pose of the control point at some knot, for a trajectory that is turning
+// and accelerating
+Eigen::Matrix4d ControlPointPose(const ros::Time& knot) {
+  const double t = knot.toSec() - 10;
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      (Eigen::AngleAxisd(0.8 * t, Eigen::Vector3d::UnitZ()) *
+       Eigen::AngleAxisd(0.3 * t * t, Eigen::Vector3d::UnitX()))
+          .toRotationMatrix();
+  T.block<3, 1>(0, 3) =
+      Eigen::Vector3d(2 * t + 0.5 * t * t, 0.3 * t, 0.1 * t * t);
+  return T;
+}
+
+// adds the control points needed between start and end to the graph
+void AddControlPoints(const SplineTrajectory& spline, const ros::Time& start,
+                      const ros::Time& end, fuse_graphs::HashGraph& graph) {
+  for (const auto& knot : spline.GetKnots(start, end)) {
+    const Eigen::Matrix4d T = ControlPointPose(knot);
+    const Eigen::Quaterniond q(T.block<3, 3>(0, 0));
+    auto p = bs_variables::PositionControlPoint3DStamped::make_shared(knot);
+    p->x() = T(0, 3);
+    p->y() = T(1, 3);
+    p->z() = T(2, 3);
+    auto o = bs_variables::OrientationControlPoint3DStamped::make_shared(knot);
+    o->w() = q.w();
+    o->x() = q.x();
+    o->y() = q.y();
+    o->z() = q.z();
+    if (!graph.variableExists(p->uuid())) { graph.addVariable(p); }
+    if (!graph.variableExists(o->uuid())) { graph.addVariable(o); }
+  }
+}
+
+// copies of the values of the constraint's variables, in order
+std::vector<std::vector<double>> GetParameters(
+    const fuse_core::Graph& graph, const fuse_core::Constraint& constraint) {
+  std::vector<std::vector<double>> parameters;
+  for (const auto& uuid : constraint.variables()) {
+    const fuse_core::Variable& variable = graph.getVariable(uuid);
+    parameters.emplace_back(variable.data(),
+                            variable.data() + variable.size());
+  }
+  return parameters;
+}
+
+Eigen::VectorXd Residual(const ceres::CostFunction& cost_function,
+                         const std::vector<std::vector<double>>& parameters) {
+  std::vector<const double*> ptrs;
+  for (const auto& block : parameters) { ptrs.push_back(block.data()); }
+  Eigen::VectorXd residual(cost_function.num_residuals());
+  EXPECT_TRUE(cost_function.Evaluate(ptrs.data(), residual.data(), nullptr));
+  return residual;
+}
+
+// compares the jacobians of a cost function to central differences
+void CheckJacobians(const ceres::CostFunction& cost_function,
+                    const std::vector<std::vector<double>>& parameters) {
+  const int num_residuals = cost_function.num_residuals();
+  const auto& block_sizes = cost_function.parameter_block_sizes();
+  ASSERT_EQ(block_sizes.size(), parameters.size());
+
+  std::vector<const double*> ptrs;
+  std::vector<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                            Eigen::RowMajor>>
+      jacobians;
+  std::vector<double*> jacobian_ptrs;
+  for (size_t i = 0; i < parameters.size(); i++) {
+    ASSERT_EQ(static_cast<size_t>(block_sizes[i]), parameters[i].size());
+    ptrs.push_back(parameters[i].data());
+    jacobians.emplace_back(num_residuals, block_sizes[i]);
+  }
+  for (auto& J : jacobians) { jacobian_ptrs.push_back(J.data()); }
+  Eigen::VectorXd residual(num_residuals);
+  ASSERT_TRUE(cost_function.Evaluate(ptrs.data(), residual.data(),
+                                     jacobian_ptrs.data()));
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < parameters.size(); i++) {
+    for (int k = 0; k < block_sizes[i]; k++) {
+      std::vector<std::vector<double>> plus = parameters;
+      std::vector<std::vector<double>> minus = parameters;
+      plus[i][k] += h;
+      minus[i][k] -= h;
+      const Eigen::VectorXd numerical =
+          (Residual(cost_function, plus) - Residual(cost_function, minus)) /
+          (2 * h);
+      EXPECT_TRUE(numerical.isApprox(jacobians[i].col(k), 1e-5) ||
+                  (numerical - jacobians[i].col(k)).norm() < 1e-6)
+          << "block " << i << ", column " << k << "\nnumerical: "
+          << numerical.transpose()
+          << "\nanalytical: " << jacobians[i].col(k).transpose();
+    }
+  }
+}
+
+} // namespace
+
+TEST(SplineTrajectory, ControlPointVariables) {
+  const ros::Time knot(10.2);
+  const fuse_core::UUID device_id = fuse_core::uuid::generate("lidar");
+  const bs_variables::PositionControlPoint3DStamped p(knot, device_id);
+  const bs_variables::OrientationControlPoint3DStamped o(knot, device_id);
+  EXPECT_EQ(p.size(), 3u);
+  EXPECT_EQ(p.localSize(), 3u);
+  EXPECT_EQ(o.size(), 4u);
+  EXPECT_EQ(o.localSize(), 3u);
+  std::unique_ptr<fuse_core::LocalParameterization> parameterization(
+      o.localParameterization());
+  ASSERT_TRUE(parameterization);
+  EXPECT_EQ(parameterization->GlobalSize(), 4);
+  EXPECT_EQ(parameterization->LocalSize(), 3);
+
+  // the uuid only depends on the type, stamp and device, so that every model
+  // refers to the same variables
+  EXPECT_NE(p.uuid(), o.uuid());
+  const bs_variables::PositionControlPoint3DStamped same(knot, device_id);
+  EXPECT_EQ(p.uuid(), same.uuid());
+  EXPECT_NE(p.uuid(), bs_variables::PositionControlPoint3DStamped(knot).uuid());
+  EXPECT_NE(p.uuid(), bs_variables::PositionControlPoint3DStamped(
+                          ros::Time(10.3), device_id)
+                          .uuid());
+
+  // segments refer to the variables in the order of the constraints
+  const SplineTrajectory spline(kKnotSpacing, device_id);
+  const auto segment = spline.GetSegment(ros::Time(10.25));
+  EXPECT_EQ(segment.knots[0], ros::Time(10.1));
+  EXPECT_EQ(segment.knots[3], ros::Time(10.4));
+  EXPECT_NEAR(segment.u, 0.5, 1e-9);
+  const auto uuids = spline.SegmentUuids(segment);
+  ASSERT_EQ(uuids.size(), 8u);
+  EXPECT_EQ(uuids[1], p.uuid());
+  EXPECT_EQ(uuids[5], o.uuid());
+}
+
+TEST(SplineTrajectory, AddControlPoints) {
+  const SplineTrajectory spline(kKnotSpacing);
+  fuse_graphs::HashGraph graph;
+  AddControlPoints(spline, ros::Time(10.0), ros::Time(10.1), graph);
+  const auto graph_variables = graph.getVariables();
+  EXPECT_EQ(std::distance(graph_variables.begin(), graph_variables.end()),
+            2 * 5);
+
+  // the pose is evaluated from the control points in the graph
+  Eigen::Matrix4d T_World_Baselink;
+  ASSERT_TRUE(spline.GetPose(graph, ros::Time(10.05), T_World_Baselink));
+  const auto segment = spline.GetSegment(ros::Time(10.05));
+  std::array<Eigen::Matrix4d, 4> control_points;
+  for (int j = 0; j < 4; j++) {
+    control_points[j] = ControlPointPose(segment.knots[j]);
+  }
+  EXPECT_TRUE(T_World_Baselink.isApprox(
+      SplineTrajectory::Evaluate(control_points, segment.basis), 1e-9));
+  EXPECT_FALSE(spline.GetPose(graph, ros::Time(10.25), T_World_Baselink));
+
+  // only the missing control points are added
+  fuse_core::Transaction transaction;
+  const Eigen::Matrix4d T_init = ControlPointPose(ros::Time(10.2));
+  const auto added = spline.AddControlPoints(
+      transaction, ros::Time(10.1), ros::Time(10.35), T_init, &graph);
+  ASSERT_EQ(added.size(), 2u);
+  EXPECT_EQ(added[0], ros::Time(10.4));
+  EXPECT_EQ(added[1], ros::Time(10.5));
+  const auto variables = transaction.addedVariables();
+  EXPECT_EQ(std::distance(variables.begin(), variables.end()), 4);
+  const auto all = spline.AddControlPoints(transaction, ros::Time(10.1),
+                                           ros::Time(10.35), T_init);
+  EXPECT_EQ(all.size(), 6u);
+
+  fuse_core::Transaction prior_transaction;
+  spline.AddControlPointPrior(prior_transaction, added[0], T_init, 1e-6,
+                              "test");
+  const auto constraints = prior_transaction.addedConstraints();
+  EXPECT_EQ(std::distance(constraints.begin(), constraints.end()), 2);
+}
+
+TEST(SplinePoint3DConstraint, ResidualAndJacobians) {
+  const SplineTrajectory spline(kKnotSpacing);
+  fuse_graphs::HashGraph graph;
+  const ros::Time stamp(10.137);
+  AddControlPoints(spline, stamp, stamp, graph);
+
+  Eigen::Matrix4d T_World_Baselink;
+  ASSERT_TRUE(spline.GetPose(graph, stamp, T_World_Baselink));
+  const Eigen::Vector3d p_Baselink(3.0, -1.5, 0.4);
+  const Eigen::Vector3d p_World =
+      T_World_Baselink.block<3, 3>(0, 0) * p_Baselink +
+      T_World_Baselink.block<3, 1>(0, 3);
+  Eigen::Matrix3d A;
+  A << 2, 0.1, 0, 0, 1, 0.3, 0, 0, 0.5;
+
+  const SplinePoint3DConstraint constraint("test", spline, stamp, p_Baselink,
+                                           p_World, A);
+  EXPECT_EQ(constraint.variables(),
+            spline.SegmentUuids(spline.GetSegment(stamp)));
+  const auto parameters = GetParameters(graph, constraint);
+  std::unique_ptr<ceres::CostFunction> cost_function(
+      constraint.costFunction());
+  ASSERT_EQ(cost_function->num_residuals(), 3);
+  EXPECT_LT(Residual(*cost_function, parameters).norm(), 1e-9);
+
+  // the residual is the weighted offset from the mean
+  const Eigen::Vector3d offset(0.05, -0.1, 0.2);
+  const SplinePoint3DConstraint offset_constraint(
+      "test", spline, stamp, p_Baselink, p_World - offset, A);
+  std::unique_ptr<ceres::CostFunction> offset_cost_function(
+      offset_constraint.costFunction());
+  EXPECT_TRUE(Residual(*offset_cost_function, parameters)
+                  .isApprox(A * offset, 1e-9));
+  CheckJacobians(*offset_cost_function, parameters);
+}
+
+TEST(SplineImuConstraint, ResidualAndJacobians) {
+  const SplineTrajectory spline(kKnotSpacing);
+  fuse_graphs::HashGraph graph;
+  const ros::Time stamp(10.262);
+  AddControlPoints(spline, stamp, stamp, graph);
+
+  // biases
+  auto gyro_bias = bs_variables::GyroscopeBias3DStamped::make_shared(stamp);
+  gyro_bias->x() = 0.01;
+  gyro_bias->y() = -0.02;
+  gyro_bias->z() = 0.005;
+  auto accel_bias =
+      bs_variables::AccelerationBias3DStamped::make_shared(stamp);
+  accel_bias->x() = -0.1;
+  accel_bias->y() = 0.05;
+  accel_bias->z() = 0.2;
+  graph.addVariable(gyro_bias);
+  graph.addVariable(accel_bias);
+
+  // measurements of the true motion
+  const auto segment = spline.GetSegment(stamp);
+  const double* p[4];
+  const double* q[4];
+  const auto position_uuids = spline.PositionUuids(segment);
+  const auto orientation_uuids = spline.OrientationUuids(segment);
+  for (int j = 0; j < 4; j++) {
+    p[j] = graph.getVariable(position_uuids[j]).data();
+    q[j] = graph.getVariable(orientation_uuids[j]).data();
+  }
+  Eigen::Vector3d t_World_Baselink, v_World, a_World, w_Baselink;
+  Eigen::Quaterniond q_World_Baselink;
+  EvaluateSplinePosition(p, segment.basis, t_World_Baselink, &v_World,
+                         &a_World);
+  EvaluateSplineOrientation(q, segment.basis, q_World_Baselink, &w_Baselink);
+  const Eigen::Vector3d bg(gyro_bias->data());
+  const Eigen::Vector3d ba(accel_bias->data());
+  const Eigen::Vector3d angular_velocity = w_Baselink + bg;
+  const Eigen::Vector3d linear_acceleration =
+      q_World_Baselink.conjugate() * (a_World - GRAVITY_WORLD) + ba;
+
+  Eigen::Matrix<double, 6, 6> covariance =
+      Eigen::Matrix<double, 6, 6>::Identity() * 1e-2;
+  covariance.block<3, 3>(0, 0) *= 0.1;
+  const SplineImuConstraint constraint("test", spline, stamp,
+                                       angular_velocity, linear_acceleration,
+                                       *gyro_bias, *accel_bias, covariance);
+  std::vector<fuse_core::UUID> expected_uuids = spline.SegmentUuids(segment);
+  expected_uuids.push_back(gyro_bias->uuid());
+  expected_uuids.push_back(accel_bias->uuid());
+  EXPECT_EQ(constraint.variables(), expected_uuids);
+  EXPECT_TRUE(constraint.sqrtInformation().isApprox(
+      Eigen::Matrix<double, 6, 6>(covariance.inverse().llt().matrixU())));
+
+  const auto parameters = GetParameters(graph, constraint);
+  std::unique_ptr<ceres::CostFunction> cost_function(
+      constraint.costFunction());
+  ASSERT_EQ(cost_function->num_residuals(), 6);
+  EXPECT_LT(Residual(*cost_function, parameters).norm(), 1e-6);
+
+  // a biased gyro measurement only shows in the gyro residuals
+  const Eigen::Vector3d gyro_offset(0.01, 0, -0.02);
+  const SplineImuConstraint offset_constraint(
+      "test", spline, stamp, angular_velocity + gyro_offset,
+      linear_acceleration, *gyro_bias, *accel_bias, covariance);
+  std::unique_ptr<ceres::CostFunction> offset_cost_function(
+      offset_constraint.costFunction());
+  Eigen::Matrix<double, 6, 1> error = Eigen::Matrix<double, 6, 1>::Zero();
+  error.head<3>() = -gyro_offset;
+  const Eigen::VectorXd residual =
+      Residual(*offset_cost_function, parameters);
+  EXPECT_TRUE(residual.isApprox(constraint.sqrtInformation() * error, 1e-6));
+  CheckJacobians(*offset_cost_function, parameters);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <array>
+
+#include <bs_constraints/spline/spline_functions.h>
+#include <bs_constraints/spline/spline_imu_cost_functor.h>
+#include <bs_constraints/spline/spline_point_cost_functor.h>
+
+using namespace bs_constraints;
+
+namespace {
+
+const double kKnotSpacing{0.1};
+
+struct ControlPoints {
+  std::array<Eigen::Vector3d, 5> p;
+  std::array<Eigen::Vector4d, 5> q;
+};
+
+// control points of a trajectory that is turning and accelerating
+ControlPoints CreateControlPoints() {
+  ControlPoints cps;
+  for (int i = 0; i < 5; i++) {
+    const double t = kKnotSpacing * i;
+    cps.p[i] = Eigen::Vector3d(2 * t + 0.5 * t * t, 0.3 * t, 0.1 * t * t);
+    const Eigen::Quaterniond q(
+        Eigen::AngleAxisd(0.8 * t, Eigen::Vector3d::UnitZ()) *
+        Eigen::AngleAxisd(0.3 * t * t, Eigen::Vector3d::UnitX()));
+    cps.q[i] = Eigen::Vector4d(q.w(), q.x(), q.y(), q.z());
+  }
+  return cps;
+}
+
+// evaluate the segment starting at control point first
+void Evaluate(const ControlPoints& cps, int first, double u,
+              Eigen::Vector3d& p, Eigen::Quaterniond& q,
+              Eigen::Vector3d* v = nullptr, Eigen::Vector3d* a = nullptr,
+              Eigen::Vector3d* w = nullptr) {
+  const double* p_ptrs[4];
+  const double* q_ptrs[4];
+  for (int j = 0; j < 4; j++) {
+    p_ptrs[j] = cps.p[first + j].data();
+    q_ptrs[j] = cps.q[first + j].data();
+  }
+  const SplineBasis basis(u, kKnotSpacing);
+  EvaluateSplinePosition(p_ptrs, basis, p, v, a);
+  EvaluateSplineOrientation(q_ptrs, basis, q, w);
+}
+
+} // namespace
+
+TEST(SplineFunctions, ExpLog) {
+  const Eigen::Vector3d w(0.3, -0.2, 0.5);
+  const Eigen::Quaterniond q = SplineExp<double>(w);
+  const Eigen::Quaterniond q_expected(
+      Eigen::AngleAxisd(w.norm(), w.normalized()));
+  EXPECT_TRUE(q.isApprox(q_expected, 1e-12));
+  EXPECT_TRUE(SplineLog<double>(q).isApprox(w, 1e-12));
+  const Eigen::Quaterniond q_negated(-q.coeffs());
+  EXPECT_TRUE(SplineLog<double>(q_negated).isApprox(w, 1e-12));
+
+  // near zero rotation
+  const Eigen::Vector3d w_small(1e-8, 0, -2e-8);
+  const Eigen::Vector3d w_small_log =
+      SplineLog<double>(SplineExp<double>(w_small));
+  EXPECT_TRUE(w_small_log.isApprox(w_small, 1e-6));
+}
+
+TEST(SplineFunctions, ConstantControlPoints) {
+  ControlPoints cps = CreateControlPoints();
+  for (int i = 1; i < 5; i++) {
+    cps.p[i] = cps.p[0];
+    cps.q[i] = cps.q[0];
+  }
+  for (double u : {0.0, 0.3, 0.99}) {
+    Eigen::Vector3d p, v, a, w;
+    Eigen::Quaterniond q;
+    Evaluate(cps, 0, u, p, q, &v, &a, &w);
+    EXPECT_TRUE(p.isApprox(cps.p[0]));
+    const Eigen::Quaterniond q0(cps.q[0][0], cps.q[0][1], cps.q[0][2],
+                                cps.q[0][3]);
+    EXPECT_NEAR(std::abs(q.coeffs().dot(q0.coeffs())), 1, 1e-12);
+    EXPECT_LT(v.norm(), 1e-12);
+    EXPECT_LT(a.norm(), 1e-12);
+    EXPECT_LT(w.norm(), 1e-12);
+  }
+}
+
+TEST(SplineFunctions, Continuity) {
+  const ControlPoints cps = CreateControlPoints();
+  Eigen::Vector3d p1, v1, a1, w1, p2, v2, a2, w2;
+  Eigen::Quaterniond q1, q2;
+  Evaluate(cps, 0, 1.0, p1, q1, &v1, &a1, &w1);
+  Evaluate(cps, 1, 0.0, p2, q2, &v2, &a2, &w2);
+  EXPECT_TRUE(p1.isApprox(p2, 1e-9));
+  EXPECT_TRUE(v1.isApprox(v2, 1e-9));
+  EXPECT_TRUE(a1.isApprox(a2, 1e-9));
+  EXPECT_TRUE(w1.isApprox(w2, 1e-9));
+  EXPECT_NEAR(std::abs(q1.coeffs().dot(q2.coeffs())), 1, 1e-12);
+}
+
+TEST(SplineFunctions, Derivatives) {
+  const ControlPoints cps = CreateControlPoints();
+  const double h = 1e-4;
+  for (double u : {0.2, 0.5, 0.8}) {
+    Eigen::Vector3d p, v, a, w;
+    Eigen::Quaterniond q;
+    Evaluate(cps, 0, u, p, q, &v, &a, &w);
+
+    Eigen::Vector3d p_plus, p_minus;
+    Eigen::Quaterniond q_plus, q_minus;
+    Evaluate(cps, 0, u + h / kKnotSpacing, p_plus, q_plus);
+    Evaluate(cps, 0, u - h / kKnotSpacing, p_minus, q_minus);
+
+    const Eigen::Vector3d v_numerical = (p_plus - p_minus) / (2 * h);
+    const Eigen::Vector3d a_numerical = (p_plus - 2 * p + p_minus) / (h * h);
+    const Eigen::Vector3d w_numerical =
+        SplineLog<double>(q_minus.conjugate() * q_plus) / (2 * h);
+    EXPECT_LT((v - v_numerical).norm(), 1e-6);
+    EXPECT_LT((a - a_numerical).norm(), 1e-3);
+    EXPECT_LT((w - w_numerical).norm(), 1e-6);
+  }
+}
+
+TEST(SplineCostFunctors, ZeroResidualAtTruth) {
+  const ControlPoints cps = CreateControlPoints();
+  const double u = 0.4;
+  Eigen::Vector3d p, v, a, w;
+  Eigen::Quaterniond q;
+  Evaluate(cps, 0, u, p, q, &v, &a, &w);
+  const SplineBasis basis(u, kKnotSpacing);
+
+  // lidar point
+  const Eigen::Vector3d p_Baselink(3, -1, 0.5);
+  const Eigen::Vector3d p_World = q * p_Baselink + p;
+  SplinePointCostFunctor point_functor(basis, p_Baselink, p_World,
+                                       Eigen::Matrix3d::Identity() * 10);
+  double point_residual[3];
+  point_functor(cps.p[0].data(), cps.p[1].data(), cps.p[2].data(),
+                cps.p[3].data(), cps.q[0].data(), cps.q[1].data(),
+                cps.q[2].data(), cps.q[3].data(), point_residual);
+  EXPECT_LT(Eigen::Map<Eigen::Vector3d>(point_residual).norm(), 1e-9);
+
+  // imu measurement with biases
+  const Eigen::Vector3d gravity(0, 0, -9.81);
+  const Eigen::Vector3d bg(0.01, -0.02, 0.005);
+  const Eigen::Vector3d ba(0.1, 0.05, -0.2);
+  const Eigen::Vector3d w_measured = w + bg;
+  const Eigen::Vector3d a_measured = q.conjugate() * (a - gravity) + ba;
+  SplineImuCostFunctor imu_functor(basis, w_measured, a_measured, gravity,
+                                   Eigen::Matrix<double, 6, 6>::Identity());
+  double imu_residual[6];
+  imu_functor(cps.p[0].data(), cps.p[1].data(), cps.p[2].data(),
+              cps.p[3].data(), cps.q[0].data(), cps.q[1].data(),
+              cps.q[2].data(), cps.q[3].data(), bg.data(), ba.data(),
+              imu_residual);
+  const Eigen::Map<Eigen::Matrix<double, 6, 1>> r(imu_residual);
+  EXPECT_LT(r.norm(), 1e-9);
+
+  // a wrong measurement time gives a non zero residual
+  SplineImuCostFunctor shifted_functor(SplineBasis(u + 0.2, kKnotSpacing),
+                                       w_measured, a_measured, gravity,
+                                       Eigen::Matrix<double, 6, 6>::Identity());
+  shifted_functor(cps.p[0].data(), cps.p[1].data(), cps.p[2].data(),
+                  cps.p[3].data(), cps.q[0].data(), cps.q[1].data(),
+                  cps.q[2].data(), cps.q[3].data(), bg.data(), ba.data(),
+                  imu_residual);
+  EXPECT_GT(r.norm(), 1e-3);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -76,6 +76,11 @@ public:
 
     bool disable_loop_closure{false};
 
+    /** Full path to config file for removing dynamic points from completed
+     * submaps, see DynamicPointFilter. Optional json key, if blank no points
+     * are removed */
+    std::string dynamic_point_filter_config;
+
     /** Loads config settings from a json file. If config_path empty, it will
      * use default params defined herein.*/
     void LoadJson(const std::string& config_path);
@@ -417,6 +422,8 @@ private:
       loop_closure_candidate_search_;
   std::shared_ptr<reloc::RelocRefinementBase> loop_closure_refinement_;
 
+  DynamicPointFilter dynamic_point_filter_;
+
   // ros maps
   std::queue<std::shared_ptr<RosMap>> ros_submaps_;
   std::queue<std::shared_ptr<RosMap>> ros_new_scans_;
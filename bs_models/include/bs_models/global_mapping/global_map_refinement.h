@@ -33,6 +33,11 @@ namespace bs_models::global_mapping {
  * The batch optimization (4) is a replacement for running 1 to 4 which may work
  * better or worse
  *
+ * Optionally, each step can save a checkpoint of the global map when it
+ * finishes, see EnableCheckpoints. When re-running with checkpoints enabled,
+ * steps whose inputs have not changed are skipped and the refinement resumes
+ * from the last valid checkpoint.
+ *
  */
 class GlobalMapRefinement {
 public:
@@ -135,12 +140,55 @@ public:
    */
   void SaveGlobalMapData(const std::string& output_path);
 
+  /**
+   * @brief save a checkpoint of the global map after each refinement step,
+   * along with a hash of the step inputs: the hash of the previous step (or of
+   * the input map for the first step), the step name and its params, including
+   * the contents of its config files. Steps with a checkpoint for the same
+   * hash are skipped, and the checkpoint is only loaded once a later step
+   * needs to run or results are saved. Must be called before running any
+   * steps.
+   * @param checkpoint_dir directory to save checkpoints to, created if it does
+   * not exist. Should not be cleared between runs
+   * @param input_hash hash identifying the input global map, e.g. from
+   * HashDirectory on the global map data directory
+   */
+  void EnableCheckpoints(const std::string& checkpoint_dir,
+                         uint64_t input_hash);
+
 private:
   void Initialize();
 
+  /**
+   * @brief check for a valid checkpoint of a step when checkpoints are
+   * enabled. Updates the current checkpoint hash with the step inputs
+   * @param step name of the refinement step
+   * @param params_hash hash of the step params
+   * @return true if the step can be skipped
+   */
+  bool SkipStep(const std::string& step, uint64_t params_hash);
+
+  /**
+   * @brief load the checkpoint of the last skipped step into the global map,
+   * if it hasn't been loaded yet
+   */
+  void RestoreCheckpoint();
+
+  /**
+   * @brief save a checkpoint of the global map for the step which just ran
+   */
+  void SaveCheckpoint();
+
   Params params_;
   std::shared_ptr<GlobalMap> global_map_;
   Summary summary_;
+
+  // checkpoints, only used if checkpoint_dir_ is set
+  std::string checkpoint_dir_;
+  uint64_t checkpoint_hash_{0};
+  int num_steps_{0};
+  std::string current_step_dir_;
+  std::string checkpoint_to_restore_;
 };
 
 } // namespace bs_models::global_mapping
\ No newline at end of file
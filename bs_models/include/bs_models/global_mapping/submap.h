@@ -18,6 +18,7 @@
 #include <beam_utils/pointclouds.h>
 #include <bs_common/bs_msgs.h>
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_models/lidar/dynamic_point_filter.h>
 #include <bs_models/lidar/scan_pose.h>
 
 namespace bs_models::global_mapping {
@@ -383,6 +384,15 @@ public:
   beam_matching::LoamPointCloud
       GetLidarLoamPointsInWorldFrame(bool use_initials = false) const;
 
+  /**
+   * @brief remove points on moving objects from the lidar keyframes. Each
+   * keyframe is checked against the keyframes closest to it in time, see
+   * DynamicPointFilter. This should be called once the submap is complete
+   * @param filter dynamic point filter, must be enabled
+   * @return number of points removed
+   */
+  size_t RemoveDynamicPoints(const DynamicPointFilter& filter);
+
   /**
    * @brief return a vector of stamped poses for all keyframes and their
    * attached sub-trajectories. Note that it is possible for a lidar keyframe
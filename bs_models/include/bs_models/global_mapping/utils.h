@@ -49,4 +49,29 @@ void UpdateSubmapPosesFromGraph(std::vector<SubmapPtr> submaps,
                                 std::shared_ptr<fuse_graphs::HashGraph> graph,
                                 bool verbose = false);
 
+/** initial value for the hash functions below */
+constexpr uint64_t kHashSeed{14695981039346656037ULL};
+
+/**
+ * @brief 64 bit FNV-1a hash, used to detect changes to the inputs of the map
+ * refinement stages. This is not a cryptographic hash.
+ * @param data bytes to hash
+ * @param seed hash to continue from, so that several inputs can be chained
+ */
+uint64_t HashBytes(const std::string& data, uint64_t seed = kHashSeed);
+
+/**
+ * @brief hash the contents of a file. If the path is empty or the file does
+ * not exist, the path is hashed instead
+ */
+uint64_t HashFile(const std::string& path, uint64_t seed = kHashSeed);
+
+/**
+ * @brief hash the relative paths and contents of all files in a directory,
+ * recursively and in sorted order so the result doesn't depend on the file
+ * system
+ */
+uint64_t HashDirectory(const std::string& directory,
+                       uint64_t seed = kHashSeed);
+
 } // namespace bs_models::global_mapping
\ No newline at end of file
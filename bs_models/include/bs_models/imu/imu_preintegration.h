@@ -1,11 +1,14 @@
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <queue>
 
 #include <bs_common/bs_msgs.h>
 #include <bs_common/imu_state.h>
 #include <bs_common/preintegrator.h>
+#include <bs_common/spsc_ring_buffer.h>
+#include <bs_common/timed_lock.h>
 #include <bs_constraints/inertial/imu_state_3d_stamped_transaction.h>
 #include <sensor_msgs/Imu.h>
 
@@ -21,6 +24,13 @@ using PoseWithCovariance =
  * quantities. Key frames calculated from IMU preintegration can be adjusted
  * with estimates of pose outside of this class, such as those obtained from VIO
  * or LIO
+ *
+ * IMU data is handed over through a lock free ring buffer, so AddToBuffer
+ * never waits on integration or graph updates. The buffer is drained by the
+ * calls that need the data. After each change the current states are
+ * published as an immutable snapshot, which GetSnapshot and GetImuState read
+ * without locking. The hold times of the internal lock are recorded in a
+ * bs_common::JitterMonitor named "<source> Preintegration Lock".
  */
 class ImuPreintegration {
 public:
@@ -43,6 +53,22 @@ public:
     bool LoadFromJSON(const std::string& path);
   };
 
+  /**
+   * @brief States published after each change
+   */
+  struct Snapshot {
+    /** last registered key frame */
+    bs_common::ImuState imu_state_i;
+
+    /** most recently predicted state, by GetPose, GetRelativeMotion or
+     * RegisterNewImuPreintegratedFactor */
+    bs_common::ImuState latest;
+  };
+
+  /** maximum number of IMU measurements waiting to be integrated before
+   * AddToBuffer has to wait for the lock */
+  static constexpr size_t kBufferCapacity = 2048;
+
   /**
    * @brief Constructor
    * @param params all input params optional. See struct above
@@ -79,7 +105,8 @@ public:
   void AddToBuffer(const sensor_msgs::Imu& msg);
 
   /**
-   * @brief Populate IMU buffer with IMU data
+   * @brief Populate IMU buffer with IMU data. This is lock free unless the
+   * buffer is full, and must not be called by several threads at once
    */
   void AddToBuffer(const bs_common::IMUData& imu_data);
 
@@ -127,10 +154,18 @@ public:
                    const ros::Time& t_now = ros::Time(0));
 
   /**
-   * @brief Gets current IMU state, which is the last registered key frame
+   * @brief Gets current IMU state, which is the last registered key frame.
+   * Does not lock
    * @return ImuState
    */
-  bs_common::ImuState GetImuState() const { return imu_state_i_; }
+  bs_common::ImuState GetImuState() const {
+    return GetSnapshot()->imu_state_i;
+  }
+
+  /**
+   * @brief Gets the last published states. Does not lock
+   */
+  std::shared_ptr<const Snapshot> GetSnapshot() const;
 
   /**
    * @brief Registers new transaction between key frames
@@ -193,6 +228,19 @@ private:
    */
   void SetPreintegrator();
 
+  /**
+   * @brief Moves the IMU data in the ring buffer to the preintegrators. Must
+   * be called with preint_mutex_ locked
+   */
+  void DrainBuffer();
+
+  /**
+   * @brief Publishes the current states. Must be called with preint_mutex_
+   * locked
+   * @param latest most recently predicted state
+   */
+  void PublishSnapshot(const bs_common::ImuState& latest);
+
   Params params_;           // class parameters
   bool first_window_{true}; // flag for first window between key frames
   bool add_prior_on_first_window_{true};
@@ -210,6 +258,13 @@ private:
       window_states_; // state velocities in the window
   double info_weight_{1.0};
   std::mutex preint_mutex_;
+
+  // written by the producer without locking, drained with preint_mutex_
+  bs_common::SpscRingBuffer<bs_common::IMUData> buffer_{kBufferCapacity};
+
+  // read and written with std::atomic_load and std::atomic_store
+  std::shared_ptr<const Snapshot> snapshot_;
+  std::shared_ptr<bs_common::JitterMonitor> lock_hold_;
 };
 
 } // namespace bs_models
@@ -13,6 +13,10 @@
 
 #include <bs_common/bs_msgs.h>
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_common/spsc_ring_buffer.h>
+#include <bs_common/thread_placement.h>
+#include <bs_common/timed_lock.h>
+#include <bs_constraints/spline/spline_trajectory.h>
 #include <bs_models/frame_initializers/frame_initializer.h>
 #include <bs_models/imu/imu_preintegration.h>
 #include <bs_parameters/models/calibration_params.h>
@@ -56,6 +60,12 @@ public:
 
   const std::map<ros::Time, sensor_msgs::Imu::ConstPtr>& GetImuMsgs() const;
 
+  // save the raw IMU data to a binary file in a directory, for snapshots
+  bool Save(const std::string& directory) const;
+
+  // load raw IMU data saved with Save and add it to the raw IMU buffer
+  bool Load(const std::string& directory);
+
 private:
   void CleanOverflow();
 
@@ -85,11 +95,30 @@ public:
 private:
   /**
    * @brief Callback for imu processing, this will make sure the imu messages
-   * are added to the buffer at the correct time
+   * are added to the buffer at the correct time. Messages are queued in
+   * imu_queue_ and processed right away if mutex_ is free, otherwise by the
+   * thread holding it, so the callback never waits on a graph update or
+   * trigger
    * @param[in] msg - The imu msg to process
    */
   void processIMU(const sensor_msgs::Imu::ConstPtr& msg);
 
+  /**
+   * @brief Processes the queued imu messages if mutex_ is free. Call without
+   * holding mutex_
+   */
+  void ProcessImuQueue();
+
+  /**
+   * @brief Processes the queued imu messages. Call while holding mutex_
+   */
+  void DrainImuQueue();
+
+  /**
+   * @brief Processes one imu message. Call while holding mutex_
+   */
+  void ProcessImu(const sensor_msgs::Imu::ConstPtr& msg);
+
   /**
    * @brief Callback for processing a Time message which serves as a trigger to
    * add IMU constraints
@@ -97,6 +126,12 @@ private:
    */
   void processTrigger(const std_msgs::Time::ConstPtr& msg);
 
+  /**
+   * @brief Adds constraints for the buffered triggers that are in the graph.
+   * Call while holding mutex_
+   */
+  void ProcessTriggerBuffer();
+
   /**
    * @brief Perform any required initialization for the sensor model
    *
@@ -146,6 +181,19 @@ private:
   void BreakupConstraint(const ros::Time& new_trigger_time,
                          const ImuConstraintData& constraint_data);
 
+  /**
+   * @brief Continuous-time mode only: add one constraint per IMU measurement
+   * on the spline, for each knot interval that is complete and whose control
+   * points are in the graph. Biases are estimated once per knot interval.
+   */
+  void AddSplineImuConstraints();
+
+  /**
+   * @brief Saves the IMU buffer to the snapshot if a save is due. See
+   * bs_common::SnapshotManager
+   */
+  void SaveSnapshot();
+
   /**
    * @brief Resets to base state
    */
@@ -163,6 +211,10 @@ private:
   // loadable parameters
   bs_parameters::models::InertialOdometryParams params_;
 
+  // placement of the callback threads, and latency of the imu callbacks
+  bs_common::ThreadPlacement thread_placement_;
+  std::shared_ptr<bs_common::JitterMonitor> callback_latency_;
+
   // subscribers
   ros::Subscriber imu_subscriber_;
   ros::Subscriber trigger_subscriber_;
@@ -181,6 +233,15 @@ private:
   bs_models::ImuPreintegration::Params imu_params_;
   std::mutex mutex_;
 
+  // imu messages waiting for mutex_, and how long mutex_ is held
+  bs_common::SpscRingBuffer<sensor_msgs::Imu::ConstPtr> imu_queue_{1024};
+  std::shared_ptr<bs_common::JitterMonitor> lock_hold_;
+
+  // only used if continuous_time_knot_spacing is set. last_spline_knot_ is the
+  // start of the next knot interval to add constraints for
+  std::unique_ptr<bs_constraints::SplineTrajectory> spline_;
+  ros::Time last_spline_knot_{0};
+
   // extrinsics
   bs_common::ExtrinsicsLookupOnline& extrinsics_ =
       bs_common::ExtrinsicsLookupOnline::GetInstance();
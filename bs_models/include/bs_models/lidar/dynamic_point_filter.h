@@ -0,0 +1,164 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <beam_matching/loam/LoamPointCloud.h>
+#include <beam_utils/pointclouds.h>
+
+namespace bs_models {
+
+/**
+ * @brief Removes points on moving objects (vehicles, people) from lidar maps
+ * using free space visibility between scans.
+ *
+ * Each scan is summarized by a VisibilityImage: a coarse spherical image
+ * (azimuth x elevation) in the scan's frame storing the closest return in each
+ * cell. A point is "seen through" by a scan if, projected into that scan's
+ * image, the scan measured a return clearly behind the point along the same
+ * ray, meaning the space the point occupies was free when that scan was taken.
+ * Points that are seen through by enough other scans must have moved, and are
+ * removed:
+ *  - points of a new scan that earlier scans saw through are objects that
+ * moved into view, and are removed before the scan is inserted in the map
+ *  - points already in the map that newer scans see through are objects that
+ * moved away, and are removed from the map
+ *
+ * The checks are conservative: cells without returns are treated as unknown,
+ * each cell stores the minimum range of itself and its horizontal neighbors,
+ * and a point must be in front of the returns of the rows above and below it,
+ * so points near depth discontinuities or on surfaces seen at grazing angles
+ * (e.g. the ground far from the sensor) are not removed.
+ */
+class DynamicPointFilter {
+public:
+  struct Params {
+    /** if false, no points are removed */
+    bool enabled{false};
+
+    /** size of the visibility image cells. The elevation resolution should be
+     * the lidar's ring spacing */
+    float azimuth_resolution_deg{0.5};
+    float elevation_resolution_deg{2.0};
+
+    /** elevation range covered by the visibility image. Rows should be
+     * centered on the rings, the defaults are for a VLP16 and must be changed
+     * for other lidars */
+    float min_elevation_deg{-26};
+    float max_elevation_deg{26};
+
+    /** returns and points outside of this range are ignored */
+    float min_range_m{1.0};
+    float max_range_m{40.0};
+
+    /** a point is seen through if the measured range is larger than the
+     * point's range by more than free_space_margin_m + free_space_margin_ratio
+     * * range */
+    float free_space_margin_m{0.3};
+    float free_space_margin_ratio{0.05};
+
+    /** number of scans that must see through a point for it to be removed */
+    int min_free_observations{2};
+
+    /** max number of other scans (the most recent ones) each point is checked
+     * against */
+    int max_views{5};
+
+    /**
+     * @brief load params from a json config. Throws if the file cannot be read
+     * or is missing a param
+     */
+    void LoadFromJson(const std::string& config);
+  };
+
+  /**
+   * @brief closest return in each azimuth x elevation cell of a scan, in the
+   * scan's frame
+   */
+  class VisibilityImage {
+  public:
+    VisibilityImage(const Params& params);
+
+    /** add a return, expressed in the scan frame */
+    void AddReturn(float x, float y, float z);
+
+    /** apply the horizontal neighbor minimum, must be called after adding all
+     * returns */
+    void Finalize();
+
+    /**
+     * @brief whether a point, expressed in the scan frame, is in free space
+     * according to this image
+     */
+    bool IsFree(float x, float y, float z) const;
+
+  private:
+    /** @return false if outside of the range limits. row is continuous and
+     * may be outside of the image */
+    bool Project(float x, float y, float z, float& range, float& row,
+                 int& col) const;
+
+    Params params_;
+    int rows_;
+    int cols_;
+    std::vector<float> ranges_;
+  };
+
+  struct View {
+    /** transform from the map frame to the frame of the scan */
+    Eigen::Matrix4d T_Scan_Map;
+    std::shared_ptr<const VisibilityImage> image;
+  };
+
+  DynamicPointFilter() = default;
+
+  explicit DynamicPointFilter(const Params& params);
+
+  const Params& GetParams() const { return params_; }
+
+  bool Enabled() const { return params_.enabled; }
+
+  /**
+   * @brief build the visibility image of a scan from its points, expressed in
+   * the scan frame
+   */
+  std::shared_ptr<const VisibilityImage>
+      BuildImage(const PointCloud& cloud) const;
+
+  /**
+   * @brief build the visibility image of a scan from all of its features.
+   * Used when the full scan is not available.
+   */
+  std::shared_ptr<const VisibilityImage>
+      BuildImage(const beam_matching::LoamPointCloud& cloud) const;
+
+  /**
+   * @brief remove points expressed in the map frame that are seen through by
+   * at least min_observations of the views
+   * @return number of points removed
+   */
+  size_t RemoveSeenThrough(PointCloud& cloud, const std::vector<View>& views,
+                           int min_observations) const;
+
+  /**
+   * @brief same as above for all feature clouds of a loam cloud
+   */
+  size_t RemoveSeenThrough(beam_matching::LoamPointCloud& cloud,
+                           const std::vector<View>& views,
+                           int min_observations) const;
+
+private:
+  template <typename PointT>
+  size_t RemoveSeenThroughImpl(pcl::PointCloud<PointT>& cloud,
+                               const std::vector<View>& views,
+                               int min_observations) const;
+
+  template <typename PointT>
+  void AddReturns(VisibilityImage& image,
+                  const pcl::PointCloud<PointT>& cloud) const;
+
+  Params params_;
+};
+
+} // namespace bs_models
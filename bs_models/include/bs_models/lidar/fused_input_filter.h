@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/pointclouds.h>
+
+namespace bs_models {
+
+/**
+ * @brief Applies a chain of input filters to a lidar scan in a single pass
+ * over the points, writing into a caller owned output cloud whose memory is
+ * reused between scans.
+ *
+ * The filters are read from the same json format as
+ * beam_filtering::LoadFilterParamsVector, and the result is the same as
+ * applying them one after the other with beam_filtering::FilterPointCloud.
+ * Supported filter types:
+ *
+ *  - CROPBOX: {"min": [x, y, z], "max": [x, y, z], "remove_outside_points":
+ * bool}. Bounds are inclusive.
+ *  - VOXEL: {"cell_size": [x, y, z]}. Points are replaced with the centroid of
+ * each occupied voxel, ordered by voxel index. Only one voxel filter is
+ * supported.
+ *  - RANGE: {"min_range": m, "max_range": m}. Removes points outside the range
+ * interval, measured from the sensor origin.
+ *  - RING_DECIMATION: {"ring_step": n}. Only keeps every n-th ring. This has no
+ * effect on clouds without ring information.
+ *
+ * RANGE and RING_DECIMATION are not supported by beam_filtering, so configs
+ * using them can only be applied with this class.
+ *
+ * Point filters before the voxel filter are evaluated while reading each
+ * input point, and those after the voxel filter are evaluated on each
+ * centroid, so the order of the filters in the config is respected.
+ *
+ * The output only contains finite points and is unorganized (height 1), unless
+ * no filters were loaded, in which case it is a copy of the input.
+ */
+class FusedInputFilter {
+public:
+  FusedInputFilter() = default;
+
+  /**
+   * @brief load filters from the "filters" array of an input filters config
+   * @param J_filters json array of filters
+   * @return false if any of the filters cannot be fused (unknown type, or more
+   * than one voxel filter), in which case the chained filters should be used
+   * instead. Throws if a supported filter is missing a key.
+   */
+  bool LoadFromJson(const nlohmann::json& J_filters);
+
+  /** true if no filters were loaded */
+  bool Empty() const;
+
+  void Filter(const PointCloud& input, PointCloud& output);
+
+  void Filter(const pcl::PointCloud<PointXYZIRT>& input,
+              pcl::PointCloud<PointXYZIRT>& output);
+
+  void Filter(const pcl::PointCloud<PointXYZITRRNR>& input,
+              pcl::PointCloud<PointXYZITRRNR>& output);
+
+  /**
+   * @brief apply the point filters while keeping the layout of the input, for
+   * organized feature extraction. Removed points are set to NaN instead of
+   * being erased, and the voxel filter is not applied. With no filters, the
+   * output is a copy of the input.
+   */
+  void FilterOrganized(const pcl::PointCloud<PointXYZIRT>& input,
+                       pcl::PointCloud<PointXYZIRT>& output);
+
+  void FilterOrganized(const pcl::PointCloud<PointXYZITRRNR>& input,
+                       pcl::PointCloud<PointXYZITRRNR>& output);
+
+private:
+  struct PointFilter {
+    enum class Type { CROPBOX, RANGE, RING_DECIMATION };
+    Type type;
+    float min[3];
+    float max[3];
+    bool remove_outside_points{true};
+    int ring_step{1};
+
+    /** @return true if the point should be kept */
+    bool Keep(float x, float y, float z, int ring) const;
+  };
+
+  template <typename PointT>
+  void FilterImpl(const pcl::PointCloud<PointT>& input,
+                  pcl::PointCloud<PointT>& output);
+
+  template <typename PointT>
+  void FilterOrganizedImpl(const pcl::PointCloud<PointT>& input,
+                           pcl::PointCloud<PointT>& output);
+
+  static bool Keep(const std::vector<PointFilter>& filters, float x, float y,
+                   float z, int ring);
+
+  std::vector<PointFilter> pre_voxel_;
+  std::vector<PointFilter> post_voxel_;
+  bool use_voxel_{false};
+  float inverse_cell_size_[3]{1, 1, 1};
+
+  /** (voxel key, point index) of each point that passed the filters before
+   * the voxel filter, reused between scans */
+  std::vector<std::pair<uint64_t, uint32_t>> voxel_keys_;
+};
+
+} // namespace bs_models
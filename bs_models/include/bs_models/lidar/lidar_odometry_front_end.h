@@ -0,0 +1,235 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <fuse_core/transaction.h>
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <beam_filtering/Utils.h>
+#include <beam_matching/Matchers.h>
+#include <beam_utils/pointclouds.h>
+#include <beam_utils/time.h>
+
+#include <bs_models/lidar/fused_input_filter.h>
+#include <bs_models/lidar/organized_loam_extractor.h>
+#include <bs_models/lidar/scan_pose.h>
+#include <bs_models/lidar/scan_redeskewer.h>
+#include <bs_models/scan_registration/registration_profile_tuner.h>
+#include <bs_models/scan_registration/scan_registration_base.h>
+
+namespace bs_models {
+
+/**
+ * @brief Per scan pipeline of LidarOdometry: conversion from the ROS message,
+ * input filtering, deskewing, ScanPose construction (including feature
+ * extraction) and registration against the registration map. It also owns the
+ * optional registration profile tuner, and re-deskews the scans once the
+ * trajectory is refined.
+ *
+ * Initial poses, the transactions sent to the graph and all outputs are left
+ * to the caller, so that this can also be run without ROS by
+ * bs_tools::LidarOdometryBenchmark.
+ *
+ * Registration uses the RegistrationMap singleton, and the dynamic point
+ * filter is set on it on construction.
+ *
+ * ProcessScan and RedeskewScans may be called from different threads, e.g. the
+ * scan and graph update callbacks of LidarOdometry. They share the scratch
+ * clouds, the feature extractors and the profile tuner, and are serialized by
+ * an internal mutex. FindRawScan and RemoveRawScan are thread safe, and the
+ * registration map is synchronized by RegistrationMap. SetStageCallback must
+ * be called before the first scan.
+ */
+class LidarOdometryFrontEnd {
+public:
+  struct Params {
+    /** full paths to the registration and matcher configs */
+    std::string registration_config;
+    std::string matcher_config;
+
+    /** directory registration results are saved to, can be empty */
+    std::string registration_results_path;
+
+    /** full path to input filters config, with a "filters" array. If empty,
+     * or if it cannot be read, no filters are used */
+    std::string input_filters_config;
+
+    /** full path to registration profile tuning config, can be empty. The
+     * tuner is not used if it is disabled in the config */
+    std::string registration_tuning_config;
+
+    /** full path to the dynamic point filter config of the registration map,
+     * can be empty */
+    std::string dynamic_point_filter_config;
+
+    LidarType lidar_type{LidarType::VELODYNE};
+    bool organized_feature_extraction{false};
+    int range_image_columns{1800};
+    double lidar_information_weight{1};
+
+    /** keep the raw scans to deskew them again with the refined trajectory */
+    bool redeskew_scans{false};
+    ScanRedeskewer::Params redeskewer;
+  };
+
+  /** stages of ProcessScan, in the order they run */
+  static const std::vector<std::string> kStages;
+
+  /** called with the latency of each stage of a scan */
+  using StageCallback =
+      std::function<void(const std::string& stage, double latency_ms)>;
+
+  struct Result {
+    std::shared_ptr<ScanPose> scan_pose;
+
+    /** registration transaction, nullptr if the scan could not be registered
+     * or did not move enough */
+    fuse_core::Transaction::SharedPtr transaction;
+
+    /** pose of the scan in the registration map */
+    Eigen::Matrix4d T_World_Lidar{Eigen::Matrix4d::Identity()};
+  };
+
+  explicit LidarOdometryFrontEnd(const Params& params);
+
+  /**
+   * @brief run a scan through the pipeline
+   * @param msg raw scan
+   * @param T_World_BaselinkInit initial pose estimate
+   * @param T_Baselink_Lidar lidar extrinsics
+   * @param get_T_World_Lidar lidar poses used to deskew the scan on arrival,
+   * only used if scans are re-deskewed. It may fail, in which case the scan
+   * is deskewed on a later call to RedeskewScans
+   */
+  Result ProcessScan(const sensor_msgs::PointCloud2& msg,
+                     const Eigen::Matrix4d& T_World_BaselinkInit,
+                     const Eigen::Matrix4d& T_Baselink_Lidar,
+                     const ScanRedeskewer::PoseLookup& get_T_World_Lidar);
+
+  /**
+   * @brief re-deskew the raw scans with a refined trajectory, and replace the
+   * clouds of the matching scans and their clouds in the registration map. Raw
+   * scans older than the start of the trajectory are dropped
+   * @param trajectory lidar trajectory over the window
+   * @param scans active scans, sorted by stamp
+   * @return scans whose clouds were replaced
+   */
+  std::vector<std::shared_ptr<ScanPose>>
+      RedeskewScans(const LidarTrajectory& trajectory,
+                    const std::list<std::shared_ptr<ScanPose>>& scans);
+
+  /**
+   * @brief get the raw scan kept for re-deskewing
+   * @return nullptr if scans are not re-deskewed or the scan is not kept
+   */
+  std::shared_ptr<const pcl::PointCloud<PointXYZIRT>>
+      FindRawScan(const ros::Time& stamp) const;
+
+  /**
+   * @brief drop the raw scan kept for re-deskewing, e.g. once the scan left
+   * the window
+   */
+  void RemoveRawScan(const ros::Time& stamp);
+
+  bool RedeskewsScans() const { return redeskewer_ != nullptr; }
+
+  scan_registration::ScanRegistrationBase& Registration() {
+    return *scan_registration_;
+  }
+
+  /**
+   * @brief time each stage of ProcessScan, see kStages
+   */
+  void SetStageCallback(const StageCallback& callback) {
+    stage_callback_ = callback;
+  }
+
+private:
+  void LoadInputFilters(const std::string& config);
+
+  /**
+   * @brief apply the current profile of the registration profile tuner to the
+   * feature extractor, the matcher and the registration map
+   */
+  void ApplyRegistrationProfile();
+
+  template <typename Function>
+  void TimeStage(const std::string& stage, Function&& function);
+
+  template <typename PointT>
+  void Filter(const pcl::PointCloud<PointT>& cloud,
+              pcl::PointCloud<PointT>& filtered);
+
+  /**
+   * @brief build the scan pose of a filtered (and deskewed) scan, and add the
+   * organized features if used
+   * @param raw raw scan, only used for organized features
+   * @param organized buffer for organized features, reused between scans
+   */
+  template <typename RawPointT, typename PointT>
+  std::shared_ptr<ScanPose>
+      CreateScanPose(const pcl::PointCloud<RawPointT>& raw,
+                     const pcl::PointCloud<PointT>& cloud,
+                     const ros::Time& stamp,
+                     const Eigen::Matrix4d& T_World_BaselinkInit,
+                     const Eigen::Matrix4d& T_Baselink_Lidar,
+                     const ScanRedeskewer::PoseLookup& get_T_World_Lidar,
+                     pcl::PointCloud<RawPointT>& organized);
+
+  /**
+   * @brief extract organized features from a raw scan, filtered with the
+   * fused input filter so that it keeps its layout, and deskewed if scans are
+   * re-deskewed. Only valid if fused_input_filter_ is set: the chained filters
+   * do not keep the layout, so the filtered cloud is used directly instead
+   * @param organized buffer for the filtered scan, reused between scans
+   */
+  template <typename PointT>
+  beam_matching::LoamPointCloud ExtractOrganizedFeatures(
+      const pcl::PointCloud<PointT>& cloud, const ros::Time& stamp,
+      const ScanRedeskewer::PoseLookup& get_T_World_Lidar,
+      pcl::PointCloud<PointT>& organized);
+
+  Params params_;
+  StageCallback stage_callback_;
+
+  /** serializes ProcessScan and RedeskewScans */
+  std::mutex mutex_;
+
+  std::unique_ptr<scan_registration::ScanRegistrationBase> scan_registration_;
+
+  /** Only needed if using LoamMatcher. The params are shared with the feature
+   * extractor so that the registration profile can be updated at runtime */
+  std::shared_ptr<beam_matching::LoamParams> matcher_params_;
+  std::shared_ptr<beam_matching::LoamFeatureExtractor> feature_extractor_;
+
+  /** Only used if organized_feature_extraction is set, replaces the feature
+   * extractor above */
+  std::unique_ptr<OrganizedLoamFeatureExtractor> organized_extractor_;
+
+  /** Only used if registration_tuning_config is set and enabled */
+  std::unique_ptr<scan_registration::RegistrationProfileTuner> profile_tuner_;
+
+  /** Only used if redeskew_scans is set */
+  std::unique_ptr<ScanRedeskewer> redeskewer_;
+
+  std::vector<beam_filtering::FilterParamsType> input_filter_params_;
+
+  /** Used instead of input_filter_params_ if all input filters can be fused.
+   * Filtered clouds are written into the buffers below, which are reused */
+  std::unique_ptr<FusedInputFilter> fused_input_filter_;
+  pcl::PointCloud<PointXYZIRT> velodyne_filtered_;
+  pcl::PointCloud<PointXYZITRRNR> ouster_filtered_;
+  pcl::PointCloud<PointXYZIRT> velodyne_organized_;
+  pcl::PointCloud<PointXYZITRRNR> ouster_organized_;
+
+  beam::HighResolutionTimer scan_timer_;
+};
+
+} // namespace bs_models
@@ -11,6 +11,7 @@
 #include <beam_utils/pointclouds.h>
 
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_models/lidar/fused_input_filter.h>
 #include <bs_models/lidar/scan_pose.h>
 #include <bs_models/scan_registration/scan_to_map_registration.h>
 
@@ -104,6 +105,10 @@ private:
   std::shared_ptr<beam_matching::LoamFeatureExtractor> feature_extractor_;
   std::vector<beam_filtering::FilterParamsType> input_filter_params_;
 
+  /** used instead of input_filter_params_ if all input filters can be fused */
+  std::unique_ptr<FusedInputFilter> fused_input_filter_;
+  PointCloud cloud_filtered_;
+
   // store all current keyframes to be processed. Data in scan poses have
   // already been converted to the baselink frame, and T_BASELINK_LIDAR is set
   // to identity
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <beam_matching/loam/LoamParams.h>
+#include <beam_matching/loam/LoamPointCloud.h>
+#include <beam_utils/pointclouds.h>
+
+#include <bs_models/lidar/range_image.h>
+
+namespace bs_models {
+
+/**
+ * @brief LOAM feature extractor that works on an organized range image
+ * instead of sorting each ring by azimuth.
+ *
+ * For each ring, the valid cells are compacted into contiguous arrays and the
+ * curvature of each point is computed from its curvature_region neighbors on
+ * either side. Neighbors are only used if they are adjacent in the image (no
+ * column gap larger than max_column_gap), so holes from missing returns do not
+ * create false edges. Occlusion and parallel beam checks compare the ranges of
+ * column adjacent points:
+ *  - occlusion: if the range jumps by more than occlusion_threshold_m between
+ * two adjacent columns, the points on the far side are not selected since
+ * they may be hidden when the sensor moves
+ *  - parallel beam: if the range jumps by more than parallel_beam_ratio of the
+ * point's range on both sides, the point is on a surface nearly parallel to the
+ * beam and is not selected
+ *
+ * Features are then selected in each of n_feature_regions sectors per ring,
+ * using the same limits as beam_matching::LoamFeatureExtractor
+ * (max_corner_sharp, max_corner_less_sharp, max_surface_flat,
+ * surface_curvature_threshold), so the two can be used interchangeably.
+ *
+ * The LoamParams are shared, so changes made to them at runtime (e.g. by the
+ * registration profile tuner) apply to the next call to ExtractFeatures. All
+ * buffers are reused between calls, so one extractor should be kept per
+ * sensor and it is not thread safe.
+ */
+class OrganizedLoamFeatureExtractor {
+public:
+  struct Params {
+    /** range jump between adjacent columns above which the far side is
+     * considered occluded */
+    float occlusion_threshold_m{0.3};
+
+    /** relative range jump on both sides above which a point is considered
+     * to be on a surface parallel to the beam */
+    float parallel_beam_ratio{0.02};
+
+    /** max number of columns between two valid points for them to be
+     * considered neighbors */
+    int max_column_gap{2};
+  };
+
+  /**
+   * @brief constructor
+   * @param loam_params loam params, shared with the matcher
+   * @param num_columns number of range image columns used when the input cloud
+   * is not organized
+   * @param params extraction params
+   */
+  OrganizedLoamFeatureExtractor(
+      const std::shared_ptr<beam_matching::LoamParams>& loam_params,
+      int num_columns, const Params& params);
+
+  /**
+   * @brief constructor with default extraction params
+   */
+  OrganizedLoamFeatureExtractor(
+      const std::shared_ptr<beam_matching::LoamParams>& loam_params,
+      int num_columns);
+
+  /**
+   * @brief extract features from a velodyne cloud
+   */
+  beam_matching::LoamPointCloud
+      ExtractFeatures(const pcl::PointCloud<PointXYZIRT>& cloud);
+
+  /**
+   * @brief extract features from an ouster cloud
+   */
+  beam_matching::LoamPointCloud
+      ExtractFeatures(const pcl::PointCloud<PointXYZITRRNR>& cloud);
+
+  /**
+   * @brief extract features from a range image that has already been built
+   */
+  beam_matching::LoamPointCloud ExtractFeatures(const RangeImage& image);
+
+  /**
+   * @brief range image built in the last call to ExtractFeatures with a cloud
+   */
+  const RangeImage& GetRangeImage() const { return image_; }
+
+  /**
+   * @brief curvature of each point of a ring, in column order, as computed in
+   * the last call to ExtractFeatures. Points without enough neighbors have a
+   * negative curvature. Only the last ring is kept, this is for testing.
+   */
+  const std::vector<float>& GetCurvature() const { return curvature_; }
+
+private:
+  enum class Label : uint8_t { NONE, EDGE, SURFACE };
+
+  void ExtractRing(const RangeImage& image, int ring,
+                   beam_matching::LoamPointCloud& features,
+                   pcl::PointCloud<PointXYZIRT>& weak_surfaces);
+
+  /** load the valid points of a ring into the contiguous scratch buffers */
+  void CompactRing(const RangeImage& image, int ring);
+
+  void ComputeCurvature(int region);
+
+  void MarkUnreliable(int region);
+
+  /** prevent the neighbors of a selected point from being selected */
+  void Suppress(int k, int region);
+
+  PointXYZIRT ToPoint(const RangeImage& image, int ring, int k) const;
+
+  std::shared_ptr<beam_matching::LoamParams> loam_params_;
+  Params params_;
+  RangeImage image_;
+
+  // per ring scratch buffers, reused
+  std::vector<int> columns_;
+  std::vector<int> segments_;
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<float> range_;
+  std::vector<float> curvature_;
+  std::vector<uint8_t> picked_;
+  std::vector<Label> labels_;
+  std::vector<int> sorted_;
+};
+
+} // namespace bs_models
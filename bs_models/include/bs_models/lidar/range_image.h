@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <beam_utils/pointclouds.h>
+
+namespace bs_models {
+
+/**
+ * @brief Organized view of a lidar scan, indexed by ring (row) and column.
+ * Each row is stored contiguously as separate x, y, z, range, intensity and
+ * time arrays so that per ring operations (e.g. curvature) walk linear memory.
+ *
+ * If the input cloud is already organized (height equal to the number of
+ * rings) the column is the point's index in its row, which is the case for
+ * ouster clouds straight from the driver. Otherwise the column is computed
+ * from the point's azimuth, and the ring from its ring field. When two points
+ * fall in the same cell, the closer one is kept.
+ *
+ * Buffers are reused between calls to Build, so one RangeImage should be kept
+ * per sensor.
+ */
+class RangeImage {
+public:
+  /**
+   * @brief constructor
+   * @param num_rings number of lidar rings (rows)
+   * @param num_columns number of columns used when the input cloud is not
+   * organized
+   */
+  RangeImage(int num_rings, int num_columns);
+
+  /**
+   * @brief fill the image from a velodyne cloud
+   */
+  void Build(const pcl::PointCloud<PointXYZIRT>& cloud);
+
+  /**
+   * @brief fill the image from an ouster cloud
+   */
+  void Build(const pcl::PointCloud<PointXYZITRRNR>& cloud);
+
+  int Rings() const { return num_rings_; }
+
+  int Columns() const { return num_columns_; }
+
+  /** number of valid cells */
+  size_t NumPoints() const { return num_points_; }
+
+  /** number of input points that were dropped, either because their ring was
+   * out of bounds or because the cell was taken by a closer point */
+  size_t NumDropped() const { return num_dropped_; }
+
+  size_t Index(int ring, int column) const {
+    return static_cast<size_t>(ring) * num_columns_ + column;
+  }
+
+  /** a cell is valid if it has a return */
+  bool Valid(int ring, int column) const {
+    return range_[Index(ring, column)] > 0;
+  }
+
+  /** pointers to the start of each row */
+  const float* X(int ring) const { return &x_[Index(ring, 0)]; }
+  const float* Y(int ring) const { return &y_[Index(ring, 0)]; }
+  const float* Z(int ring) const { return &z_[Index(ring, 0)]; }
+  const float* Range(int ring) const { return &range_[Index(ring, 0)]; }
+  const float* Intensity(int ring) const {
+    return &intensity_[Index(ring, 0)];
+  }
+  const float* Time(int ring) const { return &time_[Index(ring, 0)]; }
+
+  /**
+   * @brief convert the valid cells back to a cloud, ordered by ring then
+   * column
+   */
+  pcl::PointCloud<PointXYZIRT> ToCloud() const;
+
+private:
+  template <typename PointT>
+  void BuildImpl(const pcl::PointCloud<PointT>& cloud);
+
+  void Resize(int num_columns);
+
+  void Insert(int ring, int column, float x, float y, float z,
+              float intensity, float time);
+
+  int num_rings_;
+  int num_columns_;
+  int default_num_columns_;
+  size_t num_points_{0};
+  size_t num_dropped_{0};
+
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<float> range_;
+  std::vector<float> intensity_;
+  std::vector<float> time_;
+};
+
+} // namespace bs_models
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <ros/time.h>
+
+#include <beam_utils/pointclouds.h>
+
+namespace bs_models {
+
+/**
+ * @brief Poses of the lidar over a time window. Poses between two stamped
+ * poses are interpolated, and poses outside of the window are extrapolated
+ * with the velocity of the closest two poses, up to max_extrapolation_s.
+ */
+class LidarTrajectory {
+public:
+  explicit LidarTrajectory(double max_extrapolation_s = 0.2);
+
+  void AddPose(const ros::Time& stamp, const Eigen::Matrix4d& T_World_Lidar);
+
+  /**
+   * @brief get the pose of the lidar at some time
+   * @return false if the time is too far outside of the trajectory, or the
+   * trajectory has less than two poses
+   */
+  bool GetPose(const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) const;
+
+  bool Empty() const { return poses_.empty(); }
+
+  /** stamp of the first pose, the trajectory must not be empty */
+  ros::Time Start() const;
+
+private:
+  double max_extrapolation_s_;
+  std::map<uint64_t, Eigen::Matrix4d> poses_;
+};
+
+/**
+ * @brief Keeps the raw (skewed) scans that are still in the lag window, and
+ * re-deskews them once the smoother has refined the trajectory.
+ *
+ * Scans are first deskewed with whatever trajectory is available when they
+ * are received (e.g. from a FrameInitializer). Each time the trajectory is
+ * refined, scans for which the refined motion over the scan differs from the
+ * motion they were deskewed with are re-projected, so that aggressive motion
+ * does not stay smeared in the map once it is better estimated. Scans that
+ * leave the window are dropped.
+ *
+ * Points must have a time field, relative to the scan stamp. Deskewed points
+ * are expressed in the lidar frame at the scan stamp.
+ *
+ * Thread safe: scans are usually added from the scan callback while Update
+ * runs on graph updates. Scans are only deskewed outside of the lock.
+ */
+class ScanRedeskewer {
+public:
+  struct Params {
+    /** scans are only re-deskewed if the motion over the scan changed by more
+     * than one of these */
+    double rotation_threshold_deg{0.1};
+    double translation_threshold_m{0.01};
+
+    /** max number of scans re-deskewed by each Update, the scans whose motion
+     * changed the most are re-deskewed first and the others on later
+     * updates. Set to 0 for no limit */
+    int max_scans_per_update{0};
+  };
+
+  /** returns T_World_Lidar at the requested time, or false if unknown */
+  using PoseLookup = std::function<bool(const ros::Time&, Eigen::Matrix4d&)>;
+
+  struct DeskewedScan {
+    ros::Time stamp;
+    pcl::PointCloud<PointXYZIRT> cloud;
+  };
+
+  /**
+   * @brief deskew a scan into the lidar frame at the scan stamp
+   * @param cloud raw scan
+   * @param stamp scan stamp, point times are relative to this
+   * @param get_T_World_Lidar pose lookup
+   * @param deskewed output, same size and order as the input
+   * @return false if any pose lookup failed, in which case deskewed is not
+   * valid
+   */
+  template <typename PointT>
+  static bool Deskew(const pcl::PointCloud<PointT>& cloud,
+                     const ros::Time& stamp,
+                     const PoseLookup& get_T_World_Lidar,
+                     pcl::PointCloud<PointT>& deskewed);
+
+  /**
+   * @brief convert an ouster scan to the point type stored here, keeping the
+   * cloud organization
+   */
+  static pcl::PointCloud<PointXYZIRT>
+      ToPointXYZIRT(const pcl::PointCloud<PointXYZITRRNR>& cloud);
+
+  ScanRedeskewer() = default;
+
+  explicit ScanRedeskewer(const Params& params);
+
+  /**
+   * @brief store a new raw scan and deskew it with the current trajectory
+   * estimate
+   * @return deskewed scan, or the raw scan if the trajectory was not available,
+   * in which case it will be deskewed on the next Update
+   */
+  pcl::PointCloud<PointXYZIRT>
+      AddScan(const ros::Time& stamp, const pcl::PointCloud<PointXYZIRT>& cloud,
+              const PoseLookup& get_T_World_Lidar);
+
+  /**
+   * @brief remove a scan, e.g. if it could not be registered
+   */
+  void RemoveScan(const ros::Time& stamp);
+
+  /**
+   * @brief re-deskew the stored scans with a refined trajectory, up to
+   * max_scans_per_update. Scans older than the start of the trajectory have
+   * left the window and are dropped
+   * @return scans that were re-deskewed, sorted by stamp
+   */
+  std::vector<DeskewedScan> Update(const LidarTrajectory& trajectory);
+
+  /**
+   * @brief get a stored raw scan. The cloud is never modified, and stays valid
+   * after the scan is removed
+   * @return nullptr if the scan is not stored
+   */
+  std::shared_ptr<const pcl::PointCloud<PointXYZIRT>>
+      FindRawScan(const ros::Time& stamp) const;
+
+  size_t NumScans() const;
+
+private:
+  struct RawScan {
+    std::shared_ptr<const pcl::PointCloud<PointXYZIRT>> cloud;
+    double duration_s{0};
+
+    /** motion over the scan used for the current deskewed cloud. Only valid if
+     * deskewed is true */
+    bool deskewed{false};
+    Eigen::Matrix4d T_Lidar0_LidarEnd{Eigen::Matrix4d::Identity()};
+  };
+
+  /** motion between the scan stamp and the time of its last point */
+  static bool GetScanMotion(const ros::Time& stamp, double duration_s,
+                            const PoseLookup& get_T_World_Lidar,
+                            Eigen::Matrix4d& T_Lidar0_LidarEnd);
+
+  Params params_;
+  mutable std::mutex mutex_;
+  std::map<uint64_t, RawScan> scans_;
+};
+
+template <typename PointT>
+bool ScanRedeskewer::Deskew(const pcl::PointCloud<PointT>& cloud,
+                            const ros::Time& stamp,
+                            const PoseLookup& get_T_World_Lidar,
+                            pcl::PointCloud<PointT>& deskewed) {
+  Eigen::Matrix4d T_World_Lidar0;
+  if (!get_T_World_Lidar(stamp, T_World_Lidar0)) { return false; }
+  const Eigen::Matrix4d T_Lidar0_World = T_World_Lidar0.inverse();
+
+  deskewed = cloud;
+  // points are usually sorted by time or ring then time, so consecutive points
+  // often share the same pose
+  float last_time = std::numeric_limits<float>::quiet_NaN();
+  Eigen::Matrix4f T_Lidar0_LidarN = Eigen::Matrix4f::Identity();
+  for (auto& p : deskewed) {
+    if (p.time != last_time) {
+      Eigen::Matrix4d T_World_LidarN;
+      if (!get_T_World_Lidar(stamp + ros::Duration(p.time), T_World_LidarN)) {
+        return false;
+      }
+      T_Lidar0_LidarN = (T_Lidar0_World * T_World_LidarN).cast<float>();
+      last_time = p.time;
+    }
+    const Eigen::Vector3f p_Lidar0 =
+        T_Lidar0_LidarN.block<3, 3>(0, 0) * Eigen::Vector3f(p.x, p.y, p.z) +
+        T_Lidar0_LidarN.block<3, 1>(0, 3);
+    p.x = p_Lidar0[0];
+    p.y = p_Lidar0[1];
+    p.z = p_Lidar0[2];
+  }
+  return true;
+}
+
+} // namespace bs_models
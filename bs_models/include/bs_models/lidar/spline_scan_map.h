@@ -0,0 +1,107 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <Eigen/Dense>
+#include <fuse_core/graph.h>
+#include <fuse_core/transaction.h>
+#include <ros/time.h>
+
+#include <beam_utils/pointclouds.h>
+
+#include <bs_constraints/spline/spline_trajectory.h>
+#include <bs_models/lidar/scan_pose.h>
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+
+namespace bs_models {
+
+/**
+ * @brief Map of the lidar scans in the window, used to constrain a
+ * continuous-time trajectory with the raw points of new scans.
+ *
+ * Each new scan adds the control points of the spline over the scan, and one
+ * SplinePoint3DConstraint per sampled raw point, at the exact time the point
+ * was measured, against the point distributions of the map. The scan is then
+ * inserted in the map. Scans are moved as the trajectory is refined, and
+ * removed once they leave the window.
+ *
+ * Thread safe, except for Map: scans are added from the scan callback while
+ * graph updates move and remove them.
+ */
+class SplineScanMap {
+public:
+  struct Params {
+    /** voxel size of the point distributions */
+    double voxel_size{1.0};
+
+    /** max number of raw points per scan that are added as constraints */
+    int points_per_scan{500};
+
+    /** weight applied to the information of each point constraint */
+    double information_weight{1.0};
+  };
+
+  SplineScanMap() = default;
+
+  explicit SplineScanMap(const Params& params);
+
+  /**
+   * @brief build the transaction for a new scan and insert the scan in the
+   * map. The control points are given a prior if too few points are
+   * constrained, e.g. for the first scan which fixes the gauge of the
+   * trajectory
+   * @param source source of the constraints
+   * @param spline trajectory to constrain
+   * @param graph optional current graph
+   * @param scan_pose registered scan
+   * @param raw_cloud raw scan with per point times
+   * @param T_World_Lidar registration result
+   * @return transaction, or nullptr if there is nothing to add
+   */
+  fuse_core::Transaction::SharedPtr
+      AddScan(const std::string& source,
+              const bs_constraints::SplineTrajectory& spline,
+              const fuse_core::Graph* graph, const ScanPose& scan_pose,
+              const pcl::PointCloud<PointXYZIRT>& raw_cloud,
+              const Eigen::Matrix4d& T_World_Lidar);
+
+  /**
+   * @brief move a scan to its current pose, e.g. after a graph update refined
+   * the spline. Scans that moved less than the registration map thresholds are
+   * left in place
+   * @param scan_pose scan with its updated pose
+   * @param cloud_changed set if the scan's cloud was replaced (e.g.
+   * re-deskewed), in which case it is reinserted even if it did not move
+   */
+  void UpdateScan(const ScanPose& scan_pose, bool cloud_changed);
+
+  /**
+   * @brief remove a scan that left the window
+   */
+  void RemoveScan(const ros::Time& stamp);
+
+  size_t NumScans() const;
+
+  /**
+   * @brief not synchronized, only use it while no other thread changes the
+   * scans
+   */
+  const scan_registration::VoxelGaussianMap& Map() const { return map_; }
+
+private:
+  /** scan in the map, with the transform it was last inserted with so it can
+   * be removed exactly */
+  struct MapScan {
+    PointCloud cloud;
+    Eigen::Matrix4d T_World_Lidar;
+  };
+
+  Params params_;
+  mutable std::mutex mutex_;
+  scan_registration::VoxelGaussianMap map_;
+  std::map<uint64_t, MapScan> scans_;
+};
+
+} // namespace bs_models
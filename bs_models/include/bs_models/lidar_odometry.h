@@ -8,15 +8,15 @@
 #include <fuse_core/uuid.h>
 #include <tf/transform_broadcaster.h>
 
-#include <beam_filtering/Utils.h>
-#include <beam_matching/Matchers.h>
 #include <beam_utils/pointclouds.h>
-#include <beam_utils/time.h>
 
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_common/thread_placement.h>
+#include <bs_constraints/spline/spline_trajectory.h>
 #include <bs_models/frame_initializers/frame_initializer.h>
+#include <bs_models/lidar/lidar_odometry_front_end.h>
 #include <bs_models/lidar/scan_pose.h>
-#include <bs_models/scan_registration/scan_registration_base.h>
+#include <bs_models/lidar/spline_scan_map.h>
 #include <bs_parameters/models/lidar_odometry_params.h>
 
 namespace bs_models {
@@ -50,8 +50,18 @@ private:
 
   void PublishMarginalizedScanPose(const std::shared_ptr<ScanPose>& scan_pose);
 
+  /**
+   * @brief save a scan which has left the window using the shared
+   * bs_common::AsyncDiskWriter, so the graph update thread is not blocked
+   */
   void SaveMarginalizedScanPose(const std::shared_ptr<ScanPose>& scan_pose);
 
+  /**
+   * @brief save a copy of all scans in the window to a new directory for this
+   * graph update, using the shared bs_common::AsyncDiskWriter
+   */
+  void SaveGraphUpdateScans();
+
   void PublishTfTransform(const Eigen::Matrix4d& T_Child_Parent,
                           const std::string& child_frame,
                           const std::string& parent_frame,
@@ -59,6 +69,25 @@ private:
 
   void PublishExtrinsics(fuse_core::Graph::ConstSharedPtr graph_msg);
 
+  /**
+   * @brief scale the registration map voxel size according to the current
+   * level of the DegradationController
+   */
+  void UpdateMapResolution();
+
+  /**
+   * @brief re-deskew the scans in the window with the optimized trajectory,
+   * and replace their clouds in the active scans and the registration map
+   */
+  void RedeskewScans(const fuse_core::Graph& graph);
+
+  /**
+   * @brief get the lidar trajectory in the current window, either from the
+   * continuous-time spline or from the discrete poses in the graph
+   */
+  LidarTrajectory GetLidarTrajectory(const fuse_core::Graph& graph,
+                                     const Eigen::Matrix4d& T_Baselink_Lidar);
+
   /** subscribe to lidar data */
   ros::Subscriber subscriber_;
 
@@ -85,11 +114,14 @@ private:
    * updates */
   std::list<std::shared_ptr<ScanPose>> active_clouds_;
 
-  /** Only needed if using LoamMatcher */
-  std::shared_ptr<beam_matching::LoamFeatureExtractor> feature_extractor_;
+  /** filters, deskews and registers scans to the registration map. Scans are
+   * re-deskewed if redeskew_scans is set, or in continuous-time mode */
+  std::unique_ptr<LidarOdometryFrontEnd> front_end_;
 
-  // register scans to map
-  std::unique_ptr<scan_registration::ScanRegistrationBase> scan_registration_;
+  /** Only used if continuous_time_knot_spacing is set */
+  std::unique_ptr<bs_constraints::SplineTrajectory> spline_;
+  std::unique_ptr<SplineScanMap> spline_map_;
+  fuse_core::Graph::ConstSharedPtr last_graph_;
 
   fuse_core::UUID device_id_; //!< The UUID of this device
   fuse_core::UUID extrinsics_position_uuid_;
@@ -103,7 +135,9 @@ private:
 
   bs_parameters::models::LidarOdometryParams params_;
 
-  std::vector<beam_filtering::FilterParamsType> input_filter_params_;
+  /** placement of the callback threads, and latency of the callbacks */
+  bs_common::ThreadPlacement thread_placement_;
+  std::shared_ptr<bs_common::JitterMonitor> callback_latency_;
 
   int updates_{0};
   Eigen::Matrix4d T_World_BaselinkLast_{Eigen::Matrix4d::Identity()};
@@ -112,6 +146,7 @@ private:
   std::string marginalized_scans_path_;
   std::string registration_results_path_;
   ros::Time last_map_update_time_{0};
+  double base_map_voxel_size_{-1};
   int skipped_scans_in_a_row_{0};
   bool resetting_{false};
 
@@ -123,8 +158,6 @@ private:
   int max_scan_buffer_size_{4};
   bool publish_extrinsics_{false};
   bool log_registration_time_{false};
-
-  beam::HighResolutionTimer timer_;
 };
 
 } // namespace bs_models
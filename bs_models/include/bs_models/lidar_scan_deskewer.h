@@ -6,6 +6,7 @@
 #include <fuse_core/fuse_macros.h>
 #include <fuse_core/throttled_callback.h>
 
+#include <bs_common/thread_placement.h>
 #include <bs_models/frame_initializers/frame_initializer.h>
 #include <bs_parameters/models/lidar_scan_deskewer_params.h>
 
@@ -45,6 +46,9 @@ private:
 
   bs_parameters::models::LidarScanDeskewerParams params_;
 
+  bs_common::ThreadPlacement thread_placement_;
+  std::shared_ptr<bs_common::JitterMonitor> callback_latency_;
+
   int counter_{0};
 
   bs_common::ExtrinsicsLookupOnline& extrinsics_ =
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <nlohmann/json.hpp>
+
+namespace bs_models { namespace scan_registration {
+
+/**
+ * @brief Detects degenerate directions of a scan registration result (e.g.
+ * motion along a tunnel or a long corridor) from the eigenspectrum of the
+ * registration's information matrix (the Hessian of the matching cost, i.e. the
+ * inverse of the matcher's covariance), following Zhang et al., "On Degeneracy
+ * of Optimization-based State Estimation Problems", ICRA 2016.
+ *
+ * Translation and rotation are analyzed separately since their units differ,
+ * each using the marginal covariance of its 3x3 block. A direction is
+ * degenerate if its information is below the threshold for its block.
+ *
+ * The result is used to:
+ *  - restrict the matcher's correction to the well constrained subspace, so
+ *    the initial estimate is kept along degenerate directions (solution
+ *    remapping)
+ *  - shape the covariance sent to the graph, so degenerate directions carry
+ *    (almost) no information while the constrained directions are unchanged
+ *  - clamp the covariance used for outlier validation, so partially
+ *    constrained scans are not rejected for their large uncertainty
+ *
+ * All 6x6 matrices and 6 vectors are ordered [x, y, z, roll, pitch, yaw], the
+ * same as the pose constraints.
+ */
+class DegeneracyAnalysis {
+public:
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+  struct Params {
+    /** if false, registration results are used as is */
+    bool enabled{false};
+
+    /** min eigenvalue of the translation information [1/m^2] for a direction
+     * to be well constrained */
+    double min_translation_information{100};
+
+    /** min eigenvalue of the rotation information [1/rad^2] for a direction
+     * to be well constrained */
+    double min_rotation_information{1000};
+
+    /** variance [m^2 or rad^2] given to degenerate directions in the
+     * covariance sent to the graph */
+    double degenerate_variance{100};
+
+    /**
+     * @brief load params from the "degeneracy" object of a registration config.
+     * Throws if a param is missing
+     */
+    void LoadFromJson(const nlohmann::json& J);
+  };
+
+  struct Result {
+    /** eigenvectors of the translation and rotation blocks, as columns. Block
+     * diagonal */
+    Matrix6d basis{Matrix6d::Identity()};
+
+    /** information along each basis vector */
+    Eigen::Matrix<double, 6, 1> information{
+        Eigen::Matrix<double, 6, 1>::Zero()};
+
+    /** whether each basis vector is degenerate */
+    Eigen::Matrix<bool, 6, 1> degenerate{
+        Eigen::Matrix<bool, 6, 1>::Constant(false)};
+
+    /** projection onto the well constrained subspace */
+    Matrix6d projection{Matrix6d::Identity()};
+
+    int NumDegenerateTranslation() const;
+
+    int NumDegenerateRotation() const;
+
+    bool Degenerate() const;
+  };
+
+  DegeneracyAnalysis() = default;
+
+  explicit DegeneracyAnalysis(const Params& params);
+
+  const Params& GetParams() const { return params_; }
+
+  bool Enabled() const { return params_.enabled; }
+
+  /**
+   * @brief analyze the covariance estimated by the matcher
+   */
+  Result Analyze(const Matrix6d& covariance) const;
+
+  /**
+   * @brief remove the degenerate components of a correction transform
+   * @param T_correction transform estimated by the matcher, from the estimated
+   * frame to the registered frame
+   * @param result result of Analyze
+   * @return correction in the well constrained subspace only
+   */
+  Eigen::Matrix4d ConstrainCorrection(const Eigen::Matrix4d& T_correction,
+                                      const Result& result) const;
+
+  /**
+   * @brief replace the degenerate directions of a covariance with
+   * degenerate_variance and remove their correlations
+   */
+  Matrix6d ShapeCovariance(const Matrix6d& covariance,
+                           const Result& result) const;
+
+  /**
+   * @brief replace the degenerate directions of a covariance with the variance
+   * at the threshold, so it can be validated against well constrained results
+   */
+  Matrix6d ValidationCovariance(const Matrix6d& covariance,
+                                const Result& result) const;
+
+private:
+  Matrix6d ReplaceDegenerate(const Matrix6d& covariance, const Result& result,
+                             double translation_variance,
+                             double rotation_variance) const;
+
+  Params params_;
+};
+
+}} // namespace bs_models::scan_registration
@@ -167,6 +167,11 @@ public:
                             int num_neighbors = 10, double lag_duration = 0,
                             bool disable_lidar_map = false);
 
+  /**
+   * @brief replaces the loam matcher with one using these params
+   */
+  void SetLoamMatcherParams(const beam_matching::LoamParams& params) override;
+
 private:
   bool MatchScans(const ScanPose& scan_pose_ref, const ScanPose& scan_pose_tgt,
                   Eigen::Matrix4d& T_LIDARREF_LIDARTGT) override;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <fuse_core/graph.h>
 #include <fuse_core/uuid.h>
 #include <ros/publisher.h>
@@ -8,6 +11,8 @@
 #include <beam_utils/pointclouds.h>
 #include <beam_utils/time.h>
 
+#include <bs_models/lidar/dynamic_point_filter.h>
+
 namespace bs_models { namespace scan_registration {
 
 /**
@@ -28,6 +33,13 @@ public:
     beam_matching::LoamPointCloud loam_cloud;
     fuse_core::UUID orientation_uuid;
     fuse_core::UUID position_uuid;
+
+    /** only set if the dynamic point filter is enabled, in the scan frame */
+    std::shared_ptr<const DynamicPointFilter::VisibilityImage> visibility;
+
+    /** changes each time the points of this scan are replaced or removed, but
+     * not when the scan is moved. See GetScanRevision */
+    uint64_t revision{0};
   };
 
   /**
@@ -43,6 +55,11 @@ public:
    */
   void SetVoxelDownsampleSize(double downsample_voxel_size);
 
+  /**
+   * @brief return the current voxel downsample size (-1 if not downsampling)
+   */
+  double VoxelDownsampleSize() const;
+
   /**
    * @brief map_size: number of scans to store in this map. If already set,
    * it'll override and purge extra clouds
@@ -51,10 +68,25 @@ public:
 
   /**
    * @brief if set to true, this class with publish the full
-   * lidar map in the world frame whenever the map is updated
+   * lidar map in the world frame whenever the map is updated. Publishers are
+   * only advertised once this is set, so that the map can be used offline
+   * without a ROS master
    */
   void SetPublishUpdates(bool publish_updates);
 
+  /**
+   * @brief set params for removing points on moving objects. If enabled, each
+   * new scan has its points that previous scans saw through removed before
+   * being added, and points of recent scans that the newest scans see through
+   * are removed from the map. See DynamicPointFilter
+   */
+  void SetDynamicPointFilter(const DynamicPointFilter::Params& params);
+
+  /**
+   * @brief total number of points removed by the dynamic point filter
+   */
+  size_t NumDynamicPointsRemoved() const;
+
   /**
    * @brief return map size
    * @return map_size
@@ -123,6 +155,21 @@ public:
                   double rotation_threshold_deg = 0.5,
                   double translation_threshold_m = 0.005);
 
+  /**
+   * @brief replace the points of a scan if that scan is currently saved in the
+   * map, keeping its current pose. This is used when a scan is re-deskewed
+   * after the trajectory was refined, see ScanRedeskewer
+   * @param stamp time associated with the scan
+   * @param cloud new pointcloud, in the scan frame
+   * @param loam_cloud new loam pointcloud, in the scan frame
+   * @param publish set to false when updating several scans, and call Publish
+   * once they are all updated
+   * @return true if the scan exists
+   */
+  bool UpdateScanClouds(const ros::Time& stamp, const PointCloud& cloud,
+                        const beam_matching::LoamPointCloud& loam_cloud,
+                        bool publish = true);
+
   /**
    * @brief save pointcloud of current scanposes
    * @param save_path full path to output directory. This directory must exist
@@ -134,6 +181,29 @@ public:
   void Save(const std::string& save_path, bool add_frames = true,
             uint8_t r = 255, uint8_t g = 255, uint8_t b = 255) const;
 
+  /**
+   * @brief save all scans and their poses so that the map can be restored
+   * with LoadSnapshot, e.g., when warm starting. See bs_common::SnapshotManager
+   * @param directory full path to output directory. This directory must exist
+   * @return true if successful
+   */
+  bool SaveSnapshot(const std::string& directory) const;
+
+  /**
+   * @brief copy all scans under the map lock and return a function which
+   * saves the copy the same way as SaveSnapshot. The function owns the copy,
+   * so it can be run on another thread (e.g., with
+   * bs_common::SnapshotManager::SaveAsync) while this map keeps changing
+   */
+  std::function<bool(const std::string& directory)> SnapshotWriter() const;
+
+  /**
+   * @brief replace the current scans with the ones saved with SaveSnapshot
+   * @param directory full path to the directory containing the snapshot
+   * @return true if successful
+   */
+  bool LoadSnapshot(const std::string& directory);
+
   /**
    * @brief get a scan pose collected at some timestamp. This will check both
    * the loam cloud poses (this takes priority) and regular poses
@@ -143,6 +213,21 @@ public:
    */
   bool GetScanPose(const ros::Time& stamp, Eigen::Matrix4d& T_Map_Scan) const;
 
+  /**
+   * @brief get the revision of the points of a scan, so that users that keep
+   * a copy of the scan can tell when its points were changed, e.g. by the
+   * dynamic point filter or UpdateScanClouds
+   * @param stamp when scan was collected
+   * @param revision reference to the revision to fill in
+   * @return true if scan with this timestamp exists
+   */
+  bool GetScanRevision(const ros::Time& stamp, uint64_t& revision) const;
+
+  /**
+   * @brief get the timestamps of all scans currently stored, oldest first
+   */
+  std::vector<ros::Time> GetScanStamps() const;
+
   /**
    * @brief get a scan collected at some timestamp, with points expressed in the
    * map frame
@@ -227,19 +312,31 @@ private:
   pcl::PointCloud<PointXYZIRT>
       DownsampleCloud(const pcl::PointCloud<PointXYZIRT>& cloud_in) const;
 
+  /**
+   * @brief remove dynamic points from a newly added scan, and from the recent
+   * scans that it sees through
+   */
+  void RemoveDynamicPoints(uint64_t stamp_nsecs, const PointCloud& cloud,
+                           const beam_matching::LoamPointCloud& loam_cloud);
+
   // publishers
   ros::Publisher lidar_map_publisher_;
   ros::Publisher loam_map_publisher_;
 
-  std::mutex mutex_;
+  mutable std::mutex mutex_;
   int map_size_{10};
   double downsample_voxel_size_{-1};
   bool map_size_set_{false};
   int updates_counter_{0};
   bool publish_updates_{false};
+  bool publishers_advertised_{false};
   std::string world_frame_id_;
 
   std::map<uint64_t, ScanPoseInMapFrame> scans_;
+  uint64_t last_revision_{0};
+
+  DynamicPointFilter dynamic_point_filter_;
+  size_t num_dynamic_points_removed_{0};
 
   bool log_time_{false};
   mutable beam::HighResolutionTimer timer_;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <ros/time.h>
+
+namespace bs_models { namespace scan_registration {
+
+/**
+ * @brief set of registration parameters that trade off accuracy for
+ * computation time. These map to the values that differ between the fast and
+ * slow config pairs (e.g. scan_to_map.json and scan_to_map_slow.json)
+ */
+struct RegistrationProfile {
+  /** number of scans in the registration map */
+  int map_size{45};
+
+  /** loam feature counts per feature region */
+  int max_corner_sharp{2};
+  int max_corner_less_sharp{20};
+  int max_surface_flat{4};
+
+  /** loam matcher correspondence iterations */
+  int max_correspondence_iterations{5};
+
+  /** ceres solver time for each correspondence iteration */
+  double max_solver_time_in_seconds{0.1};
+
+  bool operator==(const RegistrationProfile& other) const;
+
+  bool operator!=(const RegistrationProfile& other) const {
+    return !(*this == other);
+  }
+
+  void LoadFromJson(const nlohmann::json& J);
+
+  void Print(std::ostream& stream = std::cout) const;
+};
+
+/**
+ * @brief Selects registration parameters at runtime by measuring the time
+ * taken to process each scan relative to the scan period. The profile is
+ * linearly interpolated between min_profile (level 0, cheapest) and
+ * max_profile (level 1, most accurate).
+ *
+ * When the smoothed load (processing time / scan period) goes above
+ * high_load_ratio, the level is decreased by level_step. When it goes below
+ * low_load_ratio, the level is increased by level_step. After each change we
+ * wait cooldown_scans scans so the load can settle with the new parameters.
+ */
+class RegistrationProfileTuner {
+public:
+  struct Params {
+    /** If false, the profile is never changed from the initial level.
+     * LidarOdometry does not use the tuner at all if false, so that the
+     * registration and matcher configs apply unchanged */
+    bool enabled{false};
+
+    /** Level to start at in [0, 1]. Starting at 0 means we start with the
+     * cheapest profile and only spend more time when we know we have it */
+    double initial_level{0};
+
+    /** Amount to change the level by on each adjustment */
+    double level_step{0.1};
+
+    /** Decrease the level when the load is above this */
+    double high_load_ratio{0.8};
+
+    /** Increase the level when the load is below this */
+    double low_load_ratio{0.5};
+
+    /** Exponential smoothing factor in (0, 1] applied to each new load
+     * measurement. Lower values react slower but are less noisy */
+    double load_smoothing{0.1};
+
+    /** Number of scans to wait after each level change */
+    int cooldown_scans{20};
+
+    /** Profile at level 0 and 1, respectively */
+    RegistrationProfile min_profile;
+    RegistrationProfile max_profile;
+
+    /** Loads params from a json file. Throws std::runtime_error if the file
+     * cannot be read or has invalid bounds */
+    void LoadFromJson(const std::string& config);
+
+    void Print(std::ostream& stream = std::cout) const;
+  };
+
+  /**
+   * @brief constructor
+   * @param params tuning params
+   */
+  explicit RegistrationProfileTuner(const Params& params);
+
+  /**
+   * @brief add the time taken to process a scan
+   * @param stamp scan stamp, used to measure the scan period
+   * @param processing_time_s time taken to process this scan
+   * @return true if the profile changed and needs to be applied
+   */
+  bool AddMeasurement(const ros::Time& stamp, double processing_time_s);
+
+  /**
+   * @brief reset the load measurements and go back to the initial level
+   */
+  void Reset();
+
+  const RegistrationProfile& GetProfile() const { return profile_; }
+
+  double GetLevel() const { return level_; }
+
+  /** smoothed ratio of processing time to scan period */
+  double GetLoad() const { return load_; }
+
+  const Params& GetParams() const { return params_; }
+
+private:
+  /**
+   * @brief interpolate between min and max profiles
+   */
+  RegistrationProfile Interpolate(double level) const;
+
+  Params params_;
+  RegistrationProfile profile_;
+  double level_{0};
+  double load_{0};
+  bool load_initialized_{false};
+  int scans_since_change_{0};
+  ros::Time last_stamp_{0};
+};
+
+}} // namespace bs_models::scan_registration
@@ -5,6 +5,7 @@
 #include <bs_common/extrinsics_lookup_online.h>
 #include <bs_constraints/relative_pose/pose_3d_stamped_transaction.h>
 #include <bs_models/lidar/scan_pose.h>
+#include <bs_models/scan_registration/degeneracy_analysis.h>
 #include <bs_models/scan_registration/registration_map.h>
 #include <bs_models/scan_registration/registration_validation.h>
 
@@ -40,6 +41,11 @@ struct ScanRegistrationParamsBase {
   /** If not empty, each method can save registration output to this path */
   std::string save_path;
 
+  /** Handling of degenerate registration results (e.g. in tunnels or long
+   * corridors). Loaded from the optional "degeneracy" object of the config,
+   * disabled by default. See DegeneracyAnalysis */
+  DegeneracyAnalysis::Params degeneracy;
+
   /** This will load the default params, and can be called by derived classes.
    */
   void LoadBaseFromJson(const std::string& config);
@@ -88,16 +94,47 @@ public:
 
   ScanRegistrationParamsBase& GetBaseParamsMutable() { return base_params_; }
 
+  /**
+   * @brief replace the params of the loam matcher, e.g. when the registration
+   * profile is changed at runtime. Registration types that don't use a loam
+   * matcher ignore this.
+   */
+  virtual void SetLoamMatcherParams(const beam_matching::LoamParams& params) {}
+
 protected:
   bool PassedMotionThresholds(const Eigen::Matrix4d& T_CLOUD1_CLOUD2);
 
+  /**
+   * @brief validate a registration result using covariance_, which must be set
+   * before calling this. If degeneracy handling is enabled, the matcher's
+   * covariance is first analyzed: the correction is restricted to the well
+   * constrained directions, covariance_ is shaped so that degenerate
+   * directions carry no information, and only the constrained directions are
+   * validated
+   * @param T_correction correction estimated by the matcher, from the
+   * estimated to the registered frame. Updated in place
+   * @param matcher_covariance covariance estimated by the matcher, in the
+   * frame of the correction
+   * @param R_CONSTRAINT_CORRECTION rotation from the frame of the correction
+   * to the frame of the relative pose constraint, used to express the shaped
+   * covariance in the constraint frame
+   * @return true if the result passed validation
+   */
+  bool ValidateRegistration(
+      Eigen::Matrix4d& T_correction,
+      const Eigen::Matrix<double, 6, 6>& matcher_covariance,
+      const Eigen::Matrix3d& R_CONSTRAINT_CORRECTION =
+          Eigen::Matrix3d::Identity());
+
   ScanRegistrationParamsBase base_params_;
   Eigen::Matrix<double, 6, 6> covariance_;
+  Eigen::Matrix<double, 6, 6> fixed_covariance_;
   bool use_fixed_covariance_{false};
   RegistrationMap& map_ = RegistrationMap::GetInstance();
   bs_common::ExtrinsicsLookupOnline& extrinsics_ =
       bs_common::ExtrinsicsLookupOnline::GetInstance();
   RegistrationValidation registration_validation_;
+  DegeneracyAnalysis degeneracy_analysis_;
   double covariance_weight_{1.0};
 
   /** This is the prior set on the first scan when fix_first_scan is enabled.
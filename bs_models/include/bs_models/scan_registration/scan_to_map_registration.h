@@ -10,6 +10,8 @@
 #include <bs_models/lidar/scan_pose.h>
 #include <bs_models/scan_registration/registration_map.h>
 #include <bs_models/scan_registration/scan_registration_base.h>
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+#include <bs_models/scan_registration/voxel_gaussian_matcher.h>
 
 namespace bs_models { namespace scan_registration {
 
@@ -110,6 +112,11 @@ public:
                             int map_size = 10,
                             double downsample_voxel_size = -1);
 
+  /**
+   * @brief replaces the loam matcher with one using these params
+   */
+  void SetLoamMatcherParams(const beam_matching::LoamParams& params) override;
+
 private:
   bool RegisterScanToMap(const ScanPose& scan_pose,
                          Eigen::Matrix4d& T_MAP_SCAN) override;
@@ -121,4 +128,61 @@ private:
   Params params_;
 };
 
+/**
+ * @brief Derived class that implements scan to map registration by matching
+ * points to the distributions of a VoxelGaussianMap. The voxel map mirrors the
+ * scans in the RegistrationMap: scans are inserted and trimmed incrementally,
+ * scans whose poses are updated in the RegistrationMap (e.g. after a graph
+ * update) are moved in the voxel map, and scans whose points change (e.g. the
+ * dynamic point filter or re-deskewing) are reinserted.
+ *
+ * NOTE: this uses the same registration params as ScanToMapLoamRegistration.
+ */
+class ScanToMapVoxelGaussianRegistration : public ScanToMapRegistrationBase {
+public:
+  using Params = ScanToMapLoamRegistration::Params;
+
+  ScanToMapVoxelGaussianRegistration(
+      std::unique_ptr<VoxelGaussianMatcher> matcher,
+      const ScanRegistrationParamsBase& base_params, int map_size = 10,
+      double downsample_voxel_size = -1);
+
+  const VoxelGaussianMap& GetVoxelMap() const { return voxel_map_; }
+
+private:
+  /** cloud inserted in the voxel map, kept so it can be removed or moved */
+  struct VoxelMapScan {
+    ros::Time stamp;
+    PointCloud cloud;
+    Eigen::Matrix4d T_MAP_SCAN;
+    uint64_t revision{0};
+  };
+
+  bool RegisterScanToMap(const ScanPose& scan_pose,
+                         Eigen::Matrix4d& T_MAP_SCAN) override;
+
+  void AddScanToMap(const ScanPose& scan_pose,
+                    const Eigen::Matrix4d& T_MAP_SCAN) override;
+
+  /**
+   * @brief make the voxel map consistent with the RegistrationMap, which may
+   * have been loaded, updated or cleared externally
+   */
+  void SyncVoxelMap();
+
+  /**
+   * @brief get a scan from the RegistrationMap, with its points in the scan
+   * frame and downsampled
+   * @return false if the scan is not in the RegistrationMap
+   */
+  bool GetMapScan(const ros::Time& stamp, VoxelMapScan& scan) const;
+
+  PointCloud Downsample(const PointCloud& cloud, double voxel_size) const;
+
+  std::unique_ptr<VoxelGaussianMatcher> matcher_;
+  Params params_;
+  VoxelGaussianMap voxel_map_;
+  std::list<VoxelMapScan> voxel_map_scans_;
+};
+
 }} // namespace bs_models::scan_registration
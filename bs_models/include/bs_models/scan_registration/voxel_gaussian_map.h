@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <Eigen/Dense>
+
+#include <beam_utils/pointclouds.h>
+
+namespace bs_models { namespace scan_registration {
+
+/**
+ * @brief Map of normal distributions, one per occupied voxel, used for point
+ * to distribution scan matching.
+ *
+ * Each voxel stores the sufficient statistics of its points (count, sum and
+ * sum of outer products), so scans can be added and removed incrementally and
+ * only the voxels they touch are recomputed. Finding the distribution that
+ * corresponds to a point is a single hash lookup, instead of a nearest
+ * neighbor search into the raw points.
+ *
+ * Voxels with fewer than min_points_per_voxel points have no distribution.
+ * Covariances are regularized by clamping their eigenvalues to at least
+ * covariance_regularization times the largest eigenvalue, so that planar and
+ * linear voxels have a well defined information matrix.
+ */
+class VoxelGaussianMap {
+public:
+  struct Voxel {
+    int num_points{0};
+    Eigen::Vector3d sum{Eigen::Vector3d::Zero()};
+    Eigen::Matrix3d sum_outer{Eigen::Matrix3d::Zero()};
+
+    /** only valid if num_points >= min_points_per_voxel */
+    bool valid{false};
+    Eigen::Vector3d mean{Eigen::Vector3d::Zero()};
+    Eigen::Matrix3d information{Eigen::Matrix3d::Zero()};
+  };
+
+  /**
+   * @brief constructor
+   * @param voxel_size voxel side length [m]
+   * @param min_points_per_voxel min number of points for a voxel to have a
+   * distribution
+   * @param covariance_regularization min ratio between the smallest and
+   * largest eigenvalue of each voxel covariance
+   */
+  explicit VoxelGaussianMap(double voxel_size = 1.0,
+                            int min_points_per_voxel = 6,
+                            double covariance_regularization = 1e-3);
+
+  /**
+   * @brief add points to the map
+   * @param cloud points in the cloud frame
+   * @param T_MAP_CLOUD transform from the cloud frame to the map frame
+   */
+  void AddPoints(const PointCloud& cloud, const Eigen::Matrix4d& T_MAP_CLOUD =
+                                              Eigen::Matrix4d::Identity());
+
+  /**
+   * @brief remove points that were previously added with the same transform
+   */
+  void RemovePoints(const PointCloud& cloud,
+                    const Eigen::Matrix4d& T_MAP_CLOUD =
+                        Eigen::Matrix4d::Identity());
+
+  void Clear();
+
+  /**
+   * @brief get the voxel containing a point in the map frame
+   * @return nullptr if the voxel is empty
+   */
+  const Voxel* Find(const Eigen::Vector3d& p_MAP) const;
+
+  /**
+   * @brief get a voxel from its integer coordinates
+   * @return nullptr if the voxel is empty
+   */
+  const Voxel* Find(const Eigen::Vector3i& coordinates) const;
+
+  /** integer coordinates of the voxel containing a point in the map frame */
+  Eigen::Vector3i Coordinates(const Eigen::Vector3d& p_MAP) const;
+
+  /** number of occupied voxels, including those without a distribution */
+  size_t NumVoxels() const;
+
+  /** number of voxels with a distribution */
+  size_t NumValidVoxels() const;
+
+  /** total number of points in the map */
+  size_t NumPoints() const;
+
+  /**
+   * @brief mean over the voxels with a distribution of the standard deviation
+   * along their thinnest direction, before regularization. Lower is sharper,
+   * e.g. to compare maps built from the same scans with different deskewing
+   */
+  double MeanThickness() const;
+
+  double VoxelSize() const { return voxel_size_; }
+
+private:
+  static uint64_t Key(const Eigen::Vector3i& coordinates);
+
+  void Update(const PointCloud& cloud, const Eigen::Matrix4d& T_MAP_CLOUD,
+              int sign);
+
+  void ComputeDistribution(Voxel& voxel) const;
+
+  double voxel_size_;
+  double inverse_voxel_size_;
+  int min_points_per_voxel_;
+  double covariance_regularization_;
+  std::unordered_map<uint64_t, Voxel> voxels_;
+  size_t num_points_{0};
+};
+
+}} // namespace bs_models::scan_registration
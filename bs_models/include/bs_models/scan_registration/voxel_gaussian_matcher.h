@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+
+#include <Eigen/Dense>
+
+#include <beam_utils/pointclouds.h>
+
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+
+namespace bs_models { namespace scan_registration {
+
+/**
+ * @brief Point to distribution matcher that registers a source cloud to a
+ * VoxelGaussianMap.
+ *
+ * Each source point is associated with the distribution of the voxel it falls
+ * in (optionally also the 6 face neighbors, keeping the one with the lowest
+ * Mahalanobis distance), so correspondences are found with a constant number
+ * of hash lookups per point rather than a nearest neighbor search. The
+ * transform is then solved with Gauss-Newton, minimizing the sum of the
+ * squared Mahalanobis distances between the transformed points and their
+ * distributions.
+ *
+ * Unlike the beam_matching matchers, this is selected with a matcher config
+ * with "matcher_type": "VOXEL_GAUSSIAN". See
+ * beam_slam_launch/config/matchers/voxel_gaussian.json
+ */
+class VoxelGaussianMatcher {
+public:
+  struct Params {
+    /** side length of the voxels of the map [m] */
+    double voxel_size{1.0};
+
+    /** min number of map points for a voxel to be used */
+    int min_points_per_voxel{6};
+
+    /** min ratio between the smallest and largest eigenvalue of each voxel
+     * covariance */
+    double covariance_regularization{1e-2};
+
+    /** voxel size used to downsample the source scans before matching. Set to
+     * zero to use all points */
+    double source_voxel_size{0.2};
+
+    int max_iterations{30};
+
+    /** stop iterating once the update is below both of these */
+    double translation_eps_m{1e-4};
+    double rotation_eps_deg{1e-3};
+
+    /** correspondences with a larger Mahalanobis distance are ignored */
+    double max_mahalanobis_distance{10};
+
+    /** also search the 6 face neighbors of the voxel containing each point */
+    bool search_neighbors{true};
+
+    /** min number of correspondences for a valid result */
+    int min_correspondences{50};
+
+    /** load from a matcher config json */
+    void LoadFromJson(const std::string& config);
+  };
+
+  /**
+   * @brief check if a matcher config is for this matcher
+   */
+  static bool IsConfig(const std::string& config);
+
+  VoxelGaussianMatcher() = default;
+
+  explicit VoxelGaussianMatcher(const Params& params);
+
+  /**
+   * @brief register a cloud to a map
+   * @param source points in the source frame
+   * @param map map to register to
+   * @param T_MAP_SOURCE initial estimate, replaced with the result if the
+   * registration succeeds
+   * @return false if there were too few correspondences or the problem was
+   * singular
+   */
+  bool Match(const PointCloud& source, const VoxelGaussianMap& map,
+             Eigen::Matrix4d& T_MAP_SOURCE);
+
+  /**
+   * @brief covariance of the last result, as the inverse of the Gauss-Newton
+   * Hessian. Perturbations are applied on the left, in the map frame, and
+   * ordered [x, y, z, roll, pitch, yaw]
+   */
+  const Eigen::Matrix<double, 6, 6>& GetCovariance() const {
+    return covariance_;
+  }
+
+  int NumIterations() const { return num_iterations_; }
+
+  int NumCorrespondences() const { return num_correspondences_; }
+
+  const Params& GetParams() const { return params_; }
+
+private:
+  /**
+   * @brief find the distribution a point in the map frame corresponds to
+   * @return nullptr if no valid distribution is found
+   */
+  const VoxelGaussianMap::Voxel* FindCorrespondence(
+      const VoxelGaussianMap& map, const Eigen::Vector3d& p_MAP) const;
+
+  Params params_;
+  Eigen::Matrix<double, 6, 6> covariance_{
+      Eigen::Matrix<double, 6, 6>::Identity()};
+  int num_iterations_{0};
+  int num_correspondences_{0};
+};
+
+}} // namespace bs_models::scan_registration
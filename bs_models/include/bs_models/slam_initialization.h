@@ -91,11 +91,26 @@ private:
    */
   void onStop() override;
 
+  /**
+   * @brief Saves the graph and extrinsics to the snapshot if a save is due. See
+   * bs_common::SnapshotManager
+   */
+  void onGraphUpdate(fuse_core::Graph::ConstSharedPtr graph_msg) override;
+
   /**
    * @brief Clears all memory and shuts down subscribers
    */
   void shutdown();
 
+  /**
+   * @brief Attempts to start from the graph in the snapshot instead of
+   * initializing from scratch. This only succeeds if warm starting is enabled
+   * and the snapshot is recent enough.
+   * @param stamp stamp of the first IMU measurement received
+   * @return pass or fail
+   */
+  bool WarmStart(const ros::Time& stamp);
+
   /**
    * @brief Attempts initialization using the available imu, lidar, and visual
    * data. Will create and send an initial graph to the fuse optimizer to
@@ -174,6 +189,10 @@ private:
   // method for estimating initial path
   InitMode mode_ = InitMode::VISUAL;
 
+  // warm starting is only attempted once per process, a reset should not
+  // restore the state that lead to it
+  bool warm_start_attempted_{false};
+
   // initial path estimate for performing initialization, stored as
   // T_WORLD_BASELINK
   std::map<uint64_t, Eigen::Matrix4d> init_path_;
@@ -11,6 +11,7 @@
 
 #include <bs_common/bs_msgs.h>
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_common/thread_placement.h>
 #include <bs_parameters/models/visual_feature_tracker_params.h>
 
 namespace bs_models {
@@ -72,6 +73,10 @@ private:
   // loadable camera parameters
   bs_parameters::models::VisualFeatureTrackerParams params_;
 
+  // placement of the callback threads, and latency of the image callbacks
+  bs_common::ThreadPlacement thread_placement_;
+  std::shared_ptr<bs_common::JitterMonitor> callback_latency_;
+
   // subscribers
   ros::Subscriber image_subscriber_;
 
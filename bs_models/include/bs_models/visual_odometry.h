@@ -17,6 +17,7 @@
 
 #include <bs_common/bs_msgs.h>
 #include <bs_common/extrinsics_lookup_online.h>
+#include <bs_common/thread_placement.h>
 #include <bs_models/frame_initializers/frame_initializer.h>
 #include <bs_models/vision/keyframe.h>
 #include <bs_models/vision/visual_map.h>
@@ -235,6 +236,12 @@ private:
   /// @brief loadable camera parameters
   bs_parameters::models::VisualOdometryParams vo_params_;
 
+  /// @brief placement of the callback threads
+  bs_common::ThreadPlacement thread_placement_;
+
+  /// @brief latency of the measurement callbacks
+  std::shared_ptr<bs_common::JitterMonitor> callback_latency_;
+
   /// @brief calibration parameters
   bs_parameters::models::CalibrationParams calibration_params_;
 
@@ -13,6 +13,7 @@
 #include <beam_utils/filesystem.h>
 #include <beam_utils/time.h>
 
+#include <bs_common/async_disk_writer.h>
 #include <bs_common/conversions.h>
 #include <bs_common/utils.h>
 #include <bs_common/visualization.h>
@@ -31,6 +32,25 @@ namespace bs_models {
 
 using namespace graph_visualization;
 
+namespace {
+
+/**
+ * @brief queue saving a cloud on the disk writer threads, so that graph
+ * updates are not blocked by the disk
+ */
+void QueueSaveCloud(const std::string& save_path, const std::string& cloud_name,
+                    pcl::PointCloud<pcl::PointXYZRGBL>&& cloud) {
+  if (save_path.empty()) { return; }
+  auto cloud_ptr = std::make_shared<const pcl::PointCloud<pcl::PointXYZRGBL>>(
+      std::move(cloud));
+  bs_common::AsyncDiskWriter::GetInstance().Enqueue(
+      cloud_name, [save_path, cloud_name, cloud_ptr]() {
+        SaveCloud<pcl::PointXYZRGBL>(save_path, cloud_name, *cloud_ptr);
+      });
+}
+
+} // namespace
+
 GraphVisualization::GraphVisualization()
     : fuse_core::AsyncSensorModel(1),
       throttled_measurement_callback_(
@@ -118,9 +138,9 @@ void GraphVisualization::VisualizePoses(
   pcl::PointCloud<pcl::PointXYZRGBL> cloud =
       bs_common::GetGraphPosesAsCloud(*graph_msg);
   PublishCloud<pcl::PointXYZRGBL>(poses_publisher_, cloud);
-  SaveCloud<pcl::PointXYZRGBL>(
-      save_path_, std::to_string(current_time_.toSec()) + "_graph_poses",
-      cloud);
+  QueueSaveCloud(save_path_,
+                 std::to_string(current_time_.toSec()) + "_graph_poses",
+                 std::move(cloud));
 }
 
 void GraphVisualization::VisualizeLidarRelativePoseConstraints(
@@ -135,10 +155,10 @@ void GraphVisualization::VisualizeLidarRelativePoseConstraints(
 
   PublishCloud<pcl::PointXYZRGBL>(lidar_relative_pose_constraints_publisher_,
                                   cloud);
-  SaveCloud<pcl::PointXYZRGBL>(save_path_,
-                               std::to_string(current_time_.toSec()) +
-                                   "_lidar_relative_pose_constraints",
-                               cloud);
+  QueueSaveCloud(save_path_,
+                 std::to_string(current_time_.toSec()) +
+                     "_lidar_relative_pose_constraints",
+                 std::move(cloud));
 }
 
 void GraphVisualization::VisualizeImuRelativeConstraints(
@@ -147,10 +167,10 @@ void GraphVisualization::VisualizeImuRelativeConstraints(
       GetGraphRelativeImuConstraintsAsCloud(*graph_msg, point_spacing_,
                                             frame_size_);
   PublishCloud<pcl::PointXYZRGBL>(relative_imu_constraints_publisher_, cloud);
-  SaveCloud<pcl::PointXYZRGBL>(save_path_,
-                               std::to_string(current_time_.toSec()) +
-                                   "_relative_imu_constraints",
-                               cloud);
+  QueueSaveCloud(save_path_,
+                 std::to_string(current_time_.toSec()) +
+                     "_relative_imu_constraints",
+                 std::move(cloud));
 }
 
 void GraphVisualization::VisualizeImuBiases(
@@ -177,8 +197,13 @@ void GraphVisualization::VisualizeImuBiases(
   imu_biases_publisher_az_.publish(az);
 
   // save window of biases
-  SaveImuBiases(biases_in_graph, save_path_,
-                std::to_string(current_time_.toSec()) + "_imu_biases");
+  if (save_path_.empty()) { return; }
+  const std::string filename =
+      std::to_string(current_time_.toSec()) + "_imu_biases";
+  bs_common::AsyncDiskWriter::GetInstance().Enqueue(
+      filename,
+      [biases = std::move(biases_in_graph), save_path = save_path_,
+       filename]() { SaveImuBiases(biases, save_path, filename); });
 }
 
 void GraphVisualization::VisualizeImuGravityConstraints(
@@ -186,9 +211,9 @@ void GraphVisualization::VisualizeImuGravityConstraints(
   pcl::PointCloud<pcl::PointXYZRGBL> cloud = GetGraphGravityConstraintsAsCloud(
       *graph_msg, point_spacing_, frame_size_, g_length_);
   PublishCloud<pcl::PointXYZRGBL>(gravity_constraints_publisher_, cloud);
-  SaveCloud<pcl::PointXYZRGBL>(
-      save_path_,
-      std::to_string(current_time_.toSec()) + "_gravity_constraints", cloud);
+  QueueSaveCloud(save_path_,
+                 std::to_string(current_time_.toSec()) + "_gravity_constraints",
+                 std::move(cloud));
 }
 
 void GraphVisualization::VisualizeCameraLandmarks(
@@ -196,9 +221,9 @@ void GraphVisualization::VisualizeCameraLandmarks(
   pcl::PointCloud<pcl::PointXYZRGBL> cloud =
       GetGraphCameraLandmarksAsCloud(*graph_msg);
   PublishCloud<pcl::PointXYZRGBL>(camera_landmarks_publisher_, cloud);
-  SaveCloud<pcl::PointXYZRGBL>(
-      save_path_, std::to_string(current_time_.toSec()) + "_camera_landmarks",
-      cloud);
+  QueueSaveCloud(save_path_,
+                 std::to_string(current_time_.toSec()) + "_camera_landmarks",
+                 std::move(cloud));
 
   // get all timestamps in the graph
   auto timestamps = bs_common::CurrentTimestamps(*graph_msg);
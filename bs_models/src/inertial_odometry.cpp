@@ -1,14 +1,22 @@
 #include <bs_models/inertial_odometry.h>
 
+#include <atomic>
+#include <fstream>
+
 #include <geometry_msgs/PoseStamped.h>
 #include <pluginlib/class_list_macros.h>
+#include <ros/serialization.h>
 
 #include <beam_utils/filesystem.h>
 #include <std_msgs/Empty.h>
 
 #include <bs_common/conversions.h>
 #include <bs_common/graph_access.h>
+#include <bs_common/snapshot_manager.h>
+#include <bs_constraints/global/absolute_constraint.h>
 #include <bs_constraints/inertial/relative_imu_state_3d_stamped_constraint.h>
+#include <bs_constraints/relative_pose/relative_constraints.h>
+#include <bs_constraints/spline/spline_imu_constraint.h>
 #include <fuse_constraints/relative_constraint.h>
 #include <fuse_constraints/relative_pose_3d_stamped_constraint.h>
 
@@ -17,6 +25,13 @@ PLUGINLIB_EXPORT_CLASS(bs_models::InertialOdometry, fuse_core::SensorModel);
 
 namespace bs_models {
 
+namespace {
+
+const std::string kImuBufferSnapshot = "imu_buffer";
+const std::string kImuMsgsFilename = "imu_msgs.bin";
+
+} // namespace
+
 ImuBuffer::ImuBuffer(double buffer_length_s) {
   buffer_length_ = ros::Duration(buffer_length_s);
 }
@@ -97,6 +112,47 @@ const std::map<ros::Time, sensor_msgs::Imu::ConstPtr>&
   return imu_msgs_;
 }
 
+bool ImuBuffer::Save(const std::string& directory) const {
+  std::ofstream file(beam::CombinePaths(directory, kImuMsgsFilename),
+                     std::ios::binary);
+  if (!file.good()) { return false; }
+
+  // each message is stored as its serialized length followed by the ros
+  // serialized message
+  std::vector<uint8_t> buffer;
+  for (const auto& [stamp, msg] : imu_msgs_) {
+    const uint32_t length = ros::serialization::serializationLength(*msg);
+    buffer.resize(length);
+    ros::serialization::OStream stream(buffer.data(), length);
+    ros::serialization::serialize(stream, *msg);
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(reinterpret_cast<const char*>(buffer.data()), length);
+  }
+  return file.good();
+}
+
+bool ImuBuffer::Load(const std::string& directory) {
+  std::ifstream file(beam::CombinePaths(directory, kImuMsgsFilename),
+                     std::ios::binary);
+  if (!file.good()) { return false; }
+
+  std::vector<uint8_t> buffer;
+  uint32_t length;
+  while (file.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+    buffer.resize(length);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), length)) {
+      BEAM_ERROR("Truncated IMU buffer snapshot in: {}", directory);
+      return false;
+    }
+    auto msg = boost::make_shared<sensor_msgs::Imu>();
+    ros::serialization::IStream stream(buffer.data(), length);
+    ros::serialization::deserialize(stream, *msg);
+    imu_msgs_.emplace(msg->header.stamp, msg);
+  }
+  CleanOverflow();
+  return true;
+}
+
 InertialOdometry::InertialOdometry()
     : fuse_core::AsyncSensorModel(2),
       throttled_imu_callback_(std::bind(&InertialOdometry::processIMU, this,
@@ -109,6 +165,14 @@ void InertialOdometry::onInit() {
   calibration_params_.loadFromROS();
   params_.loadFromROS(private_node_handle_);
 
+  // setup placement of the callback threads
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(
+      ros::NodeHandle(private_node_handle_, "thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement(name(), placement_params);
+  callback_latency_ = bs_common::JitterMonitor::Create(name() + " Callback");
+  lock_hold_ = bs_common::JitterMonitor::Create(name() + " Lock");
+
   // setup publishers
   odometry_publisher_ =
       private_node_handle_.advertise<nav_msgs::Odometry>("odometry", 100);
@@ -126,6 +190,11 @@ void InertialOdometry::onInit() {
   imu_params_.cov_gyro_bias = Eigen::Matrix3d::Identity() * J["cov_gyro_bias"];
   imu_params_.cov_accel_bias =
       Eigen::Matrix3d::Identity() * J["cov_accel_bias"];
+
+  if (params_.continuous_time_knot_spacing > 0) {
+    spline_ = std::make_unique<bs_constraints::SplineTrajectory>(
+        params_.continuous_time_knot_spacing);
+  }
 }
 
 void InertialOdometry::onStart() {
@@ -148,10 +217,46 @@ void InertialOdometry::onStop() {
 }
 
 void InertialOdometry::processIMU(const sensor_msgs::Imu::ConstPtr& msg) {
+  thread_placement_.ApplyToCurrentThread();
+  callback_latency_->AddSample((ros::Time::now() - msg->header.stamp).toSec());
   ROS_INFO_STREAM_ONCE(
       "InertialOdometry received IMU measurements: " << msg->header.stamp);
-  std::unique_lock<std::mutex> lk(mutex_);
+  if (!imu_queue_.Push(msg)) {
+    // the lock has been held for a long time, wait for it to keep the order
+    bs_common::TimedLock lk(mutex_, lock_hold_.get());
+    DrainImuQueue();
+    ProcessImu(msg);
+    return;
+  }
+  ProcessImuQueue();
+}
+
+void InertialOdometry::ProcessImuQueue() {
+  // a thread that finds the lock taken leaves its messages in the queue for
+  // the holder, so check the queue again after each unlock. The fence orders
+  // the push before the check, see processIMU
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!imu_queue_.Empty()) {
+    bs_common::TimedLock lk(mutex_, lock_hold_.get(), std::try_to_lock);
+    if (!lk.owns_lock()) { return; }
+    DrainImuQueue();
+    lk.unlock();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+void InertialOdometry::DrainImuQueue() {
+  imu_queue_.Drain(
+      [this](sensor_msgs::Imu::ConstPtr&& msg) { ProcessImu(msg); });
+}
+
+void InertialOdometry::ProcessImu(const sensor_msgs::Imu::ConstPtr& msg) {
   imu_buffer_.AddData(msg);
+  if (spline_) {
+    AddSplineImuConstraints();
+    return;
+  }
+
   // return if its not initialized_
   if (!initialized_) {
     ROS_INFO_THROTTLE(
@@ -169,11 +274,17 @@ void InertialOdometry::processIMU(const sensor_msgs::Imu::ConstPtr& msg) {
 }
 
 void InertialOdometry::processTrigger(const std_msgs::Time::ConstPtr& msg) {
-  std::unique_lock<std::mutex> lk(mutex_);
-  trigger_buffer_.push_back(msg);
-
-  if (!initialized_) { return; }
+  {
+    bs_common::TimedLock lk(mutex_, lock_hold_.get());
+    // constraints need all imu data up to the trigger
+    DrainImuQueue();
+    trigger_buffer_.push_back(msg);
+    if (initialized_) { ProcessTriggerBuffer(); }
+  }
+  ProcessImuQueue();
+}
 
+void InertialOdometry::ProcessTriggerBuffer() {
   while (!trigger_buffer_.empty()) {
     const auto current_trigger = trigger_buffer_.front();
     const ros::Time& time(current_trigger->data);
@@ -234,10 +345,19 @@ void InertialOdometry::ComputeRelativeMotion(const ros::Time& prev_stamp,
 
 void InertialOdometry::onGraphUpdate(
     fuse_core::Graph::ConstSharedPtr graph_msg) {
-  std::unique_lock<std::mutex> lk(mutex_);
+  bs_common::TimedLock lk(mutex_, lock_hold_.get());
+  DrainImuQueue();
   most_recent_graph_msg_ = graph_msg;
+  if (spline_) {
+    AddSplineImuConstraints();
+    lk.unlock();
+    ProcessImuQueue();
+    return;
+  }
   if (!initialized_) {
     Initialize(graph_msg);
+    lk.unlock();
+    ProcessImuQueue();
     return;
   }
   imu_preint_->UpdateGraph(graph_msg);
@@ -258,10 +378,128 @@ void InertialOdometry::onGraphUpdate(
     std_msgs::Empty reset;
     reset_publisher_.publish(reset);
   }
+
+  // write to disk without blocking the IMU callback
+  lk.unlock();
+  ProcessImuQueue();
+  SaveSnapshot();
+}
+
+void InertialOdometry::AddSplineImuConstraints() {
+  const auto& imu_msgs = imu_buffer_.GetImuMsgs();
+  if (!most_recent_graph_msg_ || imu_msgs.empty()) { return; }
+  const fuse_core::Graph& graph = *most_recent_graph_msg_;
+  const ros::Duration spacing(spline_->KnotSpacing());
+  if (last_spline_knot_.isZero()) {
+    last_spline_knot_ = spline_->GetSegment(imu_msgs.begin()->first).knots[1];
+  }
+
+  Eigen::Matrix<double, 6, 6> covariance = Eigen::Matrix<double, 6, 6>::Zero();
+  covariance.block<3, 3>(0, 0) = imu_params_.cov_gyro_noise;
+  covariance.block<3, 3>(3, 3) = imu_params_.cov_accel_noise;
+  covariance /= params_.inertial_information_weight;
+
+  // only add complete knot intervals, biases are held constant over each
+  while (last_spline_knot_ + spacing <= imu_msgs.rbegin()->first) {
+    const ros::Time start = last_spline_knot_;
+    const ros::Time end = start + spacing;
+    if (!spline_->InGraph(graph, spline_->GetSegment(start))) {
+      // the control points are added by lidar odometry. If later ones are
+      // already in the graph these were marginalized or never added
+      if (spline_->InGraph(graph, spline_->GetSegment(end))) {
+        last_spline_knot_ = end;
+        continue;
+      }
+      break;
+    }
+
+    auto transaction = fuse_core::Transaction::make_shared();
+    transaction->stamp(end);
+    auto bg = bs_variables::GyroscopeBias3DStamped::make_shared(start);
+    auto ba = bs_variables::AccelerationBias3DStamped::make_shared(start);
+    transaction->addVariable(bg);
+    transaction->addVariable(ba);
+    transaction->addInvolvedStamp(start);
+
+    const auto bg_prev = bs_common::GetGyroscopeBias(graph, start - spacing);
+    const auto ba_prev = bs_common::GetAccelBias(graph, start - spacing);
+    const double dt = spacing.toSec();
+    if (bg_prev && ba_prev) {
+      // biases follow a random walk between knot intervals
+      std::copy(bg_prev->data(), bg_prev->data() + 3, bg->data());
+      std::copy(ba_prev->data(), ba_prev->data() + 3, ba->data());
+      transaction->addConstraint(
+          bs_constraints::RelativeGyroBias3DStampedConstraint::make_shared(
+              name(), *bg_prev, *bg, Eigen::Vector3d::Zero(),
+              imu_params_.cov_gyro_bias * dt));
+      transaction->addConstraint(
+          bs_constraints::RelativeAccelBias3DStampedConstraint::make_shared(
+              name(), *ba_prev, *ba, Eigen::Vector3d::Zero(),
+              imu_params_.cov_accel_bias * dt));
+    } else {
+      const Eigen::Matrix3d prior_covariance =
+          Eigen::Matrix3d::Identity() * imu_params_.cov_prior_noise;
+      transaction->addConstraint(
+          bs_constraints::AbsoluteGyroBias3DStampedConstraint::make_shared(
+              name(), *bg, Eigen::Vector3d::Zero(), prior_covariance));
+      transaction->addConstraint(
+          bs_constraints::AbsoluteAccelBias3DStampedConstraint::make_shared(
+              name(), *ba, Eigen::Vector3d::Zero(), prior_covariance));
+    }
+
+    int count = 0;
+    for (const auto& [stamp, msg] : imu_buffer_.GetImuData(start, end)) {
+      if (stamp == end ||
+          count++ % std::max(params_.continuous_time_imu_stride, 1) != 0) {
+        continue;
+      }
+      const Eigen::Vector3d w(msg->angular_velocity.x,
+                              msg->angular_velocity.y,
+                              msg->angular_velocity.z);
+      const Eigen::Vector3d a(msg->linear_acceleration.x,
+                              msg->linear_acceleration.y,
+                              msg->linear_acceleration.z);
+      transaction->addConstraint(
+          bs_constraints::SplineImuConstraint::make_shared(
+              name(), *spline_, stamp, w, a, *bg, *ba, covariance));
+    }
+    sendTransaction(transaction);
+    last_spline_knot_ = end;
+  }
+}
+
+void InertialOdometry::SaveSnapshot() {
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  ImuBuffer imu_buffer;
+  ros::Time stamp;
+  {
+    bs_common::TimedLock lk(mutex_, lock_hold_.get());
+    if (!initialized_ || !snapshot.SaveDue(kImuBufferSnapshot, prev_stamp_)) {
+      return;
+    }
+    imu_buffer = imu_buffer_;
+    stamp = prev_stamp_;
+  }
+  ProcessImuQueue();
+  auto buffer = std::make_shared<const ImuBuffer>(std::move(imu_buffer));
+  snapshot.SaveAsync(kImuBufferSnapshot, stamp,
+                     [buffer](const std::string& directory) {
+                       return buffer->Save(directory);
+                     });
 }
 
 void InertialOdometry::Initialize(fuse_core::Graph::ConstSharedPtr graph_msg) {
   ROS_INFO("InertialOdometry received initial graph.");
+
+  // restore the IMU data from before the restart so we can integrate between
+  // the states of the restored graph
+  if (bs_common::SnapshotManager::GetInstance().WarmStarted()) {
+    bs_common::SnapshotManager::GetInstance().Load(
+        kImuBufferSnapshot, [this](const std::string& directory) {
+          return imu_buffer_.Load(directory);
+        });
+  }
+
   std::set<ros::Time> timestamps = bs_common::CurrentTimestamps(*graph_msg);
 
   // get first state in the graph
@@ -499,8 +737,13 @@ void InertialOdometry::shutdown() {
   prev_stamp_ = ros::Time(0.0);
   T_ODOM_IMUprev_ = Eigen::Matrix4d::Identity();
   trigger_buffer_.clear();
+  {
+    bs_common::TimedLock lk(mutex_, lock_hold_.get());
+    imu_queue_.Drain([](sensor_msgs::Imu::ConstPtr&&) {});
+  }
   imu_buffer_ = ImuBuffer();
-  imu_preint_->Reset();
+  last_spline_knot_ = ros::Time(0);
+  if (imu_preint_) { imu_preint_->Reset(); }
 }
 
 } // namespace bs_models
\ No newline at end of file
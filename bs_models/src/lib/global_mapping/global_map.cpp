@@ -85,6 +85,16 @@ void GlobalMap::Params::LoadJson(const std::string& config_path) {
     loop_closure_covariance = vec_eig.asDiagonal();
   }
 
+  // optional, older configs do not have it
+  if (J.find("dynamic_point_filter_config") != J.end()) {
+    std::string dynamic_point_filter_config_rel =
+        J["dynamic_point_filter_config"];
+    if (!dynamic_point_filter_config_rel.empty()) {
+      dynamic_point_filter_config = beam::CombinePaths(
+          bs_common::GetBeamSlamConfigPath(), dynamic_point_filter_config_rel);
+    }
+  }
+
   // load filters
   nlohmann::json J_publishing = J["publishing"];
 
@@ -239,6 +249,13 @@ void GlobalMap::Setup() {
   // initiate loop_closure refinement
   loop_closure_refinement_ = reloc::RelocRefinementBase::Create(
       params_.loop_closure_refinement_config);
+
+  DynamicPointFilter::Params dynamic_point_filter_params;
+  if (!params_.dynamic_point_filter_config.empty()) {
+    dynamic_point_filter_params.LoadFromJson(
+        params_.dynamic_point_filter_config);
+  }
+  dynamic_point_filter_ = DynamicPointFilter(dynamic_point_filter_params);
 }
 
 fuse_core::Transaction::SharedPtr GlobalMap::AddMeasurement(
@@ -257,6 +274,15 @@ fuse_core::Transaction::SharedPtr GlobalMap::AddMeasurement(
     submaps_.push_back(new_submap);
     new_transaction = InitiateNewSubmapPose();
 
+    // remove moving objects from the completed submap before it is used for
+    // loop closure or published
+    if (dynamic_point_filter_.Enabled() && submaps_.size() > 1) {
+      size_t num_removed = submaps_.at(submaps_.size() - 2)
+                               ->RemoveDynamicPoints(dynamic_point_filter_);
+      ROS_DEBUG("Removed %zu dynamic points from completed submap.",
+                num_removed);
+    }
+
     // Run loop closure on the previously completed submap. Current submap is
     // size -1, therefore the last is size - 2
     fuse_core::Transaction::SharedPtr loop_closure_transaction =
@@ -1,9 +1,23 @@
 #include <bs_models/global_mapping/global_map_refinement.h>
 
 #include <filesystem>
+#include <sstream>
 
 namespace bs_models::global_mapping {
 
+namespace {
+
+const std::string kCheckpointFilename = "checkpoint.json";
+
+uint64_t HashCovariance(const Eigen::Matrix<double, 6, 6>& covariance,
+                        uint64_t seed) {
+  std::stringstream ss;
+  ss << std::setprecision(17) << covariance;
+  return HashBytes(ss.str(), seed);
+}
+
+} // namespace
+
 void GlobalMapRefinement::Params::LoadJson(const std::string& config_path) {
   // Read json
   if (config_path.empty()) {
@@ -189,6 +203,13 @@ void GlobalMapRefinement::Initialize() {
 }
 
 bool GlobalMapRefinement::RunSubmapRefinement(const std::string& output_path) {
+  const auto& params = params_.submap_refinement;
+  if (SkipStep("submap_refinement",
+               HashFile(params.matcher_config,
+                        HashFile(params.scan_registration_config)))) {
+    return true;
+  }
+
   if (!output_path.empty()) {
     global_map_->SaveTrajectoryClouds(output_path, false);
     std::filesystem::rename(
@@ -207,14 +228,21 @@ bool GlobalMapRefinement::RunSubmapRefinement(const std::string& output_path) {
         beam::CombinePaths(output_path, "global_map_trajectory_optimized.pcd"),
         beam::CombinePaths(output_path, "trajectory_final.pcd"));
   }
+  SaveCheckpoint();
   return true;
 }
 
 bool GlobalMapRefinement::RunSubmapAlignment(const std::string& output_path) {
+  if (SkipStep("submap_alignment",
+               HashFile(params_.submap_alignment.matcher_config))) {
+    return true;
+  }
+
   std::vector<SubmapPtr> submaps = global_map_->GetSubmaps();
   if (submaps.size() < 2) {
     BEAM_WARN(
         "Not enough submaps to run submap alignment, at least two are needed");
+    SaveCheckpoint();
     return true;
   }
 
@@ -235,12 +263,19 @@ bool GlobalMapRefinement::RunSubmapAlignment(const std::string& output_path) {
         beam::CombinePaths(output_path, "global_map_trajectory_optimized.pcd"),
         beam::CombinePaths(output_path, "trajectory_final.pcd"));
   }
-
+  SaveCheckpoint();
   return true;
 }
 
 bool GlobalMapRefinement::RunPoseGraphOptimization(
     const std::string& output_path) {
+  const auto& params = params_.submap_pgo;
+  uint64_t params_hash = HashFile(params.candidate_search_config);
+  params_hash = HashFile(params.refinement_config, params_hash);
+  params_hash = HashCovariance(params.loop_closure_covariance, params_hash);
+  params_hash = HashCovariance(params.local_mapper_covariance, params_hash);
+  if (SkipStep("posegraph_optimization", params_hash)) { return true; }
+
   if (!output_path.empty()) {
     global_map_->SaveTrajectoryClouds(output_path, false);
     std::filesystem::rename(
@@ -258,11 +293,22 @@ bool GlobalMapRefinement::RunPoseGraphOptimization(
         beam::CombinePaths(output_path, "global_map_trajectory_optimized.pcd"),
         beam::CombinePaths(output_path, "trajectory_final.pcd"));
   }
-
+  SaveCheckpoint();
   return true;
 }
 
 bool GlobalMapRefinement::RunBatchOptimization(const std::string& output_path) {
+  const auto& params = params_.batch;
+  std::stringstream ss;
+  ss << std::setprecision(17) << params.update_graph_on_all_scans << " "
+     << params.update_graph_on_all_lcs << " " << params.lc_dist_thresh_m << " "
+     << params.lc_min_traj_dist_m << " " << params.lc_max_per_query_scan << " "
+     << params.lc_scan_context_dist_thres << " " << params.lc_cov_multiplier;
+  uint64_t params_hash = HashFile(params.matcher_config);
+  params_hash = HashFile(params.scan_registration_config, params_hash);
+  params_hash = HashBytes(ss.str(), params_hash);
+  if (SkipStep("batch_optimization", params_hash)) { return true; }
+
   if (!output_path.empty()) {
     global_map_->SaveTrajectoryClouds(output_path, false);
     std::filesystem::rename(
@@ -281,7 +327,7 @@ bool GlobalMapRefinement::RunBatchOptimization(const std::string& output_path) {
         beam::CombinePaths(output_path, "global_map_trajectory_optimized.pcd"),
         beam::CombinePaths(output_path, "trajectory_final.pcd"));
   }
-
+  SaveCheckpoint();
   return true;
 }
 
@@ -297,6 +343,7 @@ void GlobalMapRefinement::SaveResults(const std::string& output_path,
   }
 
   // save
+  RestoreCheckpoint();
   summary_.Save(output_path);
   global_map_->SaveTrajectoryFile(output_path, save_initial);
   global_map_->SaveTrajectoryClouds(output_path, save_initial);
@@ -320,7 +367,72 @@ void GlobalMapRefinement::SaveGlobalMapData(const std::string& output_path) {
   boost::filesystem::create_directory(save_dir);
 
   // save
+  RestoreCheckpoint();
   global_map_->SaveData(save_dir);
 }
 
+void GlobalMapRefinement::EnableCheckpoints(const std::string& checkpoint_dir,
+                                            uint64_t input_hash) {
+  checkpoint_dir_ = checkpoint_dir;
+  std::filesystem::create_directories(checkpoint_dir_);
+  num_steps_ = 0;
+  checkpoint_to_restore_.clear();
+
+  // submaps may have been resized on construction
+  std::stringstream ss;
+  ss << std::setprecision(17) << params_.resize.apply << " "
+     << params_.resize.target_submap_length_m;
+  checkpoint_hash_ = HashBytes(ss.str(), input_hash);
+}
+
+bool GlobalMapRefinement::SkipStep(const std::string& step,
+                                   uint64_t params_hash) {
+  if (checkpoint_dir_.empty()) { return false; }
+
+  // steps are numbered so the same step can be run more than once
+  checkpoint_hash_ =
+      HashBytes(step + std::to_string(params_hash), checkpoint_hash_);
+  current_step_dir_ = beam::CombinePaths(
+      checkpoint_dir_, std::to_string(num_steps_++) + "_" + step);
+
+  nlohmann::json J;
+  std::string checkpoint_path =
+      beam::CombinePaths(current_step_dir_, kCheckpointFilename);
+  if (std::filesystem::exists(checkpoint_path) &&
+      beam::ReadJson(checkpoint_path, J) && J.contains("hash") &&
+      J["hash"].get<uint64_t>() == checkpoint_hash_) {
+    BEAM_INFO("Inputs to {} unchanged since checkpoint, skipping step.", step);
+    checkpoint_to_restore_ =
+        beam::CombinePaths(current_step_dir_, "GlobalMapData");
+    return true;
+  }
+
+  RestoreCheckpoint();
+  return false;
+}
+
+void GlobalMapRefinement::RestoreCheckpoint() {
+  if (checkpoint_to_restore_.empty()) { return; }
+  BEAM_INFO("Restoring global map from checkpoint: {}",
+            checkpoint_to_restore_);
+  GlobalMap checkpoint(checkpoint_to_restore_);
+  global_map_->SetSubmaps(checkpoint.GetSubmaps());
+  checkpoint_to_restore_.clear();
+}
+
+void GlobalMapRefinement::SaveCheckpoint() {
+  if (checkpoint_dir_.empty()) { return; }
+  std::filesystem::remove_all(current_step_dir_);
+  std::string data_dir = beam::CombinePaths(current_step_dir_, "GlobalMapData");
+  std::filesystem::create_directories(data_dir);
+  global_map_->SaveData(data_dir);
+
+  // the hash is written last so that partially saved checkpoints are not used
+  nlohmann::json J;
+  J["hash"] = checkpoint_hash_;
+  std::ofstream file(
+      beam::CombinePaths(current_step_dir_, kCheckpointFilename));
+  file << std::setw(4) << J << std::endl;
+}
+
 } // namespace bs_models::global_mapping
\ No newline at end of file
@@ -459,6 +459,61 @@ beam_matching::LoamPointCloud
   return map;
 }
 
+size_t Submap::RemoveDynamicPoints(const DynamicPointFilter& filter) {
+  const auto& params = filter.GetParams();
+  std::vector<std::map<uint64_t, ScanPose>::iterator> keyframes;
+  std::vector<std::shared_ptr<const DynamicPointFilter::VisibilityImage>>
+      images;
+  for (auto it = lidar_keyframe_poses_.begin();
+       it != lidar_keyframe_poses_.end(); it++) {
+    keyframes.push_back(it);
+    const PointCloud& cloud = it->second.Cloud();
+    images.push_back(cloud.empty()
+                         ? filter.BuildImage(it->second.LoamCloud())
+                         : filter.BuildImage(cloud));
+  }
+
+  // points are checked in the frame of their own keyframe, so the views are
+  // relative to it and clouds do not need to be transformed
+  size_t num_removed{0};
+  const int num_keyframes = keyframes.size();
+  for (int i = 0; i < num_keyframes; i++) {
+    const Eigen::Matrix4d T_SUBMAP_LIDARI =
+        keyframes[i]->second.T_REFFRAME_LIDAR();
+
+    // closest keyframes in time, alternating after and before
+    std::vector<DynamicPointFilter::View> views;
+    for (int offset = 1; offset < num_keyframes &&
+                         views.size() < static_cast<size_t>(params.max_views);
+         offset++) {
+      for (int j : {i + offset, i - offset}) {
+        if (j < 0 || j >= num_keyframes ||
+            views.size() >= static_cast<size_t>(params.max_views)) {
+          continue;
+        }
+        const Eigen::Matrix4d T_LIDARJ_LIDARI =
+            beam::InvertTransform(keyframes[j]->second.T_REFFRAME_LIDAR()) *
+            T_SUBMAP_LIDARI;
+        views.push_back(DynamicPointFilter::View{T_LIDARJ_LIDARI, images[j]});
+      }
+    }
+
+    ScanPose& scan_pose = keyframes[i]->second;
+    PointCloud cloud = scan_pose.Cloud();
+    const size_t num_removed_cloud =
+        filter.RemoveSeenThrough(cloud, views, params.min_free_observations);
+    if (num_removed_cloud > 0) { scan_pose.AddPointCloud(cloud, true); }
+
+    beam_matching::LoamPointCloud loam_cloud = scan_pose.LoamCloud();
+    const size_t num_removed_loam = filter.RemoveSeenThrough(
+        loam_cloud, views, params.min_free_observations);
+    if (num_removed_loam > 0) { scan_pose.AddPointCloud(loam_cloud, true); }
+
+    num_removed += num_removed_cloud + num_removed_loam;
+  }
+  return num_removed;
+}
+
 std::vector<Submap::PoseStamped>
     Submap::GetTrajectory(bool use_initials) const {
   // first we create an ordered map so we can easily make sure poses are in
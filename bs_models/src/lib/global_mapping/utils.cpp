@@ -1,5 +1,8 @@
 #include <bs_models/global_mapping/utils.h>
 
+#include <filesystem>
+#include <fstream>
+
 #include <beam_filtering/CropBox.h>
 #include <beam_filtering/VoxelDownsample.h>
 
@@ -116,4 +119,49 @@ void UpdateSubmapPosesFromGraph(std::vector<SubmapPtr> submaps,
   }
 }
 
-} // namespace bs_models::global_mapping
\ No newline at end of file
+namespace {
+
+uint64_t HashBytes(const char* data, size_t size, uint64_t seed) {
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+} // namespace
+
+uint64_t HashBytes(const std::string& data, uint64_t seed) {
+  return HashBytes(data.data(), data.size(), seed);
+}
+
+uint64_t HashFile(const std::string& path, uint64_t seed) {
+  std::ifstream file(path, std::ios::binary);
+  if (path.empty() || !file.good()) { return HashBytes(path, seed); }
+  uint64_t hash = seed;
+  std::vector<char> buffer(1 << 20);
+  while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+    hash = HashBytes(buffer.data(), file.gcount(), hash);
+  }
+  return hash;
+}
+
+uint64_t HashDirectory(const std::string& directory, uint64_t seed) {
+  std::vector<std::filesystem::path> files;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator(directory)) {
+    if (entry.is_regular_file()) { files.push_back(entry.path()); }
+  }
+  std::sort(files.begin(), files.end());
+
+  uint64_t hash = seed;
+  for (const auto& file : files) {
+    // hash the relative path so the directory can be moved
+    hash = HashBytes(std::filesystem::relative(file, directory).string(), hash);
+    hash = HashFile(file.string(), hash);
+  }
+  return hash;
+}
+
+} // namespace bs_models::global_mapping
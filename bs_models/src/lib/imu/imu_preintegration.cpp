@@ -47,6 +47,9 @@ ImuPreintegration::ImuPreintegration(const std::string& source,
       add_prior_on_first_window_(add_prior_on_first_window) {
   CheckParameters();
   SetPreintegrator();
+  lock_hold_ =
+      bs_common::JitterMonitor::Create(source_ + " Preintegration Lock");
+  PublishSnapshot(imu_state_i_);
 }
 
 ImuPreintegration::ImuPreintegration(const std::string& source,
@@ -63,6 +66,9 @@ ImuPreintegration::ImuPreintegration(const std::string& source,
       add_prior_on_first_window_(add_prior_on_first_window) {
   CheckParameters();
   SetPreintegrator();
+  lock_hold_ =
+      bs_common::JitterMonitor::Create(source_ + " Preintegration Lock");
+  PublishSnapshot(imu_state_i_);
 }
 
 void ImuPreintegration::CheckParameters() {
@@ -81,24 +87,47 @@ void ImuPreintegration::SetPreintegrator() {
   pre_integrator_kj_ = pre_integrator_ij_;
 }
 
+void ImuPreintegration::DrainBuffer() {
+  buffer_.Drain([this](bs_common::IMUData&& imu_data) {
+    pre_integrator_ij_.data.emplace(imu_data.t, imu_data);
+    pre_integrator_kj_.data.emplace(imu_data.t, imu_data);
+  });
+}
+
+void ImuPreintegration::PublishSnapshot(const bs_common::ImuState& latest) {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->imu_state_i = imu_state_i_;
+  snapshot->latest = latest;
+  std::atomic_store(&snapshot_,
+                    std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+std::shared_ptr<const ImuPreintegration::Snapshot>
+    ImuPreintegration::GetSnapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
 void ImuPreintegration::AddToBuffer(const sensor_msgs::Imu& msg) {
   bs_common::IMUData imu_data(msg);
   AddToBuffer(imu_data);
 }
 
 void ImuPreintegration::AddToBuffer(const bs_common::IMUData& imu_data) {
-  std::unique_lock<std::mutex> lk(preint_mutex_);
-  pre_integrator_ij_.data.emplace(imu_data.t, imu_data);
-  pre_integrator_kj_.data.emplace(imu_data.t, imu_data);
+  if (buffer_.Push(imu_data)) { return; }
+  // nothing has drained the buffer for a while, do it here
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
+  buffer_.Push(imu_data);
 }
 
 PoseWithCovariance ImuPreintegration::GetPose(const ros::Time& t_now) {
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
   if (t_now < imu_state_k_.Stamp()) {
     throw std::runtime_error{
         "Requested time is before current imu state. Request a "
         "pose at a timestamp >= the most recent imu measurement"};
   }
-  std::unique_lock<std::mutex> lk(preint_mutex_);
+  DrainBuffer();
   // integrate between frames if there is data to integrate
   if (!pre_integrator_kj_.data.empty()) {
     pre_integrator_kj_.Integrate(t_now, imu_state_i_.GyroBiasVec(),
@@ -117,6 +146,7 @@ PoseWithCovariance ImuPreintegration::GetPose(const ros::Time& t_now) {
   // remove data in buffer that is before the new state k
   pre_integrator_kj_.Clear(t_now);
   pre_integrator_kj_.Reset();
+  PublishSnapshot(imu_state_k_);
 
   // extract the computed covariance if requested
   Eigen::Matrix<double, 6, 6> covariance =
@@ -126,6 +156,8 @@ PoseWithCovariance ImuPreintegration::GetPose(const ros::Time& t_now) {
 
 PoseWithCovariance ImuPreintegration::GetRelativeMotion(
     const ros::Time& t1, const ros::Time& t2, Eigen::Vector3d& velocity_t2) {
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   if (pre_integrator_ij_.data.empty()) {
     throw std::runtime_error{
         "No data in preintegrator, cannot retrieve relative motion."};
@@ -143,7 +175,6 @@ PoseWithCovariance ImuPreintegration::GetRelativeMotion(
   } else if (t1 >= t2) {
     throw std::runtime_error{"Start time of window must precede end times."};
   }
-  std::unique_lock<std::mutex> lk(preint_mutex_);
   // get state at t1
   bs_common::ImuState imu_state_1;
   if (window_states_.find(t1.toNSec()) == window_states_.end()) {
@@ -169,6 +200,7 @@ PoseWithCovariance ImuPreintegration::GetRelativeMotion(
 
   // store for potential next t1
   window_states_.emplace(t2.toNSec(), imu_state_2);
+  PublishSnapshot(imu_state_2);
 
   // get poses at each state
   Eigen::Matrix4d T_WORLD_IMUSTATE2;
@@ -198,7 +230,8 @@ void ImuPreintegration::SetStart(
     fuse_variables::Orientation3DStamped::SharedPtr R_WORLD_IMU,
     fuse_variables::Position3DStamped::SharedPtr t_WORLD_IMU,
     fuse_variables::VelocityLinear3DStamped::SharedPtr velocity) {
-  std::unique_lock<std::mutex> lk(preint_mutex_);
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   // remove data in buffer that is before the start state
   pre_integrator_ij_.Clear(t_start);
   pre_integrator_ij_.Reset();
@@ -215,6 +248,7 @@ void ImuPreintegration::SetStart(
 
   imu_state_i_ = imu_state_i;
   imu_state_k_ = imu_state_i;
+  PublishSnapshot(imu_state_k_);
 }
 
 bs_common::ImuState ImuPreintegration::PredictState(
@@ -250,7 +284,8 @@ fuse_core::Transaction::SharedPtr
         fuse_variables::Position3DStamped::SharedPtr t_WORLD_IMU,
         fuse_variables::VelocityLinear3DStamped::SharedPtr velocity) {
   bs_constraints::ImuState3DStampedTransaction transaction(t_now);
-  std::unique_lock<std::mutex> lk(preint_mutex_);
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   // check requested time
   if (pre_integrator_ij_.data.empty()) {
     ROS_WARN("Cannot register IMU factor, no imu data is available.");
@@ -316,12 +351,14 @@ fuse_core::Transaction::SharedPtr
 
   // clear state storage within the window
   window_states_.clear();
+  PublishSnapshot(imu_state_k_);
   return transaction.GetTransaction();
 }
 
 void ImuPreintegration::UpdateGraph(
     fuse_core::Graph::ConstSharedPtr graph_msg) {
-  std::unique_lock<std::mutex> lk(preint_mutex_);
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   // update state i with all info, reset state k to updated state i
   if (imu_state_i_.Update(graph_msg)) {
     // reset kj integrator to the ij integrator
@@ -333,6 +370,7 @@ void ImuPreintegration::UpdateGraph(
   }
   // clear state storage within the window
   window_states_.clear();
+  PublishSnapshot(imu_state_k_);
 }
 
 void ImuPreintegration::UpdateState(
@@ -341,16 +379,19 @@ void ImuPreintegration::UpdateState(
     const fuse_variables::VelocityLinear3DStamped velocity,
     const bs_variables::GyroscopeBias3DStamped gyro_bias,
     const bs_variables::AccelerationBias3DStamped accel_bias) {
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
   imu_state_i_.SetStamp(position.stamp());
   imu_state_i_.SetPosition(position);
   imu_state_i_.SetOrientation(orientation);
   imu_state_i_.SetVelocity(velocity);
   imu_state_i_.SetGyroBias(gyro_bias);
   imu_state_i_.SetAccelBias(accel_bias);
+  PublishSnapshot(imu_state_k_);
 }
 
 void ImuPreintegration::Clear() {
-  std::unique_lock<std::mutex> lk(preint_mutex_);
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   pre_integrator_kj_.data.clear();
   pre_integrator_kj_.Reset();
   pre_integrator_ij_.data.clear();
@@ -358,6 +399,8 @@ void ImuPreintegration::Clear() {
 }
 
 std::string ImuPreintegration::PrintBuffer() {
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   std::string str;
   for (const auto& [t, _] : pre_integrator_ij_.data) {
     str += "IMU time: " + std::to_string(t.toSec()) + "\n";
@@ -366,11 +409,14 @@ std::string ImuPreintegration::PrintBuffer() {
 }
 
 size_t ImuPreintegration::CurrentBufferSize() {
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
+  DrainBuffer();
   return pre_integrator_ij_.data.size();
 }
 
 void ImuPreintegration::Reset() {
   Clear();
+  bs_common::TimedLock lk(preint_mutex_, lock_hold_.get());
   window_states_.clear();
   first_window_ = true;
 }
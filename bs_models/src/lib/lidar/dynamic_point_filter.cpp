@@ -0,0 +1,213 @@
+#include <bs_models/lidar/dynamic_point_filter.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_models {
+
+using namespace beam_matching;
+
+void DynamicPointFilter::Params::LoadFromJson(const std::string& config) {
+  if (!boost::filesystem::exists(config)) {
+    BEAM_ERROR("Invalid dynamic point filter config path, file does not "
+               "exist: {}",
+               config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+
+  nlohmann::json J;
+  if (!beam::ReadJson(config, J)) {
+    BEAM_ERROR("Unable to read dynamic point filter config: {}", config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+  beam::ValidateJsonKeysOrThrow(
+      {"enabled", "azimuth_resolution_deg", "elevation_resolution_deg",
+       "min_elevation_deg", "max_elevation_deg", "min_range_m", "max_range_m",
+       "free_space_margin_m", "free_space_margin_ratio",
+       "min_free_observations", "max_views"},
+      J);
+
+  enabled = J["enabled"];
+  azimuth_resolution_deg = J["azimuth_resolution_deg"];
+  elevation_resolution_deg = J["elevation_resolution_deg"];
+  min_elevation_deg = J["min_elevation_deg"];
+  max_elevation_deg = J["max_elevation_deg"];
+  min_range_m = J["min_range_m"];
+  max_range_m = J["max_range_m"];
+  free_space_margin_m = J["free_space_margin_m"];
+  free_space_margin_ratio = J["free_space_margin_ratio"];
+  min_free_observations = J["min_free_observations"];
+  max_views = J["max_views"];
+
+  if (azimuth_resolution_deg <= 0 || elevation_resolution_deg <= 0 ||
+      max_elevation_deg <= min_elevation_deg) {
+    BEAM_ERROR("Invalid dynamic point filter image size, resolutions must be "
+               "positive and max_elevation_deg > min_elevation_deg");
+    throw std::runtime_error{"invalid dynamic point filter params"};
+  }
+  if (min_free_observations < 1 || max_views < 1) {
+    BEAM_ERROR("min_free_observations and max_views must be at least 1");
+    throw std::runtime_error{"invalid dynamic point filter params"};
+  }
+}
+
+DynamicPointFilter::VisibilityImage::VisibilityImage(const Params& params)
+    : params_(params) {
+  rows_ = static_cast<int>(
+      std::ceil((params_.max_elevation_deg - params_.min_elevation_deg) /
+                params_.elevation_resolution_deg));
+  cols_ = static_cast<int>(std::ceil(360.0 / params_.azimuth_resolution_deg));
+  ranges_.assign(rows_ * cols_, 0);
+}
+
+bool DynamicPointFilter::VisibilityImage::Project(float x, float y, float z,
+                                                  float& range, float& row,
+                                                  int& col) const {
+  range = std::sqrt(x * x + y * y + z * z);
+  if (range < params_.min_range_m || range > params_.max_range_m) {
+    return false;
+  }
+  const float elevation = std::asin(z / range) * 180 / M_PI;
+  row = (elevation - params_.min_elevation_deg) /
+        params_.elevation_resolution_deg;
+  const float azimuth = std::atan2(y, x) * 180 / M_PI + 180;
+  col = static_cast<int>(azimuth / params_.azimuth_resolution_deg) % cols_;
+  return true;
+}
+
+void DynamicPointFilter::VisibilityImage::AddReturn(float x, float y,
+                                                    float z) {
+  float range;
+  float row_f;
+  int col;
+  if (!Project(x, y, z, range, row_f, col)) { return; }
+  const int row = static_cast<int>(std::floor(row_f));
+  if (row < 0 || row >= rows_) { return; }
+  float& current = ranges_[row * cols_ + col];
+  if (current == 0 || range < current) { current = range; }
+}
+
+void DynamicPointFilter::VisibilityImage::Finalize() {
+  // each cell takes the minimum of itself and its horizontal neighbors, where
+  // an empty neighbor (0) makes the cell unknown
+  std::vector<float> row_ranges(cols_);
+  for (int row = 0; row < rows_; row++) {
+    float* r = &ranges_[row * cols_];
+    std::copy(r, r + cols_, row_ranges.begin());
+    for (int col = 0; col < cols_; col++) {
+      const float left = row_ranges[(col + cols_ - 1) % cols_];
+      const float right = row_ranges[(col + 1) % cols_];
+      r[col] = std::min({row_ranges[col], left, right});
+    }
+  }
+}
+
+bool DynamicPointFilter::VisibilityImage::IsFree(float x, float y,
+                                                 float z) const {
+  float range;
+  float row_f;
+  int col;
+  if (!Project(x, y, z, range, row_f, col)) { return false; }
+
+  // returns are sampled at the center of each row, so the point must be in
+  // front of the rows above and below it. Otherwise the ground seen at a
+  // grazing angle would look free between two rings
+  const int lower = static_cast<int>(std::floor(row_f - 0.5f));
+  const int upper = lower + 1;
+  if (lower < 0 || upper >= rows_) { return false; }
+  const float measured = std::min(ranges_[lower * cols_ + col],
+                                  ranges_[upper * cols_ + col]);
+  return measured > range + params_.free_space_margin_m +
+                        params_.free_space_margin_ratio * range;
+}
+
+DynamicPointFilter::DynamicPointFilter(const Params& params)
+    : params_(params) {}
+
+template <typename PointT>
+void DynamicPointFilter::AddReturns(
+    VisibilityImage& image, const pcl::PointCloud<PointT>& cloud) const {
+  for (const auto& p : cloud) { image.AddReturn(p.x, p.y, p.z); }
+}
+
+std::shared_ptr<const DynamicPointFilter::VisibilityImage>
+    DynamicPointFilter::BuildImage(const PointCloud& cloud) const {
+  auto image = std::make_shared<VisibilityImage>(params_);
+  AddReturns(*image, cloud);
+  image->Finalize();
+  return image;
+}
+
+std::shared_ptr<const DynamicPointFilter::VisibilityImage>
+    DynamicPointFilter::BuildImage(const LoamPointCloud& cloud) const {
+  auto image = std::make_shared<VisibilityImage>(params_);
+  AddReturns(*image, cloud.edges.strong.cloud);
+  AddReturns(*image, cloud.edges.weak.cloud);
+  AddReturns(*image, cloud.surfaces.strong.cloud);
+  AddReturns(*image, cloud.surfaces.weak.cloud);
+  image->Finalize();
+  return image;
+}
+
+template <typename PointT>
+size_t DynamicPointFilter::RemoveSeenThroughImpl(
+    pcl::PointCloud<PointT>& cloud, const std::vector<View>& views,
+    int min_observations) const {
+  if (views.size() < static_cast<size_t>(min_observations)) { return 0; }
+
+  std::vector<Eigen::Matrix4f> T_Scan_Map;
+  for (const auto& view : views) {
+    T_Scan_Map.push_back(view.T_Scan_Map.cast<float>());
+  }
+
+  size_t num_kept{0};
+  for (size_t i = 0; i < cloud.size(); i++) {
+    const PointT& p = cloud[i];
+    int num_free{0};
+    for (size_t v = 0; v < views.size() && num_free < min_observations; v++) {
+      const Eigen::Matrix4f& T = T_Scan_Map[v];
+      const float x = T(0, 0) * p.x + T(0, 1) * p.y + T(0, 2) * p.z + T(0, 3);
+      const float y = T(1, 0) * p.x + T(1, 1) * p.y + T(1, 2) * p.z + T(1, 3);
+      const float z = T(2, 0) * p.x + T(2, 1) * p.y + T(2, 2) * p.z + T(2, 3);
+      if (views[v].image->IsFree(x, y, z)) { num_free++; }
+    }
+    if (num_free < min_observations) { cloud[num_kept++] = p; }
+  }
+
+  const size_t num_removed = cloud.size() - num_kept;
+  if (num_removed > 0) {
+    cloud.resize(num_kept);
+    cloud.width = num_kept;
+    cloud.height = 1;
+  }
+  return num_removed;
+}
+
+size_t DynamicPointFilter::RemoveSeenThrough(PointCloud& cloud,
+                                             const std::vector<View>& views,
+                                             int min_observations) const {
+  return RemoveSeenThroughImpl(cloud, views, min_observations);
+}
+
+size_t DynamicPointFilter::RemoveSeenThrough(LoamPointCloud& cloud,
+                                             const std::vector<View>& views,
+                                             int min_observations) const {
+  size_t num_removed{0};
+  num_removed +=
+      RemoveSeenThroughImpl(cloud.edges.strong.cloud, views, min_observations);
+  num_removed +=
+      RemoveSeenThroughImpl(cloud.edges.weak.cloud, views, min_observations);
+  num_removed += RemoveSeenThroughImpl(cloud.surfaces.strong.cloud, views,
+                                       min_observations);
+  num_removed += RemoveSeenThroughImpl(cloud.surfaces.weak.cloud, views,
+                                       min_observations);
+  return num_removed;
+}
+
+} // namespace bs_models
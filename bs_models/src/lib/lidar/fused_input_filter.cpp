@@ -0,0 +1,274 @@
+#include <bs_models/lidar/fused_input_filter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_models {
+
+namespace {
+
+// voxel coordinates are packed into 21 bits each, ordered z, y, x so that
+// sorting by key gives the same order as pcl's voxel grid
+constexpr int kVoxelBits = 21;
+constexpr int64_t kVoxelBias = int64_t(1) << (kVoxelBits - 1);
+constexpr int64_t kVoxelMax = (int64_t(1) << kVoxelBits) - 1;
+
+struct Centroid {
+  float x{0};
+  float y{0};
+  float z{0};
+  float intensity{0};
+  float time{0};
+  float ring{0};
+};
+
+int GetRing(const pcl::PointXYZ& p) {
+  return -1;
+}
+
+template <typename PointT>
+int GetRing(const PointT& p) {
+  return p.ring;
+}
+
+void AddFields(Centroid& c, const pcl::PointXYZ& p) {}
+
+template <typename PointT>
+void AddFields(Centroid& c, const PointT& p) {
+  c.intensity += p.intensity;
+  c.time += p.time;
+  c.ring += p.ring;
+}
+
+void SetFields(pcl::PointXYZ& p, const Centroid& c, float n) {}
+
+template <typename PointT>
+void SetFields(PointT& p, const Centroid& c, float n) {
+  p.intensity = c.intensity / n;
+  p.time = c.time / n;
+  p.ring = static_cast<uint16_t>(c.ring / n);
+}
+
+} // namespace
+
+bool FusedInputFilter::PointFilter::Keep(float x, float y, float z,
+                                         int ring) const {
+  switch (type) {
+    case Type::CROPBOX: {
+      const bool inside = x >= min[0] && x <= max[0] && y >= min[1] &&
+                          y <= max[1] && z >= min[2] && z <= max[2];
+      return inside == remove_outside_points;
+    }
+    case Type::RANGE: {
+      const float range_sq = x * x + y * y + z * z;
+      return range_sq >= min[0] * min[0] && range_sq <= max[0] * max[0];
+    }
+    case Type::RING_DECIMATION:
+      return ring < 0 || ring % ring_step == 0;
+  }
+  return true;
+}
+
+bool FusedInputFilter::LoadFromJson(const nlohmann::json& J_filters) {
+  pre_voxel_.clear();
+  post_voxel_.clear();
+  use_voxel_ = false;
+
+  for (const auto& J : J_filters) {
+    beam::ValidateJsonKeysOrThrow({"filter_type"}, J);
+    const std::string type = J["filter_type"];
+    PointFilter filter;
+    if (type == "CROPBOX") {
+      beam::ValidateJsonKeysOrThrow({"min", "max", "remove_outside_points"},
+                                    J);
+      std::vector<float> min = J["min"];
+      std::vector<float> max = J["max"];
+      if (min.size() != 3 || max.size() != 3) {
+        BEAM_ERROR("Invalid cropbox filter, min and max must have 3 values.");
+        throw std::runtime_error{"invalid cropbox filter"};
+      }
+      filter.type = PointFilter::Type::CROPBOX;
+      std::copy(min.begin(), min.end(), filter.min);
+      std::copy(max.begin(), max.end(), filter.max);
+      filter.remove_outside_points = J["remove_outside_points"];
+    } else if (type == "RANGE") {
+      beam::ValidateJsonKeysOrThrow({"min_range", "max_range"}, J);
+      filter.type = PointFilter::Type::RANGE;
+      filter.min[0] = J["min_range"];
+      filter.max[0] = J["max_range"];
+    } else if (type == "RING_DECIMATION") {
+      beam::ValidateJsonKeysOrThrow({"ring_step"}, J);
+      filter.type = PointFilter::Type::RING_DECIMATION;
+      filter.ring_step = std::max(J["ring_step"].get<int>(), 1);
+    } else if (type == "VOXEL") {
+      beam::ValidateJsonKeysOrThrow({"cell_size"}, J);
+      std::vector<float> cell_size = J["cell_size"];
+      if (use_voxel_ || cell_size.size() != 3) {
+        BEAM_WARN("Cannot fuse voxel filter, using chained filters.");
+        return false;
+      }
+      for (int i = 0; i < 3; i++) {
+        inverse_cell_size_[i] = 1.0f / cell_size[i];
+      }
+      use_voxel_ = true;
+      continue;
+    } else {
+      BEAM_INFO("Cannot fuse filter type {}, using chained filters.", type);
+      return false;
+    }
+    if (use_voxel_) {
+      post_voxel_.push_back(filter);
+    } else {
+      pre_voxel_.push_back(filter);
+    }
+  }
+  return true;
+}
+
+bool FusedInputFilter::Empty() const {
+  return pre_voxel_.empty() && post_voxel_.empty() && !use_voxel_;
+}
+
+void FusedInputFilter::Filter(const PointCloud& input, PointCloud& output) {
+  FilterImpl(input, output);
+}
+
+void FusedInputFilter::Filter(const pcl::PointCloud<PointXYZIRT>& input,
+                              pcl::PointCloud<PointXYZIRT>& output) {
+  FilterImpl(input, output);
+}
+
+void FusedInputFilter::Filter(const pcl::PointCloud<PointXYZITRRNR>& input,
+                              pcl::PointCloud<PointXYZITRRNR>& output) {
+  FilterImpl(input, output);
+}
+
+void FusedInputFilter::FilterOrganized(
+    const pcl::PointCloud<PointXYZIRT>& input,
+    pcl::PointCloud<PointXYZIRT>& output) {
+  FilterOrganizedImpl(input, output);
+}
+
+void FusedInputFilter::FilterOrganized(
+    const pcl::PointCloud<PointXYZITRRNR>& input,
+    pcl::PointCloud<PointXYZITRRNR>& output) {
+  FilterOrganizedImpl(input, output);
+}
+
+bool FusedInputFilter::Keep(const std::vector<PointFilter>& filters, float x,
+                            float y, float z, int ring) {
+  for (const auto& filter : filters) {
+    if (!filter.Keep(x, y, z, ring)) { return false; }
+  }
+  return true;
+}
+
+template <typename PointT>
+void FusedInputFilter::FilterImpl(const pcl::PointCloud<PointT>& input,
+                                  pcl::PointCloud<PointT>& output) {
+  if (&input == &output) {
+    throw std::invalid_argument{"input and output clouds must be different"};
+  }
+
+  // same as the chained filters without any filter: the input is kept as is,
+  // including its invalid points and organized layout
+  if (Empty()) {
+    output = input;
+    return;
+  }
+
+  output.clear();
+  output.header = input.header;
+  voxel_keys_.clear();
+
+  // single pass over the input, applying all filters before the voxel filter
+  for (uint32_t i = 0; i < input.size(); i++) {
+    const PointT& p = input[i];
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+      continue;
+    }
+    if (!Keep(pre_voxel_, p.x, p.y, p.z, GetRing(p))) { continue; }
+    if (!use_voxel_) {
+      output.push_back(p);
+      continue;
+    }
+    const int64_t vx = static_cast<int64_t>(
+                           std::floor(p.x * inverse_cell_size_[0])) +
+                       kVoxelBias;
+    const int64_t vy = static_cast<int64_t>(
+                           std::floor(p.y * inverse_cell_size_[1])) +
+                       kVoxelBias;
+    const int64_t vz = static_cast<int64_t>(
+                           std::floor(p.z * inverse_cell_size_[2])) +
+                       kVoxelBias;
+    if (vx < 0 || vy < 0 || vz < 0 || vx > kVoxelMax || vy > kVoxelMax ||
+        vz > kVoxelMax) {
+      continue;
+    }
+    const uint64_t key = (static_cast<uint64_t>(vz) << (2 * kVoxelBits)) |
+                         (static_cast<uint64_t>(vy) << kVoxelBits) |
+                         static_cast<uint64_t>(vx);
+    voxel_keys_.emplace_back(key, i);
+  }
+
+  if (use_voxel_) {
+    std::sort(voxel_keys_.begin(), voxel_keys_.end());
+    size_t first = 0;
+    while (first < voxel_keys_.size()) {
+      size_t last = first;
+      Centroid c;
+      while (last < voxel_keys_.size() &&
+             voxel_keys_[last].first == voxel_keys_[first].first) {
+        const PointT& p = input[voxel_keys_[last].second];
+        c.x += p.x;
+        c.y += p.y;
+        c.z += p.z;
+        AddFields(c, p);
+        last++;
+      }
+      const float n = static_cast<float>(last - first);
+      PointT p = input[voxel_keys_[first].second];
+      p.x = c.x / n;
+      p.y = c.y / n;
+      p.z = c.z / n;
+      SetFields(p, c, n);
+      if (Keep(post_voxel_, p.x, p.y, p.z, GetRing(p))) {
+        output.push_back(p);
+      }
+      first = last;
+    }
+  }
+
+  output.width = output.size();
+  output.height = 1;
+  output.is_dense = true;
+}
+
+template <typename PointT>
+void FusedInputFilter::FilterOrganizedImpl(const pcl::PointCloud<PointT>& input,
+                                           pcl::PointCloud<PointT>& output) {
+  if (&input == &output) {
+    throw std::invalid_argument{"input and output clouds must be different"};
+  }
+  output = input;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (auto& p : output) {
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+      continue;
+    }
+    if (!Keep(pre_voxel_, p.x, p.y, p.z, GetRing(p)) ||
+        !Keep(post_voxel_, p.x, p.y, p.z, GetRing(p))) {
+      p.x = nan;
+      p.y = nan;
+      p.z = nan;
+      output.is_dense = false;
+    }
+  }
+}
+
+} // namespace bs_models
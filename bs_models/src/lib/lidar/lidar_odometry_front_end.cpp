@@ -0,0 +1,301 @@
+#include <bs_models/lidar/lidar_odometry_front_end.h>
+
+#include <nlohmann/json.hpp>
+#include <ros/console.h>
+
+#include <beam_utils/filesystem.h>
+
+#include <bs_common/utils.h>
+#include <bs_models/scan_registration/registration_map.h>
+#include <bs_models/scan_registration/voxel_gaussian_matcher.h>
+
+namespace bs_models {
+
+using namespace scan_registration;
+
+const std::vector<std::string> LidarOdometryFrontEnd::kStages{
+    "ros_to_pcl", "filter", "deskew", "scan_pose", "registration"};
+
+LidarOdometryFrontEnd::LidarOdometryFrontEnd(const Params& params)
+    : params_(params) {
+  if (!params_.input_filters_config.empty()) {
+    LoadInputFilters(params_.input_filters_config);
+  }
+
+  // setup registration and feature extraction. Voxel gaussian matching uses
+  // the raw clouds, and its config is not a beam_matching type
+  scan_registration_ = ScanRegistrationBase::Create(
+      params_.registration_config, params_.matcher_config,
+      params_.registration_results_path, 1e-5);
+  if (!VoxelGaussianMatcher::IsConfig(params_.matcher_config) &&
+      beam_matching::GetTypeFromConfig(params_.matcher_config) ==
+          beam_matching::MatcherType::LOAM) {
+    std::string ceres_config = bs_common::GetAbsoluteConfigPathFromJson(
+        params_.matcher_config, "ceres_config");
+    matcher_params_ = std::make_shared<beam_matching::LoamParams>(
+        params_.matcher_config, ceres_config);
+    if (params_.organized_feature_extraction) {
+      organized_extractor_ = std::make_unique<OrganizedLoamFeatureExtractor>(
+          matcher_params_, params_.range_image_columns);
+    } else {
+      feature_extractor_ =
+          std::make_shared<beam_matching::LoamFeatureExtractor>(
+              matcher_params_);
+    }
+  }
+  scan_registration_->SetInformationWeight(params_.lidar_information_weight);
+
+  // setup registration profile tuning
+  if (!params_.registration_tuning_config.empty()) {
+    RegistrationProfileTuner::Params tuner_params;
+    tuner_params.LoadFromJson(params_.registration_tuning_config);
+    if (tuner_params.enabled) {
+      profile_tuner_ =
+          std::make_unique<RegistrationProfileTuner>(tuner_params);
+      ApplyRegistrationProfile();
+    }
+  }
+
+  if (!params_.dynamic_point_filter_config.empty()) {
+    DynamicPointFilter::Params dynamic_point_filter_params;
+    dynamic_point_filter_params.LoadFromJson(
+        params_.dynamic_point_filter_config);
+    RegistrationMap::GetInstance().SetDynamicPointFilter(
+        dynamic_point_filter_params);
+  }
+
+  if (params_.redeskew_scans) {
+    redeskewer_ = std::make_unique<ScanRedeskewer>(params_.redeskewer);
+  }
+}
+
+void LidarOdometryFrontEnd::LoadInputFilters(const std::string& config) {
+  ROS_INFO("Reading input filter params from %s", config.c_str());
+  nlohmann::json J;
+  if (!beam::ReadJson(config, J)) {
+    ROS_ERROR("Cannot read input filters json, not using any filters.");
+    return;
+  }
+  if (!J.contains("filters")) {
+    ROS_ERROR("Missing 'filters' param in input filters config file. Not using "
+              "filters.");
+    return;
+  }
+
+  auto fused_filter = std::make_unique<FusedInputFilter>();
+  if (fused_filter->LoadFromJson(J["filters"])) {
+    fused_input_filter_ = std::move(fused_filter);
+    ROS_INFO("Loaded %zu fused input filters", J["filters"].size());
+  } else {
+    input_filter_params_ = beam_filtering::LoadFilterParamsVector(J["filters"]);
+    ROS_INFO("Loaded %zu input filters", input_filter_params_.size());
+  }
+}
+
+template <typename Function>
+void LidarOdometryFrontEnd::TimeStage(const std::string& stage,
+                                      Function&& function) {
+  if (!stage_callback_) {
+    function();
+    return;
+  }
+  beam::HighResolutionTimer timer;
+  function();
+  stage_callback_(stage, timer.elapsed() * 1e3);
+}
+
+template <typename PointT>
+void LidarOdometryFrontEnd::Filter(const pcl::PointCloud<PointT>& cloud,
+                                   pcl::PointCloud<PointT>& filtered) {
+  if (fused_input_filter_) {
+    fused_input_filter_->Filter(cloud, filtered);
+  } else {
+    filtered = beam_filtering::FilterPointCloud<PointT>(cloud,
+                                                        input_filter_params_);
+  }
+}
+
+template <typename PointT>
+beam_matching::LoamPointCloud LidarOdometryFrontEnd::ExtractOrganizedFeatures(
+    const pcl::PointCloud<PointT>& cloud, const ros::Time& stamp,
+    const ScanRedeskewer::PoseLookup& get_T_World_Lidar,
+    pcl::PointCloud<PointT>& organized) {
+  fused_input_filter_->FilterOrganized(cloud, organized);
+  if (redeskewer_) {
+    pcl::PointCloud<PointT> deskewed;
+    if (ScanRedeskewer::Deskew(organized, stamp, get_T_World_Lidar,
+                               deskewed)) {
+      return organized_extractor_->ExtractFeatures(deskewed);
+    }
+  }
+  return organized_extractor_->ExtractFeatures(organized);
+}
+
+template <typename RawPointT, typename PointT>
+std::shared_ptr<ScanPose> LidarOdometryFrontEnd::CreateScanPose(
+    const pcl::PointCloud<RawPointT>& raw, const pcl::PointCloud<PointT>& cloud,
+    const ros::Time& stamp, const Eigen::Matrix4d& T_World_BaselinkInit,
+    const Eigen::Matrix4d& T_Baselink_Lidar,
+    const ScanRedeskewer::PoseLookup& get_T_World_Lidar,
+    pcl::PointCloud<RawPointT>& organized) {
+  auto scan_pose =
+      std::make_shared<ScanPose>(cloud, stamp, T_World_BaselinkInit,
+                                 T_Baselink_Lidar, feature_extractor_);
+  if (organized_extractor_) {
+    scan_pose->AddPointCloud(
+        fused_input_filter_
+            ? ExtractOrganizedFeatures(raw, stamp, get_T_World_Lidar,
+                                       organized)
+            : organized_extractor_->ExtractFeatures(cloud),
+        true);
+  }
+  return scan_pose;
+}
+
+LidarOdometryFrontEnd::Result LidarOdometryFrontEnd::ProcessScan(
+    const sensor_msgs::PointCloud2& msg,
+    const Eigen::Matrix4d& T_World_BaselinkInit,
+    const Eigen::Matrix4d& T_Baselink_Lidar,
+    const ScanRedeskewer::PoseLookup& get_T_World_Lidar) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  scan_timer_.restart();
+  const ros::Time stamp = msg.header.stamp;
+  Result result;
+  if (params_.lidar_type == LidarType::VELODYNE) {
+    pcl::PointCloud<PointXYZIRT> cloud_unfiltered;
+    TimeStage("ros_to_pcl", [&]() { beam::ROSToPCL(cloud_unfiltered, msg); });
+    pcl::PointCloud<PointXYZIRT>& cloud_filtered = velodyne_filtered_;
+    TimeStage("filter", [&]() { Filter(cloud_unfiltered, cloud_filtered); });
+    if (redeskewer_) {
+      TimeStage("deskew", [&]() {
+        cloud_filtered =
+            redeskewer_->AddScan(stamp, cloud_filtered, get_T_World_Lidar);
+      });
+    }
+    TimeStage("scan_pose", [&]() {
+      result.scan_pose = CreateScanPose(
+          cloud_unfiltered, cloud_filtered, stamp, T_World_BaselinkInit,
+          T_Baselink_Lidar, get_T_World_Lidar, velodyne_organized_);
+    });
+  } else if (params_.lidar_type == LidarType::OUSTER) {
+    pcl::PointCloud<PointXYZITRRNR> cloud_unfiltered;
+    TimeStage("ros_to_pcl", [&]() { beam::ROSToPCL(cloud_unfiltered, msg); });
+    pcl::PointCloud<PointXYZITRRNR>& cloud_filtered = ouster_filtered_;
+    TimeStage("filter", [&]() { Filter(cloud_unfiltered, cloud_filtered); });
+    if (redeskewer_) {
+      // scans kept for re-deskewing are stored as PointXYZIRT
+      pcl::PointCloud<PointXYZIRT>& cloud_deskewed = velodyne_filtered_;
+      TimeStage("deskew", [&]() {
+        cloud_deskewed = redeskewer_->AddScan(
+            stamp, ScanRedeskewer::ToPointXYZIRT(cloud_filtered),
+            get_T_World_Lidar);
+      });
+      TimeStage("scan_pose", [&]() {
+        result.scan_pose = CreateScanPose(
+            cloud_unfiltered, cloud_deskewed, stamp, T_World_BaselinkInit,
+            T_Baselink_Lidar, get_T_World_Lidar, ouster_organized_);
+      });
+    } else {
+      TimeStage("scan_pose", [&]() {
+        result.scan_pose = CreateScanPose(
+            cloud_unfiltered, cloud_filtered, stamp, T_World_BaselinkInit,
+            T_Baselink_Lidar, get_T_World_Lidar, ouster_organized_);
+      });
+    }
+  } else {
+    ROS_ERROR(
+        "Invalid lidar type param. Lidar type may not be implemented yet.");
+    throw std::runtime_error(
+        "Invalid lidar type param. Lidar type may not be implemented yet.");
+  }
+
+  TimeStage("registration", [&]() {
+    result.transaction =
+        scan_registration_->RegisterNewScan(*result.scan_pose)
+            .GetTransaction();
+  });
+  if (profile_tuner_ != nullptr &&
+      profile_tuner_->AddMeasurement(stamp, scan_timer_.elapsed())) {
+    ApplyRegistrationProfile();
+  }
+  scan_registration_->GetMap().GetScanPose(stamp, result.T_World_Lidar);
+  if (result.transaction == nullptr && redeskewer_) {
+    redeskewer_->RemoveScan(stamp);
+  }
+  return result;
+}
+
+std::vector<std::shared_ptr<ScanPose>> LidarOdometryFrontEnd::RedeskewScans(
+    const LidarTrajectory& trajectory,
+    const std::list<std::shared_ptr<ScanPose>>& scans) {
+  std::vector<std::shared_ptr<ScanPose>> updated;
+  if (redeskewer_ == nullptr) { return updated; }
+  // the redeskewer has its own lock, so new scans are only blocked by the
+  // feature extraction and map update below
+  const auto deskewed_scans = redeskewer_->Update(trajectory);
+  if (deskewed_scans.empty()) { return updated; }
+
+  std::lock_guard<std::mutex> lk(mutex_);
+
+  auto& map = scan_registration_->GetMapMutable();
+  auto scan_pose = scans.begin();
+  for (const auto& deskewed : deskewed_scans) {
+    // both are sorted by stamp
+    while (scan_pose != scans.end() &&
+           (*scan_pose)->Stamp() < deskewed.stamp) {
+      ++scan_pose;
+    }
+    if (scan_pose == scans.end()) { break; }
+    if ((*scan_pose)->Stamp() != deskewed.stamp) { continue; }
+
+    PointCloud cloud;
+    for (const auto& p : deskewed.cloud) {
+      cloud.push_back(pcl::PointXYZ(p.x, p.y, p.z));
+    }
+    (*scan_pose)->AddPointCloud(cloud, true);
+    if (organized_extractor_) {
+      (*scan_pose)->AddPointCloud(
+          organized_extractor_->ExtractFeatures(deskewed.cloud), true);
+    } else if (feature_extractor_) {
+      (*scan_pose)->AddPointCloud(
+          feature_extractor_->ExtractFeatures(deskewed.cloud), true);
+    }
+    map.UpdateScanClouds(deskewed.stamp, (*scan_pose)->Cloud(),
+                         (*scan_pose)->LoamCloud(), false);
+    updated.push_back(*scan_pose);
+  }
+  map.Publish();
+  ROS_DEBUG("Re-deskewed %zu scans with the optimized trajectory",
+            deskewed_scans.size());
+  return updated;
+}
+
+std::shared_ptr<const pcl::PointCloud<PointXYZIRT>>
+    LidarOdometryFrontEnd::FindRawScan(const ros::Time& stamp) const {
+  return redeskewer_ ? redeskewer_->FindRawScan(stamp) : nullptr;
+}
+
+void LidarOdometryFrontEnd::RemoveRawScan(const ros::Time& stamp) {
+  if (redeskewer_) { redeskewer_->RemoveScan(stamp); }
+}
+
+void LidarOdometryFrontEnd::ApplyRegistrationProfile() {
+  const RegistrationProfile& profile = profile_tuner_->GetProfile();
+  ROS_INFO_STREAM("Setting registration profile level to "
+                  << profile_tuner_->GetLevel()
+                  << " (load: " << profile_tuner_->GetLoad() << ")");
+  scan_registration_->GetMapMutable().SetMapSize(profile.map_size);
+
+  // feature counts are read by the feature extractor from the shared params
+  if (matcher_params_ == nullptr) { return; }
+  matcher_params_->max_corner_sharp = profile.max_corner_sharp;
+  matcher_params_->max_corner_less_sharp = profile.max_corner_less_sharp;
+  matcher_params_->max_surface_flat = profile.max_surface_flat;
+  matcher_params_->max_correspondence_iterations =
+      profile.max_correspondence_iterations;
+  matcher_params_->optimizer_params.GetSolverOptionsMutable()
+      .max_solver_time_in_seconds = profile.max_solver_time_in_seconds;
+  scan_registration_->SetLoamMatcherParams(*matcher_params_);
+}
+
+} // namespace bs_models
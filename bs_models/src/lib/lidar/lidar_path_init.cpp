@@ -71,8 +71,14 @@ LidarPathInit::LidarPathInit(int lidar_buffer_size,
 
   beam::ValidateJsonKeysOrThrow({"filters"}, J);
   nlohmann::json J_filters = J["filters"];
-  input_filter_params_ = beam_filtering::LoadFilterParamsVector(J_filters);
-  BEAM_INFO("Loaded {} input filters", input_filter_params_.size());
+  auto fused_filter = std::make_unique<FusedInputFilter>();
+  if (fused_filter->LoadFromJson(J_filters)) {
+    fused_input_filter_ = std::move(fused_filter);
+    BEAM_INFO("Loaded {} fused input filters", J_filters.size());
+  } else {
+    input_filter_params_ = beam_filtering::LoadFilterParamsVector(J_filters);
+    BEAM_INFO("Loaded {} input filters", input_filter_params_.size());
+  }
 }
 
 void LidarPathInit::ProcessLidar(
@@ -84,8 +90,13 @@ void LidarPathInit::ProcessLidar(
   beam::HighResolutionTimer timer;
   PointCloud cloud_current = beam::ROSToPCL(*msg);
 
-  PointCloud cloud_filtered = beam_filtering::FilterPointCloud<pcl::PointXYZ>(
-      cloud_current, input_filter_params_);
+  PointCloud& cloud_filtered = cloud_filtered_;
+  if (fused_input_filter_) {
+    fused_input_filter_->Filter(cloud_current, cloud_filtered);
+  } else {
+    cloud_filtered = beam_filtering::FilterPointCloud<pcl::PointXYZ>(
+        cloud_current, input_filter_params_);
+  }
 
   Eigen::Matrix4d T_WORLD_BASELINK_EST =
       Get_T_WORLD_BASELINKEST(msg->header.stamp);
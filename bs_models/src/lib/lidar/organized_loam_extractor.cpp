@@ -0,0 +1,247 @@
+#include <bs_models/lidar/organized_loam_extractor.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <beam_filtering/VoxelDownsample.h>
+
+namespace bs_models {
+
+using namespace beam_matching;
+
+OrganizedLoamFeatureExtractor::OrganizedLoamFeatureExtractor(
+    const std::shared_ptr<LoamParams>& loam_params, int num_columns,
+    const Params& params)
+    : loam_params_(loam_params),
+      params_(params),
+      image_(loam_params->number_of_beams, num_columns) {}
+
+OrganizedLoamFeatureExtractor::OrganizedLoamFeatureExtractor(
+    const std::shared_ptr<LoamParams>& loam_params, int num_columns)
+    : OrganizedLoamFeatureExtractor(loam_params, num_columns, Params()) {}
+
+LoamPointCloud OrganizedLoamFeatureExtractor::ExtractFeatures(
+    const pcl::PointCloud<PointXYZIRT>& cloud) {
+  image_.Build(cloud);
+  return ExtractFeatures(image_);
+}
+
+LoamPointCloud OrganizedLoamFeatureExtractor::ExtractFeatures(
+    const pcl::PointCloud<PointXYZITRRNR>& cloud) {
+  image_.Build(cloud);
+  return ExtractFeatures(image_);
+}
+
+LoamPointCloud
+    OrganizedLoamFeatureExtractor::ExtractFeatures(const RangeImage& image) {
+  LoamPointCloud features;
+  pcl::PointCloud<PointXYZIRT> weak_surfaces;
+  for (int ring = 0; ring < image.Rings(); ring++) {
+    ExtractRing(image, ring, features, weak_surfaces);
+  }
+
+  if (loam_params_->downsample_less_flat_features &&
+      loam_params_->less_flat_filter_size > 0 && !weak_surfaces.empty()) {
+    const float size = loam_params_->less_flat_filter_size;
+    beam_filtering::VoxelDownsample<PointXYZIRT> voxel_filter(
+        Eigen::Vector3f(size, size, size));
+    voxel_filter.SetInputCloud(
+        std::make_shared<pcl::PointCloud<PointXYZIRT>>(weak_surfaces));
+    voxel_filter.Filter();
+    features.surfaces.weak.cloud = voxel_filter.GetFilteredCloud();
+  } else {
+    features.surfaces.weak.cloud = std::move(weak_surfaces);
+  }
+  return features;
+}
+
+void OrganizedLoamFeatureExtractor::ExtractRing(
+    const RangeImage& image, int ring, LoamPointCloud& features,
+    pcl::PointCloud<PointXYZIRT>& weak_surfaces) {
+  const int region = std::max(loam_params_->curvature_region, 1);
+  CompactRing(image, ring);
+  const int n = columns_.size();
+  if (n < 2 * region + 1) { return; }
+
+  ComputeCurvature(region);
+  MarkUnreliable(region);
+
+  const float threshold = loam_params_->surface_curvature_threshold;
+  const int num_regions = std::max(loam_params_->n_feature_regions, 1);
+  const int start = region;
+  const int end = n - region;
+  for (int sector = 0; sector < num_regions; sector++) {
+    const int sp = start + (end - start) * sector / num_regions;
+    const int ep = start + (end - start) * (sector + 1) / num_regions;
+    if (ep <= sp) { continue; }
+
+    sorted_.resize(ep - sp);
+    for (int k = sp; k < ep; k++) { sorted_[k - sp] = k; }
+    std::sort(sorted_.begin(), sorted_.end(), [this](int a, int b) {
+      return curvature_[a] < curvature_[b];
+    });
+
+    // edges, highest curvature first
+    int num_edges{0};
+    for (auto it = sorted_.rbegin(); it != sorted_.rend(); it++) {
+      const int k = *it;
+      if (curvature_[k] <= threshold) { break; }
+      if (picked_[k]) { continue; }
+      num_edges++;
+      if (num_edges > loam_params_->max_corner_less_sharp) { break; }
+      const PointXYZIRT p = ToPoint(image, ring, k);
+      if (num_edges <= loam_params_->max_corner_sharp) {
+        features.edges.strong.cloud.push_back(p);
+      }
+      features.edges.weak.cloud.push_back(p);
+      labels_[k] = Label::EDGE;
+      Suppress(k, region);
+    }
+
+    // surfaces, lowest curvature first
+    int num_surfaces{0};
+    for (const int k : sorted_) {
+      if (curvature_[k] < 0 || picked_[k]) { continue; }
+      if (curvature_[k] >= threshold) { break; }
+      features.surfaces.strong.cloud.push_back(ToPoint(image, ring, k));
+      labels_[k] = Label::SURFACE;
+      Suppress(k, region);
+      if (++num_surfaces >= loam_params_->max_surface_flat) { break; }
+    }
+
+    // everything that is not an edge can be used as a weak surface
+    for (int k = sp; k < ep; k++) {
+      if (labels_[k] != Label::EDGE && curvature_[k] >= 0) {
+        weak_surfaces.push_back(ToPoint(image, ring, k));
+      }
+    }
+  }
+}
+
+void OrganizedLoamFeatureExtractor::CompactRing(const RangeImage& image,
+                                                int ring) {
+  columns_.clear();
+  segments_.clear();
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  range_.clear();
+
+  const float* x = image.X(ring);
+  const float* y = image.Y(ring);
+  const float* z = image.Z(ring);
+  const float* range = image.Range(ring);
+  int segment{0};
+  int last_column{-1};
+  for (int column = 0; column < image.Columns(); column++) {
+    if (range[column] <= 0) { continue; }
+    if (last_column >= 0 && column - last_column > params_.max_column_gap) {
+      segment++;
+    }
+    last_column = column;
+    columns_.push_back(column);
+    segments_.push_back(segment);
+    x_.push_back(x[column]);
+    y_.push_back(y[column]);
+    z_.push_back(z[column]);
+    range_.push_back(range[column]);
+  }
+
+  const size_t n = columns_.size();
+  curvature_.assign(n, -1);
+  picked_.assign(n, 0);
+  labels_.assign(n, Label::NONE);
+}
+
+void OrganizedLoamFeatureExtractor::ComputeCurvature(int region) {
+  const int n = columns_.size();
+  for (int k = region; k < n - region; k++) {
+    // all neighbors must be in the same contiguous segment
+    if (segments_[k - region] != segments_[k + region]) {
+      picked_[k] = 1;
+      continue;
+    }
+    float dx = -2 * region * x_[k];
+    float dy = -2 * region * y_[k];
+    float dz = -2 * region * z_[k];
+    for (int j = k - region; j <= k + region; j++) {
+      dx += x_[j];
+      dy += y_[j];
+      dz += z_[j];
+    }
+    // remove the point itself, which was added in the loop
+    dx -= x_[k];
+    dy -= y_[k];
+    dz -= z_[k];
+    curvature_[k] = dx * dx + dy * dy + dz * dz;
+  }
+  for (int k = 0; k < std::min(region, n); k++) { picked_[k] = 1; }
+  for (int k = std::max(n - region, 0); k < n; k++) { picked_[k] = 1; }
+}
+
+void OrganizedLoamFeatureExtractor::MarkUnreliable(int region) {
+  const int n = columns_.size();
+  for (int k = 0; k + 1 < n; k++) {
+    if (segments_[k] != segments_[k + 1]) { continue; }
+    const float r0 = range_[k];
+    const float r1 = range_[k + 1];
+
+    // occlusion: the far side of a depth discontinuity
+    if (r0 - r1 > params_.occlusion_threshold_m) {
+      for (int j = std::max(k - region, 0); j <= k; j++) {
+        if (segments_[j] == segments_[k]) { picked_[j] = 1; }
+      }
+    } else if (r1 - r0 > params_.occlusion_threshold_m) {
+      for (int j = k + 1; j <= std::min(k + 1 + region, n - 1); j++) {
+        if (segments_[j] == segments_[k]) { picked_[j] = 1; }
+      }
+    }
+
+    // parallel beam: large relative jump on both sides of the point
+    if (k > 0 && segments_[k - 1] == segments_[k]) {
+      const float limit = params_.parallel_beam_ratio * r0;
+      if (std::abs(r0 - range_[k - 1]) > limit && std::abs(r1 - r0) > limit) {
+        picked_[k] = 1;
+      }
+    }
+  }
+}
+
+void OrganizedLoamFeatureExtractor::Suppress(int k, int region) {
+  static constexpr float kMaxNeighborDistanceSq = 0.05;
+  picked_[k] = 1;
+  const int n = columns_.size();
+  for (int l = 1; l <= region && k + l < n; l++) {
+    const int j = k + l;
+    if (segments_[j] != segments_[k]) { break; }
+    const float dx = x_[j] - x_[j - 1];
+    const float dy = y_[j] - y_[j - 1];
+    const float dz = z_[j] - z_[j - 1];
+    if (dx * dx + dy * dy + dz * dz > kMaxNeighborDistanceSq) { break; }
+    picked_[j] = 1;
+  }
+  for (int l = 1; l <= region && k - l >= 0; l++) {
+    const int j = k - l;
+    if (segments_[j] != segments_[k]) { break; }
+    const float dx = x_[j] - x_[j + 1];
+    const float dy = y_[j] - y_[j + 1];
+    const float dz = z_[j] - z_[j + 1];
+    if (dx * dx + dy * dy + dz * dz > kMaxNeighborDistanceSq) { break; }
+    picked_[j] = 1;
+  }
+}
+
+PointXYZIRT OrganizedLoamFeatureExtractor::ToPoint(const RangeImage& image,
+                                                   int ring, int k) const {
+  const int column = columns_[k];
+  PointXYZIRT p;
+  p.x = x_[k];
+  p.y = y_[k];
+  p.z = z_[k];
+  p.intensity = image.Intensity(ring)[column];
+  p.ring = static_cast<uint16_t>(ring);
+  p.time = image.Time(ring)[column];
+  return p;
+}
+
+} // namespace bs_models
@@ -0,0 +1,115 @@
+#include <bs_models/lidar/range_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <beam_utils/log.h>
+
+namespace bs_models {
+
+RangeImage::RangeImage(int num_rings, int num_columns)
+    : num_rings_(num_rings),
+      num_columns_(num_columns),
+      default_num_columns_(num_columns) {
+  if (num_rings < 1 || num_columns < 1) {
+    BEAM_ERROR("Invalid range image size, rings: {}, columns: {}", num_rings,
+               num_columns);
+    throw std::invalid_argument{"invalid range image size"};
+  }
+  Resize(num_columns);
+}
+
+void RangeImage::Build(const pcl::PointCloud<PointXYZIRT>& cloud) {
+  BuildImpl(cloud);
+}
+
+void RangeImage::Build(const pcl::PointCloud<PointXYZITRRNR>& cloud) {
+  BuildImpl(cloud);
+}
+
+template <typename PointT>
+void RangeImage::BuildImpl(const pcl::PointCloud<PointT>& cloud) {
+  const bool organized = cloud.height == static_cast<uint32_t>(num_rings_) &&
+                         cloud.width > 1;
+  Resize(organized ? static_cast<int>(cloud.width) : default_num_columns_);
+  std::fill(range_.begin(), range_.end(), 0.0f);
+  num_points_ = 0;
+  num_dropped_ = 0;
+
+  const float columns_per_rad = num_columns_ / (2 * M_PI);
+  for (size_t i = 0; i < cloud.size(); i++) {
+    const PointT& p = cloud[i];
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+      continue;
+    }
+    const int ring = static_cast<int>(p.ring);
+    int column;
+    if (organized) {
+      column = static_cast<int>(i % cloud.width);
+    } else {
+      const float azimuth = std::atan2(p.y, p.x) + M_PI;
+      column = static_cast<int>(azimuth * columns_per_rad);
+      column = std::min(std::max(column, 0), num_columns_ - 1);
+    }
+    if (ring < 0 || ring >= num_rings_) {
+      num_dropped_++;
+      continue;
+    }
+    Insert(ring, column, p.x, p.y, p.z, p.intensity,
+           static_cast<float>(p.time));
+  }
+}
+
+void RangeImage::Resize(int num_columns) {
+  num_columns_ = num_columns;
+  const size_t size = static_cast<size_t>(num_rings_) * num_columns_;
+  if (range_.size() == size) { return; }
+  x_.resize(size);
+  y_.resize(size);
+  z_.resize(size);
+  range_.resize(size);
+  intensity_.resize(size);
+  time_.resize(size);
+}
+
+void RangeImage::Insert(int ring, int column, float x, float y, float z,
+                        float intensity, float time) {
+  const float range = std::sqrt(x * x + y * y + z * z);
+  if (range <= 0) { return; }
+  const size_t i = Index(ring, column);
+  if (range_[i] > 0) {
+    num_dropped_++;
+    if (range_[i] <= range) { return; }
+  } else {
+    num_points_++;
+  }
+  x_[i] = x;
+  y_[i] = y;
+  z_[i] = z;
+  range_[i] = range;
+  intensity_[i] = intensity;
+  time_[i] = time;
+}
+
+pcl::PointCloud<PointXYZIRT> RangeImage::ToCloud() const {
+  pcl::PointCloud<PointXYZIRT> cloud;
+  cloud.reserve(num_points_);
+  for (int ring = 0; ring < num_rings_; ring++) {
+    for (int column = 0; column < num_columns_; column++) {
+      const size_t i = Index(ring, column);
+      if (range_[i] <= 0) { continue; }
+      PointXYZIRT p;
+      p.x = x_[i];
+      p.y = y_[i];
+      p.z = z_[i];
+      p.intensity = intensity_[i];
+      p.ring = static_cast<uint16_t>(ring);
+      p.time = time_[i];
+      cloud.push_back(p);
+    }
+  }
+  return cloud;
+}
+
+} // namespace bs_models
@@ -0,0 +1,255 @@
+#include <bs_models/lidar/scan_redeskewer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include <beam_utils/math.h>
+
+namespace bs_models {
+
+namespace {
+
+/**
+ * interpolates between two poses, or extrapolates if ratio is outside [0, 1],
+ * assuming constant velocity in between
+ */
+Eigen::Matrix4d InterpolatePose(const Eigen::Matrix4d& T1,
+                                const Eigen::Matrix4d& T2, double ratio) {
+  const Eigen::Matrix3d R1 = T1.block<3, 3>(0, 0);
+  const Eigen::AngleAxisd aa(Eigen::Matrix3d(R1.transpose() *
+                                             T2.block<3, 3>(0, 0)));
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      R1 * Eigen::AngleAxisd(ratio * aa.angle(), aa.axis()).toRotationMatrix();
+  T.block<3, 1>(0, 3) = T1.block<3, 1>(0, 3) +
+                        ratio * (T2.block<3, 1>(0, 3) - T1.block<3, 1>(0, 3));
+  return T;
+}
+
+} // namespace
+
+LidarTrajectory::LidarTrajectory(double max_extrapolation_s)
+    : max_extrapolation_s_(max_extrapolation_s) {}
+
+void LidarTrajectory::AddPose(const ros::Time& stamp,
+                              const Eigen::Matrix4d& T_World_Lidar) {
+  poses_[stamp.toNSec()] = T_World_Lidar;
+}
+
+ros::Time LidarTrajectory::Start() const {
+  ros::Time start;
+  start.fromNSec(poses_.begin()->first);
+  return start;
+}
+
+bool LidarTrajectory::GetPose(const ros::Time& time,
+                              Eigen::Matrix4d& T_World_Lidar) const {
+  const uint64_t t = time.toNSec();
+  auto upper = poses_.lower_bound(t);
+  if (upper != poses_.end() && upper->first == t) {
+    T_World_Lidar = upper->second;
+    return true;
+  }
+  if (poses_.size() < 2) { return false; }
+
+  // get the two poses to interpolate, or extrapolate from
+  auto lower = upper;
+  if (upper == poses_.begin()) {
+    upper = std::next(lower);
+    if ((lower->first - t) * 1e-9 > max_extrapolation_s_) { return false; }
+  } else if (upper == poses_.end()) {
+    lower = std::prev(upper, 2);
+    upper = std::next(lower);
+    if ((t - upper->first) * 1e-9 > max_extrapolation_s_) { return false; }
+  } else {
+    lower = std::prev(upper);
+  }
+
+  const double ratio = (static_cast<double>(t) - lower->first) /
+                       (static_cast<double>(upper->first) - lower->first);
+  T_World_Lidar = InterpolatePose(lower->second, upper->second, ratio);
+  return true;
+}
+
+pcl::PointCloud<PointXYZIRT> ScanRedeskewer::ToPointXYZIRT(
+    const pcl::PointCloud<PointXYZITRRNR>& cloud) {
+  pcl::PointCloud<PointXYZIRT> converted;
+  converted.resize(cloud.size());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    const auto& p = cloud[i];
+    auto& q = converted[i];
+    q.x = p.x;
+    q.y = p.y;
+    q.z = p.z;
+    q.intensity = p.intensity;
+    q.ring = p.ring;
+    q.time = p.time;
+  }
+  converted.width = cloud.width;
+  converted.height = cloud.height;
+  converted.is_dense = cloud.is_dense;
+  return converted;
+}
+
+ScanRedeskewer::ScanRedeskewer(const Params& params) : params_(params) {}
+
+bool ScanRedeskewer::GetScanMotion(const ros::Time& stamp, double duration_s,
+                                   const PoseLookup& get_T_World_Lidar,
+                                   Eigen::Matrix4d& T_Lidar0_LidarEnd) {
+  Eigen::Matrix4d T_World_Lidar0;
+  Eigen::Matrix4d T_World_LidarEnd;
+  if (!get_T_World_Lidar(stamp, T_World_Lidar0) ||
+      !get_T_World_Lidar(stamp + ros::Duration(duration_s),
+                         T_World_LidarEnd)) {
+    return false;
+  }
+  T_Lidar0_LidarEnd = beam::InvertTransform(T_World_Lidar0) * T_World_LidarEnd;
+  return true;
+}
+
+pcl::PointCloud<PointXYZIRT>
+    ScanRedeskewer::AddScan(const ros::Time& stamp,
+                            const pcl::PointCloud<PointXYZIRT>& cloud,
+                            const PoseLookup& get_T_World_Lidar) {
+  RawScan scan;
+  scan.cloud = std::make_shared<const pcl::PointCloud<PointXYZIRT>>(cloud);
+  for (const auto& p : cloud) {
+    scan.duration_s = std::max(scan.duration_s, static_cast<double>(p.time));
+  }
+
+  pcl::PointCloud<PointXYZIRT> deskewed;
+  scan.deskewed =
+      GetScanMotion(stamp, scan.duration_s, get_T_World_Lidar,
+                    scan.T_Lidar0_LidarEnd) &&
+      Deskew(cloud, stamp, get_T_World_Lidar, deskewed);
+  const bool is_deskewed = scan.deskewed;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    scans_[stamp.toNSec()] = std::move(scan);
+  }
+  if (!is_deskewed) { return cloud; }
+  return deskewed;
+}
+
+void ScanRedeskewer::RemoveScan(const ros::Time& stamp) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  scans_.erase(stamp.toNSec());
+}
+
+std::shared_ptr<const pcl::PointCloud<PointXYZIRT>>
+    ScanRedeskewer::FindRawScan(const ros::Time& stamp) const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = scans_.find(stamp.toNSec());
+  if (it == scans_.end()) { return nullptr; }
+  return it->second.cloud;
+}
+
+size_t ScanRedeskewer::NumScans() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return scans_.size();
+}
+
+std::vector<ScanRedeskewer::DeskewedScan>
+    ScanRedeskewer::Update(const LidarTrajectory& trajectory) {
+  std::vector<DeskewedScan> updated;
+  if (trajectory.Empty()) { return updated; }
+
+  const PoseLookup get_T_World_Lidar =
+      [&trajectory](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        return trajectory.GetPose(time, T_World_Lidar);
+      };
+
+  // scans whose motion changed, with how much it changed relative to the
+  // thresholds. Scans that were never deskewed come first
+  struct Candidate {
+    uint64_t stamp;
+    std::shared_ptr<const pcl::PointCloud<PointXYZIRT>> cloud;
+    Eigen::Matrix4d T_Lidar0_LidarEnd;
+    double change;
+  };
+  std::vector<Candidate> candidates;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    // scans before the window have been marginalized
+    scans_.erase(scans_.begin(),
+                 scans_.lower_bound(trajectory.Start().toNSec()));
+
+    for (const auto& [t_in_ns, scan] : scans_) {
+      ros::Time stamp;
+      stamp.fromNSec(t_in_ns);
+      Eigen::Matrix4d T_Lidar0_LidarEnd;
+      if (!GetScanMotion(stamp, scan.duration_s, get_T_World_Lidar,
+                         T_Lidar0_LidarEnd)) {
+        continue;
+      }
+      if (!scan.deskewed) {
+        candidates.push_back(Candidate{t_in_ns, scan.cloud, T_Lidar0_LidarEnd,
+                                       std::numeric_limits<double>::max()});
+        continue;
+      }
+      if (beam::ArePosesEqual(T_Lidar0_LidarEnd, scan.T_Lidar0_LidarEnd,
+                              params_.rotation_threshold_deg,
+                              params_.translation_threshold_m)) {
+        continue;
+      }
+      const Eigen::Matrix4d T_diff =
+          beam::InvertTransform(scan.T_Lidar0_LidarEnd) * T_Lidar0_LidarEnd;
+      const double rotation_deg =
+          Eigen::AngleAxisd(Eigen::Matrix3d(T_diff.block<3, 3>(0, 0)))
+              .angle() *
+          180 / M_PI;
+      const double translation_m = T_diff.block<3, 1>(0, 3).norm();
+      candidates.push_back(Candidate{
+          t_in_ns, scan.cloud, T_Lidar0_LidarEnd,
+          std::max(rotation_deg / params_.rotation_threshold_deg,
+                   translation_m / params_.translation_threshold_m)});
+    }
+  }
+
+  if (params_.max_scans_per_update > 0 &&
+      candidates.size() > static_cast<size_t>(params_.max_scans_per_update)) {
+    std::partial_sort(candidates.begin(),
+                      candidates.begin() + params_.max_scans_per_update,
+                      candidates.end(),
+                      [](const Candidate& a, const Candidate& b) {
+                        return a.change > b.change;
+                      });
+    candidates.resize(params_.max_scans_per_update);
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                return a.stamp < b.stamp;
+              });
+  }
+
+  // deskew without holding the lock, so that new scans are not blocked
+  std::vector<const Candidate*> deskewed_candidates;
+  for (const Candidate& candidate : candidates) {
+    ros::Time stamp;
+    stamp.fromNSec(candidate.stamp);
+    DeskewedScan deskewed{stamp};
+    if (!Deskew(*candidate.cloud, stamp, get_T_World_Lidar,
+                deskewed.cloud)) {
+      continue;
+    }
+    updated.push_back(std::move(deskewed));
+    deskewed_candidates.push_back(&candidate);
+  }
+
+  // only record the new motion if the scan was not removed or replaced in the
+  // meantime
+  std::lock_guard<std::mutex> lk(mutex_);
+  for (const Candidate* candidate : deskewed_candidates) {
+    auto it = scans_.find(candidate->stamp);
+    if (it == scans_.end() || it->second.cloud != candidate->cloud) {
+      continue;
+    }
+    it->second.deskewed = true;
+    it->second.T_Lidar0_LidarEnd = candidate->T_Lidar0_LidarEnd;
+  }
+  return updated;
+}
+
+} // namespace bs_models
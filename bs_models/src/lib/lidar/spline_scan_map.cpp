@@ -0,0 +1,131 @@
+#include <bs_models/lidar/spline_scan_map.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <fuse_loss/cauchy_loss.h>
+#include <ros/console.h>
+
+#include <beam_utils/math.h>
+
+#include <bs_constraints/spline/spline_point_3d_constraint.h>
+
+namespace bs_models {
+
+SplineScanMap::SplineScanMap(const Params& params)
+    : params_(params), map_(params.voxel_size) {}
+
+fuse_core::Transaction::SharedPtr SplineScanMap::AddScan(
+    const std::string& source, const bs_constraints::SplineTrajectory& spline,
+    const fuse_core::Graph* graph, const ScanPose& scan_pose,
+    const pcl::PointCloud<PointXYZIRT>& raw_cloud,
+    const Eigen::Matrix4d& T_World_Lidar) {
+  if (raw_cloud.empty()) { return nullptr; }
+  const ros::Time stamp = scan_pose.Stamp();
+  const Eigen::Matrix4d T_Baselink_Lidar = scan_pose.T_BASELINK_LIDAR();
+  const Eigen::Matrix4d T_World_Baselink =
+      T_World_Lidar * scan_pose.T_LIDAR_BASELINK();
+  double duration_s{0};
+  for (const auto& p : raw_cloud) {
+    duration_s = std::max(duration_s, static_cast<double>(p.time));
+  }
+
+  auto transaction = fuse_core::Transaction::make_shared();
+  transaction->stamp(stamp);
+  const std::vector<ros::Time> added_knots = spline.AddControlPoints(
+      *transaction, stamp, stamp + ros::Duration(duration_s), T_World_Baselink,
+      graph);
+
+  // constrain the sampled points at their own time against the map. The pose
+  // at each point is taken from the current spline estimate where available,
+  // otherwise from the registration result
+  std::lock_guard<std::mutex> lk(mutex_);
+  int num_constraints{0};
+  if (map_.NumValidVoxels() > 0) {
+    // chi-square 99% quantile for 3 DOF
+    const double max_squared_distance = 11.34;
+    const double sqrt_weight = std::sqrt(params_.information_weight);
+    auto loss = std::make_shared<fuse_loss::CauchyLoss>();
+    const size_t max_points = std::max(1, params_.points_per_scan);
+    const size_t stride = std::max<size_t>(1, raw_cloud.size() / max_points);
+    for (size_t i = 0; i < raw_cloud.size(); i += stride) {
+      const auto& p = raw_cloud[i];
+      if (!pcl::isFinite(p)) { continue; }
+      const ros::Time point_time = stamp + ros::Duration(p.time);
+      Eigen::Matrix4d T_World_BaselinkPoint = T_World_Baselink;
+      if (graph) { spline.GetPose(*graph, point_time, T_World_BaselinkPoint); }
+      const Eigen::Vector3d p_Baselink =
+          (T_Baselink_Lidar * Eigen::Vector4d(p.x, p.y, p.z, 1)).head<3>();
+      const Eigen::Vector3d p_World =
+          T_World_BaselinkPoint.block<3, 3>(0, 0) * p_Baselink +
+          T_World_BaselinkPoint.block<3, 1>(0, 3);
+      const auto* voxel = map_.Find(map_.Coordinates(p_World));
+      if (voxel == nullptr || !voxel->valid) { continue; }
+      const Eigen::Vector3d r = p_World - voxel->mean;
+      if (r.dot(voxel->information * r) > max_squared_distance) { continue; }
+
+      const Eigen::Matrix3d sqrt_information =
+          sqrt_weight * Eigen::Matrix3d(voxel->information.llt().matrixU());
+      auto constraint =
+          std::make_shared<bs_constraints::SplinePoint3DConstraint>(
+              source, spline, point_time, p_Baselink, voxel->mean,
+              sqrt_information);
+      constraint->loss(loss);
+      transaction->addConstraint(constraint);
+      num_constraints++;
+    }
+  }
+
+  // the first scan fixes the gauge of the trajectory, and control points that
+  // no point constrains would make the problem singular
+  if (num_constraints < params_.points_per_scan / 10) {
+    const double prior_covariance = map_.NumValidVoxels() > 0 ? 1e-2 : 1e-6;
+    for (const auto& knot : added_knots) {
+      spline.AddControlPointPrior(*transaction, knot, T_World_Baselink,
+                                  prior_covariance, source);
+    }
+  }
+  if (added_knots.empty() && num_constraints == 0) { return nullptr; }
+
+  MapScan& map_scan = scans_[stamp.toNSec()];
+  map_scan.cloud = scan_pose.Cloud();
+  map_scan.T_World_Lidar = T_World_Lidar;
+  map_.AddPoints(map_scan.cloud, map_scan.T_World_Lidar);
+  ROS_DEBUG("Added %zu control points and %d point constraints for scan at %f",
+            added_knots.size(), num_constraints, stamp.toSec());
+  return transaction;
+}
+
+void SplineScanMap::UpdateScan(const ScanPose& scan_pose, bool cloud_changed) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = scans_.find(scan_pose.Stamp().toNSec());
+  if (it == scans_.end()) { return; }
+
+  // same thresholds as the registration map uses to move its scans
+  MapScan& map_scan = it->second;
+  const Eigen::Matrix4d T_World_Lidar = scan_pose.T_REFFRAME_LIDAR();
+  if (!cloud_changed &&
+      beam::ArePosesEqual(T_World_Lidar, map_scan.T_World_Lidar, 0.5, 0.005)) {
+    return;
+  }
+  map_.RemovePoints(map_scan.cloud, map_scan.T_World_Lidar);
+  if (cloud_changed) { map_scan.cloud = scan_pose.Cloud(); }
+  map_scan.T_World_Lidar = T_World_Lidar;
+  map_.AddPoints(map_scan.cloud, map_scan.T_World_Lidar);
+}
+
+void SplineScanMap::RemoveScan(const ros::Time& stamp) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = scans_.find(stamp.toNSec());
+  if (it == scans_.end()) { return; }
+  map_.RemovePoints(it->second.cloud, it->second.T_World_Lidar);
+  scans_.erase(it);
+}
+
+size_t SplineScanMap::NumScans() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return scans_.size();
+}
+
+} // namespace bs_models
@@ -0,0 +1,131 @@
+#include <bs_models/scan_registration/degeneracy_analysis.h>
+
+#include <limits>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_models { namespace scan_registration {
+
+void DegeneracyAnalysis::Params::LoadFromJson(const nlohmann::json& J) {
+  beam::ValidateJsonKeysOrThrow(
+      {"enabled", "min_translation_information", "min_rotation_information",
+       "degenerate_variance"},
+      J);
+  enabled = J["enabled"];
+  min_translation_information = J["min_translation_information"];
+  min_rotation_information = J["min_rotation_information"];
+  degenerate_variance = J["degenerate_variance"];
+
+  if (min_translation_information <= 0 || min_rotation_information <= 0 ||
+      degenerate_variance <= 0) {
+    BEAM_ERROR("Invalid degeneracy params, thresholds and degenerate variance "
+               "must be positive");
+    throw std::runtime_error{"invalid degeneracy params"};
+  }
+}
+
+int DegeneracyAnalysis::Result::NumDegenerateTranslation() const {
+  return degenerate.head<3>().count();
+}
+
+int DegeneracyAnalysis::Result::NumDegenerateRotation() const {
+  return degenerate.tail<3>().count();
+}
+
+bool DegeneracyAnalysis::Result::Degenerate() const {
+  return degenerate.any();
+}
+
+DegeneracyAnalysis::DegeneracyAnalysis(const Params& params)
+    : params_(params) {}
+
+DegeneracyAnalysis::Result
+    DegeneracyAnalysis::Analyze(const Matrix6d& covariance) const {
+  Result result;
+  Eigen::Matrix<double, 6, 1> selection = Eigen::Matrix<double, 6, 1>::Ones();
+  for (int block = 0; block < 2; block++) {
+    const int i0 = 3 * block;
+    const double min_information = block == 0
+                                       ? params_.min_translation_information
+                                       : params_.min_rotation_information;
+
+    // the eigenvalues of the marginal information are the inverse of the
+    // eigenvalues of the marginal covariance, with the same eigenvectors
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(
+        covariance.block<3, 3>(i0, i0));
+    result.basis.block<3, 3>(i0, i0) = solver.eigenvectors();
+    for (int i = 0; i < 3; i++) {
+      const double variance = solver.eigenvalues()[i];
+      const double information =
+          variance > 0 ? 1.0 / variance
+                       : std::numeric_limits<double>::infinity();
+      result.information[i0 + i] = information;
+      result.degenerate[i0 + i] = information < min_information;
+      if (result.degenerate[i0 + i]) { selection[i0 + i] = 0; }
+    }
+  }
+
+  result.projection =
+      result.basis * selection.asDiagonal() * result.basis.transpose();
+  return result;
+}
+
+Eigen::Matrix4d
+    DegeneracyAnalysis::ConstrainCorrection(const Eigen::Matrix4d& T_correction,
+                                            const Result& result) const {
+  if (!result.Degenerate()) { return T_correction; }
+
+  // corrections are small, so projecting the translation and rotation vector
+  // is a good approximation of projecting on the tangent space
+  Eigen::Matrix<double, 6, 1> delta;
+  delta.head<3>() = T_correction.block<3, 1>(0, 3);
+  Eigen::AngleAxisd aa(Eigen::Matrix3d(T_correction.block<3, 3>(0, 0)));
+  delta.tail<3>() = aa.angle() * aa.axis();
+
+  const Eigen::Matrix<double, 6, 1> delta_constrained =
+      result.projection * delta;
+  const Eigen::Vector3d rotation = delta_constrained.tail<3>();
+  Eigen::Matrix4d T_constrained = Eigen::Matrix4d::Identity();
+  if (rotation.norm() > 1e-12) {
+    T_constrained.block<3, 3>(0, 0) =
+        Eigen::AngleAxisd(rotation.norm(), rotation.normalized())
+            .toRotationMatrix();
+  }
+  T_constrained.block<3, 1>(0, 3) = delta_constrained.head<3>();
+  return T_constrained;
+}
+
+DegeneracyAnalysis::Matrix6d
+    DegeneracyAnalysis::ShapeCovariance(const Matrix6d& covariance,
+                                        const Result& result) const {
+  return ReplaceDegenerate(covariance, result, params_.degenerate_variance,
+                           params_.degenerate_variance);
+}
+
+DegeneracyAnalysis::Matrix6d
+    DegeneracyAnalysis::ValidationCovariance(const Matrix6d& covariance,
+                                             const Result& result) const {
+  return ReplaceDegenerate(covariance, result,
+                           1.0 / params_.min_translation_information,
+                           1.0 / params_.min_rotation_information);
+}
+
+DegeneracyAnalysis::Matrix6d DegeneracyAnalysis::ReplaceDegenerate(
+    const Matrix6d& covariance, const Result& result,
+    double translation_variance, double rotation_variance) const {
+  if (!result.Degenerate()) { return covariance; }
+
+  // express in the eigenbasis, where each degenerate direction is a single
+  // row and column
+  Matrix6d cov_basis = result.basis.transpose() * covariance * result.basis;
+  for (int i = 0; i < 6; i++) {
+    if (!result.degenerate[i]) { continue; }
+    cov_basis.row(i).setZero();
+    cov_basis.col(i).setZero();
+    cov_basis(i, i) = i < 3 ? translation_variance : rotation_variance;
+  }
+  return result.basis * cov_basis * result.basis.transpose();
+}
+
+}} // namespace bs_models::scan_registration
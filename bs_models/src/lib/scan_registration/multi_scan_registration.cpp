@@ -5,6 +5,7 @@
 
 #include <beam_matching/Matchers.h>
 
+#include <bs_common/async_disk_writer.h>
 #include <bs_common/conversions.h>
 #include <bs_common/utils.h>
 #include <bs_constraints/relative_pose/pose_3d_stamped_transaction.h>
@@ -63,7 +64,8 @@ ScanRegistrationParamsBase MultiScanRegistrationBase::Params::GetBaseParams() {
       .min_motion_trans_m = min_motion_trans_m,
       .min_motion_rot_deg = min_motion_rot_deg,
       .max_motion_trans_m = max_motion_trans_m,
-      .fix_first_scan = fix_first_scan};
+      .fix_first_scan = fix_first_scan,
+      .degeneracy = degeneracy};
   return base_params;
 }
 
@@ -392,7 +394,7 @@ void MultiScanRegistrationBase::OutputResults(
   cloud_tgt_in_world_aligned_col = beam::AddFrameToCloud(
       cloud_tgt_in_world_aligned_col, coord_frame_, T_WORLD_LIDARREF_OPT);
 
-  // create directories
+  // create paths
   double t = scan_pose_ref.Stamp().toSec();
   std::string filename_ref =
       beam::CombinePaths(current_scan_path_, std::to_string(t) + "_ref");
@@ -400,44 +402,42 @@ void MultiScanRegistrationBase::OutputResults(
       beam::CombinePaths(current_scan_path_, std::to_string(t) + "_tgt_init");
   std::string filename_align =
       beam::CombinePaths(current_scan_path_, std::to_string(t) + "_tgt_alig");
-  boost::filesystem::create_directory(filename_ref);
-  boost::filesystem::create_directory(filename_init);
-  boost::filesystem::create_directory(filename_align);
 
-  // save clouds
-  BEAM_INFO("Saving scan registration results to {}",
-            beam::CombinePaths(current_scan_path_, std::to_string(t)));
-
-  std::string error_message{};
-  if (!beam::SavePointCloud<pcl::PointXYZRGB>(
-          filename_ref, cloud_ref_world_col,
-          beam::PointCloudFileType::PCDBINARY, error_message)) {
-    BEAM_ERROR("Unable to save cloud. Reason: {}", error_message);
-  }
-  if (!beam::SavePointCloud<pcl::PointXYZRGB>(
-          filename_init, cloud_tgt_in_world_init_col,
-          beam::PointCloudFileType::PCDBINARY, error_message)) {
-    BEAM_ERROR("Unable to save cloud. Reason: {}", error_message);
-  }
-  if (!beam::SavePointCloud<pcl::PointXYZRGB>(
-          filename_align, cloud_tgt_in_world_aligned_col,
-          beam::PointCloudFileType::PCDBINARY, error_message)) {
-    BEAM_ERROR("Unable to save cloud. Reason: {}", error_message);
+  // get loam clouds
+  std::vector<LoamPointCloud> loam_clouds;
+  if (output_loam_cloud) {
+    loam_clouds.emplace_back(scan_pose_ref.LoamCloud(), T_WORLD_LIDARREF);
+    loam_clouds.emplace_back(scan_pose_tgt.LoamCloud(), T_WORLD_LIDARTGT_INIT);
+    loam_clouds.emplace_back(scan_pose_tgt.LoamCloud(), T_WORLD_LIDARREF_OPT);
   }
 
-  if (!output_loam_cloud) { return; }
-
-  // get loam clouds
-  LoamPointCloud loam_cloud_ref_world(scan_pose_ref.LoamCloud(),
-                                      T_WORLD_LIDARREF);
-  LoamPointCloud loam_cloud_tgt_in_world_init(scan_pose_tgt.LoamCloud(),
-                                              T_WORLD_LIDARTGT_INIT);
-  LoamPointCloud loam_cloud_tgt_in_world_aligned(scan_pose_tgt.LoamCloud(),
-                                                 T_WORLD_LIDARREF_OPT);
-
-  loam_cloud_ref_world.SaveCombined(filename_ref, "loam");
-  loam_cloud_tgt_in_world_init.SaveCombined(filename_init, "loam.pcd");
-  loam_cloud_tgt_in_world_aligned.SaveCombined(filename_align, "loam.pcd");
+  // save clouds on the shared writer thread so registration is not blocked
+  BEAM_INFO("Saving scan registration results to {}",
+            beam::CombinePaths(current_scan_path_, std::to_string(t)));
+  std::vector<std::string> paths{filename_ref, filename_init, filename_align};
+  std::vector<PointCloudCol> clouds;
+  clouds.push_back(std::move(cloud_ref_world_col));
+  clouds.push_back(std::move(cloud_tgt_in_world_init_col));
+  clouds.push_back(std::move(cloud_tgt_in_world_aligned_col));
+  bs_common::AsyncDiskWriter::GetInstance().Enqueue(
+      "scan registration results",
+      [paths, clouds = std::move(clouds),
+       loam_clouds = std::move(loam_clouds)]() {
+        std::string error_message{};
+        for (size_t i = 0; i < paths.size(); i++) {
+          boost::filesystem::create_directory(paths[i]);
+          if (!beam::SavePointCloud<pcl::PointXYZRGB>(
+                  paths[i], clouds[i], beam::PointCloudFileType::PCDBINARY,
+                  error_message)) {
+            BEAM_ERROR("Unable to save cloud. Reason: {}", error_message);
+          }
+        }
+
+        if (loam_clouds.empty()) { return; }
+        loam_clouds[0].SaveCombined(paths[0], "loam");
+        loam_clouds[1].SaveCombined(paths[1], "loam.pcd");
+        loam_clouds[2].SaveCombined(paths[2], "loam.pcd");
+      });
 }
 
 MultiScanRegistration::MultiScanRegistration(
@@ -483,7 +483,15 @@ bool MultiScanRegistration::MatchScans(const ScanPose& scan_pose_ref,
     covariance_ = matcher_->GetCovariance();
   }
 
-  return registration_validation_.Validate(T_RefEst_Ref, covariance_);
+  // only estimate the covariance when needed for the degeneracy analysis
+  const Eigen::Matrix<double, 6, 6> matcher_covariance =
+      degeneracy_analysis_.Enabled() ? matcher_->GetCovariance() : covariance_;
+  if (!ValidateRegistration(T_RefEst_Ref, matcher_covariance)) {
+    return false;
+  }
+  T_LIDARREF_LIDARTGT =
+      beam::InvertTransform(T_RefEst_Ref) * T_LidarRefEst_LidarTgt;
+  return true;
 }
 
 MultiScanLoamRegistration::MultiScanLoamRegistration(
@@ -494,6 +502,11 @@ MultiScanLoamRegistration::MultiScanLoamRegistration(
                                 disable_lidar_map),
       matcher_(std::move(matcher)) {}
 
+void MultiScanLoamRegistration::SetLoamMatcherParams(
+    const beam_matching::LoamParams& params) {
+  matcher_ = std::make_unique<LoamMatcher>(params);
+}
+
 bool MultiScanLoamRegistration::MatchScans(
     const ScanPose& scan_pose_ref, const ScanPose& scan_pose_tgt,
     Eigen::Matrix4d& T_LIDARREF_LIDARTGT) {
@@ -527,7 +540,15 @@ bool MultiScanLoamRegistration::MatchScans(
 
   if (!use_fixed_covariance_) { covariance_ = matcher_->GetCovariance(); }
 
-  return registration_validation_.Validate(T_RefEst_Ref, covariance_);
+  // only estimate the covariance when needed for the degeneracy analysis
+  const Eigen::Matrix<double, 6, 6> matcher_covariance =
+      degeneracy_analysis_.Enabled() ? matcher_->GetCovariance() : covariance_;
+  if (!ValidateRegistration(T_RefEst_Ref, matcher_covariance)) {
+    return false;
+  }
+  T_LIDARREF_LIDARTGT =
+      beam::InvertTransform(T_RefEst_Ref) * T_LidarRefEst_LidarTgt;
+  return true;
 }
 
 }} // namespace bs_models::scan_registration
@@ -1,12 +1,17 @@
 #include <bs_models/scan_registration/registration_map.h>
 
+#include <fstream>
+#include <iomanip>
+
 #include <boost/filesystem.hpp>
 #include <fuse_variables/orientation_3d_stamped.h>
 #include <fuse_variables/position_3d_stamped.h>
+#include <nlohmann/json.hpp>
 #include <pcl/common/transforms.h>
 #include <pcl/io/pcd_io.h>
 
 #include <beam_filtering/VoxelDownsample.h>
+#include <beam_utils/filesystem.h>
 #include <beam_utils/math.h>
 #include <beam_utils/se3.h>
 
@@ -17,17 +22,45 @@ namespace bs_models { namespace scan_registration {
 
 using namespace beam_matching;
 
+namespace {
+
+bool SaveScans(
+    const std::map<uint64_t, RegistrationMap::ScanPoseInMapFrame>& scans,
+    const std::string& directory) {
+  nlohmann::json J;
+  J["scans"] = nlohmann::json::array();
+  std::string error_message;
+  for (const auto& [stamp_ns, scan] : scans) {
+    const std::string prefix = std::to_string(stamp_ns);
+    nlohmann::json J_scan;
+    J_scan["stamp_nsecs"] = stamp_ns;
+    beam::AddTransformToJson(J_scan, scan.T_Map_Scan, "T_Map_Scan");
+    J["scans"].push_back(J_scan);
+
+    // clouds are saved in the map frame, same as they are stored
+    if (!beam::SavePointCloud<pcl::PointXYZ>(
+            beam::CombinePaths(directory, prefix + "_cloud.pcd"), scan.cloud,
+            beam::PointCloudFileType::PCDBINARY, error_message)) {
+      BEAM_ERROR("Unable to save cloud. Reason: {}", error_message);
+      return false;
+    }
+    if (!scan.loam_cloud.Empty()) {
+      scan.loam_cloud.SaveCombined(directory, prefix + "_loam.pcd", 255, 255,
+                                   255, false);
+    }
+  }
+
+  std::ofstream file(beam::CombinePaths(directory, "registration_map.json"));
+  file << std::setw(4) << J << std::endl;
+  return file.good();
+}
+
+} // namespace
+
 RegistrationMap::RegistrationMap() {
   bs_common::ExtrinsicsLookupOnline& extrinsics_online =
       bs_common::ExtrinsicsLookupOnline::GetInstance();
   world_frame_id_ = extrinsics_online.GetWorldFrameId();
-
-  // setup publishers
-  ros::NodeHandle n;
-  lidar_map_publisher_ = n.advertise<sensor_msgs::PointCloud2>(
-      "/local_mapper/local_map/lidar_map", 10);
-  loam_map_publisher_ = n.advertise<sensor_msgs::PointCloud2>(
-      "/local_mapper/local_map/loam_map", 10);
 }
 
 RegistrationMap& RegistrationMap::GetInstance() {
@@ -51,12 +84,34 @@ void RegistrationMap::SetMapSize(int map_size) {
 
 void RegistrationMap::SetPublishUpdates(bool publish_updates) {
   publish_updates_ = publish_updates;
+  if (!publish_updates_ || publishers_advertised_) { return; }
+
+  // only advertise when needed so offline users don't need a ROS master
+  ros::NodeHandle n;
+  lidar_map_publisher_ = n.advertise<sensor_msgs::PointCloud2>(
+      "/local_mapper/local_map/lidar_map", 10);
+  loam_map_publisher_ = n.advertise<sensor_msgs::PointCloud2>(
+      "/local_mapper/local_map/loam_map", 10);
+  publishers_advertised_ = true;
 }
 
 void RegistrationMap::SetVoxelDownsampleSize(double downsample_voxel_size) {
   downsample_voxel_size_ = downsample_voxel_size;
 }
 
+double RegistrationMap::VoxelDownsampleSize() const {
+  return downsample_voxel_size_;
+}
+
+void RegistrationMap::SetDynamicPointFilter(
+    const DynamicPointFilter::Params& params) {
+  dynamic_point_filter_ = DynamicPointFilter(params);
+}
+
+size_t RegistrationMap::NumDynamicPointsRemoved() const {
+  return num_dynamic_points_removed_;
+}
+
 int RegistrationMap::MapSize() const {
   return map_size_;
 }
@@ -83,6 +138,11 @@ void RegistrationMap::AddPointCloud(const PointCloud& cloud,
       "fuse_variables::Orientation3DStamped", stamp, fuse_core::uuid::NIL);
   scan.position_uuid = fuse_core::uuid::generate(
       "fuse_variables::Position3DStamped", stamp, fuse_core::uuid::NIL);
+  scan.revision = ++last_revision_;
+
+  if (dynamic_point_filter_.Enabled()) {
+    RemoveDynamicPoints(stamp.toNSec(), cloud, loam_cloud);
+  }
 
   // remove cloud & pose if map is greater than max size
   if (scans_.size() > map_size_) {
@@ -93,6 +153,63 @@ void RegistrationMap::AddPointCloud(const PointCloud& cloud,
   Publish();
 }
 
+void RegistrationMap::RemoveDynamicPoints(uint64_t stamp_nsecs,
+                                          const PointCloud& cloud,
+                                          const LoamPointCloud& loam_cloud) {
+  const auto& params = dynamic_point_filter_.GetParams();
+  ScanPoseInMapFrame& new_scan = scans_.at(stamp_nsecs);
+  new_scan.visibility = cloud.empty()
+                            ? dynamic_point_filter_.BuildImage(loam_cloud)
+                            : dynamic_point_filter_.BuildImage(cloud);
+
+  // the most recent scans, newest first. Scans restored from a snapshot have
+  // no visibility image and are skipped
+  std::vector<uint64_t> recent_stamps;
+  std::vector<DynamicPointFilter::View> recent_views;
+  for (auto it = scans_.rbegin();
+       it != scans_.rend() &&
+       recent_views.size() <= static_cast<size_t>(params.max_views);
+       it++) {
+    if (!it->second.visibility) { continue; }
+    recent_stamps.push_back(it->first);
+    recent_views.push_back(DynamicPointFilter::View{
+        beam::InvertTransform(it->second.T_Map_Scan), it->second.visibility});
+  }
+
+  size_t num_removed{0};
+  for (size_t i = 0; i < recent_stamps.size(); i++) {
+    ScanPoseInMapFrame& scan = scans_.at(recent_stamps[i]);
+    std::vector<DynamicPointFilter::View> views;
+    if (recent_stamps[i] == stamp_nsecs) {
+      // new scan: check against the previous scans
+      for (size_t j = 0; j < recent_views.size(); j++) {
+        if (j != i && views.size() < static_cast<size_t>(params.max_views)) {
+          views.push_back(recent_views[j]);
+        }
+      }
+    } else {
+      // existing scan: check against the newest scans, including the new one
+      for (size_t j = 0; j < recent_views.size(); j++) {
+        if (j != i && views.size() < static_cast<size_t>(
+                                         params.min_free_observations)) {
+          views.push_back(recent_views[j]);
+        }
+      }
+    }
+    const size_t num_removed_scan =
+        dynamic_point_filter_.RemoveSeenThrough(
+            scan.cloud, views, params.min_free_observations) +
+        dynamic_point_filter_.RemoveSeenThrough(scan.loam_cloud, views,
+                                                params.min_free_observations);
+    if (num_removed_scan > 0) { scan.revision = ++last_revision_; }
+    num_removed += num_removed_scan;
+  }
+
+  num_dynamic_points_removed_ += num_removed;
+  ROS_DEBUG("Removed %zu dynamic points from the registration map",
+            num_removed);
+}
+
 PointCloud RegistrationMap::GetPointCloudMap() const {
   PointCloud cloud;
   for (auto it = scans_.begin(); it != scans_.end(); it++) {
@@ -173,6 +290,25 @@ bool RegistrationMap::UpdateScan(const ros::Time& stamp,
   return true;
 }
 
+bool RegistrationMap::UpdateScanClouds(const ros::Time& stamp,
+                                       const PointCloud& cloud,
+                                       const LoamPointCloud& loam_cloud,
+                                       bool publish) {
+  auto it = scans_.find(stamp.toNSec());
+  if (it == scans_.end()) { return false; }
+
+  auto& scan = it->second;
+  pcl::transformPointCloud(cloud, scan.cloud, scan.T_Map_Scan);
+  scan.loam_cloud = LoamPointCloud(loam_cloud, scan.T_Map_Scan);
+  scan.revision = ++last_revision_;
+  if (dynamic_point_filter_.Enabled()) {
+    RemoveDynamicPoints(stamp.toNSec(), cloud, loam_cloud);
+  }
+
+  if (publish) { Publish(); }
+  return true;
+}
+
 void RegistrationMap::Save(const std::string& save_path, bool add_frames,
                            uint8_t r, uint8_t g, uint8_t b) const {
   if (!boost::filesystem::exists(save_path)) {
@@ -221,6 +357,69 @@ void RegistrationMap::Save(const std::string& save_path, bool add_frames,
   }
 }
 
+bool RegistrationMap::SaveSnapshot(const std::string& directory) const {
+  return SaveScans(scans_, directory);
+}
+
+std::function<bool(const std::string& directory)>
+    RegistrationMap::SnapshotWriter() const {
+  std::shared_ptr<const std::map<uint64_t, ScanPoseInMapFrame>> scans;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    scans = std::make_shared<const std::map<uint64_t, ScanPoseInMapFrame>>(
+        scans_);
+  }
+  return [scans](const std::string& directory) {
+    return SaveScans(*scans, directory);
+  };
+}
+
+bool RegistrationMap::LoadSnapshot(const std::string& directory) {
+  nlohmann::json J;
+  if (!beam::ReadJson(beam::CombinePaths(directory, "registration_map.json"),
+                      J)) {
+    return false;
+  }
+
+  std::map<uint64_t, ScanPoseInMapFrame> scans;
+  for (const auto& J_scan : J["scans"]) {
+    const uint64_t stamp_ns = J_scan["stamp_nsecs"];
+    const std::string prefix = std::to_string(stamp_ns);
+    ros::Time stamp;
+    stamp.fromNSec(stamp_ns);
+
+    ScanPoseInMapFrame& scan = scans[stamp_ns];
+    std::vector<double> T_vec = J_scan["T_Map_Scan"];
+    scan.T_Map_Scan = beam::VectorToEigenTransform(T_vec);
+    const std::string cloud_path =
+        beam::CombinePaths(directory, prefix + "_cloud.pcd");
+    if (pcl::io::loadPCDFile<pcl::PointXYZ>(cloud_path, scan.cloud) == -1) {
+      BEAM_ERROR("Couldn't read pointcloud file: {}", cloud_path);
+      return false;
+    }
+    const std::string loam_path =
+        beam::CombinePaths(directory, prefix + "_loam.pcd");
+    if (boost::filesystem::exists(loam_path)) {
+      LoamPointCloudCombined loam_combined;
+      if (pcl::io::loadPCDFile<PointLoam>(loam_path, loam_combined) == -1) {
+        BEAM_ERROR("Couldn't read pointcloud file: {}", loam_path);
+        return false;
+      }
+      scan.loam_cloud.LoadFromCombined(loam_combined);
+    }
+    scan.orientation_uuid = fuse_core::uuid::generate(
+        "fuse_variables::Orientation3DStamped", stamp, fuse_core::uuid::NIL);
+    scan.position_uuid = fuse_core::uuid::generate(
+        "fuse_variables::Position3DStamped", stamp, fuse_core::uuid::NIL);
+    scan.revision = ++last_revision_;
+  }
+
+  scans_ = std::move(scans);
+  while (scans_.size() > map_size_) { scans_.erase(scans_.begin()); }
+  Publish();
+  return true;
+}
+
 bool RegistrationMap::GetScanPose(const ros::Time& stamp,
                                   Eigen::Matrix4d& T_Map_Scan) const {
   auto iter = scans_.find(stamp.toNSec());
@@ -230,6 +429,26 @@ bool RegistrationMap::GetScanPose(const ros::Time& stamp,
   return true;
 }
 
+bool RegistrationMap::GetScanRevision(const ros::Time& stamp,
+                                      uint64_t& revision) const {
+  auto iter = scans_.find(stamp.toNSec());
+  if (iter == scans_.end()) { return false; }
+
+  revision = iter->second.revision;
+  return true;
+}
+
+std::vector<ros::Time> RegistrationMap::GetScanStamps() const {
+  std::vector<ros::Time> stamps;
+  stamps.reserve(scans_.size());
+  for (const auto& [stamp_ns, scan] : scans_) {
+    ros::Time stamp;
+    stamp.fromNSec(stamp_ns);
+    stamps.push_back(stamp);
+  }
+  return stamps;
+}
+
 bool RegistrationMap::GetScanInMapFrame(const ros::Time& stamp,
                                         PointCloud& cloud) const {
   auto iter = scans_.find(stamp.toNSec());
@@ -0,0 +1,199 @@
+#include <bs_models/scan_registration/registration_profile_tuner.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/filesystem.hpp>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_models { namespace scan_registration {
+
+namespace {
+
+int InterpolateInt(int min, int max, double level) {
+  return static_cast<int>(std::round(min + level * (max - min)));
+}
+
+double InterpolateDouble(double min, double max, double level) {
+  return min + level * (max - min);
+}
+
+} // namespace
+
+bool RegistrationProfile::operator==(const RegistrationProfile& other) const {
+  return map_size == other.map_size &&
+         max_corner_sharp == other.max_corner_sharp &&
+         max_corner_less_sharp == other.max_corner_less_sharp &&
+         max_surface_flat == other.max_surface_flat &&
+         max_correspondence_iterations ==
+             other.max_correspondence_iterations &&
+         max_solver_time_in_seconds == other.max_solver_time_in_seconds;
+}
+
+void RegistrationProfile::LoadFromJson(const nlohmann::json& J) {
+  beam::ValidateJsonKeysOrThrow(
+      {"map_size", "max_corner_sharp", "max_corner_less_sharp",
+       "max_surface_flat", "max_correspondence_iterations",
+       "max_solver_time_in_seconds"},
+      J);
+  map_size = J["map_size"];
+  max_corner_sharp = J["max_corner_sharp"];
+  max_corner_less_sharp = J["max_corner_less_sharp"];
+  max_surface_flat = J["max_surface_flat"];
+  max_correspondence_iterations = J["max_correspondence_iterations"];
+  max_solver_time_in_seconds = J["max_solver_time_in_seconds"];
+}
+
+void RegistrationProfile::Print(std::ostream& stream) const {
+  stream << "map_size: " << map_size << "\n";
+  stream << "max_corner_sharp: " << max_corner_sharp << "\n";
+  stream << "max_corner_less_sharp: " << max_corner_less_sharp << "\n";
+  stream << "max_surface_flat: " << max_surface_flat << "\n";
+  stream << "max_correspondence_iterations: " << max_correspondence_iterations
+         << "\n";
+  stream << "max_solver_time_in_seconds: " << max_solver_time_in_seconds
+         << "\n";
+}
+
+void RegistrationProfileTuner::Params::LoadFromJson(const std::string& config) {
+  if (!boost::filesystem::exists(config)) {
+    BEAM_ERROR("Invalid registration tuning config path, file does not exist: "
+               "{}",
+               config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+
+  nlohmann::json J;
+  if (!beam::ReadJson(config, J)) {
+    BEAM_ERROR("Unable to read registration tuning config: {}", config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+  beam::ValidateJsonKeysOrThrow(
+      {"enabled", "initial_level", "level_step", "high_load_ratio",
+       "low_load_ratio", "load_smoothing", "cooldown_scans", "min_profile",
+       "max_profile"},
+      J);
+
+  enabled = J["enabled"];
+  initial_level = J["initial_level"];
+  level_step = J["level_step"];
+  high_load_ratio = J["high_load_ratio"];
+  low_load_ratio = J["low_load_ratio"];
+  load_smoothing = J["load_smoothing"];
+  cooldown_scans = J["cooldown_scans"];
+  min_profile.LoadFromJson(J["min_profile"]);
+  max_profile.LoadFromJson(J["max_profile"]);
+
+  if (initial_level < 0 || initial_level > 1 || level_step <= 0 ||
+      level_step > 1) {
+    BEAM_ERROR("initial_level must be in [0, 1] and level_step in (0, 1]");
+    throw std::runtime_error{"invalid registration tuning params"};
+  }
+  if (low_load_ratio >= high_load_ratio) {
+    BEAM_ERROR("low_load_ratio ({}) must be less than high_load_ratio ({})",
+               low_load_ratio, high_load_ratio);
+    throw std::runtime_error{"invalid registration tuning params"};
+  }
+  if (load_smoothing <= 0 || load_smoothing > 1) {
+    BEAM_ERROR("load_smoothing must be in (0, 1], input: {}", load_smoothing);
+    throw std::runtime_error{"invalid registration tuning params"};
+  }
+  if (min_profile.map_size < 1 ||
+      min_profile.max_correspondence_iterations < 1 ||
+      min_profile.max_solver_time_in_seconds <= 0) {
+    BEAM_ERROR("min_profile must have a map_size and "
+               "max_correspondence_iterations of at least 1, and a positive "
+               "max_solver_time_in_seconds");
+    throw std::runtime_error{"invalid registration tuning params"};
+  }
+}
+
+void RegistrationProfileTuner::Params::Print(std::ostream& stream) const {
+  stream << "RegistrationProfileTuner::Params: \n";
+  stream << "enabled: " << enabled << "\n";
+  stream << "initial_level: " << initial_level << "\n";
+  stream << "level_step: " << level_step << "\n";
+  stream << "high_load_ratio: " << high_load_ratio << "\n";
+  stream << "low_load_ratio: " << low_load_ratio << "\n";
+  stream << "load_smoothing: " << load_smoothing << "\n";
+  stream << "cooldown_scans: " << cooldown_scans << "\n";
+  stream << "min_profile: \n";
+  min_profile.Print(stream);
+  stream << "max_profile: \n";
+  max_profile.Print(stream);
+}
+
+RegistrationProfileTuner::RegistrationProfileTuner(const Params& params)
+    : params_(params) {
+  Reset();
+}
+
+bool RegistrationProfileTuner::AddMeasurement(const ros::Time& stamp,
+                                              double processing_time_s) {
+  if (last_stamp_.isZero() || stamp <= last_stamp_) {
+    last_stamp_ = stamp;
+    return false;
+  }
+  const double scan_period = (stamp - last_stamp_).toSec();
+  last_stamp_ = stamp;
+
+  const double load = processing_time_s / scan_period;
+  if (!load_initialized_) {
+    load_ = load;
+    load_initialized_ = true;
+  } else {
+    load_ = params_.load_smoothing * load + (1 - params_.load_smoothing) * load_;
+  }
+
+  if (!params_.enabled) { return false; }
+
+  scans_since_change_++;
+  if (scans_since_change_ < params_.cooldown_scans) { return false; }
+
+  double new_level = level_;
+  if (load_ > params_.high_load_ratio) {
+    new_level = std::max(level_ - params_.level_step, 0.0);
+  } else if (load_ < params_.low_load_ratio) {
+    new_level = std::min(level_ + params_.level_step, 1.0);
+  }
+  if (new_level == level_) { return false; }
+
+  level_ = new_level;
+  scans_since_change_ = 0;
+  RegistrationProfile profile = Interpolate(level_);
+  if (profile == profile_) { return false; }
+  profile_ = profile;
+  return true;
+}
+
+void RegistrationProfileTuner::Reset() {
+  level_ = std::clamp(params_.initial_level, 0.0, 1.0);
+  profile_ = Interpolate(level_);
+  load_ = 0;
+  load_initialized_ = false;
+  scans_since_change_ = 0;
+  last_stamp_ = ros::Time(0);
+}
+
+RegistrationProfile RegistrationProfileTuner::Interpolate(double level) const {
+  const auto& min = params_.min_profile;
+  const auto& max = params_.max_profile;
+  RegistrationProfile profile;
+  profile.map_size = InterpolateInt(min.map_size, max.map_size, level);
+  profile.max_corner_sharp =
+      InterpolateInt(min.max_corner_sharp, max.max_corner_sharp, level);
+  profile.max_corner_less_sharp = InterpolateInt(
+      min.max_corner_less_sharp, max.max_corner_less_sharp, level);
+  profile.max_surface_flat =
+      InterpolateInt(min.max_surface_flat, max.max_surface_flat, level);
+  profile.max_correspondence_iterations =
+      InterpolateInt(min.max_correspondence_iterations,
+                     max.max_correspondence_iterations, level);
+  profile.max_solver_time_in_seconds = InterpolateDouble(
+      min.max_solver_time_in_seconds, max.max_solver_time_in_seconds, level);
+  return profile;
+}
+
+}} // namespace bs_models::scan_registration
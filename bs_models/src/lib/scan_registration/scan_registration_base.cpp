@@ -37,6 +37,29 @@ std::unique_ptr<ScanRegistrationBase> ScanRegistrationBase::Create(
     throw std::invalid_argument{"invalid json"};
   }
   std::string registration_type = J["registration_type"];
+
+  // voxel gaussian matching is implemented here rather than in beam_matching,
+  // so check for it before reading the matcher type
+  if (VoxelGaussianMatcher::IsConfig(matcher_config)) {
+    if (registration_type != "SCANTOMAP") {
+      BEAM_ERROR("voxel gaussian matching is only implemented for SCANTOMAP "
+                 "registration");
+      throw std::runtime_error{"function not implemented"};
+    }
+    VoxelGaussianMatcher::Params matcher_params;
+    matcher_params.LoadFromJson(matcher_config);
+    ScanToMapVoxelGaussianRegistration::Params params;
+    params.LoadFromJson(registration_config);
+    params.save_path = save_path;
+    std::unique_ptr<scan_registration::ScanRegistrationBase> registration =
+        std::make_unique<ScanToMapVoxelGaussianRegistration>(
+            std::make_unique<VoxelGaussianMatcher>(matcher_params),
+            params.GetBaseParams(), params.map_size,
+            params.downsample_voxel_size);
+    registration->SetExtrinsicsPrior(extrinsics_prior);
+    return std::move(registration);
+  }
+
   MatcherType matcher_type = beam_matching::GetTypeFromConfig(matcher_config);
   std::unique_ptr<scan_registration::ScanRegistrationBase> registration;
 
@@ -116,6 +139,13 @@ void ScanRegistrationParamsBase::Print(std::ostream& stream) const {
   stream << "max_motion_trans_m: " << max_motion_trans_m << "\n";
   stream << "fix_first_scan: " << fix_first_scan << "\n";
   stream << "save_path: " << save_path << "\n";
+  stream << "degeneracy.enabled: " << degeneracy.enabled << "\n";
+  stream << "degeneracy.min_translation_information: "
+         << degeneracy.min_translation_information << "\n";
+  stream << "degeneracy.min_rotation_information: "
+         << degeneracy.min_rotation_information << "\n";
+  stream << "degeneracy.degenerate_variance: "
+         << degeneracy.degenerate_variance << "\n";
 }
 
 void ScanRegistrationParamsBase::LoadBaseFromJson(const std::string& config) {
@@ -144,15 +174,20 @@ void ScanRegistrationParamsBase::LoadBaseFromJson(const std::string& config) {
   min_motion_rot_deg = J["min_motion_rot_deg"];
   max_motion_trans_m = J["max_motion_trans_m"];
   fix_first_scan = J["fix_first_scan"];
+
+  // optional, older configs do not have it
+  if (J.contains("degeneracy")) { degeneracy.LoadFromJson(J["degeneracy"]); }
 }
 
 ScanRegistrationBase::ScanRegistrationBase(
     const ScanRegistrationParamsBase& base_params)
-    : base_params_(base_params) {}
+    : base_params_(base_params),
+      degeneracy_analysis_(base_params.degeneracy) {}
 
 void ScanRegistrationBase::SetFixedCovariance(
     const Eigen::Matrix<double, 6, 6>& covariance) {
   covariance_ = covariance;
+  fixed_covariance_ = covariance;
   use_fixed_covariance_ = true;
 }
 
@@ -161,6 +196,7 @@ void ScanRegistrationBase::SetFixedCovariance(double covariance) {
   cov_vec << covariance, covariance, covariance, covariance, covariance,
       covariance;
   covariance_ = cov_vec.asDiagonal();
+  fixed_covariance_ = covariance_;
   use_fixed_covariance_ = true;
 }
 
@@ -206,6 +242,44 @@ bool ScanRegistrationBase::PassedMotionThresholds(
   return (passed_trans || passed_rot);
 }
 
+bool ScanRegistrationBase::ValidateRegistration(
+    Eigen::Matrix4d& T_correction,
+    const Eigen::Matrix<double, 6, 6>& matcher_covariance,
+    const Eigen::Matrix3d& R_CONSTRAINT_CORRECTION) {
+  // covariance_ may have been shaped for the previous result
+  if (use_fixed_covariance_) { covariance_ = fixed_covariance_; }
+  if (!degeneracy_analysis_.Enabled()) {
+    return registration_validation_.Validate(T_correction, covariance_);
+  }
+
+  const DegeneracyAnalysis::Result result =
+      degeneracy_analysis_.Analyze(matcher_covariance);
+  if (!result.Degenerate()) {
+    return registration_validation_.Validate(T_correction, covariance_);
+  }
+
+  ROS_WARN_THROTTLE(5,
+                    "Degenerate scan registration, %d translation and %d "
+                    "rotation directions are not constrained.",
+                    result.NumDegenerateTranslation(),
+                    result.NumDegenerateRotation());
+  T_correction =
+      degeneracy_analysis_.ConstrainCorrection(T_correction, result);
+  if (!registration_validation_.Validate(
+          T_correction,
+          degeneracy_analysis_.ValidationCovariance(covariance_, result))) {
+    return false;
+  }
+
+  Eigen::Matrix<double, 6, 6> R = Eigen::Matrix<double, 6, 6>::Zero();
+  R.block<3, 3>(0, 0) = R_CONSTRAINT_CORRECTION;
+  R.block<3, 3>(3, 3) = R_CONSTRAINT_CORRECTION;
+  covariance_ =
+      R * degeneracy_analysis_.ShapeCovariance(covariance_, result) *
+      R.transpose();
+  return true;
+}
+
 void ScanRegistrationBase::SetInformationWeight(double w) {
   covariance_weight_ = 1 / (w * w);
 }
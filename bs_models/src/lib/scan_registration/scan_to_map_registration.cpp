@@ -1,8 +1,12 @@
 #include <bs_models/scan_registration/scan_to_map_registration.h>
 
+#include <set>
+
 #include <fuse_constraints/absolute_pose_3d_stamped_constraint.h>
 #include <fuse_core/transaction.h>
+#include <pcl/common/transforms.h>
 
+#include <beam_filtering/VoxelDownsample.h>
 #include <beam_matching/Matchers.h>
 
 #include <bs_common/conversions.h>
@@ -150,7 +154,8 @@ ScanRegistrationParamsBase
       .min_motion_rot_deg = min_motion_rot_deg,
       .max_motion_trans_m = max_motion_trans_m,
       .fix_first_scan = fix_first_scan,
-      .save_path = save_path};
+      .save_path = save_path,
+      .degeneracy = degeneracy};
   return base_params;
 }
 
@@ -165,6 +170,11 @@ ScanToMapLoamRegistration::ScanToMapLoamRegistration(
   map_.SetVoxelDownsampleSize(params_.downsample_voxel_size);
 }
 
+void ScanToMapLoamRegistration::SetLoamMatcherParams(
+    const beam_matching::LoamParams& params) {
+  matcher_ = std::make_unique<LoamMatcher>(params);
+}
+
 bool ScanToMapLoamRegistration::RegisterScanToMap(const ScanPose& scan_pose,
                                                   Eigen::Matrix4d& T_MAP_SCAN) {
   const Eigen::Matrix4d& T_MAPEST_SCAN = scan_pose.T_REFFRAME_LIDAR();
@@ -189,7 +199,12 @@ bool ScanToMapLoamRegistration::RegisterScanToMap(const ScanPose& scan_pose,
 
   if (!use_fixed_covariance_) { covariance_ = matcher_->GetCovariance(); }
 
-  if (registration_validation_.Validate(T_MAPEST_MAP, covariance_)) {
+  // the correction and its covariance are in the map frame, while the
+  // constraint is relative to the previous scan
+  const Eigen::Matrix3d R_SCANPREV_MAP =
+      T_MAP_SCANPREV.block<3, 3>(0, 0).transpose();
+  if (ValidateRegistration(T_MAPEST_MAP, matcher_->GetCovariance(),
+                           R_SCANPREV_MAP)) {
     T_MAP_SCAN = beam::InvertTransform(T_MAPEST_MAP) * T_MAPEST_SCAN;
     return true;
   }
@@ -202,4 +217,133 @@ void ScanToMapLoamRegistration::AddScanToMap(
                      scan_pose.Stamp(), T_MAP_SCAN);
 }
 
+ScanToMapVoxelGaussianRegistration::ScanToMapVoxelGaussianRegistration(
+    std::unique_ptr<VoxelGaussianMatcher> matcher,
+    const ScanRegistrationParamsBase& base_params, int map_size,
+    double downsample_voxel_size)
+    : ScanToMapRegistrationBase(base_params),
+      matcher_(std::move(matcher)),
+      params_(base_params, map_size, downsample_voxel_size),
+      voxel_map_(matcher_->GetParams().voxel_size,
+                 matcher_->GetParams().min_points_per_voxel,
+                 matcher_->GetParams().covariance_regularization) {
+  map_.SetMapSize(params_.map_size);
+  map_.SetVoxelDownsampleSize(params_.downsample_voxel_size);
+}
+
+bool ScanToMapVoxelGaussianRegistration::RegisterScanToMap(
+    const ScanPose& scan_pose, Eigen::Matrix4d& T_MAP_SCAN) {
+  const Eigen::Matrix4d& T_MAPEST_SCAN = scan_pose.T_REFFRAME_LIDAR();
+  const Eigen::Matrix4d& T_MAP_SCANPREV = scan_pose_prev_->T_REFFRAME_LIDAR();
+  Eigen::Matrix4d T_SCANPREV_SCANNEW =
+      beam::InvertTransform(T_MAP_SCANPREV) * T_MAPEST_SCAN;
+  if (!PassedMotionThresholds(T_SCANPREV_SCANNEW)) { return false; }
+
+  SyncVoxelMap();
+  const PointCloud source =
+      Downsample(scan_pose.Cloud(), matcher_->GetParams().source_voxel_size);
+  Eigen::Matrix4d T_MAP_SCAN_EST = T_MAPEST_SCAN;
+  if (!matcher_->Match(source, voxel_map_, T_MAP_SCAN_EST)) { return false; }
+
+  // express the result as a correction, same as the loam registration
+  Eigen::Matrix4d T_MAPEST_MAP =
+      T_MAPEST_SCAN * beam::InvertTransform(T_MAP_SCAN_EST);
+
+  if (!use_fixed_covariance_) { covariance_ = matcher_->GetCovariance(); }
+
+  const Eigen::Matrix3d R_SCANPREV_MAP =
+      T_MAP_SCANPREV.block<3, 3>(0, 0).transpose();
+  if (ValidateRegistration(T_MAPEST_MAP, matcher_->GetCovariance(),
+                           R_SCANPREV_MAP)) {
+    T_MAP_SCAN = beam::InvertTransform(T_MAPEST_MAP) * T_MAPEST_SCAN;
+    return true;
+  }
+  return false;
+}
+
+void ScanToMapVoxelGaussianRegistration::AddScanToMap(
+    const ScanPose& scan_pose, const Eigen::Matrix4d& T_MAP_SCAN) {
+  map_.AddPointCloud(scan_pose.Cloud(), scan_pose.LoamCloud(),
+                     scan_pose.Stamp(), T_MAP_SCAN);
+
+  // the scan is inserted from the registration map, after the dynamic point
+  // filter, and the oldest scan is removed if the map trimmed it
+  SyncVoxelMap();
+}
+
+void ScanToMapVoxelGaussianRegistration::SyncVoxelMap() {
+  if (map_.Empty()) {
+    voxel_map_.Clear();
+    voxel_map_scans_.clear();
+    return;
+  }
+
+  // remove scans that were trimmed from the registration map, reinsert those
+  // whose points changed and move those whose poses were updated
+  std::set<ros::Time> stamps_in_voxel_map;
+  auto it = voxel_map_scans_.begin();
+  while (it != voxel_map_scans_.end()) {
+    Eigen::Matrix4d T_MAP_SCAN;
+    uint64_t revision;
+    if (!map_.GetScanPose(it->stamp, T_MAP_SCAN) ||
+        !map_.GetScanRevision(it->stamp, revision)) {
+      voxel_map_.RemovePoints(it->cloud, it->T_MAP_SCAN);
+      it = voxel_map_scans_.erase(it);
+      continue;
+    }
+    if (revision != it->revision) {
+      voxel_map_.RemovePoints(it->cloud, it->T_MAP_SCAN);
+      GetMapScan(it->stamp, *it);
+      voxel_map_.AddPoints(it->cloud, it->T_MAP_SCAN);
+    } else if (!T_MAP_SCAN.isApprox(it->T_MAP_SCAN)) {
+      voxel_map_.RemovePoints(it->cloud, it->T_MAP_SCAN);
+      it->T_MAP_SCAN = T_MAP_SCAN;
+      voxel_map_.AddPoints(it->cloud, it->T_MAP_SCAN);
+    }
+    stamps_in_voxel_map.insert(it->stamp);
+    ++it;
+  }
+
+  // insert new scans, including those added or loaded externally (e.g. from a
+  // prior map), keeping the scans ordered by stamp
+  it = voxel_map_scans_.begin();
+  for (const ros::Time& stamp : map_.GetScanStamps()) {
+    while (it != voxel_map_scans_.end() && it->stamp < stamp) { ++it; }
+    if (stamps_in_voxel_map.find(stamp) != stamps_in_voxel_map.end()) {
+      continue;
+    }
+    VoxelMapScan scan;
+    if (!GetMapScan(stamp, scan)) { continue; }
+    voxel_map_.AddPoints(scan.cloud, scan.T_MAP_SCAN);
+    voxel_map_scans_.insert(it, std::move(scan));
+  }
+}
+
+bool ScanToMapVoxelGaussianRegistration::GetMapScan(
+    const ros::Time& stamp, VoxelMapScan& scan) const {
+  PointCloud cloud_in_map_frame;
+  if (!map_.GetScanPose(stamp, scan.T_MAP_SCAN) ||
+      !map_.GetScanRevision(stamp, scan.revision) ||
+      !map_.GetScanInMapFrame(stamp, cloud_in_map_frame)) {
+    return false;
+  }
+  scan.stamp = stamp;
+  PointCloud cloud_in_scan_frame;
+  pcl::transformPointCloud(cloud_in_map_frame, cloud_in_scan_frame,
+                           beam::InvertTransform(scan.T_MAP_SCAN));
+  scan.cloud = Downsample(cloud_in_scan_frame, params_.downsample_voxel_size);
+  return true;
+}
+
+PointCloud ScanToMapVoxelGaussianRegistration::Downsample(
+    const PointCloud& cloud, double voxel_size) const {
+  if (voxel_size <= 0) { return cloud; }
+  beam_filtering::VoxelDownsample voxel_filter(
+      Eigen::Vector3f(voxel_size, voxel_size, voxel_size));
+  auto cloud_ptr = std::make_shared<PointCloud>(cloud);
+  voxel_filter.SetInputCloud(cloud_ptr);
+  voxel_filter.Filter();
+  return voxel_filter.GetFilteredCloud();
+}
+
 }} // namespace bs_models::scan_registration
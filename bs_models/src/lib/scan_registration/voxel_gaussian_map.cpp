@@ -0,0 +1,155 @@
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace bs_models { namespace scan_registration {
+
+namespace {
+
+// voxel coordinates are packed into 21 bits each
+constexpr int kVoxelBits = 21;
+constexpr int64_t kVoxelBias = int64_t(1) << (kVoxelBits - 1);
+constexpr uint64_t kVoxelMask = (uint64_t(1) << kVoxelBits) - 1;
+
+} // namespace
+
+VoxelGaussianMap::VoxelGaussianMap(double voxel_size, int min_points_per_voxel,
+                                   double covariance_regularization)
+    : voxel_size_(voxel_size),
+      inverse_voxel_size_(1.0 / voxel_size),
+      min_points_per_voxel_(std::max(min_points_per_voxel, 3)),
+      covariance_regularization_(covariance_regularization) {}
+
+uint64_t VoxelGaussianMap::Key(const Eigen::Vector3i& coordinates) {
+  // coordinates out of range wrap around, which only happens for maps larger
+  // than 2^20 voxels from the origin
+  const uint64_t x = static_cast<uint64_t>(coordinates[0] + kVoxelBias);
+  const uint64_t y = static_cast<uint64_t>(coordinates[1] + kVoxelBias);
+  const uint64_t z = static_cast<uint64_t>(coordinates[2] + kVoxelBias);
+  return ((z & kVoxelMask) << (2 * kVoxelBits)) |
+         ((y & kVoxelMask) << kVoxelBits) | (x & kVoxelMask);
+}
+
+Eigen::Vector3i
+    VoxelGaussianMap::Coordinates(const Eigen::Vector3d& p_MAP) const {
+  return Eigen::Vector3i(
+      static_cast<int>(std::floor(p_MAP[0] * inverse_voxel_size_)),
+      static_cast<int>(std::floor(p_MAP[1] * inverse_voxel_size_)),
+      static_cast<int>(std::floor(p_MAP[2] * inverse_voxel_size_)));
+}
+
+void VoxelGaussianMap::AddPoints(const PointCloud& cloud,
+                                 const Eigen::Matrix4d& T_MAP_CLOUD) {
+  Update(cloud, T_MAP_CLOUD, 1);
+}
+
+void VoxelGaussianMap::RemovePoints(const PointCloud& cloud,
+                                    const Eigen::Matrix4d& T_MAP_CLOUD) {
+  Update(cloud, T_MAP_CLOUD, -1);
+}
+
+void VoxelGaussianMap::Clear() {
+  voxels_.clear();
+  num_points_ = 0;
+}
+
+void VoxelGaussianMap::Update(const PointCloud& cloud,
+                              const Eigen::Matrix4d& T_MAP_CLOUD, int sign) {
+  const Eigen::Matrix3d R = T_MAP_CLOUD.block<3, 3>(0, 0);
+  const Eigen::Vector3d t = T_MAP_CLOUD.block<3, 1>(0, 3);
+  std::vector<uint64_t> touched;
+  for (const auto& point : cloud) {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) ||
+        !std::isfinite(point.z)) {
+      continue;
+    }
+    const Eigen::Vector3d p =
+        R * Eigen::Vector3d(point.x, point.y, point.z) + t;
+    const uint64_t key = Key(Coordinates(p));
+    if (sign < 0 && voxels_.find(key) == voxels_.end()) { continue; }
+    Voxel& voxel = voxels_[key];
+    voxel.num_points += sign;
+    voxel.sum += sign * p;
+    voxel.sum_outer += sign * p * p.transpose();
+    num_points_ += sign;
+    touched.push_back(key);
+  }
+
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+  for (uint64_t key : touched) {
+    auto it = voxels_.find(key);
+    if (it->second.num_points <= 0) {
+      voxels_.erase(it);
+      continue;
+    }
+    ComputeDistribution(it->second);
+  }
+}
+
+void VoxelGaussianMap::ComputeDistribution(Voxel& voxel) const {
+  voxel.valid = false;
+  if (voxel.num_points < min_points_per_voxel_) { return; }
+
+  const double n = voxel.num_points;
+  voxel.mean = voxel.sum / n;
+  const Eigen::Matrix3d covariance =
+      (voxel.sum_outer - n * voxel.mean * voxel.mean.transpose()) / (n - 1);
+
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  const double max_eigenvalue = solver.eigenvalues()[2];
+  if (!(max_eigenvalue > 0)) { return; }
+  const double min_eigenvalue = covariance_regularization_ * max_eigenvalue;
+  Eigen::Vector3d inverse_eigenvalues;
+  for (int i = 0; i < 3; i++) {
+    inverse_eigenvalues[i] =
+        1.0 / std::max(solver.eigenvalues()[i], min_eigenvalue);
+  }
+  voxel.information = solver.eigenvectors() * inverse_eigenvalues.asDiagonal() *
+                      solver.eigenvectors().transpose();
+  voxel.valid = true;
+}
+
+const VoxelGaussianMap::Voxel*
+    VoxelGaussianMap::Find(const Eigen::Vector3d& p_MAP) const {
+  return Find(Coordinates(p_MAP));
+}
+
+const VoxelGaussianMap::Voxel*
+    VoxelGaussianMap::Find(const Eigen::Vector3i& coordinates) const {
+  auto it = voxels_.find(Key(coordinates));
+  if (it == voxels_.end()) { return nullptr; }
+  return &it->second;
+}
+
+size_t VoxelGaussianMap::NumVoxels() const {
+  return voxels_.size();
+}
+
+size_t VoxelGaussianMap::NumValidVoxels() const {
+  return std::count_if(voxels_.begin(), voxels_.end(),
+                       [](const auto& v) { return v.second.valid; });
+}
+
+size_t VoxelGaussianMap::NumPoints() const {
+  return num_points_;
+}
+
+double VoxelGaussianMap::MeanThickness() const {
+  double sum{0};
+  int num_voxels{0};
+  for (const auto& [key, voxel] : voxels_) {
+    if (!voxel.valid) { continue; }
+    const double n = voxel.num_points;
+    const Eigen::Matrix3d covariance =
+        (voxel.sum_outer - n * voxel.mean * voxel.mean.transpose()) / (n - 1);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+    sum += std::sqrt(std::max(solver.eigenvalues()[0], 0.0));
+    num_voxels++;
+  }
+  return num_voxels == 0 ? 0 : sum / num_voxels;
+}
+
+}} // namespace bs_models::scan_registration
@@ -0,0 +1,187 @@
+#include <bs_models/scan_registration/voxel_gaussian_matcher.h>
+
+#include <cmath>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_models { namespace scan_registration {
+
+namespace {
+
+const std::string kMatcherType{"VOXEL_GAUSSIAN"};
+
+Eigen::Matrix3d SkewSymmetric(const Eigen::Vector3d& v) {
+  Eigen::Matrix3d S;
+  S << 0, -v[2], v[1], v[2], 0, -v[0], -v[1], v[0], 0;
+  return S;
+}
+
+} // namespace
+
+void VoxelGaussianMatcher::Params::LoadFromJson(const std::string& config) {
+  if (!boost::filesystem::exists(config)) {
+    BEAM_ERROR("Invalid voxel gaussian matcher config path, file does not "
+               "exist: {}",
+               config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+
+  nlohmann::json J;
+  if (!beam::ReadJson(config, J)) {
+    BEAM_ERROR("Unable to read voxel gaussian matcher config: {}", config);
+    throw std::runtime_error{"Unable to read config"};
+  }
+  beam::ValidateJsonKeysOrThrow(
+      {"matcher_type", "voxel_size", "min_points_per_voxel",
+       "covariance_regularization", "source_voxel_size", "max_iterations",
+       "translation_eps_m", "rotation_eps_deg", "max_mahalanobis_distance",
+       "search_neighbors", "min_correspondences"},
+      J);
+
+  if (J["matcher_type"] != kMatcherType) {
+    BEAM_ERROR("Invalid matcher_type for voxel gaussian matcher config: {}",
+               config);
+    throw std::runtime_error{"invalid voxel gaussian matcher params"};
+  }
+
+  voxel_size = J["voxel_size"];
+  min_points_per_voxel = J["min_points_per_voxel"];
+  covariance_regularization = J["covariance_regularization"];
+  source_voxel_size = J["source_voxel_size"];
+  max_iterations = J["max_iterations"];
+  translation_eps_m = J["translation_eps_m"];
+  rotation_eps_deg = J["rotation_eps_deg"];
+  max_mahalanobis_distance = J["max_mahalanobis_distance"];
+  search_neighbors = J["search_neighbors"];
+  min_correspondences = J["min_correspondences"];
+
+  if (voxel_size <= 0 || covariance_regularization <= 0 ||
+      covariance_regularization > 1 || max_iterations < 1) {
+    BEAM_ERROR("Invalid voxel gaussian matcher params, voxel_size and "
+               "max_iterations must be positive and covariance_regularization "
+               "in (0, 1]");
+    throw std::runtime_error{"invalid voxel gaussian matcher params"};
+  }
+}
+
+bool VoxelGaussianMatcher::IsConfig(const std::string& config) {
+  if (!boost::filesystem::exists(config)) { return false; }
+  nlohmann::json J;
+  if (!beam::ReadJson(config, J)) { return false; }
+  return J.contains("matcher_type") && J["matcher_type"] == kMatcherType;
+}
+
+VoxelGaussianMatcher::VoxelGaussianMatcher(const Params& params)
+    : params_(params) {}
+
+const VoxelGaussianMap::Voxel* VoxelGaussianMatcher::FindCorrespondence(
+    const VoxelGaussianMap& map, const Eigen::Vector3d& p_MAP) const {
+  const Eigen::Vector3i center = map.Coordinates(p_MAP);
+  const VoxelGaussianMap::Voxel* voxel = map.Find(center);
+  if (!params_.search_neighbors) {
+    return voxel && voxel->valid ? voxel : nullptr;
+  }
+
+  static const Eigen::Vector3i kOffsets[6] = {
+      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+  const VoxelGaussianMap::Voxel* best{nullptr};
+  double best_distance = std::numeric_limits<double>::max();
+  auto check = [&](const VoxelGaussianMap::Voxel* candidate) {
+    if (!candidate || !candidate->valid) { return; }
+    const Eigen::Vector3d r = p_MAP - candidate->mean;
+    const double distance = r.dot(candidate->information * r);
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = candidate;
+    }
+  };
+  check(voxel);
+  for (const auto& offset : kOffsets) {
+    check(map.Find(Eigen::Vector3i(center + offset)));
+  }
+  return best;
+}
+
+bool VoxelGaussianMatcher::Match(const PointCloud& source,
+                                 const VoxelGaussianMap& map,
+                                 Eigen::Matrix4d& T_MAP_SOURCE) {
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+  using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+  std::vector<Eigen::Vector3d> points;
+  points.reserve(source.size());
+  for (const auto& p : source) {
+    if (std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z)) {
+      points.emplace_back(p.x, p.y, p.z);
+    }
+  }
+
+  const double max_squared_distance =
+      params_.max_mahalanobis_distance * params_.max_mahalanobis_distance;
+  const double rotation_eps = params_.rotation_eps_deg * M_PI / 180.0;
+
+  Eigen::Matrix3d R = T_MAP_SOURCE.block<3, 3>(0, 0);
+  Eigen::Vector3d t = T_MAP_SOURCE.block<3, 1>(0, 3);
+  Matrix6d H;
+  num_iterations_ = 0;
+  num_correspondences_ = 0;
+  for (int iteration = 0; iteration < params_.max_iterations; iteration++) {
+    num_iterations_++;
+    H.setZero();
+    Vector6d b = Vector6d::Zero();
+    int num_correspondences = 0;
+    for (const auto& p : points) {
+      const Eigen::Vector3d p_MAP = R * p + t;
+      const VoxelGaussianMap::Voxel* voxel = FindCorrespondence(map, p_MAP);
+      if (!voxel) { continue; }
+      const Eigen::Vector3d r = p_MAP - voxel->mean;
+      const Eigen::Vector3d Omega_r = voxel->information * r;
+      if (r.dot(Omega_r) > max_squared_distance) { continue; }
+
+      // left perturbation in the map frame: d(p_MAP) / d[dt, dw]
+      Eigen::Matrix<double, 3, 6> J;
+      J.block<3, 3>(0, 0).setIdentity();
+      J.block<3, 3>(0, 3) = -SkewSymmetric(p_MAP);
+      const Eigen::Matrix<double, 6, 3> Jt_Omega =
+          J.transpose() * voxel->information;
+      H += Jt_Omega * J;
+      b += Jt_Omega * r;
+      num_correspondences++;
+    }
+    num_correspondences_ = num_correspondences;
+    if (num_correspondences < params_.min_correspondences) { return false; }
+
+    Eigen::LDLT<Matrix6d> solver(H);
+    if (solver.info() != Eigen::Success) { return false; }
+    const Vector6d delta = -solver.solve(b);
+    if (!delta.allFinite()) { return false; }
+
+    const Eigen::Vector3d dt = delta.head<3>();
+    const Eigen::Vector3d dw = delta.tail<3>();
+    Eigen::Matrix3d dR = Eigen::Matrix3d::Identity();
+    if (dw.norm() > 0) {
+      dR = Eigen::AngleAxisd(dw.norm(), dw.normalized()).toRotationMatrix();
+    }
+    R = dR * R;
+    t = dR * t + dt;
+    if (dt.norm() < params_.translation_eps_m && dw.norm() < rotation_eps) {
+      break;
+    }
+  }
+
+  // orthonormalize to remove numerical drift from the repeated updates
+  Eigen::Quaterniond q(R);
+  q.normalize();
+  T_MAP_SOURCE.setIdentity();
+  T_MAP_SOURCE.block<3, 3>(0, 0) = q.toRotationMatrix();
+  T_MAP_SOURCE.block<3, 1>(0, 3) = t;
+  covariance_ = H.inverse();
+  return true;
+}
+
+}} // namespace bs_models::scan_registration
@@ -8,8 +8,11 @@
 
 #include <beam_utils/filesystem.h>
 
+#include <bs_common/async_disk_writer.h>
 #include <bs_common/bs_msgs.h>
 #include <bs_common/conversions.h>
+#include <bs_common/degradation_controller.h>
+#include <bs_common/snapshot_manager.h>
 #include <bs_models/frame_initializers/frame_initializer.h>
 #include <bs_models/graph_visualization/helpers.h>
 #include <bs_models/scan_registration/multi_scan_registration.h>
@@ -25,6 +28,12 @@ namespace bs_models {
 using namespace scan_registration;
 using namespace beam_matching;
 
+namespace {
+
+const std::string kRegistrationMapSnapshot = "registration_map";
+
+} // namespace
+
 LidarOdometry::LidarOdometry()
     : fuse_core::AsyncSensorModel(3),
       device_id_(fuse_core::uuid::NIL),
@@ -34,34 +43,12 @@ LidarOdometry::LidarOdometry()
 void LidarOdometry::onInit() {
   params_.loadFromROS(private_node_handle_);
 
-  // get filter params
-  nlohmann::json J;
-  if (!params_.input_filters_config.empty()) {
-    std::string filepath = beam::CombinePaths(
-        bs_common::GetBeamSlamConfigPath(), params_.input_filters_config);
-
-    ROS_INFO("Reading input filter params from %s", filepath.c_str());
-    if (!beam::ReadJson(filepath, J)) {
-      ROS_ERROR("Cannot read input filters json, not using any filters.");
-    } else {
-      nlohmann::json J_filters;
-      bool json_valid{true};
-      try {
-        J_filters = J["filters"];
-      } catch (...) {
-        ROS_ERROR(
-            "Missing 'filters' param in input filters config file. Not using "
-            "filters.");
-        std::cout << "Json Dump: " << J.dump() << "\n";
-        json_valid = false;
-      }
-      if (json_valid) {
-        input_filter_params_ =
-            beam_filtering::LoadFilterParamsVector(J_filters);
-        ROS_INFO("Loaded %zu input filters", input_filter_params_.size());
-      }
-    }
-  }
+  // setup placement of the callback threads
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(
+      ros::NodeHandle(private_node_handle_, "thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement(name(), placement_params);
+  callback_latency_ = bs_common::JitterMonitor::Create(name() + " Callback");
 
   // if outputting scans, clear folders
   if (params_.scan_output_directory.empty()) {
@@ -110,6 +97,34 @@ void LidarOdometry::onStart() {
         params_.frame_initializer_config);
   }
 
+  const bool continuous_time = params_.continuous_time_knot_spacing > 0;
+  if (continuous_time) {
+    if (params_.trigger_inertial_odom_constraints ||
+        params_.prior_information_weight != 0) {
+      ROS_WARN("trigger_inertial_odom_constraints and prior_information_weight "
+               "need one pose per scan and are ignored in continuous-time "
+               "mode");
+      params_.trigger_inertial_odom_constraints = false;
+      params_.prior_information_weight = 0;
+    }
+    spline_ = std::make_unique<bs_constraints::SplineTrajectory>(
+        params_.continuous_time_knot_spacing, device_id_);
+    SplineScanMap::Params spline_map_params;
+    spline_map_params.voxel_size = params_.continuous_time_voxel_size;
+    spline_map_params.points_per_scan =
+        params_.continuous_time_points_per_scan;
+    spline_map_params.information_weight = params_.lidar_information_weight;
+    spline_map_ = std::make_unique<SplineScanMap>(spline_map_params);
+  }
+
+  // in continuous-time mode the raw scans are kept to be deskewed with the
+  // spline for the registration map and outputs
+  if ((params_.redeskew_scans || continuous_time) &&
+      frame_initializer_ == nullptr) {
+    ROS_WARN("No frame initializer to deskew raw scans on arrival, scans "
+             "will only be deskewed once they are in the optimized window");
+  }
+
   subscriber_ = private_node_handle_.subscribe<sensor_msgs::PointCloud2>(
       ros::names::resolve(params_.input_topic), 10,
       &ThrottledCallback::callback, &throttled_callback_,
@@ -149,11 +164,10 @@ void LidarOdometry::onStop() {
   for (auto iter = active_clouds_.begin(); iter != active_clouds_.end();
        iter++) {
     PublishMarginalizedScanPose(*iter);
-    if (params_.save_marginalized_scans) {
-      (*iter)->SaveCloud(marginalized_scans_path_);
-    }
+    if (params_.save_marginalized_scans) { SaveMarginalizedScanPose(*iter); }
   }
   active_clouds_.clear();
+  bs_common::AsyncDiskWriter::GetInstance().Flush();
   subscriber_.shutdown();
   updates_ = 0;
   T_World_BaselinkLast_ = Eigen::Matrix4d::Identity();
@@ -166,28 +180,45 @@ void LidarOdometry::onStop() {
 }
 
 void LidarOdometry::SetupRegistration() {
-  // setup registration
-  beam_matching::MatcherType matcher_type;
-  if (!params_.matcher_config.empty()) {
-    const auto& reg_filepath = params_.registration_config;
-    const auto& matcher_filepath = params_.matcher_config;
-    scan_registration_ = ScanRegistrationBase::Create(
-        reg_filepath, matcher_filepath, registration_results_path_, 1e-5);
-
-    // setup feature extractor if needed
-    matcher_type = beam_matching::GetTypeFromConfig(matcher_filepath);
-    if (matcher_type == beam_matching::MatcherType::LOAM) {
-      std::string ceres_config = bs_common::GetAbsoluteConfigPathFromJson(
-          matcher_filepath, "ceres_config");
-      std::shared_ptr<LoamParams> matcher_params =
-          std::make_shared<LoamParams>(matcher_filepath, ceres_config);
-      feature_extractor_ =
-          std::make_shared<LoamFeatureExtractor>(matcher_params);
-    }
+  // setup the per scan pipeline
+  LidarOdometryFrontEnd::Params front_end_params;
+  front_end_params.registration_config = params_.registration_config;
+  front_end_params.matcher_config = params_.matcher_config;
+  front_end_params.registration_results_path = registration_results_path_;
+  if (!params_.input_filters_config.empty()) {
+    front_end_params.input_filters_config = beam::CombinePaths(
+        bs_common::GetBeamSlamConfigPath(), params_.input_filters_config);
+  }
+  front_end_params.registration_tuning_config =
+      params_.registration_tuning_config;
+  front_end_params.dynamic_point_filter_config =
+      params_.dynamic_point_filter_config;
+  front_end_params.lidar_type = params_.lidar_type;
+  front_end_params.organized_feature_extraction =
+      params_.organized_feature_extraction;
+  front_end_params.range_image_columns = params_.range_image_columns;
+  front_end_params.lidar_information_weight = params_.lidar_information_weight;
+  front_end_params.redeskew_scans =
+      params_.redeskew_scans || params_.continuous_time_knot_spacing > 0;
+  front_end_params.redeskewer.rotation_threshold_deg =
+      params_.redeskew_rotation_threshold_deg;
+  front_end_params.redeskewer.translation_threshold_m =
+      params_.redeskew_translation_threshold_m;
+  front_end_params.redeskewer.max_scans_per_update =
+      params_.redeskew_max_scans_per_update;
+  front_end_ = std::make_unique<LidarOdometryFrontEnd>(front_end_params);
+  if (log_registration_time_) {
+    front_end_->SetStageCallback(
+        [](const std::string& stage, double latency_ms) {
+          if (stage == "registration") {
+            BEAM_INFO("Registration time: {}s", latency_ms * 1e-3);
+          }
+        });
   }
 
   // set registration map to publish
   RegistrationMap& map = RegistrationMap::GetInstance();
+  base_map_voxel_size_ = map.VoxelDownsampleSize();
   if (params_.publish_registration_map) {
     map.SetPublishUpdates(true);
     ROS_INFO("Publishing initial lidar_odometry registration map");
@@ -214,14 +245,23 @@ void LidarOdometry::SetupRegistration() {
     T_World_BaselinkLast_ = T_MAP_SCAN * T_Lidar_Baselink;
     last_map_update_time_ = ros::Time::now();
   }
-
-  scan_registration_->SetInformationWeight(params_.lidar_information_weight);
 }
 
 void LidarOdometry::onGraphUpdate(fuse_core::Graph::ConstSharedPtr graph_msg) {
+  last_graph_ = graph_msg;
   if (updates_ == 0) {
     ROS_INFO("received first graph update, initializing registration and "
              "starting lidar odometry");
+    // restore the map before setting up registration so that we start from
+    // the last scan pose in the map
+    auto& snapshot = bs_common::SnapshotManager::GetInstance();
+    if (snapshot.WarmStarted()) {
+      RegistrationMap& map = RegistrationMap::GetInstance();
+      snapshot.Load(kRegistrationMapSnapshot,
+                    [&map](const std::string& directory) {
+                      return map.LoadSnapshot(directory);
+                    });
+    }
     SetupRegistration();
 
     const auto timestamps = bs_common::CurrentTimestamps(*graph_msg);
@@ -242,17 +282,20 @@ void LidarOdometry::onGraphUpdate(fuse_core::Graph::ConstSharedPtr graph_msg) {
 
   updates_++;
   PublishExtrinsics(graph_msg);
-
-  // update map
-  if (update_registration_map_all_scans_) {
-    scan_registration_->GetMapMutable().UpdateScanPosesFromGraphMsg(graph_msg);
-  } else if (update_registration_map_in_batch_) {
+  UpdateMapResolution();
+  if (front_end_->RedeskewsScans()) { RedeskewScans(*graph_msg); }
+
+  // update map. In continuous-time mode there are no scan poses in the graph,
+  // scans are updated from the spline below
+  RegistrationMap& map = front_end_->Registration().GetMapMutable();
+  if (spline_ == nullptr && update_registration_map_all_scans_) {
+    map.UpdateScanPosesFromGraphMsg(graph_msg);
+  } else if (spline_ == nullptr && update_registration_map_in_batch_) {
     ros::Time now = ros::Time::now();
     if (now >= (last_map_update_time_ + registration_map_batch_update_dur_)) {
       last_map_update_time_ = now;
       Eigen::Matrix4d T_WorldCorrected_World =
-          scan_registration_->GetMapMutable().CorrectMapDriftFromGraphMsg(
-              graph_msg);
+          map.CorrectMapDriftFromGraphMsg(graph_msg);
       T_World_BaselinkLast_ = T_WorldCorrected_World * T_World_BaselinkLast_;
     }
   }
@@ -261,7 +304,19 @@ void LidarOdometry::onGraphUpdate(fuse_core::Graph::ConstSharedPtr graph_msg) {
   auto i = active_clouds_.begin();
   while (i != active_clouds_.end()) {
     std::shared_ptr<ScanPose>& scan_pose = *i;
-    bool update_successful = scan_pose->UpdatePose(graph_msg);
+    bool update_successful;
+    if (spline_) {
+      Eigen::Matrix4d T_World_Baselink;
+      update_successful =
+          spline_->GetPose(*graph_msg, scan_pose->Stamp(), T_World_Baselink);
+      if (update_successful) {
+        scan_pose->UpdatePose(T_World_Baselink);
+        map.UpdateScan(scan_pose->Stamp(), scan_pose->T_REFFRAME_LIDAR());
+        spline_map_->UpdateScan(*scan_pose, false);
+      }
+    } else {
+      update_successful = scan_pose->UpdatePose(graph_msg);
+    }
     if (update_successful) {
       ++i;
       continue;
@@ -277,27 +332,55 @@ void LidarOdometry::onGraphUpdate(fuse_core::Graph::ConstSharedPtr graph_msg) {
     // Otherwise, it has probably been marginalized out, so output and remove
     // from active list
     PublishMarginalizedScanPose(*i);
+    if (spline_) { spline_map_->RemoveScan(scan_pose->Stamp()); }
     if (params_.save_marginalized_scans) {
-      scan_pose->SaveCloud(marginalized_scans_path_);
+      SaveMarginalizedScanPose(scan_pose);
     }
     active_clouds_.erase(i++);
   }
 
-  if (params_.save_graph_updates) {
-    std::string update_time =
-        beam::ConvertTimeToDate(std::chrono::system_clock::now());
-    std::string curent_path =
-        beam::CombinePaths(graph_updates_path_,
-                           "U" + std::to_string(updates_) + "_" + update_time);
-    std::filesystem::create_directory(curent_path);
-    for (auto iter = active_clouds_.begin(); iter != active_clouds_.end();
-         iter++) {
-      (*iter)->SaveCloud(curent_path);
-    }
+  if (params_.save_graph_updates) { SaveGraphUpdateScans(); }
+
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  if (!map.Empty() &&
+      snapshot.SaveDue(kRegistrationMapSnapshot, last_scan_pose_time_)) {
+    snapshot.SaveAsync(kRegistrationMapSnapshot, last_scan_pose_time_,
+                       map.SnapshotWriter());
   }
 }
 
+void LidarOdometry::SaveMarginalizedScanPose(
+    const std::shared_ptr<ScanPose>& scan_pose) {
+  // marginalized scans are no longer updated, so the writer can share them
+  std::shared_ptr<const ScanPose> scan = scan_pose;
+  const std::string save_path = marginalized_scans_path_;
+  bs_common::AsyncDiskWriter::GetInstance().Enqueue(
+      "marginalized scan",
+      [scan, save_path]() { scan->SaveCloud(save_path); });
+}
+
+void LidarOdometry::SaveGraphUpdateScans() {
+  std::string update_time =
+      beam::ConvertTimeToDate(std::chrono::system_clock::now());
+  std::string curent_path =
+      beam::CombinePaths(graph_updates_path_,
+                         "U" + std::to_string(updates_) + "_" + update_time);
+
+  // scans in the window keep getting updated, so we write copies
+  std::vector<std::shared_ptr<const ScanPose>> scans;
+  for (const auto& scan_pose : active_clouds_) {
+    scans.push_back(std::make_shared<const ScanPose>(*scan_pose));
+  }
+  bs_common::AsyncDiskWriter::GetInstance().Enqueue(
+      "graph update scans", [scans, curent_path]() {
+        std::filesystem::create_directory(curent_path);
+        for (const auto& scan : scans) { scan->SaveCloud(curent_path); }
+      });
+}
+
 void LidarOdometry::process(const sensor_msgs::PointCloud2::ConstPtr& msg) {
+  thread_placement_.ApplyToCurrentThread();
+  callback_latency_->AddSample((ros::Time::now() - msg->header.stamp).toSec());
   if (updates_ == 0) {
     ROS_INFO_THROTTLE(
         1, "lidar odometry not yet initialized, waiting on first graph "
@@ -359,46 +442,19 @@ void LidarOdometry::process(const sensor_msgs::PointCloud2::ConstPtr& msg) {
       break;
     }
 
-    std::shared_ptr<ScanPose> current_scan_pose;
-    if (params_.lidar_type == LidarType::VELODYNE) {
-      pcl::PointCloud<PointXYZIRT> cloud_current_unfiltered;
-      beam::ROSToPCL(cloud_current_unfiltered, *msg);
-      pcl::PointCloud<PointXYZIRT> cloud_filtered =
-          beam_filtering::FilterPointCloud<PointXYZIRT>(
-              cloud_current_unfiltered, input_filter_params_);
-      current_scan_pose = std::make_shared<ScanPose>(
-          cloud_filtered, current_msg->header.stamp, T_World_BaselinkInit,
-          T_Baselink_Lidar, feature_extractor_);
-    } else if (params_.lidar_type == LidarType::OUSTER) {
-      pcl::PointCloud<PointXYZITRRNR> cloud_current_unfiltered;
-      beam::ROSToPCL(cloud_current_unfiltered, *msg);
-      pcl::PointCloud<PointXYZITRRNR> cloud_filtered =
-          beam_filtering::FilterPointCloud(cloud_current_unfiltered,
-                                           input_filter_params_);
-      current_scan_pose = std::make_shared<ScanPose>(
-          cloud_filtered, current_msg->header.stamp, T_World_BaselinkInit,
-          T_Baselink_Lidar, feature_extractor_);
-    } else {
-      ROS_ERROR(
-          "Invalid lidar type param. Lidar type may not be implemented yet.");
-      throw std::runtime_error(
-          "Invalid lidar type param. Lidar type may not be implemented yet.");
-    }
-
-    Eigen::Matrix4d T_World_BaselinkCurrent;
-    fuse_core::Transaction::SharedPtr transaction;
-    if (log_registration_time_) { timer_.restart(); }
-    transaction = scan_registration_->RegisterNewScan(*current_scan_pose)
-                      .GetTransaction();
-    if (log_registration_time_) {
-      BEAM_INFO("Registration time: {}s", timer_.elapsed());
-    }
-    Eigen::Matrix4d T_WORLD_LIDAR;
-
-    scan_registration_->GetMap().GetScanPose(current_scan_pose->Stamp(),
-                                             T_WORLD_LIDAR);
-
-    T_World_BaselinkCurrent = T_WORLD_LIDAR * T_Baselink_Lidar;
+    const ScanRedeskewer::PoseLookup get_T_World_Lidar =
+        [this](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+          return frame_initializer_ != nullptr &&
+                 frame_initializer_->GetPose(T_World_Lidar, time,
+                                             extrinsics_.GetLidarFrameId());
+        };
+    auto result =
+        front_end_->ProcessScan(*current_msg, T_World_BaselinkInit,
+                                T_Baselink_Lidar, get_T_World_Lidar);
+    const std::shared_ptr<ScanPose>& current_scan_pose = result.scan_pose;
+    fuse_core::Transaction::SharedPtr transaction = result.transaction;
+    const Eigen::Matrix4d& T_WORLD_LIDAR = result.T_World_Lidar;
+    Eigen::Matrix4d T_World_BaselinkCurrent = T_WORLD_LIDAR * T_Baselink_Lidar;
 
     if (transaction == nullptr) {
       ROS_WARN("No transaction generated, skipping scan.");
@@ -415,7 +471,19 @@ void LidarOdometry::process(const sensor_msgs::PointCloud2::ConstPtr& msg) {
       break;
     }
     skipped_scans_in_a_row_ = 0;
-    sendTransaction(transaction);
+    if (spline_) {
+      // constrain the spline with the raw points instead of the registration
+      // result, which is only used to initialize the new control points
+      const auto raw_cloud =
+          front_end_->FindRawScan(current_scan_pose->Stamp());
+      transaction = raw_cloud != nullptr
+                        ? spline_map_->AddScan(name(), *spline_,
+                                               last_graph_.get(),
+                                               *current_scan_pose, *raw_cloud,
+                                               T_WORLD_LIDAR)
+                        : nullptr;
+    }
+    if (transaction) { sendTransaction(transaction); }
 
     // add priors from initializer
     fuse_core::Transaction::SharedPtr prior_transaction;
@@ -588,4 +656,70 @@ void LidarOdometry::PublishExtrinsics(
       extrinsics_.GetBaselinkFrameId()));
 }
 
+void LidarOdometry::UpdateMapResolution() {
+  // a negative voxel size means downsampling is disabled, leave it that way
+  if (base_map_voxel_size_ <= 0) { return; }
+  const double voxel_size =
+      base_map_voxel_size_ *
+      bs_common::DegradationController::GetInstance().VoxelSizeScale();
+  RegistrationMap& map = front_end_->Registration().GetMapMutable();
+  if (map.VoxelDownsampleSize() == voxel_size) { return; }
+  ROS_INFO_STREAM(name() << ": setting registration map voxel size to "
+                         << voxel_size << "m");
+  map.SetVoxelDownsampleSize(voxel_size);
+}
+
+void LidarOdometry::RedeskewScans(const fuse_core::Graph& graph) {
+  Eigen::Matrix4d T_Baselink_Lidar;
+  if (!extrinsics_.GetT_BASELINK_LIDAR(T_Baselink_Lidar)) {
+    ROS_WARN_THROTTLE(1, "Cannot lookup transform from lidar to baselink, not "
+                         "re-deskewing scans");
+    return;
+  }
+
+  const auto scans = front_end_->RedeskewScans(
+      GetLidarTrajectory(graph, T_Baselink_Lidar), active_clouds_);
+  if (spline_ == nullptr) { return; }
+  for (const auto& scan_pose : scans) {
+    spline_map_->UpdateScan(*scan_pose, true);
+  }
+}
+
+LidarTrajectory
+    LidarOdometry::GetLidarTrajectory(const fuse_core::Graph& graph,
+                                      const Eigen::Matrix4d& T_Baselink_Lidar) {
+  LidarTrajectory trajectory;
+  if (spline_ == nullptr) {
+    for (const auto& t : bs_common::CurrentTimestamps(graph)) {
+      auto maybe_p = bs_common::GetPosition(graph, t);
+      auto maybe_o = bs_common::GetOrientation(graph, t);
+      if (maybe_p && maybe_o) {
+        Eigen::Matrix4d T_World_Baselink =
+            bs_common::FusePoseToEigenTransform(*maybe_p, *maybe_o);
+        trajectory.AddPose(t, T_World_Baselink * T_Baselink_Lidar);
+      }
+    }
+    return trajectory;
+  }
+
+  // sample the spline densely enough that interpolating between samples is
+  // accurate over a scan
+  if (active_clouds_.empty()) { return trajectory; }
+  const ros::Duration step(spline_->KnotSpacing() / 4);
+  const ros::Time last_stamp = active_clouds_.back()->Stamp();
+  // the last scan's points after its stamp are covered by extrapolation
+  for (ros::Time t = active_clouds_.front()->Stamp(); t <= last_stamp;
+       t += step) {
+    Eigen::Matrix4d T_World_Baselink;
+    if (spline_->GetPose(graph, t, T_World_Baselink)) {
+      trajectory.AddPose(t, T_World_Baselink * T_Baselink_Lidar);
+    }
+  }
+  Eigen::Matrix4d T_World_Baselink;
+  if (spline_->GetPose(graph, last_stamp, T_World_Baselink)) {
+    trajectory.AddPose(last_stamp, T_World_Baselink * T_Baselink_Lidar);
+  }
+  return trajectory;
+}
+
 } // namespace bs_models
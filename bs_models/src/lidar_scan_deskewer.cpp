@@ -20,6 +20,13 @@ void LidarScanDeskewer::onInit() {
   params_.loadFromROS(private_node_handle_);
   ROS_DEBUG("Loaded params");
 
+  // setup placement of the callback threads
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(
+      ros::NodeHandle(private_node_handle_, "thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement(name(), placement_params);
+  callback_latency_ = bs_common::JitterMonitor::Create(name() + " Callback");
+
   frame_initializer_ =
       std::make_unique<bs_models::FrameInitializer>(
           params_.frame_initializer_config);
@@ -48,6 +55,8 @@ void LidarScanDeskewer::onStop() {
 
 void LidarScanDeskewer::ProcessPointcloud(
     const sensor_msgs::PointCloud2::ConstPtr& msg) {
+  thread_placement_.ApplyToCurrentThread();
+  callback_latency_->AddSample((ros::Time::now() - msg->header.stamp).toSec());
   if (params_.lidar_type == LidarType::VELODYNE) {
     ROS_DEBUG("Processing Velodyne poincloud message");
     pcl::PointCloud<PointXYZIRT> cloud;
@@ -9,6 +9,8 @@
 #include <beam_cv/geometry/Triangulation.h>
 #include <beam_utils/utils.h>
 
+#include <bs_common/graph_access.h>
+#include <bs_common/snapshot_manager.h>
 #include <bs_common/visualization.h>
 #include <bs_models/graph_visualization/helpers.h>
 #include <bs_models/imu/inertial_alignment.h>
@@ -22,6 +24,15 @@ namespace bs_models {
 
 using namespace vision;
 
+namespace {
+
+const std::string kGraphSnapshot = "graph";
+const std::string kGraphFilename = "graph.bin";
+const std::string kExtrinsicsSnapshot = "extrinsics";
+const std::string kExtrinsicsFilename = "extrinsics.json";
+
+} // namespace
+
 SLAMInitialization::SLAMInitialization()
     : fuse_core::AsyncSensorModel(3),
       device_id_(fuse_core::uuid::NIL),
@@ -273,10 +284,75 @@ void SLAMInitialization::processLidar(
 void SLAMInitialization::processIMU(const sensor_msgs::Imu::ConstPtr& msg) {
   ROS_INFO_STREAM_ONCE(
       "SLAMInitialization received IMU measurements: " << msg->header.stamp);
+  if (!warm_start_attempted_) {
+    warm_start_attempted_ = true;
+    if (WarmStart(msg->header.stamp)) {
+      shutdown();
+      return;
+    }
+  }
+
   imu_buffer_.push_back(*msg);
   if (imu_buffer_.size() > imu_buffer_size_) { imu_buffer_.pop_front(); }
 }
 
+bool SLAMInitialization::WarmStart(const ros::Time& stamp) {
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  const auto snapshot_params = snapshot.GetParams();
+  if (!snapshot_params.warm_start) { return false; }
+
+  beam::HighResolutionTimer timer;
+  ros::Time graph_stamp;
+  if (!snapshot.GetStamp(kGraphSnapshot, graph_stamp)) {
+    ROS_WARN_STREAM("No graph snapshot found in " << snapshot_params.path
+                                                  << ", not warm starting.");
+    return false;
+  }
+
+  const double gap_s = (stamp - graph_stamp).toSec();
+  if (gap_s < 0 || gap_s > snapshot_params.max_warm_start_gap_s) {
+    ROS_WARN_STREAM("Graph snapshot is " << gap_s
+                                         << "s old, max is "
+                                         << snapshot_params.max_warm_start_gap_s
+                                         << "s. Not warm starting.");
+    return false;
+  }
+
+  fuse_graphs::HashGraph graph;
+  if (!snapshot.Load(kGraphSnapshot, [&graph](const std::string& directory) {
+        return bs_common::LoadGraphFromBinaryFile(
+            beam::CombinePaths(directory, kGraphFilename), graph);
+      })) {
+    return false;
+  }
+  const std::set<ros::Time> timestamps = bs_common::CurrentTimestamps(graph);
+  if (timestamps.empty()) {
+    ROS_WARN("Graph snapshot is empty, not warm starting.");
+    return false;
+  }
+
+  // extrinsics are optional, if they are missing we keep looking them up
+  snapshot.Load(kExtrinsicsSnapshot, [this](const std::string& directory) {
+    try {
+      extrinsics_.LoadExtrinsicsFromJson(
+          beam::CombinePaths(directory, kExtrinsicsFilename));
+    } catch (const std::exception& e) {
+      BEAM_WARN("Unable to load extrinsics snapshot: {}", e.what());
+      return false;
+    }
+    return true;
+  });
+
+  // the other sensor models check this on their first graph update, so it must
+  // be set before sending the graph
+  snapshot.SetWarmStarted(graph_stamp);
+  sendTransaction(bs_common::GraphToTransaction(graph, *timestamps.begin()));
+  BEAM_INFO("Warm started from snapshot with {} states, gap: {}s, total time: "
+            "{}s",
+            timestamps.size(), gap_s, timer.elapsed());
+  return true;
+}
+
 bool SLAMInitialization::Initialize() {
   if (imu_buffer_.empty()) {
     ROS_ERROR_STREAM(__func__ << ": IMU buffer empty, cannot initialize!");
@@ -911,6 +987,33 @@ void SLAMInitialization::AddMeasurementsToContainer(
   prev_frame_ = msg->header.stamp;
 }
 
+void SLAMInitialization::onGraphUpdate(
+    fuse_core::Graph::ConstSharedPtr graph_msg) {
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  if (!snapshot.GetParams().save) { return; }
+
+  const std::set<ros::Time> timestamps =
+      bs_common::CurrentTimestamps(*graph_msg);
+  if (timestamps.empty()) { return; }
+  const ros::Time stamp = *timestamps.rbegin();
+  if (!snapshot.SaveDue(kGraphSnapshot, stamp)) { return; }
+
+  // the graph message is never modified, so the queued write can share it
+  snapshot.SaveAsync(kGraphSnapshot, stamp,
+                     [graph_msg](const std::string& directory) {
+                       return bs_common::SaveGraphToBinaryFile(
+                           *graph_msg,
+                           beam::CombinePaths(directory, kGraphFilename));
+                     });
+  bs_common::ExtrinsicsLookupOnline* extrinsics = &extrinsics_;
+  snapshot.SaveAsync(kExtrinsicsSnapshot, stamp,
+                     [extrinsics](const std::string& directory) {
+                       extrinsics->SaveExtrinsicsToJson(
+                           beam::CombinePaths(directory, kExtrinsicsFilename));
+                       return true;
+                     });
+}
+
 void SLAMInitialization::shutdown() {
   visual_measurement_subscriber_.shutdown();
   imu_subscriber_.shutdown();
@@ -919,7 +1022,7 @@ void SLAMInitialization::shutdown() {
   frame_init_buffer_.clear();
   local_graph_->clear();
   visual_map_->Clear();
-  imu_preint_->Reset();
+  if (imu_preint_) { imu_preint_->Reset(); }
   image_db_->Clear();
   init_path_.clear();
   velocities_.clear();
@@ -25,6 +25,13 @@ void VisualFeatureTracker::onInit() {
   device_id_ = fuse_variables::loadDeviceId(private_node_handle_);
   params_.loadFromROS(private_node_handle_);
 
+  // setup placement of the callback threads
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(
+      ros::NodeHandle(private_node_handle_, "thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement(name(), placement_params);
+  callback_latency_ = bs_common::JitterMonitor::Create(name() + " Callback");
+
   // Initialize descriptor
   beam_cv::ORBDescriptor::Params descriptor_params;
   descriptor_params.LoadFromJson(params_.descriptor_config);
@@ -60,6 +67,8 @@ void VisualFeatureTracker::onStart() {
  ************************************************************/
 void VisualFeatureTracker::processImage(
     const sensor_msgs::Image::ConstPtr& msg) {
+  thread_placement_.ApplyToCurrentThread();
+  callback_latency_->AddSample((ros::Time::now() - msg->header.stamp).toSec());
   // track features in image
   cv::Mat image = beam_cv::OpenCVConversions::RosImgToMat(*msg);
   cv::Mat clahe_image = beam_cv::AdaptiveHistogram(image);
@@ -20,7 +20,9 @@
 #include <beam_utils/pointclouds.h>
 
 #include <bs_common/conversions.h>
+#include <bs_common/degradation_controller.h>
 #include <bs_common/graph_access.h>
+#include <bs_common/task_scheduler.h>
 #include <bs_constraints/inertial/absolute_imu_state_3d_stamped_constraint.h>
 #include <bs_constraints/visual/euclidean_reprojection_constraint.h>
 #include <bs_models/graph_visualization/helpers.h>
@@ -44,6 +46,13 @@ void VisualOdometry::onInit() {
   vo_params_.loadFromROS(private_node_handle_);
   calibration_params_.loadFromROS();
 
+  // setup placement of the callback threads
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(
+      ros::NodeHandle(private_node_handle_, "thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement(name(), placement_params);
+  callback_latency_ = bs_common::JitterMonitor::Create(name() + " Callback");
+
   // Load camera model and create visua map object
   cam_model_ = beam_calibration::CameraModel::Create(
       calibration_params_.cam_intrinsics_path);
@@ -133,6 +142,8 @@ void VisualOdometry::onStop() {
 
 void VisualOdometry::processMeasurements(
     const bs_common::CameraMeasurementMsg::ConstPtr& msg) {
+  thread_placement_.ApplyToCurrentThread();
+  callback_latency_->AddSample((ros::Time::now() - msg->header.stamp).toSec());
   ROS_INFO_STREAM_ONCE(
       "VisualOdometry received VISUAL measurements: " << msg->header.stamp);
 
@@ -318,7 +329,27 @@ void VisualOdometry::ExtendMap(const ros::Time& timestamp,
   if (vo_params_.local_map_matching) { ProjectMapPoints(T_WORLD_BASELINK); }
 
   // process each landmark
-  const auto landmarks = landmark_container_->GetLandmarkIDsInImage(timestamp);
+  auto landmarks = landmark_container_->GetLandmarkIDsInImage(timestamp);
+
+  // if the system is overloaded, only process a subset of the landmarks,
+  // favouring the ones already in the map over new ones that need to be
+  // triangulated
+  const double landmark_fraction =
+      bs_common::DegradationController::GetInstance().LandmarkFraction();
+  if (landmark_fraction < 1.0) {
+    const auto map_ids = visual_map_->GetLandmarkIDs();
+    std::stable_partition(landmarks.begin(), landmarks.end(),
+                          [&map_ids](const uint64_t id) {
+                            return map_ids.find(id) != map_ids.end();
+                          });
+    const size_t max_landmarks = static_cast<size_t>(
+        std::ceil(landmark_fraction * landmarks.size()));
+    ROS_DEBUG_STREAM("VisualOdometry: processing " << max_landmarks << "/"
+                                                   << landmarks.size()
+                                                   << " landmarks");
+    landmarks.resize(max_landmarks);
+  }
+
   for (const auto id : landmarks) {
     if (vo_params_.use_idp) {
       ProcessLandmarkIDP(id, timestamp, transaction);
@@ -440,7 +471,9 @@ bool VisualOdometry::IsKeyframe(const ros::Time& timestamp,
   const double percent_tracked = static_cast<double>(num_correspondences) /
                                  static_cast<double>(frame1_ids.size());
 
-  if (avg_parallax > vo_params_.keyframe_parallax) {
+  const double keyframe_spacing_scale =
+      bs_common::DegradationController::GetInstance().KeyframeSpacingScale();
+  if (avg_parallax > keyframe_spacing_scale * vo_params_.keyframe_parallax) {
     return true;
   } else if (percent_tracked <= 0.5) {
     return true;
@@ -1164,21 +1197,32 @@ void VisualOdometry::ProjectMapPoints(const Eigen::Matrix4d& T_WORLD_BASELINK) {
   image_projection_to_lm_id_.clear();
 
   const auto landmarks = visual_map_->GetLandmarks();
-  for (const auto& [id, point] : landmarks) {
-    // transform into current frame
-    Eigen::Vector3d point_t_cam =
-        ((T_cam_baselink_ * beam::InvertTransform(T_WORLD_BASELINK)) *
-         point.homogeneous())
-            .hnormalized();
-    // project into image and store
-    Eigen::Vector2d pixel;
-    bool in_image = false;
-    if (!cam_model_->ProjectPoint(point_t_cam, pixel, in_image) || !in_image) {
-      continue;
-    }
+  std::vector<std::pair<uint64_t, Eigen::Vector3d>> points(landmarks.begin(),
+                                                           landmarks.end());
+  const Eigen::Matrix4d T_cam_world =
+      T_cam_baselink_ * beam::InvertTransform(T_WORLD_BASELINK);
+
+  // project in parallel, then fill the lookups in landmark order so that the
+  // result does not depend on the number of threads
+  std::vector<Eigen::Vector2d> pixels(points.size());
+  std::vector<uint8_t> in_image(points.size(), 0);
+  bs_common::TaskScheduler::GetInstance().ParallelFor(
+      bs_common::TaskPriority::REALTIME, points.size(), [&](size_t i) {
+        // transform into current frame
+        const Eigen::Vector3d point_t_cam =
+            (T_cam_world * points[i].second.homogeneous()).hnormalized();
+        bool projected_in_image = false;
+        in_image[i] = cam_model_->ProjectPoint(point_t_cam, pixels[i],
+                                               projected_in_image) &&
+                      projected_in_image;
+      });
+
+  for (size_t i = 0; i < points.size(); i++) {
+    if (!in_image[i]) { continue; }
+    const Eigen::Vector2d& pixel = pixels[i];
     landmark_projection_mask_.at<uchar>(pixel[0], pixel[1]) = 1;
     uint64_t pixel_index = pixel[1] * cam_model_->GetWidth() + pixel[0];
-    image_projection_to_lm_id_[pixel_index] = id;
+    image_projection_to_lm_id_[pixel_index] = points[i].first;
   }
 }
 
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <bs_models/scan_registration/degeneracy_analysis.h>
+
+using namespace bs_models::scan_registration;
+using Matrix6d = DegeneracyAnalysis::Matrix6d;
+
+namespace {
+
+DegeneracyAnalysis::Params EnabledParams() {
+  DegeneracyAnalysis::Params params;
+  params.enabled = true;
+  params.min_translation_information = 100;
+  params.min_rotation_information = 1000;
+  params.degenerate_variance = 100;
+  return params;
+}
+
+Matrix6d WellConstrainedCovariance() {
+  Eigen::Matrix<double, 6, 1> diag;
+  diag << 1e-4, 1e-4, 2e-4, 1e-5, 1e-5, 2e-5;
+  Matrix6d covariance = diag.asDiagonal();
+  covariance(0, 4) = covariance(4, 0) = 1e-6;
+  return covariance;
+}
+
+// covariance of a registration in a corridor along the axis, where the
+// translation along the axis is poorly constrained
+Matrix6d CorridorCovariance(const Eigen::Vector3d& axis) {
+  Matrix6d covariance = WellConstrainedCovariance();
+  const Eigen::Vector3d a = axis.normalized();
+  covariance.block<3, 3>(0, 0) += 0.5 * a * a.transpose();
+  return covariance;
+}
+
+Eigen::Matrix4d Correction(const Eigen::Vector3d& t, const Eigen::Vector3d& r) {
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  if (r.norm() > 0) {
+    T.block<3, 3>(0, 0) =
+        Eigen::AngleAxisd(r.norm(), r.normalized()).toRotationMatrix();
+  }
+  T.block<3, 1>(0, 3) = t;
+  return T;
+}
+
+} // namespace
+
+TEST(DegeneracyAnalysis, WellConstrained) {
+  DegeneracyAnalysis analysis(EnabledParams());
+  const Matrix6d covariance = WellConstrainedCovariance();
+  const auto result = analysis.Analyze(covariance);
+  EXPECT_FALSE(result.Degenerate());
+  EXPECT_EQ(result.NumDegenerateTranslation(), 0);
+  EXPECT_EQ(result.NumDegenerateRotation(), 0);
+  EXPECT_TRUE(result.projection.isApprox(Matrix6d::Identity(), 1e-9));
+
+  // results are unchanged
+  const Eigen::Matrix4d T =
+      Correction(Eigen::Vector3d(0.1, -0.2, 0.05), Eigen::Vector3d(0, 0, 0.02));
+  EXPECT_TRUE(analysis.ConstrainCorrection(T, result).isApprox(T));
+  EXPECT_TRUE(
+      analysis.ShapeCovariance(covariance, result).isApprox(covariance));
+  EXPECT_TRUE(
+      analysis.ValidationCovariance(covariance, result).isApprox(covariance));
+}
+
+TEST(DegeneracyAnalysis, Corridor) {
+  DegeneracyAnalysis analysis(EnabledParams());
+  const Eigen::Vector3d axis = Eigen::Vector3d(1, 1, 0).normalized();
+  const Matrix6d covariance = CorridorCovariance(axis);
+  const auto result = analysis.Analyze(covariance);
+  ASSERT_TRUE(result.Degenerate());
+  EXPECT_EQ(result.NumDegenerateTranslation(), 1);
+  EXPECT_EQ(result.NumDegenerateRotation(), 0);
+
+  // the correction along the corridor is removed, the rest is kept
+  const Eigen::Vector3d across = Eigen::Vector3d(1, -1, 0).normalized();
+  const Eigen::Vector3d rotation(0.01, 0, 0.02);
+  const Eigen::Matrix4d T = Correction(0.3 * axis + 0.1 * across, rotation);
+  const Eigen::Matrix4d T_constrained = analysis.ConstrainCorrection(T, result);
+  const Eigen::Vector3d t_constrained = T_constrained.block<3, 1>(0, 3);
+  EXPECT_NEAR(t_constrained.dot(axis), 0, 1e-9);
+  EXPECT_NEAR(t_constrained.dot(across), 0.1, 1e-9);
+  const Eigen::Matrix3d R_constrained = T_constrained.block<3, 3>(0, 0);
+  const Eigen::Matrix3d R = T.block<3, 3>(0, 0);
+  EXPECT_TRUE(R_constrained.isApprox(R, 1e-9));
+
+  // the shaped covariance has no information along the corridor, and is
+  // unchanged across it
+  const Matrix6d shaped = analysis.ShapeCovariance(covariance, result);
+  Eigen::Matrix<double, 6, 1> a6 = Eigen::Matrix<double, 6, 1>::Zero();
+  a6.head<3>() = axis;
+  Eigen::Matrix<double, 6, 1> c6 = Eigen::Matrix<double, 6, 1>::Zero();
+  c6.head<3>() = across;
+  EXPECT_NEAR(a6.transpose() * shaped * a6, 100, 1e-6);
+  EXPECT_NEAR(c6.transpose() * shaped * c6, c6.transpose() * covariance * c6,
+              1e-9);
+  EXPECT_NEAR(a6.transpose() * shaped * c6, 0, 1e-9);
+  const Eigen::Matrix3d shaped_rotation = shaped.block<3, 3>(3, 3);
+  EXPECT_TRUE(shaped_rotation.isApprox(covariance.block<3, 3>(3, 3)));
+  EXPECT_TRUE(shaped.isApprox(shaped.transpose()));
+
+  // validation uses the threshold variance along the corridor
+  const Matrix6d validation = analysis.ValidationCovariance(covariance, result);
+  EXPECT_NEAR(a6.transpose() * validation * a6, 1.0 / 100, 1e-9);
+  Eigen::SelfAdjointEigenSolver<Matrix6d> solver(validation);
+  EXPECT_GT(solver.eigenvalues().minCoeff(), 0);
+}
+
+TEST(DegeneracyAnalysis, Rotation) {
+  DegeneracyAnalysis analysis(EnabledParams());
+
+  // e.g. a single plane in view: roll and pitch constrained, yaw is not
+  Matrix6d covariance = WellConstrainedCovariance();
+  covariance(5, 5) = 0.1;
+  const auto result = analysis.Analyze(covariance);
+  EXPECT_EQ(result.NumDegenerateTranslation(), 0);
+  EXPECT_EQ(result.NumDegenerateRotation(), 1);
+
+  const Eigen::Matrix4d T = Correction(Eigen::Vector3d(0.1, 0, 0),
+                                       Eigen::Vector3d(0.01, -0.01, 0.05));
+  const Eigen::Matrix4d T_constrained = analysis.ConstrainCorrection(T, result);
+  Eigen::AngleAxisd aa(Eigen::Matrix3d(T_constrained.block<3, 3>(0, 0)));
+  const Eigen::Vector3d r = aa.angle() * aa.axis();
+  EXPECT_NEAR(r[0], 0.01, 1e-9);
+  EXPECT_NEAR(r[1], -0.01, 1e-9);
+  EXPECT_NEAR(r[2], 0, 1e-9);
+  EXPECT_NEAR(T_constrained(0, 3), 0.1, 1e-9);
+
+  const Matrix6d shaped = analysis.ShapeCovariance(covariance, result);
+  EXPECT_NEAR(shaped(5, 5), 100, 1e-9);
+  const Eigen::Matrix3d shaped_translation = shaped.block<3, 3>(0, 0);
+  EXPECT_TRUE(shaped_translation.isApprox(covariance.block<3, 3>(0, 0)));
+}
+
+TEST(DegeneracyAnalysis, LoadFromJson) {
+  DegeneracyAnalysis::Params params;
+  nlohmann::json J;
+  J["enabled"] = true;
+  J["min_translation_information"] = 50;
+  J["min_rotation_information"] = 500;
+  J["degenerate_variance"] = 10;
+  params.LoadFromJson(J);
+  EXPECT_TRUE(params.enabled);
+  EXPECT_EQ(params.min_translation_information, 50);
+  EXPECT_EQ(params.min_rotation_information, 500);
+  EXPECT_EQ(params.degenerate_variance, 10);
+
+  J["degenerate_variance"] = 0;
+  EXPECT_ANY_THROW(params.LoadFromJson(J));
+  J.erase("degenerate_variance");
+  EXPECT_ANY_THROW(params.LoadFromJson(J));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
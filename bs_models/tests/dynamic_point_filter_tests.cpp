@@ -0,0 +1,364 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <beam_utils/pointclouds.h>
+#include <beam_utils/se3.h>
+
+#include <bs_common/extrinsics_lookup_base.h>
+#include <bs_models/global_mapping/submap.h>
+#include <bs_models/lidar/dynamic_point_filter.h>
+#include <bs_models/scan_registration/registration_map.h>
+
+#include <test_utils.h>
+
+using namespace bs_models;
+
+namespace {
+
+// axis aligned box in the world frame
+struct Box {
+  Eigen::Vector3d min;
+  Eigen::Vector3d max;
+
+  bool Contains(const Eigen::Vector3d& p, double tolerance) const {
+    return (p.array() >= min.array() - tolerance).all() &&
+           (p.array() <= max.array() + tolerance).all();
+  }
+};
+
+// square room with a floor, walls and a static pillar
+const double kRoomHalfSize = 15;
+const double kFloorHeight = -1.5;
+const Box kPillar{{4, -6, kFloorHeight}, {5, -5, 2}};
+
+// a person sized box
+Box Person(double x, double y) {
+  return Box{{x - 0.3, y - 0.3, kFloorHeight}, {x + 0.3, y + 0.3, 0.3}};
+}
+
+// distance along the ray to the box, or infinity if missed
+double Intersect(const Eigen::Vector3d& origin, const Eigen::Vector3d& dir,
+                 const Box& box) {
+  double t_min = 0;
+  double t_max = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < 3; i++) {
+    if (std::abs(dir[i]) < 1e-12) {
+      if (origin[i] < box.min[i] || origin[i] > box.max[i]) {
+        return std::numeric_limits<double>::infinity();
+      }
+      continue;
+    }
+    double t0 = (box.min[i] - origin[i]) / dir[i];
+    double t1 = (box.max[i] - origin[i]) / dir[i];
+    if (t0 > t1) { std::swap(t0, t1); }
+    t_min = std::max(t_min, t0);
+    t_max = std::min(t_max, t1);
+  }
+  return t_min <= t_max ? t_min : std::numeric_limits<double>::infinity();
+}
+
+// sensor pose in the world (map) frame, with a yaw so that transforms matter
+Eigen::Matrix4d SensorPose(double x, double y, double yaw) {
+  Eigen::Matrix4d T_World_Scan = Eigen::Matrix4d::Identity();
+  T_World_Scan.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  T_World_Scan(0, 3) = x;
+  T_World_Scan(1, 3) = y;
+  return T_World_Scan;
+}
+
+// simulates a VLP16 scan of the room and objects, in the scan frame
+PointCloud SimulateScan(const Eigen::Matrix4d& T_World_Scan,
+                        const std::vector<Box>& objects) {
+  const Eigen::Matrix3d R = T_World_Scan.block<3, 3>(0, 0);
+  const Eigen::Vector3d origin = T_World_Scan.block<3, 1>(0, 3);
+  PointCloud cloud;
+  for (int ring = 0; ring < 16; ring++) {
+    const double elevation = (-15.0 + 2.0 * ring) * M_PI / 180;
+    for (int col = 0; col < 1800; col++) {
+      const double azimuth = col * 0.2 * M_PI / 180;
+      const Eigen::Vector3d dir_scan(std::cos(elevation) * std::cos(azimuth),
+                                     std::cos(elevation) * std::sin(azimuth),
+                                     std::sin(elevation));
+      const Eigen::Vector3d dir = R * dir_scan;
+
+      double t = std::numeric_limits<double>::infinity();
+      for (int i = 0; i < 2; i++) {
+        if (dir[i] > 1e-12) {
+          t = std::min(t, (kRoomHalfSize - origin[i]) / dir[i]);
+        } else if (dir[i] < -1e-12) {
+          t = std::min(t, (-kRoomHalfSize - origin[i]) / dir[i]);
+        }
+      }
+      if (dir[2] < -1e-12) {
+        t = std::min(t, (kFloorHeight - origin[2]) / dir[2]);
+      }
+      t = std::min(t, Intersect(origin, dir, kPillar));
+      for (const auto& object : objects) {
+        t = std::min(t, Intersect(origin, dir, object));
+      }
+      const Eigen::Vector3d p = t * dir_scan;
+      cloud.push_back(pcl::PointXYZ(p[0], p[1], p[2]));
+    }
+  }
+  return cloud;
+}
+
+PointCloud ToWorld(const PointCloud& cloud,
+                   const Eigen::Matrix4d& T_World_Scan) {
+  PointCloud cloud_world;
+  for (const auto& p : cloud) {
+    Eigen::Vector4d pw = T_World_Scan * Eigen::Vector4d(p.x, p.y, p.z, 1);
+    cloud_world.push_back(pcl::PointXYZ(pw[0], pw[1], pw[2]));
+  }
+  return cloud_world;
+}
+
+size_t CountInBox(const PointCloud& cloud, const Box& box) {
+  return std::count_if(cloud.begin(), cloud.end(), [&](const auto& p) {
+    return box.Contains(Eigen::Vector3d(p.x, p.y, p.z), 0.01);
+  });
+}
+
+struct Scan {
+  Eigen::Matrix4d T_World_Scan;
+  PointCloud cloud;
+};
+
+// sensor driving along x, with the person in the scans set in with_person
+std::vector<Scan> SimulateDrive(const std::vector<bool>& with_person,
+                                const Box& person) {
+  std::vector<Scan> scans;
+  for (size_t i = 0; i < with_person.size(); i++) {
+    Scan scan;
+    scan.T_World_Scan = SensorPose(-4 + 0.8 * i, 0.5, 0.1 * i);
+    std::vector<Box> objects;
+    if (with_person[i]) { objects.push_back(person); }
+    scan.cloud = SimulateScan(scan.T_World_Scan, objects);
+    scans.push_back(scan);
+  }
+  return scans;
+}
+
+std::vector<DynamicPointFilter::View>
+    GetViews(const DynamicPointFilter& filter, const std::vector<Scan>& scans,
+             const std::vector<int>& indices) {
+  std::vector<DynamicPointFilter::View> views;
+  for (int i : indices) {
+    views.push_back(DynamicPointFilter::View{
+        scans[i].T_World_Scan.inverse(), filter.BuildImage(scans[i].cloud)});
+  }
+  return views;
+}
+
+DynamicPointFilter::Params EnabledParams() {
+  DynamicPointFilter::Params params;
+  params.enabled = true;
+  return params;
+}
+
+} // namespace
+
+TEST(DynamicPointFilter, RemovesObjectThatMovedIntoView) {
+  DynamicPointFilter filter(EnabledParams());
+  const Box person = Person(3, 2);
+  const auto scans = SimulateDrive({false, false, false, false, true}, person);
+
+  PointCloud cloud = ToWorld(scans[4].cloud, scans[4].T_World_Scan);
+  const size_t num_person = CountInBox(cloud, person);
+  const size_t num_pillar = CountInBox(cloud, kPillar);
+  const size_t num_static = cloud.size() - num_person;
+  ASSERT_GT(num_person, 100);
+  ASSERT_GT(num_pillar, 100);
+
+  const auto views = GetViews(filter, scans, {0, 1, 2, 3});
+  const size_t num_removed = filter.RemoveSeenThrough(cloud, views, 2);
+
+  // the person is removed, except close to the floor where the other scans
+  // cannot see behind it
+  const size_t num_person_left = CountInBox(cloud, person);
+  EXPECT_LT(num_person_left, 0.2 * num_person);
+  Box upper_body = person;
+  upper_body.min[2] = -0.5;
+  EXPECT_EQ(CountInBox(cloud, upper_body), 0);
+
+  // static structure is kept
+  EXPECT_EQ(CountInBox(cloud, kPillar), num_pillar);
+  EXPECT_EQ(cloud.size(), num_static + num_person_left);
+  EXPECT_EQ(num_removed, num_person - num_person_left);
+  EXPECT_EQ(cloud.width, cloud.size());
+}
+
+TEST(DynamicPointFilter, ClearsObjectThatMovedAway) {
+  DynamicPointFilter filter(EnabledParams());
+  const Box person = Person(5, -2);
+  const auto scans = SimulateDrive({true, false, false, false, false}, person);
+
+  // the oldest scan in the map is checked against the newest scans
+  PointCloud cloud = ToWorld(scans[0].cloud, scans[0].T_World_Scan);
+  const size_t num_person = CountInBox(cloud, person);
+  const size_t num_pillar = CountInBox(cloud, kPillar);
+  ASSERT_GT(num_person, 100);
+
+  const auto views = GetViews(filter, scans, {3, 4});
+  filter.RemoveSeenThrough(cloud, views, 2);
+  EXPECT_LT(CountInBox(cloud, person), 0.2 * num_person);
+  EXPECT_EQ(CountInBox(cloud, kPillar), num_pillar);
+}
+
+TEST(DynamicPointFilter, KeepsStaticScene) {
+  DynamicPointFilter filter(EnabledParams());
+
+  // a person that does not move is static structure
+  const Box person = Person(3, 2);
+  const auto scans = SimulateDrive({true, true, true, true, true}, person);
+  const auto views = GetViews(filter, scans, {0, 1, 2, 3});
+  PointCloud cloud = ToWorld(scans[4].cloud, scans[4].T_World_Scan);
+  EXPECT_EQ(filter.RemoveSeenThrough(cloud, views, 1), 0);
+
+  // not enough views
+  const auto moving = SimulateDrive({false, false, false, false, true}, person);
+  cloud = ToWorld(moving[4].cloud, moving[4].T_World_Scan);
+  const auto one_view = GetViews(filter, moving, {3});
+  EXPECT_EQ(filter.RemoveSeenThrough(cloud, one_view, 2), 0);
+  EXPECT_GT(filter.RemoveSeenThrough(cloud, one_view, 1), 0);
+}
+
+TEST(DynamicPointFilter, LoamCloud) {
+  DynamicPointFilter filter(EnabledParams());
+  const Box person = Person(3, 2);
+  const auto scans = SimulateDrive({false, false, false, true}, person);
+
+  // split the scan into edge and surface features
+  beam_matching::LoamPointCloud loam_cloud;
+  const PointCloud cloud = ToWorld(scans[3].cloud, scans[3].T_World_Scan);
+  for (size_t i = 0; i < cloud.size(); i++) {
+    PointXYZIRT p;
+    p.x = cloud[i].x;
+    p.y = cloud[i].y;
+    p.z = cloud[i].z;
+    if (i % 2 == 0) {
+      loam_cloud.edges.strong.cloud.push_back(p);
+    } else {
+      loam_cloud.surfaces.weak.cloud.push_back(p);
+    }
+  }
+
+  // views built from loam clouds, e.g. when only features are stored
+  std::vector<DynamicPointFilter::View> views;
+  for (int i = 0; i < 3; i++) {
+    beam_matching::LoamPointCloud view_cloud;
+    for (const auto& p : scans[i].cloud) {
+      PointXYZIRT q;
+      q.x = p.x;
+      q.y = p.y;
+      q.z = p.z;
+      view_cloud.surfaces.strong.cloud.push_back(q);
+    }
+    views.push_back(DynamicPointFilter::View{scans[i].T_World_Scan.inverse(),
+                                             filter.BuildImage(view_cloud)});
+  }
+
+  PointCloud reference = cloud;
+  const size_t num_removed_reference =
+      filter.RemoveSeenThrough(reference, views, 2);
+  ASSERT_GT(num_removed_reference, 0);
+  EXPECT_EQ(filter.RemoveSeenThrough(loam_cloud, views, 2),
+            num_removed_reference);
+  EXPECT_EQ(loam_cloud.edges.strong.cloud.size() +
+                loam_cloud.surfaces.weak.cloud.size(),
+            reference.size());
+}
+
+TEST(DynamicPointFilter, RegistrationMap) {
+  auto& map = scan_registration::RegistrationMap::GetInstance();
+  const Box person = Person(3, 2);
+  const auto scans = SimulateDrive({false, false, false, true}, person);
+  auto add_scans = [&map, &scans]() {
+    map.Clear();
+    map.SetMapSize(10);
+    for (size_t i = 0; i < scans.size(); i++) {
+      map.AddPointCloud(scans[i].cloud, beam_matching::LoamPointCloud(),
+                        ros::Time(100 + i), scans[i].T_World_Scan);
+    }
+  };
+
+  // disabled filter keeps everything
+  map.SetDynamicPointFilter(DynamicPointFilter::Params());
+  size_t num_removed_before = map.NumDynamicPointsRemoved();
+  add_scans();
+  const PointCloud unfiltered = map.GetPointCloudMap();
+  EXPECT_EQ(map.NumDynamicPointsRemoved(), num_removed_before);
+  const size_t num_person = CountInBox(unfiltered, person);
+  ASSERT_GT(num_person, 100u);
+
+  // the person in the newest scan is removed when it is added, the static
+  // structure seen by all scans is kept
+  map.SetDynamicPointFilter(EnabledParams());
+  num_removed_before = map.NumDynamicPointsRemoved();
+  add_scans();
+  const PointCloud filtered = map.GetPointCloudMap();
+  const size_t num_removed = map.NumDynamicPointsRemoved() - num_removed_before;
+  EXPECT_GT(num_removed, 0u);
+  EXPECT_LT(CountInBox(filtered, person), 0.2 * num_person);
+  EXPECT_EQ(CountInBox(filtered, kPillar), CountInBox(unfiltered, kPillar));
+  EXPECT_EQ(filtered.size(), unfiltered.size() - num_removed);
+
+  map.SetDynamicPointFilter(DynamicPointFilter::Params());
+  map.Clear();
+}
+
+TEST(DynamicPointFilter, Submap) {
+  std::string current_file = "dynamic_point_filter_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  auto extrinsics = std::make_shared<bs_common::ExtrinsicsLookupBase>(
+      test_path + "data/frame_ids.json", test_path + "data/extrinsics.json");
+  Eigen::Matrix4d T_BASELINK_LIDAR;
+  ASSERT_TRUE(extrinsics->GetT_BASELINK_LIDAR(T_BASELINK_LIDAR));
+
+  const Box person = Person(3, 2);
+  const auto scans = SimulateDrive({false, false, false, true}, person);
+  global_mapping::Submap submap(ros::Time(100), Eigen::Matrix4d::Identity(),
+                                nullptr, extrinsics);
+  for (size_t i = 0; i < scans.size(); i++) {
+    const Eigen::Matrix4d T_World_Baselink =
+        scans[i].T_World_Scan * beam::InvertTransform(T_BASELINK_LIDAR);
+    submap.AddLidarMeasurement(scans[i].cloud, T_World_Baselink,
+                               ros::Time(100 + i));
+  }
+  ASSERT_EQ(submap.LidarKeyframes().size(), scans.size());
+
+  auto keyframe_in_world = [&submap, &scans](size_t i) {
+    return ToWorld(submap.LidarKeyframes().at(ros::Time(100 + i).toNSec())
+                       .Cloud(),
+                   scans[i].T_World_Scan);
+  };
+  const PointCloud last_scan = keyframe_in_world(3);
+  const size_t num_person = CountInBox(last_scan, person);
+  const size_t num_pillar = CountInBox(last_scan, kPillar);
+  ASSERT_GT(num_person, 100u);
+
+  // keyframes are checked in their own frame against the keyframes closest in
+  // time
+  const size_t num_removed =
+      submap.RemoveDynamicPoints(DynamicPointFilter(EnabledParams()));
+  EXPECT_GT(num_removed, 0u);
+  const PointCloud filtered = keyframe_in_world(3);
+  EXPECT_LT(CountInBox(filtered, person), 0.2 * num_person);
+  EXPECT_EQ(CountInBox(filtered, kPillar), num_pillar);
+  EXPECT_EQ(filtered.size(), last_scan.size() - num_removed);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_EQ(keyframe_in_world(i).size(), scans[i].cloud.size());
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "dynamic_point_filter_test");
+  bs_models::test::SetCalibrationParams();
+  return RUN_ALL_TESTS();
+}
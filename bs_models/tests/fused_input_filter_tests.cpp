@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include <nlohmann/json.hpp>
+#include <pcl/io/pcd_io.h>
+
+#include <beam_filtering/Utils.h>
+#include <beam_utils/pointclouds.h>
+#include <beam_utils/time.h>
+
+#include <bs_models/lidar/fused_input_filter.h>
+
+using namespace bs_models;
+
+namespace {
+
+pcl::PointCloud<PointXYZIRT> LoadTestScan() {
+  std::string current_file = "fused_input_filter_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  pcl::PointCloud<PointXYZIRT> cloud;
+  pcl::io::loadPCDFile(test_path + "data/test_scan_vlp16.pcd", cloud);
+  return cloud;
+}
+
+nlohmann::json Cropbox(const std::vector<double>& min,
+                       const std::vector<double>& max, bool remove_outside) {
+  nlohmann::json J;
+  J["filter_type"] = "CROPBOX";
+  J["min"] = min;
+  J["max"] = max;
+  J["remove_outside_points"] = remove_outside;
+  return J;
+}
+
+nlohmann::json Voxel(double size) {
+  nlohmann::json J;
+  J["filter_type"] = "VOXEL";
+  J["cell_size"] = std::vector<double>{size, size, size};
+  return J;
+}
+
+// sort points so that clouds can be compared regardless of their order
+std::vector<std::vector<float>>
+    SortedPoints(const pcl::PointCloud<PointXYZIRT>& cloud) {
+  std::vector<std::vector<float>> points;
+  for (const auto& p : cloud) { points.push_back({p.x, p.y, p.z}); }
+  std::sort(points.begin(), points.end());
+  return points;
+}
+
+void ExpectCloudsEqual(const pcl::PointCloud<PointXYZIRT>& expected,
+                       const pcl::PointCloud<PointXYZIRT>& actual,
+                       float tolerance) {
+  ASSERT_EQ(expected.size(), actual.size());
+  const auto e = SortedPoints(expected);
+  const auto a = SortedPoints(actual);
+  for (size_t i = 0; i < e.size(); i++) {
+    for (int j = 0; j < 3; j++) { EXPECT_NEAR(e[i][j], a[i][j], tolerance); }
+  }
+}
+
+// returns the size of the filtered cloud
+size_t ExpectSameAsChained(const nlohmann::json& J_filters,
+                           const pcl::PointCloud<PointXYZIRT>& cloud,
+                           float tolerance) {
+  FusedInputFilter fused;
+  EXPECT_TRUE(fused.LoadFromJson(J_filters));
+  pcl::PointCloud<PointXYZIRT> fused_cloud;
+  fused.Filter(cloud, fused_cloud);
+
+  auto params = beam_filtering::LoadFilterParamsVector(J_filters);
+  pcl::PointCloud<PointXYZIRT> chained_cloud =
+      beam_filtering::FilterPointCloud<PointXYZIRT>(cloud, params);
+
+  ExpectCloudsEqual(chained_cloud, fused_cloud, tolerance);
+  return fused_cloud.size();
+}
+
+} // namespace
+
+TEST(FusedInputFilter, CropboxSameAsChained) {
+  const auto cloud = LoadTestScan();
+
+  // same filters as config/lidar_filters/input_filters_cropbox.json
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(Cropbox({-1.5, -0.5, -1}, {0.5, 0.5, 1}, false));
+  J_filters.push_back(Cropbox({-25, -25, -25}, {25, 25, 25}, true));
+  ExpectSameAsChained(J_filters, cloud, 0);
+
+  // a tighter crop that removes part of the scan
+  J_filters.push_back(Cropbox({-5, -5, -0.5}, {5, 5, 0.5}, true));
+  EXPECT_LT(ExpectSameAsChained(J_filters, cloud, 0), cloud.size());
+}
+
+TEST(FusedInputFilter, VoxelSameAsChained) {
+  const auto cloud = LoadTestScan();
+
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(Voxel(0.1));
+  EXPECT_LT(ExpectSameAsChained(J_filters, cloud, 1e-4), cloud.size());
+
+  // crop before and after the voxel filter
+  J_filters = nlohmann::json::array();
+  J_filters.push_back(Cropbox({-1.5, -0.5, -1}, {0.5, 0.5, 1}, false));
+  J_filters.push_back(Voxel(0.2));
+  J_filters.push_back(Cropbox({-10, -10, -10}, {10, 10, 10}, true));
+  ExpectSameAsChained(J_filters, cloud, 1e-4);
+}
+
+TEST(FusedInputFilter, RangeAndRings) {
+  const auto cloud = LoadTestScan();
+
+  nlohmann::json J_range;
+  J_range["filter_type"] = "RANGE";
+  J_range["min_range"] = 1.0;
+  J_range["max_range"] = 10.0;
+  nlohmann::json J_rings;
+  J_rings["filter_type"] = "RING_DECIMATION";
+  J_rings["ring_step"] = 2;
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(J_range);
+  J_filters.push_back(J_rings);
+
+  FusedInputFilter fused;
+  ASSERT_TRUE(fused.LoadFromJson(J_filters));
+  pcl::PointCloud<PointXYZIRT> fused_cloud;
+  fused.Filter(cloud, fused_cloud);
+
+  pcl::PointCloud<PointXYZIRT> expected;
+  for (const auto& p : cloud) {
+    const float range = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+    if (range >= 1.0 && range <= 10.0 && p.ring % 2 == 0) {
+      expected.push_back(p);
+    }
+  }
+  ASSERT_GT(expected.size(), 0);
+  ASSERT_EQ(fused_cloud.size(), expected.size());
+
+  // order is kept when there is no voxel filter
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(fused_cloud[i].x, expected[i].x);
+    EXPECT_EQ(fused_cloud[i].ring, expected[i].ring);
+    EXPECT_EQ(fused_cloud[i].time, expected[i].time);
+  }
+
+  // rings are ignored for clouds without ring information
+  PointCloud cloud_xyz;
+  for (const auto& p : cloud) {
+    cloud_xyz.push_back(pcl::PointXYZ(p.x, p.y, p.z));
+  }
+  PointCloud fused_xyz;
+  fused.Filter(cloud_xyz, fused_xyz);
+  EXPECT_GT(fused_xyz.size(), fused_cloud.size());
+}
+
+TEST(FusedInputFilter, ReusesOutput) {
+  const auto cloud = LoadTestScan();
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(Cropbox({-10, -10, -10}, {10, 10, 10}, true));
+  J_filters.push_back(Voxel(0.1));
+  FusedInputFilter fused;
+  ASSERT_TRUE(fused.LoadFromJson(J_filters));
+
+  pcl::PointCloud<PointXYZIRT> output;
+  fused.Filter(cloud, output);
+  const size_t size = output.size();
+  const PointXYZIRT* data = output.points.data();
+  fused.Filter(cloud, output);
+  EXPECT_EQ(output.size(), size);
+  EXPECT_EQ(output.points.data(), data);
+  EXPECT_EQ(output.width, size);
+  EXPECT_EQ(output.height, 1);
+
+  // clouds cannot be filtered in place
+  EXPECT_THROW(fused.Filter(output, output), std::invalid_argument);
+}
+
+TEST(FusedInputFilter, NoFilters) {
+  // an organized cloud with one invalid point
+  pcl::PointCloud<PointXYZIRT> cloud;
+  cloud.resize(8);
+  cloud.width = 4;
+  cloud.height = 2;
+  cloud.is_dense = false;
+  for (int i = 0; i < 8; i++) {
+    cloud[i].x = i;
+    cloud[i].ring = i / 4;
+  }
+  cloud[5].x = std::numeric_limits<float>::quiet_NaN();
+
+  FusedInputFilter fused;
+  ASSERT_TRUE(fused.LoadFromJson(nlohmann::json::array()));
+  pcl::PointCloud<PointXYZIRT> output;
+  fused.Filter(cloud, output);
+  EXPECT_EQ(output.width, 4u);
+  EXPECT_EQ(output.height, 2u);
+  EXPECT_FALSE(output.is_dense);
+  ASSERT_EQ(output.size(), 8u);
+  EXPECT_TRUE(std::isnan(output[5].x));
+  EXPECT_EQ(output[6].x, 6);
+}
+
+TEST(FusedInputFilter, FilterOrganized) {
+  pcl::PointCloud<PointXYZIRT> cloud;
+  cloud.resize(8);
+  cloud.width = 4;
+  cloud.height = 2;
+  for (int i = 0; i < 8; i++) {
+    cloud[i].x = i;
+    cloud[i].ring = i / 4;
+  }
+
+  // points with x > 5 are removed, the voxel filter is not applied
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(Cropbox({-1, -1, -1}, {5, 1, 1}, true));
+  J_filters.push_back(Voxel(10));
+  FusedInputFilter fused;
+  ASSERT_TRUE(fused.LoadFromJson(J_filters));
+  pcl::PointCloud<PointXYZIRT> output;
+  fused.FilterOrganized(cloud, output);
+  EXPECT_EQ(output.width, 4u);
+  EXPECT_EQ(output.height, 2u);
+  EXPECT_FALSE(output.is_dense);
+  ASSERT_EQ(output.size(), 8u);
+  for (int i = 0; i < 8; i++) {
+    if (i > 5) {
+      EXPECT_TRUE(std::isnan(output[i].x));
+    } else {
+      EXPECT_EQ(output[i].x, i);
+    }
+    EXPECT_EQ(output[i].ring, cloud[i].ring);
+  }
+  EXPECT_THROW(fused.FilterOrganized(output, output), std::invalid_argument);
+}
+
+TEST(FusedInputFilter, Unsupported) {
+  FusedInputFilter fused;
+  nlohmann::json J_filters = nlohmann::json::array();
+  EXPECT_TRUE(fused.LoadFromJson(J_filters));
+  EXPECT_TRUE(fused.Empty());
+
+  nlohmann::json J_dror;
+  J_dror["filter_type"] = "DROR";
+  J_filters.push_back(J_dror);
+  EXPECT_FALSE(fused.LoadFromJson(J_filters));
+
+  J_filters = nlohmann::json::array();
+  J_filters.push_back(Voxel(0.1));
+  J_filters.push_back(Voxel(0.2));
+  EXPECT_FALSE(fused.LoadFromJson(J_filters));
+
+  nlohmann::json J_bad;
+  J_bad["filter_type"] = "CROPBOX";
+  J_bad["min"] = std::vector<double>{0, 0, 0};
+  EXPECT_ANY_THROW(fused.LoadFromJson(nlohmann::json::array({J_bad})));
+}
+
+// Timing of the fused filter against the chained filters. This only prints
+// the results.
+TEST(FusedInputFilter, Benchmark) {
+  const auto cloud = LoadTestScan();
+  nlohmann::json J_filters = nlohmann::json::array();
+  J_filters.push_back(Cropbox({-1.5, -0.5, -1}, {0.5, 0.5, 1}, false));
+  J_filters.push_back(Cropbox({-25, -25, -25}, {25, 25, 25}, true));
+  J_filters.push_back(Voxel(0.05));
+  const int iterations = 20;
+
+  FusedInputFilter fused;
+  ASSERT_TRUE(fused.LoadFromJson(J_filters));
+  pcl::PointCloud<PointXYZIRT> output;
+  beam::HighResolutionTimer timer;
+  for (int i = 0; i < iterations; i++) { fused.Filter(cloud, output); }
+  const double fused_s = timer.elapsed() / iterations;
+
+  auto params = beam_filtering::LoadFilterParamsVector(J_filters);
+  timer.restart();
+  for (int i = 0; i < iterations; i++) {
+    output = beam_filtering::FilterPointCloud<PointXYZIRT>(cloud, params);
+  }
+  const double chained_s = timer.elapsed() / iterations;
+  std::cout << "VLP16 test scan (" << cloud.size() << " points): fused "
+            << 1e3 * fused_s << " ms, chained " << 1e3 * chained_s << " ms\n";
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,11 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
 #include <pcl/io/pcd_io.h>
 
 #include <fuse_graphs/hash_graph.h>
 
+#include <beam_calibration/CameraModel.h>
 #include <beam_filtering/VoxelDownsample.h>
 #include <beam_matching/Matchers.h>
+#include <beam_utils/filesystem.h>
 #include <beam_utils/math.h>
 #include <beam_utils/pointclouds.h>
 #include <beam_utils/se3.h>
@@ -13,6 +19,7 @@
 
 #include <bs_models/global_mapping/global_map.h>
 #include <bs_models/global_mapping/global_map_refinement.h>
+#include <bs_models/global_mapping/utils.h>
 #include <bs_models/scan_registration/multi_scan_registration.h>
 #include <bs_models/scan_registration/scan_to_map_registration.h>
 
@@ -85,6 +92,36 @@ protected:
 
   // void TearDown() override {}
 
+  /** global map with one submap of a few scans at known poses */
+  std::shared_ptr<GlobalMap> CreateGlobalMap() {
+    auto camera_model = beam_calibration::CameraModel::Create(
+        test_path_ + "data/intrinsics.json");
+    SubmapPtr submap = std::make_shared<Submap>(
+        ros::Time(1), Eigen::Matrix4d::Identity(), camera_model, extrinsics_);
+    for (int i = 0; i < 3; i++) {
+      Eigen::Matrix4d T_WORLD_BASELINK = Eigen::Matrix4d::Identity();
+      T_WORLD_BASELINK(0, 3) = 0.5 * i;
+      PointCloud cloud_in_lidar_frame;
+      pcl::transformPointCloud(
+          cloud_in_world_frame_, cloud_in_lidar_frame,
+          beam::InvertTransform(T_WORLD_BASELINK * T_BASELINK_LIDAR_));
+      submap->AddLidarMeasurement(cloud_in_lidar_frame, T_WORLD_BASELINK,
+                                  ros::Time(1 + i));
+    }
+    auto global_map = std::make_shared<GlobalMap>(camera_model, extrinsics_);
+    global_map->SetSubmaps({submap});
+    return global_map;
+  }
+
+  /** empty temporary directory for a test */
+  std::string CreateTempDir(const std::string& name) {
+    const boost::filesystem::path dir =
+        boost::filesystem::temp_directory_path() / "bs_models_tests" / name;
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::create_directories(dir);
+    return dir.string();
+  }
+
   std::string test_path_;
   std::string extrinsics_path_;
   std::string frame_ids_path_;
@@ -297,6 +334,148 @@ TEST_F(GlobalMapRefinementTest, ScanToMap) {
   }
 }
 
+TEST_F(GlobalMapRefinementTest, HashBytes) {
+  // FNV-1a test vectors
+  EXPECT_EQ(HashBytes(""), kHashSeed);
+  EXPECT_EQ(HashBytes("a"), 0xaf63dc4c8601ec8cULL);
+  EXPECT_EQ(HashBytes("foobar"), 0x85944171f73967e8ULL);
+
+  // inputs can be chained, and every byte and its position matter
+  EXPECT_EQ(HashBytes("bar", HashBytes("foo")), HashBytes("foobar"));
+  EXPECT_NE(HashBytes("ab"), HashBytes("ba"));
+  EXPECT_NE(HashBytes("foobar"), HashBytes("foobas"));
+  EXPECT_NE(HashBytes("a", 1), HashBytes("a", 2));
+}
+
+TEST_F(GlobalMapRefinementTest, HashFile) {
+  const std::string dir = CreateTempDir("hash_file");
+  const std::string path = dir + "/config.json";
+  std::ofstream(path) << "{\"max_iterations\": 10}";
+  EXPECT_EQ(HashFile(path), HashBytes("{\"max_iterations\": 10}"));
+  EXPECT_EQ(HashFile(path, 7), HashBytes("{\"max_iterations\": 10}", 7));
+
+  std::ofstream(path) << "{\"max_iterations\": 11}";
+  EXPECT_EQ(HashFile(path), HashBytes("{\"max_iterations\": 11}"));
+
+  // files larger than the read buffer
+  const std::string large(3 * (1 << 20) + 17, 'x');
+  std::ofstream(path) << large;
+  EXPECT_EQ(HashFile(path), HashBytes(large));
+
+  // missing files hash their path, so that changing the path still counts
+  EXPECT_EQ(HashFile(""), HashBytes(""));
+  EXPECT_EQ(HashFile(dir + "/missing.json"), HashBytes(dir + "/missing.json"));
+}
+
+TEST_F(GlobalMapRefinementTest, HashDirectory) {
+  const std::string dir1 = CreateTempDir("hash_directory1");
+  const std::string dir2 = CreateTempDir("hash_directory2");
+  EXPECT_EQ(HashDirectory(dir1), kHashSeed);
+
+  // the same files written in a different order
+  boost::filesystem::create_directories(dir1 + "/submap0");
+  std::ofstream(dir1 + "/params.json") << "params";
+  std::ofstream(dir1 + "/submap0/submap.json") << "submap";
+  boost::filesystem::create_directories(dir2 + "/submap0");
+  std::ofstream(dir2 + "/submap0/submap.json") << "submap";
+  std::ofstream(dir2 + "/params.json") << "params";
+  const uint64_t hash = HashDirectory(dir1);
+  EXPECT_EQ(HashDirectory(dir1), hash);
+  EXPECT_EQ(HashDirectory(dir2), hash);
+
+  // content, names and new files all change the hash
+  std::ofstream(dir2 + "/submap0/submap.json") << "submap2";
+  EXPECT_NE(HashDirectory(dir2), hash);
+  std::ofstream(dir2 + "/submap0/submap.json") << "submap";
+  EXPECT_EQ(HashDirectory(dir2), hash);
+  boost::filesystem::rename(dir2 + "/params.json", dir2 + "/params2.json");
+  EXPECT_NE(HashDirectory(dir2), hash);
+  boost::filesystem::rename(dir2 + "/params2.json", dir2 + "/params.json");
+  std::ofstream(dir2 + "/submap0/extra.json") << "";
+  EXPECT_NE(HashDirectory(dir2), hash);
+}
+
+TEST_F(GlobalMapRefinementTest, Checkpoints) {
+  const std::string root = CreateTempDir("checkpoints");
+  const std::string checkpoint_dir = root + "/checkpoints";
+  const std::string step_dir = checkpoint_dir + "/0_submap_alignment";
+  const std::string output_dir = root + "/output";
+  boost::filesystem::create_directories(output_dir);
+
+  // submap alignment with a single submap only saves its checkpoint, and its
+  // matcher config is only hashed
+  GlobalMapRefinement::Params params;
+  params.LoadJson(refinement_config_path_);
+  params.submap_alignment.matcher_config = root + "/matcher.json";
+  std::ofstream(params.submap_alignment.matcher_config) << "config1";
+
+  // a step that runs replaces the whole step directory, so a marker file in
+  // it shows whether the step was skipped
+  const std::string marker = step_dir + "/marker";
+  auto run_alignment = [&](std::shared_ptr<GlobalMap>& global_map,
+                           uint64_t input_hash) {
+    GlobalMapRefinement refinement(global_map, params);
+    refinement.EnableCheckpoints(checkpoint_dir, input_hash);
+    EXPECT_TRUE(refinement.RunSubmapAlignment());
+    refinement.SaveGlobalMapData(output_dir);
+    const bool skipped = boost::filesystem::exists(marker);
+    boost::filesystem::create_directories(step_dir);
+    std::ofstream(marker) << "";
+    return skipped;
+  };
+
+  // the input hash identifies the saved global map data
+  std::shared_ptr<GlobalMap> global_map = CreateGlobalMap();
+  const std::string input_dir = root + "/input";
+  boost::filesystem::create_directories(input_dir);
+  global_map->SaveData(input_dir);
+  const uint64_t input_hash = HashDirectory(input_dir);
+
+  EXPECT_FALSE(run_alignment(global_map, input_hash));
+  nlohmann::json J;
+  ASSERT_TRUE(beam::ReadJson(step_dir + "/checkpoint.json", J));
+  const uint64_t checkpoint_hash = J["hash"].get<uint64_t>();
+  ASSERT_TRUE(boost::filesystem::exists(step_dir + "/GlobalMapData"));
+
+  // same inputs: the step is skipped and the map is restored from the
+  // checkpoint, even if it was changed in memory
+  std::shared_ptr<GlobalMap> moved_map = CreateGlobalMap();
+  Eigen::Matrix4d T_WORLD_SUBMAP = Eigen::Matrix4d::Identity();
+  T_WORLD_SUBMAP(0, 3) = 2;
+  moved_map->GetSubmaps().front()->UpdatePose(T_WORLD_SUBMAP);
+  EXPECT_TRUE(run_alignment(moved_map, input_hash));
+  EXPECT_TRUE(moved_map->GetSubmaps().front()->T_WORLD_SUBMAP().isApprox(
+      Eigen::Matrix4d::Identity(), 1e-9));
+  ASSERT_TRUE(beam::ReadJson(step_dir + "/checkpoint.json", J));
+  EXPECT_EQ(J["hash"].get<uint64_t>(), checkpoint_hash);
+
+  // a different input map invalidates the checkpoint
+  moved_map = CreateGlobalMap();
+  moved_map->GetSubmaps().front()->UpdatePose(T_WORLD_SUBMAP);
+  const std::string moved_dir = root + "/input_moved";
+  boost::filesystem::create_directories(moved_dir);
+  moved_map->SaveData(moved_dir);
+  const uint64_t moved_hash = HashDirectory(moved_dir);
+  EXPECT_NE(moved_hash, input_hash);
+  EXPECT_FALSE(run_alignment(moved_map, moved_hash));
+  EXPECT_TRUE(
+      moved_map->GetSubmaps().front()->T_WORLD_SUBMAP().isApprox(
+          T_WORLD_SUBMAP, 1e-9));
+  ASSERT_TRUE(beam::ReadJson(step_dir + "/checkpoint.json", J));
+  EXPECT_NE(J["hash"].get<uint64_t>(), checkpoint_hash);
+  EXPECT_TRUE(run_alignment(moved_map, moved_hash));
+
+  // and so does a change to a config file
+  std::ofstream(params.submap_alignment.matcher_config) << "config2";
+  EXPECT_FALSE(run_alignment(moved_map, moved_hash));
+  EXPECT_TRUE(run_alignment(moved_map, moved_hash));
+
+  // checkpoints are not used unless enabled
+  GlobalMapRefinement refinement(global_map, params);
+  EXPECT_TRUE(refinement.RunSubmapAlignment());
+  EXPECT_TRUE(boost::filesystem::exists(marker));
+}
+
 /*
 TEST_F(GlobalMapRefinementTest, MultiScanRealData) {
   std::string globalmap_dir =
@@ -318,10 +497,15 @@ TEST_F(GlobalMapRefinementTest, MultiScanRealData) {
 
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
-  std::cout << "Starting ROS test, make sure you have a roscore going\n";
-  ros::init(argc, argv, "scan_to_map_registration_test");
-  bs_models::test::SetCalibrationParams();
-  int ret = RUN_ALL_TESTS();
-  ros::shutdown();
-  return ret;
+
+  // refinement runs offline, so use the static extrinsics from the test data
+  // instead of a ROS master
+  std::string current_file = "global_map_refinement_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  ros::Time::init();
+  ExtrinsicsLookupOnline::InitializeStatic(
+      ExtrinsicsLookupBase(test_path + "data/frame_ids.json",
+                           test_path + "data/extrinsics.json"));
+  return RUN_ALL_TESTS();
 }
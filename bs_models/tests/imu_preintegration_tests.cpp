@@ -773,6 +773,86 @@ TEST_F(ImuPreintegration_ZeroNoiseConstantBias, MultipleTransactions) {
   imu_preintegration->Clear();
 }
 
+TEST_F(ImuPreintegration_ZeroNoiseConstantBias,
+       BufferedMatchesDirectInsertion) {
+  // the reference drains the ring buffer after every measurement, which is
+  // how measurements were inserted before they were buffered. The other only
+  // drains when a result is requested, or when its buffer is full
+  bs_models::ImuPreintegration::Params default_params;
+  bs_models::ImuPreintegration reference("reference", default_params, bg, ba);
+  bs_models::ImuPreintegration buffered("buffered", default_params, bg, ba);
+
+  fuse_variables::Orientation3DStamped::SharedPtr o_start =
+      fuse_variables::Orientation3DStamped::make_shared(IS1.Orientation());
+  fuse_variables::Position3DStamped::SharedPtr p_start =
+      fuse_variables::Position3DStamped::make_shared(IS1.Position());
+  fuse_variables::VelocityLinear3DStamped::SharedPtr v_start =
+      fuse_variables::VelocityLinear3DStamped::make_shared(IS1.Velocity());
+  reference.SetStart(t_start, o_start, p_start, v_start);
+  buffered.SetStart(t_start, o_start, p_start, v_start);
+
+  ros::Time t_prev = t_start;
+  auto check = [&](const ros::Time& t_now, bool register_factor) {
+    Eigen::Vector3d velocity_reference;
+    Eigen::Vector3d velocity_buffered;
+    const bs_models::PoseWithCovariance motion_reference =
+        reference.GetRelativeMotion(t_prev, t_now, velocity_reference);
+    const bs_models::PoseWithCovariance motion_buffered =
+        buffered.GetRelativeMotion(t_prev, t_now, velocity_buffered);
+    EXPECT_TRUE(motion_reference.first == motion_buffered.first);
+    EXPECT_TRUE(motion_reference.second == motion_buffered.second);
+    EXPECT_TRUE(velocity_reference == velocity_buffered);
+    bs_models::test::ExpectImuStateEq(reference.GetSnapshot()->latest,
+                                      buffered.GetSnapshot()->latest, 0);
+    EXPECT_EQ(buffered.GetSnapshot()->latest.Stamp(), t_now);
+    t_prev = t_now;
+    if (!register_factor) { return; }
+
+    auto transaction_reference =
+        reference.RegisterNewImuPreintegratedFactor(t_now);
+    auto transaction_buffered =
+        buffered.RegisterNewImuPreintegratedFactor(t_now);
+    ASSERT_TRUE(transaction_reference);
+    ASSERT_TRUE(transaction_buffered);
+    EXPECT_EQ(transaction_reference->stamp(), transaction_buffered->stamp());
+    EXPECT_EQ(CountVariables(transaction_reference->addedVariables()),
+              CountVariables(transaction_buffered->addedVariables()));
+    EXPECT_EQ(CountConstraints(transaction_reference->addedConstraints()),
+              CountConstraints(transaction_buffered->addedConstraints()));
+    bs_models::test::ExpectImuStateEq(reference.GetImuState(),
+                                      buffered.GetImuState(), 0);
+    EXPECT_EQ(buffered.GetImuState().Stamp(), t_now);
+    bs_models::test::ExpectImuStateEq(buffered.GetSnapshot()->imu_state_i,
+                                      buffered.GetImuState(), 0);
+  };
+
+  // query the relative motion every 0.5 s and register a key frame every 2 s
+  // while the measurements come in
+  bs_common::IMUData last_msg;
+  for (size_t i = 0; i < data.imu_data_gt.size(); i++) {
+    bs_common::IMUData msg = data.imu_data_gt[i];
+    msg.w += bg;
+    msg.a += ba;
+    reference.AddToBuffer(msg);
+    reference.CurrentBufferSize();
+    buffered.AddToBuffer(msg);
+    last_msg = msg;
+    if (i > 0 && i % 50 == 0) { check(msg.t, i % 200 == 0); }
+  }
+
+  // then overflow the ring buffer before the next query
+  const ros::Duration dt(0, data.dt_ns);
+  for (size_t i = 0; i < bs_models::ImuPreintegration::kBufferCapacity + 100;
+       i++) {
+    last_msg.t += dt;
+    reference.AddToBuffer(last_msg);
+    reference.CurrentBufferSize();
+    buffered.AddToBuffer(last_msg);
+  }
+  check(last_msg.t, true);
+  EXPECT_EQ(reference.CurrentBufferSize(), buffered.CurrentBufferSize());
+}
+
 class ImuPreintegration_ProccessNoiseConstantBias : public ::testing::Test {
 public:
   void SetUp() override {
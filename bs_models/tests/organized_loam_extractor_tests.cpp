@@ -0,0 +1,376 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include <pcl/io/pcd_io.h>
+
+#include <beam_matching/Matchers.h>
+#include <beam_utils/pointclouds.h>
+#include <beam_utils/time.h>
+
+#include <bs_models/lidar/organized_loam_extractor.h>
+#include <bs_models/lidar/range_image.h>
+
+using namespace bs_models;
+using namespace beam_matching;
+
+namespace {
+
+// room with walls at x = +/-5, y = +/-4, floor at z = -1.5 and ceiling at
+// z = 3, with a pillar in front of the x = 5 wall that occludes part of it
+const double kRoomX = 5;
+const double kRoomY = 4;
+const double kFloor = -1.5;
+const double kCeiling = 3;
+const double kPillarMinX = 1.8;
+const double kPillarY = 0.2;
+
+// distance along the ray (dx, dy, dz) from the origin to the first surface
+double RayCast(double dx, double dy, double dz) {
+  double t = std::numeric_limits<double>::max();
+  if (dx != 0) { t = std::min(t, (dx > 0 ? kRoomX : -kRoomX) / dx); }
+  if (dy != 0) { t = std::min(t, (dy > 0 ? kRoomY : -kRoomY) / dy); }
+  if (dz != 0) { t = std::min(t, (dz > 0 ? kCeiling : kFloor) / dz); }
+
+  // pillar face facing the sensor
+  if (dx > 0) {
+    const double t_pillar = kPillarMinX / dx;
+    if (t_pillar < t && std::abs(t_pillar * dy) <= kPillarY) { t = t_pillar; }
+  }
+  return t;
+}
+
+/**
+ * @brief simulate a scan of the room. Points are generated column by column
+ * like a spinning lidar, and stored either organized (one row per ring) or
+ * unorganized in firing order.
+ */
+template <typename PointT>
+pcl::PointCloud<PointT> SimulateScan(int num_rings, double fov_deg,
+                                     int num_columns, bool organized) {
+  std::vector<PointT> points(num_rings * num_columns);
+  const double scan_period = 0.1;
+  for (int c = 0; c < num_columns; c++) {
+    // column c covers azimuths [-pi + c * step, -pi + (c + 1) * step)
+    const double azimuth = -M_PI + (c + 0.5) * 2 * M_PI / num_columns;
+    for (int r = 0; r < num_rings; r++) {
+      const double elevation =
+          (-fov_deg / 2 + fov_deg * r / (num_rings - 1)) * M_PI / 180;
+      const double dx = std::cos(elevation) * std::cos(azimuth);
+      const double dy = std::cos(elevation) * std::sin(azimuth);
+      const double dz = std::sin(elevation);
+      const double t = RayCast(dx, dy, dz);
+      PointT p;
+      p.x = t * dx;
+      p.y = t * dy;
+      p.z = t * dz;
+      p.intensity = 10;
+      p.ring = r;
+      p.time = scan_period * c / num_columns;
+      points[r * num_columns + c] = p;
+    }
+  }
+
+  pcl::PointCloud<PointT> cloud;
+  if (organized) {
+    for (const auto& p : points) { cloud.push_back(p); }
+    cloud.width = num_columns;
+    cloud.height = num_rings;
+  } else {
+    for (int c = 0; c < num_columns; c++) {
+      for (int r = 0; r < num_rings; r++) {
+        cloud.push_back(points[r * num_columns + c]);
+      }
+    }
+  }
+  return cloud;
+}
+
+// whether a point lies on a crease of the scene: a vertical room or pillar
+// corner, or where a wall meets the floor or ceiling
+bool OnCrease(const PointXYZIRT& p, double tol) {
+  const double ax = std::abs(p.x);
+  const double ay = std::abs(p.y);
+  const bool on_wall =
+      std::abs(ax - kRoomX) < tol || std::abs(ay - kRoomY) < tol;
+  if (std::abs(ax - kRoomX) < tol && std::abs(ay - kRoomY) < tol) {
+    return true;
+  }
+  if (on_wall &&
+      (std::abs(p.z - kFloor) < tol || std::abs(p.z - kCeiling) < tol)) {
+    return true;
+  }
+  return std::abs(p.x - kPillarMinX) < tol && std::abs(ay - kPillarY) < tol;
+}
+
+// distance from a point to the closest surface of the scene
+double DistanceToSurface(const PointXYZIRT& p) {
+  double d = std::min(std::abs(std::abs(p.x) - kRoomX),
+                      std::abs(std::abs(p.y) - kRoomY));
+  d = std::min(d, std::abs(p.z - kFloor));
+  d = std::min(d, std::abs(p.z - kCeiling));
+  if (std::abs(p.y) <= kPillarY) {
+    d = std::min(d, std::abs(p.x - kPillarMinX));
+  }
+  return d;
+}
+
+// whether a point is on the part of the x = 5 wall next to the pillar's
+// shadow, where its curvature neighbors may be on the pillar
+bool NearPillarShadow(const PointXYZIRT& p) {
+  const double shadow_y = kPillarY * kRoomX / kPillarMinX;
+  return p.x > kRoomX - 0.1 && std::abs(p.y) < shadow_y + 0.3;
+}
+
+void ExpectFeaturesOnScene(const LoamPointCloud& features) {
+  EXPECT_GT(features.edges.strong.cloud.size(), 0);
+  EXPECT_GT(features.surfaces.strong.cloud.size(), 0);
+  EXPECT_GE(features.edges.weak.cloud.size(),
+            features.edges.strong.cloud.size());
+  EXPECT_GT(features.surfaces.weak.cloud.size(),
+            features.surfaces.strong.cloud.size());
+
+  for (const auto& p : features.edges.strong.cloud) {
+    EXPECT_TRUE(OnCrease(p, 0.3))
+        << "edge not on a crease: " << p.x << ", " << p.y << ", " << p.z;
+  }
+  for (const auto& p : features.edges.weak.cloud) {
+    EXPECT_FALSE(NearPillarShadow(p))
+        << "edge on occluded wall: " << p.x << ", " << p.y << ", " << p.z;
+  }
+  for (const auto& p : features.surfaces.strong.cloud) {
+    EXPECT_LT(DistanceToSurface(p), 1e-3);
+  }
+}
+
+std::string GetTestPath() {
+  std::string current_file = "organized_loam_extractor_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  return test_path;
+}
+
+std::shared_ptr<LoamParams> GetLoamParams(int number_of_beams) {
+  auto params =
+      std::make_shared<LoamParams>(GetTestPath() + "data/loam_config.json");
+  params->number_of_beams = number_of_beams;
+  return params;
+}
+
+template <typename PointT>
+double TimeOrganized(OrganizedLoamFeatureExtractor& extractor,
+                     const pcl::PointCloud<PointT>& cloud, int iterations) {
+  beam::HighResolutionTimer timer;
+  for (int i = 0; i < iterations; i++) { extractor.ExtractFeatures(cloud); }
+  return timer.elapsed() / iterations;
+}
+
+template <typename PointT>
+double TimeDefault(LoamFeatureExtractor& extractor,
+                   const pcl::PointCloud<PointT>& cloud, int iterations) {
+  beam::HighResolutionTimer timer;
+  for (int i = 0; i < iterations; i++) { extractor.ExtractFeatures(cloud); }
+  return timer.elapsed() / iterations;
+}
+
+} // namespace
+
+TEST(RangeImage, VelodyneUnorganized) {
+  const auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+  RangeImage image(16, 1800);
+  image.Build(cloud);
+  EXPECT_EQ(image.Rings(), 16);
+  EXPECT_EQ(image.Columns(), 1800);
+  EXPECT_EQ(image.NumPoints(), cloud.size());
+  EXPECT_EQ(image.NumDropped(), 0);
+
+  // points are ordered by ring then by azimuth
+  for (int r = 0; r < image.Rings(); r++) {
+    for (int c = 0; c < image.Columns(); c++) {
+      ASSERT_TRUE(image.Valid(r, c));
+      const auto& p = cloud[c * 16 + r];
+      EXPECT_EQ(image.X(r)[c], p.x);
+      EXPECT_EQ(image.Y(r)[c], p.y);
+      EXPECT_EQ(image.Z(r)[c], p.z);
+      EXPECT_EQ(image.Time(r)[c], p.time);
+    }
+  }
+
+  // the closer point is kept when two points fall in the same cell
+  pcl::PointCloud<PointXYZIRT> doubled = cloud;
+  PointXYZIRT far = cloud[0];
+  far.x *= 2;
+  far.y *= 2;
+  far.z *= 2;
+  doubled.push_back(far);
+  PointXYZIRT bad_ring = cloud[0];
+  bad_ring.ring = 20;
+  doubled.push_back(bad_ring);
+  image.Build(doubled);
+  EXPECT_EQ(image.NumPoints(), cloud.size());
+  EXPECT_EQ(image.NumDropped(), 2);
+  EXPECT_EQ(image.X(0)[0], cloud[0].x);
+
+  // converting back gives the same points
+  EXPECT_EQ(image.ToCloud().size(), cloud.size());
+}
+
+TEST(RangeImage, OusterOrganized) {
+  const auto cloud = SimulateScan<PointXYZITRRNR>(64, 45, 1024, true);
+  RangeImage image(64, 1800);
+  image.Build(cloud);
+
+  // organized clouds use their own width
+  EXPECT_EQ(image.Columns(), 1024);
+  EXPECT_EQ(image.NumPoints(), cloud.size());
+  for (int r = 0; r < image.Rings(); r += 7) {
+    for (int c = 0; c < image.Columns(); c += 13) {
+      EXPECT_EQ(image.X(r)[c], cloud.at(c, r).x);
+      EXPECT_EQ(image.Range(r)[c],
+                std::sqrt(cloud.at(c, r).x * cloud.at(c, r).x +
+                          cloud.at(c, r).y * cloud.at(c, r).y +
+                          cloud.at(c, r).z * cloud.at(c, r).z));
+    }
+  }
+
+  // missing returns leave empty cells
+  pcl::PointCloud<PointXYZITRRNR> with_holes = cloud;
+  with_holes.at(10, 5).x = std::numeric_limits<float>::quiet_NaN();
+  image.Build(with_holes);
+  EXPECT_FALSE(image.Valid(5, 10));
+  EXPECT_EQ(image.NumPoints(), cloud.size() - 1);
+}
+
+TEST(OrganizedLoamFeatureExtractor, Velodyne) {
+  const auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+  OrganizedLoamFeatureExtractor extractor(GetLoamParams(16), 1800);
+  LoamPointCloud features = extractor.ExtractFeatures(cloud);
+  ExpectFeaturesOnScene(features);
+
+  // the order of the input points does not matter since they are binned
+  pcl::PointCloud<PointXYZIRT> shuffled = cloud;
+  std::mt19937 gen(0);
+  std::shuffle(shuffled.begin(), shuffled.end(), gen);
+  LoamPointCloud features_shuffled = extractor.ExtractFeatures(shuffled);
+  EXPECT_EQ(features_shuffled.edges.strong.cloud.size(),
+            features.edges.strong.cloud.size());
+  EXPECT_EQ(features_shuffled.surfaces.strong.cloud.size(),
+            features.surfaces.strong.cloud.size());
+  EXPECT_EQ(features_shuffled.surfaces.weak.cloud.size(),
+            features.surfaces.weak.cloud.size());
+}
+
+TEST(OrganizedLoamFeatureExtractor, Ouster) {
+  const auto cloud = SimulateScan<PointXYZITRRNR>(64, 45, 1024, true);
+  OrganizedLoamFeatureExtractor extractor(GetLoamParams(64), 1800);
+  LoamPointCloud features = extractor.ExtractFeatures(cloud);
+  ExpectFeaturesOnScene(features);
+}
+
+TEST(OrganizedLoamFeatureExtractor, Occlusion) {
+  const auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+  RangeImage image(16, 1800);
+  image.Build(cloud);
+
+  // without the occlusion check, the wall points next to the pillar's shadow
+  // have the highest curvature in their sector and are selected as edges
+  OrganizedLoamFeatureExtractor::Params no_checks;
+  no_checks.occlusion_threshold_m = 100;
+  no_checks.parallel_beam_ratio = 100;
+  OrganizedLoamFeatureExtractor unchecked(GetLoamParams(16), 1800, no_checks);
+  LoamPointCloud features = unchecked.ExtractFeatures(image);
+  int num_occluded{0};
+  for (const auto& p : features.edges.weak.cloud) {
+    if (NearPillarShadow(p)) { num_occluded++; }
+  }
+  EXPECT_GT(num_occluded, 0);
+
+  OrganizedLoamFeatureExtractor checked(GetLoamParams(16), 1800);
+  features = checked.ExtractFeatures(image);
+  for (const auto& p : features.edges.weak.cloud) {
+    EXPECT_FALSE(NearPillarShadow(p));
+  }
+}
+
+TEST(OrganizedLoamFeatureExtractor, ColumnGaps) {
+  // remove a block of columns on every ring, points on either side of the gap
+  // must not be used as neighbors
+  auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+  pcl::PointCloud<PointXYZIRT> with_gap;
+  for (const auto& p : cloud) {
+    const double azimuth = std::atan2(p.y, p.x);
+    if (azimuth > 2.0 && azimuth < 2.1) { continue; }
+    with_gap.push_back(p);
+  }
+  OrganizedLoamFeatureExtractor extractor(GetLoamParams(16), 1800);
+  LoamPointCloud features = extractor.ExtractFeatures(with_gap);
+  ExpectFeaturesOnScene(features);
+  for (const auto& p : features.edges.weak.cloud) {
+    const double azimuth = std::atan2(p.y, p.x);
+    EXPECT_FALSE(azimuth > 1.95 && azimuth < 2.15);
+  }
+}
+
+TEST(OrganizedLoamFeatureExtractor, SharedParams) {
+  // params changed at runtime are used in the next extraction
+  const auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+  auto params = GetLoamParams(16);
+  OrganizedLoamFeatureExtractor extractor(params, 1800);
+  const size_t num_strong_edges =
+      extractor.ExtractFeatures(cloud).edges.strong.cloud.size();
+  params->max_corner_sharp = 0;
+  EXPECT_EQ(extractor.ExtractFeatures(cloud).edges.strong.cloud.size(), 0);
+  EXPECT_GT(num_strong_edges, 0);
+}
+
+// Timing of the organized extractor against the default loam feature
+// extractor, for each supported sensor. This only prints the results.
+TEST(OrganizedLoamFeatureExtractor, Benchmark) {
+  const int iterations = 20;
+
+  {
+    const auto cloud = SimulateScan<PointXYZIRT>(16, 30, 1800, false);
+    auto params = GetLoamParams(16);
+    OrganizedLoamFeatureExtractor organized(params, 1800);
+    LoamFeatureExtractor original(params);
+    std::cout << "VLP16 (" << cloud.size() << " points): organized "
+              << 1e3 * TimeOrganized(organized, cloud, iterations)
+              << " ms, default "
+              << 1e3 * TimeDefault(original, cloud, iterations) << " ms\n";
+  }
+
+  {
+    const auto cloud = SimulateScan<PointXYZITRRNR>(64, 45, 1024, true);
+    auto params = GetLoamParams(64);
+    OrganizedLoamFeatureExtractor organized(params, 1024);
+    LoamFeatureExtractor original(params);
+    std::cout << "OS1-64 (" << cloud.size() << " points): organized "
+              << 1e3 * TimeOrganized(organized, cloud, iterations)
+              << " ms, default "
+              << 1e3 * TimeDefault(original, cloud, iterations) << " ms\n";
+  }
+
+  {
+    pcl::PointCloud<PointXYZIRT> cloud;
+    pcl::io::loadPCDFile(GetTestPath() + "data/test_scan_vlp16.pcd", cloud);
+    auto params = GetLoamParams(16);
+    OrganizedLoamFeatureExtractor organized(params, 1800);
+    LoamFeatureExtractor original(params);
+    LoamPointCloud features = organized.ExtractFeatures(cloud);
+    EXPECT_GT(features.edges.strong.cloud.size(), 0);
+    EXPECT_GT(features.surfaces.strong.cloud.size(), 0);
+    std::cout << "VLP16 test scan (" << cloud.size() << " points): organized "
+              << 1e3 * TimeOrganized(organized, cloud, iterations)
+              << " ms, default "
+              << 1e3 * TimeDefault(original, cloud, iterations) << " ms\n";
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <bs_models/scan_registration/registration_profile_tuner.h>
+
+using namespace bs_models::scan_registration;
+
+RegistrationProfileTuner::Params GetTunerParams() {
+  RegistrationProfileTuner::Params params;
+  params.enabled = true;
+  params.initial_level = 0;
+  params.level_step = 0.5;
+  params.high_load_ratio = 0.8;
+  params.low_load_ratio = 0.5;
+  params.load_smoothing = 1;
+  params.cooldown_scans = 5;
+  params.min_profile.map_size = 40;
+  params.min_profile.max_corner_sharp = 2;
+  params.min_profile.max_corner_less_sharp = 20;
+  params.min_profile.max_surface_flat = 4;
+  params.min_profile.max_correspondence_iterations = 5;
+  params.min_profile.max_solver_time_in_seconds = 0.1;
+  params.max_profile.map_size = 200;
+  params.max_profile.max_corner_sharp = 4;
+  params.max_profile.max_corner_less_sharp = 20;
+  params.max_profile.max_surface_flat = 6;
+  params.max_profile.max_correspondence_iterations = 21;
+  params.max_profile.max_solver_time_in_seconds = 1.0;
+  return params;
+}
+
+// adds num_scans scans at 10 Hz, each taking load * 0.1s to process. Returns
+// the number of profile changes
+int AddScans(RegistrationProfileTuner& tuner, ros::Time& stamp, int num_scans,
+             double load) {
+  int num_changes{0};
+  for (int i = 0; i < num_scans; i++) {
+    stamp += ros::Duration(0.1);
+    if (tuner.AddMeasurement(stamp, load * 0.1)) { num_changes++; }
+  }
+  return num_changes;
+}
+
+TEST(RegistrationProfileTuner, InitialProfile) {
+  auto params = GetTunerParams();
+  RegistrationProfileTuner tuner_min(params);
+  EXPECT_TRUE(tuner_min.GetProfile() == params.min_profile);
+
+  params.initial_level = 1;
+  RegistrationProfileTuner tuner_max(params);
+  EXPECT_TRUE(tuner_max.GetProfile() == params.max_profile);
+
+  params.initial_level = 0.5;
+  RegistrationProfileTuner tuner_mid(params);
+  const auto& profile = tuner_mid.GetProfile();
+  EXPECT_EQ(profile.map_size, 120);
+  EXPECT_EQ(profile.max_corner_sharp, 3);
+  EXPECT_EQ(profile.max_corner_less_sharp, 20);
+  EXPECT_EQ(profile.max_surface_flat, 5);
+  EXPECT_EQ(profile.max_correspondence_iterations, 13);
+  EXPECT_NEAR(profile.max_solver_time_in_seconds, 0.55, 1e-9);
+}
+
+TEST(RegistrationProfileTuner, FollowsLoad) {
+  const auto params = GetTunerParams();
+  RegistrationProfileTuner tuner(params);
+  ros::Time stamp(100);
+
+  // spare time: step up once per cooldown until we reach the max profile
+  EXPECT_EQ(AddScans(tuner, stamp, 4, 0.2), 0);
+  EXPECT_EQ(tuner.GetLevel(), 0);
+  EXPECT_EQ(AddScans(tuner, stamp, 2, 0.2), 1);
+  EXPECT_EQ(tuner.GetLevel(), 0.5);
+  EXPECT_EQ(AddScans(tuner, stamp, 20, 0.2), 1);
+  EXPECT_EQ(tuner.GetLevel(), 1);
+  EXPECT_TRUE(tuner.GetProfile() == params.max_profile);
+  EXPECT_NEAR(tuner.GetLoad(), 0.2, 1e-6);
+
+  // within the band: nothing changes
+  EXPECT_EQ(AddScans(tuner, stamp, 20, 0.7), 0);
+  EXPECT_EQ(tuner.GetLevel(), 1);
+
+  // overloaded: step down until we reach the min profile
+  EXPECT_EQ(AddScans(tuner, stamp, 20, 1.5), 2);
+  EXPECT_EQ(tuner.GetLevel(), 0);
+  EXPECT_TRUE(tuner.GetProfile() == params.min_profile);
+
+  tuner.Reset();
+  EXPECT_EQ(tuner.GetLevel(), params.initial_level);
+  EXPECT_EQ(tuner.GetLoad(), 0);
+}
+
+TEST(RegistrationProfileTuner, Disabled) {
+  auto params = GetTunerParams();
+  params.enabled = false;
+  RegistrationProfileTuner tuner(params);
+  ros::Time stamp(100);
+  EXPECT_EQ(AddScans(tuner, stamp, 50, 0.1), 0);
+  EXPECT_EQ(AddScans(tuner, stamp, 50, 2.0), 0);
+  EXPECT_TRUE(tuner.GetProfile() == params.min_profile);
+  // the load is still measured
+  EXPECT_NEAR(tuner.GetLoad(), 2.0, 1e-6);
+}
+
+TEST(RegistrationProfileTuner, LoadFromJson) {
+  const std::string filename =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("registration_tuning_%%%%%%%%.json"))
+          .string();
+  std::ofstream file(filename);
+  file << R"({
+    "enabled": true, "initial_level": 0.5, "level_step": 0.1,
+    "high_load_ratio": 0.9, "low_load_ratio": 0.4, "load_smoothing": 0.2,
+    "cooldown_scans": 10,
+    "min_profile": {"map_size": 45, "max_corner_sharp": 2,
+      "max_corner_less_sharp": 20, "max_surface_flat": 4,
+      "max_correspondence_iterations": 5, "max_solver_time_in_seconds": 0.1},
+    "max_profile": {"map_size": 200, "max_corner_sharp": 4,
+      "max_corner_less_sharp": 20, "max_surface_flat": 5,
+      "max_correspondence_iterations": 20, "max_solver_time_in_seconds": 1}
+  })";
+  file.close();
+
+  RegistrationProfileTuner::Params params;
+  params.LoadFromJson(filename);
+  EXPECT_TRUE(params.enabled);
+  EXPECT_EQ(params.initial_level, 0.5);
+  EXPECT_EQ(params.cooldown_scans, 10);
+  EXPECT_EQ(params.min_profile.map_size, 45);
+  EXPECT_EQ(params.max_profile.max_correspondence_iterations, 20);
+  EXPECT_EQ(params.max_profile.max_solver_time_in_seconds, 1);
+  boost::filesystem::remove(filename);
+
+  EXPECT_THROW(params.LoadFromJson(filename), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+#include <thread>
+
+#include <bs_models/lidar/scan_redeskewer.h>
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+
+using namespace bs_models;
+
+namespace {
+
+const double kScanDuration{0.1};
+
+/**
+ * true lidar motion: fast yaw rotation with some roll oscillation, and a
+ * constant forward velocity
+ */
+Eigen::Matrix4d TrueTrajectory(double t) {
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      (Eigen::AngleAxisd(1.5 * t, Eigen::Vector3d::UnitZ()) *
+       Eigen::AngleAxisd(0.1 * std::sin(10 * t), Eigen::Vector3d::UnitX()))
+          .toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(0.8 * t, 0.1 * t, 0);
+  return T;
+}
+
+// distance along a ray from inside a box to its walls
+double RayToBox(const Eigen::Vector3d& origin, const Eigen::Vector3d& ray) {
+  const Eigen::Vector3d min(-6, -5, -1.5);
+  const Eigen::Vector3d max(6, 5, 2.5);
+  double range = std::numeric_limits<double>::max();
+  for (int i = 0; i < 3; i++) {
+    if (ray[i] > 1e-9) {
+      range = std::min(range, (max[i] - origin[i]) / ray[i]);
+    } else if (ray[i] < -1e-9) {
+      range = std::min(range, (min[i] - origin[i]) / ray[i]);
+    }
+  }
+  return range;
+}
+
+// raw scan of a box shaped room by a 16 beam lidar moving along the true
+// trajectory, with point times relative to the scan stamp
+pcl::PointCloud<PointXYZIRT> SimulateRawScan(double stamp) {
+  const int columns = 900;
+  pcl::PointCloud<PointXYZIRT> cloud;
+  for (int c = 0; c < columns; c++) {
+    const double time = kScanDuration * c / columns;
+    const Eigen::Matrix4d T_World_Lidar = TrueTrajectory(stamp + time);
+    const Eigen::Matrix3d R = T_World_Lidar.block<3, 3>(0, 0);
+    const Eigen::Vector3d origin = T_World_Lidar.block<3, 1>(0, 3);
+    const double azimuth = 2 * M_PI * c / columns;
+    for (int ring = 0; ring < 16; ring++) {
+      const double elevation = (-15 + 2 * ring) * M_PI / 180;
+      const Eigen::Vector3d ray_Lidar(std::cos(elevation) * std::cos(azimuth),
+                                      std::cos(elevation) * std::sin(azimuth),
+                                      std::sin(elevation));
+      const double range = RayToBox(origin, R * ray_Lidar);
+      PointXYZIRT p;
+      p.x = range * ray_Lidar[0];
+      p.y = range * ray_Lidar[1];
+      p.z = range * ray_Lidar[2];
+      p.ring = ring;
+      p.time = time;
+      cloud.push_back(p);
+    }
+  }
+  return cloud;
+}
+
+ros::Time Stamp(double t) {
+  return ros::Time(100 + t);
+}
+
+double MapThickness(const std::vector<pcl::PointCloud<PointXYZIRT>>& scans,
+                    const std::vector<double>& stamps) {
+  scan_registration::VoxelGaussianMap map(0.5, 6, 1e-3);
+  for (size_t i = 0; i < scans.size(); i++) {
+    PointCloud cloud;
+    for (const auto& p : scans[i]) {
+      cloud.push_back(pcl::PointXYZ(p.x, p.y, p.z));
+    }
+    map.AddPoints(cloud, TrueTrajectory(stamps[i]));
+  }
+  return map.MeanThickness();
+}
+
+} // namespace
+
+TEST(LidarTrajectory, InterpolateAndExtrapolate) {
+  LidarTrajectory trajectory(0.2);
+  Eigen::Matrix4d T;
+  EXPECT_FALSE(trajectory.GetPose(Stamp(0), T));
+  trajectory.AddPose(Stamp(0), TrueTrajectory(0));
+  EXPECT_TRUE(trajectory.GetPose(Stamp(0), T));
+  EXPECT_FALSE(trajectory.GetPose(Stamp(0.05), T));
+  trajectory.AddPose(Stamp(0.1), TrueTrajectory(0.1));
+  trajectory.AddPose(Stamp(0.2), TrueTrajectory(0.2));
+  EXPECT_EQ(trajectory.Start().toNSec(), Stamp(0).toNSec());
+
+  // the true trajectory is close to constant velocity over short intervals,
+  // apart from the roll oscillation
+  for (double t : {0.0, 0.03, 0.1, 0.17, 0.25, -0.05}) {
+    ASSERT_TRUE(trajectory.GetPose(Stamp(t), T));
+    const Eigen::Matrix4d T_true = TrueTrajectory(t);
+    const Eigen::Vector3d dt = T.block<3, 1>(0, 3) - T_true.block<3, 1>(0, 3);
+    const Eigen::Matrix3d dR =
+        T.block<3, 3>(0, 0).transpose() * T_true.block<3, 3>(0, 0);
+    EXPECT_LT(dt.norm(), 1e-3);
+    EXPECT_LT(Eigen::AngleAxisd(dR).angle(), 5e-2);
+  }
+
+  // too far out of the window
+  EXPECT_FALSE(trajectory.GetPose(Stamp(0.5), T));
+  EXPECT_FALSE(trajectory.GetPose(Stamp(-0.3), T));
+}
+
+TEST(ScanRedeskewer, Deskew) {
+  const pcl::PointCloud<PointXYZIRT> raw = SimulateRawScan(0);
+  const ScanRedeskewer::PoseLookup truth =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        T_World_Lidar = TrueTrajectory(time.toSec() - 100);
+        return true;
+      };
+
+  // deskewed points are all in the frame of the first point
+  pcl::PointCloud<PointXYZIRT> deskewed;
+  ASSERT_TRUE(ScanRedeskewer::Deskew(raw, Stamp(0), truth, deskewed));
+  ASSERT_EQ(deskewed.size(), raw.size());
+  const Eigen::Matrix4d T_World_Lidar0 = TrueTrajectory(0);
+  for (size_t i = 0; i < deskewed.size(); i += 97) {
+    const Eigen::Vector3d p_World =
+        T_World_Lidar0.block<3, 3>(0, 0) *
+            Eigen::Vector3d(deskewed[i].x, deskewed[i].y, deskewed[i].z) +
+        T_World_Lidar0.block<3, 1>(0, 3);
+    const Eigen::Matrix4d T_World_LidarN = TrueTrajectory(raw[i].time);
+    const Eigen::Vector3d p_World_true =
+        T_World_LidarN.block<3, 3>(0, 0) *
+            Eigen::Vector3d(raw[i].x, raw[i].y, raw[i].z) +
+        T_World_LidarN.block<3, 1>(0, 3);
+    EXPECT_LT((p_World - p_World_true).norm(), 1e-4);
+    EXPECT_EQ(deskewed[i].time, raw[i].time);
+    EXPECT_EQ(deskewed[i].ring, raw[i].ring);
+  }
+
+  const ScanRedeskewer::PoseLookup unavailable =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        return false;
+      };
+  EXPECT_FALSE(ScanRedeskewer::Deskew(raw, Stamp(0), unavailable, deskewed));
+}
+
+TEST(ScanRedeskewer, ReplaySharpness) {
+  // replay scans received with a poor initial trajectory (e.g. a frame
+  // initializer that only knows the pose at each scan stamp, not the motion
+  // within the scan)
+  const int num_scans = 8;
+  std::vector<double> stamps;
+  for (int i = 0; i < num_scans; i++) { stamps.push_back(kScanDuration * i); }
+  const ScanRedeskewer::PoseLookup initial =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        const double t = time.toSec() - 100;
+        T_World_Lidar =
+            TrueTrajectory(kScanDuration * std::floor(t / kScanDuration + 1e-6));
+        return true;
+      };
+
+  ScanRedeskewer redeskewer;
+  std::vector<pcl::PointCloud<PointXYZIRT>> initial_scans;
+  for (double stamp : stamps) {
+    initial_scans.push_back(
+        redeskewer.AddScan(Stamp(stamp), SimulateRawScan(stamp), initial));
+  }
+  EXPECT_EQ(redeskewer.NumScans(), num_scans);
+
+  // the smoother then refines the trajectory at the scan stamps
+  LidarTrajectory trajectory;
+  for (double stamp : stamps) {
+    trajectory.AddPose(Stamp(stamp), TrueTrajectory(stamp));
+  }
+  const auto redeskewed = redeskewer.Update(trajectory);
+  ASSERT_EQ(redeskewed.size(), num_scans);
+  std::vector<pcl::PointCloud<PointXYZIRT>> redeskewed_scans;
+  for (size_t i = 0; i < redeskewed.size(); i++) {
+    EXPECT_EQ(redeskewed[i].stamp.toNSec(), Stamp(stamps[i]).toNSec());
+    redeskewed_scans.push_back(redeskewed[i].cloud);
+  }
+
+  const double initial_thickness = MapThickness(initial_scans, stamps);
+  const double redeskewed_thickness = MapThickness(redeskewed_scans, stamps);
+  std::cout << "Map thickness, initial deskew: " << initial_thickness
+            << " m, re-deskewed: " << redeskewed_thickness << " m\n";
+  EXPECT_LT(redeskewed_thickness, 0.5 * initial_thickness);
+
+  // nothing changes with the same trajectory
+  EXPECT_TRUE(redeskewer.Update(trajectory).empty());
+
+  // scans that left the window are dropped
+  LidarTrajectory window;
+  for (int i = 4; i < num_scans; i++) {
+    window.AddPose(Stamp(stamps[i]), TrueTrajectory(stamps[i]));
+  }
+  EXPECT_TRUE(redeskewer.Update(window).empty());
+  EXPECT_EQ(redeskewer.NumScans(), num_scans - 4);
+  redeskewer.RemoveScan(Stamp(stamps[4]));
+  EXPECT_EQ(redeskewer.NumScans(), num_scans - 5);
+  EXPECT_TRUE(redeskewer.FindRawScan(Stamp(stamps[4])) == nullptr);
+  ASSERT_TRUE(redeskewer.FindRawScan(Stamp(stamps[5])) != nullptr);
+  EXPECT_EQ(redeskewer.FindRawScan(Stamp(stamps[5]))->size(),
+            SimulateRawScan(stamps[5]).size());
+
+  // raw scans stay valid after they are removed
+  const auto raw5 = redeskewer.FindRawScan(Stamp(stamps[5]));
+  redeskewer.RemoveScan(Stamp(stamps[5]));
+  EXPECT_TRUE(redeskewer.FindRawScan(Stamp(stamps[5])) == nullptr);
+  EXPECT_EQ(raw5->size(), SimulateRawScan(stamps[5]).size());
+}
+
+TEST(ScanRedeskewer, MaxScansPerUpdate) {
+  const int num_scans = 8;
+  std::vector<double> stamps;
+  for (int i = 0; i < num_scans; i++) { stamps.push_back(kScanDuration * i); }
+  const ScanRedeskewer::PoseLookup initial =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        const double t = time.toSec() - 100;
+        T_World_Lidar =
+            TrueTrajectory(kScanDuration * std::floor(t / kScanDuration + 1e-6));
+        return true;
+      };
+
+  ScanRedeskewer::Params params;
+  params.max_scans_per_update = 3;
+  ScanRedeskewer redeskewer(params);
+  for (double stamp : stamps) {
+    redeskewer.AddScan(Stamp(stamp), SimulateRawScan(stamp), initial);
+  }
+  LidarTrajectory trajectory;
+  for (double stamp : stamps) {
+    trajectory.AddPose(Stamp(stamp), TrueTrajectory(stamp));
+  }
+
+  // the scans are spread over updates, each one sorted by stamp
+  std::set<uint64_t> redeskewed_stamps;
+  for (size_t expected : {3u, 3u, 2u, 0u}) {
+    const auto redeskewed = redeskewer.Update(trajectory);
+    ASSERT_EQ(redeskewed.size(), expected);
+    for (size_t i = 0; i < redeskewed.size(); i++) {
+      if (i > 0) { EXPECT_LT(redeskewed[i - 1].stamp, redeskewed[i].stamp); }
+      EXPECT_TRUE(
+          redeskewed_stamps.insert(redeskewed[i].stamp.toNSec()).second);
+    }
+  }
+  EXPECT_EQ(redeskewed_stamps.size(), 8u);
+}
+
+TEST(ScanRedeskewer, ConcurrentAddAndUpdate) {
+  // scans are added by the scan callback while the graph update callback
+  // re-deskews them and drops the scans that left the window
+  const int num_scans = 30;
+  const ScanRedeskewer::PoseLookup truth =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        T_World_Lidar = TrueTrajectory(time.toSec() - 100);
+        return true;
+      };
+  ScanRedeskewer redeskewer;
+  std::atomic<int> added{0};
+  std::thread scan_thread([&]() {
+    for (int i = 0; i < num_scans; i++) {
+      const double stamp = kScanDuration * i;
+      redeskewer.AddScan(Stamp(stamp), SimulateRawScan(stamp), truth);
+      const auto raw = redeskewer.FindRawScan(Stamp(stamp));
+      if (raw) { EXPECT_GT(raw->size(), 0u); }
+      added++;
+    }
+  });
+
+  // the window covers the last 6 scans added
+  auto update = [&redeskewer](int last) {
+    LidarTrajectory window;
+    for (int i = std::max(0, last - 5); i <= last; i++) {
+      window.AddPose(Stamp(kScanDuration * i),
+                     TrueTrajectory(kScanDuration * i + 0.01));
+    }
+    return redeskewer.Update(window);
+  };
+  while (added < num_scans) { update(added); }
+  scan_thread.join();
+  update(num_scans - 1);
+  EXPECT_EQ(redeskewer.NumScans(), 6u);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
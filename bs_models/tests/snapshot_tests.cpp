@@ -0,0 +1,297 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <fuse_constraints/absolute_pose_3d_stamped_constraint.h>
+#include <fuse_graphs/hash_graph.h>
+#include <fuse_variables/orientation_3d_stamped.h>
+#include <fuse_variables/position_3d_stamped.h>
+#include <ros/ros.h>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/math.h>
+#include <beam_utils/se3.h>
+#include <beam_utils/time.h>
+
+#include <bs_common/async_disk_writer.h>
+#include <bs_common/graph_access.h>
+#include <bs_common/snapshot_manager.h>
+#include <bs_models/inertial_odometry.h>
+#include <bs_models/scan_registration/registration_map.h>
+
+#include <test_utils.h>
+
+using namespace bs_models;
+
+class SnapshotTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    path_ = (boost::filesystem::temp_directory_path() /
+             boost::filesystem::unique_path("snapshot_test_%%%%%%%%"))
+                .string();
+    boost::filesystem::create_directories(path_);
+    params_.path = path_;
+    params_.save = true;
+    params_.period_s = 1.0;
+    params_.warm_start = true;
+    auto& snapshot = bs_common::SnapshotManager::GetInstance();
+    snapshot.Reset();
+    snapshot.SetParams(params_);
+  }
+
+  void TearDown() override { boost::filesystem::remove_all(path_); }
+
+  std::string path_;
+  bs_common::SnapshotManager::Params params_;
+};
+
+void CreateGraph(int num_poses, fuse_graphs::HashGraph& graph) {
+  for (int i = 0; i < num_poses; i++) {
+    const ros::Time stamp(100 + 0.1 * i);
+    auto p = fuse_variables::Position3DStamped::make_shared(stamp);
+    p->x() = i;
+    p->y() = 0.5 * i;
+    p->z() = -0.1 * i;
+    auto o = fuse_variables::Orientation3DStamped::make_shared(stamp);
+    Eigen::Quaterniond q(Eigen::AngleAxisd(0.1 * i, Eigen::Vector3d::UnitZ()));
+    o->w() = q.w();
+    o->x() = q.x();
+    o->y() = q.y();
+    o->z() = q.z();
+    graph.addVariable(p);
+    graph.addVariable(o);
+
+    fuse_core::Vector7d mean;
+    mean << p->x(), p->y(), p->z(), q.w(), q.x(), q.y(), q.z();
+    graph.addConstraint(
+        fuse_constraints::AbsolutePose3DStampedConstraint::make_shared(
+            "test", *p, *o, mean, fuse_core::Matrix6d::Identity()));
+  }
+}
+
+TEST_F(SnapshotTest, SaveDueAndAtomicReplace) {
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  const ros::Time t0(10);
+  EXPECT_TRUE(snapshot.SaveDue("component", t0));
+
+  auto write_value = [](int value) {
+    return [value](const std::string& directory) {
+      std::ofstream file(beam::CombinePaths(directory, "value.txt"));
+      file << value;
+      return true;
+    };
+  };
+  int loaded{-1};
+  auto read_value = [&loaded](const std::string& directory) {
+    std::ifstream file(beam::CombinePaths(directory, "value.txt"));
+    file >> loaded;
+    return file.good() || file.eof();
+  };
+
+  ASSERT_TRUE(snapshot.Save("component", t0, write_value(1)));
+  EXPECT_FALSE(snapshot.SaveDue("component", t0 + ros::Duration(0.5)));
+  EXPECT_TRUE(snapshot.SaveDue("component", t0 + ros::Duration(1.0)));
+
+  ros::Time stamp;
+  ASSERT_TRUE(snapshot.GetStamp("component", stamp));
+  EXPECT_EQ(stamp, t0);
+  ASSERT_TRUE(snapshot.Load("component", read_value));
+  EXPECT_EQ(loaded, 1);
+
+  // a failed save must not replace the previous snapshot
+  const ros::Time t1 = t0 + ros::Duration(1.0);
+  EXPECT_FALSE(snapshot.Save("component", t1,
+                             [](const std::string&) { return false; }));
+  ASSERT_TRUE(snapshot.GetStamp("component", stamp));
+  EXPECT_EQ(stamp, t0);
+
+  ASSERT_TRUE(snapshot.Save("component", t1, write_value(2)));
+  ASSERT_TRUE(snapshot.Load("component", read_value));
+  EXPECT_EQ(loaded, 2);
+
+  EXPECT_FALSE(snapshot.Load("missing", read_value));
+}
+
+TEST_F(SnapshotTest, WarmStartGapShorterThanPeriod) {
+  // the latest snapshot can be up to period_s old, so a shorter gap would
+  // reject most warm starts
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  auto params = params_;
+  params.period_s = 5.0;
+  params.max_warm_start_gap_s = 2.0;
+  EXPECT_THROW(snapshot.SetParams(params), std::invalid_argument);
+  EXPECT_EQ(snapshot.GetParams().max_warm_start_gap_s,
+            params_.max_warm_start_gap_s);
+  params.max_warm_start_gap_s = 5.0;
+  EXPECT_NO_THROW(snapshot.SetParams(params));
+}
+
+TEST_F(SnapshotTest, QueuedSavesRunInOrder) {
+  // queued saves of the same component must not run at the same time, they
+  // share its temporary directory
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  const ros::Time t0(10);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(snapshot.SaveAsync(
+        "component", t0 + ros::Duration(i), [i](const std::string& directory) {
+          std::ofstream file(beam::CombinePaths(directory, "value.txt"));
+          file << i;
+          return true;
+        }));
+  }
+  bs_common::AsyncDiskWriter::GetInstance().Flush();
+
+  ros::Time stamp;
+  ASSERT_TRUE(snapshot.GetStamp("component", stamp));
+  EXPECT_EQ(stamp, t0 + ros::Duration(19));
+  int loaded{-1};
+  ASSERT_TRUE(
+      snapshot.Load("component", [&loaded](const std::string& directory) {
+        std::ifstream file(beam::CombinePaths(directory, "value.txt"));
+        file >> loaded;
+        return true;
+      }));
+  EXPECT_EQ(loaded, 19);
+  EXPECT_FALSE(boost::filesystem::exists(
+      beam::CombinePaths(path_, "component.tmp")));
+}
+
+TEST_F(SnapshotTest, GraphRoundTrip) {
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  fuse_graphs::HashGraph graph;
+  CreateGraph(200, graph);
+  const ros::Time stamp = *bs_common::CurrentTimestamps(graph).rbegin();
+
+  beam::HighResolutionTimer timer;
+  ASSERT_TRUE(snapshot.Save("graph", stamp,
+                            [&graph](const std::string& directory) {
+                              return bs_common::SaveGraphToBinaryFile(
+                                  graph,
+                                  beam::CombinePaths(directory, "graph.bin"));
+                            }));
+  const double save_time = timer.elapsed();
+
+  timer.restart();
+  fuse_graphs::HashGraph restored;
+  ASSERT_TRUE(snapshot.Load("graph", [&restored](const std::string& directory) {
+    return bs_common::LoadGraphFromBinaryFile(
+        beam::CombinePaths(directory, "graph.bin"), restored);
+  }));
+  const double load_time = timer.elapsed();
+  std::cout << "Graph with " << bs_common::GetNumberOfVariables(graph)
+            << " variables saved in " << save_time << "s, loaded in "
+            << load_time << "s\n";
+
+  EXPECT_EQ(bs_common::GetNumberOfVariables(restored),
+            bs_common::GetNumberOfVariables(graph));
+  EXPECT_EQ(bs_common::GetNumberOfConstraints(restored),
+            bs_common::GetNumberOfConstraints(graph));
+  for (const auto& variable : graph.getVariables()) {
+    ASSERT_TRUE(restored.variableExists(variable.uuid()));
+    const auto& restored_variable = restored.getVariable(variable.uuid());
+    ASSERT_EQ(restored_variable.size(), variable.size());
+    for (size_t i = 0; i < variable.size(); i++) {
+      EXPECT_EQ(restored_variable.data()[i], variable.data()[i]);
+    }
+  }
+  for (const auto& constraint : graph.getConstraints()) {
+    EXPECT_TRUE(restored.constraintExists(constraint.uuid()));
+  }
+
+  // the restored graph is sent to the optimizer as a single transaction
+  auto transaction = bs_common::GraphToTransaction(restored, stamp);
+  EXPECT_EQ(bs_common::GetNumberOfVariables(transaction),
+            bs_common::GetNumberOfVariables(graph));
+  EXPECT_EQ(bs_common::GetNumberOfConstraints(transaction),
+            bs_common::GetNumberOfConstraints(graph));
+}
+
+TEST_F(SnapshotTest, ImuBufferRoundTrip) {
+  ImuBuffer buffer;
+  for (int i = 0; i < 1000; i++) {
+    auto msg = boost::make_shared<sensor_msgs::Imu>();
+    msg->header.stamp = ros::Time(100 + 0.005 * i);
+    msg->header.seq = i;
+    msg->angular_velocity.x = 0.01 * i;
+    msg->linear_acceleration.z = 9.81 + 0.001 * i;
+    buffer.AddData(msg);
+  }
+
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  const ros::Time stamp = buffer.GetImuMsgs().rbegin()->first;
+  ASSERT_TRUE(
+      snapshot.Save("imu_buffer", stamp, [&buffer](const std::string& dir) {
+        return buffer.Save(dir);
+      }));
+
+  ImuBuffer restored;
+  ASSERT_TRUE(snapshot.Load("imu_buffer", [&restored](const std::string& dir) {
+    return restored.Load(dir);
+  }));
+
+  const auto& msgs = buffer.GetImuMsgs();
+  const auto& restored_msgs = restored.GetImuMsgs();
+  ASSERT_EQ(restored_msgs.size(), msgs.size());
+  for (const auto& stamp_msg : msgs) {
+    const auto& msg = stamp_msg.second;
+    auto iter = restored_msgs.find(stamp_msg.first);
+    ASSERT_TRUE(iter != restored_msgs.end());
+    EXPECT_EQ(iter->second->header.seq, msg->header.seq);
+    EXPECT_EQ(iter->second->angular_velocity.x, msg->angular_velocity.x);
+    EXPECT_EQ(iter->second->linear_acceleration.z,
+              msg->linear_acceleration.z);
+  }
+}
+
+TEST_F(SnapshotTest, RegistrationMapRoundTrip) {
+  auto& map = scan_registration::RegistrationMap::GetInstance();
+  map.Clear();
+  map.SetMapSize(10);
+
+  std::vector<Eigen::Matrix4d, beam::AlignMat4d> poses;
+  for (int i = 0; i < 5; i++) {
+    PointCloud cloud;
+    for (int j = 0; j < 100; j++) {
+      cloud.push_back(pcl::PointXYZ(j * 0.1, i, 1));
+    }
+    Eigen::Matrix4d T_Map_Scan = Eigen::Matrix4d::Identity();
+    T_Map_Scan.block<3, 1>(0, 3) = Eigen::Vector3d(i, 0.5 * i, 0);
+    poses.push_back(T_Map_Scan);
+    map.AddPointCloud(cloud, beam_matching::LoamPointCloud(), ros::Time(100 + i),
+                      T_Map_Scan);
+  }
+  const PointCloud map_cloud = map.GetPointCloudMap();
+
+  auto& snapshot = bs_common::SnapshotManager::GetInstance();
+  // the writer owns a copy of the scans, so the map can change before the
+  // queued save runs
+  ASSERT_TRUE(snapshot.SaveAsync("registration_map", ros::Time(104),
+                                 map.SnapshotWriter()));
+  EXPECT_FALSE(snapshot.SaveDue("registration_map", ros::Time(104.5)));
+  map.Clear();
+  ASSERT_TRUE(map.Empty());
+  bs_common::AsyncDiskWriter::GetInstance().Flush();
+  ASSERT_TRUE(snapshot.Load("registration_map",
+                            [&map](const std::string& directory) {
+                              return map.LoadSnapshot(directory);
+                            }));
+
+  ASSERT_EQ(map.NumScans(), 5);
+  for (int i = 0; i < 5; i++) {
+    Eigen::Matrix4d T_Map_Scan;
+    ASSERT_TRUE(map.GetScanPose(ros::Time(100 + i), T_Map_Scan));
+    bs_models::test::ExpectTransformsNear(T_Map_Scan, poses[i]);
+  }
+  EXPECT_EQ(map.GetPointCloudMap().size(), map_cloud.size());
+  map.Clear();
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "snapshot_test");
+  bs_models::test::SetCalibrationParams();
+  int ret = RUN_ALL_TESTS();
+  ros::shutdown();
+  return ret;
+}
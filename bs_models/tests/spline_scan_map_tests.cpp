@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <fuse_graphs/hash_graph.h>
+
+#include <bs_constraints/spline/spline_point_3d_constraint.h>
+#include <bs_models/lidar/spline_scan_map.h>
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+
+using namespace bs_models;
+
+namespace {
+
+const double kScanDuration{0.1};
+const double kKnotSpacing{0.05};
+
+// true lidar motion: slow yaw rotation and a constant forward velocity
+Eigen::Matrix4d TrueTrajectory(double t) {
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(0.5 * t, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(0.5 * t, 0.05 * t, 0);
+  return T;
+}
+
+// distance along a ray from inside a box to its walls
+double RayToBox(const Eigen::Vector3d& origin, const Eigen::Vector3d& ray) {
+  const Eigen::Vector3d min(-6, -5, -1.5);
+  const Eigen::Vector3d max(6, 5, 2.5);
+  double range = std::numeric_limits<double>::max();
+  for (int i = 0; i < 3; i++) {
+    if (ray[i] > 1e-9) {
+      range = std::min(range, (max[i] - origin[i]) / ray[i]);
+    } else if (ray[i] < -1e-9) {
+      range = std::min(range, (min[i] - origin[i]) / ray[i]);
+    }
+  }
+  return range;
+}
+
+// raw scan of a box shaped room by a 16 beam lidar moving along the true
+// trajectory, with point times relative to the scan stamp
+pcl::PointCloud<PointXYZIRT> SimulateRawScan(double stamp) {
+  const int columns = 900;
+  pcl::PointCloud<PointXYZIRT> cloud;
+  for (int c = 0; c < columns; c++) {
+    const double time = kScanDuration * c / columns;
+    const Eigen::Matrix4d T_World_Lidar = TrueTrajectory(stamp + time);
+    const Eigen::Matrix3d R = T_World_Lidar.block<3, 3>(0, 0);
+    const Eigen::Vector3d origin = T_World_Lidar.block<3, 1>(0, 3);
+    const double azimuth = 2 * M_PI * c / columns;
+    for (int ring = 0; ring < 16; ring++) {
+      const double elevation = (-15 + 2 * ring) * M_PI / 180;
+      const Eigen::Vector3d ray_Lidar(std::cos(elevation) * std::cos(azimuth),
+                                      std::cos(elevation) * std::sin(azimuth),
+                                      std::sin(elevation));
+      const double range = RayToBox(origin, R * ray_Lidar);
+      PointXYZIRT p;
+      p.x = range * ray_Lidar[0];
+      p.y = range * ray_Lidar[1];
+      p.z = range * ray_Lidar[2];
+      p.ring = ring;
+      p.time = time;
+      cloud.push_back(p);
+    }
+  }
+  return cloud;
+}
+
+ros::Time Stamp(double t) {
+  return ros::Time(100 + t);
+}
+
+SplineScanMap::Params GetParams() {
+  SplineScanMap::Params params;
+  params.voxel_size = 1.0;
+  params.points_per_scan = 500;
+  return params;
+}
+
+struct ConstraintCounts {
+  int points{0};
+  int others{0};
+};
+
+ConstraintCounts CountConstraints(const fuse_core::Transaction& transaction) {
+  ConstraintCounts counts;
+  for (const auto& constraint : transaction.addedConstraints()) {
+    if (dynamic_cast<const bs_constraints::SplinePoint3DConstraint*>(
+            &constraint)) {
+      counts.points++;
+    } else {
+      counts.others++;
+    }
+  }
+  return counts;
+}
+
+} // namespace
+
+TEST(SplineScanMap, AddScans) {
+  const bs_constraints::SplineTrajectory spline(kKnotSpacing);
+  SplineScanMap map(GetParams());
+  fuse_graphs::HashGraph graph;
+
+  // the first scan only gets control points and priors
+  const auto raw1 = SimulateRawScan(0);
+  const ScanPose scan1(raw1, Stamp(0), TrueTrajectory(0));
+  const auto transaction1 =
+      map.AddScan("test", spline, nullptr, scan1, raw1, TrueTrajectory(0));
+  ASSERT_TRUE(transaction1);
+  const auto variables1 = transaction1->addedVariables();
+  const int num_variables1 =
+      std::distance(variables1.begin(), variables1.end());
+  EXPECT_EQ(num_variables1, 2 * 5);
+  ConstraintCounts counts = CountConstraints(*transaction1);
+  EXPECT_EQ(counts.points, 0);
+  EXPECT_EQ(counts.others, num_variables1);
+  EXPECT_EQ(map.NumScans(), 1u);
+  EXPECT_GT(map.Map().NumValidVoxels(), 0u);
+  graph.update(*transaction1);
+
+  // the next scan is constrained against the map, and only adds the control
+  // points that are not in the graph yet
+  const auto raw2 = SimulateRawScan(kScanDuration);
+  const ScanPose scan2(raw2, Stamp(kScanDuration),
+                       TrueTrajectory(kScanDuration));
+  const auto transaction2 = map.AddScan("test", spline, &graph, scan2, raw2,
+                                        TrueTrajectory(kScanDuration));
+  ASSERT_TRUE(transaction2);
+  int num_variables2{0};
+  for (const auto& variable : transaction2->addedVariables()) {
+    EXPECT_FALSE(graph.variableExists(variable.uuid()));
+    num_variables2++;
+  }
+  EXPECT_EQ(num_variables2, 2 * 2);
+  counts = CountConstraints(*transaction2);
+  EXPECT_GT(counts.points, GetParams().points_per_scan / 10);
+  EXPECT_EQ(counts.others, 0);
+  EXPECT_EQ(map.NumScans(), 2u);
+
+  // every point constraint is on the spline segment at the time of the point
+  for (const auto& constraint : transaction2->addedConstraints()) {
+    const auto& point =
+        dynamic_cast<const bs_constraints::SplinePoint3DConstraint&>(
+            constraint);
+    EXPECT_GE(point.stamp(), Stamp(kScanDuration));
+    EXPECT_LT(point.stamp(), Stamp(2 * kScanDuration));
+    EXPECT_EQ(point.variables(),
+              spline.SegmentUuids(spline.GetSegment(point.stamp())));
+  }
+
+  map.RemoveScan(Stamp(0));
+  map.RemoveScan(Stamp(kScanDuration));
+  EXPECT_EQ(map.NumScans(), 0u);
+  EXPECT_EQ(map.Map().NumPoints(), 0u);
+}
+
+TEST(SplineScanMap, UpdateScan) {
+  const bs_constraints::SplineTrajectory spline(kKnotSpacing);
+  SplineScanMap map(GetParams());
+  scan_registration::VoxelGaussianMap reference(GetParams().voxel_size);
+
+  // the second scan is inserted at a poor registration result
+  const auto raw1 = SimulateRawScan(0);
+  const ScanPose scan1(raw1, Stamp(0), TrueTrajectory(0));
+  map.AddScan("test", spline, nullptr, scan1, raw1, TrueTrajectory(0));
+  reference.AddPoints(scan1.Cloud(), TrueTrajectory(0));
+
+  const auto raw2 = SimulateRawScan(kScanDuration);
+  Eigen::Matrix4d T_World_Lidar2 = TrueTrajectory(kScanDuration);
+  T_World_Lidar2(0, 3) += 0.3;
+  ScanPose scan2(raw2, Stamp(kScanDuration), T_World_Lidar2);
+  map.AddScan("test", spline, nullptr, scan2, raw2, T_World_Lidar2);
+  reference.AddPoints(scan2.Cloud(), TrueTrajectory(kScanDuration));
+  const double thickness_before = map.Map().MeanThickness();
+  EXPECT_GT(thickness_before, reference.MeanThickness());
+
+  // small corrections are ignored
+  Eigen::Matrix4d T_World_Lidar2_small = T_World_Lidar2;
+  T_World_Lidar2_small(1, 3) += 0.001;
+  scan2.UpdatePose(T_World_Lidar2_small);
+  map.UpdateScan(scan2, false);
+  EXPECT_EQ(map.Map().MeanThickness(), thickness_before);
+
+  // the optimized pose moves the scan in the map
+  scan2.UpdatePose(TrueTrajectory(kScanDuration));
+  map.UpdateScan(scan2, false);
+  EXPECT_EQ(map.Map().NumPoints(), reference.NumPoints());
+  EXPECT_NEAR(map.Map().MeanThickness(), reference.MeanThickness(), 1e-3);
+
+  // a replaced cloud is reinserted even if the scan did not move
+  const ScanPose empty_scan(Stamp(kScanDuration),
+                            TrueTrajectory(kScanDuration));
+  map.UpdateScan(empty_scan, true);
+  EXPECT_EQ(map.Map().NumPoints(), scan1.Cloud().size());
+}
+
+TEST(SplineScanMap, ConcurrentAddAndUpdate) {
+  // scans are added by the scan callback while graph updates move the scans
+  // and remove the ones that left the window
+  const bs_constraints::SplineTrajectory spline(kKnotSpacing);
+  SplineScanMap map(GetParams());
+  const int num_scans = 10;
+  std::vector<pcl::PointCloud<PointXYZIRT>> raw_scans;
+  std::vector<ScanPose> scans;
+  for (int i = 0; i < num_scans; i++) {
+    const double t = kScanDuration * i;
+    raw_scans.push_back(SimulateRawScan(t));
+    scans.emplace_back(raw_scans.back(), Stamp(t), TrueTrajectory(t));
+  }
+
+  std::thread scan_thread([&]() {
+    for (int i = 0; i < num_scans; i++) {
+      map.AddScan("test", spline, nullptr, scans[i], raw_scans[i],
+                  TrueTrajectory(kScanDuration * i));
+    }
+  });
+  for (int repeat = 0; repeat < 20; repeat++) {
+    for (int i = 0; i < num_scans / 2; i++) {
+      map.UpdateScan(scans[i], true);
+    }
+  }
+  for (int i = 0; i < num_scans / 2; i++) {
+    map.RemoveScan(Stamp(kScanDuration * i));
+  }
+  scan_thread.join();
+
+  // removed scans that were not added yet are added afterwards
+  EXPECT_GE(map.NumScans(), static_cast<size_t>(num_scans / 2));
+  for (int i = 0; i < num_scans / 2; i++) {
+    map.RemoveScan(Stamp(kScanDuration * i));
+  }
+  EXPECT_EQ(map.NumScans(), static_cast<size_t>(num_scans / 2));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include <pcl/io/pcd_io.h>
+
+#include <beam_matching/Matchers.h>
+#include <beam_utils/math.h>
+#include <beam_utils/pointclouds.h>
+#include <beam_utils/time.h>
+
+#include <bs_models/scan_registration/voxel_gaussian_map.h>
+#include <bs_models/scan_registration/voxel_gaussian_matcher.h>
+
+using namespace bs_models::scan_registration;
+using namespace beam_matching;
+
+namespace {
+
+std::string GetTestPath() {
+  std::string current_file = "voxel_gaussian_matcher_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  return test_path;
+}
+
+PointCloud LoadTestScan() {
+  PointCloud cloud;
+  pcl::io::loadPCDFile(GetTestPath() + "data/test_scan_vlp16.pcd", cloud);
+  return cloud;
+}
+
+// keep every n-th point, as a cheap stand in for the source downsampling
+PointCloud Subsample(const PointCloud& cloud, int n) {
+  PointCloud subsampled;
+  for (size_t i = 0; i < cloud.size(); i += n) {
+    subsampled.push_back(cloud[i]);
+  }
+  return subsampled;
+}
+
+Eigen::Matrix4d Transform(const Eigen::Vector3d& t, const Eigen::Vector3d& r) {
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  if (r.norm() > 0) {
+    T.block<3, 3>(0, 0) =
+        Eigen::AngleAxisd(r.norm(), r.normalized()).toRotationMatrix();
+  }
+  T.block<3, 1>(0, 3) = t;
+  return T;
+}
+
+double TranslationError(const Eigen::Matrix4d& T1, const Eigen::Matrix4d& T2) {
+  return (T1.block<3, 1>(0, 3) - T2.block<3, 1>(0, 3)).norm();
+}
+
+double RotationErrorDeg(const Eigen::Matrix4d& T1, const Eigen::Matrix4d& T2) {
+  const Eigen::Matrix3d R =
+      T1.block<3, 3>(0, 0).transpose() * T2.block<3, 3>(0, 0);
+  return Eigen::AngleAxisd(R).angle() * 180.0 / M_PI;
+}
+
+// points sampled on three orthogonal walls, with some noise
+PointCloud SimulateCorner(int num_points, std::mt19937& generator) {
+  std::uniform_real_distribution<float> u(0, 4);
+  std::normal_distribution<float> n(0, 0.01);
+  PointCloud cloud;
+  for (int i = 0; i < num_points; i++) {
+    pcl::PointXYZ p;
+    switch (i % 3) {
+      case 0: p = pcl::PointXYZ(n(generator), u(generator), u(generator));
+        break;
+      case 1: p = pcl::PointXYZ(u(generator), n(generator), u(generator));
+        break;
+      default: p = pcl::PointXYZ(u(generator), u(generator), n(generator));
+    }
+    cloud.push_back(p);
+  }
+  return cloud;
+}
+
+} // namespace
+
+TEST(VoxelGaussianMap, IncrementalUpdates) {
+  std::mt19937 generator(0);
+  const PointCloud cloud1 = SimulateCorner(3000, generator);
+  const PointCloud cloud2 = SimulateCorner(3000, generator);
+  const Eigen::Matrix4d T_MAP_CLOUD2 =
+      Transform(Eigen::Vector3d(0.5, 0.2, 0), Eigen::Vector3d(0, 0, 0.1));
+
+  VoxelGaussianMap batch(1.0, 6, 1e-2);
+  batch.AddPoints(cloud1);
+
+  VoxelGaussianMap incremental(1.0, 6, 1e-2);
+  incremental.AddPoints(cloud1);
+  incremental.AddPoints(cloud2, T_MAP_CLOUD2);
+  EXPECT_EQ(incremental.NumPoints(), cloud1.size() + cloud2.size());
+  EXPECT_GE(incremental.NumVoxels(), batch.NumVoxels());
+
+  // removing the second cloud gives the same distributions as never adding it
+  incremental.RemovePoints(cloud2, T_MAP_CLOUD2);
+  EXPECT_EQ(incremental.NumPoints(), batch.NumPoints());
+  EXPECT_EQ(incremental.NumVoxels(), batch.NumVoxels());
+  EXPECT_EQ(incremental.NumValidVoxels(), batch.NumValidVoxels());
+  EXPECT_GT(batch.NumValidVoxels(), 0);
+  for (const auto& p : cloud1) {
+    const Eigen::Vector3d p_MAP(p.x, p.y, p.z);
+    const auto* expected = batch.Find(p_MAP);
+    const auto* voxel = incremental.Find(p_MAP);
+    ASSERT_TRUE(expected);
+    ASSERT_TRUE(voxel);
+    EXPECT_EQ(voxel->num_points, expected->num_points);
+    EXPECT_EQ(voxel->valid, expected->valid);
+    if (!expected->valid) { continue; }
+    EXPECT_TRUE(voxel->mean.isApprox(expected->mean, 1e-6));
+    EXPECT_TRUE(voxel->information.isApprox(expected->information, 1e-4));
+  }
+
+  incremental.Clear();
+  EXPECT_EQ(incremental.NumVoxels(), 0);
+  EXPECT_EQ(incremental.NumPoints(), 0);
+}
+
+TEST(VoxelGaussianMap, Distribution) {
+  // points on a plane z = 0.5 inside a single voxel
+  PointCloud cloud;
+  for (int i = 0; i < 10; i++) {
+    for (int j = 0; j < 10; j++) {
+      cloud.push_back(pcl::PointXYZ(0.05 + 0.1 * i, 0.05 + 0.1 * j, 0.5));
+    }
+  }
+  VoxelGaussianMap map(1.0, 6, 1e-3);
+  map.AddPoints(cloud);
+  ASSERT_EQ(map.NumVoxels(), 1);
+  const auto* voxel = map.Find(Eigen::Vector3d(0.5, 0.5, 0.5));
+  ASSERT_TRUE(voxel);
+  ASSERT_TRUE(voxel->valid);
+  EXPECT_TRUE(voxel->mean.isApprox(Eigen::Vector3d(0.5, 0.5, 0.5), 1e-6));
+
+  // the plane normal has the largest information, limited by regularization
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(voxel->information);
+  const Eigen::Vector3d normal = solver.eigenvectors().col(2);
+  EXPECT_NEAR(std::abs(normal[2]), 1, 1e-9);
+  EXPECT_NEAR(solver.eigenvalues()[2] / solver.eigenvalues()[1], 1e3, 1);
+
+  // voxels with too few points have no distribution
+  VoxelGaussianMap sparse(1.0, 200, 1e-3);
+  sparse.AddPoints(cloud);
+  EXPECT_EQ(sparse.NumVoxels(), 1);
+  EXPECT_EQ(sparse.NumValidVoxels(), 0);
+  EXPECT_FALSE(sparse.Find(Eigen::Vector3d(0.5, 0.5, 0.5))->valid);
+  EXPECT_EQ(sparse.Find(Eigen::Vector3d(-0.5, 0.5, 0.5)), nullptr);
+}
+
+TEST(VoxelGaussianMatcher, TestScan) {
+  const PointCloud scan = LoadTestScan();
+  ASSERT_GT(scan.size(), 1000);
+  VoxelGaussianMatcher::Params params;
+  VoxelGaussianMap map(params.voxel_size, params.min_points_per_voxel,
+                       params.covariance_regularization);
+  map.AddPoints(scan);
+
+  // register a subsampled copy of the scan from a perturbed initial estimate
+  const PointCloud source = Subsample(scan, 5);
+  const Eigen::Matrix4d T_MAP_SOURCE = Eigen::Matrix4d::Identity();
+  const Eigen::Matrix4d T_MAP_SOURCE_INIT = Transform(
+      Eigen::Vector3d(0.15, -0.1, 0.05), Eigen::Vector3d(0.01, -0.02, 0.05));
+  VoxelGaussianMatcher matcher(params);
+  Eigen::Matrix4d T_MAP_SOURCE_EST = T_MAP_SOURCE_INIT;
+  ASSERT_TRUE(matcher.Match(source, map, T_MAP_SOURCE_EST));
+  EXPECT_LT(TranslationError(T_MAP_SOURCE_EST, T_MAP_SOURCE), 0.01);
+  EXPECT_LT(RotationErrorDeg(T_MAP_SOURCE_EST, T_MAP_SOURCE), 0.2);
+  EXPECT_LT(matcher.NumIterations(), params.max_iterations);
+  EXPECT_GT(matcher.NumCorrespondences(), params.min_correspondences);
+
+  // the covariance is a valid, small covariance
+  const Eigen::Matrix<double, 6, 6>& covariance = matcher.GetCovariance();
+  EXPECT_TRUE(covariance.isApprox(covariance.transpose()));
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 6, 6>> solver(
+      covariance);
+  EXPECT_GT(solver.eigenvalues().minCoeff(), 0);
+  EXPECT_LT(solver.eigenvalues().maxCoeff(), 1e-2);
+
+  // matching to an empty map fails
+  VoxelGaussianMap empty_map;
+  Eigen::Matrix4d T = T_MAP_SOURCE_INIT;
+  EXPECT_FALSE(matcher.Match(source, empty_map, T));
+  EXPECT_TRUE(T.isApprox(T_MAP_SOURCE_INIT));
+}
+
+TEST(VoxelGaussianMatcher, IsConfig) {
+  EXPECT_FALSE(VoxelGaussianMatcher::IsConfig(GetTestPath() +
+                                              "data/loam_config.json"));
+  EXPECT_FALSE(VoxelGaussianMatcher::IsConfig(GetTestPath() + "data/none"));
+  VoxelGaussianMatcher::Params params;
+  EXPECT_ANY_THROW(params.LoadFromJson(GetTestPath() + "data/none"));
+}
+
+TEST(VoxelGaussianMatcher, BenchmarkAgainstLoam) {
+  const PointCloud scan = LoadTestScan();
+  const Eigen::Matrix4d T_MAP_SOURCE_INIT = Transform(
+      Eigen::Vector3d(0.1, -0.05, 0.02), Eigen::Vector3d(0, 0.01, 0.03));
+  const int iterations = 10;
+
+  // voxel gaussian: map insertion is incremental, so only the matching is
+  // timed per scan
+  VoxelGaussianMatcher::Params params;
+  VoxelGaussianMap map(params.voxel_size, params.min_points_per_voxel,
+                       params.covariance_regularization);
+  beam::HighResolutionTimer timer;
+  map.AddPoints(scan);
+  const double map_time = timer.elapsed();
+  const PointCloud source = Subsample(scan, 5);
+  VoxelGaussianMatcher matcher(params);
+  Eigen::Matrix4d T_MAP_SOURCE_EST;
+  timer.restart();
+  for (int i = 0; i < iterations; i++) {
+    T_MAP_SOURCE_EST = T_MAP_SOURCE_INIT;
+    ASSERT_TRUE(matcher.Match(source, map, T_MAP_SOURCE_EST));
+  }
+  const double voxel_gaussian_time = timer.elapsed() / iterations;
+  const Eigen::Matrix4d I = Eigen::Matrix4d::Identity();
+  EXPECT_LT(TranslationError(T_MAP_SOURCE_EST, I), 0.01);
+
+  // loam, on features extracted from the same scan
+  auto loam_params =
+      std::make_shared<LoamParams>(GetTestPath() + "data/loam_config.json");
+  LoamFeatureExtractor extractor(loam_params);
+  pcl::PointCloud<PointXYZIRT> scan_irt;
+  pcl::io::loadPCDFile(GetTestPath() + "data/test_scan_vlp16.pcd", scan_irt);
+  LoamPointCloudPtr ref =
+      std::make_shared<LoamPointCloud>(extractor.ExtractFeatures(scan_irt));
+  LoamPointCloudPtr target = std::make_shared<LoamPointCloud>(
+      *ref, beam::InvertTransform(T_MAP_SOURCE_INIT));
+  LoamMatcher loam_matcher(*loam_params);
+  timer.restart();
+  for (int i = 0; i < iterations; i++) {
+    loam_matcher.SetRef(ref);
+    loam_matcher.SetTarget(target);
+    ASSERT_TRUE(loam_matcher.Match());
+  }
+  const double loam_time = timer.elapsed() / iterations;
+
+  std::cout << "Voxel gaussian map insertion: " << map_time * 1e3 << " ms, "
+            << map.NumValidVoxels() << " voxels\n"
+            << "Voxel gaussian matching: " << voxel_gaussian_time * 1e3
+            << " ms, " << matcher.NumIterations() << " iterations\n"
+            << "LOAM matching: " << loam_time * 1e3 << " ms\n";
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -35,6 +35,9 @@
 #define BS_OPTIMIZERS_FIXED_LAG_SMOOTHER_H
 
 #include <bs_common/imu_state.h>
+#include <bs_common/thread_placement.h>
+#include <bs_optimizers/linear_solver_selector.h>
+#include <bs_optimizers/optimization_budget.h>
 #include <fuse_core/graph.h>
 #include <fuse_core/transaction.h>
 #include <fuse_optimizers/fixed_lag_smoother_params.h>
@@ -85,6 +88,10 @@ namespace bs_optimizers {
  * Parameters:
  *  - lag_duration (float, default: 5.0) The duration of the smoothing window in
  * seconds
+ *  - marginalization_threads (int, default: 1) Number of threads used to
+ * linearize and eliminate when marginalizing with fuse (i.e., when
+ * pseudo_marginalization is false). 1 uses the serial fuse implementation,
+ * values < 1 use all available cores. See MarginalizeVariablesParallel.
  *  - motion_models (struct array) The set of motion model plugins to load
  *    @code{.yaml}
  *    - name: string  (A unique name for this motion model)
@@ -115,6 +122,84 @@ namespace bs_optimizers {
  * processes sequentially, so no new transactions will be added to the graph
  * while waiting for motion models to be generated. Once the timeout expires,
  * that transaction will be deleted from the queue.
+ *  - degradation_controller (struct) Parameters for the
+ * bs_common::DegradationController which monitors optimization time and queue
+ * length and asks the optimizer and sensor models to shed work when the
+ * system falls behind. See DegradationControllerParams.
+ *    @code{.yaml}
+ *    enabled: bool
+ *    high_load_ratio: double
+ *    low_load_ratio: double
+ *    max_queue_lag_fraction: double
+ *    cycles_to_degrade: int
+ *    cycles_to_recover: int
+ *    @endcode
+ *  - optimization_budget (struct) Parameters for the OptimizationBudget which
+ * limits solver time and iterations so that each cycle fits in a fraction of
+ * the optimization period, and schedules another cycle when the solution did
+ * not converge. See OptimizationBudgetParams.
+ *    @code{.yaml}
+ *    enabled: bool
+ *    budget_fraction: double
+ *    min_solver_time_s: double
+ *    min_iterations: int
+ *    iteration_time_smoothing: double
+ *    carry_over_unconverged: bool
+ *    @endcode
+ *  - snapshot (struct) Parameters for the bs_common::SnapshotManager which
+ * sensor models use to periodically save their state and to warm start from
+ * it after a restart. See SnapshotParams.
+ *    @code{.yaml}
+ *    path: string
+ *    save: bool
+ *    period_s: double
+ *    warm_start: bool
+ *    max_warm_start_gap_s: double
+ *    @endcode
+ *  - async_disk_writer (struct) Parameters for the bs_common::AsyncDiskWriter
+ * which runs scan and debug output writes off the sensor model threads. See
+ * AsyncDiskWriterParams.
+ *    @code{.yaml}
+ *    max_queue_size: int
+ *    overflow_policy: string
+ *    max_block_time_s: double
+ *    @endcode
+ *  - task_scheduler (struct) Parameters for the bs_common::TaskScheduler,
+ * the pool of worker threads shared by the sensor models. See
+ * TaskSchedulerParams.
+ *    @code{.yaml}
+ *    num_threads: int
+ *    realtime_threads: int
+ *    cpu_affinity: [int, ...]
+ *    realtime_cpu_affinity: [int, ...]
+ *    scheduling_policy: string
+ *    priority: int
+ *    realtime_scheduling_policy: string
+ *    realtime_priority: int
+ *    @endcode
+ *  - thread_placement (struct) Cores, scheduling policy and priority of the
+ * optimization thread. The Ceres worker threads are created by the
+ * optimization thread and inherit its placement. How late each cycle starts
+ * after its timer fired is reported in the diagnostics, along with the
+ * callback latencies of the sensor models. See ThreadPlacementParams.
+ *    @code{.yaml}
+ *    cpu_affinity: [int, ...]
+ *    scheduling_policy: string
+ *    priority: int
+ *    @endcode
+ *  - linear_solver_selection (struct) Parameters for the LinearSolverSelector
+ * which chooses the linear solver for each cycle from the graph structure and
+ * the measured solve times, instead of always using
+ * solver_options/linear_solver_type. See LinearSolverSelectionParams.
+ *    @code{.yaml}
+ *    enabled: bool
+ *    candidates: [string, ...]
+ *    landmark_variable_types: [string, ...]
+ *    cost_smoothing: double
+ *    switch_margin: double
+ *    exploration_period: int
+ *    max_exploration_ratio: double
+ *    @endcode
  */
 class FixedLagSmoother : public Optimizer {
 public:
@@ -172,6 +257,12 @@ protected:
                                     //!< background process
   ParameterType params_; //!< Configuration settings for this fixed-lag smoother
   bool use_pseudo_marginalization_;
+  int marginalization_threads_; //!< Threads used to marginalize when not using
+                                //!< pseudo-marginalization. 1 is serial
+  bs_common::ThreadPlacement
+      thread_placement_; //!< Placement of the optimization thread
+  std::shared_ptr<bs_common::JitterMonitor>
+      wake_latency_; //!< Time from the timer firing to the cycle starting
 
   // Inherently thread-safe
   std::atomic<bool> ignited_; //!< Flag indicating the optimizer has received a
@@ -206,6 +297,13 @@ protected:
   ceres::Solver::Summary
       summary_; //!< Optimization summary, written by optimizationLoop and read
                 //!< by setDiagnostics
+  OptimizationBudget budget_; //!< Wall-clock budget for each optimization
+                              //!< cycle. HasCarryOver() is thread-safe
+  size_t num_marginal_priors_{0}; //!< Number of pseudo-marginalization priors
+                                  //!< in the graph after compaction
+  double marginalization_time_s_{0}; //!< Wall time of the last marginalization
+  LinearSolverSelector
+      linear_solver_selector_; //!< Chooses the linear solver for each cycle
 
   // Guarded by optimization_requested_mutex_
   std::mutex
@@ -213,6 +311,8 @@ protected:
   ros::Time
       optimization_deadline_; //!< The deadline for the optimization to
                               //!< complete. Triggers a warning if exceeded.
+  ros::WallTime optimization_request_wall_time_; //!< Wall time at which the
+                                                 //!< timer should have fired
   std::condition_variable
       optimization_requested_; //!< Condition variable used by the optimization
                                //!< thread to wait until a new optimization is
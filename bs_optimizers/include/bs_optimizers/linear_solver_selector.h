@@ -0,0 +1,142 @@
+#ifndef BS_OPTIMIZERS_LINEAR_SOLVER_SELECTOR_H
+#define BS_OPTIMIZERS_LINEAR_SOLVER_SELECTOR_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ceres/solver.h>
+#include <ceres/types.h>
+#include <fuse_core/graph.h>
+
+#include <bs_parameters/optimizers/linear_solver_selection_params.h>
+
+namespace bs_optimizers {
+
+/**
+ * @brief Chooses the ceres linear solver for each optimization cycle of the
+ * fixed lag smoother from the structure of the graph.
+ *
+ * Each candidate solver has a structural cost model (e.g. m * n^2 for dense
+ * QR, landmark Schur fill plus the reduced system for the Schur solvers) which
+ * is multiplied by a running estimate of the measured seconds per unit of
+ * cost. The measured candidate with the lowest predicted linear solve time is
+ * used, with a margin to avoid switching back and forth. Every
+ * exploration_period cycles, a candidate that was never measured is used
+ * instead, or once all are measured, the one measured least recently (if it is
+ * not predicted to be much slower) so that its estimate stays current as the
+ * problem changes. Candidates are never predicted before they are measured,
+ * since the structural costs of different solvers are not in the same units.
+ *
+ * Usage for each cycle:
+ *  (1) ApplyTo() right before solving, which sets the linear solver type
+ *  (2) EndCycle() with the solver summary, which updates the cost estimate of
+ * the solver that was used
+ *
+ * All methods must be called from the optimization thread, or while holding
+ * the optimizer's optimization mutex.
+ */
+class LinearSolverSelector {
+public:
+  using Params = bs_parameters::optimizers::LinearSolverSelectionParams;
+
+  /**
+   * @brief sizes describing the linear system of the graph
+   */
+  struct ProblemStructure {
+    size_t num_variables{0};
+    size_t num_landmarks{0};
+    size_t num_constraints{0};
+    /** total tangent space dimension of all variables */
+    size_t dimension{0};
+    /** dimension left after eliminating the landmarks */
+    size_t reduced_dimension{0};
+    /** number of non-zero jacobian column blocks, weighted by their size */
+    size_t jacobian_nnz{0};
+    /** number of entries each landmark adds to the reduced system */
+    double schur_fill{0};
+  };
+
+  LinearSolverSelector() = default;
+
+  ~LinearSolverSelector() = default;
+
+  /**
+   * @brief set params and clear all estimates. Candidates that are invalid
+   * for this ceres build are removed.
+   * @param params selection params
+   * @param options solver options from the config, whose linear solver is
+   * used when the selector is disabled or no candidate is valid
+   */
+  void Configure(const Params& params, const ceres::Solver::Options& options);
+
+  bool Enabled() const { return params_.enabled && !candidates_.empty(); }
+
+  /**
+   * @brief clear all cost estimates and statistics, keeping the params
+   */
+  void Reset();
+
+  /**
+   * @brief compute the structure of the graph's linear system
+   */
+  ProblemStructure ComputeStructure(const fuse_core::Graph& graph) const;
+
+  /**
+   * @brief select the linear solver for this cycle and set it in the options
+   */
+  void ApplyTo(const fuse_core::Graph& graph, ceres::Solver::Options& options);
+
+  /**
+   * @brief update the cost estimate of the solver used in this cycle
+   * @param summary summary of the solve performed in this cycle
+   */
+  void EndCycle(const ceres::Solver::Summary& summary);
+
+  /**
+   * @brief structural cost of solving a problem with a linear solver, in
+   * arbitrary units
+   */
+  static double StructuralCost(ceres::LinearSolverType type,
+                               const ProblemStructure& structure);
+
+  /**
+   * @brief predicted time of one linear solve, in seconds, or a negative value
+   * if the solver was not measured yet
+   */
+  double PredictSeconds(ceres::LinearSolverType type,
+                        const ProblemStructure& structure) const;
+
+  ceres::LinearSolverType CurrentSolver() const { return current_; }
+
+  /**
+   * @brief time of each linear solve in the last cycle
+   */
+  double LastLinearSolveSeconds() const { return last_linear_solve_s_; }
+
+  /**
+   * @brief number of cycles and mean linear solve time for each solver used
+   */
+  std::string Report() const;
+
+private:
+  struct SolverStats {
+    double seconds_per_cost{0};
+    size_t num_cycles{0};
+    double total_linear_solve_s{0};
+    size_t last_cycle{0};
+  };
+
+  Params params_;
+  std::vector<ceres::LinearSolverType> candidates_;
+  ceres::LinearSolverType default_{ceres::DENSE_QR};
+  ceres::LinearSolverType current_{ceres::DENSE_QR};
+  std::map<ceres::LinearSolverType, SolverStats> stats_;
+  ProblemStructure last_structure_;
+  double last_linear_solve_s_{0};
+  size_t num_cycles_{0};
+};
+
+} // namespace bs_optimizers
+
+#endif // BS_OPTIMIZERS_LINEAR_SOLVER_SELECTOR_H
@@ -0,0 +1,111 @@
+#ifndef BS_OPTIMIZERS_OPTIMIZATION_BUDGET_H
+#define BS_OPTIMIZERS_OPTIMIZATION_BUDGET_H
+
+#include <atomic>
+
+#include <ceres/solver.h>
+#include <ros/time.h>
+
+#include <bs_parameters/optimizers/optimization_budget_params.h>
+
+namespace bs_optimizers {
+
+/**
+ * @brief Gives each optimization cycle of the fixed lag smoother a wall-clock
+ * budget and derives the solver limits from it.
+ *
+ * Usage for each cycle:
+ *  (1) StartCycle() before the graph is updated
+ *  (2) ApplyTo() right before solving, which limits the solver time to what is
+ * left of the budget and the number of iterations to what is expected to fit
+ * in that time, based on a running estimate of the time per iteration
+ *  (3) EndCycle() with the solver summary, which records whether the budget
+ * was met and whether the solution converged
+ *
+ * If a cycle does not converge, HasCarryOver() returns true so the optimizer
+ * can schedule another cycle even when no new transactions are queued.
+ *
+ * All methods other than HasCarryOver() must be called from the optimization
+ * thread, or while holding the optimizer's optimization mutex.
+ */
+class OptimizationBudget {
+public:
+  using Params = bs_parameters::optimizers::OptimizationBudgetParams;
+
+  OptimizationBudget() = default;
+
+  ~OptimizationBudget() = default;
+
+  /**
+   * @brief set params and the optimization period, and clear statistics
+   */
+  void Configure(const Params& params,
+                 const ros::Duration& optimization_period);
+
+  bool Enabled() const { return params_.enabled; }
+
+  /**
+   * @brief clear statistics and any pending carry over, keeping the params
+   */
+  void Reset();
+
+  /**
+   * @brief mark the start of a new cycle
+   */
+  void StartCycle();
+
+  /**
+   * @brief limit the solver options to the budget remaining in this cycle.
+   * Limits are only ever tightened, never loosened past the input options.
+   */
+  void ApplyTo(ceres::Solver::Options& options) const;
+
+  /**
+   * @brief mark the end of the current cycle
+   * @param summary summary of the solve performed in this cycle
+   */
+  void EndCycle(const ceres::Solver::Summary& summary);
+
+  /**
+   * @brief true if the last cycle did not converge and carrying over is
+   * enabled
+   */
+  bool HasCarryOver() const;
+
+  /**
+   * @brief wall time allotted to each cycle
+   */
+  double BudgetSeconds() const;
+
+  /**
+   * @brief fraction of cycles that finished within budget
+   */
+  double HitRate() const;
+
+  /**
+   * @brief wall time spent in the last cycle
+   */
+  double LastCycleSeconds() const { return last_cycle_s_; }
+
+  /**
+   * @brief number of cycles that did not converge and were carried over
+   */
+  size_t NumCarryOvers() const { return num_carry_overs_; }
+
+  size_t NumCycles() const { return num_cycles_; }
+
+private:
+  Params params_;
+  ros::Duration optimization_period_{0.1};
+  ros::WallTime cycle_start_;
+  double seconds_per_iteration_{0};
+  double last_cycle_s_{0};
+  std::atomic<bool> carry_over_{false}; // read by the timer callback
+  size_t num_cycles_{0};
+  size_t num_cycles_in_budget_{0};
+  size_t num_carry_overs_{0};
+};
+
+} // namespace bs_optimizers
+
+#endif // BS_OPTIMIZERS_OPTIMIZATION_BUDGET_H
@@ -0,0 +1,64 @@
+#ifndef BS_OPTIMIZERS_PARALLEL_MARGINALIZATION_H
+#define BS_OPTIMIZERS_PARALLEL_MARGINALIZATION_H
+
+#include <string>
+#include <vector>
+
+#include <fuse_core/graph.h>
+#include <fuse_core/transaction.h>
+#include <fuse_core/uuid.h>
+
+namespace bs_optimizers {
+
+/**
+ * @brief Timing and size statistics of one call to
+ * MarginalizeVariablesParallel
+ */
+struct MarginalizationTiming {
+  double ordering_s{0};
+  double linearization_s{0};
+  double elimination_s{0};
+  double total_s{0};
+  size_t num_constraints{0};
+  size_t num_levels{0};    // number of sequential elimination steps
+  size_t max_level_size{0}; // largest number of eliminations run in parallel
+  size_t num_marginals{0};
+};
+
+/**
+ * @brief Drop-in replacement for fuse_constraints::marginalizeVariables which
+ * runs the expensive steps on multiple threads.
+ *
+ * The result is the same set of marginal constraints as the serial version:
+ *  (1) the elimination order is computed with
+ * fuse_constraints::computeEliminationOrder
+ *  (2) all constraints connected to the marginalized variables are linearized
+ * in parallel
+ *  (3) the elimination tree is built symbolically. Eliminating a variable only
+ * depends on the variables eliminated in its subtree, so all variables at the
+ * same height in the tree (independent cliques) are eliminated in parallel,
+ * level by level from the leaves up
+ *  (4) the remaining linear terms are converted to marginal constraints in
+ * parallel
+ *
+ * Only the floating point summation order differs from the serial version.
+ *
+ * @param source source of the marginal constraints
+ * @param marginalized_variables variables to marginalize out
+ * @param graph graph containing the variables. Only read from, and must not be
+ * modified during the call.
+ * @param num_threads maximum number of threads to use, including the calling
+ * thread. If < 1, all bs_common::TaskScheduler workers can be used
+ * @param timing optional output of timing statistics
+ * @return transaction removing the marginalized variables and their
+ * constraints, and adding the marginal constraints
+ */
+fuse_core::Transaction MarginalizeVariablesParallel(
+    const std::string& source,
+    const std::vector<fuse_core::UUID>& marginalized_variables,
+    const fuse_core::Graph& graph, int num_threads,
+    MarginalizationTiming* timing = nullptr);
+
+} // namespace bs_optimizers
+
+#endif // BS_OPTIMIZERS_PARALLEL_MARGINALIZATION_H
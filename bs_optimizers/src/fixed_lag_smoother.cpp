@@ -33,8 +33,14 @@
  */
 #include <bs_optimizers/fixed_lag_smoother.h>
 
+#include <bs_common/async_disk_writer.h>
+#include <bs_common/degradation_controller.h>
 #include <bs_common/imu_state.h>
+#include <bs_common/snapshot_manager.h>
+#include <bs_common/task_scheduler.h>
 #include <bs_constraints/inertial/absolute_imu_state_3d_stamped_constraint.h>
+#include <bs_constraints/inertial/imu_state_prior_compaction.h>
+#include <bs_optimizers/parallel_marginalization.h>
 #include <bs_parameters/parameter_base.h>
 #include <fuse_constraints/marginalize_variables.h>
 #include <fuse_core/graph.h>
@@ -91,6 +97,48 @@ FixedLagSmoother::FixedLagSmoother(fuse_core::Graph::UniquePtr graph,
   // get additional parameter
   bs_parameters::getParam(ros::NodeHandle("~"), "pseudo_marginalization",
                           use_pseudo_marginalization_, false);
+  bs_parameters::getParam(ros::NodeHandle("~"), "marginalization_threads",
+                          marginalization_threads_, 1);
+
+  // setup load monitoring
+  bs_parameters::optimizers::DegradationControllerParams degradation_params;
+  degradation_params.loadFromROS(
+      ros::NodeHandle("~/degradation_controller"));
+  bs_common::DegradationController::GetInstance().SetParams(
+      degradation_params);
+
+  // setup snapshots for warm restarts
+  bs_parameters::optimizers::SnapshotParams snapshot_params;
+  snapshot_params.loadFromROS(ros::NodeHandle("~/snapshot"));
+  bs_common::SnapshotManager::GetInstance().SetParams(snapshot_params);
+
+  // setup background disk writes
+  bs_parameters::optimizers::AsyncDiskWriterParams writer_params;
+  writer_params.loadFromROS(ros::NodeHandle("~/async_disk_writer"));
+  bs_common::AsyncDiskWriter::GetInstance().SetParams(writer_params);
+
+  // setup the worker threads shared by the sensor models
+  bs_parameters::optimizers::TaskSchedulerParams scheduler_params;
+  scheduler_params.loadFromROS(ros::NodeHandle("~/task_scheduler"));
+  bs_common::TaskScheduler::GetInstance().SetParams(scheduler_params);
+
+  // setup placement of the optimization thread
+  bs_parameters::ThreadPlacementParams placement_params;
+  placement_params.loadFromROS(ros::NodeHandle("~/thread_placement"));
+  thread_placement_ = bs_common::ThreadPlacement("optimizer", placement_params);
+  wake_latency_ = bs_common::JitterMonitor::Create("Optimizer Wake");
+
+  // setup per cycle budget
+  OptimizationBudget::Params budget_params;
+  budget_params.loadFromROS(ros::NodeHandle("~/optimization_budget"));
+  budget_.Configure(budget_params, params_.optimization_period);
+
+  // setup per cycle linear solver selection
+  LinearSolverSelector::Params linear_solver_params;
+  linear_solver_params.loadFromROS(
+      ros::NodeHandle("~/linear_solver_selection"));
+  linear_solver_selector_.Configure(linear_solver_params,
+                                    params_.solver_options);
 
   // Test for auto-start
   autostart();
@@ -168,21 +216,32 @@ void FixedLagSmoother::optimizationLoop() {
     return this->optimization_request_ || !this->optimization_running_ ||
            !ros::ok();
   };
+  // place this thread before the first solve creates the Ceres threads
+  thread_placement_.ApplyToCurrentThread();
   // Optimize constraints until told to exit
   while (ros::ok() && optimization_running_) {
     // Wait for the next signal to start the next optimization cycle
     auto optimization_deadline = ros::Time(0, 0);
+    auto request_wall_time = ros::WallTime(0, 0);
     {
       std::unique_lock<std::mutex> lock(optimization_requested_mutex_);
       optimization_requested_.wait(lock, exit_wait_condition);
       optimization_request_ = false;
       optimization_deadline = optimization_deadline_;
+      request_wall_time = optimization_request_wall_time_;
     }
     // If a shutdown is requested, exit now.
     if (!optimization_running_ || !ros::ok()) { break; }
+    if (!request_wall_time.isZero()) {
+      wake_latency_->AddSample(
+          (ros::WallTime::now() - request_wall_time).toSec());
+    }
     // Optimize
     {
       std::lock_guard<std::mutex> lock(optimization_mutex_);
+      const auto cycle_start = ros::WallTime::now();
+      const bool carry_over = budget_.HasCarryOver();
+      budget_.StartCycle();
       // Apply motion models
       auto new_transaction = fuse_core::Transaction::make_shared();
       // DANGER: processQueue obtains a lock from the
@@ -193,8 +252,9 @@ void FixedLagSmoother::optimizationLoop() {
       //         we are not extremely careful, we could get a deadlock.
       processQueue(*new_transaction, lag_expiration_);
       // Skip this optimization cycle if the transaction is empty because
-      // something failed while processing the pending transactions queue.
-      if (new_transaction->empty()) { continue; }
+      // something failed while processing the pending transactions queue,
+      // unless the last cycle did not converge and we need to keep solving.
+      if (new_transaction->empty() && !carry_over) { continue; }
 
       // ! check for invalid constraints
       std::vector<fuse_core::UUID> faulty_constraints;
@@ -265,10 +325,33 @@ void FixedLagSmoother::optimizationLoop() {
               first_window_state.GetStateVector(),
               Eigen::Matrix<double, 15, 15>::Identity() * 0.00001);
           marginal_transaction_.addConstraint(prior);
+
+          // merge it with any priors left on the same state by earlier cycles
+          // so the number of priors is bounded by the number of states
+          num_marginal_priors_ = bs_constraints::CompactImuStatePriors(
+              *graph_, "MARGINALIZATION", marginal_transaction_);
         }
-      } else {
+      } else if (marginalization_threads_ == 1) {
+        const ros::WallTime marginalization_start = ros::WallTime::now();
         marginal_transaction_ = fuse_constraints::marginalizeVariables(
             ros::this_node::getName(), vars_to_marginalize, *graph_);
+        marginalization_time_s_ =
+            (ros::WallTime::now() - marginalization_start).toSec();
+      } else {
+        MarginalizationTiming timing;
+        marginal_transaction_ = MarginalizeVariablesParallel(
+            ros::this_node::getName(), vars_to_marginalize, *graph_,
+            marginalization_threads_, &timing);
+        marginalization_time_s_ = timing.total_s;
+        ROS_DEBUG_STREAM("Marginalized "
+                         << vars_to_marginalize.size() << " variables and "
+                         << timing.num_constraints << " constraints in "
+                         << timing.total_s << "s (ordering: "
+                         << timing.ordering_s << "s, linearization: "
+                         << timing.linearization_s << "s, elimination: "
+                         << timing.elimination_s << "s over "
+                         << timing.num_levels << " levels, widest: "
+                         << timing.max_level_size << ")");
       }
 
       graph_->update(marginal_transaction_);
@@ -276,10 +359,40 @@ void FixedLagSmoother::optimizationLoop() {
       postprocessMarginalization(marginal_transaction_);
       ROS_DEBUG("----Done marginalizing fuse graph");
 
-      // Optimize the entire graph
+      // Optimize the entire graph, shedding solver iterations if the
+      // degradation controller requests it
+      auto& degradation_controller =
+          bs_common::DegradationController::GetInstance();
+      ceres::Solver::Options solver_options = params_.solver_options;
+      solver_options.max_num_iterations = std::max(
+          1, static_cast<int>(solver_options.max_num_iterations *
+                              degradation_controller.SolverIterationFraction()));
+      linear_solver_selector_.ApplyTo(*graph_, solver_options);
+      budget_.ApplyTo(solver_options);
       ROS_DEBUG("Optimizing fuse graph");
-      summary_ = graph_->optimize(params_.solver_options);
+      summary_ = graph_->optimize(solver_options);
       ROS_DEBUG("Done optimizing fuse graph");
+      budget_.EndCycle(summary_);
+      linear_solver_selector_.EndCycle(summary_);
+      if (linear_solver_selector_.Enabled()) {
+        ROS_INFO_STREAM_THROTTLE(
+            30.0, "Linear solver selection: "
+                      << linear_solver_selector_.Report());
+      }
+      if (budget_.Enabled()) {
+        ROS_DEBUG_STREAM("Optimization cycle took "
+                         << budget_.LastCycleSeconds() << "s of a "
+                         << budget_.BudgetSeconds() << "s budget, "
+                         << summary_.iterations.size() << " iterations, "
+                         << ceres::TerminationTypeToString(
+                                summary_.termination_type));
+        ROS_INFO_STREAM_THROTTLE(
+            30.0, "Optimization budget hit rate: "
+                      << 100 * budget_.HitRate() << "% over "
+                      << budget_.NumCycles() << " cycles, "
+                      << budget_.NumCarryOvers()
+                      << " unconverged cycles carried over");
+      }
 
       // Abort if optimization failed. Not converging is not a failure because
       // the solution found is usable.
@@ -303,6 +416,21 @@ void FixedLagSmoother::optimizationLoop() {
                       << "s");
       }
 
+      // Report this cycle so the load on the system can be adjusted
+      double queue_span_s = 0;
+      {
+        std::lock_guard<std::mutex> pending_lock(pending_transactions_mutex_);
+        if (!pending_transactions_.empty()) {
+          queue_span_s = (pending_transactions_.front().stamp() -
+                          pending_transactions_.back().stamp())
+                             .toSec();
+        }
+      }
+      degradation_controller.AddCycle(
+          (ros::WallTime::now() - cycle_start).toSec(),
+          params_.optimization_period.toSec(), queue_span_s,
+          params_.lag_duration.toSec());
+
       // Optimization is complete. Notify all the things about the graph
       // changes.
       notify(std::move(new_transaction), graph_->clone());
@@ -320,13 +448,19 @@ void FixedLagSmoother::optimizerTimerCallback(const ros::TimerEvent& event) {
   // happen.
   {
     std::lock_guard<std::mutex> lock(pending_transactions_mutex_);
-    optimization_request_ = !pending_transactions_.empty();
+    optimization_request_ =
+        !pending_transactions_.empty() || budget_.HasCarryOver();
   }
   if (optimization_request_) {
     {
       std::lock_guard<std::mutex> lock(optimization_requested_mutex_);
       optimization_deadline_ =
           event.current_expected + params_.optimization_period;
+      optimization_request_wall_time_ =
+          ros::WallTime::now() -
+          ros::WallDuration(
+              std::max((event.current_real - event.current_expected).toSec(),
+                       0.0));
     }
     optimization_requested_.notify_one();
   }
@@ -503,7 +637,12 @@ bool FixedLagSmoother::resetServiceCallback(std_srvs::Empty::Request&,
     marginal_transaction_ = fuse_core::Transaction();
     timestamp_tracking_.clear();
     lag_expiration_ = ros::Time(0, 0);
+    num_marginal_priors_ = 0;
+    budget_.Reset();
+    linear_solver_selector_.Reset();
   }
+  bs_common::DegradationController::GetInstance().Reset();
+  bs_common::SnapshotManager::GetInstance().Reset();
   // Tell all the plugins to start
   startPlugins();
   // Test for auto-start
@@ -538,7 +677,12 @@ void FixedLagSmoother::resetCallback(const std_msgs::Empty::ConstPtr&) {
     marginal_transaction_ = fuse_core::Transaction();
     timestamp_tracking_.clear();
     lag_expiration_ = ros::Time(0, 0);
+    num_marginal_priors_ = 0;
+    budget_.Reset();
+    linear_solver_selector_.Reset();
   }
+  bs_common::DegradationController::GetInstance().Reset();
+  bs_common::SnapshotManager::GetInstance().Reset();
   // Tell all the plugins to start
   startPlugins();
   // Test for auto-start
@@ -686,16 +830,46 @@ void FixedLagSmoother::setDiagnostics(
     std::lock_guard<std::mutex> lock(pending_transactions_mutex_);
     status.add("Pending Transactions", pending_transactions_.size());
   }
+  const auto writer_stats =
+      bs_common::AsyncDiskWriter::GetInstance().GetStats();
+  status.add("Disk Writer Queue", writer_stats.queue_size);
+  status.add("Disk Writer Dropped", writer_stats.dropped);
+  status.add("Disk Writer Failed", writer_stats.failed);
+  const auto scheduler_stats =
+      bs_common::TaskScheduler::GetInstance().GetStats();
+  status.add("Scheduler Utilization", scheduler_stats.utilization);
+  for (size_t p = 0; p < bs_common::TaskScheduler::kNumPriorities; p++) {
+    const auto& priority_stats = scheduler_stats.priorities[p];
+    const std::string name = "Scheduler " + bs_common::TaskScheduler::ToString(
+                                 static_cast<bs_common::TaskPriority>(p));
+    status.add(name + " Queue", priority_stats.queue_size);
+    status.add(name + " Max Wait", priority_stats.max_wait_time_s);
+  }
+  for (const auto& [name, latency] : bs_common::JitterMonitor::GetAllStats()) {
+    status.add(name + " Latency Mean [ms]", latency.mean_s * 1e3);
+    status.add(name + " Latency Stddev [ms]", latency.stddev_s * 1e3);
+    status.add(name + " Latency P99 [ms]", latency.p99_s * 1e3);
+  }
 
   if (started) {
     // Add some optimization summary report fields to the diagnostics status if
     // the optimizer has started
     auto summary = decltype(summary_)();
+    double budget_hit_rate{1};
+    size_t budget_carry_overs{0};
+    size_t num_marginal_priors{0};
+    double marginalization_time_s{0};
+    std::string linear_solver_report;
     {
       const std::unique_lock<std::mutex> lock(optimization_mutex_,
                                               std::try_to_lock);
       if (lock) {
         summary = summary_;
+        budget_hit_rate = budget_.HitRate();
+        budget_carry_overs = budget_.NumCarryOvers();
+        num_marginal_priors = num_marginal_priors_;
+        marginalization_time_s = marginalization_time_s_;
+        linear_solver_report = linear_solver_selector_.Report();
       } else {
         status.summary(diagnostic_msgs::DiagnosticStatus::OK,
                        "Optimization running");
@@ -711,6 +885,24 @@ void FixedLagSmoother::setDiagnostics(
       status.add("Optimization Iterations", summary.iterations.size());
       status.add("Initial Cost", summary.initial_cost);
       status.add("Final Cost", summary.final_cost);
+      status.add("Linear Solver",
+                 ceres::LinearSolverTypeToString(
+                     summary.linear_solver_type_used));
+      status.add("Linear Solver Time [s]",
+                 summary.linear_solver_time_in_seconds);
+      if (linear_solver_selector_.Enabled()) {
+        status.add("Linear Solver Selection", linear_solver_report);
+      }
+      if (budget_.Enabled()) {
+        status.add("Optimization Budget [s]", budget_.BudgetSeconds());
+        status.add("Optimization Budget Hit Rate", budget_hit_rate);
+        status.add("Optimization Carry Overs", budget_carry_overs);
+      }
+      if (use_pseudo_marginalization_) {
+        status.add("Marginal Priors", num_marginal_priors);
+      } else {
+        status.add("Marginalization Time [s]", marginalization_time_s);
+      }
 
       status.mergeSummary(
           terminationTypeToDiagnosticStatus(summary.termination_type));
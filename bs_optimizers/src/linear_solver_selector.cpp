@@ -0,0 +1,269 @@
+#include <bs_optimizers/linear_solver_selector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <fuse_core/uuid.h>
+#include <ros/console.h>
+
+namespace bs_optimizers {
+
+void LinearSolverSelector::Configure(const Params& params,
+                                     const ceres::Solver::Options& options) {
+  params_ = params;
+  default_ = options.linear_solver_type;
+  candidates_.clear();
+  if (params_.enabled) {
+    for (const auto& name : params_.candidates) {
+      ceres::LinearSolverType type;
+      if (!ceres::StringToLinearSolverType(name, &type)) {
+        ROS_WARN_STREAM("Invalid linear solver candidate: " << name
+                                                            << ", ignoring.");
+        continue;
+      }
+      ceres::Solver::Options candidate_options = options;
+      candidate_options.linear_solver_type = type;
+      std::string error;
+      if (!candidate_options.IsValid(&error)) {
+        ROS_WARN_STREAM("Linear solver " << name
+                                         << " cannot be used, ignoring: "
+                                         << error);
+        continue;
+      }
+      if (std::find(candidates_.begin(), candidates_.end(), type) ==
+          candidates_.end()) {
+        candidates_.push_back(type);
+      }
+    }
+    if (candidates_.empty()) {
+      ROS_WARN_STREAM("No valid linear solver candidates, using "
+                      << ceres::LinearSolverTypeToString(default_));
+    }
+  }
+  Reset();
+}
+
+void LinearSolverSelector::Reset() {
+  stats_.clear();
+  current_ = default_;
+  last_structure_ = ProblemStructure();
+  last_linear_solve_s_ = 0;
+  num_cycles_ = 0;
+}
+
+LinearSolverSelector::ProblemStructure
+    LinearSolverSelector::ComputeStructure(
+        const fuse_core::Graph& graph) const {
+  ProblemStructure structure;
+  std::unordered_map<fuse_core::UUID, size_t, fuse_core::uuid::hash> sizes;
+  std::unordered_set<fuse_core::UUID, fuse_core::uuid::hash> landmarks;
+  for (const auto& variable : graph.getVariables()) {
+    const size_t size = variable.localSize();
+    sizes.emplace(variable.uuid(), size);
+    structure.num_variables++;
+    structure.dimension += size;
+    if (std::find(params_.landmark_variable_types.begin(),
+                  params_.landmark_variable_types.end(),
+                  variable.type()) != params_.landmark_variable_types.end()) {
+      landmarks.insert(variable.uuid());
+      structure.num_landmarks++;
+    } else {
+      structure.reduced_dimension += size;
+    }
+  }
+
+  // for each landmark, sum the size of the non-landmark variables it is
+  // connected to. Eliminating it adds a dense block of that size squared to
+  // the reduced system
+  std::unordered_map<fuse_core::UUID, size_t, fuse_core::uuid::hash>
+      landmark_connections;
+  for (const auto& constraint : graph.getConstraints()) {
+    structure.num_constraints++;
+    size_t non_landmark_size{0};
+    const fuse_core::UUID* landmark{nullptr};
+    for (const auto& uuid : constraint.variables()) {
+      auto iter = sizes.find(uuid);
+      if (iter == sizes.end()) { continue; }
+      structure.jacobian_nnz += iter->second;
+      if (landmarks.find(uuid) != landmarks.end()) {
+        landmark = &uuid;
+      } else {
+        non_landmark_size += iter->second;
+      }
+    }
+    if (landmark != nullptr) {
+      landmark_connections[*landmark] += non_landmark_size;
+    }
+  }
+  for (const auto& uuid_size : landmark_connections) {
+    const double size = uuid_size.second;
+    structure.schur_fill += size * size;
+  }
+  return structure;
+}
+
+void LinearSolverSelector::ApplyTo(const fuse_core::Graph& graph,
+                                   ceres::Solver::Options& options) {
+  if (!Enabled()) { return; }
+  num_cycles_++;
+  last_structure_ = ComputeStructure(graph);
+
+  // find the best measured candidate, the measured one used least recently
+  // and the first one not measured yet. Solvers that were not measured are
+  // never predicted, since the structural costs of different solvers are not
+  // in the same units
+  ceres::LinearSolverType best = current_;
+  double best_s = std::numeric_limits<double>::max();
+  ceres::LinearSolverType oldest = current_;
+  size_t oldest_cycle = std::numeric_limits<size_t>::max();
+  ceres::LinearSolverType unmeasured = current_;
+  bool has_measured{false};
+  bool has_unmeasured{false};
+  for (const auto& type : candidates_) {
+    const double predicted_s = PredictSeconds(type, last_structure_);
+    if (predicted_s < 0) {
+      if (!has_unmeasured) { unmeasured = type; }
+      has_unmeasured = true;
+      continue;
+    }
+    has_measured = true;
+    if (predicted_s < best_s) {
+      best_s = predicted_s;
+      best = type;
+    }
+    const size_t last_cycle = stats_[type].last_cycle;
+    if (last_cycle < oldest_cycle) {
+      oldest_cycle = last_cycle;
+      oldest = type;
+    }
+  }
+
+  // only switch if the best solver is clearly faster than the current one
+  ceres::LinearSolverType selected = current_;
+  const bool current_is_candidate =
+      std::find(candidates_.begin(), candidates_.end(), current_) !=
+      candidates_.end();
+  const double current_s = PredictSeconds(current_, last_structure_);
+  if (!current_is_candidate) {
+    selected = has_measured ? best : candidates_.front();
+  } else if (has_measured && current_s >= 0 &&
+             best_s < (1 - params_.switch_margin) * current_s) {
+    selected = best;
+  }
+
+  // solvers that were not measured are tried before any is measured again
+  const bool explore = params_.exploration_period > 0 &&
+                       num_cycles_ % params_.exploration_period == 0;
+  ceres::LinearSolverType explored = selected;
+  if (explore && has_unmeasured) {
+    explored = unmeasured;
+  } else if (explore && has_measured &&
+             PredictSeconds(oldest, last_structure_) <=
+                 params_.max_exploration_ratio * best_s) {
+    explored = oldest;
+  }
+  if (explored != selected) {
+    ROS_DEBUG_STREAM("Exploring linear solver "
+                     << ceres::LinearSolverTypeToString(explored));
+    options.linear_solver_type = explored;
+    return;
+  }
+
+  if (selected != current_) {
+    ROS_INFO_STREAM("Switching linear solver from "
+                    << ceres::LinearSolverTypeToString(current_) << " to "
+                    << ceres::LinearSolverTypeToString(selected)
+                    << " (predicted: "
+                    << PredictSeconds(selected, last_structure_)
+                    << "s per solve, variables: "
+                    << last_structure_.num_variables
+                    << ", landmarks: " << last_structure_.num_landmarks
+                    << ", constraints: " << last_structure_.num_constraints
+                    << ")");
+    current_ = selected;
+  }
+  options.linear_solver_type = current_;
+}
+
+void LinearSolverSelector::EndCycle(const ceres::Solver::Summary& summary) {
+  if (!Enabled() || summary.num_linear_solves <= 0) { return; }
+  const ceres::LinearSolverType used = summary.linear_solver_type_used;
+  last_linear_solve_s_ =
+      summary.linear_solver_time_in_seconds / summary.num_linear_solves;
+
+  SolverStats& stats = stats_[used];
+  stats.num_cycles++;
+  stats.total_linear_solve_s += last_linear_solve_s_;
+  stats.last_cycle = num_cycles_;
+
+  const double cost = StructuralCost(used, last_structure_);
+  if (cost > 0) {
+    const double seconds_per_cost = last_linear_solve_s_ / cost;
+    if (stats.seconds_per_cost <= 0) {
+      stats.seconds_per_cost = seconds_per_cost;
+    } else {
+      stats.seconds_per_cost =
+          params_.cost_smoothing * seconds_per_cost +
+          (1 - params_.cost_smoothing) * stats.seconds_per_cost;
+    }
+  }
+
+  ROS_DEBUG_STREAM("Linear solver "
+                   << ceres::LinearSolverTypeToString(used) << ": "
+                   << summary.num_linear_solves << " solves, "
+                   << last_linear_solve_s_ << "s per solve (predicted "
+                   << PredictSeconds(used, last_structure_) << "s)");
+}
+
+double LinearSolverSelector::StructuralCost(ceres::LinearSolverType type,
+                                            const ProblemStructure& s) {
+  const double n = s.dimension;
+  const double n_r = s.reduced_dimension;
+  const double m = s.num_constraints;
+  const double nnz = s.jacobian_nnz;
+  switch (type) {
+    case ceres::DENSE_QR:
+    case ceres::DENSE_NORMAL_CHOLESKY:
+      return m * n * n;
+    case ceres::DENSE_SCHUR:
+      return s.schur_fill + n_r * n_r * n_r;
+    case ceres::SPARSE_NORMAL_CHOLESKY:
+      return nnz + n * n;
+    case ceres::SPARSE_SCHUR:
+      return s.schur_fill + n_r * n_r;
+    case ceres::ITERATIVE_SCHUR:
+    case ceres::CGNR:
+      // one jacobian product per cg iteration
+      return nnz * std::sqrt(std::max(n_r, 1.0));
+    default:
+      return m * n * n;
+  }
+}
+
+double LinearSolverSelector::PredictSeconds(
+    ceres::LinearSolverType type, const ProblemStructure& structure) const {
+  auto iter = stats_.find(type);
+  if (iter == stats_.end() || iter->second.seconds_per_cost <= 0) {
+    return -1;
+  }
+  return iter->second.seconds_per_cost * StructuralCost(type, structure);
+}
+
+std::string LinearSolverSelector::Report() const {
+  std::stringstream ss;
+  ss << "current: " << ceres::LinearSolverTypeToString(current_);
+  for (const auto& type_stats : stats_) {
+    const SolverStats& stats = type_stats.second;
+    if (stats.num_cycles == 0) { continue; }
+    ss << ", " << ceres::LinearSolverTypeToString(type_stats.first) << ": "
+       << stats.num_cycles << " cycles, "
+       << stats.total_linear_solve_s / stats.num_cycles << "s per solve";
+  }
+  return ss.str();
+}
+
+} // namespace bs_optimizers
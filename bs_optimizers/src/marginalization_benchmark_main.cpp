@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+
+#include <gflags/gflags.h>
+
+#include <beam_utils/gflags.h>
+#include <beam_utils/log.h>
+#include <fuse_constraints/marginalize_variables.h>
+#include <fuse_core/serialization.h>
+#include <fuse_graphs/hash_graph.h>
+#include <fuse_optimizers/variable_stamp_index.h>
+#include <fuse_variables/stamped.h>
+
+#include <bs_optimizers/parallel_marginalization.h>
+
+// clang-format off
+/**
+ * Compares the serial fuse marginalization with MarginalizeVariablesParallel
+ * on a recorded graph. The graph must be a fuse_graphs::HashGraph serialized
+ * with a fuse_core::BinaryOutputArchive (see fuse_core::Graph::serialize).
+ *
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_optimizers/bs_optimizers_marginalization_benchmark_main \
+ -graph_path ~/results/graph.bin \
+ -lag_duration 5 \
+ -threads 8 \
+ -iterations 20
+ */
+// clang-format on
+
+DEFINE_string(graph_path, "",
+              "Full path to the serialized graph to marginalize (Required).");
+DEFINE_validator(graph_path, &beam::gflags::ValidateFileMustExist);
+DEFINE_double(lag_duration, 5.0,
+              "Variables older than the newest stamp in the graph minus this "
+              "duration are marginalized, the same as the fixed lag smoother.");
+DEFINE_int32(threads, 0,
+             "Threads to use for the parallel marginalization. If < 1, uses "
+             "all available cores.");
+DEFINE_int32(iterations, 10, "Number of times to run each implementation.");
+
+namespace {
+
+struct Stats {
+  double mean_s{0};
+  double min_s{0};
+  double max_s{0};
+};
+
+Stats ComputeStats(const std::vector<double>& times) {
+  Stats stats;
+  stats.mean_s =
+      std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+  stats.min_s = *std::min_element(times.begin(), times.end());
+  stats.max_s = *std::max_element(times.begin(), times.end());
+  return stats;
+}
+
+size_t CountAdded(const fuse_core::Transaction& transaction) {
+  auto added = transaction.addedConstraints();
+  return std::distance(added.begin(), added.end());
+}
+
+std::vector<fuse_core::UUID> SortedRemoved(
+    const fuse_core::Transaction& transaction) {
+  auto removed = transaction.removedConstraints();
+  std::vector<fuse_core::UUID> uuids(removed.begin(), removed.end());
+  std::sort(uuids.begin(), uuids.end());
+  return uuids;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_iterations < 1) {
+    BEAM_ERROR("iterations must be at least 1");
+    return 1;
+  }
+
+  fuse_graphs::HashGraph graph;
+  {
+    std::ifstream file(FLAGS_graph_path, std::ios::binary);
+    fuse_core::BinaryInputArchive archive(file);
+    graph.deserialize(archive);
+  }
+
+  // find the variables to marginalize the same way the fixed lag smoother does
+  fuse_core::Transaction graph_transaction;
+  ros::Time newest_stamp(0);
+  for (const auto& variable : graph.getVariables()) {
+    graph_transaction.addVariable(variable.clone());
+    const auto stamped =
+        dynamic_cast<const fuse_variables::Stamped*>(&variable);
+    if (stamped) { newest_stamp = std::max(newest_stamp, stamped->stamp()); }
+  }
+  for (const auto& constraint : graph.getConstraints()) {
+    graph_transaction.addConstraint(constraint.clone());
+  }
+  fuse_optimizers::VariableStampIndex stamp_index;
+  stamp_index.addNewTransaction(graph_transaction);
+  std::vector<fuse_core::UUID> to_marginalize;
+  const ros::Duration lag(FLAGS_lag_duration);
+  const ros::Time lag_expiration =
+      newest_stamp.toSec() > lag.toSec() ? newest_stamp - lag : ros::Time(0);
+  stamp_index.query(lag_expiration, std::back_inserter(to_marginalize));
+  BEAM_INFO("Marginalizing {} variables older than {}s", to_marginalize.size(),
+            lag_expiration.toSec());
+  if (to_marginalize.empty()) { return 0; }
+
+  std::vector<double> serial_times;
+  fuse_core::Transaction serial;
+  for (int i = 0; i < FLAGS_iterations; i++) {
+    const ros::WallTime start = ros::WallTime::now();
+    serial = fuse_constraints::marginalizeVariables("benchmark", to_marginalize,
+                                                    graph);
+    serial_times.push_back((ros::WallTime::now() - start).toSec());
+  }
+
+  std::vector<double> parallel_times;
+  fuse_core::Transaction parallel;
+  bs_optimizers::MarginalizationTiming timing;
+  for (int i = 0; i < FLAGS_iterations; i++) {
+    parallel = bs_optimizers::MarginalizeVariablesParallel(
+        "benchmark", to_marginalize, graph, FLAGS_threads, &timing);
+    parallel_times.push_back(timing.total_s);
+  }
+
+  const Stats serial_stats = ComputeStats(serial_times);
+  const Stats parallel_stats = ComputeStats(parallel_times);
+  BEAM_INFO("serial:   mean {:.5f}s, min {:.5f}s, max {:.5f}s",
+            serial_stats.mean_s, serial_stats.min_s, serial_stats.max_s);
+  BEAM_INFO("parallel: mean {:.5f}s, min {:.5f}s, max {:.5f}s",
+            parallel_stats.mean_s, parallel_stats.min_s, parallel_stats.max_s);
+  BEAM_INFO("speedup (mean): {:.2f}x",
+            serial_stats.mean_s / parallel_stats.mean_s);
+  BEAM_INFO("last parallel run: {} constraints, ordering {:.5f}s, "
+            "linearization {:.5f}s, elimination {:.5f}s, {} levels, widest {}",
+            timing.num_constraints, timing.ordering_s, timing.linearization_s,
+            timing.elimination_s, timing.num_levels, timing.max_level_size);
+
+  if (SortedRemoved(serial) != SortedRemoved(parallel) ||
+      CountAdded(serial) != CountAdded(parallel)) {
+    BEAM_ERROR("serial and parallel marginalization results differ: removed "
+               "{} vs {} constraints, added {} vs {} marginals",
+               SortedRemoved(serial).size(), SortedRemoved(parallel).size(),
+               CountAdded(serial), CountAdded(parallel));
+    return 1;
+  }
+  BEAM_INFO("serial and parallel results match: {} marginal constraints",
+            CountAdded(parallel));
+  return 0;
+}
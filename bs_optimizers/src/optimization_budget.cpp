@@ -0,0 +1,81 @@
+#include <bs_optimizers/optimization_budget.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bs_optimizers {
+
+void OptimizationBudget::Configure(const Params& params,
+                                   const ros::Duration& optimization_period) {
+  params_ = params;
+  optimization_period_ = optimization_period;
+  Reset();
+}
+
+void OptimizationBudget::Reset() {
+  seconds_per_iteration_ = 0;
+  last_cycle_s_ = 0;
+  carry_over_ = false;
+  num_cycles_ = 0;
+  num_cycles_in_budget_ = 0;
+  num_carry_overs_ = 0;
+}
+
+void OptimizationBudget::StartCycle() {
+  cycle_start_ = ros::WallTime::now();
+}
+
+void OptimizationBudget::ApplyTo(ceres::Solver::Options& options) const {
+  if (!params_.enabled) { return; }
+
+  const double elapsed = (ros::WallTime::now() - cycle_start_).toSec();
+  const double solver_time =
+      std::max(params_.min_solver_time_s, BudgetSeconds() - elapsed);
+  options.max_solver_time_in_seconds =
+      std::min(options.max_solver_time_in_seconds, solver_time);
+
+  // we need at least one cycle to know how long an iteration takes
+  if (seconds_per_iteration_ <= 0) { return; }
+  const int iterations = static_cast<int>(
+      std::floor(options.max_solver_time_in_seconds / seconds_per_iteration_));
+  options.max_num_iterations = std::min(
+      options.max_num_iterations, std::max(params_.min_iterations, iterations));
+}
+
+void OptimizationBudget::EndCycle(const ceres::Solver::Summary& summary) {
+  last_cycle_s_ = (ros::WallTime::now() - cycle_start_).toSec();
+  num_cycles_++;
+  if (last_cycle_s_ <= BudgetSeconds()) { num_cycles_in_budget_++; }
+
+  // update running estimate of the iteration time
+  if (!summary.iterations.empty() && summary.minimizer_time_in_seconds > 0) {
+    const double iteration_s =
+        summary.minimizer_time_in_seconds / summary.iterations.size();
+    if (seconds_per_iteration_ <= 0) {
+      seconds_per_iteration_ = iteration_s;
+    } else {
+      seconds_per_iteration_ =
+          params_.iteration_time_smoothing * iteration_s +
+          (1 - params_.iteration_time_smoothing) * seconds_per_iteration_;
+    }
+  }
+
+  carry_over_ = params_.enabled && params_.carry_over_unconverged &&
+                summary.termination_type == ceres::NO_CONVERGENCE;
+  if (carry_over_) { num_carry_overs_++; }
+}
+
+bool OptimizationBudget::HasCarryOver() const {
+  return carry_over_;
+}
+
+double OptimizationBudget::BudgetSeconds() const {
+  return params_.budget_fraction * optimization_period_.toSec();
+}
+
+double OptimizationBudget::HitRate() const {
+  if (num_cycles_ == 0) { return 1; }
+  return static_cast<double>(num_cycles_in_budget_) / num_cycles_;
+}
+
+} // namespace bs_optimizers
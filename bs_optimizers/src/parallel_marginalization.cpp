@@ -0,0 +1,162 @@
+#include <bs_optimizers/parallel_marginalization.h>
+
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+
+#include <fuse_constraints/marginalize_variables.h>
+#include <fuse_constraints/uuid_ordering.h>
+#include <ros/time.h>
+
+#include <bs_common/task_scheduler.h>
+
+namespace bs_optimizers {
+
+namespace {
+
+/**
+ * @brief Runs func(i) for i in [0, n) on up to num_threads threads of the
+ * shared task scheduler, including the calling thread. Marginalization is part
+ * of the optimization cycle so it runs with real-time priority.
+ */
+template <typename Func>
+void ParallelFor(size_t n, int num_threads, Func func) {
+  bs_common::TaskScheduler::GetInstance().ParallelFor(
+      bs_common::TaskPriority::REALTIME, n, func, num_threads);
+}
+
+} // namespace
+
+fuse_core::Transaction MarginalizeVariablesParallel(
+    const std::string& source,
+    const std::vector<fuse_core::UUID>& marginalized_variables,
+    const fuse_core::Graph& graph, int num_threads,
+    MarginalizationTiming* timing) {
+  using LinearTerm = fuse_constraints::detail::LinearTerm;
+  const ros::WallTime start = ros::WallTime::now();
+  MarginalizationTiming stats;
+
+  fuse_core::Transaction transaction;
+  for (const auto& variable_uuid : marginalized_variables) {
+    transaction.removeVariable(variable_uuid);
+  }
+
+  const fuse_constraints::UuidOrdering elimination_order =
+      fuse_constraints::computeEliminationOrder(marginalized_variables, graph);
+  const size_t num_marginalized = marginalized_variables.size();
+  ros::WallTime step_start = ros::WallTime::now();
+  stats.ordering_s = (step_start - start).toSec();
+
+  // Assign each connected constraint to the first marginalized variable (in
+  // elimination order) it involves, same as the serial implementation
+  std::vector<const fuse_core::Constraint*> constraints;
+  std::vector<size_t> constraint_slots;
+  std::vector<std::set<unsigned int>> slot_variables(num_marginalized);
+  std::unordered_set<fuse_core::UUID, fuse_core::uuid::hash> used_constraints;
+  for (size_t i = 0; i < num_marginalized; ++i) {
+    for (const auto& constraint :
+         graph.getConnectedConstraints(elimination_order[i])) {
+      if (!used_constraints.insert(constraint.uuid()).second) { continue; }
+      transaction.removeConstraint(constraint.uuid());
+      constraints.push_back(&constraint);
+      constraint_slots.push_back(i);
+      for (const auto& variable_uuid : constraint.variables()) {
+        slot_variables[i].insert(elimination_order.at(variable_uuid));
+      }
+    }
+  }
+  stats.num_constraints = constraints.size();
+
+  // Linearize every constraint independently
+  std::vector<LinearTerm> linearized(constraints.size());
+  ParallelFor(constraints.size(), num_threads, [&](size_t c) {
+    linearized[c] = fuse_constraints::detail::linearize(
+        *constraints[c], graph, elimination_order);
+  });
+  std::vector<std::vector<size_t>> slot_constraints(num_marginalized);
+  for (size_t c = 0; c < constraints.size(); ++c) {
+    slot_constraints[constraint_slots[c]].push_back(c);
+  }
+  stats.linearization_s = (ros::WallTime::now() - step_start).toSec();
+  step_start = ros::WallTime::now();
+
+  // Build the elimination tree symbolically. The term produced by eliminating
+  // variable i involves every other variable of its slot, and is passed on to
+  // the slot of the lowest of them. Children always have lower indices than
+  // their parent, so a single pass in order is enough.
+  const size_t kNoParent = num_marginalized;
+  std::vector<size_t> parent(num_marginalized, kNoParent);
+  std::vector<std::vector<size_t>> children(num_marginalized);
+  std::vector<size_t> level(num_marginalized, 0);
+  std::vector<bool> produces_term(num_marginalized, false);
+  size_t num_levels = 0;
+  for (size_t i = 0; i < num_marginalized; ++i) {
+    if (slot_variables[i].empty()) { continue; }
+    for (const size_t child : children[i]) {
+      level[i] = std::max(level[i], level[child] + 1);
+    }
+    num_levels = std::max(num_levels, level[i] + 1);
+
+    slot_variables[i].erase(static_cast<unsigned int>(i));
+    if (slot_variables[i].empty()) { continue; }
+    produces_term[i] = true;
+    const size_t lowest = *slot_variables[i].begin();
+    if (lowest < num_marginalized) {
+      parent[i] = lowest;
+      children[lowest].push_back(i);
+      slot_variables[lowest].insert(slot_variables[i].begin(),
+                                    slot_variables[i].end());
+    }
+  }
+
+  std::vector<std::vector<size_t>> levels(num_levels);
+  for (size_t i = 0; i < num_marginalized; ++i) {
+    if (!slot_constraints[i].empty() || !children[i].empty()) {
+      levels[level[i]].push_back(i);
+    }
+  }
+  stats.num_levels = levels.size();
+
+  // Eliminate level by level. All variables in a level are independent
+  std::vector<LinearTerm> eliminated(num_marginalized);
+  for (const auto& nodes : levels) {
+    stats.max_level_size = std::max(stats.max_level_size, nodes.size());
+    ParallelFor(nodes.size(), num_threads, [&](size_t n) {
+      const size_t i = nodes[n];
+      std::vector<LinearTerm> terms;
+      terms.reserve(slot_constraints[i].size() + children[i].size());
+      for (const size_t c : slot_constraints[i]) {
+        terms.push_back(std::move(linearized[c]));
+      }
+      for (const size_t child : children[i]) {
+        terms.push_back(std::move(eliminated[child]));
+      }
+      eliminated[i] = fuse_constraints::detail::marginalizeNext(terms);
+    });
+  }
+
+  // Terms not passed on to another marginalized variable become marginal
+  // constraints on the remaining variables
+  std::vector<size_t> marginal_nodes;
+  for (size_t i = 0; i < num_marginalized; ++i) {
+    if (produces_term[i] && parent[i] == kNoParent &&
+        !eliminated[i].variables.empty()) {
+      marginal_nodes.push_back(i);
+    }
+  }
+  std::vector<fuse_core::Constraint::SharedPtr> marginals(
+      marginal_nodes.size());
+  ParallelFor(marginal_nodes.size(), num_threads, [&](size_t n) {
+    marginals[n] = fuse_constraints::detail::createMarginalConstraint(
+        source, eliminated[marginal_nodes[n]], graph, elimination_order);
+  });
+  for (const auto& marginal : marginals) { transaction.addConstraint(marginal); }
+  stats.num_marginals = marginals.size();
+  stats.elimination_s = (ros::WallTime::now() - step_start).toSec();
+  stats.total_s = (ros::WallTime::now() - start).toSec();
+
+  if (timing) { *timing = stats; }
+  return transaction;
+}
+
+} // namespace bs_optimizers
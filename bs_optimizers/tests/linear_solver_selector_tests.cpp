@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <fuse_constraints/absolute_constraint.h>
+#include <fuse_graphs/hash_graph.h>
+#include <fuse_variables/position_3d_stamped.h>
+
+#include <bs_optimizers/linear_solver_selector.h>
+
+using bs_optimizers::LinearSolverSelector;
+
+namespace {
+
+/**
+ * Selects between DENSE_QR and DENSE_NORMAL_CHOLESKY, which are valid in every
+ * ceres build and have the same structural cost, so their predictions only
+ * differ by the measured time per unit of cost
+ */
+class LinearSolverSelectorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    for (int i = 0; i < 5; i++) {
+      auto position =
+          fuse_variables::Position3DStamped::make_shared(ros::Time(100 + i));
+      graph_.addVariable(position);
+      graph_.addConstraint(
+          fuse_constraints::AbsolutePosition3DStampedConstraint::make_shared(
+              "test", *position, fuse_core::Vector3d::Zero(),
+              fuse_core::Matrix3d::Identity()));
+    }
+
+    params_.enabled = true;
+    params_.candidates = {"DENSE_QR", "DENSE_NORMAL_CHOLESKY"};
+    params_.cost_smoothing = 0.5;
+    params_.switch_margin = 0.1;
+    params_.exploration_period = 4;
+    params_.max_exploration_ratio = 1.5;
+    options_.linear_solver_type = ceres::DENSE_QR;
+  }
+
+  /** runs a cycle where each linear solve takes linear_solve_s */
+  ceres::LinearSolverType RunCycle(
+      LinearSolverSelector& selector,
+      const std::map<ceres::LinearSolverType, double>& linear_solve_s) {
+    ceres::Solver::Options options = options_;
+    selector.ApplyTo(graph_, options);
+    ceres::Solver::Summary summary;
+    summary.linear_solver_type_used = options.linear_solver_type;
+    summary.num_linear_solves = 10;
+    summary.linear_solver_time_in_seconds =
+        10 * linear_solve_s.at(options.linear_solver_type);
+    selector.EndCycle(summary);
+    return options.linear_solver_type;
+  }
+
+  fuse_graphs::HashGraph graph_;
+  LinearSolverSelector::Params params_;
+  ceres::Solver::Options options_;
+};
+
+} // namespace
+
+TEST_F(LinearSolverSelectorTest, Disabled) {
+  LinearSolverSelector selector;
+  params_.enabled = false;
+  selector.Configure(params_, options_);
+  EXPECT_FALSE(selector.Enabled());
+
+  ceres::Solver::Options options = options_;
+  options.linear_solver_type = ceres::SPARSE_SCHUR;
+  selector.ApplyTo(graph_, options);
+  EXPECT_EQ(options.linear_solver_type, ceres::SPARSE_SCHUR);
+}
+
+TEST_F(LinearSolverSelectorTest, Update) {
+  LinearSolverSelector selector;
+  selector.Configure(params_, options_);
+  const auto structure = selector.ComputeStructure(graph_);
+  EXPECT_EQ(structure.num_variables, 5u);
+  EXPECT_EQ(structure.num_constraints, 5u);
+  EXPECT_EQ(structure.dimension, 15u);
+  EXPECT_LT(selector.PredictSeconds(ceres::DENSE_QR, structure), 0);
+
+  // the first measurement is used as is, later ones are smoothed
+  const std::map<ceres::LinearSolverType, double> times{
+      {ceres::DENSE_QR, 0.002}, {ceres::DENSE_NORMAL_CHOLESKY, 0.001}};
+  EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_QR);
+  EXPECT_DOUBLE_EQ(selector.LastLinearSolveSeconds(), 0.002);
+  EXPECT_NEAR(selector.PredictSeconds(ceres::DENSE_QR, structure), 0.002,
+              1e-12);
+  RunCycle(selector, {{ceres::DENSE_QR, 0.004}});
+  EXPECT_NEAR(selector.PredictSeconds(ceres::DENSE_QR, structure), 0.003,
+              1e-12);
+  EXPECT_LT(selector.PredictSeconds(ceres::DENSE_NORMAL_CHOLESKY, structure),
+            0);
+}
+
+TEST_F(LinearSolverSelectorTest, UnmeasuredSolversAreExplored) {
+  LinearSolverSelector selector;
+  selector.Configure(params_, options_);
+
+  // the unmeasured solver is only used on the exploration cycle, never
+  // selected because it would be predicted to be faster
+  const std::map<ceres::LinearSolverType, double> times{
+      {ceres::DENSE_QR, 0.002}, {ceres::DENSE_NORMAL_CHOLESKY, 0.001}};
+  for (int i = 1; i < 4; i++) {
+    EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_QR);
+  }
+  EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_NORMAL_CHOLESKY);
+
+  // once measured, the faster solver is selected
+  EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_NORMAL_CHOLESKY);
+  EXPECT_EQ(selector.CurrentSolver(), ceres::DENSE_NORMAL_CHOLESKY);
+}
+
+TEST_F(LinearSolverSelectorTest, ExplorationRatio) {
+  LinearSolverSelector selector;
+  selector.Configure(params_, options_);
+
+  // DENSE_NORMAL_CHOLESKY is 3x slower, it is not explored again once
+  // measured
+  const std::map<ceres::LinearSolverType, double> times{
+      {ceres::DENSE_QR, 0.001}, {ceres::DENSE_NORMAL_CHOLESKY, 0.003}};
+  for (int i = 1; i < 4; i++) { RunCycle(selector, times); }
+  EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_NORMAL_CHOLESKY);
+  for (int i = 0; i < 12; i++) {
+    EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_QR);
+  }
+
+  // a solver predicted within the ratio is explored again
+  LinearSolverSelector close_selector;
+  close_selector.Configure(params_, options_);
+  const std::map<ceres::LinearSolverType, double> close_times{
+      {ceres::DENSE_QR, 0.001}, {ceres::DENSE_NORMAL_CHOLESKY, 0.0012}};
+  for (int i = 0; i < 4; i++) { RunCycle(close_selector, close_times); }
+  for (int i = 1; i < 4; i++) {
+    EXPECT_EQ(RunCycle(close_selector, close_times), ceres::DENSE_QR);
+  }
+  EXPECT_EQ(RunCycle(close_selector, close_times),
+            ceres::DENSE_NORMAL_CHOLESKY);
+}
+
+TEST_F(LinearSolverSelectorTest, DefaultNotACandidate) {
+  LinearSolverSelector selector;
+  params_.candidates = {"DENSE_NORMAL_CHOLESKY", "DENSE_QR"};
+  params_.exploration_period = 0;
+  options_.linear_solver_type = ceres::SPARSE_SCHUR;
+  selector.Configure(params_, options_);
+
+  // the first candidate is used, and without exploration the other is never
+  // tried
+  const std::map<ceres::LinearSolverType, double> times{
+      {ceres::DENSE_QR, 0.0001}, {ceres::DENSE_NORMAL_CHOLESKY, 0.001}};
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(RunCycle(selector, times), ceres::DENSE_NORMAL_CHOLESKY);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <bs_optimizers/optimization_budget.h>
+
+using bs_optimizers::OptimizationBudget;
+
+namespace {
+
+OptimizationBudget::Params EnabledParams() {
+  OptimizationBudget::Params params;
+  params.enabled = true;
+  params.budget_fraction = 0.5;
+  params.min_solver_time_s = 0.005;
+  params.min_iterations = 2;
+  params.iteration_time_smoothing = 0.5;
+  params.carry_over_unconverged = true;
+  return params;
+}
+
+ceres::Solver::Summary MakeSummary(int iterations, double minimizer_time_s,
+                                   ceres::TerminationType termination) {
+  ceres::Solver::Summary summary;
+  summary.iterations.resize(iterations);
+  summary.minimizer_time_in_seconds = minimizer_time_s;
+  summary.termination_type = termination;
+  return summary;
+}
+
+// runs a cycle which reports iterations of iteration_s each
+void RunCycle(OptimizationBudget& budget, double iteration_s,
+              ceres::TerminationType termination = ceres::CONVERGENCE) {
+  budget.StartCycle();
+  budget.EndCycle(MakeSummary(10, 10 * iteration_s, termination));
+}
+
+int PlannedIterations(const OptimizationBudget& budget) {
+  ceres::Solver::Options options;
+  options.max_solver_time_in_seconds = 1e6;
+  options.max_num_iterations = 100000;
+  budget.ApplyTo(options);
+  return options.max_num_iterations;
+}
+
+} // namespace
+
+TEST(OptimizationBudget, Disabled) {
+  OptimizationBudget budget;
+  OptimizationBudget::Params params = EnabledParams();
+  params.enabled = false;
+  budget.Configure(params, ros::Duration(0.1));
+
+  budget.StartCycle();
+  ceres::Solver::Options options;
+  options.max_solver_time_in_seconds = 10;
+  options.max_num_iterations = 100;
+  budget.ApplyTo(options);
+  EXPECT_EQ(options.max_solver_time_in_seconds, 10);
+  EXPECT_EQ(options.max_num_iterations, 100);
+
+  budget.EndCycle(MakeSummary(100, 1, ceres::NO_CONVERGENCE));
+  EXPECT_FALSE(budget.HasCarryOver());
+}
+
+TEST(OptimizationBudget, ClampsSolverTime) {
+  OptimizationBudget budget;
+  budget.Configure(EnabledParams(), ros::Duration(1));
+  EXPECT_DOUBLE_EQ(budget.BudgetSeconds(), 0.5);
+
+  budget.StartCycle();
+  ceres::Solver::Options options;
+  options.max_solver_time_in_seconds = 10;
+  options.max_num_iterations = 100;
+  budget.ApplyTo(options);
+  EXPECT_LE(options.max_solver_time_in_seconds, 0.5);
+  EXPECT_GT(options.max_solver_time_in_seconds, 0.4);
+  // no iteration time is known before the first cycle
+  EXPECT_EQ(options.max_num_iterations, 100);
+
+  // limits are never loosened
+  options.max_solver_time_in_seconds = 0.1;
+  budget.ApplyTo(options);
+  EXPECT_EQ(options.max_solver_time_in_seconds, 0.1);
+}
+
+TEST(OptimizationBudget, MinSolverTimeWhenOverBudget) {
+  OptimizationBudget budget;
+  budget.Configure(EnabledParams(), ros::Duration(0.02));
+
+  // the graph update already used up the 10ms budget
+  budget.StartCycle();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ceres::Solver::Options options;
+  budget.ApplyTo(options);
+  EXPECT_DOUBLE_EQ(options.max_solver_time_in_seconds, 0.005);
+
+  budget.EndCycle(MakeSummary(1, 0.001, ceres::CONVERGENCE));
+  EXPECT_DOUBLE_EQ(budget.HitRate(), 0);
+  EXPECT_GE(budget.LastCycleSeconds(), 0.02);
+
+  RunCycle(budget, 0.0001);
+  EXPECT_EQ(budget.NumCycles(), 2u);
+  EXPECT_DOUBLE_EQ(budget.HitRate(), 0.5);
+}
+
+TEST(OptimizationBudget, ClampsIterations) {
+  OptimizationBudget budget;
+  budget.Configure(EnabledParams(), ros::Duration(1));
+
+  // 10ms per iteration fits about 50 in the 0.5s budget
+  RunCycle(budget, 0.01);
+  budget.StartCycle();
+  const int iterations = PlannedIterations(budget);
+  EXPECT_LE(iterations, 50);
+  EXPECT_GE(iterations, 45);
+
+  // never more than the config allows
+  ceres::Solver::Options options;
+  options.max_num_iterations = 20;
+  budget.ApplyTo(options);
+  EXPECT_EQ(options.max_num_iterations, 20);
+
+  // never fewer than min_iterations, even if one iteration does not fit
+  RunCycle(budget, 10);
+  RunCycle(budget, 10);
+  RunCycle(budget, 10);
+  budget.StartCycle();
+  EXPECT_EQ(PlannedIterations(budget), 2);
+}
+
+TEST(OptimizationBudget, BackOffAndRecovery) {
+  OptimizationBudget budget;
+  budget.Configure(EnabledParams(), ros::Duration(1));
+
+  RunCycle(budget, 0.001);
+  budget.StartCycle();
+  const int fast_iterations = PlannedIterations(budget);
+
+  // iterations get slower, the planned iterations back off with smoothing
+  RunCycle(budget, 0.01);
+  budget.StartCycle();
+  const int slowed_iterations = PlannedIterations(budget);
+  EXPECT_LT(slowed_iterations, fast_iterations);
+  RunCycle(budget, 0.01);
+  budget.StartCycle();
+  const int slow_iterations = PlannedIterations(budget);
+  EXPECT_LT(slow_iterations, slowed_iterations);
+
+  // and recover once iterations are fast again
+  for (int i = 0; i < 20; i++) { RunCycle(budget, 0.001); }
+  budget.StartCycle();
+  const int recovered_iterations = PlannedIterations(budget);
+  EXPECT_GT(recovered_iterations, slow_iterations);
+  EXPECT_GE(recovered_iterations, 0.95 * fast_iterations);
+}
+
+TEST(OptimizationBudget, CarryOver) {
+  OptimizationBudget budget;
+  budget.Configure(EnabledParams(), ros::Duration(1));
+
+  RunCycle(budget, 0.001, ceres::NO_CONVERGENCE);
+  EXPECT_TRUE(budget.HasCarryOver());
+  EXPECT_EQ(budget.NumCarryOvers(), 1u);
+
+  RunCycle(budget, 0.001, ceres::CONVERGENCE);
+  EXPECT_FALSE(budget.HasCarryOver());
+  EXPECT_EQ(budget.NumCarryOvers(), 1u);
+
+  RunCycle(budget, 0.001, ceres::NO_CONVERGENCE);
+  budget.Reset();
+  EXPECT_FALSE(budget.HasCarryOver());
+  EXPECT_EQ(budget.NumCycles(), 0u);
+
+  OptimizationBudget::Params params = EnabledParams();
+  params.carry_over_unconverged = false;
+  budget.Configure(params, ros::Duration(1));
+  RunCycle(budget, 0.001, ceres::NO_CONVERGENCE);
+  EXPECT_FALSE(budget.HasCarryOver());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
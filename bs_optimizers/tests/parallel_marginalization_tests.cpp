@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <fuse_constraints/absolute_pose_3d_stamped_constraint.h>
+#include <fuse_constraints/marginal_constraint.h>
+#include <fuse_constraints/marginalize_variables.h>
+#include <fuse_constraints/relative_pose_3d_stamped_constraint.h>
+#include <fuse_graphs/hash_graph.h>
+#include <fuse_variables/orientation_3d_stamped.h>
+#include <fuse_variables/position_3d_stamped.h>
+
+#include <bs_optimizers/parallel_marginalization.h>
+
+namespace {
+
+struct Pose {
+  fuse_variables::Position3DStamped::SharedPtr p;
+  fuse_variables::Orientation3DStamped::SharedPtr o;
+};
+
+fuse_core::Vector7d Delta(const Pose& pose1, const Pose& pose2) {
+  const Eigen::Quaterniond q1(pose1.o->w(), pose1.o->x(), pose1.o->y(),
+                              pose1.o->z());
+  const Eigen::Quaterniond q2(pose2.o->w(), pose2.o->x(), pose2.o->y(),
+                              pose2.o->z());
+  const Eigen::Vector3d t =
+      q1.conjugate() * (Eigen::Vector3d(pose2.p->x(), pose2.p->y(),
+                                        pose2.p->z()) -
+                        Eigen::Vector3d(pose1.p->x(), pose1.p->y(),
+                                        pose1.p->z()));
+  const Eigen::Quaterniond q = q1.conjugate() * q2;
+  fuse_core::Vector7d delta;
+  // perturbed so that the graph is not at its minimum
+  delta << t.x() + 0.05, t.y() - 0.02, t.z(), q.w(), q.x(), q.y(), q.z();
+  return delta;
+}
+
+/**
+ * A chain of poses with odometry constraints, a prior on the first pose and
+ * loop closures, so that eliminating the first poses creates fill in
+ */
+class ParallelMarginalizationTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    for (int i = 0; i < 12; i++) {
+      const ros::Time stamp(100 + 0.1 * i);
+      Pose pose;
+      pose.p = fuse_variables::Position3DStamped::make_shared(stamp);
+      pose.p->x() = i;
+      pose.p->y() = 0.3 * i * i;
+      pose.p->z() = -0.1 * i;
+      pose.o = fuse_variables::Orientation3DStamped::make_shared(stamp);
+      const Eigen::Vector3d axis = Eigen::Vector3d(0.1, 0.2, 1).normalized();
+      const Eigen::Quaterniond q(Eigen::AngleAxisd(0.2 * i, axis));
+      pose.o->w() = q.w();
+      pose.o->x() = q.x();
+      pose.o->y() = q.y();
+      pose.o->z() = q.z();
+      graph_.addVariable(pose.p);
+      graph_.addVariable(pose.o);
+      poses_.push_back(pose);
+    }
+
+    fuse_core::Vector7d prior;
+    prior << 0, 0, 0, 1, 0, 0, 0;
+    graph_.addConstraint(
+        fuse_constraints::AbsolutePose3DStampedConstraint::make_shared(
+            "test", *poses_[0].p, *poses_[0].o, prior,
+            fuse_core::Matrix6d::Identity()));
+    auto add_relative = [this](size_t i, size_t j, double sigma) {
+      graph_.addConstraint(
+          fuse_constraints::RelativePose3DStampedConstraint::make_shared(
+              "test", *poses_[i].p, *poses_[i].o, *poses_[j].p, *poses_[j].o,
+              Delta(poses_[i], poses_[j]),
+              sigma * sigma * fuse_core::Matrix6d::Identity()));
+    };
+    for (size_t i = 1; i < poses_.size(); i++) { add_relative(i - 1, i, 0.1); }
+    add_relative(0, 5, 0.5);
+    add_relative(1, 7, 0.5);
+    add_relative(3, 6, 0.5);
+    add_relative(2, 9, 0.5);
+  }
+
+  std::vector<fuse_core::UUID> Marginalized(size_t num_poses) const {
+    std::vector<fuse_core::UUID> uuids;
+    for (size_t i = 0; i < num_poses; i++) {
+      uuids.push_back(poses_[i].p->uuid());
+      uuids.push_back(poses_[i].o->uuid());
+    }
+    return uuids;
+  }
+
+  fuse_graphs::HashGraph graph_;
+  std::vector<Pose> poses_;
+};
+
+struct Information {
+  Eigen::MatrixXd H; // A^T * A
+  Eigen::VectorXd g; // A^T * b
+};
+
+/**
+ * The marginals by sorted variable uuids, in information form so that the
+ * comparison does not depend on the row order or signs of the QR factors
+ */
+std::map<std::vector<fuse_core::UUID>, Information>
+    Marginals(const fuse_core::Transaction& transaction) {
+  std::map<std::vector<fuse_core::UUID>, Information> marginals;
+  for (const auto& constraint : transaction.addedConstraints()) {
+    const auto marginal =
+        dynamic_cast<const fuse_constraints::MarginalConstraint*>(&constraint);
+    EXPECT_TRUE(marginal);
+    if (!marginal) { continue; }
+
+    const auto& variables = marginal->variables();
+    std::vector<size_t> order(variables.size());
+    for (size_t i = 0; i < order.size(); i++) { order[i] = i; }
+    std::sort(order.begin(), order.end(), [&variables](size_t a, size_t b) {
+      return variables[a] < variables[b];
+    });
+
+    std::vector<fuse_core::UUID> uuids;
+    Eigen::Index cols = 0;
+    for (size_t i : order) {
+      uuids.push_back(variables[i]);
+      cols += marginal->A()[i].cols();
+    }
+    Eigen::MatrixXd A(marginal->b().size(), cols);
+    Eigen::Index col = 0;
+    for (size_t i : order) {
+      A.middleCols(col, marginal->A()[i].cols()) = marginal->A()[i];
+      col += marginal->A()[i].cols();
+    }
+    Information info;
+    info.H = A.transpose() * A;
+    info.g = A.transpose() * marginal->b();
+    marginals[uuids] = info;
+  }
+  return marginals;
+}
+
+std::vector<fuse_core::UUID>
+    SortedRemovedConstraints(const fuse_core::Transaction& transaction) {
+  auto removed = transaction.removedConstraints();
+  std::vector<fuse_core::UUID> uuids(removed.begin(), removed.end());
+  std::sort(uuids.begin(), uuids.end());
+  return uuids;
+}
+
+std::vector<fuse_core::UUID>
+    SortedRemovedVariables(const fuse_core::Transaction& transaction) {
+  auto removed = transaction.removedVariables();
+  std::vector<fuse_core::UUID> uuids(removed.begin(), removed.end());
+  std::sort(uuids.begin(), uuids.end());
+  return uuids;
+}
+
+} // namespace
+
+TEST_F(ParallelMarginalizationTest, MatchesSerial) {
+  for (size_t num_poses : {1, 3, 5}) {
+    const auto to_marginalize = Marginalized(num_poses);
+    const fuse_core::Transaction serial =
+        fuse_constraints::marginalizeVariables("test", to_marginalize, graph_);
+    const auto serial_marginals = Marginals(serial);
+    ASSERT_FALSE(serial_marginals.empty());
+
+    for (int num_threads : {1, 4}) {
+      bs_optimizers::MarginalizationTiming timing;
+      const fuse_core::Transaction parallel =
+          bs_optimizers::MarginalizeVariablesParallel(
+              "test", to_marginalize, graph_, num_threads, &timing);
+      EXPECT_EQ(SortedRemovedConstraints(parallel),
+                SortedRemovedConstraints(serial));
+      EXPECT_EQ(SortedRemovedVariables(parallel),
+                SortedRemovedVariables(serial));
+      EXPECT_EQ(timing.num_marginals, serial_marginals.size());
+
+      const auto parallel_marginals = Marginals(parallel);
+      ASSERT_EQ(parallel_marginals.size(), serial_marginals.size());
+      for (const auto& entry : serial_marginals) {
+        auto iter = parallel_marginals.find(entry.first);
+        ASSERT_TRUE(iter != parallel_marginals.end());
+        EXPECT_TRUE(iter->second.H.isApprox(entry.second.H, 1e-8))
+            << "num_poses " << num_poses << ", num_threads " << num_threads;
+        EXPECT_TRUE(iter->second.g.isApprox(entry.second.g, 1e-8))
+            << "num_poses " << num_poses << ", num_threads " << num_threads;
+      }
+    }
+  }
+}
+
+TEST_F(ParallelMarginalizationTest, NothingToMarginalize) {
+  const fuse_core::Transaction parallel =
+      bs_optimizers::MarginalizeVariablesParallel("test", {}, graph_, 4);
+  EXPECT_TRUE(parallel.empty());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
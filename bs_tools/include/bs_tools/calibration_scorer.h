@@ -0,0 +1,197 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <opencv2/core.hpp>
+#include <ros/time.h>
+
+#include <beam_calibration/CameraModel.h>
+#include <beam_utils/pointclouds.h>
+
+namespace bs_tools {
+
+/**
+ * @brief Scores the consistency of a camera-lidar extrinsic calibration from
+ * lidar scans and images, without any ROS graph.
+ *
+ * Each frame is scored by how well the depth discontinuities of the lidar
+ * scan project onto the edges of the image (Levinson and Thrun, Automatic
+ * Online Calibration of Cameras and Lasers, RSS 2013). The score of the
+ * calibrated extrinsics is compared to the score of small perturbations of
+ * it, one positive and one negative perturbation per degree of freedom. With
+ * a good calibration the calibrated extrinsics score highest in most frames,
+ * so the fraction of frames where this holds drops when the extrinsics drift.
+ * This fraction is computed over time windows, and windows where it falls
+ * below min_consistent_fraction are flagged.
+ */
+class CalibrationScorer {
+public:
+  struct Params {
+    /** weight of the edge at a pixel vs. the edges around it in the edge
+     * image */
+    double edge_alpha{0.33};
+
+    /** decay of the edge strength per pixel of distance in the edge image */
+    double edge_gamma{0.98};
+
+    /** minimum range difference between neighbouring points of a ring for
+     * the closer point to be a depth edge */
+    double min_depth_discontinuity_m{0.3};
+
+    /** minimum depth of points in the camera frame */
+    double min_depth_m{0.5};
+
+    /** frames with fewer depth edges projecting into the image are not
+     * scored */
+    int min_edge_points{50};
+
+    /** size of the perturbations of the extrinsics */
+    double rotation_step_deg{0.5};
+    double translation_step_m{0.02};
+
+    /** a perturbation only scores higher than the calibrated extrinsics if
+     * its score is larger by more than this fraction, so that near ties in
+     * directions the scene does not constrain are ignored */
+    double score_tolerance{0.005};
+
+    /** frames are grouped into windows of this duration */
+    double window_duration_s{30};
+
+    /** windows with fewer scored frames are not flagged */
+    int min_window_frames{5};
+
+    /** windows where the calibrated extrinsics score highest in less than
+     * this fraction of frames are flagged as drifted */
+    double min_consistent_fraction{0.5};
+
+    /** threads of the shared bs_common::TaskScheduler used to score frames,
+     * including the calling thread. If set to 0, all cores are used */
+    int num_threads{0};
+  };
+
+  struct Frame {
+    ros::Time stamp;
+    cv::Mat image;
+
+    /** deskewed scan in the lidar frame at the image stamp, the ring field is
+     * used to find the neighbours of each point */
+    pcl::PointCloud<PointXYZIRT> cloud;
+  };
+
+  struct EdgePoint {
+    Eigen::Vector3d point;
+    double weight;
+  };
+
+  struct FrameResult {
+    ros::Time stamp;
+
+    /** false if there were not enough depth edges in the image */
+    bool valid{false};
+    int num_edge_points{0};
+
+    /** score of the calibrated extrinsics, normalized by the total weight of
+     * the depth edges */
+    double score{0};
+
+    /** scores of the perturbed extrinsics, in the order +/- rotation about x,
+     * y, z then +/- translation along x, y, z of the camera frame */
+    std::vector<double> perturbed_scores;
+
+    /** true if no perturbation scores higher than the calibrated extrinsics,
+     * see Params::score_tolerance */
+    bool consistent{false};
+  };
+
+  struct WindowResult {
+    ros::Time start;
+    ros::Time end;
+    int num_frames{0};
+    double consistent_fraction{0};
+    double mean_score{0};
+
+    /** mean change of the score per step of each perturbation, in the order
+     * rotation about x, y, z then translation along x, y, z. Points towards
+     * the correction of the extrinsics */
+    Eigen::Matrix<double, 6, 1> mean_gradient{
+        Eigen::Matrix<double, 6, 1>::Zero()};
+    bool drift{false};
+  };
+
+  struct Summary {
+    std::vector<FrameResult> frames;
+    std::vector<WindowResult> windows;
+    int num_valid_frames{0};
+    double consistent_fraction{0};
+    bool drift{false};
+  };
+
+  /**
+   * @brief constructor
+   * @param params scoring params
+   * @param camera_model camera model of the images
+   * @param T_Camera_Lidar calibrated extrinsics to score
+   */
+  CalibrationScorer(const Params& params,
+                    const std::shared_ptr<beam_calibration::CameraModel>&
+                        camera_model,
+                    const Eigen::Matrix4d& T_Camera_Lidar);
+
+  /**
+   * @brief score frames in parallel
+   * @return results, in the same order as the frames
+   */
+  std::vector<FrameResult> ScoreFrames(const std::vector<Frame>& frames) const;
+
+  FrameResult ScoreFrame(const Frame& frame) const;
+
+  /**
+   * @brief group frame results into windows and flag drift
+   * @param frames frame results sorted by stamp
+   */
+  Summary Summarize(const std::vector<FrameResult>& frames) const;
+
+  /**
+   * @brief edge image of a grayscale or bgr image. Each pixel is the maximum
+   * absolute intensity difference to its neighbours, blended with the edges
+   * around it decayed by gamma^(|dx| + |dy|)
+   * @return CV_32F image with values in [0, 1]
+   */
+  static cv::Mat EdgeImage(const cv::Mat& image, double alpha, double gamma);
+
+  /**
+   * @brief find depth discontinuities along the rings of a scan. Each point
+   * that is closer than one of its neighbours by more than min_discontinuity_m
+   * is an edge, weighted by the square root of the range difference. The edge
+   * is placed at the range of the point, halfway to the ray of the neighbour
+   */
+  static std::vector<EdgePoint>
+      DepthEdges(const pcl::PointCloud<PointXYZIRT>& cloud,
+                 double min_discontinuity_m);
+
+  /**
+   * @brief score the alignment of depth edges with an edge image
+   * @return sum of the edge image at the projected points times their weight,
+   * over the total weight of the edges
+   */
+  double Score(const cv::Mat& edge_image, const std::vector<EdgePoint>& edges,
+               const Eigen::Matrix4d& T_Camera_Lidar) const;
+
+  /**
+   * @brief save a summary to a json file
+   */
+  static void SaveSummary(const Summary& summary, const std::string& path);
+
+private:
+  Params params_;
+  std::shared_ptr<beam_calibration::CameraModel> camera_model_;
+  Eigen::Matrix4d T_Camera_Lidar_;
+
+  /** calibrated extrinsics with each perturbation applied */
+  std::vector<Eigen::Matrix4d> T_Camera_Lidar_perturbed_;
+};
+
+} // namespace bs_tools
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <fuse_core/transaction.h>
+#include <ros/time.h>
+
+#include <beam_utils/pointclouds.h>
+
+#include <bs_models/lidar/lidar_odometry_front_end.h>
+#include <bs_models/lidar/scan_pose.h>
+
+namespace bs_tools {
+
+/**
+ * @brief Runs recorded scans through the front end of bs_models::LidarOdometry
+ * without ROS, and measures the latency of each stage.
+ *
+ * Each scan goes through bs_models::LidarOdometryFrontEnd, the same pipeline
+ * as LidarOdometry::process: conversion from the ROS message, input
+ * filtering, deskewing, ScanPose construction (including feature extraction)
+ * and registration against the registration map, with the registration
+ * profile tuner and the dynamic point filter if configured. Initial poses come
+ * from a pose lookup in place of the FrameInitializer, or from the last
+ * registered pose like LidarOdometry without a frame initializer. Transactions
+ * go to a stub graph which only counts them, and keeps each scan active for
+ * window_duration_s like the lag of the local mapper, so that memory use is
+ * representative. There are no graph updates, so scan poses are never
+ * corrected and scans are only deskewed on arrival.
+ *
+ * The registration map and extrinsics are the usual singletons, so the static
+ * extrinsics must be set (bs_common::ExtrinsicsLookupOnline::InitializeStatic)
+ * before this is created, and there must only be one instance per process.
+ */
+class LidarOdometryBenchmark {
+public:
+  struct Params {
+    /** full paths to the configs of LidarOdometry */
+    std::string registration_config;
+    std::string matcher_config;
+
+    /** full path to input filters config, with a "filters" array. If empty,
+     * or if it cannot be read, no filters are used */
+    std::string input_filters_config;
+
+    /** full paths to the optional configs of LidarOdometry, can be empty */
+    std::string registration_tuning_config;
+    std::string dynamic_point_filter_config;
+
+    bool organized_feature_extraction{false};
+    int range_image_columns{1024};
+    double lidar_information_weight{1};
+
+    /** deskew scans on arrival with the pose lookup, like LidarOdometry with
+     * redeskew_scans set */
+    bool redeskew_scans{false};
+    bs_models::ScanRedeskewer::Params redeskewer;
+
+    /** scans stay active in the stub graph for this long */
+    double window_duration_s{10};
+  };
+
+  /** stages, in the order they run for each scan. Scans are only timed in
+   * the "deskew" stage if redeskew_scans is set */
+  static const std::vector<std::string> kStages;
+
+  struct LatencyStats {
+    int count{0};
+    double mean_ms{0};
+    double p50_ms{0};
+    double p90_ms{0};
+    double p99_ms{0};
+    double max_ms{0};
+  };
+
+  struct Summary {
+    int num_scans{0};
+
+    /** scans without a transaction, i.e. failed registration or below the
+     * motion thresholds */
+    int num_skipped{0};
+    int num_transactions{0};
+    int num_variables{0};
+    int num_constraints{0};
+    double peak_memory_gb{0};
+
+    /** latencies by stage, plus the latency of the whole scan as "total" */
+    std::map<std::string, LatencyStats> stages;
+  };
+
+  /** gets T_World_Baselink at some time, returns false if not available */
+  using PoseLookup =
+      std::function<bool(const ros::Time&, Eigen::Matrix4d& T_World_Baselink)>;
+
+  /**
+   * @brief constructor
+   * @param params benchmark params
+   * @param T_Baselink_Lidar lidar extrinsics
+   * @param pose_lookup optional initial poses, also used to deskew the scans.
+   * If empty, or if it fails for a scan, the last registered pose is used
+   */
+  LidarOdometryBenchmark(const Params& params,
+                         const Eigen::Matrix4d& T_Baselink_Lidar,
+                         const PoseLookup& pose_lookup = PoseLookup());
+
+  /**
+   * @brief run a scan through all stages
+   * @param cloud raw scan in the lidar frame
+   * @param stamp scan stamp, must be increasing
+   * @return false if the scan was skipped
+   */
+  bool ProcessScan(const pcl::PointCloud<PointXYZIRT>& cloud,
+                   const ros::Time& stamp);
+
+  /** pose of the last registered scan */
+  const Eigen::Matrix4d& T_World_BaselinkLast() const {
+    return T_World_BaselinkLast_;
+  }
+
+  Summary GetSummary() const;
+
+  /**
+   * @brief latency stats of a set of samples, in ms. Percentiles use the
+   * nearest rank
+   */
+  static LatencyStats ComputeLatencyStats(std::vector<double> latencies_ms);
+
+  /**
+   * @brief peak resident memory of this process, in GB
+   */
+  static double PeakMemoryGb();
+
+  static void SaveSummary(const Summary& summary, const std::string& path);
+
+private:
+  /** add a transaction to the stub graph, and drop scans that have left the
+   * window */
+  void AddToStubGraph(const fuse_core::Transaction& transaction,
+                      const std::shared_ptr<bs_models::ScanPose>& scan_pose);
+
+  Params params_;
+  Eigen::Matrix4d T_Baselink_Lidar_;
+  PoseLookup pose_lookup_;
+
+  std::unique_ptr<bs_models::LidarOdometryFrontEnd> front_end_;
+
+  Eigen::Matrix4d T_World_BaselinkLast_{Eigen::Matrix4d::Identity()};
+  ros::Time last_stamp_{0};
+  uint32_t seq_{0};
+
+  /** scans in the stub graph window */
+  std::deque<std::shared_ptr<bs_models::ScanPose>> active_scans_;
+
+  std::map<std::string, std::vector<double>> latencies_ms_;
+  Summary summary_;
+};
+
+} // namespace bs_tools
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace bs_tools {
+
+/**
+ * @brief Runs the refinement steps of many global maps on a fixed number of
+ * worker slots, under a global memory cap.
+ *
+ * Each step of each map is a job, and the jobs of a map form a chain in the
+ * order of kSteps: a step only starts once the previous step of the same map
+ * has succeeded, and the remaining steps of a map are cancelled if one fails.
+ * Jobs of different maps are independent, so the idle slots left by one map's
+ * serial steps are filled with steps of other maps. When several jobs are
+ * ready, the one with the most steps left in its map goes first.
+ *
+ * Every job runs the global map refinement tool in its own process, with only
+ * the steps up to and including its own enabled. Steps that already ran are
+ * then restored from the checkpoints of that map (see
+ * GlobalMapRefinement::EnableCheckpoints). Separate processes are needed since
+ * the registration map and extrinsics used by the refinement are per process
+ * singletons.
+ *
+ * The memory needed by a job is estimated from the size of its map directory
+ * times memory_factor, and from the peak memory of the previous steps of the
+ * same map once they are done. A job only starts if the estimates of all
+ * running jobs plus its own fit under max_memory_gb, unless no other job is
+ * running.
+ */
+class RefinementScheduler {
+public:
+  /** refinement steps, in the order they are run by the refinement tool */
+  static const std::vector<std::string> kSteps;
+
+  struct Params {
+    /** full path to the global map refinement tool */
+    std::string refinement_binary;
+
+    /** refinement config passed to the tool, can be empty */
+    std::string refinement_config;
+
+    /** steps to run, must be in kSteps */
+    std::vector<std::string> steps;
+
+    /** maximum number of jobs running at once */
+    int max_jobs{1};
+
+    /** maximum sum of the memory estimates of running jobs. Set to 0 for no
+     * limit */
+    double max_memory_gb{0};
+
+    /** initial memory estimate of a job, as a multiple of the size of its map
+     * directory */
+    double memory_factor{3};
+  };
+
+  struct StepResult {
+    std::string step;
+
+    /** false if the step was cancelled since a previous step failed */
+    bool run{false};
+    int exit_code{-1};
+    double wall_time_s{0};
+    double peak_memory_gb{0};
+
+    /** time from the start of the scheduler to the start of this step */
+    double start_time_s{0};
+  };
+
+  struct MapResult {
+    std::string map_dir;
+    std::string output_dir;
+    std::vector<StepResult> steps;
+
+    /** sum of the wall time of all steps */
+    double wall_time_s{0};
+    bool success{false};
+  };
+
+  explicit RefinementScheduler(const Params& params);
+
+  /**
+   * @brief add a map to refine
+   * @param map_dir global map data directory
+   * @param output_dir output directory for this map. The checkpoints are
+   * saved to output_dir/checkpoints and the output of each step to
+   * output_dir/<step>, with the final results in the output of the last step
+   */
+  void AddMap(const std::string& map_dir, const std::string& output_dir);
+
+  /**
+   * @brief run all jobs, blocks until they are done
+   * @return results, in the order maps were added
+   */
+  std::vector<MapResult> Run();
+
+  /**
+   * @brief time from the start to the end of the last Run call
+   */
+  double TotalTime() const { return total_time_s_; }
+
+  /**
+   * @brief print a per map and per step timing table
+   */
+  static void PrintSummary(const std::vector<MapResult>& results);
+
+  /**
+   * @brief save the results to a json file
+   */
+  static void SaveSummary(const std::vector<MapResult>& results,
+                          double total_time_s, const std::string& path);
+
+private:
+  /**
+   * @brief run a step of a map in a child process and wait for it
+   * @return step result with exit code, time and peak memory
+   */
+  StepResult RunStep(size_t map, size_t step) const;
+
+  Params params_;
+  std::vector<MapResult> maps_;
+  std::vector<double> map_sizes_gb_;
+  double total_time_s_{0};
+};
+
+} // namespace bs_tools
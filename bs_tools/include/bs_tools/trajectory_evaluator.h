@@ -0,0 +1,137 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <bs_models/global_mapping/global_map.h>
+
+namespace bs_tools {
+
+/** poses in the world frame, by stamp in nanoseconds */
+using Trajectory = std::map<uint64_t, Eigen::Matrix4d>;
+
+/** total wall time of each stage of a run, in seconds */
+using StageTimes = std::map<std::string, double>;
+
+/**
+ * @brief Computes the error of estimated trajectories w.r.t. a ground truth
+ * trajectory of the same frame.
+ *
+ * Each estimated pose is matched to the ground truth interpolated at its
+ * stamp. The estimate is then aligned to the ground truth (Umeyama), and the
+ * absolute trajectory error (ATE) is the error of each aligned pose. The
+ * relative pose error (RPE) is the error of the motion between pairs of
+ * estimated poses that are some distance apart along the ground truth,
+ * normalized by that distance, which does not depend on the alignment.
+ */
+class TrajectoryEvaluator {
+public:
+  enum class Alignment { NONE, SE3, SIM3 };
+
+  struct Params {
+    Alignment alignment{Alignment::SE3};
+
+    /** estimated poses are only matched if the ground truth poses around them
+     * are at most this far apart */
+    double max_time_diff_s{0.5};
+
+    /** distances along the ground truth for the RPE */
+    std::vector<double> rpe_distances_m{10, 25, 50, 100};
+  };
+
+  struct ErrorStats {
+    int count{0};
+    double rmse{0};
+    double mean{0};
+    double median{0};
+    double std{0};
+    double max{0};
+  };
+
+  struct RelativeError {
+    double distance_m{0};
+
+    /** translation error over distance, in percent */
+    ErrorStats translation_pct;
+
+    /** rotation error over distance, in deg/m */
+    ErrorStats rotation_deg_per_m;
+  };
+
+  struct Errors {
+    /** estimated poses matched to the ground truth */
+    int num_poses{0};
+
+    /** length of the ground truth over the matched poses */
+    double length_m{0};
+
+    /** alignment of the estimate to the ground truth */
+    Eigen::Matrix4d T_GroundTruth_Estimate{Eigen::Matrix4d::Identity()};
+    double scale{1};
+
+    ErrorStats ate_translation_m;
+    ErrorStats ate_rotation_deg;
+    std::vector<RelativeError> rpe;
+  };
+
+  TrajectoryEvaluator(const Trajectory& ground_truth, const Params& params);
+
+  /**
+   * @brief compute the errors of an estimated trajectory
+   * @throw std::runtime_error if fewer than 3 poses match the ground truth
+   */
+  Errors Evaluate(const Trajectory& estimate) const;
+
+  /**
+   * @brief get the ground truth pose at some time, interpolated between the
+   * closest poses
+   * @return false if the time is outside of the ground truth, or the closest
+   * poses are more than max_time_diff_s apart
+   */
+  bool GetGroundTruth(uint64_t stamp, Eigen::Matrix4d& T_World_Frame) const;
+
+  /**
+   * @brief load a trajectory from a pose file (.json, .txt or .ply, see
+   * beam_mapping::Poses)
+   * @return false if the file could not be read
+   */
+  static bool LoadTrajectory(const std::string& path, Trajectory& trajectory);
+
+  /**
+   * @brief get the baselink trajectory of a global map, the same as
+   * GlobalMap::SaveTrajectoryFile
+   * @param use_initial set to true to get the trajectory from the local mapper,
+   * before global optimization
+   */
+  static Trajectory
+      GetGlobalMapTrajectory(bs_models::global_mapping::GlobalMap& global_map,
+                             bool use_initial = false);
+
+  /**
+   * @brief load stage times from a json file. Accepts an object of stage names
+   * to times in seconds or arrays of times, which are summed, or the summary of
+   * bs_tools::RefinementScheduler, in which case step times are summed over
+   * all maps
+   * @return false if the file could not be read
+   */
+  static bool LoadStageTimes(const std::string& path, StageTimes& times);
+
+  static ErrorStats ComputeStats(std::vector<double> errors);
+
+private:
+  /**
+   * @brief find the transform (and scale for SIM3) minimizing the squared
+   * distance between the aligned estimated positions and the ground truth
+   */
+  void Align(const std::vector<Eigen::Matrix4d>& estimate,
+             const std::vector<Eigen::Matrix4d>& ground_truth,
+             Errors& errors) const;
+
+  Trajectory ground_truth_;
+  Params params_;
+};
+
+} // namespace bs_tools
@@ -0,0 +1,310 @@
+#include <bs_tools/calibration_scorer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+#include <nlohmann/json.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <bs_common/task_scheduler.h>
+
+namespace bs_tools {
+
+namespace {
+
+/** number of perturbations of the extrinsics, +/- for each dof */
+const int kNumPerturbations{12};
+
+/**
+ * @brief max(value, previous value * gamma) along the rows of an image, in
+ * both directions
+ */
+void DecayRows(cv::Mat& image, float gamma) {
+  for (int r = 0; r < image.rows; r++) {
+    float* row = image.ptr<float>(r);
+    for (int c = 1; c < image.cols; c++) {
+      row[c] = std::max(row[c], row[c - 1] * gamma);
+    }
+    for (int c = image.cols - 2; c >= 0; c--) {
+      row[c] = std::max(row[c], row[c + 1] * gamma);
+    }
+  }
+}
+
+/**
+ * @brief bilinear interpolation of a CV_32F image, so that the score changes
+ * smoothly with the extrinsics instead of in steps of one pixel
+ */
+double Interpolate(const cv::Mat& image, const Eigen::Vector2d& pixel) {
+  const double u = std::clamp<double>(pixel[0], 0, image.cols - 1);
+  const double v = std::clamp<double>(pixel[1], 0, image.rows - 1);
+  const int c = std::min<int>(u, image.cols - 2);
+  const int r = std::min<int>(v, image.rows - 2);
+  const double du = u - c;
+  const double dv = v - r;
+  return (1 - dv) * ((1 - du) * image.at<float>(r, c) +
+                     du * image.at<float>(r, c + 1)) +
+         dv * ((1 - du) * image.at<float>(r + 1, c) +
+               du * image.at<float>(r + 1, c + 1));
+}
+
+} // namespace
+
+CalibrationScorer::CalibrationScorer(
+    const Params& params,
+    const std::shared_ptr<beam_calibration::CameraModel>& camera_model,
+    const Eigen::Matrix4d& T_Camera_Lidar)
+    : params_(params),
+      camera_model_(camera_model),
+      T_Camera_Lidar_(T_Camera_Lidar) {
+  const double rotation_step = params_.rotation_step_deg * M_PI / 180;
+  for (int i = 0; i < kNumPerturbations; i++) {
+    const int axis = (i / 2) % 3;
+    const double sign = i % 2 == 0 ? 1 : -1;
+    Eigen::Matrix4d T_Perturbed_Camera = Eigen::Matrix4d::Identity();
+    if (i < 6) {
+      T_Perturbed_Camera.block<3, 3>(0, 0) =
+          Eigen::AngleAxisd(sign * rotation_step, Eigen::Vector3d::Unit(axis))
+              .toRotationMatrix();
+    } else {
+      T_Perturbed_Camera(axis, 3) = sign * params_.translation_step_m;
+    }
+    T_Camera_Lidar_perturbed_.push_back(T_Perturbed_Camera * T_Camera_Lidar_);
+  }
+}
+
+std::vector<CalibrationScorer::FrameResult>
+    CalibrationScorer::ScoreFrames(const std::vector<Frame>& frames) const {
+  std::vector<FrameResult> results(frames.size());
+  bs_common::TaskScheduler::GetInstance().ParallelFor(
+      bs_common::TaskPriority::MAPPING, frames.size(),
+      [&](size_t i) { results[i] = ScoreFrame(frames[i]); },
+      params_.num_threads);
+  return results;
+}
+
+CalibrationScorer::FrameResult
+    CalibrationScorer::ScoreFrame(const Frame& frame) const {
+  FrameResult result;
+  result.stamp = frame.stamp;
+
+  // only keep the edges in view of the camera, so that the scores are not
+  // diluted by the rest of the scan
+  std::vector<EdgePoint> edges;
+  for (const auto& edge :
+       DepthEdges(frame.cloud, params_.min_depth_discontinuity_m)) {
+    const Eigen::Vector3d p_Camera =
+        T_Camera_Lidar_.block<3, 3>(0, 0) * edge.point +
+        T_Camera_Lidar_.block<3, 1>(0, 3);
+    if (p_Camera.z() < params_.min_depth_m) { continue; }
+    Eigen::Vector2d pixel;
+    bool in_image;
+    if (!camera_model_->ProjectPoint(p_Camera, pixel, in_image) ||
+        !in_image) {
+      continue;
+    }
+    edges.push_back(edge);
+  }
+  result.num_edge_points = edges.size();
+  if (result.num_edge_points < params_.min_edge_points) { return result; }
+
+  const cv::Mat edge_image =
+      EdgeImage(frame.image, params_.edge_alpha, params_.edge_gamma);
+  result.valid = true;
+  result.score = Score(edge_image, edges, T_Camera_Lidar_);
+  result.consistent = true;
+  for (const auto& T : T_Camera_Lidar_perturbed_) {
+    result.perturbed_scores.push_back(Score(edge_image, edges, T));
+    if (result.perturbed_scores.back() >
+        result.score * (1 + params_.score_tolerance)) {
+      result.consistent = false;
+    }
+  }
+  return result;
+}
+
+CalibrationScorer::Summary
+    CalibrationScorer::Summarize(const std::vector<FrameResult>& frames) const {
+  Summary summary;
+  summary.frames = frames;
+
+  int num_consistent = 0;
+  for (const auto& frame : frames) {
+    if (!frame.valid) { continue; }
+    if (summary.windows.empty() ||
+        (frame.stamp - summary.windows.back().start).toSec() >=
+            params_.window_duration_s) {
+      WindowResult window;
+      window.start = frame.stamp;
+      summary.windows.push_back(window);
+    }
+
+    // accumulate sums, normalized below
+    WindowResult& window = summary.windows.back();
+    window.end = frame.stamp;
+    window.num_frames++;
+    window.mean_score += frame.score;
+    if (frame.consistent) {
+      window.consistent_fraction++;
+      num_consistent++;
+    }
+    for (int i = 0; i < 6; i++) {
+      window.mean_gradient[i] +=
+          (frame.perturbed_scores[2 * i] - frame.perturbed_scores[2 * i + 1]) /
+          2;
+    }
+    summary.num_valid_frames++;
+  }
+
+  for (auto& window : summary.windows) {
+    window.mean_score /= window.num_frames;
+    window.consistent_fraction /= window.num_frames;
+    window.mean_gradient /= window.num_frames;
+    window.drift = window.num_frames >= params_.min_window_frames &&
+                   window.consistent_fraction < params_.min_consistent_fraction;
+    if (window.drift) { summary.drift = true; }
+  }
+  if (summary.num_valid_frames > 0) {
+    summary.consistent_fraction =
+        static_cast<double>(num_consistent) / summary.num_valid_frames;
+  }
+  return summary;
+}
+
+cv::Mat CalibrationScorer::EdgeImage(const cv::Mat& image, double alpha,
+                                     double gamma) {
+  cv::Mat gray;
+  if (image.channels() == 3) {
+    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+  } else {
+    gray = image;
+  }
+  gray.convertTo(gray, CV_32F, 1.0 / 255);
+
+  // max absolute difference to the 8 neighbours
+  cv::Mat edges = cv::Mat::zeros(gray.rows, gray.cols, CV_32F);
+  for (int r = 1; r < gray.rows - 1; r++) {
+    for (int c = 1; c < gray.cols - 1; c++) {
+      const float value = gray.at<float>(r, c);
+      float max_diff = 0;
+      for (int dr = -1; dr <= 1; dr++) {
+        for (int dc = -1; dc <= 1; dc++) {
+          max_diff = std::max(
+              max_diff, std::abs(gray.at<float>(r + dr, c + dc) - value));
+        }
+      }
+      edges.at<float>(r, c) = max_diff;
+    }
+  }
+
+  // spread the edges, decaying with the L1 distance. Rows then columns
+  cv::Mat spread = edges.clone();
+  DecayRows(spread, gamma);
+  spread = spread.t();
+  DecayRows(spread, gamma);
+  spread = spread.t();
+  return alpha * edges + (1 - alpha) * spread;
+}
+
+std::vector<CalibrationScorer::EdgePoint>
+    CalibrationScorer::DepthEdges(const pcl::PointCloud<PointXYZIRT>& cloud,
+                                  double min_discontinuity_m) {
+  // sort each ring by azimuth, in case the scan is not organized
+  std::map<uint16_t, std::vector<std::pair<double, Eigen::Vector3d>>> rings;
+  for (const auto& p : cloud) {
+    const Eigen::Vector3d point(p.x, p.y, p.z);
+    if (!point.allFinite() || point.norm() < 1e-3) { continue; }
+    rings[p.ring].emplace_back(std::atan2(p.y, p.x), point);
+  }
+
+  std::vector<EdgePoint> edges;
+  for (auto& [ring, points] : rings) {
+    std::sort(points.begin(), points.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 1; i + 1 < points.size(); i++) {
+      const Eigen::Vector3d& point = points[i].second;
+      const double range = point.norm();
+      const double diff_prev = points[i - 1].second.norm() - range;
+      const double diff_next = points[i + 1].second.norm() - range;
+      const double diff = std::max(diff_prev, diff_next);
+      if (diff < min_discontinuity_m) { continue; }
+
+      // the edge is somewhere between this ray and the ray of the far
+      // neighbour, use the middle to not bias the edges towards the
+      // foreground
+      const Eigen::Vector3d& neighbour =
+          diff_prev > diff_next ? points[i - 1].second : points[i + 1].second;
+      const Eigen::Vector3d edge =
+          range * (point / range + neighbour.normalized()).normalized();
+      edges.push_back(EdgePoint{edge, std::sqrt(diff)});
+    }
+  }
+  return edges;
+}
+
+double CalibrationScorer::Score(const cv::Mat& edge_image,
+                                const std::vector<EdgePoint>& edges,
+                                const Eigen::Matrix4d& T_Camera_Lidar) const {
+  double score = 0;
+  double total_weight = 0;
+  for (const auto& edge : edges) {
+    total_weight += edge.weight;
+    const Eigen::Vector3d p_Camera =
+        T_Camera_Lidar.block<3, 3>(0, 0) * edge.point +
+        T_Camera_Lidar.block<3, 1>(0, 3);
+    if (p_Camera.z() < params_.min_depth_m) { continue; }
+    Eigen::Vector2d pixel;
+    bool in_image;
+    if (!camera_model_->ProjectPoint(p_Camera, pixel, in_image) ||
+        !in_image) {
+      continue;
+    }
+    score += edge.weight * Interpolate(edge_image, pixel);
+  }
+  return total_weight > 0 ? score / total_weight : 0;
+}
+
+void CalibrationScorer::SaveSummary(const Summary& summary,
+                                    const std::string& path) {
+  nlohmann::json J;
+  J["num_frames"] = summary.frames.size();
+  J["num_valid_frames"] = summary.num_valid_frames;
+  J["consistent_fraction"] = summary.consistent_fraction;
+  J["drift"] = summary.drift;
+
+  std::vector<nlohmann::json> J_windows;
+  for (const auto& window : summary.windows) {
+    nlohmann::json J_window;
+    J_window["start"] = window.start.toSec();
+    J_window["end"] = window.end.toSec();
+    J_window["num_frames"] = window.num_frames;
+    J_window["consistent_fraction"] = window.consistent_fraction;
+    J_window["mean_score"] = window.mean_score;
+    J_window["mean_gradient"] = std::vector<double>(
+        window.mean_gradient.data(), window.mean_gradient.data() + 6);
+    J_window["drift"] = window.drift;
+    J_windows.push_back(J_window);
+  }
+  J["windows"] = J_windows;
+
+  std::vector<nlohmann::json> J_frames;
+  for (const auto& frame : summary.frames) {
+    nlohmann::json J_frame;
+    J_frame["stamp"] = frame.stamp.toSec();
+    J_frame["valid"] = frame.valid;
+    J_frame["num_edge_points"] = frame.num_edge_points;
+    J_frame["score"] = frame.score;
+    J_frame["perturbed_scores"] = frame.perturbed_scores;
+    J_frame["consistent"] = frame.consistent;
+    J_frames.push_back(J_frame);
+  }
+  J["frames"] = J_frames;
+
+  std::ofstream file(path);
+  file << std::setw(4) << J << std::endl;
+}
+
+} // namespace bs_tools
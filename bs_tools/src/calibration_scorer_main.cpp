@@ -0,0 +1,251 @@
+#include <queue>
+
+#include <gflags/gflags.h>
+#include <pcl/common/transforms.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <beam_calibration/CameraModel.h>
+#include <beam_cv/OpenCVConversions.h>
+#include <beam_utils/filesystem.h>
+#include <beam_utils/gflags.h>
+#include <beam_utils/log.h>
+#include <beam_utils/math.h>
+#include <beam_utils/pointclouds.h>
+
+#include <bs_common/extrinsics_lookup_online.h>
+#include <bs_models/frame_initializers/frame_initializer.h>
+#include <bs_models/lidar/scan_redeskewer.h>
+#include <bs_tools/calibration_scorer.h>
+
+// clang-format off
+/**
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_tools/bs_tools_calibration_scorer_main \
+ -bag_file ~/data/run1.bag \
+ -lidar_topic /lidar_h/velodyne_points \
+ -image_topic /F1/image \
+ -frame_initializer_config ~/results/run1/frame_initializer.json \
+ -intrinsics ~/calibrations/F1.json \
+ -extrinsics ~/calibrations/extrinsics.json \
+ -frame_ids ~/calibrations/frame_ids.json \
+ -output_path ~/results/run1
+*
+* Scores the camera-lidar extrinsics over a recorded bag, see
+* bs_tools::CalibrationScorer. This does not need a ROS master, so the frame
+* initializer must be of type POSEFILE (e.g. the poses of a previous slam run).
+* Results are saved to output_path/calibration_score.json. Returns 2 if drift
+* of the extrinsics was detected.
+*/
+// clang-format on
+
+DEFINE_string(bag_file, "", "Full path to bag file (Required).");
+DEFINE_validator(bag_file, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(lidar_topic, "", "Lidar topic, with per point times (Required).");
+DEFINE_string(image_topic, "", "Image topic (Required).");
+DEFINE_string(frame_initializer_config, "",
+              "Full path to frame initializer config used to deskew the "
+              "scans, must be of type POSEFILE (Required).");
+DEFINE_validator(frame_initializer_config,
+                 &beam::gflags::ValidateFileMustExist);
+DEFINE_string(intrinsics, "",
+              "Full path to camera intrinsics file (Required).");
+DEFINE_validator(intrinsics, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(extrinsics, "",
+              "Full path to extrinsics file to score (Required).");
+DEFINE_validator(extrinsics, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(frame_ids, "", "Full path to frame ids file (Required).");
+DEFINE_validator(frame_ids, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(output_path, "", "Full path to output directory (Required).");
+DEFINE_validator(output_path, &beam::gflags::ValidateDirMustExist);
+DEFINE_int32(frame_stride, 10, "Score every nth image.");
+DEFINE_int32(batch_size, 64,
+             "Number of frames loaded and scored in parallel at once.");
+DEFINE_int32(num_threads, 0,
+             "Threads used for scoring. If set to 0, all cores are used.");
+DEFINE_double(rotation_step_deg, 0.5,
+              "Size of the rotation perturbations of the extrinsics.");
+DEFINE_double(translation_step_m, 0.02,
+              "Size of the translation perturbations of the extrinsics.");
+DEFINE_double(window_duration_s, 30,
+              "Duration of the windows over which drift is checked.");
+DEFINE_double(min_consistent_fraction, 0.5,
+              "Windows where the extrinsics score higher than all "
+              "perturbations in less than this fraction of frames are flagged "
+              "as drifted.");
+
+namespace {
+
+struct ScanStamped {
+  pcl::PointCloud<PointXYZIRT> scan;
+  ros::Time start;
+  ros::Time end;
+  ros::Time stamp;
+};
+
+struct ImageStamped {
+  cv::Mat image;
+  ros::Time stamp;
+};
+
+/**
+ * @brief deskew a scan and express it in the lidar frame at the image time
+ */
+bool GetFrame(const ScanStamped& scan, const ImageStamped& image,
+              bs_models::FrameInitializer& frame_initializer,
+              const std::string& lidar_frame,
+              bs_tools::CalibrationScorer::Frame& frame) {
+  const bs_models::ScanRedeskewer::PoseLookup get_T_World_Lidar =
+      [&](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        return frame_initializer.GetPose(T_World_Lidar, time, lidar_frame);
+      };
+  pcl::PointCloud<PointXYZIRT> deskewed;
+  Eigen::Matrix4d T_World_LidarScan;
+  Eigen::Matrix4d T_World_LidarImage;
+  if (!bs_models::ScanRedeskewer::Deskew(scan.scan, scan.stamp,
+                                         get_T_World_Lidar, deskewed) ||
+      !get_T_World_Lidar(scan.stamp, T_World_LidarScan) ||
+      !get_T_World_Lidar(image.stamp, T_World_LidarImage)) {
+    return false;
+  }
+  const Eigen::Matrix4d T_LidarImage_LidarScan =
+      beam::InvertTransform(T_World_LidarImage) * T_World_LidarScan;
+  pcl::transformPointCloud(deskewed, frame.cloud,
+                           Eigen::Affine3d(T_LidarImage_LidarScan));
+  frame.image = image.image;
+  frame.stamp = image.stamp;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  ros::Time::init();
+
+  if (!bs_common::ExtrinsicsLookupOnline::InitializeStatic(
+          bs_common::ExtrinsicsLookupBase(FLAGS_frame_ids,
+                                          FLAGS_extrinsics))) {
+    return 1;
+  }
+  auto& extrinsics = bs_common::ExtrinsicsLookupOnline::GetInstance();
+  Eigen::Matrix4d T_Camera_Lidar;
+  if (!extrinsics.GetT_CAMERA_LIDAR(T_Camera_Lidar)) {
+    BEAM_ERROR("Cannot get camera to lidar extrinsics from: {}",
+               FLAGS_extrinsics);
+    return 1;
+  }
+  const std::string lidar_frame = extrinsics.GetLidarFrameId();
+  bs_models::FrameInitializer frame_initializer(
+      FLAGS_frame_initializer_config);
+
+  bs_tools::CalibrationScorer::Params params;
+  params.rotation_step_deg = FLAGS_rotation_step_deg;
+  params.translation_step_m = FLAGS_translation_step_m;
+  params.window_duration_s = FLAGS_window_duration_s;
+  params.min_consistent_fraction = FLAGS_min_consistent_fraction;
+  params.num_threads = FLAGS_num_threads;
+  bs_tools::CalibrationScorer scorer(
+      params, beam_calibration::CameraModel::Create(FLAGS_intrinsics),
+      T_Camera_Lidar);
+
+  BEAM_INFO("Opening bag: {}", FLAGS_bag_file);
+  rosbag::Bag bag;
+  try {
+    bag.open(FLAGS_bag_file, rosbag::bagmode::Read);
+  } catch (rosbag::BagException& ex) {
+    BEAM_ERROR("Bag exception: {}", ex.what());
+    return 1;
+  }
+  rosbag::View view(bag, rosbag::TopicQuery(std::vector<std::string>{
+                             FLAGS_lidar_topic, FLAGS_image_topic}));
+
+  // pair each image with the scan it falls in, same as the calibration viewer
+  std::queue<ScanStamped> scans;
+  std::queue<ImageStamped> images;
+  std::vector<bs_tools::CalibrationScorer::Frame> batch;
+  std::vector<bs_tools::CalibrationScorer::FrameResult> results;
+  int num_images = 0;
+  int num_skipped = 0;
+  for (const auto& msg : view) {
+    if (msg.getTopic() == FLAGS_image_topic) {
+      auto image_msg = msg.instantiate<sensor_msgs::Image>();
+      if (!image_msg || num_images++ % FLAGS_frame_stride != 0) { continue; }
+      ImageStamped image;
+      image.image = beam_cv::OpenCVConversions::RosImgToMat(*image_msg).clone();
+      image.stamp = image_msg->header.stamp;
+      images.push(image);
+    } else {
+      auto lidar_msg = msg.instantiate<sensor_msgs::PointCloud2>();
+      if (!lidar_msg) { continue; }
+      ScanStamped s;
+      beam::ROSToPCL(s.scan, *lidar_msg);
+      s.stamp = lidar_msg->header.stamp;
+      s.end = ros::Time(0);
+      s.start = ros::TIME_MAX;
+      for (const auto& p : s.scan) {
+        ros::Time pt = s.stamp + ros::Duration(p.time);
+        if (pt < s.start) { s.start = pt; }
+        if (pt > s.end) { s.end = pt; }
+      }
+      scans.push(s);
+    }
+
+    while (!images.empty() && !scans.empty()) {
+      const auto& image = images.front();
+      const auto& scan = scans.front();
+      if (scan.end < image.stamp) {
+        scans.pop();
+        continue;
+      } else if (scan.start > image.stamp) {
+        images.pop();
+        continue;
+      }
+      bs_tools::CalibrationScorer::Frame frame;
+      if (GetFrame(scan, image, frame_initializer, lidar_frame, frame)) {
+        batch.push_back(frame);
+      } else {
+        num_skipped++;
+      }
+      images.pop();
+    }
+
+    if (batch.size() >= static_cast<size_t>(FLAGS_batch_size)) {
+      const auto batch_results = scorer.ScoreFrames(batch);
+      results.insert(results.end(), batch_results.begin(),
+                     batch_results.end());
+      batch.clear();
+      BEAM_INFO("Scored {} frames", results.size());
+    }
+  }
+  const auto batch_results = scorer.ScoreFrames(batch);
+  results.insert(results.end(), batch_results.begin(), batch_results.end());
+  bag.close();
+
+  if (num_skipped > 0) {
+    BEAM_WARN("Skipped {} frames without poses from the frame initializer",
+              num_skipped);
+  }
+  const auto summary = scorer.Summarize(results);
+  BEAM_INFO("Scored {} frames, {} with enough depth edges. Consistent "
+            "fraction: {:.2f}",
+            summary.frames.size(), summary.num_valid_frames,
+            summary.consistent_fraction);
+  for (const auto& window : summary.windows) {
+    if (window.drift) {
+      BEAM_WARN("Possible extrinsics drift in [{:.1f}, {:.1f}]: consistent "
+                "fraction {:.2f} over {} frames",
+                window.start.toSec(), window.end.toSec(),
+                window.consistent_fraction, window.num_frames);
+    }
+  }
+
+  const std::string output_file =
+      beam::CombinePaths(FLAGS_output_path, "calibration_score.json");
+  BEAM_INFO("Saving results to: {}", output_file);
+  bs_tools::CalibrationScorer::SaveSummary(summary, output_file);
+  return summary.drift ? 2 : 0;
+}
@@ -0,0 +1,136 @@
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <gflags/gflags.h>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/gflags.h>
+#include <beam_utils/log.h>
+
+#include <bs_tools/refinement_scheduler.h>
+
+// clang-format off
+/**
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_tools/bs_tools_global_map_batch_refinement_main \
+ -map_list ~/results/nightly_maps.txt \
+ -output_path ~/results/nightly_refined \
+ -jobs 8 \
+ -max_memory_gb 48 \
+ -refinement_config ~/beam_slam/beam_slam_launch/config/global_map/global_map_refinement.json
+*
+* The map list is a text file with the full path to one global map data
+* directory per line. Each map is refined to output_path/<index>_<map name>,
+* see bs_tools::RefinementScheduler for how the steps are scheduled. Re-running
+* with the same output path resumes from the checkpoints of each map.
+*/
+// clang-format on
+
+DEFINE_string(map_list, "",
+              "Full path to a text file with one global map directory per "
+              "line (Required).");
+DEFINE_validator(map_list, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(output_path, "", "Full path to output directory (Required).");
+DEFINE_validator(output_path, &beam::gflags::ValidateDirMustExist);
+DEFINE_string(refinement_config, "",
+              "Full path to config file for the map refinement, passed to each "
+              "map refinement. If left empty, default parameters are used.");
+DEFINE_string(refinement_binary, "",
+              "Full path to the global map refinement tool. If left empty, "
+              "bs_tools_global_map_refinement_main next to this binary is "
+              "used.");
+DEFINE_bool(run_batch_optimizer, false,
+            "Set to true to run the batch optimization step.");
+DEFINE_bool(run_submap_refinement, true,
+            "Set to true to run the submap refinement step.");
+DEFINE_bool(run_submap_alignment, true,
+            "Set to true to run the submap alignment step.");
+DEFINE_bool(run_posegraph_optimization, true,
+            "Set to true to run the pose graph optimization step.");
+DEFINE_int32(jobs, 0,
+             "Maximum number of refinement steps running at once. If set to "
+             "0, the number of cores is used.");
+DEFINE_double(max_memory_gb, 0,
+              "Maximum total memory estimate of the running steps. Set to 0 "
+              "for no limit.");
+DEFINE_double(memory_factor, 3,
+              "Initial memory estimate of a step, as a multiple of the size of "
+              "its map directory. Once a step of a map is done, its peak "
+              "memory is used for the next steps of that map if larger.");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  bs_tools::RefinementScheduler::Params params;
+  params.refinement_binary = FLAGS_refinement_binary;
+  if (params.refinement_binary.empty()) {
+    params.refinement_binary =
+        (std::filesystem::read_symlink("/proc/self/exe").parent_path() /
+         "bs_tools_global_map_refinement_main")
+            .string();
+  }
+  if (!std::filesystem::exists(params.refinement_binary)) {
+    BEAM_ERROR("Global map refinement tool not found: {}",
+               params.refinement_binary);
+    return 1;
+  }
+  params.refinement_config = FLAGS_refinement_config;
+  if (FLAGS_run_batch_optimizer) {
+    params.steps.push_back("batch_optimization");
+  }
+  if (FLAGS_run_submap_refinement) {
+    params.steps.push_back("submap_refinement");
+  }
+  if (FLAGS_run_submap_alignment) {
+    params.steps.push_back("submap_alignment");
+  }
+  if (FLAGS_run_posegraph_optimization) {
+    params.steps.push_back("posegraph_optimization");
+  }
+  params.max_jobs = FLAGS_jobs > 0 ? FLAGS_jobs
+                                   : std::thread::hardware_concurrency();
+  params.max_memory_gb = FLAGS_max_memory_gb;
+  params.memory_factor = FLAGS_memory_factor;
+  bs_tools::RefinementScheduler scheduler(params);
+
+  // read map list, skipping empty lines
+  std::ifstream file(FLAGS_map_list);
+  std::string map_dir;
+  int num_maps = 0;
+  while (std::getline(file, map_dir)) {
+    if (map_dir.empty()) { continue; }
+    if (!std::filesystem::is_directory(map_dir)) {
+      BEAM_ERROR("Invalid global map directory: {}", map_dir);
+      return 1;
+    }
+    // the index keeps outputs unique if map directories share a name
+    std::filesystem::path map_path = std::filesystem::path(map_dir);
+    if (!map_path.has_filename()) { map_path = map_path.parent_path(); }
+    const std::string map_name = map_path.filename().string();
+    std::string output_dir = beam::CombinePaths(
+        FLAGS_output_path, std::to_string(num_maps++) + "_" + map_name);
+    scheduler.AddMap(map_dir, output_dir);
+  }
+  if (num_maps == 0) {
+    BEAM_ERROR("No maps in map list: {}", FLAGS_map_list);
+    return 1;
+  }
+
+  BEAM_INFO("Refining {} maps with up to {} jobs", num_maps, params.max_jobs);
+  const auto results = scheduler.Run();
+  bs_tools::RefinementScheduler::PrintSummary(results);
+  BEAM_INFO("Total time: {:.1f} s", scheduler.TotalTime());
+
+  std::string summary_path =
+      beam::CombinePaths(FLAGS_output_path, "batch_refinement_summary.json");
+  BEAM_INFO("Saving summary to: {}", summary_path);
+  bs_tools::RefinementScheduler::SaveSummary(results, scheduler.TotalTime(),
+                                             summary_path);
+
+  for (const auto& map : results) {
+    if (!map.success) { return 1; }
+  }
+  return 0;
+}
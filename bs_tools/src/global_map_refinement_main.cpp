@@ -1,8 +1,16 @@
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
 
 #include <gflags/gflags.h>
+#include <nlohmann/json.hpp>
 
 #include <beam_utils/gflags.h>
+#include <beam_utils/time.h>
+#include <bs_common/extrinsics_lookup_online.h>
 #include <bs_models/global_mapping/global_map_refinement.h>
 
 // clang-format off
@@ -14,10 +22,13 @@
  -output_path ~/results \
  -run_submap_refinement=true \
  -run_posegraph_optimization=true \ 
- -refinement_config ~/beam_slam/beam_slam_launch/config/global_map/global_map_refinement.json \ 
- -calibration_yaml ~/beam_slam/beam_slam_launch/config/calibration_params.yaml
+ -refinement_config ~/beam_slam/beam_slam_launch/config/global_map/global_map_refinement.json
 *
-* NOTE: YOU MUST ALSO PUBLISH YOUR EXTRINSIC CALIBRATIONS - USE: calibration_publisher.launch
+* NOTE: this does not need a ROS master. The extrinsics are static and loaded
+* from the frame_ids.json and extrinsics.json files in the global map directory
+*
+* The wall time of each stage is saved to timing.json in the results directory,
+* see bs_tools_trajectory_evaluation_main
 */
 // clang-format on
 
@@ -33,8 +44,6 @@ DEFINE_string(
     "global_map_refinement.json");
 DEFINE_string(output_path, "", "Full path to output directory. ");
 DEFINE_validator(output_path, &beam::gflags::ValidateDirMustExist);
-DEFINE_string(calibration_yaml, "", "Full path to calibration yaml. ");
-DEFINE_validator(calibration_yaml, &beam::gflags::ValidateFileMustExist);
 DEFINE_bool(run_batch_optimizer, true,
             "Set to true to run registration in batch with loop closures along "
             "the whole trajectory.");
@@ -47,6 +56,17 @@ DEFINE_bool(run_submap_alignment, true,
 DEFINE_bool(run_posegraph_optimization, true,
             "Set to true to run pose graph optimization after submap "
             "refinement to refine the relative pose of the submaps. ");
+DEFINE_bool(use_checkpoints, false,
+            "Set to true to save a checkpoint of the map after each step, and "
+            "skip steps whose inputs and params have not changed since the "
+            "last run. Each checkpoint is a full copy of the global map data, "
+            "so this is off by default.");
+DEFINE_string(checkpoint_dir, "",
+              "Full path to the checkpoint directory. If left empty, this will "
+              "use output_path/global_map_refinement_checkpoints.");
+DEFINE_bool(save_results, true,
+            "Set to false to skip saving the refined map and results once all "
+            "steps are done, e.g. when only running some of the steps.");
 
 // Global Variables
 bool RUN_BATCH = false;
@@ -54,6 +74,25 @@ bool RUN_REFINEMENT = false;
 bool RUN_ALIGNMENT = false;
 bool RUN_PGO = false;
 std::string SAVE_PATH;
+std::map<std::string, double> STAGE_TIMES;
+
+void SaveStageTimes() {
+  nlohmann::json J;
+  for (const auto& [stage, time] : STAGE_TIMES) { J[stage] = time; }
+  std::ofstream file(beam::CombinePaths(SAVE_PATH, "timing.json"));
+  file << std::setw(4) << J << std::endl;
+}
+
+/**
+ * @brief run a stage and record its wall time
+ */
+int RunTimed(const std::string& stage, const std::function<int()>& run) {
+  beam::HighResolutionTimer timer;
+  int result = run();
+  STAGE_TIMES[stage] = timer.elapsed();
+  BEAM_INFO("Stage {} took {:.2f}s", stage, STAGE_TIMES[stage]);
+  return result;
+}
 
 int RunBatchOptimizer(
     bs_models::global_mapping::GlobalMapRefinement& refinement,
@@ -131,12 +170,18 @@ int RunPGO(bs_models::global_mapping::GlobalMapRefinement& refinement,
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  // setup ros and load calibration
-  int arg = 0;
-  ros::init(arg, NULL, "global_map_refinement");
-  std::string calibration_load_cmd = "rosparam load " + FLAGS_calibration_yaml;
-  BEAM_INFO("Running command: {}", calibration_load_cmd);
-  int result1 = system(calibration_load_cmd.c_str());
+  // load static extrinsics from file, this must be done before any of the
+  // refinement classes are created
+  ros::Time::init();
+  std::string frame_ids_path =
+      beam::CombinePaths(FLAGS_globalmap_dir, "frame_ids.json");
+  std::string extrinsics_path =
+      beam::CombinePaths(FLAGS_globalmap_dir, "extrinsics.json");
+  BEAM_INFO("Loading extrinsics from: {}", extrinsics_path);
+  if (!bs_common::ExtrinsicsLookupOnline::InitializeStatic(
+          bs_common::ExtrinsicsLookupBase(frame_ids_path, extrinsics_path))) {
+    return 1;
+  }
 
   // set global variables
   RUN_BATCH = FLAGS_run_batch_optimizer;
@@ -155,28 +200,64 @@ int main(int argc, char* argv[]) {
 
   // load global map and refinement
   BEAM_INFO("Loading global map data from: {}", FLAGS_globalmap_dir);
-  auto global_map = std::make_shared<bs_models::global_mapping::GlobalMap>(
-      FLAGS_globalmap_dir);
-  bs_models::global_mapping::GlobalMapRefinement refinement(
-      global_map, FLAGS_refinement_config);
+  std::shared_ptr<bs_models::global_mapping::GlobalMap> global_map;
+  std::unique_ptr<bs_models::global_mapping::GlobalMapRefinement> refinement;
+  RunTimed("load", [&]() {
+    global_map = std::make_shared<bs_models::global_mapping::GlobalMap>(
+        FLAGS_globalmap_dir);
+    refinement =
+        std::make_unique<bs_models::global_mapping::GlobalMapRefinement>(
+            global_map, FLAGS_refinement_config);
+    return 0;
+  });
+  if (FLAGS_use_checkpoints) {
+    std::string checkpoint_dir =
+        FLAGS_checkpoint_dir.empty()
+            ? beam::CombinePaths(FLAGS_output_path,
+                                 "global_map_refinement_checkpoints")
+            : FLAGS_checkpoint_dir;
+    BEAM_INFO("Using checkpoints in: {}", checkpoint_dir);
+    refinement->EnableCheckpoints(
+        checkpoint_dir,
+        bs_models::global_mapping::HashDirectory(FLAGS_globalmap_dir));
+  }
 
   // run refinement
-  if (RunBatchOptimizer(refinement, *global_map) != 0) { return 1; }
-  if (RunRefinement(refinement, *global_map) != 0) { return 1; }
-  if (RunAlignment(refinement, *global_map) != 0) { return 1; }
-  if (RunPGO(refinement, *global_map) != 0) { return 1; }
+  if (RunTimed("batch_optimization", [&]() {
+        return RunBatchOptimizer(*refinement, *global_map);
+      }) != 0 ||
+      RunTimed("submap_refinement", [&]() {
+        return RunRefinement(*refinement, *global_map);
+      }) != 0 ||
+      RunTimed("submap_alignment", [&]() {
+        return RunAlignment(*refinement, *global_map);
+      }) != 0 ||
+      RunTimed("posegraph_optimization", [&]() {
+        return RunPGO(*refinement, *global_map);
+      }) != 0) {
+    SaveStageTimes();
+    return 1;
+  }
   BEAM_INFO("Global map refinement completed successfully.");
+  if (!FLAGS_save_results) {
+    SaveStageTimes();
+    return 0;
+  }
 
-  // output results
-  BEAM_INFO("Outputting results to: {}", SAVE_PATH);
-  refinement.SaveResults(SAVE_PATH, true);
+  RunTimed("save", [&]() {
+    // output results
+    BEAM_INFO("Outputting results to: {}", SAVE_PATH);
+    refinement->SaveResults(SAVE_PATH, true);
 
-  // Save global map data
-  std::string global_map_data_path =
-      beam::CombinePaths(SAVE_PATH, "GlobalMapData");
-  std::filesystem::create_directory(global_map_data_path);
-  BEAM_INFO("Outputting global map data to: {}", global_map_data_path);
-  refinement.SaveGlobalMapData(global_map_data_path);
+    // Save global map data
+    std::string global_map_data_path =
+        beam::CombinePaths(SAVE_PATH, "GlobalMapData");
+    std::filesystem::create_directory(global_map_data_path);
+    BEAM_INFO("Outputting global map data to: {}", global_map_data_path);
+    refinement->SaveGlobalMapData(global_map_data_path);
+    return 0;
+  });
+  SaveStageTimes();
 
   return 0;
 }
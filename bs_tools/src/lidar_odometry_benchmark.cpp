@@ -0,0 +1,191 @@
+#include <bs_tools/lidar_odometry_benchmark.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <numeric>
+
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/log.h>
+#include <beam_utils/math.h>
+#include <beam_utils/time.h>
+
+#include <bs_common/extrinsics_lookup_online.h>
+
+namespace bs_tools {
+
+using namespace bs_models;
+
+// stages of LidarOdometryFrontEnd, then the stub graph
+const std::vector<std::string> LidarOdometryBenchmark::kStages{
+    "ros_to_pcl",   "filter", "deskew", "scan_pose",
+    "registration", "stub_graph"};
+
+LidarOdometryBenchmark::LidarOdometryBenchmark(
+    const Params& params, const Eigen::Matrix4d& T_Baselink_Lidar,
+    const PoseLookup& pose_lookup)
+    : params_(params),
+      T_Baselink_Lidar_(T_Baselink_Lidar),
+      pose_lookup_(pose_lookup) {
+  LidarOdometryFrontEnd::Params front_end_params;
+  front_end_params.registration_config = params_.registration_config;
+  front_end_params.matcher_config = params_.matcher_config;
+  front_end_params.input_filters_config = params_.input_filters_config;
+  front_end_params.registration_tuning_config =
+      params_.registration_tuning_config;
+  front_end_params.dynamic_point_filter_config =
+      params_.dynamic_point_filter_config;
+  front_end_params.organized_feature_extraction =
+      params_.organized_feature_extraction;
+  front_end_params.range_image_columns = params_.range_image_columns;
+  front_end_params.lidar_information_weight = params_.lidar_information_weight;
+  front_end_params.redeskew_scans = params_.redeskew_scans;
+  front_end_params.redeskewer = params_.redeskewer;
+  front_end_ = std::make_unique<LidarOdometryFrontEnd>(front_end_params);
+  front_end_->SetStageCallback(
+      [this](const std::string& stage, double latency_ms) {
+        latencies_ms_[stage].push_back(latency_ms);
+      });
+}
+
+bool LidarOdometryBenchmark::ProcessScan(
+    const pcl::PointCloud<PointXYZIRT>& cloud, const ros::Time& stamp) {
+  if (stamp <= last_stamp_) {
+    BEAM_WARN("Skipping non-monotonically increasing scan stamp: {}",
+              stamp.toSec());
+    return false;
+  }
+  summary_.num_scans++;
+  beam::HighResolutionTimer total_timer;
+
+  // the conversion to a message is not part of the front end, only the
+  // conversion back is timed
+  const sensor_msgs::PointCloud2 msg = beam::PCLToROS<PointXYZIRT>(
+      cloud, stamp, bs_common::ExtrinsicsLookupOnline::GetInstance()
+                        .GetLidarFrameId(),
+      seq_++);
+
+  Eigen::Matrix4d T_World_BaselinkInit = T_World_BaselinkLast_;
+  if (pose_lookup_) {
+    Eigen::Matrix4d T_World_Baselink;
+    if (pose_lookup_(stamp, T_World_Baselink)) {
+      T_World_BaselinkInit = T_World_Baselink;
+    }
+  }
+  const ScanRedeskewer::PoseLookup get_T_World_Lidar =
+      [this](const ros::Time& time, Eigen::Matrix4d& T_World_Lidar) {
+        Eigen::Matrix4d T_World_Baselink;
+        if (!pose_lookup_ || !pose_lookup_(time, T_World_Baselink)) {
+          return false;
+        }
+        T_World_Lidar = T_World_Baselink * T_Baselink_Lidar_;
+        return true;
+      };
+
+  const auto result = front_end_->ProcessScan(
+      msg, T_World_BaselinkInit, T_Baselink_Lidar_, get_T_World_Lidar);
+  last_stamp_ = stamp;
+  if (result.transaction == nullptr) {
+    summary_.num_skipped++;
+    latencies_ms_["total"].push_back(total_timer.elapsed() * 1e3);
+    return false;
+  }
+  T_World_BaselinkLast_ =
+      result.T_World_Lidar * beam::InvertTransform(T_Baselink_Lidar_);
+
+  beam::HighResolutionTimer stub_graph_timer;
+  AddToStubGraph(*result.transaction, result.scan_pose);
+  latencies_ms_["stub_graph"].push_back(stub_graph_timer.elapsed() * 1e3);
+  latencies_ms_["total"].push_back(total_timer.elapsed() * 1e3);
+  return true;
+}
+
+void LidarOdometryBenchmark::AddToStubGraph(
+    const fuse_core::Transaction& transaction,
+    const std::shared_ptr<ScanPose>& scan_pose) {
+  summary_.num_transactions++;
+  const auto variables = transaction.addedVariables();
+  const auto constraints = transaction.addedConstraints();
+  summary_.num_variables += std::distance(variables.begin(), variables.end());
+  summary_.num_constraints +=
+      std::distance(constraints.begin(), constraints.end());
+
+  active_scans_.push_back(scan_pose);
+  const ros::Time window_start =
+      scan_pose->Stamp() - ros::Duration(params_.window_duration_s);
+  while (!active_scans_.empty() &&
+         active_scans_.front()->Stamp() < window_start) {
+    front_end_->RemoveRawScan(active_scans_.front()->Stamp());
+    active_scans_.pop_front();
+  }
+}
+
+LidarOdometryBenchmark::Summary LidarOdometryBenchmark::GetSummary() const {
+  Summary summary = summary_;
+  summary.peak_memory_gb = PeakMemoryGb();
+  for (const auto& [stage, latencies] : latencies_ms_) {
+    summary.stages[stage] = ComputeLatencyStats(latencies);
+  }
+  return summary;
+}
+
+LidarOdometryBenchmark::LatencyStats
+    LidarOdometryBenchmark::ComputeLatencyStats(
+        std::vector<double> latencies_ms) {
+  LatencyStats stats;
+  stats.count = latencies_ms.size();
+  if (latencies_ms.empty()) { return stats; }
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const auto percentile = [&latencies_ms](double p) {
+    int rank = std::ceil(p * latencies_ms.size());
+    return latencies_ms[std::max(rank, 1) - 1];
+  };
+  stats.mean_ms =
+      std::accumulate(latencies_ms.begin(), latencies_ms.end(), 0.0) /
+      latencies_ms.size();
+  stats.p50_ms = percentile(0.5);
+  stats.p90_ms = percentile(0.9);
+  stats.p99_ms = percentile(0.99);
+  stats.max_ms = latencies_ms.back();
+  return stats;
+}
+
+double LidarOdometryBenchmark::PeakMemoryGb() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+  // ru_maxrss is in kilobytes on linux
+  return usage.ru_maxrss / (1024.0 * 1024.0);
+}
+
+void LidarOdometryBenchmark::SaveSummary(const Summary& summary,
+                                         const std::string& path) {
+  nlohmann::json J;
+  J["num_scans"] = summary.num_scans;
+  J["num_skipped"] = summary.num_skipped;
+  J["num_transactions"] = summary.num_transactions;
+  J["num_variables"] = summary.num_variables;
+  J["num_constraints"] = summary.num_constraints;
+  J["peak_memory_gb"] = summary.peak_memory_gb;
+  nlohmann::json J_stages;
+  for (const auto& [stage, stats] : summary.stages) {
+    nlohmann::json J_stage;
+    J_stage["count"] = stats.count;
+    J_stage["mean_ms"] = stats.mean_ms;
+    J_stage["p50_ms"] = stats.p50_ms;
+    J_stage["p90_ms"] = stats.p90_ms;
+    J_stage["p99_ms"] = stats.p99_ms;
+    J_stage["max_ms"] = stats.max_ms;
+    J_stages[stage] = J_stage;
+  }
+  J["stages"] = J_stages;
+  std::ofstream file(path);
+  file << std::setw(4) << J << std::endl;
+}
+
+} // namespace bs_tools
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include <gflags/gflags.h>
+#include <pcl/io/pcd_io.h>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/gflags.h>
+#include <beam_utils/log.h>
+
+#include <bs_common/extrinsics_lookup_online.h>
+#include <bs_models/frame_initializers/frame_initializer.h>
+#include <bs_tools/lidar_odometry_benchmark.h>
+
+// clang-format off
+/**
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_tools/bs_tools_lidar_odometry_benchmark_main \
+ -scans_dir ~/data/run1_scans \
+ -registration_config ~/beam_slam/beam_slam_launch/config/registration_config.json \
+ -matcher_config ~/beam_slam/beam_slam_launch/config/matchers/loam_vlp16.json \
+ -input_filters_config ~/beam_slam/beam_slam_launch/config/lidar_filters/vlp16_filters.json \
+ -extrinsics ~/calibrations/extrinsics.json \
+ -frame_ids ~/calibrations/frame_ids.json \
+ -output_file ~/results/lidar_odometry_benchmark.json
+*
+* Replays scans saved as .pcd (PointXYZIRT) or .bin (KITTI layout: x, y, z,
+* intensity as float32, without ring or time) through the lidar odometry front
+* end, and reports the latency of each stage and the peak memory, see
+* bs_tools::LidarOdometryBenchmark. This does not need a ROS master. Scans are
+* stamped from their file names in seconds (e.g. as saved by
+* ScanPose::SaveCloud), or every scan_period_s in file name order.
+*/
+// clang-format on
+
+DEFINE_string(scans_dir, "",
+              "Full path to directory of .pcd or .bin scans (Required).");
+DEFINE_validator(scans_dir, &beam::gflags::ValidateDirMustExist);
+DEFINE_string(registration_config, "",
+              "Full path to scan registration config (Required).");
+DEFINE_validator(registration_config, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(matcher_config, "", "Full path to matcher config (Required).");
+DEFINE_validator(matcher_config, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(input_filters_config, "",
+              "Full path to input filters config. If left empty, no filters "
+              "are used.");
+DEFINE_string(registration_tuning_config, "",
+              "Full path to registration profile tuning config. If left "
+              "empty or disabled, the matcher and registration configs are "
+              "used as is.");
+DEFINE_string(dynamic_point_filter_config, "",
+              "Full path to dynamic point filter config of the registration "
+              "map. If left empty, no points are removed from the map.");
+DEFINE_string(extrinsics, "", "Full path to extrinsics file (Required).");
+DEFINE_validator(extrinsics, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(frame_ids, "", "Full path to frame ids file (Required).");
+DEFINE_validator(frame_ids, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(frame_initializer_config, "",
+              "Full path to frame initializer config for the initial scan "
+              "poses, must be of type POSEFILE. If left empty, the last "
+              "registered pose is used.");
+DEFINE_bool(organized_feature_extraction, false,
+            "Set to true to extract loam features from a range image.");
+DEFINE_int32(range_image_columns, 1024,
+             "Range image columns for organized feature extraction.");
+DEFINE_double(lidar_information_weight, 1,
+              "Information weight of the registration constraints.");
+DEFINE_bool(redeskew_scans, false,
+            "Set to true to deskew the scans on arrival with the frame "
+            "initializer, like lidar odometry with redeskew_scans set.");
+DEFINE_double(window_duration_s, 10,
+              "Duration scans are kept active, i.e. the lag of the local "
+              "mapper.");
+DEFINE_bool(use_filename_stamps, true,
+            "Set to true to read the scan stamps from the file names, in "
+            "seconds. Otherwise scans are stamped every scan_period_s.");
+DEFINE_double(scan_period_s, 0.1,
+              "Time between scans if not using the file name stamps.");
+DEFINE_int32(max_scans, 0,
+             "Maximum number of scans to replay. If set to 0, all scans are "
+             "replayed.");
+DEFINE_string(output_file, "",
+              "Full path to output summary json. If left empty, the summary "
+              "is only printed.");
+
+namespace {
+
+struct ScanFile {
+  std::string path;
+  ros::Time stamp;
+};
+
+std::vector<ScanFile> GetScanFiles() {
+  std::vector<std::string> paths;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(FLAGS_scans_dir)) {
+    const std::string extension = entry.path().extension().string();
+    if (extension == ".pcd" || extension == ".bin") {
+      paths.push_back(entry.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+
+  std::vector<ScanFile> files;
+  for (size_t i = 0; i < paths.size(); i++) {
+    ScanFile file;
+    file.path = paths[i];
+    if (FLAGS_use_filename_stamps) {
+      const std::string stem = std::filesystem::path(paths[i]).stem().string();
+      try {
+        file.stamp = ros::Time(std::stod(stem));
+      } catch (const std::exception&) {
+        BEAM_ERROR("Cannot read stamp from scan file name: {}", paths[i]);
+        throw std::invalid_argument{"invalid scan file name"};
+      }
+    } else {
+      file.stamp = ros::Time(1) + ros::Duration(i * FLAGS_scan_period_s);
+    }
+    files.push_back(file);
+  }
+  std::sort(files.begin(), files.end(),
+            [](const ScanFile& a, const ScanFile& b) {
+              return a.stamp < b.stamp;
+            });
+  return files;
+}
+
+bool LoadScan(const std::string& path, pcl::PointCloud<PointXYZIRT>& cloud) {
+  cloud.clear();
+  if (std::filesystem::path(path).extension() == ".pcd") {
+    return pcl::io::loadPCDFile<PointXYZIRT>(path, cloud) == 0;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.good()) { return false; }
+  float values[4];
+  while (file.read(reinterpret_cast<char*>(values), sizeof(values))) {
+    PointXYZIRT p;
+    p.x = values[0];
+    p.y = values[1];
+    p.z = values[2];
+    p.intensity = values[3];
+    p.ring = 0;
+    p.time = 0;
+    cloud.push_back(p);
+  }
+  return true;
+}
+
+void PrintSummary(const bs_tools::LidarOdometryBenchmark::Summary& summary) {
+  BEAM_INFO("Replayed {} scans, {} skipped. {} transactions with {} variables "
+            "and {} constraints",
+            summary.num_scans, summary.num_skipped, summary.num_transactions,
+            summary.num_variables, summary.num_constraints);
+  BEAM_INFO("{:<14} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9}", "stage [ms]",
+            "count", "mean", "p50", "p90", "p99", "max");
+  std::vector<std::string> stages = bs_tools::LidarOdometryBenchmark::kStages;
+  stages.push_back("total");
+  for (const auto& stage : stages) {
+    auto iter = summary.stages.find(stage);
+    if (iter == summary.stages.end()) { continue; }
+    const auto& stats = iter->second;
+    BEAM_INFO("{:<14} {:>7} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f}",
+              stage, stats.count, stats.mean_ms, stats.p50_ms, stats.p90_ms,
+              stats.p99_ms, stats.max_ms);
+  }
+  BEAM_INFO("Peak memory: {:.3f} GB", summary.peak_memory_gb);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  ros::Time::init();
+
+  if (!bs_common::ExtrinsicsLookupOnline::InitializeStatic(
+          bs_common::ExtrinsicsLookupBase(FLAGS_frame_ids,
+                                          FLAGS_extrinsics))) {
+    return 1;
+  }
+  auto& extrinsics = bs_common::ExtrinsicsLookupOnline::GetInstance();
+  Eigen::Matrix4d T_Baselink_Lidar;
+  if (!extrinsics.GetT_BASELINK_LIDAR(T_Baselink_Lidar)) {
+    BEAM_ERROR("Cannot get baselink to lidar extrinsics from: {}",
+               FLAGS_extrinsics);
+    return 1;
+  }
+
+  bs_tools::LidarOdometryBenchmark::PoseLookup pose_lookup;
+  std::shared_ptr<bs_models::FrameInitializer> frame_initializer;
+  if (!FLAGS_frame_initializer_config.empty()) {
+    frame_initializer = std::make_shared<bs_models::FrameInitializer>(
+        FLAGS_frame_initializer_config);
+    const std::string baselink_frame = extrinsics.GetBaselinkFrameId();
+    pose_lookup = [frame_initializer, baselink_frame](
+                      const ros::Time& time,
+                      Eigen::Matrix4d& T_World_Baselink) {
+      return frame_initializer->GetPose(T_World_Baselink, time,
+                                        baselink_frame);
+    };
+  }
+
+  bs_tools::LidarOdometryBenchmark::Params params;
+  params.registration_config = FLAGS_registration_config;
+  params.matcher_config = FLAGS_matcher_config;
+  params.input_filters_config = FLAGS_input_filters_config;
+  params.registration_tuning_config = FLAGS_registration_tuning_config;
+  params.dynamic_point_filter_config = FLAGS_dynamic_point_filter_config;
+  params.organized_feature_extraction = FLAGS_organized_feature_extraction;
+  params.range_image_columns = FLAGS_range_image_columns;
+  params.lidar_information_weight = FLAGS_lidar_information_weight;
+  params.redeskew_scans = FLAGS_redeskew_scans;
+  params.window_duration_s = FLAGS_window_duration_s;
+  bs_tools::LidarOdometryBenchmark benchmark(params, T_Baselink_Lidar,
+                                             pose_lookup);
+
+  const auto files = GetScanFiles();
+  BEAM_INFO("Replaying {} scans from: {}", files.size(), FLAGS_scans_dir);
+  pcl::PointCloud<PointXYZIRT> cloud;
+  int num_replayed = 0;
+  for (const auto& file : files) {
+    if (FLAGS_max_scans > 0 && num_replayed >= FLAGS_max_scans) { break; }
+    if (!LoadScan(file.path, cloud)) {
+      BEAM_WARN("Cannot load scan: {}", file.path);
+      continue;
+    }
+    benchmark.ProcessScan(cloud, file.stamp);
+    if (++num_replayed % 100 == 0) {
+      BEAM_INFO("Replayed {} scans", num_replayed);
+    }
+  }
+
+  const auto summary = benchmark.GetSummary();
+  PrintSummary(summary);
+  if (!FLAGS_output_file.empty()) {
+    BEAM_INFO("Saving summary to: {}", FLAGS_output_file);
+    bs_tools::LidarOdometryBenchmark::SaveSummary(summary, FLAGS_output_file);
+  }
+  return 0;
+}
@@ -0,0 +1,296 @@
+#include <bs_tools/refinement_scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+extern char** environ;
+
+namespace bs_tools {
+
+namespace {
+
+/** flags of the refinement tool enabling each step in kSteps */
+const std::vector<std::string> kStepFlags{
+    "run_batch_optimizer", "run_submap_refinement", "run_submap_alignment",
+    "run_posegraph_optimization"};
+
+double SecondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+double DirectorySizeGb(const std::string& directory) {
+  uintmax_t size = 0;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator(directory)) {
+    if (entry.is_regular_file()) { size += entry.file_size(); }
+  }
+  return size / (1024.0 * 1024.0 * 1024.0);
+}
+
+} // namespace
+
+const std::vector<std::string> RefinementScheduler::kSteps{
+    "batch_optimization", "submap_refinement", "submap_alignment",
+    "posegraph_optimization"};
+
+RefinementScheduler::RefinementScheduler(const Params& params)
+    : params_(params) {
+  for (const auto& step : params_.steps) {
+    if (std::find(kSteps.begin(), kSteps.end(), step) == kSteps.end()) {
+      BEAM_ERROR("Invalid refinement step: {}", step);
+      throw std::invalid_argument{"invalid refinement step"};
+    }
+  }
+
+  // steps always run in the order of kSteps
+  std::vector<std::string> steps;
+  for (const auto& step : kSteps) {
+    if (std::find(params_.steps.begin(), params_.steps.end(), step) !=
+        params_.steps.end()) {
+      steps.push_back(step);
+    }
+  }
+  params_.steps = steps;
+  params_.max_jobs = std::max(params_.max_jobs, 1);
+}
+
+void RefinementScheduler::AddMap(const std::string& map_dir,
+                                 const std::string& output_dir) {
+  MapResult map;
+  map.map_dir = map_dir;
+  map.output_dir = output_dir;
+  maps_.push_back(map);
+  map_sizes_gb_.push_back(DirectorySizeGb(map_dir));
+}
+
+std::vector<RefinementScheduler::MapResult> RefinementScheduler::Run() {
+  struct MapState {
+    size_t next_step{0};
+    bool running{false};
+    bool done{false};
+    double memory_gb{0};
+  };
+  std::vector<MapState> states(maps_.size());
+  for (size_t m = 0; m < maps_.size(); m++) {
+    maps_[m].steps.clear();
+    maps_[m].wall_time_s = 0;
+    maps_[m].success = false;
+    states[m].memory_gb = map_sizes_gb_[m] * params_.memory_factor;
+    states[m].done = params_.steps.empty();
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  int running = 0;
+  double reserved_gb = 0;
+  std::vector<std::thread> threads;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lk(mutex);
+  while (true) {
+    // pick the ready job with the most steps left in its map
+    int next = -1;
+    for (size_t m = 0; m < maps_.size(); m++) {
+      if (states[m].running || states[m].done) { continue; }
+      if (next < 0 || states[m].next_step < states[next].next_step) {
+        next = m;
+      }
+    }
+    if (next < 0 && running == 0) { break; }
+
+    bool can_start = next >= 0 && running < params_.max_jobs;
+    if (can_start && params_.max_memory_gb > 0 && running > 0) {
+      can_start =
+          reserved_gb + states[next].memory_gb <= params_.max_memory_gb;
+    }
+    if (!can_start) {
+      cv.wait(lk);
+      continue;
+    }
+
+    MapState& state = states[next];
+    state.running = true;
+    running++;
+    reserved_gb += state.memory_gb;
+    BEAM_INFO("Starting {} for map: {} (memory estimate: {:.2f} GB)",
+              params_.steps[state.next_step], maps_[next].map_dir,
+              state.memory_gb);
+
+    const size_t m = next;
+    const size_t step = state.next_step;
+    const double memory_gb = state.memory_gb;
+    threads.emplace_back([&, m, step, memory_gb]() {
+      const double start_time_s = SecondsSince(start);
+      StepResult result = RunStep(m, step);
+      result.start_time_s = start_time_s;
+
+      std::lock_guard<std::mutex> guard(mutex);
+      MapResult& map = maps_[m];
+      MapState& state = states[m];
+      map.steps.push_back(result);
+      map.wall_time_s += result.wall_time_s;
+      running--;
+      reserved_gb -= memory_gb;
+      state.running = false;
+      state.memory_gb = std::max(state.memory_gb, result.peak_memory_gb);
+      state.next_step++;
+
+      if (result.exit_code != 0) {
+        BEAM_ERROR("{} failed for map: {}, see log in: {}", result.step,
+                   map.map_dir, map.output_dir);
+        for (size_t i = state.next_step; i < params_.steps.size(); i++) {
+          StepResult cancelled;
+          cancelled.step = params_.steps[i];
+          map.steps.push_back(cancelled);
+        }
+        state.done = true;
+      } else if (state.next_step == params_.steps.size()) {
+        map.success = true;
+        state.done = true;
+      }
+      cv.notify_all();
+    });
+  }
+  lk.unlock();
+
+  for (auto& thread : threads) { thread.join(); }
+  total_time_s_ = SecondsSince(start);
+  return maps_;
+}
+
+RefinementScheduler::StepResult
+    RefinementScheduler::RunStep(size_t m, size_t step) const {
+  const MapResult& map = maps_[m];
+  StepResult result;
+  result.step = params_.steps[step];
+  result.run = true;
+
+  const std::string output_path =
+      beam::CombinePaths(map.output_dir, result.step);
+  std::filesystem::create_directories(output_path);
+
+  // enable all steps up to this one, the previous steps are restored from
+  // their checkpoints
+  const bool last_step = step + 1 == params_.steps.size();
+  std::vector<std::string> args{
+      params_.refinement_binary,
+      "-globalmap_dir=" + map.map_dir,
+      "-output_path=" + output_path,
+      "-use_checkpoints=true",
+      "-checkpoint_dir=" + beam::CombinePaths(map.output_dir, "checkpoints"),
+      std::string("-save_results=") + (last_step ? "true" : "false")};
+  if (!params_.refinement_config.empty()) {
+    args.push_back("-refinement_config=" + params_.refinement_config);
+  }
+  for (size_t i = 0; i < kSteps.size(); i++) {
+    const auto it = std::find(params_.steps.begin(),
+                              params_.steps.begin() + step + 1, kSteps[i]);
+    const bool enabled = it != params_.steps.begin() + step + 1;
+    args.push_back("-" + kStepFlags[i] + "=" + (enabled ? "true" : "false"));
+  }
+  std::vector<char*> argv;
+  for (auto& arg : args) { argv.push_back(&arg[0]); }
+  argv.push_back(nullptr);
+
+  // the output of each step goes to a log file in its output path
+  const std::string log_path = beam::CombinePaths(output_path, "log.txt");
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log_path.c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+  const auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  int error = posix_spawn(&pid, params_.refinement_binary.c_str(), &actions,
+                          nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) {
+    BEAM_ERROR("Unable to start refinement tool {}: {}",
+               params_.refinement_binary, std::strerror(error));
+    return result;
+  }
+
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    BEAM_ERROR("Unable to wait for refinement tool: {}", std::strerror(errno));
+    return result;
+  }
+  result.wall_time_s = SecondsSince(start);
+  result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+  // ru_maxrss is in kilobytes on linux
+  result.peak_memory_gb = usage.ru_maxrss / (1024.0 * 1024.0);
+  return result;
+}
+
+void RefinementScheduler::PrintSummary(const std::vector<MapResult>& results) {
+  for (const auto& map : results) {
+    BEAM_INFO("Map: {} ({}, {:.1f} s)", map.map_dir,
+              map.success ? "success" : "failed", map.wall_time_s);
+    for (const auto& step : map.steps) {
+      if (!step.run) {
+        BEAM_INFO("  {:<24} cancelled", step.step);
+        continue;
+      }
+      BEAM_INFO("  {:<24} {:>9.1f} s {:>7.2f} GB  exit code: {}", step.step,
+                step.wall_time_s, step.peak_memory_gb, step.exit_code);
+    }
+  }
+}
+
+void RefinementScheduler::SaveSummary(const std::vector<MapResult>& results,
+                                      double total_time_s,
+                                      const std::string& path) {
+  nlohmann::json J;
+  J["total_time_s"] = total_time_s;
+  std::vector<nlohmann::json> J_maps;
+  for (const auto& map : results) {
+    nlohmann::json J_map;
+    J_map["map_dir"] = map.map_dir;
+    J_map["output_dir"] = map.output_dir;
+    J_map["success"] = map.success;
+    J_map["wall_time_s"] = map.wall_time_s;
+    std::vector<nlohmann::json> J_steps;
+    for (const auto& step : map.steps) {
+      nlohmann::json J_step;
+      J_step["step"] = step.step;
+      J_step["run"] = step.run;
+      J_step["exit_code"] = step.exit_code;
+      J_step["start_time_s"] = step.start_time_s;
+      J_step["wall_time_s"] = step.wall_time_s;
+      J_step["peak_memory_gb"] = step.peak_memory_gb;
+      J_steps.push_back(J_step);
+    }
+    J_map["steps"] = J_steps;
+    J_maps.push_back(J_map);
+  }
+  J["maps"] = J_maps;
+
+  std::ofstream file(path);
+  file << std::setw(4) << J << std::endl;
+}
+
+} // namespace bs_tools
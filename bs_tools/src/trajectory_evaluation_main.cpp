@@ -0,0 +1,318 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <gflags/gflags.h>
+#include <nlohmann/json.hpp>
+
+#include <beam_utils/filesystem.h>
+#include <beam_utils/gflags.h>
+#include <beam_utils/log.h>
+
+#include <bs_common/extrinsics_lookup_online.h>
+#include <bs_tools/trajectory_evaluator.h>
+
+// clang-format off
+/**
+ * Example command for running binary:
+ *
+ ./devel/lib/bs_tools/bs_tools_trajectory_evaluation_main \
+ -ground_truth ~/data/run1_ground_truth.txt \
+ -estimates ~/results/baseline/global_map_refined_results/GlobalMapData,~/results/new/global_map_refined_results/GlobalMapData \
+ -labels baseline,new \
+ -timings ~/results/baseline/global_map_refined_results/timing.json,~/results/new/global_map_refined_results/timing.json \
+ -output_file ~/results/new/evaluation.json \
+ -baseline_report ~/results/baseline/evaluation.json
+*
+* Computes the absolute and relative trajectory errors of each estimate w.r.t.
+* the ground truth, see bs_tools::TrajectoryEvaluator, and prints them along
+* with the wall time of each stage from the timing files (e.g. the timing.json
+* of bs_tools_global_map_refinement_main or the summary of
+* bs_tools_global_map_batch_refinement_main). Estimates are pose files or
+* GlobalMapData directories. The extrinsics of the first directory are used
+* for all directories.
+*
+* If a baseline report is given, each estimate is compared to the run with the
+* same label in it, and this returns 2 if the ATE or the total time increased
+* by more than the given fractions.
+*/
+// clang-format on
+
+DEFINE_string(ground_truth, "",
+              "Full path to ground truth pose file, see "
+              "beam_mapping::Poses (Required).");
+DEFINE_validator(ground_truth, &beam::gflags::ValidateFileMustExist);
+DEFINE_string(estimates, "",
+              "Comma separated list of estimated pose files or GlobalMapData "
+              "directories (Required).");
+DEFINE_string(labels, "",
+              "Comma separated list of labels of the estimates. If left empty, "
+              "the paths of the estimates are used.");
+DEFINE_string(timings, "",
+              "Comma separated list of timing files of the estimates, in the "
+              "same order. Leave an entry empty for estimates without timing.");
+DEFINE_bool(use_initial, false,
+            "Set to true to evaluate the initial trajectory of GlobalMapData "
+            "directories, from the local mapper.");
+DEFINE_string(alignment, "se3",
+              "Alignment of the estimates to the ground truth. Options: se3, "
+              "sim3, none.");
+DEFINE_double(max_time_diff_s, 0.5,
+              "Maximum time between the ground truth poses an estimated pose "
+              "is interpolated between.");
+DEFINE_string(rpe_distances_m, "10,25,50,100",
+              "Comma separated list of distances for the relative errors.");
+DEFINE_string(output_file, "",
+              "Full path to output report json. If left empty, the report is "
+              "only printed.");
+DEFINE_string(baseline_report, "",
+              "Full path to a report of a previous evaluation to check for "
+              "regressions against.");
+DEFINE_double(max_ate_increase, 0.1,
+              "Maximum increase of the ATE rmse over the baseline, as a "
+              "fraction of the baseline.");
+DEFINE_double(max_time_increase, 0.2,
+              "Maximum increase of the total time over the baseline, as a "
+              "fraction of the baseline.");
+
+namespace {
+
+std::vector<std::string> Split(const std::string& list) {
+  std::vector<std::string> items;
+  if (list.empty()) { return items; }
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) { items.push_back(item); }
+  if (list.back() == ',') { items.push_back(""); }
+  return items;
+}
+
+nlohmann::json ToJson(const bs_tools::TrajectoryEvaluator::ErrorStats& stats) {
+  nlohmann::json J;
+  J["count"] = stats.count;
+  J["rmse"] = stats.rmse;
+  J["mean"] = stats.mean;
+  J["median"] = stats.median;
+  J["std"] = stats.std;
+  J["max"] = stats.max;
+  return J;
+}
+
+struct Run {
+  std::string label;
+  std::string source;
+  bs_tools::TrajectoryEvaluator::Errors errors;
+  bs_tools::StageTimes times;
+  double total_time_s{0};
+};
+
+nlohmann::json ToJson(const Run& run) {
+  nlohmann::json J;
+  J["label"] = run.label;
+  J["source"] = run.source;
+  J["num_poses"] = run.errors.num_poses;
+  J["length_m"] = run.errors.length_m;
+  J["scale"] = run.errors.scale;
+  J["ate_translation_m"] = ToJson(run.errors.ate_translation_m);
+  J["ate_rotation_deg"] = ToJson(run.errors.ate_rotation_deg);
+  std::vector<nlohmann::json> J_rpe;
+  for (const auto& rpe : run.errors.rpe) {
+    nlohmann::json J_distance;
+    J_distance["distance_m"] = rpe.distance_m;
+    J_distance["translation_pct"] = ToJson(rpe.translation_pct);
+    J_distance["rotation_deg_per_m"] = ToJson(rpe.rotation_deg_per_m);
+    J_rpe.push_back(J_distance);
+  }
+  J["rpe"] = J_rpe;
+  J["stage_times_s"] = run.times;
+  J["total_time_s"] = run.total_time_s;
+  return J;
+}
+
+bool LoadEstimate(const std::string& path, bs_tools::Trajectory& trajectory) {
+  if (!std::filesystem::is_directory(path)) {
+    return bs_tools::TrajectoryEvaluator::LoadTrajectory(path, trajectory);
+  }
+
+  // the global map needs the extrinsics, which can only be set once
+  static bool extrinsics_initialized = false;
+  if (!extrinsics_initialized) {
+    const std::string extrinsics_path =
+        beam::CombinePaths(path, "extrinsics.json");
+    BEAM_INFO("Loading extrinsics from: {}", extrinsics_path);
+    if (!bs_common::ExtrinsicsLookupOnline::InitializeStatic(
+            bs_common::ExtrinsicsLookupBase(
+                beam::CombinePaths(path, "frame_ids.json"),
+                extrinsics_path))) {
+      return false;
+    }
+    extrinsics_initialized = true;
+  }
+  bs_models::global_mapping::GlobalMap global_map(path);
+  trajectory = bs_tools::TrajectoryEvaluator::GetGlobalMapTrajectory(
+      global_map, FLAGS_use_initial);
+  return true;
+}
+
+void PrintRun(const Run& run) {
+  const auto& errors = run.errors;
+  BEAM_INFO("{}: {} poses over {:.1f} m, scale {:.4f}", run.label,
+            errors.num_poses, errors.length_m, errors.scale);
+  BEAM_INFO("  ATE translation [m]  rmse {:.4f}  mean {:.4f}  median {:.4f}  "
+            "max {:.4f}",
+            errors.ate_translation_m.rmse, errors.ate_translation_m.mean,
+            errors.ate_translation_m.median, errors.ate_translation_m.max);
+  BEAM_INFO("  ATE rotation [deg]   rmse {:.4f}  mean {:.4f}  median {:.4f}  "
+            "max {:.4f}",
+            errors.ate_rotation_deg.rmse, errors.ate_rotation_deg.mean,
+            errors.ate_rotation_deg.median, errors.ate_rotation_deg.max);
+  for (const auto& rpe : errors.rpe) {
+    if (rpe.translation_pct.count == 0) {
+      BEAM_INFO("  RPE {:>6.1f} m        trajectory too short", rpe.distance_m);
+      continue;
+    }
+    BEAM_INFO("  RPE {:>6.1f} m        {:.3f} %  {:.5f} deg/m  ({} pairs)",
+              rpe.distance_m, rpe.translation_pct.mean,
+              rpe.rotation_deg_per_m.mean, rpe.translation_pct.count);
+  }
+  for (const auto& [stage, time] : run.times) {
+    BEAM_INFO("  {:<24} {:>9.2f} s", stage, time);
+  }
+  if (!run.times.empty()) {
+    BEAM_INFO("  {:<24} {:>9.2f} s", "total", run.total_time_s);
+  }
+}
+
+/**
+ * @brief compare a run to the run with the same label in a baseline report
+ * @return false if the run regressed
+ */
+bool CheckRegression(const Run& run, const nlohmann::json& J_baseline) {
+  for (const auto& J_run : J_baseline["runs"]) {
+    if (J_run["label"].get<std::string>() != run.label) { continue; }
+
+    bool passed = true;
+    const double ate_baseline =
+        J_run["ate_translation_m"]["rmse"].get<double>();
+    const double ate = run.errors.ate_translation_m.rmse;
+    if (ate > ate_baseline * (1 + FLAGS_max_ate_increase)) {
+      BEAM_ERROR("{}: ATE rmse increased from {:.4f} m to {:.4f} m", run.label,
+                 ate_baseline, ate);
+      passed = false;
+    }
+    const double time_baseline = J_run["total_time_s"].get<double>();
+    if (time_baseline > 0 && run.total_time_s > 0 &&
+        run.total_time_s > time_baseline * (1 + FLAGS_max_time_increase)) {
+      BEAM_ERROR("{}: total time increased from {:.2f} s to {:.2f} s",
+                 run.label, time_baseline, run.total_time_s);
+      passed = false;
+    }
+    if (passed) {
+      BEAM_INFO("{}: no regression (ATE rmse {:.4f} -> {:.4f} m, total time "
+                "{:.2f} -> {:.2f} s)",
+                run.label, ate_baseline, ate, time_baseline,
+                run.total_time_s);
+    }
+    return passed;
+  }
+  BEAM_WARN("{}: not in the baseline report, skipping regression check",
+            run.label);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  ros::Time::init();
+
+  const auto estimates = Split(FLAGS_estimates);
+  auto labels = Split(FLAGS_labels);
+  auto timings = Split(FLAGS_timings);
+  if (estimates.empty()) {
+    BEAM_ERROR("No estimates given");
+    return 1;
+  }
+  if (labels.empty()) { labels = estimates; }
+  timings.resize(estimates.size());
+  if (labels.size() != estimates.size() ||
+      timings.size() != estimates.size()) {
+    BEAM_ERROR("The number of labels and timing files must match the number "
+               "of estimates");
+    return 1;
+  }
+
+  bs_tools::TrajectoryEvaluator::Params params;
+  if (FLAGS_alignment == "se3") {
+    params.alignment = bs_tools::TrajectoryEvaluator::Alignment::SE3;
+  } else if (FLAGS_alignment == "sim3") {
+    params.alignment = bs_tools::TrajectoryEvaluator::Alignment::SIM3;
+  } else if (FLAGS_alignment == "none") {
+    params.alignment = bs_tools::TrajectoryEvaluator::Alignment::NONE;
+  } else {
+    BEAM_ERROR("Invalid alignment: {}. Options: se3, sim3, none",
+               FLAGS_alignment);
+    return 1;
+  }
+  params.max_time_diff_s = FLAGS_max_time_diff_s;
+  params.rpe_distances_m.clear();
+  for (const auto& distance : Split(FLAGS_rpe_distances_m)) {
+    params.rpe_distances_m.push_back(std::stod(distance));
+  }
+
+  bs_tools::Trajectory ground_truth;
+  if (!bs_tools::TrajectoryEvaluator::LoadTrajectory(FLAGS_ground_truth,
+                                                     ground_truth)) {
+    return 1;
+  }
+  bs_tools::TrajectoryEvaluator evaluator(ground_truth, params);
+
+  std::vector<Run> runs;
+  for (size_t i = 0; i < estimates.size(); i++) {
+    Run run;
+    run.label = labels[i];
+    run.source = estimates[i];
+    BEAM_INFO("Loading estimate: {}", run.source);
+    bs_tools::Trajectory estimate;
+    if (!LoadEstimate(run.source, estimate)) { return 1; }
+    try {
+      run.errors = evaluator.Evaluate(estimate);
+    } catch (const std::runtime_error&) { return 1; }
+
+    if (!timings[i].empty()) {
+      if (!bs_tools::TrajectoryEvaluator::LoadStageTimes(timings[i],
+                                                         run.times)) {
+        return 1;
+      }
+      for (const auto& [stage, time] : run.times) { run.total_time_s += time; }
+    }
+    runs.push_back(run);
+  }
+
+  for (const auto& run : runs) { PrintRun(run); }
+
+  if (!FLAGS_output_file.empty()) {
+    nlohmann::json J;
+    J["ground_truth"] = FLAGS_ground_truth;
+    J["alignment"] = FLAGS_alignment;
+    std::vector<nlohmann::json> J_runs;
+    for (const auto& run : runs) { J_runs.push_back(ToJson(run)); }
+    J["runs"] = J_runs;
+    BEAM_INFO("Saving report to: {}", FLAGS_output_file);
+    std::ofstream file(FLAGS_output_file);
+    file << std::setw(4) << J << std::endl;
+  }
+
+  if (FLAGS_baseline_report.empty()) { return 0; }
+  nlohmann::json J_baseline;
+  if (!beam::ReadJson(FLAGS_baseline_report, J_baseline)) {
+    BEAM_ERROR("Cannot read baseline report: {}", FLAGS_baseline_report);
+    return 1;
+  }
+  bool passed = true;
+  for (const auto& run : runs) {
+    passed = CheckRegression(run, J_baseline) && passed;
+  }
+  return passed ? 0 : 2;
+}
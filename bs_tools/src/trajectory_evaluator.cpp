@@ -0,0 +1,256 @@
+#include <bs_tools/trajectory_evaluator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include <beam_mapping/Poses.h>
+#include <beam_utils/filesystem.h>
+#include <beam_utils/log.h>
+
+namespace bs_tools {
+
+namespace {
+
+double AngleDeg(const Eigen::Matrix3d& R) {
+  return Eigen::AngleAxisd(R).angle() * 180 / M_PI;
+}
+
+/**
+ * @brief relative transform between two poses, with the translation of the
+ * poses scaled first
+ */
+Eigen::Matrix4d Relative(const Eigen::Matrix4d& T_World_A,
+                         const Eigen::Matrix4d& T_World_B, double scale) {
+  Eigen::Matrix4d T_A_B = Eigen::Matrix4d::Identity();
+  T_A_B.block<3, 3>(0, 0) =
+      T_World_A.block<3, 3>(0, 0).transpose() * T_World_B.block<3, 3>(0, 0);
+  T_A_B.block<3, 1>(0, 3) =
+      scale * T_World_A.block<3, 3>(0, 0).transpose() *
+      (T_World_B.block<3, 1>(0, 3) - T_World_A.block<3, 1>(0, 3));
+  return T_A_B;
+}
+
+} // namespace
+
+TrajectoryEvaluator::TrajectoryEvaluator(const Trajectory& ground_truth,
+                                         const Params& params)
+    : ground_truth_(ground_truth), params_(params) {}
+
+TrajectoryEvaluator::Errors
+    TrajectoryEvaluator::Evaluate(const Trajectory& estimate) const {
+  std::vector<Eigen::Matrix4d> matched_estimate;
+  std::vector<Eigen::Matrix4d> matched_ground_truth;
+  for (const auto& [stamp, T_World_Frame] : estimate) {
+    Eigen::Matrix4d T_World_FrameGt;
+    if (!GetGroundTruth(stamp, T_World_FrameGt)) { continue; }
+    matched_estimate.push_back(T_World_Frame);
+    matched_ground_truth.push_back(T_World_FrameGt);
+  }
+
+  Errors errors;
+  errors.num_poses = matched_estimate.size();
+  if (errors.num_poses < 3) {
+    BEAM_ERROR("Only {} of {} estimated poses match the ground truth, check "
+               "that both trajectories use the same time base",
+               errors.num_poses, estimate.size());
+    throw std::runtime_error{"not enough poses matching the ground truth"};
+  }
+  Align(matched_estimate, matched_ground_truth, errors);
+
+  // absolute errors of the aligned estimate
+  const Eigen::Matrix4d& T_Gt_Est = errors.T_GroundTruth_Estimate;
+  const Eigen::Matrix3d R_Gt_Est = T_Gt_Est.block<3, 3>(0, 0);
+  const Eigen::Vector3d t_Gt_Est = T_Gt_Est.block<3, 1>(0, 3);
+  std::vector<double> translation_errors;
+  std::vector<double> rotation_errors;
+  std::vector<double> distances{0};
+  for (int i = 0; i < errors.num_poses; i++) {
+    const Eigen::Matrix4d& T_Est = matched_estimate[i];
+    const Eigen::Matrix4d& T_Gt = matched_ground_truth[i];
+    const Eigen::Vector3d p_aligned =
+        errors.scale * R_Gt_Est * T_Est.block<3, 1>(0, 3) + t_Gt_Est;
+    translation_errors.push_back((p_aligned - T_Gt.block<3, 1>(0, 3)).norm());
+    rotation_errors.push_back(AngleDeg(T_Gt.block<3, 3>(0, 0).transpose() *
+                                       R_Gt_Est * T_Est.block<3, 3>(0, 0)));
+    if (i > 0) {
+      distances.push_back(distances.back() +
+                          (T_Gt.block<3, 1>(0, 3) -
+                           matched_ground_truth[i - 1].block<3, 1>(0, 3))
+                              .norm());
+    }
+  }
+  errors.ate_translation_m = ComputeStats(translation_errors);
+  errors.ate_rotation_deg = ComputeStats(rotation_errors);
+  errors.length_m = distances.back();
+
+  // relative errors between each pose and the first pose at least some
+  // distance after it
+  for (double distance : params_.rpe_distances_m) {
+    RelativeError rpe;
+    rpe.distance_m = distance;
+    std::vector<double> translation_pct;
+    std::vector<double> rotation_deg_per_m;
+    int j = 0;
+    for (int i = 0; i < errors.num_poses; i++) {
+      while (j < errors.num_poses && distances[j] - distances[i] < distance) {
+        j++;
+      }
+      if (j == errors.num_poses) { break; }
+      const double actual_distance = distances[j] - distances[i];
+      const Eigen::Matrix4d T_Gt_ij = Relative(
+          matched_ground_truth[i], matched_ground_truth[j], 1);
+      const Eigen::Matrix4d T_Est_ij =
+          Relative(matched_estimate[i], matched_estimate[j], errors.scale);
+      const Eigen::Matrix4d E = T_Gt_ij.inverse() * T_Est_ij;
+      translation_pct.push_back(100 * E.block<3, 1>(0, 3).norm() /
+                                actual_distance);
+      rotation_deg_per_m.push_back(AngleDeg(E.block<3, 3>(0, 0)) /
+                                   actual_distance);
+    }
+    rpe.translation_pct = ComputeStats(translation_pct);
+    rpe.rotation_deg_per_m = ComputeStats(rotation_deg_per_m);
+    errors.rpe.push_back(rpe);
+  }
+  return errors;
+}
+
+bool TrajectoryEvaluator::GetGroundTruth(uint64_t stamp,
+                                         Eigen::Matrix4d& T_World_Frame) const {
+  auto next = ground_truth_.lower_bound(stamp);
+  if (next == ground_truth_.end()) { return false; }
+  if (next->first == stamp) {
+    T_World_Frame = next->second;
+    return true;
+  }
+  if (next == ground_truth_.begin()) { return false; }
+  auto prev = std::prev(next);
+  const double dt = (next->first - prev->first) * 1e-9;
+  if (dt > params_.max_time_diff_s) { return false; }
+
+  const double alpha = (stamp - prev->first) * 1e-9 / dt;
+  const Eigen::Quaterniond q_prev(prev->second.block<3, 3>(0, 0));
+  const Eigen::Quaterniond q_next(next->second.block<3, 3>(0, 0));
+  T_World_Frame = Eigen::Matrix4d::Identity();
+  T_World_Frame.block<3, 3>(0, 0) =
+      q_prev.slerp(alpha, q_next).toRotationMatrix();
+  T_World_Frame.block<3, 1>(0, 3) =
+      (1 - alpha) * prev->second.block<3, 1>(0, 3) +
+      alpha * next->second.block<3, 1>(0, 3);
+  return true;
+}
+
+void TrajectoryEvaluator::Align(
+    const std::vector<Eigen::Matrix4d>& estimate,
+    const std::vector<Eigen::Matrix4d>& ground_truth, Errors& errors) const {
+  if (params_.alignment == Alignment::NONE) { return; }
+
+  Eigen::Matrix3Xd p_Est(3, estimate.size());
+  Eigen::Matrix3Xd p_Gt(3, ground_truth.size());
+  for (size_t i = 0; i < estimate.size(); i++) {
+    p_Est.col(i) = estimate[i].block<3, 1>(0, 3);
+    p_Gt.col(i) = ground_truth[i].block<3, 1>(0, 3);
+  }
+  const Eigen::Matrix4d T =
+      Eigen::umeyama(p_Est, p_Gt, params_.alignment == Alignment::SIM3);
+
+  // the rotation block is scaled by the scale of the similarity transform
+  errors.scale = T.block<3, 1>(0, 0).norm();
+  errors.T_GroundTruth_Estimate = T;
+  errors.T_GroundTruth_Estimate.block<3, 3>(0, 0) /= errors.scale;
+}
+
+bool TrajectoryEvaluator::LoadTrajectory(const std::string& path,
+                                         Trajectory& trajectory) {
+  beam_mapping::Poses poses;
+  if (!poses.LoadFromFile(path)) {
+    BEAM_ERROR("Cannot load pose file: {}. Options: .json, .txt, .ply", path);
+    return false;
+  }
+  trajectory.clear();
+  const auto& transforms = poses.GetPoses();
+  const auto& stamps = poses.GetTimeStamps();
+  for (size_t i = 0; i < transforms.size(); i++) {
+    trajectory.emplace(stamps[i].toNSec(), transforms[i]);
+  }
+  return true;
+}
+
+Trajectory TrajectoryEvaluator::GetGlobalMapTrajectory(
+    bs_models::global_mapping::GlobalMap& global_map, bool use_initial) {
+  Trajectory trajectory;
+  for (const auto& submap : global_map.GetSubmaps()) {
+    const Eigen::Matrix4d T_WORLD_SUBMAP = use_initial
+                                               ? submap->T_WORLD_SUBMAP_INIT()
+                                               : submap->T_WORLD_SUBMAP();
+    for (const auto& pose_stamped : submap->GetTrajectory(use_initial)) {
+      trajectory.emplace(pose_stamped.stamp.toNSec(),
+                         T_WORLD_SUBMAP * pose_stamped.pose);
+    }
+  }
+  return trajectory;
+}
+
+bool TrajectoryEvaluator::LoadStageTimes(const std::string& path,
+                                         StageTimes& times) {
+  nlohmann::json J;
+  if (!beam::ReadJson(path, J)) {
+    BEAM_ERROR("Cannot read timing file: {}", path);
+    return false;
+  }
+
+  times.clear();
+  if (J.contains("maps")) {
+    // summary of the batch refinement
+    for (const auto& J_map : J["maps"]) {
+      for (const auto& J_step : J_map["steps"]) {
+        if (!J_step["run"].get<bool>()) { continue; }
+        times[J_step["step"].get<std::string>()] +=
+            J_step["wall_time_s"].get<double>();
+      }
+    }
+    return true;
+  }
+
+  for (const auto& [stage, J_time] : J.items()) {
+    if (J_time.is_number()) {
+      times[stage] += J_time.get<double>();
+    } else if (J_time.is_array()) {
+      for (const auto& J_sample : J_time) {
+        times[stage] += J_sample.get<double>();
+      }
+    } else {
+      BEAM_WARN("Ignoring invalid time of stage {} in: {}", stage, path);
+    }
+  }
+  return true;
+}
+
+TrajectoryEvaluator::ErrorStats
+    TrajectoryEvaluator::ComputeStats(std::vector<double> errors) {
+  ErrorStats stats;
+  stats.count = errors.size();
+  if (errors.empty()) { return stats; }
+
+  std::sort(errors.begin(), errors.end());
+  stats.median = errors.size() % 2 == 1
+                     ? errors[errors.size() / 2]
+                     : (errors[errors.size() / 2 - 1] +
+                        errors[errors.size() / 2]) /
+                           2;
+  stats.max = errors.back();
+  stats.mean =
+      std::accumulate(errors.begin(), errors.end(), 0.0) / errors.size();
+  double sum_squares = 0;
+  for (double error : errors) { sum_squares += error * error; }
+  stats.rmse = std::sqrt(sum_squares / errors.size());
+  stats.std =
+      std::sqrt(std::max(0.0, sum_squares / errors.size() -
+                                  stats.mean * stats.mean));
+  return stats;
+}
+
+} // namespace bs_tools
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <bs_tools/calibration_scorer.h>
+
+using namespace bs_tools;
+
+namespace {
+
+/**
+ * synthetic scene in the lidar frame (x forward, y left, z up): a wall at
+ * x = 10 with vertical boards in front of it. The boards are taller than the
+ * vertical field of view of the lidar, so all depth edges are vertical
+ */
+struct Board {
+  double x;
+  double y_min;
+  double y_max;
+};
+
+std::vector<Board> Boards(int frame) {
+  std::vector<Board> boards;
+  for (int j = 0; j < 4; j++) {
+    const double x = 3 + j + 0.25 * (frame % 4);
+    const double y_min = -3.2 + 1.6 * j + 0.1 * frame;
+    boards.push_back(Board{x, y_min, y_min + 0.8});
+  }
+  return boards;
+}
+
+// index of the surface hit by a ray (0 for the wall, j + 1 for board j), and
+// the range to it. Returns -1 if nothing is hit
+int CastRay(const std::vector<Board>& boards, const Eigen::Vector3d& origin,
+            const Eigen::Vector3d& ray, double& range) {
+  if (ray.x() < 1e-6) { return -1; }
+  int surface = 0;
+  range = (10 - origin.x()) / ray.x();
+  for (size_t j = 0; j < boards.size(); j++) {
+    const double t = (boards[j].x - origin.x()) / ray.x();
+    const Eigen::Vector3d p = origin + t * ray;
+    if (t > 0 && t < range && p.y() > boards[j].y_min &&
+        p.y() < boards[j].y_max && std::abs(p.z()) < 3) {
+      range = t;
+      surface = j + 1;
+    }
+  }
+  return surface;
+}
+
+Eigen::Matrix4d TrueT_Camera_Lidar() {
+  Eigen::Matrix4d T_Lidar_Camera = Eigen::Matrix4d::Identity();
+  T_Lidar_Camera.block<3, 3>(0, 0) << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+  T_Lidar_Camera.block<3, 1>(0, 3) = Eigen::Vector3d(0.1, 0.05, -0.1);
+  return T_Lidar_Camera.inverse();
+}
+
+// rotate the camera about its vertical axis
+Eigen::Matrix4d Yaw(const Eigen::Matrix4d& T_Camera_Lidar, double deg) {
+  Eigen::Matrix4d T_Rotated_Camera = Eigen::Matrix4d::Identity();
+  T_Rotated_Camera.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(deg * M_PI / 180, Eigen::Vector3d::UnitY())
+          .toRotationMatrix();
+  return T_Rotated_Camera * T_Camera_Lidar;
+}
+
+cv::Mat RenderImage(beam_calibration::CameraModel& camera, int frame,
+                    const Eigen::Matrix4d& T_Camera_Lidar) {
+  const std::vector<Board> boards = Boards(frame);
+  const Eigen::Matrix4d T_Lidar_Camera = T_Camera_Lidar.inverse();
+  const Eigen::Vector3d origin = T_Lidar_Camera.block<3, 1>(0, 3);
+  cv::Mat image(camera.GetHeight(), camera.GetWidth(), CV_8UC1);
+  for (int r = 0; r < image.rows; r++) {
+    for (int c = 0; c < image.cols; c++) {
+      Eigen::Vector3d ray_Camera;
+      camera.BackProject(Eigen::Vector2i(c, r), ray_Camera);
+      double range;
+      const int surface = CastRay(
+          boards, origin, T_Lidar_Camera.block<3, 3>(0, 0) * ray_Camera, range);
+      image.at<uchar>(r, c) = surface < 0 ? 0 : 60 + 40 * surface;
+    }
+  }
+  return image;
+}
+
+pcl::PointCloud<PointXYZIRT> SimulateScan(int frame) {
+  const std::vector<Board> boards = Boards(frame);
+  pcl::PointCloud<PointXYZIRT> cloud;
+  for (int ring = 0; ring < 32; ring++) {
+    const double elevation = (-16 + ring) * M_PI / 180;
+    for (int c = 0; c < 600; c++) {
+      const double azimuth = (-60 + 0.2 * c) * M_PI / 180;
+      const Eigen::Vector3d ray(std::cos(elevation) * std::cos(azimuth),
+                                std::cos(elevation) * std::sin(azimuth),
+                                std::sin(elevation));
+      double range;
+      if (CastRay(boards, Eigen::Vector3d::Zero(), ray, range) < 0) {
+        continue;
+      }
+      PointXYZIRT p;
+      p.x = range * ray.x();
+      p.y = range * ray.y();
+      p.z = range * ray.z();
+      p.ring = ring;
+      cloud.push_back(p);
+    }
+  }
+  return cloud;
+}
+
+std::shared_ptr<beam_calibration::CameraModel> Camera() {
+  std::string current_file = "calibration_scorer_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  return beam_calibration::CameraModel::Create(test_path +
+                                               "data/intrinsics.json");
+}
+
+} // namespace
+
+TEST(CalibrationScorer, DepthEdges) {
+  const auto edges = CalibrationScorer::DepthEdges(SimulateScan(0), 0.3);
+
+  // each ring sees both vertical sides of the 4 boards
+  EXPECT_EQ(edges.size(), 32 * 4 * 2);
+  for (const auto& edge : edges) {
+    EXPECT_LT(edge.point.x(), 7.5);
+    EXPECT_GT(edge.weight, std::sqrt(2.0));
+  }
+}
+
+TEST(CalibrationScorer, EdgeImage) {
+  cv::Mat image(20, 20, CV_8UC1, cv::Scalar(0));
+  for (int r = 0; r < 20; r++) {
+    for (int c = 10; c < 20; c++) { image.at<uchar>(r, c) = 255; }
+  }
+  const cv::Mat edges = CalibrationScorer::EdgeImage(image, 0.5, 0.9);
+  ASSERT_EQ(edges.type(), CV_32F);
+  EXPECT_NEAR(edges.at<float>(10, 9), 1, 1e-6);
+  EXPECT_NEAR(edges.at<float>(10, 10), 1, 1e-6);
+  EXPECT_NEAR(edges.at<float>(10, 7), 0.5 * 0.9 * 0.9, 1e-6);
+  EXPECT_NEAR(edges.at<float>(10, 14), 0.5 * std::pow(0.9, 4), 1e-6);
+}
+
+TEST(CalibrationScorer, DetectDrift) {
+  const auto camera = Camera();
+  const Eigen::Matrix4d T_Camera_Lidar = TrueT_Camera_Lidar();
+
+  // the camera is bumped by 2 degrees halfway through the recording
+  const int num_frames = 20;
+  std::vector<CalibrationScorer::Frame> frames;
+  for (int i = 0; i < num_frames; i++) {
+    CalibrationScorer::Frame frame;
+    frame.stamp = ros::Time(100 + i);
+    frame.cloud = SimulateScan(i);
+    const Eigen::Matrix4d T_Camera_Lidar_true =
+        i < num_frames / 2 ? T_Camera_Lidar : Yaw(T_Camera_Lidar, 2);
+    frame.image = RenderImage(*camera, i, T_Camera_Lidar_true);
+    frames.push_back(frame);
+  }
+
+  CalibrationScorer::Params params;
+  params.window_duration_s = 10;
+  params.num_threads = 4;
+  CalibrationScorer scorer(params, camera, T_Camera_Lidar);
+  const auto results = scorer.ScoreFrames(frames);
+  ASSERT_EQ(results.size(), num_frames);
+
+  // results do not depend on the threads
+  for (int i = 0; i < num_frames; i += 7) {
+    const auto result = scorer.ScoreFrame(frames[i]);
+    EXPECT_EQ(result.score, results[i].score);
+    EXPECT_EQ(result.perturbed_scores, results[i].perturbed_scores);
+  }
+
+  for (int i = 0; i < num_frames; i++) {
+    EXPECT_TRUE(results[i].valid);
+    EXPECT_EQ(results[i].perturbed_scores.size(), 12);
+  }
+
+  const auto summary = scorer.Summarize(results);
+  EXPECT_EQ(summary.num_valid_frames, num_frames);
+  ASSERT_EQ(summary.windows.size(), 2);
+  const auto& before = summary.windows[0];
+  const auto& after = summary.windows[1];
+  std::cout << "Consistent fraction before drift: "
+            << before.consistent_fraction
+            << ", after: " << after.consistent_fraction << "\n";
+  EXPECT_EQ(before.num_frames, num_frames / 2);
+  EXPECT_GE(before.consistent_fraction, 0.9);
+  EXPECT_FALSE(before.drift);
+  EXPECT_LE(after.consistent_fraction, 0.1);
+  EXPECT_TRUE(after.drift);
+  EXPECT_TRUE(summary.drift);
+  EXPECT_GT(before.mean_score, after.mean_score);
+
+  // the gradient points towards the yaw of the camera
+  EXPECT_GT(after.mean_gradient[1], 0);
+  EXPECT_GT(std::abs(after.mean_gradient[1]),
+            std::abs(after.mean_gradient[0]));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+#include <bs_common/extrinsics_lookup_online.h>
+#include <bs_models/scan_registration/registration_map.h>
+#include <bs_tools/lidar_odometry_benchmark.h>
+
+using namespace bs_tools;
+
+namespace {
+
+const double kScanPeriod{0.1};
+const int kNumScans{10};
+
+std::string TestPath() {
+  std::string current_file = "lidar_odometry_benchmark_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  return test_path;
+}
+
+// true lidar motion: slow yaw rotation and a forward velocity of 1 m/s
+Eigen::Matrix4d TrueTrajectory(double t) {
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(0.2 * t, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(t, 0.1 * t, 0);
+  return T;
+}
+
+// distance along a ray from inside a box to its walls
+double RayToBox(const Eigen::Vector3d& origin, const Eigen::Vector3d& ray) {
+  const Eigen::Vector3d min(-6, -5, -1.5);
+  const Eigen::Vector3d max(6, 5, 2.5);
+  double range = std::numeric_limits<double>::max();
+  for (int i = 0; i < 3; i++) {
+    if (ray[i] > 1e-9) {
+      range = std::min(range, (max[i] - origin[i]) / ray[i]);
+    } else if (ray[i] < -1e-9) {
+      range = std::min(range, (min[i] - origin[i]) / ray[i]);
+    }
+  }
+  return range;
+}
+
+// raw scan of a box shaped room by a 16 beam lidar moving along the true
+// trajectory, with point times relative to the scan stamp
+pcl::PointCloud<PointXYZIRT> SimulateRawScan(double stamp) {
+  const int columns = 900;
+  pcl::PointCloud<PointXYZIRT> cloud;
+  for (int c = 0; c < columns; c++) {
+    const double time = kScanPeriod * c / columns;
+    const Eigen::Matrix4d T_World_Lidar = TrueTrajectory(stamp + time);
+    const Eigen::Matrix3d R = T_World_Lidar.block<3, 3>(0, 0);
+    const Eigen::Vector3d origin = T_World_Lidar.block<3, 1>(0, 3);
+    const double azimuth = 2 * M_PI * c / columns;
+    for (int ring = 0; ring < 16; ring++) {
+      const double elevation = (-15 + 2 * ring) * M_PI / 180;
+      const Eigen::Vector3d ray_Lidar(std::cos(elevation) * std::cos(azimuth),
+                                      std::cos(elevation) * std::sin(azimuth),
+                                      std::sin(elevation));
+      const double range = RayToBox(origin, R * ray_Lidar);
+      PointXYZIRT p;
+      p.x = range * ray_Lidar[0];
+      p.y = range * ray_Lidar[1];
+      p.z = range * ray_Lidar[2];
+      p.intensity = 1;
+      p.ring = ring;
+      p.time = time;
+      cloud.push_back(p);
+    }
+  }
+  return cloud;
+}
+
+ros::Time Stamp(double t) {
+  return ros::Time(100 + t);
+}
+
+LidarOdometryBenchmark::Params GetParams() {
+  LidarOdometryBenchmark::Params params;
+  params.registration_config = TestPath() + "data/registration.json";
+  params.matcher_config = TestPath() + "data/voxel_gaussian.json";
+  params.window_duration_s = 0.5;
+  return params;
+}
+
+// replays the simulated scans and checks the last registered pose against the
+// true trajectory
+void ReplayScans(LidarOdometryBenchmark& benchmark, double tolerance_m) {
+  for (int i = 0; i < kNumScans; i++) {
+    const double t = i * kScanPeriod;
+    EXPECT_TRUE(benchmark.ProcessScan(SimulateRawScan(t), Stamp(t)));
+  }
+  const Eigen::Matrix4d T_True = TrueTrajectory((kNumScans - 1) * kScanPeriod);
+  const Eigen::Matrix4d T_Error =
+      T_True.inverse() * benchmark.T_World_BaselinkLast();
+  EXPECT_LT(T_Error.block<3, 1>(0, 3).norm(), tolerance_m);
+  EXPECT_LT(Eigen::AngleAxisd(Eigen::Matrix3d(T_Error.block<3, 3>(0, 0)))
+                .angle(),
+            1.0 * M_PI / 180);
+}
+
+} // namespace
+
+TEST(LidarOdometryBenchmark, LatencyStats) {
+  std::vector<double> latencies;
+  for (int i = 100; i > 0; i--) { latencies.push_back(i); }
+  const auto stats = LidarOdometryBenchmark::ComputeLatencyStats(latencies);
+  EXPECT_EQ(stats.count, 100);
+  EXPECT_DOUBLE_EQ(stats.mean_ms, 50.5);
+  EXPECT_DOUBLE_EQ(stats.p50_ms, 50);
+  EXPECT_DOUBLE_EQ(stats.p90_ms, 90);
+  EXPECT_DOUBLE_EQ(stats.p99_ms, 99);
+  EXPECT_DOUBLE_EQ(stats.max_ms, 100);
+
+  // nearest rank of a single sample
+  const auto single = LidarOdometryBenchmark::ComputeLatencyStats({3});
+  EXPECT_DOUBLE_EQ(single.p50_ms, 3);
+  EXPECT_DOUBLE_EQ(single.p99_ms, 3);
+  EXPECT_EQ(LidarOdometryBenchmark::ComputeLatencyStats({}).count, 0);
+}
+
+TEST(LidarOdometryBenchmark, PeakMemory) {
+  // any running process has some resident memory
+  EXPECT_GT(LidarOdometryBenchmark::PeakMemoryGb(), 0);
+  EXPECT_LT(LidarOdometryBenchmark::PeakMemoryGb(), 1024);
+}
+
+TEST(LidarOdometryBenchmark, ProcessScan) {
+  // the registration map is shared, so start each benchmark from an empty map
+  bs_models::scan_registration::RegistrationMap::GetInstance().Clear();
+  LidarOdometryBenchmark benchmark(GetParams(), Eigen::Matrix4d::Identity());
+
+  // without a pose lookup each scan starts at the last registered pose, and
+  // scans are not deskewed, so the motion over each scan is not corrected
+  ReplayScans(benchmark, 0.1);
+  const auto summary = benchmark.GetSummary();
+  EXPECT_EQ(summary.num_scans, kNumScans);
+  EXPECT_EQ(summary.num_skipped, 0);
+  EXPECT_EQ(summary.num_transactions, kNumScans);
+  EXPECT_GT(summary.num_constraints, 0);
+  for (const auto& stage : LidarOdometryBenchmark::kStages) {
+    auto iter = summary.stages.find(stage);
+    if (stage == "deskew") {
+      EXPECT_TRUE(iter == summary.stages.end());
+      continue;
+    }
+    ASSERT_TRUE(iter != summary.stages.end()) << stage;
+    EXPECT_EQ(iter->second.count, kNumScans) << stage;
+  }
+  EXPECT_EQ(summary.stages.at("total").count, kNumScans);
+
+  // stamps must be increasing
+  EXPECT_FALSE(benchmark.ProcessScan(SimulateRawScan(0), Stamp(0)));
+  EXPECT_EQ(benchmark.GetSummary().num_scans, kNumScans);
+}
+
+TEST(LidarOdometryBenchmark, ProcessScanRedeskewed) {
+  bs_models::scan_registration::RegistrationMap::GetInstance().Clear();
+  auto params = GetParams();
+  params.redeskew_scans = true;
+  const LidarOdometryBenchmark::PoseLookup pose_lookup =
+      [](const ros::Time& time, Eigen::Matrix4d& T_World_Baselink) {
+        T_World_Baselink = TrueTrajectory((time - Stamp(0)).toSec());
+        return true;
+      };
+  LidarOdometryBenchmark benchmark(params, Eigen::Matrix4d::Identity(),
+                                   pose_lookup);
+
+  // scans are deskewed on arrival with the pose lookup, like with a frame
+  // initializer in lidar odometry
+  ReplayScans(benchmark, 0.02);
+  const auto summary = benchmark.GetSummary();
+  EXPECT_EQ(summary.num_skipped, 0);
+  ASSERT_EQ(summary.stages.count("deskew"), 1u);
+  EXPECT_EQ(summary.stages.at("deskew").count, kNumScans);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+
+  // the benchmark runs offline, so use static extrinsics with the lidar as
+  // the baselink instead of a ROS master
+  ros::Time::init();
+  bs_common::ExtrinsicsLookupBase::FrameIds frame_ids;
+  frame_ids.imu = "imu";
+  frame_ids.camera = "camera";
+  frame_ids.lidar = "lidar";
+  frame_ids.world = "world";
+  frame_ids.baselink = "lidar";
+  bs_common::ExtrinsicsLookupOnline::InitializeStatic(
+      bs_common::ExtrinsicsLookupBase(frame_ids));
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#include <bs_tools/refinement_scheduler.h>
+
+using namespace bs_tools;
+
+namespace {
+
+const double kStepDuration{0.3};
+
+// stand-in for the refinement tool: saves its arguments to the output path,
+// sleeps, and exits with the code in <map_dir>/exit_<step> if that file exists
+const std::string kFakeTool = R"(#!/bin/sh
+for arg in "$@"; do
+  case "$arg" in
+    -globalmap_dir=*) map_dir="${arg#*=}" ;;
+    -output_path=*) output_path="${arg#*=}" ;;
+  esac
+done
+step=$(basename "$output_path")
+echo "$@" > "$output_path/args.txt"
+sleep 0.3
+if [ -f "$map_dir/exit_$step" ]; then exit $(cat "$map_dir/exit_$step"); fi
+exit 0
+)";
+
+std::string CreateTempDir() {
+  const auto dir =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("refinement_scheduler_test_%%%%%%%%");
+  boost::filesystem::create_directories(dir);
+  return dir.string();
+}
+
+std::string WriteFakeTool(const std::string& dir) {
+  const std::string path = dir + "/fake_refinement_tool.sh";
+  std::ofstream file(path);
+  file << kFakeTool;
+  file.close();
+  boost::filesystem::permissions(path, boost::filesystem::owner_all);
+  return path;
+}
+
+// map directory with a data file of size_mb MB, so that with a memory factor
+// of 1024 its memory estimate is size_mb GB
+std::string CreateMap(const std::string& dir, const std::string& name,
+                      int size_mb) {
+  const std::string map_dir = dir + "/maps/" + name;
+  boost::filesystem::create_directories(map_dir);
+  std::ofstream file(map_dir + "/data.bin", std::ios::binary);
+  const std::string block(1024 * 1024, '\0');
+  for (int i = 0; i < size_mb; i++) { file << block; }
+  return map_dir;
+}
+
+RefinementScheduler::Params GetParams(const std::string& tool) {
+  RefinementScheduler::Params params;
+  params.refinement_binary = tool;
+  params.memory_factor = 1024;
+  return params;
+}
+
+// largest number of steps that ran at once. Intervals are shrunk by a small
+// margin since a step is timed from just before it is started until its
+// process is reaped
+int MaxConcurrentSteps(
+    const std::vector<RefinementScheduler::MapResult>& results) {
+  const double margin = 0.02;
+  std::vector<std::pair<double, int>> events;
+  for (const auto& map : results) {
+    for (const auto& step : map.steps) {
+      if (!step.run) { continue; }
+      events.emplace_back(step.start_time_s + margin, 1);
+      events.emplace_back(step.start_time_s + step.wall_time_s - margin, -1);
+    }
+  }
+  std::sort(events.begin(), events.end());
+  int running = 0;
+  int max_running = 0;
+  for (const auto& event : events) {
+    running += event.second;
+    max_running = std::max(max_running, running);
+  }
+  return max_running;
+}
+
+bool Overlap(const RefinementScheduler::StepResult& a,
+             const RefinementScheduler::StepResult& b) {
+  const double margin = 0.02;
+  return a.start_time_s + margin < b.start_time_s + b.wall_time_s &&
+         b.start_time_s + margin < a.start_time_s + a.wall_time_s;
+}
+
+std::string ReadArgs(const std::string& output_dir, const std::string& step) {
+  std::ifstream file(output_dir + "/" + step + "/args.txt");
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+} // namespace
+
+TEST(RefinementScheduler, StepsRunInOrderUnderMemoryCap) {
+  const std::string dir = CreateTempDir();
+  auto params = GetParams(WriteFakeTool(dir));
+  params.steps = {"posegraph_optimization", "submap_refinement",
+                  "submap_alignment"};
+  params.max_jobs = 3;
+  params.max_memory_gb = 2.5;
+  RefinementScheduler scheduler(params);
+  for (const std::string name : {"a", "b", "c"}) {
+    scheduler.AddMap(CreateMap(dir, name, 1), dir + "/output/" + name);
+  }
+  const auto results = scheduler.Run();
+
+  // steps of each map run one after the other, in the order of kSteps
+  const std::vector<std::string> expected_steps{
+      "submap_refinement", "submap_alignment", "posegraph_optimization"};
+  ASSERT_EQ(results.size(), 3u);
+  for (const auto& map : results) {
+    EXPECT_TRUE(map.success);
+    ASSERT_EQ(map.steps.size(), expected_steps.size());
+    for (size_t i = 0; i < map.steps.size(); i++) {
+      const auto& step = map.steps[i];
+      EXPECT_EQ(step.step, expected_steps[i]);
+      EXPECT_TRUE(step.run);
+      EXPECT_EQ(step.exit_code, 0);
+      EXPECT_GE(step.wall_time_s, kStepDuration);
+      if (i > 0) {
+        const auto& previous = map.steps[i - 1];
+        EXPECT_GE(step.start_time_s,
+                  previous.start_time_s + previous.wall_time_s);
+      }
+    }
+  }
+
+  // only two of the 1 GB jobs fit under the cap, even with a free slot
+  EXPECT_EQ(MaxConcurrentSteps(results), 2);
+  EXPECT_LT(scheduler.TotalTime(), 9 * kStepDuration);
+
+  // each step enables the steps up to itself and restores the earlier ones
+  const std::string alignment_args =
+      ReadArgs(results[0].output_dir, "submap_alignment");
+  EXPECT_NE(alignment_args.find("-globalmap_dir=" + results[0].map_dir),
+            std::string::npos);
+  EXPECT_NE(alignment_args.find("-use_checkpoints=true"), std::string::npos);
+  EXPECT_NE(alignment_args.find("-save_results=false"), std::string::npos);
+  EXPECT_NE(alignment_args.find("-run_batch_optimizer=false"),
+            std::string::npos);
+  EXPECT_NE(alignment_args.find("-run_submap_refinement=true"),
+            std::string::npos);
+  EXPECT_NE(alignment_args.find("-run_submap_alignment=true"),
+            std::string::npos);
+  EXPECT_NE(alignment_args.find("-run_posegraph_optimization=false"),
+            std::string::npos);
+  const std::string posegraph_args =
+      ReadArgs(results[0].output_dir, "posegraph_optimization");
+  EXPECT_NE(posegraph_args.find("-save_results=true"), std::string::npos);
+  EXPECT_NE(posegraph_args.find("-run_posegraph_optimization=true"),
+            std::string::npos);
+
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(RefinementScheduler, MaxJobs) {
+  const std::string dir = CreateTempDir();
+  auto params = GetParams(WriteFakeTool(dir));
+  params.steps = {"submap_alignment"};
+  params.max_jobs = 2;
+  RefinementScheduler scheduler(params);
+  for (const std::string name : {"a", "b", "c", "d"}) {
+    scheduler.AddMap(CreateMap(dir, name, 1), dir + "/output/" + name);
+  }
+  const auto results = scheduler.Run();
+  for (const auto& map : results) { EXPECT_TRUE(map.success); }
+  EXPECT_EQ(MaxConcurrentSteps(results), 2);
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(RefinementScheduler, OversizedJobRunsAlone) {
+  const std::string dir = CreateTempDir();
+  auto params = GetParams(WriteFakeTool(dir));
+  params.steps = {"submap_alignment"};
+  params.max_jobs = 3;
+  params.max_memory_gb = 2.5;
+  RefinementScheduler scheduler(params);
+  scheduler.AddMap(CreateMap(dir, "large", 3), dir + "/output/large");
+  scheduler.AddMap(CreateMap(dir, "a", 1), dir + "/output/a");
+  scheduler.AddMap(CreateMap(dir, "b", 1), dir + "/output/b");
+  const auto results = scheduler.Run();
+
+  // the job over the cap still runs, but never next to another job
+  ASSERT_EQ(results.size(), 3u);
+  for (const auto& map : results) {
+    EXPECT_TRUE(map.success);
+    ASSERT_EQ(map.steps.size(), 1u);
+  }
+  EXPECT_FALSE(Overlap(results[0].steps[0], results[1].steps[0]));
+  EXPECT_FALSE(Overlap(results[0].steps[0], results[2].steps[0]));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(RefinementScheduler, FailedStepStopsItsMap) {
+  const std::string dir = CreateTempDir();
+  auto params = GetParams(WriteFakeTool(dir));
+  params.steps = {"batch_optimization", "submap_refinement",
+                  "submap_alignment"};
+  params.max_jobs = 2;
+  RefinementScheduler scheduler(params);
+  const std::string failing_map = CreateMap(dir, "failing", 1);
+  std::ofstream(failing_map + "/exit_submap_refinement") << 3;
+  scheduler.AddMap(failing_map, dir + "/output/failing");
+  scheduler.AddMap(CreateMap(dir, "good", 1), dir + "/output/good");
+  const auto results = scheduler.Run();
+  ASSERT_EQ(results.size(), 2u);
+
+  // the failed step is recorded and the remaining steps are cancelled
+  const auto& failed = results[0];
+  EXPECT_FALSE(failed.success);
+  ASSERT_EQ(failed.steps.size(), 3u);
+  EXPECT_TRUE(failed.steps[0].run);
+  EXPECT_EQ(failed.steps[0].exit_code, 0);
+  EXPECT_TRUE(failed.steps[1].run);
+  EXPECT_EQ(failed.steps[1].exit_code, 3);
+  EXPECT_EQ(failed.steps[2].step, "submap_alignment");
+  EXPECT_FALSE(failed.steps[2].run);
+  EXPECT_FALSE(
+      boost::filesystem::exists(failed.output_dir + "/submap_alignment"));
+
+  // other maps are not affected
+  const auto& good = results[1];
+  EXPECT_TRUE(good.success);
+  ASSERT_EQ(good.steps.size(), 3u);
+  for (const auto& step : good.steps) {
+    EXPECT_TRUE(step.run);
+    EXPECT_EQ(step.exit_code, 0);
+  }
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(RefinementScheduler, InvalidStep) {
+  RefinementScheduler::Params params;
+  params.steps = {"submap_alignment", "loop_closure"};
+  EXPECT_THROW(RefinementScheduler{params}, std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
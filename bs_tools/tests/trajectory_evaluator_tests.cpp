@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include <beam_calibration/CameraModel.h>
+
+#include <bs_common/extrinsics_lookup_base.h>
+#include <bs_tools/trajectory_evaluator.h>
+
+using namespace bs_tools;
+
+namespace {
+
+const uint64_t kStart{100000000000};
+const uint64_t kPeriod{100000000};
+
+/**
+ * ground truth baselink trajectory: a circle of radius 20 m at 2 m/s, sampled
+ * at 10 Hz, with some height and roll oscillation
+ */
+Eigen::Matrix4d TruePose(double t) {
+  const double angle = 0.1 * t;
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.block<3, 3>(0, 0) =
+      (Eigen::AngleAxisd(angle + M_PI / 2, Eigen::Vector3d::UnitZ()) *
+       Eigen::AngleAxisd(0.05 * std::sin(t), Eigen::Vector3d::UnitX()))
+          .toRotationMatrix();
+  T.block<3, 1>(0, 3) = Eigen::Vector3d(20 * std::cos(angle),
+                                        20 * std::sin(angle),
+                                        0.5 * std::sin(0.3 * t));
+  return T;
+}
+
+Trajectory GroundTruth(int num_poses) {
+  Trajectory trajectory;
+  for (int i = 0; i < num_poses; i++) {
+    trajectory.emplace(kStart + i * kPeriod, TruePose(i * 0.1));
+  }
+  return trajectory;
+}
+
+// estimate at every other ground truth stamp, in another world frame
+Trajectory Estimate(const Trajectory& ground_truth, double scale = 1,
+                    double yaw_drift_deg_per_m = 0) {
+  Eigen::Matrix4d T_WorldEst_WorldGt = Eigen::Matrix4d::Identity();
+  T_WorldEst_WorldGt.block<3, 3>(0, 0) =
+      Eigen::AngleAxisd(0.7, Eigen::Vector3d(1, 2, 3).normalized())
+          .toRotationMatrix();
+  T_WorldEst_WorldGt.block<3, 1>(0, 3) = Eigen::Vector3d(5, -3, 1);
+
+  Trajectory estimate;
+  int i = 0;
+  Eigen::Matrix4d T_Last = ground_truth.begin()->second;
+  Eigen::Matrix4d T_Drifted = T_Last;
+  for (const auto& stamp_pose : ground_truth) {
+    const Eigen::Matrix4d& T_World_Baselink = stamp_pose.second;
+    // accumulate the motion since the last pose with a yaw error
+    Eigen::Matrix4d T_Last_Current = T_Last.inverse() * T_World_Baselink;
+    const double step = T_Last_Current.block<3, 1>(0, 3).norm();
+    T_Last_Current.block<3, 3>(0, 0) =
+        Eigen::AngleAxisd(yaw_drift_deg_per_m * step * M_PI / 180,
+                          Eigen::Vector3d::UnitZ())
+            .toRotationMatrix() *
+        T_Last_Current.block<3, 3>(0, 0);
+    T_Drifted = T_Drifted * T_Last_Current;
+    T_Last = T_World_Baselink;
+
+    if (i++ % 2 == 1) { continue; }
+    Eigen::Matrix4d T = T_WorldEst_WorldGt * T_Drifted;
+    T.block<3, 1>(0, 3) *= scale;
+    estimate.emplace(stamp_pose.first, T);
+  }
+  return estimate;
+}
+
+ros::Time Stamp(int i) {
+  ros::Time stamp;
+  stamp.fromNSec(kStart + i * kPeriod);
+  return stamp;
+}
+
+std::string TestPath() {
+  std::string current_file = "trajectory_evaluator_tests.cpp";
+  std::string test_path = __FILE__;
+  test_path.erase(test_path.end() - current_file.size(), test_path.end());
+  return test_path;
+}
+
+} // namespace
+
+TEST(TrajectoryEvaluator, Interpolate) {
+  TrajectoryEvaluator::Params params;
+  params.max_time_diff_s = 0.15;
+  Trajectory ground_truth = GroundTruth(10);
+  ground_truth.erase(kStart + 5 * kPeriod);
+  TrajectoryEvaluator evaluator(ground_truth, params);
+
+  Eigen::Matrix4d T;
+  ASSERT_TRUE(evaluator.GetGroundTruth(kStart + 2 * kPeriod, T));
+  EXPECT_TRUE(T.isApprox(TruePose(0.2)));
+  ASSERT_TRUE(evaluator.GetGroundTruth(kStart + 2.5 * kPeriod, T));
+  EXPECT_LT((T.block<3, 1>(0, 3) - TruePose(0.25).block<3, 1>(0, 3)).norm(),
+            1e-2);
+
+  // outside of the ground truth or in a gap
+  EXPECT_FALSE(evaluator.GetGroundTruth(kStart - 1, T));
+  EXPECT_FALSE(evaluator.GetGroundTruth(kStart + 10 * kPeriod, T));
+  EXPECT_FALSE(evaluator.GetGroundTruth(kStart + 4.5 * kPeriod, T));
+}
+
+TEST(TrajectoryEvaluator, Alignment) {
+  const Trajectory ground_truth = GroundTruth(1000);
+  const Trajectory estimate = Estimate(ground_truth);
+
+  TrajectoryEvaluator::Params params;
+  const auto errors = TrajectoryEvaluator(ground_truth, params)
+                          .Evaluate(estimate);
+  EXPECT_EQ(errors.num_poses, 500);
+  EXPECT_NEAR(errors.length_m, 2 * 99.8, 0.5);
+  EXPECT_LT(errors.ate_translation_m.max, 1e-6);
+  EXPECT_LT(errors.ate_rotation_deg.max, 1e-4);
+  EXPECT_NEAR(errors.scale, 1, 1e-9);
+  ASSERT_EQ(errors.rpe.size(), params.rpe_distances_m.size());
+  for (const auto& rpe : errors.rpe) {
+    EXPECT_GT(rpe.translation_pct.count, 0);
+    EXPECT_LT(rpe.translation_pct.max, 1e-6);
+  }
+
+  // the relative errors do not depend on the alignment
+  params.alignment = TrajectoryEvaluator::Alignment::NONE;
+  const auto unaligned = TrajectoryEvaluator(ground_truth, params)
+                             .Evaluate(estimate);
+  EXPECT_GT(unaligned.ate_translation_m.mean, 1);
+  EXPECT_LT(unaligned.rpe[0].translation_pct.max, 1e-6);
+}
+
+TEST(TrajectoryEvaluator, Scale) {
+  const Trajectory ground_truth = GroundTruth(1000);
+  const Trajectory estimate = Estimate(ground_truth, 1.1);
+
+  TrajectoryEvaluator::Params params;
+  const auto se3 = TrajectoryEvaluator(ground_truth, params).Evaluate(estimate);
+  EXPECT_GT(se3.ate_translation_m.rmse, 0.5);
+  // the scale error is over the chord, the distance is along the circle
+  const double chord = 2 * 20 * std::sin(0.25);
+  EXPECT_NEAR(se3.rpe[0].translation_pct.mean, 10 * chord / 10, 0.05);
+
+  params.alignment = TrajectoryEvaluator::Alignment::SIM3;
+  const auto sim3 =
+      TrajectoryEvaluator(ground_truth, params).Evaluate(estimate);
+  EXPECT_NEAR(sim3.scale, 1 / 1.1, 1e-9);
+  EXPECT_LT(sim3.ate_translation_m.max, 1e-6);
+  EXPECT_LT(sim3.rpe[0].translation_pct.max, 1e-6);
+}
+
+TEST(TrajectoryEvaluator, Drift) {
+  const Trajectory ground_truth = GroundTruth(1000);
+  const Trajectory estimate = Estimate(ground_truth, 1, 0.01);
+
+  TrajectoryEvaluator::Params params;
+  const auto errors =
+      TrajectoryEvaluator(ground_truth, params).Evaluate(estimate);
+  EXPECT_GT(errors.ate_translation_m.rmse, 0.1);
+  for (const auto& rpe : errors.rpe) {
+    EXPECT_NEAR(rpe.rotation_deg_per_m.mean, 0.01, 1e-3);
+  }
+
+  // not enough poses
+  Trajectory late;
+  late.emplace(kStart + 2000 * kPeriod, Eigen::Matrix4d::Identity());
+  EXPECT_THROW(TrajectoryEvaluator(ground_truth, params).Evaluate(late),
+               std::runtime_error);
+}
+
+TEST(TrajectoryEvaluator, Stats) {
+  const auto stats = TrajectoryEvaluator::ComputeStats({3, 1, 4, 2});
+  EXPECT_EQ(stats.count, 4);
+  EXPECT_DOUBLE_EQ(stats.mean, 2.5);
+  EXPECT_DOUBLE_EQ(stats.median, 2.5);
+  EXPECT_DOUBLE_EQ(stats.max, 4);
+  EXPECT_DOUBLE_EQ(stats.rmse, std::sqrt(30.0 / 4));
+  EXPECT_DOUBLE_EQ(stats.std, std::sqrt(1.25));
+  EXPECT_EQ(TrajectoryEvaluator::ComputeStats({}).count, 0);
+}
+
+TEST(TrajectoryEvaluator, GlobalMapTrajectory) {
+  bs_common::ExtrinsicsLookupBase::FrameIds frame_ids;
+  frame_ids.imu = "imu";
+  frame_ids.camera = "camera";
+  frame_ids.lidar = "lidar";
+  frame_ids.world = "world";
+  frame_ids.baselink = "lidar";
+  auto extrinsics =
+      std::make_shared<bs_common::ExtrinsicsLookupBase>(frame_ids);
+  auto camera_model = beam_calibration::CameraModel::Create(
+      TestPath() + "data/intrinsics.json");
+
+  // submap of lidar keyframes at the poses from the local mapper
+  const int num_scans = 5;
+  const Eigen::Matrix4d T_World_SubmapInit = TruePose(0);
+  auto submap = std::make_shared<bs_models::global_mapping::Submap>(
+      Stamp(0), T_World_SubmapInit, camera_model, extrinsics);
+  for (int i = 0; i < num_scans; i++) {
+    submap->AddLidarMeasurement(PointCloud(), TruePose(i * 0.1), Stamp(i));
+  }
+
+  // the global mapper then moves the submap and refines the scans in it
+  Eigen::Matrix4d T_World_Submap = T_World_SubmapInit;
+  T_World_Submap(0, 3) += 1;
+  submap->UpdatePose(T_World_Submap);
+  std::map<uint64_t, Eigen::Matrix4d> T_Submap_Baselink_refined;
+  for (auto& stamp_scan : submap->LidarKeyframesMutable()) {
+    Eigen::Matrix4d T = stamp_scan.second.T_REFFRAME_BASELINK();
+    T(1, 3) += 0.2;
+    stamp_scan.second.UpdatePose(T);
+    T_Submap_Baselink_refined.emplace(stamp_scan.first, T);
+  }
+
+  bs_models::global_mapping::GlobalMap global_map(camera_model, extrinsics);
+  global_map.SetSubmaps({submap});
+
+  // the initial trajectory is the one from the local mapper, not the refined
+  // scans in the initial submap frame
+  const Trajectory initial =
+      TrajectoryEvaluator::GetGlobalMapTrajectory(global_map, true);
+  ASSERT_EQ(initial.size(), 5u);
+  for (int i = 0; i < num_scans; i++) {
+    const auto it = initial.find(Stamp(i).toNSec());
+    ASSERT_TRUE(it != initial.end());
+    EXPECT_TRUE(it->second.isApprox(TruePose(i * 0.1), 1e-9));
+  }
+
+  const Trajectory refined =
+      TrajectoryEvaluator::GetGlobalMapTrajectory(global_map, false);
+  ASSERT_EQ(refined.size(), 5u);
+  for (const auto& stamp_pose : refined) {
+    const Eigen::Matrix4d T_World_Baselink =
+        T_World_Submap * T_Submap_Baselink_refined.at(stamp_pose.first);
+    EXPECT_TRUE(stamp_pose.second.isApprox(T_World_Baselink, 1e-9));
+  }
+}
+
+TEST(TrajectoryEvaluator, StageTimes) {
+  const std::string path = "/tmp/trajectory_evaluator_tests_timing.json";
+  {
+    std::ofstream file(path);
+    file << R"({"load": 1.5, "registration": [0.1, 0.2, 0.3]})";
+  }
+  StageTimes times;
+  ASSERT_TRUE(TrajectoryEvaluator::LoadStageTimes(path, times));
+  EXPECT_EQ(times.size(), 2);
+  EXPECT_DOUBLE_EQ(times["load"], 1.5);
+  EXPECT_NEAR(times["registration"], 0.6, 1e-12);
+
+  // summary of the batch refinement
+  {
+    std::ofstream file(path);
+    file << R"({"total_time_s": 9, "maps": [
+      {"steps": [{"step": "submap_refinement", "run": true, "wall_time_s": 2},
+                 {"step": "submap_alignment", "run": false,
+                  "wall_time_s": 0}]},
+      {"steps": [{"step": "submap_refinement", "run": true,
+                  "wall_time_s": 3}]}]})";
+  }
+  ASSERT_TRUE(TrajectoryEvaluator::LoadStageTimes(path, times));
+  EXPECT_EQ(times.size(), 1);
+  EXPECT_DOUBLE_EQ(times["submap_refinement"], 5);
+  std::remove(path.c_str());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <ostream>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/export.hpp>
+#include <fuse_core/local_parameterization.h>
+#include <fuse_core/serialization.h>
+#include <fuse_core/uuid.h>
+#include <fuse_core/variable.h>
+#include <fuse_variables/fixed_size_variable.h>
+#include <fuse_variables/stamped.h>
+#include <ros/time.h>
+
+namespace bs_variables {
+
+/**
+ * @brief Variable representing the orientation (qw, qx, qy, qz) of a control
+ * point of a continuous-time trajectory spline. The stamp is the time of the
+ * knot the control point belongs to. Uses the same local parameterization as
+ * fuse_variables::Orientation3DStamped.
+ */
+class OrientationControlPoint3DStamped
+    : public fuse_variables::FixedSizeVariable<4>,
+      public fuse_variables::Stamped {
+public:
+  FUSE_VARIABLE_DEFINITIONS(OrientationControlPoint3DStamped);
+
+  /**
+   * @brief Can be used to directly index variables in the data array
+   */
+  enum : size_t { W = 0, X = 1, Y = 2, Z = 3 };
+
+  /**
+   * @brief Default constructor
+   */
+  OrientationControlPoint3DStamped() = default;
+
+  /**
+   * @brief Construct an orientation control point at a specific knot time.
+   *
+   * @param[in] stamp The knot time of this control point.
+   * @param[in] device_id An optional device id, for use when variables
+   * originate from multiple robots or devices
+   */
+  explicit OrientationControlPoint3DStamped(
+      const ros::Time& stamp,
+      const fuse_core::UUID& device_id = fuse_core::uuid::NIL);
+
+  /**
+   * @brief Read-write access to the quaternion w component
+   */
+  double& w() { return data_[W]; }
+
+  /**
+   * @brief Read-only access to the quaternion w component
+   */
+  const double& w() const { return data_[W]; }
+
+  /**
+   * @brief Read-write access to the quaternion x component
+   */
+  double& x() { return data_[X]; }
+
+  /**
+   * @brief Read-only access to the quaternion x component
+   */
+  const double& x() const { return data_[X]; }
+
+  /**
+   * @brief Read-write access to the quaternion y component
+   */
+  double& y() { return data_[Y]; }
+
+  /**
+   * @brief Read-only access to the quaternion y component
+   */
+  const double& y() const { return data_[Y]; }
+
+  /**
+   * @brief Read-write access to the quaternion z component
+   */
+  double& z() { return data_[Z]; }
+
+  /**
+   * @brief Read-only access to the quaternion z component
+   */
+  const double& z() const { return data_[Z]; }
+
+  /**
+   * @brief Print a human-readable description of the variable to the provided
+   * stream.
+   *
+   * @param  stream The stream to write to. Defaults to stdout.
+   */
+  void print(std::ostream& stream = std::cout) const override;
+
+  /**
+   * @brief Returns the number of elements of the local parameterization space.
+   */
+  size_t localSize() const override { return 3u; }
+
+  /**
+   * @brief Provides a Ceres local parameterization for the quaternion
+   *
+   * @return A pointer to a local parameterization object that indicates how
+   * to "add" increments to the quaternion
+   */
+  fuse_core::LocalParameterization* localParameterization() const override;
+
+private:
+  // Allow Boost Serialization access to private methods
+  friend class boost::serialization::access;
+
+  /**
+   * @brief The Boost Serialize method that serializes all of the data members
+   * in to/out of the archive
+   *
+   * @param[in/out] archive - The archive object that holds the serialized class
+   * members
+   * @param[in] version - The version of the archive being read/written.
+   * Generally unused.
+   */
+  template <class Archive>
+  void serialize(Archive& archive, const unsigned int /* version */) {
+    archive& boost::serialization::base_object<FixedSizeVariable<SIZE>>(*this);
+    archive& boost::serialization::base_object<Stamped>(*this);
+  }
+};
+
+}  // namespace bs_variables
+
+BOOST_CLASS_EXPORT_KEY(bs_variables::OrientationControlPoint3DStamped);
@@ -0,0 +1,44 @@
+#include <bs_variables/orientation_control_point_3d_stamped.h>
+
+#include <ostream>
+
+#include <boost/serialization/export.hpp>
+#include <fuse_core/local_parameterization.h>
+#include <fuse_core/uuid.h>
+#include <fuse_variables/fixed_size_variable.h>
+#include <fuse_variables/orientation_3d_stamped.h>
+#include <fuse_variables/stamped.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/time.h>
+
+namespace bs_variables {
+
+OrientationControlPoint3DStamped::OrientationControlPoint3DStamped(
+    const ros::Time& stamp, const fuse_core::UUID& device_id)
+    : FixedSizeVariable(
+          fuse_core::uuid::generate(detail::type(), stamp, device_id)),
+      Stamped(stamp, device_id) {}
+
+void OrientationControlPoint3DStamped::print(std::ostream& stream) const {
+  stream << type() << ":\n"
+         << "  uuid: " << uuid() << "\n"
+         << "  device_id: " << deviceId() << "\n"
+         << "  stamp: " << stamp() << "\n"
+         << "  size: " << size() << "\n"
+         << "  data:\n"
+         << "  - w: " << w() << "\n"
+         << "  - x: " << x() << "\n"
+         << "  - y: " << y() << "\n"
+         << "  - z: " << z() << "\n";
+}
+
+fuse_core::LocalParameterization*
+    OrientationControlPoint3DStamped::localParameterization() const {
+  return new fuse_variables::Orientation3DLocalParameterization();
+}
+
+}  // namespace bs_variables
+
+BOOST_CLASS_EXPORT_IMPLEMENT(bs_variables::OrientationControlPoint3DStamped);
+PLUGINLIB_EXPORT_CLASS(bs_variables::OrientationControlPoint3DStamped,
+                       fuse_core::Variable);